@@ -122,13 +122,27 @@ int insertData(const char* path, const char* json) {
     
     FLEXON_LOG("Inserting data into %s: %s\n", path, json);
     
-    // For now, we'll just log that this would insert data
-    // A full implementation would need the writer_open function to be implemented
-    // or we'd need to implement a different approach for appending to existing databases
-    FLEXON_LOG("Note: Insert functionality requires writer_open to be implemented\n");
-    FLEXON_LOG("JSON data to insert: %s\n", json);
+    // Single records go to the write-ahead log instead of a chunk each
+    writer_config_t config = writer_default_config();
+    config.use_wal = true;
+    writer_t* writer = writer_open_with_config(path, &config);
+    if (!writer) {
+        FLEXON_LOG("Error: Failed to open database for insertion\n");
+        return -1;
+    }
+    
+    int result = writer_insert_json(writer, json);
+    if (writer_close(writer) != 0) {
+        result = -1;
+    }
+    writer_free(writer);
+    
+    if (result != 0) {
+        FLEXON_LOG("Error: Failed to insert data\n");
+        return -1;
+    }
     
-    return 0; // Return success for demonstration
+    return 0;
 }
 
 char* readData(const char* path) {
@@ -186,9 +200,86 @@ int updateDatabase(const char* path, const char* json) {
     
     FLEXON_LOG("Updating database at %s with new data: %s\n", path, json);
     
-    // For now, implement update as insert (append new data)
-    // In a full implementation, this would update existing records
-    int result = insertData(path, json);
+    // Update is delete plus append: the new record replaces every record with
+    // the same key (first schema field). Appending first means a failure
+    // leaves both versions rather than neither.
+    if (insertData(path, json) != 0) {
+        FLEXON_LOG("Error: Failed to update database\n");
+        return -1;
+    }
+    
+    reader_t* reader = reader_open(path);
+    if (!reader) {
+        FLEXON_LOG("Error: Failed to open database for update\n");
+        return -1;
+    }
+    
+    // The new record is the last row stored
+    uint32_t stored = reader_get_row_count(reader) + reader_get_deleted_count(reader);
+    row_position_t new_position;
+    row_data_t* updated = NULL;
+    if (stored > 0 && reader_seek_row(reader, stored - 1) == 0) {
+        updated = reader_read_row(reader);
+    }
+    if (!updated || reader_row_position(reader, &new_position) != 0) {
+        reader_free_row(updated);
+        reader_close(reader);
+        return -1;
+    }
+    
+    const field_def_t* key = &reader->schema->fields[0];
+    field_value_t key_value = updated->values[0];
+    
+    row_position_t* positions = NULL;
+    uint32_t count = 0, capacity = 0;
+    int result = 0;
+    reader_rewind(reader);
+    
+    row_data_t* row;
+    while (result == 0 && (row = reader_read_row(reader)) != NULL) {
+        row_position_t position;
+        if (reader_values_equal(key, &row->values[0], &key_value) &&
+            reader_row_position(reader, &position) == 0 &&
+            (position.chunk_index != new_position.chunk_index ||
+             position.row_in_chunk != new_position.row_in_chunk)) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                row_position_t* grown = realloc(positions, capacity * sizeof(row_position_t));
+                if (!grown) {
+                    result = -1;
+                } else {
+                    positions = grown;
+                }
+            }
+            if (result == 0) {
+                positions[count++] = position;
+            }
+        }
+        
+        for (uint32_t i = 0; i < row->field_count; i++) {
+            if (reader->schema->fields[i].type == FIELD_TYPE_STRING) {
+                free((char*)row->values[i].value.string_val);
+            }
+        }
+        reader_free_row(row);
+    }
+    
+    if (result == 0) {
+        result = reader_delete_rows(reader, positions, count);
+    }
+    
+    if (key->type == FIELD_TYPE_STRING) {
+        free((char*)updated->values[0].value.string_val);
+    }
+    for (uint32_t i = 1; i < updated->field_count; i++) {
+        if (reader->schema->fields[i].type == FIELD_TYPE_STRING) {
+            free((char*)updated->values[i].value.string_val);
+        }
+    }
+    reader_free_row(updated);
+    free(positions);
+    reader_close(reader);
+    
     if (result != 0) {
         FLEXON_LOG("Error: Failed to update database\n");
         return -1;
@@ -19,7 +19,7 @@ char* readData(const char* path);
 // Delete the database.
 int deleteDatabase(const char* path);
 
-// Update the database record with new JSON, return result status (0 for success).
+// Replace the records whose first field matches the new JSON record, return result status (0 for success).
 int updateDatabase(const char* path, const char* json);
 
 // Convert CSV file to FlexonDB format, returning status code.
@@ -0,0 +1,184 @@
+#ifndef FLEXON_ARENA_H
+#define FLEXON_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Region and Slab Allocators
+ * ============================================================================
+ * An arena hands out memory by bumping a pointer through blocks it allocates
+ * as it goes; nothing is freed on its own. Everything allocated from it goes
+ * at once when the arena is released, so a query result or a parsed command
+ * costs one free() however many rows, values and strings it holds. An arena
+ * can start in caller storage (a stack buffer, say), in which case small
+ * workloads never reach malloc at all. Marks let a caller take back what it
+ * allocated since a point, such as a decoded row a filter rejected.
+ *
+ * A slab pool hands out objects of one size from slabs of many objects and
+ * keeps freed ones on a free list, so allocating and freeing a row buffer is
+ * a pointer swap. Objects stay valid until they are freed or the pool is
+ * destroyed.
+ *
+ * Neither is thread-safe: each belongs to one owner at a time.
+ */
+
+#define FXDB_ARENA_ALIGNMENT 16           // Alignment of every allocation
+#define FXDB_ARENA_DEFAULT_BLOCK 4096     // First block of a growing arena
+#define FXDB_ARENA_MAX_BLOCK (1u << 20)   // Blocks stop doubling here
+
+// A block the arena allocated; its memory follows the header
+typedef struct fxdb_arena_block {
+    struct fxdb_arena_block* next;        // Older block
+    size_t size;                          // Usable bytes after the header
+} fxdb_arena_block_t;
+
+typedef struct {
+    uint8_t* cursor;                      // Next free byte of the current block
+    uint8_t* limit;                       // End of the current block
+    uint8_t* initial;                     // Caller storage or inline first block (may be NULL)
+    size_t initial_size;
+    fxdb_arena_block_t* blocks;           // Blocks allocated so far, newest first
+    size_t next_block;                    // Size of the next block allocated
+    bool owned;                           // Created by fxdb_arena_create: freed with its first block
+} fxdb_arena_t;
+
+// Position in an arena to rewind to
+typedef struct {
+    uint8_t* cursor;
+    uint8_t* limit;
+    fxdb_arena_block_t* blocks;
+} fxdb_arena_mark_t;
+
+// A slab of objects; the objects follow the header
+typedef struct fxdb_slab {
+    struct fxdb_slab* next;
+} fxdb_slab_t;
+
+typedef struct {
+    size_t object_size;                   // Rounded up to FXDB_ARENA_ALIGNMENT
+    uint32_t objects_per_slab;
+    void* free_list;                      // Freed objects, linked through their first word
+    fxdb_slab_t* slabs;                   // Every slab, newest first
+    uint64_t in_use;                      // Objects handed out and not yet freed
+} fxdb_slab_pool_t;
+
+/**
+ * Start an arena in caller storage
+ * @param buffer First memory handed out (may be NULL); must outlive the arena
+ * @param size Bytes of buffer
+ */
+void fxdb_arena_init(fxdb_arena_t* arena, void* buffer, size_t size);
+
+/**
+ * Allocate an arena whose first block shares its allocation
+ * @param block_size Bytes of the first block (0 for FXDB_ARENA_DEFAULT_BLOCK)
+ * Returns NULL when out of memory; free with fxdb_arena_destroy
+ */
+fxdb_arena_t* fxdb_arena_create(size_t block_size);
+
+/**
+ * Allocate from a new block; used by fxdb_arena_alloc when the current one is full
+ */
+void* fxdb_arena_grow(fxdb_arena_t* arena, size_t size);
+
+/**
+ * Allocate `size` bytes aligned to FXDB_ARENA_ALIGNMENT
+ * Returns NULL when out of memory
+ */
+static inline void* fxdb_arena_alloc(fxdb_arena_t* arena, size_t size) {
+    size = size ? (size + FXDB_ARENA_ALIGNMENT - 1) & ~(size_t)(FXDB_ARENA_ALIGNMENT - 1) : FXDB_ARENA_ALIGNMENT;
+    if ((size_t)(arena->limit - arena->cursor) >= size) {
+        void* memory = arena->cursor;
+        arena->cursor += size;
+        return memory;
+    }
+    return fxdb_arena_grow(arena, size);
+}
+
+/**
+ * Allocate zeroed memory for `count` objects of `size` bytes
+ */
+void* fxdb_arena_calloc(fxdb_arena_t* arena, size_t count, size_t size);
+
+/**
+ * Copy a string into the arena
+ */
+char* fxdb_arena_strdup(fxdb_arena_t* arena, const char* text);
+
+/**
+ * Copy at most `length` bytes of a string into the arena, terminated
+ */
+char* fxdb_arena_strndup(fxdb_arena_t* arena, const char* text, size_t length);
+
+/**
+ * Remember the arena's position
+ */
+static inline fxdb_arena_mark_t fxdb_arena_mark(const fxdb_arena_t* arena) {
+    fxdb_arena_mark_t mark = { arena->cursor, arena->limit, arena->blocks };
+    return mark;
+}
+
+/**
+ * Take back everything allocated since `mark`, freeing blocks added after it
+ */
+void fxdb_arena_rewind(fxdb_arena_t* arena, fxdb_arena_mark_t mark);
+
+/**
+ * Take back everything; the first block is kept for reuse
+ */
+void fxdb_arena_reset(fxdb_arena_t* arena);
+
+/**
+ * Free the blocks of an arena started with fxdb_arena_init
+ */
+void fxdb_arena_release(fxdb_arena_t* arena);
+
+/**
+ * Free an arena from fxdb_arena_create and everything allocated from it
+ */
+void fxdb_arena_destroy(fxdb_arena_t* arena);
+
+/**
+ * Start a pool of objects of one size
+ * @param objects_per_slab Objects allocated together when the pool runs dry (0 for 64)
+ */
+void fxdb_slab_pool_init(fxdb_slab_pool_t* pool, size_t object_size, uint32_t objects_per_slab);
+
+/**
+ * Allocate a slab and take an object from it; used by fxdb_slab_alloc when the pool is empty
+ */
+void* fxdb_slab_grow(fxdb_slab_pool_t* pool);
+
+/**
+ * Take an object from the pool (uninitialized)
+ * Returns NULL when out of memory
+ */
+static inline void* fxdb_slab_alloc(fxdb_slab_pool_t* pool) {
+    void* object = pool->free_list;
+    if (!object) {
+        return fxdb_slab_grow(pool);
+    }
+    pool->free_list = *(void**)object;
+    pool->in_use++;
+    return object;
+}
+
+/**
+ * Return an object to the pool (may be NULL)
+ */
+static inline void fxdb_slab_free(fxdb_slab_pool_t* pool, void* object) {
+    if (object) {
+        *(void**)object = pool->free_list;
+        pool->free_list = object;
+        pool->in_use--;
+    }
+}
+
+/**
+ * Free every slab; objects from the pool are no longer valid
+ */
+void fxdb_slab_pool_destroy(fxdb_slab_pool_t* pool);
+
+#endif // FLEXON_ARENA_H
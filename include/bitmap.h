@@ -0,0 +1,100 @@
+#ifndef FLEXON_BITMAP_H
+#define FLEXON_BITMAP_H
+
+/* ============================================================================
+ * FlexonDB Validity Bitmaps
+ * ============================================================================
+ * Word-wide helpers for per-chunk validity bitmaps. One bit per row, bit set
+ * means the value is present (not NULL). Bitmaps are stored as arrays of
+ * 64-bit words so scans can test or count 64 rows per operation.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FXDB_BITMAP_WORD_BITS 64
+
+/**
+ * Number of 64-bit words needed to hold one bit per row
+ */
+static inline uint32_t fxdb_bitmap_words(uint32_t rows) {
+    return (rows + FXDB_BITMAP_WORD_BITS - 1) / FXDB_BITMAP_WORD_BITS;
+}
+
+static inline void fxdb_bitmap_set(uint64_t* bitmap, uint32_t row) {
+    bitmap[row >> 6] |= (uint64_t)1 << (row & 63);
+}
+
+static inline bool fxdb_bitmap_get(const uint64_t* bitmap, uint32_t row) {
+    return (bitmap[row >> 6] >> (row & 63)) & 1;
+}
+
+/**
+ * Mask of the bits that belong to rows in word `word` of a `rows`-row bitmap
+ */
+static inline uint64_t fxdb_bitmap_word_mask(uint32_t rows, uint32_t word) {
+    uint32_t remaining = rows - word * FXDB_BITMAP_WORD_BITS;
+    return remaining >= FXDB_BITMAP_WORD_BITS ? ~(uint64_t)0 : (((uint64_t)1 << remaining) - 1);
+}
+
+static inline uint32_t fxdb_popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (uint32_t)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * Count set bits among the first `rows` bits
+ */
+static inline uint64_t fxdb_bitmap_count(const uint64_t* bitmap, uint32_t rows) {
+    uint64_t count = 0;
+    uint32_t words = fxdb_bitmap_words(rows);
+    for (uint32_t w = 0; w < words; w++) {
+        count += fxdb_popcount64(bitmap[w] & fxdb_bitmap_word_mask(rows, w));
+    }
+    return count;
+}
+
+/**
+ * dst &= src, word by word
+ */
+static inline void fxdb_bitmap_and(uint64_t* dst, const uint64_t* src, uint32_t words) {
+    for (uint32_t w = 0; w < words; w++) {
+        dst[w] &= src[w];
+    }
+}
+
+/**
+ * dst &= ~src, word by word
+ */
+static inline void fxdb_bitmap_and_not(uint64_t* dst, const uint64_t* src, uint32_t words) {
+    for (uint32_t w = 0; w < words; w++) {
+        dst[w] &= ~src[w];
+    }
+}
+
+/**
+ * Fill the first `rows` bits with ones and clear the tail of the last word
+ */
+static inline void fxdb_bitmap_fill(uint64_t* bitmap, uint32_t rows) {
+    uint32_t words = fxdb_bitmap_words(rows);
+    for (uint32_t w = 0; w < words; w++) {
+        bitmap[w] = fxdb_bitmap_word_mask(rows, w);
+    }
+}
+
+/**
+ * Position of the nullable column among all nullable columns, given the
+ * header null mask. Only meaningful when bit `field_index` is set.
+ */
+static inline uint32_t fxdb_null_ordinal(uint64_t null_mask, uint32_t field_index) {
+    return fxdb_popcount64(null_mask & (((uint64_t)1 << field_index) - 1));
+}
+
+#endif // FLEXON_BITMAP_H
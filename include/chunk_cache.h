@@ -0,0 +1,93 @@
+#ifndef FLEXON_CHUNK_CACHE_H
+#define FLEXON_CHUNK_CACHE_H
+
+/* ============================================================================
+ * FlexonDB Chunk Cache
+ * ============================================================================
+ * Process-wide cache of chunk payloads shared by every reader_t. Entries are
+ * keyed by (file id, chunk index, generation), stay resident while pinned and
+ * are evicted with the CLOCK algorithm once the memory budget is exceeded.
+ * All functions are thread-safe.
+ */
+
+#include "config.h"
+#include "types.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    uint64_t file_id;           // Device and inode of the file
+    uint32_t chunk_index;       // Chunk number within the file
+    uint32_t generation;        // Header generation the chunk belongs to
+} fxdb_chunk_key_t;
+
+typedef struct fxdb_cached_chunk {
+    fxdb_chunk_key_t key;
+    uint8_t* data;              // Chunk payload: rows followed by validity bitmaps
+    uint32_t size;              // Payload size in bytes
+    uint32_t row_count;         // Rows in the chunk
+    long file_offset;           // Offset of the payload in the file
+
+    // Cache bookkeeping (owned by the cache, guarded by its lock)
+    uint32_t pin_count;         // Readers currently using the entry
+    bool referenced;            // CLOCK reference bit
+    struct fxdb_cached_chunk* hash_next;
+    struct fxdb_cached_chunk* clock_prev;
+    struct fxdb_cached_chunk* clock_next;
+} fxdb_cached_chunk_t;
+
+/**
+ * Identify an open file for use in cache keys
+ * Returns 0 if the file cannot be identified (caching is then skipped)
+ */
+uint64_t fxdb_chunk_cache_file_id(FILE* file);
+
+/**
+ * Look up a chunk and pin it on a hit
+ * Returns NULL on a miss; every call counts as a hit or a miss
+ */
+fxdb_cached_chunk_t* fxdb_chunk_cache_lookup(const fxdb_chunk_key_t* key);
+
+/**
+ * Check whether a chunk is cached, without pinning it or counting a lookup
+ * Fills its payload size and file offset when it is
+ */
+bool fxdb_chunk_cache_contains(const fxdb_chunk_key_t* key, uint32_t* size, long* file_offset);
+
+/**
+ * Copy a chunk payload into the cache and return it pinned
+ * Returns NULL when the payload does not fit the budget even after evicting
+ * every unpinned entry; the caller keeps using its own buffer in that case
+ */
+fxdb_cached_chunk_t* fxdb_chunk_cache_insert(const fxdb_chunk_key_t* key, const uint8_t* data,
+                                             uint32_t size, uint32_t row_count, long file_offset);
+
+/**
+ * Unpin a chunk returned by lookup or insert
+ */
+void fxdb_chunk_cache_release(fxdb_cached_chunk_t* chunk);
+
+/**
+ * Set the memory budget in bytes (0 disables caching)
+ * Shrinking the budget evicts unpinned entries immediately
+ */
+void fxdb_chunk_cache_set_budget(size_t bytes);
+
+/**
+ * Get the memory budget in bytes
+ */
+size_t fxdb_chunk_cache_get_budget(void);
+
+/**
+ * Drop every unpinned entry
+ */
+void fxdb_chunk_cache_purge(void);
+
+/**
+ * Fill cache_hits, cache_misses, memory_usage and peak_memory_usage
+ */
+void fxdb_chunk_cache_get_statistics(db_statistics_t* stats);
+
+#endif // FLEXON_CHUNK_CACHE_H
@@ -0,0 +1,116 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "protocol.h"
+#include "schema.h"
+#include "reader.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Server Client
+ * ============================================================================
+ * Talks to a `flexon serve` daemon over its Unix socket (see server.h and
+ * protocol.h). The calls below send one request and wait for its answer.
+ * To pipeline, queue requests with fxdb_client_send() and collect the
+ * answers, in the same order, with fxdb_client_receive(); requests are only
+ * written when an answer is awaited or fxdb_client_flush() is called.
+ * A client is not thread-safe; use one per thread.
+ */
+
+// Connection to a server
+typedef struct {
+    int fd;                     // Socket
+    uint32_t next_id;           // Id of the next request
+    fxdb_buffer_t out;          // Queued requests not yet written
+    fxdb_buffer_t in;           // Received bytes; holds the last answer's payload
+    size_t consumed;            // Bytes of `in` taken by answers already returned
+    char error[256];            // Message of the last failure
+} fxdb_client_t;
+
+// Answer to a request
+typedef struct {
+    uint32_t id;                // Id fxdb_client_send() returned
+    uint8_t status;             // FXDB_STATUS_OK or FXDB_STATUS_ERROR
+    const uint8_t* payload;     // Valid until the next receive
+    uint32_t size;
+} fxdb_response_t;
+
+/**
+ * Connect to a server
+ * Returns the client on success, NULL on failure
+ */
+fxdb_client_t* fxdb_client_connect(const char* socket_path);
+
+/**
+ * Queue a request without waiting for its answer
+ * @param body Operation-specific payload after the database name (may be NULL)
+ * Returns the request id, 0 on failure
+ */
+uint32_t fxdb_client_send(fxdb_client_t* client, fxdb_op_t op, const char* database,
+                          const void* body, uint32_t size);
+
+/**
+ * Write all queued requests
+ * Returns 0 on success, -1 on a broken connection
+ */
+int fxdb_client_flush(fxdb_client_t* client);
+
+/**
+ * Wait for the next answer, writing queued requests first
+ * Returns 0 on success, -1 on a broken connection
+ */
+int fxdb_client_receive(fxdb_client_t* client, fxdb_response_t* response);
+
+/**
+ * Check that the server answers
+ * Returns 0 on success, -1 on failure
+ */
+int fxdb_client_ping(fxdb_client_t* client);
+
+/**
+ * Insert a row given as a JSON object; committed when this returns 0
+ * Returns 0 on success, -1 on failure (see fxdb_client_error)
+ */
+int fxdb_client_insert(fxdb_client_t* client, const char* database, const char* json);
+
+/**
+ * Insert rows with all requests pipelined; the server commits them together
+ * Returns the number of rows inserted, -1 on a broken connection
+ */
+int fxdb_client_insert_many(fxdb_client_t* client, const char* database,
+                            const char* const* json_rows, uint32_t count);
+
+/**
+ * Count the live rows of a database
+ * Returns 0 on success, -1 on failure
+ */
+int fxdb_client_count(fxdb_client_t* client, const char* database, uint32_t* rows);
+
+/**
+ * Schema of a database
+ * Returns a schema to free with free_schema(), NULL on failure
+ */
+schema_t* fxdb_client_schema(fxdb_client_t* client, const char* database);
+
+/**
+ * Read rows from a position, which is advanced past them
+ * Start at (0, 0); an empty result means no more rows are committed yet.
+ * The server may return fewer rows than `limit` for a large page.
+ * @param schema Schema from fxdb_client_schema(); the result refers to it
+ * Returns a result to free with reader_free_result(), NULL on failure
+ */
+query_result_t* fxdb_client_read(fxdb_client_t* client, const char* database, const schema_t* schema,
+                                 row_position_t* position, uint32_t limit);
+
+/**
+ * Message of the last failure
+ */
+const char* fxdb_client_error(const fxdb_client_t* client);
+
+/**
+ * Close the connection and free the client
+ */
+void fxdb_client_close(fxdb_client_t* client);
+
+#endif // CLIENT_H
@@ -0,0 +1,68 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include "writer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Compaction
+ * ============================================================================
+ * Rewrites a database into full chunks: rows of undersized chunks (one per
+ * commit of a plain writer) are merged, deleted rows are dropped and the rows
+ * of the write-ahead log are moved into the file. Chunk headers and validity
+ * bitmaps are recomputed for the new chunks.
+ *
+ * The new file is built next to the database (<database>.fxdb.tmp) by worker
+ * threads and renamed over it, so a crash leaves either the old or the new
+ * file. Readers that have the old file open keep reading it; the new file has
+ * the next generation and reader_refresh() tells them to reopen. Compaction
+ * holds the writer lock, so it fails while a writer has the database open and
+ * writers opened meanwhile wait until the new file and its sidecars are in place.
+ *
+ * Rows are streamed from the old file a chunk at a time. Sorting by a key
+ * feeds them through the external sorter (see sort.h), which spills runs next
+ * to the database once its memory budget is reached.
+ *
+ * The workers summarize the chunks they build, and the summaries replace
+ * those of the old generation once the new file is in place.
+ */
+
+// Compaction settings
+typedef struct {
+    uint32_t chunk_size;        // Rows per chunk of the new file (0 keeps the current chunk size)
+    int sort_field;             // Field to sort rows by (NULLs first), -1 keeps insertion order
+    size_t sort_memory;         // Bytes of rows the sort holds before spilling (0 for FXDB_SORT_DEFAULT_MEMORY)
+    uint32_t threads;           // Worker threads (0 uses one per online CPU)
+    fxdb_durability_t durability; // How far the new file is pushed before it replaces the old one
+    bool align_chunks;          // Write the aligned chunk layout (files already aligned keep it)
+    bool chunk_summaries;       // Summarize the new chunks for approximate queries (see summary.h)
+} compact_options_t;
+
+// What a compaction did
+typedef struct {
+    uint32_t chunks_before;     // Chunks in the file, plus one for rows in the log
+    uint32_t chunks_after;
+    uint32_t rows_before;       // Stored rows, deleted ones included
+    uint32_t rows_after;
+    uint64_t bytes_before;      // Size of the database file and its sidecars
+    uint64_t bytes_after;
+    uint32_t threads;           // Worker threads used
+    uint32_t sort_runs;         // Runs the sort spilled to disk
+} compact_stats_t;
+
+/**
+ * Create default compaction options
+ */
+compact_options_t compact_default_options(void);
+
+/**
+ * Compact a database file
+ * @param filename Database filename
+ * @param options Compaction settings (NULL for defaults)
+ * @param stats Filled with what was done (may be NULL)
+ * @return 0 on success, -1 on failure (the database is left unchanged)
+ */
+int compact_database(const char* filename, const compact_options_t* options, compact_stats_t* stats);
+
+#endif // COMPACT_H
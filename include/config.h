@@ -17,6 +17,10 @@
 #define FXDB_EXT ".fxdb"
 #define TEMP_EXT ".tmp"
 #define BACKUP_EXT ".bak"
+#define WAL_EXT ".wal"             // Write-ahead log sidecar, appended to the database name
+#define DELETE_EXT ".del"          // Deletion vector sidecar, appended to the database name
+#define SHM_EXT ".shm"             // Shared commit state sidecar, appended to the database name
+#define SUMMARY_EXT ".sum"         // Chunk summary sidecar, appended to the database name
 
 /* ============================================================================
  * Database Limits
@@ -35,6 +39,15 @@
 #define FXDB_BUFFER_SIZE 4096      // Standard I/O buffer size (4KB)
 #define FXDB_LARGE_BUFFER_SIZE 16384  // Large I/O buffer size (16KB)
 #define FXDB_MIN_MMAP_SIZE 1024    // Minimum file size for memory mapping
+#define FXDB_MMAP_POPULATE_MAX (8 * 1024 * 1024)    // Largest file faulted in whole when mapped with populate
+#define FXDB_MMAP_HUGE_PAGE_MIN (32 * 1024 * 1024)  // Smallest file mapped at a huge page boundary
+#define FXDB_HUGE_PAGE_SIZE (2 * 1024 * 1024)       // Transparent huge page size
+#define FXDB_CHUNK_CACHE_BYTES (64 * 1024 * 1024)  // Default shared chunk cache budget (64MB)
+#define FXDB_READ_AHEAD_CHUNKS 4   // Default chunks a sequential scan reads ahead
+#define FXDB_READ_AHEAD_THREADS 4  // I/O threads shared by all read-ahead
+#define FXDB_IO_ALIGNMENT 4096     // Block size of direct I/O and of the aligned chunk layout
+#define FXDB_ALIGNED_POOL_BUFFERS 8 // Aligned buffers kept for reuse
+#define FXDB_LOCK_TIMEOUT_MS 5000  // Default wait for another writer's lock
 
 /* ============================================================================
  * Common Strings and Magic Numbers
@@ -0,0 +1,107 @@
+#ifndef COORD_H
+#define COORD_H
+
+#include "writer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Writer Coordination
+ * ============================================================================
+ * A database has at most one writer at a time, across threads and processes.
+ * Writers (and compaction) hold an exclusive advisory lock on the database
+ * file for as long as they have it open; a second writer waits for the lock
+ * up to its timeout and then fails instead of interleaving header rewrites.
+ *
+ * The writer also publishes every commit in a small shared-memory sidecar
+ * (<database>.fxdb.shm, mapped by all processes). Readers poll it to learn
+ * that rows were committed without re-reading the header or the log; only
+ * when the published sequence moved do they refresh from the file. Updates
+ * use a sequence lock: the sequence is odd while the writer changes the
+ * state and readers retry when it moved under them. The sidecar is only a
+ * hint. The file header stays the source of truth, and a missing sidecar just
+ * means readers refresh from the file.
+ */
+
+#define FXDB_SHM_MAGIC 0x4D485846   // "FXHM"
+#define FXDB_SHM_VERSION 1
+
+// Shared state: the whole sidecar
+typedef struct {
+    uint32_t magic;             // FXDB_SHM_MAGIC
+    uint32_t version;           // Sidecar format version
+    uint32_t writer_pid;        // Process of the open writer (0 when none)
+    uint32_t generation;        // Database generation of the published commit
+    uint64_t sequence;          // Bumped twice per publish; odd while an update is under way
+    uint32_t total_rows;        // Rows in the file's committed chunks
+    uint32_t chunk_count;       // Committed chunks
+    uint32_t wal_rows;          // Rows committed to the write-ahead log on top
+    uint32_t reserved;
+} fxdb_shm_t;
+
+// Consistent copy of the published commit
+typedef struct {
+    uint64_t sequence;          // Even; changes with every commit
+    uint32_t generation;
+    uint32_t total_rows;
+    uint32_t chunk_count;
+    uint32_t wal_rows;
+} fxdb_commit_state_t;
+
+// Mapped sidecar of a writer (read/write) or a reader (read-only)
+typedef struct fxdb_coord {
+    fxdb_shm_t* shm;            // Shared mapping
+    bool writable;              // Mapped by the writer
+} fxdb_coord_t;
+
+/**
+ * Path of the shared-memory sidecar of a database file
+ * Returns a malloc'd string, or NULL on allocation failure
+ */
+char* coord_shm_path(const char* db_path);
+
+/**
+ * Open a database file and take its writer lock
+ * Retries until timeout_ms has passed when another writer holds the lock.
+ * A file that was replaced (compacted) while waiting is reopened, so the lock
+ * always covers the file the path names when this returns.
+ * @param flags open(2) flags, e.g. O_RDWR or O_RDWR | O_CREAT
+ * Returns the locked descriptor (the lock goes with it when it is closed),
+ * or -1 on failure
+ */
+int coord_open_locked(const char* db_path, int flags, uint32_t timeout_ms);
+
+/**
+ * Map the shared-memory sidecar of a database
+ * The writer creates the sidecar when needed and records its pid; readers
+ * map an existing sidecar read-only.
+ * Returns fxdb_coord_t pointer, or NULL when there is no usable sidecar
+ */
+fxdb_coord_t* coord_attach(const char* db_path, bool writer);
+
+/**
+ * Publish a commit of the writer
+ * @param header Header of the commit
+ * @param wal_rows Rows committed to the write-ahead log beyond the header
+ */
+void coord_publish(fxdb_coord_t* coord, const fxdb_header_t* header, uint32_t wal_rows);
+
+/**
+ * Read the last published commit
+ * Returns 0 on success, -1 when no consistent state could be read (no
+ * sidecar, or a writer died while publishing)
+ */
+int coord_read(const fxdb_coord_t* coord, fxdb_commit_state_t* state);
+
+/**
+ * Unmap the sidecar; a writer clears its pid first
+ */
+void coord_detach(fxdb_coord_t* coord);
+
+/**
+ * Delete the sidecar of a database, if there is one
+ * Returns 0 on success (or when there was no sidecar), -1 on failure
+ */
+int coord_remove(const char* db_path);
+
+#endif // COORD_H
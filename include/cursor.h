@@ -0,0 +1,62 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include "reader.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Follow Cursors
+ * ============================================================================
+ * A cursor streams the rows of a table that is still growing, like tail -f.
+ * It remembers the physical position after the last row it returned; when a
+ * writer commits, the reader is refreshed and only the rows past that
+ * position are read. Chunks before it are never touched again, so catching up
+ * costs O(new rows) rather than a rescan of the table.
+ *
+ * fxdb_cursor_follow() blocks until rows are committed. It wakes on inotify
+ * events for the database and its log (on Linux) and checks the commit state
+ * the writer publishes in shared memory (see coord.h). Elsewhere, or when no
+ * events arrive, it polls that state at a short interval. Compacting the
+ * table ends the stream, since row positions change.
+ */
+
+// Position of a follower in a growing table
+typedef struct {
+    reader_t* reader;           // Snapshot reader, refreshed as commits arrive
+    row_position_t position;    // Where the next row will be: (chunk, row in chunk)
+    uint32_t seen_rows;         // Stored rows before the position, deleted ones included
+    int notify_fd;              // inotify descriptor (-1 when waiting by polling)
+    char* db_name;              // Base names of the database and its log, to filter events
+    char* wal_name;
+} fxdb_cursor_t;
+
+/**
+ * Open a cursor on a database
+ * @param from_start Stream the rows already in the table first; otherwise
+ *                   only rows committed after the cursor was opened
+ * Returns fxdb_cursor_t pointer on success, NULL on failure
+ */
+fxdb_cursor_t* fxdb_cursor_open(const char* filename, bool from_start);
+
+/**
+ * Next row after the cursor, in insertion order, deleted rows skipped
+ * Returns the row, owned like one from reader_read_row (string values, then
+ * reader_free_row), or NULL when the cursor has caught up with the snapshot
+ */
+row_data_t* fxdb_cursor_next(fxdb_cursor_t* cursor);
+
+/**
+ * Wait until rows past the cursor are committed
+ * @param timeout_ms Longest wait, -1 to wait until rows arrive
+ * Returns 1 when new rows can be read with fxdb_cursor_next(), 0 on timeout,
+ * -1 on error (including the table being compacted or replaced)
+ */
+int fxdb_cursor_follow(fxdb_cursor_t* cursor, int timeout_ms);
+
+/**
+ * Close a cursor and its reader
+ */
+void fxdb_cursor_close(fxdb_cursor_t* cursor);
+
+#endif // CURSOR_H
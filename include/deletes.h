@@ -0,0 +1,107 @@
+#ifndef DELETES_H
+#define DELETES_H
+
+#include "writer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Deletion Vectors
+ * ============================================================================
+ * Chunks are immutable, so deleting a row marks it in a per-chunk bitmap kept
+ * in a sidecar file (<database>.fxdb.del) instead of rewriting the chunk.
+ * Updates are a delete plus an append of the new row.
+ *
+ * Layout: [fxdb_deletes_header_t][record]... with each record being
+ * [u32 checksum][u32 chunk index][u32 word index][u64 deleted bits]: one
+ * 64-row word of a chunk's deletion vector. Deletes append records, so
+ * removing a few rows costs a few records of I/O; loading ORs every record
+ * into the vectors. Row positions of rows still in the write-ahead log are
+ * those of the chunk they will be checkpointed into, so the log's rows can
+ * be deleted too. The file is bound to the database generation; rewriting
+ * the database (compaction) drops it.
+ */
+
+#define FXDB_DELETES_MAGIC 0x56445846   // "FXDV"
+#define FXDB_DELETES_VERSION 1
+
+// Deletion file header
+typedef struct {
+    uint32_t magic;             // FXDB_DELETES_MAGIC
+    uint32_t version;           // Deletion file format version
+    uint32_t generation;        // Database generation the vectors belong to
+    uint32_t chunk_size;        // Rows per chunk of that database
+} __attribute__((packed)) fxdb_deletes_header_t;
+
+// Physical position of a row
+typedef struct {
+    uint32_t chunk_index;       // Chunk holding the row (chunk_count for log rows)
+    uint32_t row_in_chunk;      // Row within the chunk
+} row_position_t;
+
+// Deletion vectors of a database, or a batch of rows to delete
+typedef struct {
+    uint32_t words;             // Words per vector, sized for the chunk size
+    uint32_t chunk_count;       // Length of vectors
+    uint64_t** vectors;         // Deletion bitmap per chunk, NULL when no row of it is deleted
+    uint64_t deleted_rows;      // Rows marked in the vectors
+} fxdb_deletes_t;
+
+/**
+ * Path of the deletion file belonging to a database file
+ * Returns a malloc'd string, or NULL on allocation failure
+ */
+char* deletes_path(const char* db_path);
+
+/**
+ * Create an empty set of deletion vectors for chunks of chunk_size rows
+ * Returns fxdb_deletes_t pointer on success, NULL on failure
+ */
+fxdb_deletes_t* deletes_create(uint32_t chunk_size);
+
+/**
+ * Mark a row deleted
+ * Returns 1 if the row was newly marked, 0 if it already was, -1 on error
+ */
+int deletes_mark(fxdb_deletes_t* deletes, row_position_t position);
+
+/**
+ * Deletion vector of a chunk
+ * Returns NULL when no row of the chunk is deleted
+ */
+const uint64_t* deletes_chunk(const fxdb_deletes_t* deletes, uint32_t chunk_index);
+
+/**
+ * Whether a row is marked deleted
+ */
+bool deletes_contains(const fxdb_deletes_t* deletes, row_position_t position);
+
+/**
+ * Load the deletion vectors of a database
+ * A missing or stale deletion file gives an empty set. A torn last record
+ * is ignored.
+ * Returns fxdb_deletes_t pointer on success, NULL on failure
+ */
+fxdb_deletes_t* deletes_load(const char* db_path, const fxdb_header_t* db_header);
+
+/**
+ * Append the rows marked in batch to the database's deletion file
+ * Only words with marked rows are written. The database's writer lock is held
+ * while appending, and a database rewritten since db_header was read is refused.
+ * Returns 0 on success, -1 on failure
+ */
+int deletes_write(const char* db_path, const fxdb_header_t* db_header, const fxdb_deletes_t* batch,
+                  fxdb_durability_t durability);
+
+/**
+ * Free deletion vectors
+ */
+void deletes_free(fxdb_deletes_t* deletes);
+
+/**
+ * Delete the deletion file of a database, if there is one
+ * Returns 0 on success (or when there was no file), -1 on failure
+ */
+int deletes_remove(const char* db_path);
+
+#endif // DELETES_H
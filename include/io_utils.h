@@ -36,6 +36,24 @@ typedef struct {
  * Memory-Mapped Reader Structure
  * ============================================================================ */
 
+/**
+ * How a mapping will be accessed, passed to the kernel with madvise()
+ */
+typedef enum {
+    FXDB_MMAP_ACCESS_DEFAULT,             // No hint: moderate read-around on each fault
+    FXDB_MMAP_ACCESS_SEQUENTIAL,          // Scans: aggressive read-ahead, pages behind may be dropped early
+    FXDB_MMAP_ACCESS_RANDOM               // Point lookups: fault in only the page touched
+} fxdb_mmap_access_t;
+
+/**
+ * Options of a memory mapping
+ */
+typedef struct {
+    fxdb_mmap_access_t access;            // Access pattern hint
+    bool populate;                        // Fault files up to FXDB_MMAP_POPULATE_MAX in at open (small hot files)
+    bool huge_pages;                      // Map files from FXDB_MMAP_HUGE_PAGE_MIN at a huge page boundary
+} fxdb_mmap_options_t;
+
 /**
  * Memory-mapped reader for high-performance random access reads
  * Uses mmap for zero-copy access to file data
@@ -110,6 +128,35 @@ int fxdb_buffered_writer_close(fxdb_buffered_writer_t* writer);
  */
 fxdb_mmap_reader_t* fxdb_mmap_reader_open(const char* filename);
 
+/**
+ * Default mapping options: no hints, leaving read-around to the kernel
+ */
+fxdb_mmap_options_t fxdb_mmap_default_options(void);
+
+/**
+ * Create a memory-mapped reader with access hints
+ * Large files mapped with huge_pages are placed at a huge page boundary and
+ * marked MADV_HUGEPAGE, so the kernel can back them with huge pages where
+ * the file system supports it. Hints the system does not support are skipped.
+ * @param filename Path to file to open for reading
+ * @param options Mapping options (NULL for fxdb_mmap_default_options())
+ * @return Memory-mapped reader on success, NULL on failure
+ */
+fxdb_mmap_reader_t* fxdb_mmap_reader_open_with_options(const char* filename, const fxdb_mmap_options_t* options);
+
+/**
+ * Change the access pattern hint of the whole mapping
+ * @return 0 on success, -1 if not mapped or the hint was refused
+ */
+int fxdb_mmap_advise(fxdb_mmap_reader_t* reader, fxdb_mmap_access_t access);
+
+/**
+ * Ask the kernel to start reading a range of the mapping (MADV_WILLNEED)
+ * Returns at once; the range is clipped to the file
+ * @return 0 on success, -1 if not mapped or the hint was refused
+ */
+int fxdb_mmap_prefetch(fxdb_mmap_reader_t* reader, size_t offset, size_t length);
+
 /**
  * Read uint32_t value from memory-mapped file
  * @param reader Memory-mapped reader instance
@@ -179,9 +226,10 @@ int fxdb_database_delete(const char* filename);
  * ============================================================================ */
 
 /**
- * Acquire exclusive lock on file
+ * Acquire exclusive lock on file without waiting
+ * The lock is held by the open file and released when it is closed.
  * @param fd File descriptor
- * @return 0 on success, -1 on failure
+ * @return 0 on success, -1 on failure (errno EWOULDBLOCK when held elsewhere)
  */
 int fxdb_lock_file(int fd);
 
@@ -192,4 +240,55 @@ int fxdb_lock_file(int fd);
  */
 int fxdb_unlock_file(int fd);
 
+/* ============================================================================
+ * Durability Functions
+ * ============================================================================ */
+
+/**
+ * Force written data to stable storage
+ * Uses fdatasync where available (file metadata other than size is not
+ * synced), full fsync otherwise
+ * @param fd File descriptor
+ * @return 0 on success, -1 on failure
+ */
+int fxdb_sync_file(int fd);
+
+/* ============================================================================
+ * Direct I/O Functions
+ * ============================================================================
+ * Direct reads bypass the page cache, so a one-shot scan of a large file
+ * does not evict the pages other readers keep hot. They must start at an
+ * offset, cover a length and land in a buffer that are all multiples of
+ * FXDB_IO_ALIGNMENT.
+ */
+
+/**
+ * Round a size up to a multiple of an alignment (a power of two)
+ */
+size_t fxdb_align_up(size_t value, size_t alignment);
+
+/**
+ * Open a file for reading around the page cache
+ * Uses O_DIRECT where available, F_NOCACHE on macOS
+ * @param filename Path to file to open
+ * @return File descriptor, -1 if the file system does not support it
+ */
+int fxdb_open_direct(const char* filename);
+
+/**
+ * Take a buffer aligned to FXDB_IO_ALIGNMENT from the aligned buffer pool
+ * Buffers returned to the pool are reused, so readers opened one after the
+ * other do not allocate and fault in a new buffer each
+ * @param size Bytes needed (rounded up to the alignment)
+ * @return Buffer on success, NULL on allocation failure
+ */
+void* fxdb_aligned_buffer_acquire(size_t size);
+
+/**
+ * Return a buffer to the aligned buffer pool
+ * @param buffer Buffer from fxdb_aligned_buffer_acquire (may be NULL)
+ * @param size Size it was acquired with
+ */
+void fxdb_aligned_buffer_release(void* buffer, size_t size);
+
 #endif // FLEXON_IO_UTILS_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include "reader.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Hash Joins
+ * ============================================================================
+ * An equi-join of two tables on one field each. The smaller table, by rows
+ * times row size, is the build side: its rows go into a hash table keyed on
+ * the join field, and the other table's rows probe it. The probe is split
+ * into contiguous ranges of chunks, each scanned by a thread with a reader of
+ * its own, so result rows come out in the probe table's order.
+ *
+ * When the build side does not fit the memory budget the join turns into a
+ * grace hash join: both tables are split on their keys' hashes into
+ * partitions small enough for each thread's share of the budget, written to
+ * temporary files named after `temp_prefix`, and the partitions are then
+ * joined in parallel, each with a hash table of its own. Rows then come out
+ * partition by partition. Partition files are removed as the join ends.
+ *
+ * NULL keys match nothing. Both join fields must have the same type; strings
+ * of different sizes compare by their text.
+ */
+
+#define FXDB_JOIN_DEFAULT_MEMORY (64u << 20) // Bytes of build rows held in hash tables
+#define FXDB_JOIN_MAX_PARTITIONS 128         // Partitions a grace join splits into
+#define FXDB_JOIN_MAX_THREADS 16
+
+// Join settings
+typedef struct {
+    size_t memory_limit;        // Bytes of build rows held (0 for FXDB_JOIN_DEFAULT_MEMORY)
+    uint32_t threads;           // Probe threads (0 uses one per online CPU)
+    uint32_t limit;             // Stop after this many rows (0 for all); which rows is not fixed
+    const char* temp_prefix;    // Partitions are written to <temp_prefix>.join<pid>-<side><n>
+} fxdb_join_options_t;
+
+// What a join did
+typedef struct {
+    bool build_left;            // The left table was the build side
+    uint64_t build_rows;        // Rows with a key put in hash tables
+    uint64_t probe_rows;        // Rows with a key looked up
+    uint64_t rows;              // Rows produced
+    uint32_t partitions;        // 1 for an in-memory join
+    uint64_t bytes_spilled;     // Bytes written to partitions
+    uint32_t threads;           // Threads probing
+    double build_ms;            // Building hash tables, partitioning included
+    double probe_ms;
+} fxdb_join_stats_t;
+
+/**
+ * Create default join options
+ */
+fxdb_join_options_t fxdb_join_default_options(void);
+
+/**
+ * Join two tables on `left.left_field = right.right_field`
+ * Result rows hold the left table's fields followed by the right table's,
+ * named "<left_name>.<field>" and "<right_name>.<field>"; the result carries
+ * that schema, and reader_free_result() frees it with the rows. Both readers
+ * are rewound; probe threads open the probe table again by its path.
+ * @param stats Receives what the join did (may be NULL)
+ * Returns the result, NULL on error
+ */
+query_result_t* fxdb_hash_join(reader_t* left, const char* left_name, uint32_t left_field,
+                               reader_t* right, const char* right_name, uint32_t right_field,
+                               const fxdb_join_options_t* options, fxdb_join_stats_t* stats);
+
+#endif // JOIN_H
@@ -58,6 +58,16 @@ void flexon_terminal_cleanup(void);
  */
 char* flexon_readline(const char* prompt);
 
+/**
+ * Run a callback once input has been idle for a while in flexon_readline
+ * Supported with GNU readline and with the fallback reader on a terminal;
+ * other line editors never call it.
+ * @param timeout_ms Idle time before the callback runs
+ * @param hook Called at most once per flexon_readline call, NULL to disable
+ * @param arg Passed to the hook
+ */
+void flexon_terminal_set_idle_hook(int timeout_ms, void (*hook)(void* arg), void* arg);
+
 /**
  * Add a line to the history
  * @param line The line to add to history
@@ -0,0 +1,143 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "schema.h"
+#include "reader.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Server Protocol
+ * ============================================================================
+ * Requests and responses travel over a Unix stream socket as frames:
+ *
+ *   [u32 length][u32 request id][u8 code][payload]
+ *
+ * `length` counts the bytes after itself. In a request `code` is the
+ * operation, in a response the status. Integers are little-endian like the
+ * file format. A client may send many requests without waiting (pipelining);
+ * the server answers each connection's requests in the order they were sent,
+ * echoing the request id.
+ *
+ * Every request payload starts with the database name ([u16 length][bytes],
+ * empty for PING), resolved by the server against its directory. The rest:
+ *
+ *   PING    -                                  -> -
+ *   SCHEMA  -                                  -> schema string ("id int32, name string?")
+ *   COUNT   -                                  -> [u32 live rows]
+ *   INSERT  JSON object text                   -> -
+ *   READ    [u32 chunk][u32 row][u32 limit]    -> [u32 chunk][u32 row][u32 count][rows]
+ *
+ * READ starts at a physical position (0, 0 for the first row) and answers
+ * with the position to continue from, so paging never rescans. A row is, per
+ * field: [u8 present] and, when present, an int32 or float (4 bytes), a bool
+ * (1 byte) or a string ([u16 length][bytes]). An ERROR response carries a
+ * message as its payload.
+ */
+
+#define FXDB_FRAME_HEADER 9                     // length, id and code
+#define FXDB_MAX_FRAME (16 * 1024 * 1024)       // Longest frame either side accepts
+
+// Request operations
+typedef enum {
+    FXDB_OP_PING = 1,
+    FXDB_OP_SCHEMA = 2,
+    FXDB_OP_COUNT = 3,
+    FXDB_OP_INSERT = 4,
+    FXDB_OP_READ = 5
+} fxdb_op_t;
+
+// Response statuses
+typedef enum {
+    FXDB_STATUS_OK = 0,
+    FXDB_STATUS_ERROR = 1
+} fxdb_status_t;
+
+// Growable byte buffer frames are built in
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+} fxdb_buffer_t;
+
+// Read position in a received payload
+typedef struct {
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+    bool failed;                // Set once a read ran past the end
+} fxdb_payload_t;
+
+/**
+ * Append bytes to a buffer, growing it
+ * Returns 0 on success, -1 on allocation failure
+ */
+int fxdb_buffer_append(fxdb_buffer_t* buffer, const void* data, size_t size);
+int fxdb_buffer_put_u8(fxdb_buffer_t* buffer, uint8_t value);
+int fxdb_buffer_put_u16(fxdb_buffer_t* buffer, uint16_t value);
+int fxdb_buffer_put_u32(fxdb_buffer_t* buffer, uint32_t value);
+
+/**
+ * Append a string as [u16 length][bytes]
+ */
+int fxdb_buffer_put_string(fxdb_buffer_t* buffer, const char* text);
+
+/**
+ * Drop the first `size` bytes of a buffer
+ */
+void fxdb_buffer_consume(fxdb_buffer_t* buffer, size_t size);
+
+/**
+ * Free a buffer's storage
+ */
+void fxdb_buffer_free(fxdb_buffer_t* buffer);
+
+/**
+ * Start a frame; the length is filled in by fxdb_frame_end()
+ * Returns the offset of the frame in the buffer, or (size_t)-1 on failure
+ */
+size_t fxdb_frame_begin(fxdb_buffer_t* buffer, uint32_t id, uint8_t code);
+
+/**
+ * Finish the frame started at `start`
+ */
+void fxdb_frame_end(fxdb_buffer_t* buffer, size_t start);
+
+/**
+ * Size of the first complete frame in bytes, length field included
+ * Returns 0 while the frame is incomplete, (size_t)-1 if it is too long
+ */
+size_t fxdb_frame_size(const uint8_t* data, size_t length);
+
+/**
+ * Payload readers; on a short payload they return 0 / NULL and set `failed`
+ */
+uint8_t fxdb_payload_u8(fxdb_payload_t* payload);
+uint16_t fxdb_payload_u16(fxdb_payload_t* payload);
+uint32_t fxdb_payload_u32(fxdb_payload_t* payload);
+
+/**
+ * Read a [u16 length][bytes] string
+ * Returns a malloc'd copy, or NULL (failed set when the payload was short)
+ */
+char* fxdb_payload_string(fxdb_payload_t* payload);
+
+/**
+ * Schema as the text parse_schema() reads back, nullable markers included
+ * Returns a malloc'd string, or NULL on failure
+ */
+char* fxdb_schema_to_string(const schema_t* schema);
+
+/**
+ * Append a row in wire layout
+ */
+int fxdb_encode_row(fxdb_buffer_t* buffer, const schema_t* schema, const row_data_t* row);
+
+/**
+ * Decode a row in wire layout into `row` (values allocated, strings malloc'd)
+ * Returns 0 on success, -1 on a malformed row
+ */
+int fxdb_decode_row(fxdb_payload_t* payload, const schema_t* schema, row_data_t* row);
+
+#endif // PROTOCOL_H
@@ -0,0 +1,125 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "reader.h"
+#include "sort.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Query Plans and Profiles
+ * ============================================================================
+ * A query is run as a short pipeline of operators over a reader: a scan
+ * produces the live rows, an optional filter keeps the rows whose field
+ * equals a value, an optional sort orders them by a field, and an optional
+ * limit stops once enough rows have come out. A sort under a limit whose rows
+ * fit the sort memory is a top-N heap; other sorts spill to runs beside the
+ * database when they outgrow it (see sort.h). Without a sort the limit stops
+ * the scan itself. query_plan() describes that pipeline without reading any rows:
+ * the access path, where chunks are read from and how many rows and chunks
+ * each operator is expected to touch. query_execute() runs it and, when asked
+ * for a profile, also records what each operator actually did, the I/O and
+ * decode work beneath it (from stats.h) and how busy each thread was.
+ *
+ * Every chunk is scanned today: chunk headers carry no min/max, and fields
+ * are not indexed, so QUERY_ACCESS_FULL_SCAN is the only access path.
+ */
+
+#define QUERY_MAX_OPERATORS 4
+#define QUERY_MAX_THREADS 16
+#define QUERY_VALUE_LEN 256
+#define QUERY_SOURCE_LEN 48
+
+typedef enum {
+    QUERY_ACCESS_FULL_SCAN = 0       // Every chunk of the snapshot, in order
+} query_access_t;
+
+typedef enum {
+    QUERY_OP_SCAN = 0,
+    QUERY_OP_FILTER,
+    QUERY_OP_LIMIT,
+    QUERY_OP_SORT,                   // Every row, in memory or through runs
+    QUERY_OP_TOP_N                   // The first rows only, in a bounded heap
+} query_op_type_t;
+
+// A select over one table
+typedef struct {
+    bool has_filter;                 // Keep only rows where filter_field equals filter_value
+    uint32_t filter_field;
+    field_value_t filter_value;      // String values point into filter_text
+    char filter_text[QUERY_VALUE_LEN];
+    bool has_order;                  // Return rows ordered by order_field
+    uint32_t order_field;
+    bool order_desc;
+    size_t sort_memory;              // Bytes a sort may hold (0 for FXDB_SORT_DEFAULT_MEMORY)
+    uint32_t limit;                  // Rows to return, 0 for all
+} query_t;
+
+// One operator of a plan
+typedef struct {
+    query_op_type_t type;
+    char detail[QUERY_VALUE_LEN];    // Predicate, row limit or chunk source
+    uint64_t estimated_rows;         // Rows the operator is expected to produce
+    uint64_t rows;                   // Rows it produced (profiles only)
+    double time_ms;                  // Time spent in the operator itself (profiles only)
+} query_operator_t;
+
+// How a query will be run
+typedef struct {
+    query_access_t access;
+    char source[QUERY_SOURCE_LEN];   // Chunk sources a scan may use, or did use in a profile (see reader_source_name)
+    uint32_t chunk_count;            // Chunks in the snapshot, the log's rows counting as one
+    uint32_t estimated_chunks;       // Chunks the scan is expected to load
+    uint32_t operator_count;
+    query_operator_t operators[QUERY_MAX_OPERATORS]; // Outermost first; the last is the scan
+} query_plan_t;
+
+// Work one thread did while a query ran
+typedef struct {
+    uint32_t thread_id;              // Stats thread id (see stats.h)
+    double busy_ms;                  // Time in reads, writes and decoding
+    double utilization;              // busy_ms over the query's wall time
+} query_thread_t;
+
+// What running a query did
+typedef struct {
+    query_plan_t plan;               // With each operator's actual rows and time
+    uint32_t chunks_read;            // Chunks loaded by the scan
+    uint32_t chunks_skipped;         // Chunks the scan never reached
+    uint64_t bytes_read;             // Bytes read by every thread, read-ahead and mapped chunks included
+    double total_ms;                 // Wall time
+    double io_ms;                    // Time in read calls and mapped page faults, summed over threads
+    double decode_ms;                // Time decoding rows (sampled, see stats.h)
+    double filter_ms;                // Time comparing rows against the filter
+    double sort_ms;                  // Time sorting, spilling and merging
+    fxdb_sort_stats_t sort;          // What the sort did (ordered queries only)
+    uint32_t thread_count;
+    query_thread_t threads[QUERY_MAX_THREADS]; // Threads that did any work
+} query_profile_t;
+
+/**
+ * Describe how a query would run, without reading rows
+ * Returns 0 on success, -1 on error
+ */
+int query_plan(const reader_t* reader, const query_t* query, query_plan_t* plan);
+
+/**
+ * Run a query from the reader's first row
+ * @param result Receives the rows (free with reader_free_result); NULL to discard them
+ * @param profile Receives the plan with actual rows and times, and the work done
+ *                beneath it; NULL to run without measuring
+ * Returns the number of rows produced, -1 on error
+ */
+int64_t query_execute(reader_t* reader, const query_t* query, query_result_t** result, query_profile_t* profile);
+
+/**
+ * Name of an access path
+ */
+const char* query_access_name(query_access_t access);
+
+/**
+ * Name of an operator
+ */
+const char* query_op_name(query_op_type_t type);
+
+#endif // QUERY_H
@@ -0,0 +1,62 @@
+#ifndef FLEXON_READ_AHEAD_H
+#define FLEXON_READ_AHEAD_H
+
+/* ============================================================================
+ * FlexonDB Read-Ahead
+ * ============================================================================
+ * While a reader decodes one chunk, the next chunks of a sequential scan are
+ * read into the chunk cache by a small pool of I/O threads with pread(), so
+ * disk and CPU work overlap instead of alternating. Each reader keeps a
+ * window of up to `depth` chunks in flight. A chunk's position is only known
+ * once the one before it was read, so a reader's window is filled in order;
+ * the pool serves many readers at once. When the reader reaches a chunk
+ * still being fetched it waits for it rather than reading it twice.
+ * Read-ahead starts on the first chunk or when a chunk follows the one
+ * loaded before it, and does nothing when the chunk cache is disabled.
+ */
+
+#include "chunk_cache.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Read-ahead state of one reader (private to read_ahead.c)
+typedef struct fxdb_read_ahead fxdb_read_ahead_t;
+
+/**
+ * Create read-ahead for an open file
+ * @param fd Descriptor read with pread(); must stay open until destroyed
+ * @param payload_capacity Largest chunk payload the file allows
+ * Returns NULL on allocation failure (reads then go without read-ahead)
+ */
+fxdb_read_ahead_t* read_ahead_create(int fd, uint64_t file_id, uint32_t generation,
+                                     uint32_t chunk_size, size_t payload_capacity,
+                                     uint32_t chunk_count, uint32_t depth);
+
+/**
+ * Set how many chunks are read ahead (0 disables read-ahead)
+ */
+void read_ahead_set_depth(fxdb_read_ahead_t* ahead, uint32_t depth);
+
+/**
+ * Let read-ahead reach chunks committed since it was created
+ */
+void read_ahead_set_chunk_count(fxdb_read_ahead_t* ahead, uint32_t chunk_count);
+
+/**
+ * Wait until a chunk being read ahead is in the cache
+ * Returns at once when the chunk is not in the window
+ */
+void read_ahead_wait(fxdb_read_ahead_t* ahead, uint32_t chunk_index);
+
+/**
+ * Note that a chunk was loaded and where the next one starts; on a
+ * sequential scan this moves the window to the chunks after it
+ */
+void read_ahead_advance(fxdb_read_ahead_t* ahead, uint32_t chunk_index, long next_chunk_pos);
+
+/**
+ * Stop read-ahead, wait for its reads in flight and free it
+ */
+void read_ahead_destroy(fxdb_read_ahead_t* ahead);
+
+#endif // FLEXON_READ_AHEAD_H
@@ -4,9 +4,36 @@
 #include "schema.h"
 #include "writer.h"
 #include "io_utils.h"
+#include "chunk_cache.h"
+#include "deletes.h"
+#include "arena.h"
 #include <stdint.h>
 #include <stdio.h>
 
+// Shared commit state of a database (see coord.h)
+struct fxdb_coord;
+
+// Read-ahead of the chunks after the current one (see read_ahead.h)
+struct fxdb_read_ahead;
+
+// Where a committed chunk lies in the file
+typedef struct {
+    long data_start;            // Offset of the payload, after the chunk header
+    uint32_t data_size;         // Payload bytes, validity bitmaps and padding included
+    uint32_t row_count;         // Rows stored in the chunk
+    uint32_t first_row;         // Physical index of the chunk's first row
+} fxdb_chunk_entry_t;
+
+// Where a loaded chunk came from
+typedef enum {
+    READER_SOURCE_FILE = 0,     // Read from the file, then kept in the chunk cache
+    READER_SOURCE_CACHE,        // Found in the chunk cache
+    READER_SOURCE_MMAP,         // Decoded in place from the mapping
+    READER_SOURCE_DIRECT,       // Read around the page cache with direct I/O
+    READER_SOURCE_LOG,          // Rows of the write-ahead log
+    READER_SOURCE_COUNT
+} reader_source_t;
+
 // Reader context
 typedef struct {
     FILE* file;                 // File handle (for traditional I/O)
@@ -17,28 +44,69 @@ typedef struct {
     uint32_t current_chunk;     // Current chunk being read
     uint32_t current_row;       // Current row in chunk
     uint32_t chunk_row_count;   // Rows in current chunk
-    uint8_t* chunk_buffer;      // Buffer for current chunk
+    uint8_t* chunk_buffer;      // Private buffer, used when the chunk cache is full
     long chunk_data_start;      // Start of current chunk data
+    uint32_t walk_chunk;        // Chunk whose header is at walk_pos
+    long walk_pos;              // Where the chunk header walk resumes (0 before the first)
+    const uint8_t* chunk_data;  // Payload of the current chunk (NULL until loaded)
+    fxdb_cached_chunk_t* cached_chunk; // Pinned cache entry backing chunk_data
+    uint64_t file_id;           // Chunk cache identity of the file
+    
+    // Validity bitmaps of the current chunk, one per nullable column
+    uint64_t* validity;         // null column count * validity_words words
+    uint32_t validity_words;    // Words per column bitmap in the current chunk
+    
+    // Rows of the write-ahead log, read after the last chunk as one more chunk
+    char* path;                 // Database path, to find the log on refresh
+    uint8_t* wal_chunk;         // Log rows in chunk layout: rows, then validity bitmaps
+    uint32_t wal_rows;          // Rows in wal_chunk
+    
+    // Deleted rows, skipped by scans and aggregates
+    fxdb_deletes_t* deletes;    // Deletion vectors of the file
+    const uint64_t* chunk_deleted; // Deletion vector of the current chunk (NULL if none)
+    
+    // Commits published by the writer, polled instead of re-reading the header
+    struct fxdb_coord* coord;   // Mapped sidecar (NULL until a writer created one)
+    uint64_t coord_sequence;    // Published sequence of the snapshot (odd when unknown)
+    
+    // Chunks after the current one, fetched into the cache by I/O threads
+    struct fxdb_read_ahead* read_ahead; // NULL when the file cannot be cached
+    
+    // Direct reads around the page cache (see reader_set_direct_io)
+    int direct_fd;              // Descriptor opened for direct I/O, valid while direct_buffer is set
+    uint8_t* direct_buffer;     // Aligned window the current chunk is read into (NULL when off)
+    size_t direct_size;         // Bytes of direct_buffer
+    
+    // Chunks decoded in place from a memory mapping (see reader_set_mmap)
+    fxdb_mmap_reader_t* map;    // Mapping of the file (NULL when off)
+    fxdb_mmap_options_t map_options; // Hints the mapping was made with
+    uint32_t map_prefetched;    // Sequential scans: chunks before this one were asked for
+    
+    // Committed chunks located so far, for mapped reads and row seeks
+    fxdb_chunk_entry_t* directory;
+    uint32_t directory_count;   // Entries filled in, from the first chunk
+    uint32_t directory_capacity; // Entries allocated
+    
+    // Buffers of reader_read_row_pooled, one decoded row each
+    fxdb_slab_pool_t row_pool;  // Sized on first use
+    
+    // Chunks scans cover, [scan_first, scan_end) (see reader_set_chunk_range)
+    uint32_t scan_first;
+    uint32_t scan_end;          // 0 for every chunk
+    
+    // Chunks loaded from each source, for profiles
+    uint64_t source_loads[READER_SOURCE_COUNT];
 } reader_t;
 
 /**
- * Enhanced reader context with memory mapping support
+ * Enhanced reader context: a reader_t reading through a memory mapping
  */
 typedef struct {
-    fxdb_mmap_reader_t* mmap_reader;  // Memory-mapped reader (if used)
-    FILE* file;                       // Traditional file handle (fallback)
-    schema_t* schema;                 // Schema loaded from file
+    reader_t* reader;                 // Reader doing the work
+    schema_t* schema;                 // Schema loaded from file (owned by reader)
     fxdb_header_t header;             // File header
-    
-    // Performance settings
-    bool use_mmap;                    // Whether to use memory mapping
-    size_t buffer_size;               // Buffer size for chunked reads
-    
-    // Current position
-    uint32_t current_chunk;           // Current chunk being read
-    uint32_t current_row;             // Current row in chunk
-    uint32_t total_rows;              // Total rows in database
-    size_t current_offset;            // Current byte offset in file
+    bool use_mmap;                    // Whether chunks are read from a mapping
+    uint32_t total_rows;              // Rows of the chunks and the log, deleted ones included
 } fxdb_enhanced_reader_t;
 
 // Row data for reading
@@ -47,23 +115,47 @@ typedef struct {
     field_value_t* values;
 } row_data_t;
 
+// Aggregate over one column, NULLs excluded
+typedef struct {
+    uint64_t row_count;         // Rows scanned
+    uint64_t value_count;       // Non-NULL values
+    double sum;                 // Sum of non-NULL numeric values
+    double min;                 // Minimum non-NULL numeric value
+    double max;                 // Maximum non-NULL numeric value
+    uint32_t chunks_summarized; // Chunks folded in from their summaries
+    uint32_t chunks_scanned;    // Chunks whose rows were read
+} column_aggregate_t;
+
+// Committed state a reader has pinned
+typedef struct {
+    uint32_t generation;        // File generation; changes when the file is rewritten
+    uint16_t sequence;          // Commit root the header was read at (0 for older files)
+    uint32_t chunk_count;       // Chunks in the snapshot
+    uint32_t committed_rows;    // Rows of the chunks and the log, deleted ones included
+} reader_snapshot_t;
+
 // Query result
 typedef struct {
     uint32_t row_count;
     row_data_t* rows;
     const schema_t* schema; // Reference to schema for proper cleanup
+    fxdb_arena_t* arena;    // Holds the result and its rows when set; else each row is malloc'd
 } query_result_t;
 
 // Function declarations
 
 /**
  * Open .fxdb file for reading
+ * Rows committed to the write-ahead log are replayed and follow the rows of
+ * the chunks in scans, seeks and row counts.
  * Returns reader_t pointer on success, NULL on failure
  */
 reader_t* reader_open(const char* filename);
 
 /**
  * Open .fxdb file for reading with enhanced performance (ENHANCED)
+ * Same rows as reader_open(): the log is replayed and deleted rows are
+ * skipped; see reader_set_mmap() for what the mapping changes.
  * @param filename Database filename
  * @param use_mmap Whether to use memory mapping for better performance
  * @return Enhanced reader pointer on success, NULL on failure
@@ -71,28 +163,218 @@ reader_t* reader_open(const char* filename);
 fxdb_enhanced_reader_t* fxdb_reader_open(const char* filename, bool use_mmap);
 
 /**
- * Read next row from file
+ * Open .fxdb file for reading through a memory mapping with the given hints
+ * With sequential access, scans also ask the kernel for the next
+ * FXDB_READ_AHEAD_CHUNKS chunks ahead of the row being read, so pages
+ * arrive before they are touched instead of faulting one at a time.
+ * fxdb_reader_open() with use_mmap uses fxdb_mmap_default_options(); the
+ * hints pay off on storage slower than the kernel's own read-around, so
+ * measure with tests/benchmarks/benchmark_read before turning them on.
+ * @param options Mapping options (NULL reads without a mapping)
+ * @return Enhanced reader pointer on success, NULL on failure
+ */
+fxdb_enhanced_reader_t* fxdb_reader_open_with_options(const char* filename, const fxdb_mmap_options_t* options);
+
+/**
+ * Change the access pattern hint of an enhanced reader, e.g. to random
+ * before a series of seeks
+ * @return 0 on success, -1 if the reader does not use a mapping
+ */
+int fxdb_reader_set_access(fxdb_enhanced_reader_t* reader, fxdb_mmap_access_t access);
+
+/**
+ * Read next row from file, skipping deleted rows
  * Returns row_data_t pointer on success, NULL on EOF or error
  */
 row_data_t* reader_read_row(reader_t* reader);
 
+/**
+ * Read next row into a buffer from the reader's row pool, skipping deleted rows
+ * The row, its values and its strings share the buffer, so no string is freed
+ * on its own; hand it back with reader_release_row(). Buffers still out when
+ * the reader closes are freed with it.
+ * Returns the row, NULL on EOF or error
+ */
+row_data_t* reader_read_row_pooled(reader_t* reader);
+
+/**
+ * Return a row from reader_read_row_pooled() to the reader's pool
+ */
+void reader_release_row(reader_t* reader, row_data_t* row);
+
+/**
+ * Read next row into `row`, allocating its values and strings from an arena
+ * Returns 0 on success, -1 on EOF or error
+ */
+int reader_read_row_into(reader_t* reader, fxdb_arena_t* arena, row_data_t* row);
+
+/**
+ * Step to the next live row without decoding it
+ * @param null_fields Receives a bit per field, set when the field is NULL (may be NULL)
+ * Returns the row's bytes, valid until the next read; NULL at the end or on error
+ */
+const uint8_t* reader_next_row_bytes(reader_t* reader, uint64_t* null_fields);
+
+/**
+ * Bytes of the row last returned by a read, laid out as in a chunk
+ * @param null_fields Receives a bit per field, set when the field is NULL (may be NULL)
+ * Returns the bytes, valid until the next read; NULL if no row has been read
+ */
+const uint8_t* reader_row_bytes(const reader_t* reader, uint64_t* null_fields);
+
+/**
+ * Decode row bytes from reader_row_bytes() into `row`, allocating its values
+ * and strings from an arena
+ * Returns 0 on success, -1 on error
+ */
+int reader_decode_row_into(const schema_t* schema, const uint8_t* buffer, uint64_t null_fields,
+                           fxdb_arena_t* arena, row_data_t* row);
+
+/**
+ * Physical position of the row last returned by reader_read_row
+ * Returns 0 on success, -1 if no row has been read
+ */
+int reader_row_position(const reader_t* reader, row_position_t* position);
+
+/**
+ * Delete rows by position
+ * Appends the rows to the deletion vectors and reloads them, so the reader
+ * no longer returns the rows. Rewinds the reader to the first row.
+ * Returns 0 on success, -1 on error
+ */
+int reader_delete_rows(reader_t* reader, const row_position_t* positions, uint32_t count);
+
+/**
+ * Compare two values of a field; NULL only equals NULL
+ */
+bool reader_values_equal(const field_def_t* field, const field_value_t* a, const field_value_t* b);
+
 /**
  * Read multiple rows with limit
+ * The result, its rows and their strings are allocated from one arena, so
+ * reader_free_result() frees them at once
  * Returns query_result_t pointer on success, NULL on error
  */
 query_result_t* reader_read_rows(reader_t* reader, uint32_t limit);
 
 /**
- * Seek to specific row number (0-based)
+ * Seek to specific row number (0-based, counting deleted rows)
  * Returns 0 on success, -1 on error
  */
 int reader_seek_row(reader_t* reader, uint32_t row_number);
 
 /**
- * Get total row count
+ * Set how many chunks a sequential scan reads ahead of the one being decoded
+ * (0 disables read-ahead; the default is FXDB_READ_AHEAD_CHUNKS)
+ */
+void reader_set_read_ahead(reader_t* reader, uint32_t chunks);
+
+/**
+ * Read chunks with direct I/O, around the page cache and the chunk cache
+ * Meant for one-shot scans of files larger than memory, which would
+ * otherwise evict the pages and chunks other readers keep hot. Each chunk is
+ * read into an aligned window from the aligned buffer pool and decoded where
+ * it landed; read-ahead is skipped while direct I/O is on. Files written
+ * with align_chunks need no extra blocks per chunk; other files work too.
+ * Returns 0 on success, -1 if the file system does not support direct I/O
+ * (the reader keeps using buffered reads)
+ */
+int reader_set_direct_io(reader_t* reader, bool enable);
+
+/**
+ * Read chunks straight out of a memory mapping of the file
+ * Rows are decoded where they lie in the mapping: no copy into the chunk
+ * cache or a private buffer, and no read-ahead threads. The chunk headers
+ * are walked once into a directory, so later seeks jump to their chunk.
+ * Log rows and deleted rows are handled as with buffered reads, and
+ * reader_refresh() maps the file again once it has grown. With sequential
+ * access in the options, scans ask the kernel for the next
+ * FXDB_READ_AHEAD_CHUNKS chunks before they are reached. Turns direct I/O
+ * off; files smaller than FXDB_MIN_MMAP_SIZE keep buffered reads.
+ * @param options Mapping options (NULL for fxdb_mmap_default_options())
+ * Returns 0 on success, -1 if the file cannot be mapped (the reader keeps
+ * using buffered reads)
+ */
+int reader_set_mmap(reader_t* reader, bool enable, const fxdb_mmap_options_t* options);
+
+/**
+ * Position the reader before the first row
+ */
+void reader_rewind(reader_t* reader);
+
+/**
+ * Confine scans to chunks [first, end) and rewind to the first, so threads
+ * with a reader each can scan parts of a table; (0, 0) restores the whole table
+ * Returns 0 on success, -1 on error
+ */
+int reader_set_chunk_range(reader_t* reader, uint32_t first, uint32_t end);
+
+/**
+ * Chunks a scan walks: the file's, plus one for the rows of the log
+ */
+uint32_t reader_chunk_count(const reader_t* reader);
+
+/**
+ * Re-read the header and the write-ahead log to pick up rows committed since
+ * the reader was opened
+ * Returns 0 on success, -1 if the file was rewritten or replaced (compacted)
+ * and must be reopened
+ */
+int reader_refresh(reader_t* reader);
+
+/**
+ * Check whether a writer committed since the reader's snapshot
+ * Reads the shared-memory state the writer publishes, without touching the
+ * file; refresh when it reports new commits.
+ * @param committed_rows Receives the published row count, deleted rows included (may be NULL)
+ * Returns 1 when there are new commits, 0 when there are none, -1 when no
+ * writer state is available and only reader_refresh() can tell
+ */
+int reader_poll(reader_t* reader, uint32_t* committed_rows);
+
+/**
+ * Get total row count, deleted rows excluded
  */
 uint32_t reader_get_row_count(const reader_t* reader);
 
+/**
+ * Committed state pinned when the reader was opened or last refreshed
+ * Scans see exactly these rows however far a writer has moved on; the
+ * header and log are read without locks.
+ */
+void reader_get_snapshot(const reader_t* reader, reader_snapshot_t* snapshot);
+
+/**
+ * Get the number of deleted rows still stored in the file
+ */
+uint32_t reader_get_deleted_count(const reader_t* reader);
+
+/**
+ * Validity bitmap of a field in the current chunk
+ * Returns NULL when the field is not nullable (every row has a value)
+ */
+const uint64_t* reader_chunk_validity(const reader_t* reader, uint32_t field_index);
+
+/**
+ * Aggregate a column over the whole file, skipping NULLs and deleted rows
+ * NULL and deletion handling works on whole bitmap words; numeric sum/min/max are only
+ * filled for int32 and float columns. Rewinds the reader to the first row.
+ * Returns 0 on success, -1 on error
+ */
+int reader_aggregate_column(reader_t* reader, uint32_t field_index, column_aggregate_t* out);
+
+/**
+ * Aggregate a column over rows first_row..end_row - 1, skipping NULLs and deleted rows
+ * Rows are numbered as in reader_seek_row(), deleted ones included; end_row
+ * past the last row stops at it. Chunks the range covers whole are folded in
+ * from their summaries (see summary.h) when they have one and no deleted
+ * rows; the chunks at either end of the range, the log's rows and the other
+ * chunks are read. Rewinds the reader to the first row.
+ * Returns 0 on success, -1 on error
+ */
+int reader_aggregate_rows(reader_t* reader, uint32_t field_index, uint32_t first_row, uint32_t end_row,
+                          column_aggregate_t* out);
+
 /**
  * Get reader statistics
  */
@@ -105,6 +387,8 @@ void reader_print_row(const reader_t* reader, const row_data_t* row);
 
 /**
  * Print multiple rows in formatted table
+ * Uses the result's schema when it has one, else the reader's (reader may
+ * then be NULL)
  */
 void reader_print_rows(const reader_t* reader, const query_result_t* result);
 
@@ -155,4 +439,9 @@ row_data_t* deserialize_row(const schema_t* schema, const uint8_t* buffer);
  */
 int reader_load_chunk(reader_t* reader, uint32_t chunk_index);
 
+/**
+ * Name of a chunk source: "file", "cache", "mmap", "direct" or "log"
+ */
+const char* reader_source_name(reader_source_t source);
+
 #endif // READER_H
\ No newline at end of file
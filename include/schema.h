@@ -19,6 +19,7 @@ typedef struct {
     char name[MAX_FIELD_NAME_LENGTH];
     field_type_t type;
     uint32_t size;  // Size in bytes (for strings: max length, others: fixed size)
+    bool nullable;  // Column may hold NULL (type written with a '?' suffix)
 } field_def_t;
 
 // Schema structure
@@ -32,6 +33,7 @@ typedef struct {
 
 /**
  * Parse a schema string like "name string, age int32, salary float"
+ * A trailing '?' on the type ("age int32?") marks the column nullable.
  * Returns pointer to schema_t on success, NULL on failure
  */
 schema_t* parse_schema(const char* schema_str);
@@ -76,6 +78,21 @@ uint32_t calculate_row_size(const schema_t* schema);
  */
 bool validate_schema(const schema_t* schema);
 
+/**
+ * Bitmask with bit i set when field i is nullable
+ */
+uint64_t schema_null_mask(const schema_t* schema);
+
+/**
+ * Mark fields nullable according to a header null mask
+ */
+void schema_apply_null_mask(schema_t* schema, uint64_t null_mask);
+
+/**
+ * Byte offset of a field inside a serialized row
+ */
+uint32_t schema_field_offset(const schema_t* schema, uint32_t field_index);
+
 /**
  * Get string representation of field type
  */
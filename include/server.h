@@ -0,0 +1,67 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdint.h>
+
+/* ============================================================================
+ * Database Server
+ * ============================================================================
+ * `flexon serve` runs a local daemon that keeps databases open for many
+ * clients, so a short query pays neither the file open nor the schema parse.
+ * Each database served gets one reader, refreshed when the shared commit
+ * state says a writer committed, and a writer opened on the first insert.
+ * Both stay warm, and with them the chunk cache.
+ *
+ * One thread runs an epoll loop over the Unix socket and its connections. It
+ * splits incoming bytes into requests (see protocol.h) and queues each
+ * connection with requests on a worker pool. A connection is served by one
+ * worker at a time, which keeps its answers in request order; the worker
+ * takes all its queued requests at once and commits a run of inserts into
+ * the same database together. A client that does not read its answers is
+ * held back: once its unsent answers or queued requests pass a cap, the
+ * server stops reading its socket and serving its requests until the
+ * answers drain. Writers are logged (see wal.h) and closed
+ * after a while without inserts, which releases the database to other
+ * writers. Linux only.
+ */
+
+// Server configuration
+typedef struct {
+    const char* socket_path;    // Unix socket to listen on (replaced if stale)
+    const char* directory;      // Where database names are resolved; names may not leave it
+                                // (NULL: working directory, any path)
+    uint32_t workers;           // Worker threads (0: one per CPU)
+    uint32_t writer_idle_ms;    // Close a writer after this long without inserts
+} fxdb_server_config_t;
+
+// Server state (private to server.c)
+typedef struct fxdb_server fxdb_server_t;
+
+/**
+ * Get the default server configuration (socket_path still to be set)
+ */
+fxdb_server_config_t fxdb_server_default_config(void);
+
+/**
+ * Bind the socket and start the worker pool
+ * Returns the server on success, NULL on failure
+ */
+fxdb_server_t* fxdb_server_create(const fxdb_server_config_t* config);
+
+/**
+ * Serve clients until fxdb_server_stop() is called
+ * Returns 0 after a stop, -1 on error
+ */
+int fxdb_server_run(fxdb_server_t* server);
+
+/**
+ * Ask a running server to stop; safe to call from a signal handler
+ */
+void fxdb_server_stop(fxdb_server_t* server);
+
+/**
+ * Close connections and databases, remove the socket and free the server
+ */
+void fxdb_server_free(fxdb_server_t* server);
+
+#endif // SERVER_H
@@ -6,6 +6,7 @@
 #include "schema.h"
 #include "reader.h"
 #include "writer.h"
+#include "query.h"
 
 /* Ensure time.h is included for struct timespec */
 #include <time.h>
@@ -14,6 +15,7 @@
 #define MAX_COMMAND_LEN 1024
 #define MAX_DATABASE_NAME_LEN 256
 #define MAX_PATH_LEN 512
+#define SHELL_WRITER_IDLE_MS 1000  // Idle time at the prompt after which inserts give up the writer lock
 
 // ANSI Color codes for enhanced output
 #define COLOR_RESET     "\033[0m"
@@ -59,6 +61,24 @@
 #define COLOR_EMPHASIS  COLOR_BR_WHITE COLOR_BOLD
 #define COLOR_MUTED     COLOR_BR_BLACK
 
+// Open handles for the active database, kept across commands
+typedef struct {
+    char path[MAX_PATH_LEN];    // File the handles belong to ("" when none)
+    reader_t* reader;           // Shared reader (header and schema loaded once)
+    writer_t* writer;           // Writer kept across a run of inserts, committed after each one
+    bool reader_stale;          // File changed since the reader read its header
+    
+    // File identity when last validated; a change invalidates the handles
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    time_t mtime;
+    uint64_t wal_size;          // Write-ahead log, which commits change instead of the file
+    time_t wal_mtime;
+    uint64_t deletes_size;      // Deletion vectors, which deletes change instead of the file
+    time_t deletes_mtime;
+} shell_handles_t;
+
 // Shell session information
 typedef struct {
     char user[64];              // Current user
@@ -66,6 +86,7 @@ typedef struct {
     char current_db[MAX_DATABASE_NAME_LEN]; // Active database
     time_t session_start;       // Session start time
     uint32_t commands_executed; // Commands executed in session
+    shell_handles_t handles;    // Cached handles for current_db
 } shell_session_t;
 
 // Command types for the interactive shell
@@ -77,10 +98,15 @@ typedef enum {
     CMD_SELECT,
     CMD_COUNT,
     CMD_INSERT,
+    CMD_DELETE,
+    CMD_UPDATE,
+    CMD_COMPACT,
     CMD_EXPORT,
     CMD_INFO,
     CMD_SCHEMA,
     CMD_STATUS,
+    CMD_STATS,
+    CMD_EXPLAIN,
     CMD_HELP,
     CMD_CLEAR,
     CMD_HISTORY,
@@ -95,6 +121,7 @@ typedef struct {
     char* args[16];             // Command arguments
     int arg_count;
     char* raw_line;             // Original command line
+    fxdb_arena_t* arena;        // Holds the command, its arguments and the line
 } parsed_command_t;
 
 // Function declarations for shell.c
@@ -146,6 +173,52 @@ void free_parsed_command(parsed_command_t* cmd);
  */
 shell_command_t get_command_type(const char* cmd_str);
 
+/**
+ * Parse the clauses of a select: [*] [where field=value] [limit N]
+ * @param first Index of the first argument after "select"
+ * Prints the problem and returns -1 if the clauses are invalid for the schema
+ */
+int parse_select_query(const parsed_command_t* cmd, int first, const schema_t* schema, query_t* query);
+
+// A join of two databases on one field each
+typedef struct {
+    char left[MAX_DATABASE_NAME_LEN];       // Databases after "from" and "join", without ".fxdb"
+    char right[MAX_DATABASE_NAME_LEN];
+    char left_field[MAX_FIELD_NAME_LENGTH]; // Field of the left database in the condition
+    char right_field[MAX_FIELD_NAME_LENGTH];
+    uint32_t limit;                         // 0 for every row
+} join_query_t;
+
+/**
+ * Parse a join: from <a> join <b> on <a>.<field> = <b>.<field> [limit N]
+ * The condition's sides may come in either order, and the names may be
+ * written with or without ".fxdb".
+ * @param first Index of "from"
+ * Prints the problem and returns -1 if the join is invalid
+ */
+int parse_join_query(const parsed_command_t* cmd, int first, join_query_t* query);
+
+// Aggregates answered from chunk summaries
+typedef enum {
+    APPROX_COUNT_DISTINCT,
+    APPROX_PERCENTILE
+} approx_function_t;
+
+// An approximate aggregate of one field of the current database
+typedef struct {
+    approx_function_t function;
+    char field[MAX_FIELD_NAME_LENGTH];
+    double percentile;                      // APPROX_PERCENTILE: from 0 to 1
+} approx_query_t;
+
+/**
+ * Parse approx_count_distinct(<field>) or approx_percentile(<field>, <p>)
+ * The call may be spread over several arguments.
+ * @param first Index of the argument starting with "approx_"
+ * Prints the problem and returns -1 if the call is invalid
+ */
+int parse_approx_query(const parsed_command_t* cmd, int first, approx_query_t* query);
+
 // Function declarations for formatter.c
 
 /**
@@ -201,6 +274,44 @@ char* get_database_path(const char* directory, const char* database_name);
  */
 void get_current_user(char* buffer, size_t buffer_size);
 
+/**
+ * Reader for the active database, positioned at the first row
+ * Reuses the session's reader while the file is unchanged, refreshes it after
+ * appends and reopens it when the file was replaced. Owned by the session.
+ * Returns NULL if no database is selected or it cannot be opened
+ */
+reader_t* session_get_reader(shell_session_t* session);
+
+/**
+ * Writer for the active database, holding the writer lock
+ * Owned by the session; call session_commit() after inserting. The writer
+ * stays open for the next insert until session_close_writer() gives up the lock.
+ */
+writer_t* session_get_writer(shell_session_t* session);
+
+/**
+ * Commit the session writer so the inserted rows are on disk
+ * A failed commit discards the writer.
+ * Returns 0 on success, -1 on error
+ */
+int session_commit(shell_session_t* session);
+
+/**
+ * Commit and close the session writer, releasing the writer lock
+ * Returns 0 on success (or when there is no writer), -1 on error
+ */
+int session_close_writer(shell_session_t* session);
+
+/**
+ * Close a session writer left open by a failed command, without committing
+ */
+void session_release_writer(shell_session_t* session);
+
+/**
+ * Close the cached handles, committing any pending inserts
+ */
+void session_close_handles(shell_session_t* session);
+
 /**
  * Measure command execution time
  */
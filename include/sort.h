@@ -0,0 +1,105 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "schema.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Row Sorting
+ * ============================================================================
+ * A sorter orders rows, laid out as in a chunk (see reader_row_bytes), by one
+ * field. NULLs sort first ascending and last descending; rows with equal keys
+ * come out in the order they were added.
+ *
+ * Rows are gathered into segments. While they fit the memory budget, the
+ * segments are sorted in parallel when the input ends and merged in memory.
+ * Once the budget is reached, the held segments are sorted and written out as
+ * runs by worker threads, one run per segment, and the sorter goes on
+ * gathering; the runs are then merged k-way, in passes of up to
+ * FXDB_SORT_MAX_FANIN runs, with the last pass streaming rows to the caller.
+ * Runs are temporary files named after `temp_prefix`, removed as they are
+ * merged and when the sorter is freed.
+ *
+ * With top_n set the sorter keeps only the first top_n rows in a bounded
+ * heap, so memory stays proportional to top_n however many rows are added.
+ */
+
+#define FXDB_SORT_DEFAULT_MEMORY (64u << 20) // Bytes of rows held before spilling
+#define FXDB_SORT_SEGMENTS 8                 // Segments the memory budget is split into
+#define FXDB_SORT_MAX_FANIN 64               // Runs merged at once
+#define FXDB_SORT_MAX_THREADS 16
+
+// Sort settings
+typedef struct {
+    uint32_t field;             // Field to sort by
+    bool descending;
+    uint32_t top_n;             // Keep only the first top_n rows in a heap (0 sorts every row)
+    size_t memory_limit;        // Bytes of rows held in memory (0 for FXDB_SORT_DEFAULT_MEMORY)
+    uint32_t threads;           // Run generation threads (0 uses one per online CPU)
+    const char* temp_prefix;    // Runs are written to <temp_prefix>.sort<pid>-<n>
+} fxdb_sort_options_t;
+
+// What a sort did
+typedef struct {
+    uint64_t rows;              // Rows added
+    uint32_t segments;          // Segments sorted in memory or written as runs
+    uint32_t runs;              // Runs written, those of intermediate merges included
+    uint32_t merge_passes;      // Merges of runs, the final one included
+    uint64_t bytes_spilled;     // Bytes written to runs
+    uint32_t threads;           // Threads sorting segments
+    bool heap;                  // Rows kept in a top-N heap
+} fxdb_sort_stats_t;
+
+typedef struct fxdb_sorter fxdb_sorter_t;
+
+/**
+ * Create default sort options for a field
+ */
+fxdb_sort_options_t fxdb_sort_default_options(uint32_t field);
+
+/**
+ * Bytes a held row of a schema takes, to size top_n against a memory budget
+ */
+size_t fxdb_sort_row_bytes(const schema_t* schema);
+
+/**
+ * Create a sorter for rows of a schema
+ * Returns NULL on error
+ */
+fxdb_sorter_t* fxdb_sorter_create(const schema_t* schema, const fxdb_sort_options_t* options);
+
+/**
+ * Add a row
+ * @param row Bytes of the row, copied
+ * @param null_fields A bit per field, set when the field is NULL
+ * Returns 0 on success, -1 on error
+ */
+int fxdb_sorter_add(fxdb_sorter_t* sorter, const uint8_t* row, uint64_t null_fields);
+
+/**
+ * End the input: sort what is held and prepare the merge
+ * Returns 0 on success, -1 on error
+ */
+int fxdb_sorter_finish(fxdb_sorter_t* sorter);
+
+/**
+ * Take the next row in order, after fxdb_sorter_finish()
+ * @param row Receives the row's bytes, valid until the next call
+ * @param null_fields Receives the row's NULL fields
+ * Returns 1 for a row, 0 at the end, -1 on error
+ */
+int fxdb_sorter_next(fxdb_sorter_t* sorter, const uint8_t** row, uint64_t* null_fields);
+
+/**
+ * What the sorter has done so far
+ */
+void fxdb_sorter_stats(const fxdb_sorter_t* sorter, fxdb_sort_stats_t* stats);
+
+/**
+ * Free a sorter and remove its runs
+ */
+void fxdb_sorter_free(fxdb_sorter_t* sorter);
+
+#endif // SORT_H
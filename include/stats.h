@@ -0,0 +1,288 @@
+#ifndef FLEXON_STATS_H
+#define FLEXON_STATS_H
+
+/* ============================================================================
+ * FlexonDB Operation Statistics
+ * ============================================================================
+ * Counters kept by the reader, the writer and the I/O paths beneath them.
+ * Each thread updates a block of its own without locks or atomic read-modify-
+ * write; fxdb_get_statistics sums the blocks of live threads and the totals
+ * left behind by threads that have exited. Decode time is measured on one row
+ * in FXDB_STATS_DECODE_SAMPLE and scaled, so timing stays off the per-row path.
+ *
+ * Public operations (open, schema load, chunk load, insert, flush, commit,
+ * close) also record their latency in log-linear histograms. Inserts that do
+ * not fill a chunk are timed one in FXDB_STATS_INSERT_SAMPLE, each sample
+ * counted for the inserts it stands for; all others are timed every time
+ * (and every insert is while tracing). Values below
+ * 2^FXDB_HISTOGRAM_SUB_BITS ticks get a bucket each, and every power of two
+ * above is split into 2^FXDB_HISTOGRAM_SUB_BITS buckets, so each bucket is
+ * within 1/16 of the values it holds. Ticks come from the invariant TSC where
+ * there is one and from CLOCK_MONOTONIC otherwise.
+ *
+ * With FLEXON_TRACE=<file> in the environment, every operation is also written
+ * to <file> as a Chrome trace event ("ph": "X"), which chrome://tracing and
+ * Perfetto load directly.
+ */
+
+#include "types.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define FXDB_STATS_DECODE_SAMPLE 16  // Rows per timed decode (a power of two)
+#define FXDB_STATS_INSERT_SAMPLE 16  // Inserts per timed insert
+#define FXDB_HISTOGRAM_SUB_BITS 4    // log2 of the buckets per power of two
+#define FXDB_HISTOGRAM_MAX_BITS 44   // Longer latencies land in the last bucket
+#define FXDB_HISTOGRAM_BUCKETS ((FXDB_HISTOGRAM_MAX_BITS - FXDB_HISTOGRAM_SUB_BITS + 1) << FXDB_HISTOGRAM_SUB_BITS)
+#define FXDB_TRACE_ENV "FLEXON_TRACE"
+
+typedef enum {
+    FXDB_STAT_BYTES_READ = 0,
+    FXDB_STAT_BYTES_WRITTEN,
+    FXDB_STAT_READ_CALLS,
+    FXDB_STAT_WRITE_OPS,             // fwrite/pwrite calls; buffered fwrites are not syscalls
+    FXDB_STAT_SYNC_CALLS,
+    FXDB_STAT_CHUNKS_LOADED,
+    FXDB_STAT_CHUNKS_WRITTEN,
+    FXDB_STAT_ROWS_DECODED,
+    FXDB_STAT_ROWS_ENCODED,
+    FXDB_STAT_ALLOCATIONS,
+    FXDB_STAT_READ_NS,               // Nanoseconds in read calls
+    FXDB_STAT_WRITE_NS,              // Nanoseconds in write and sync calls
+    FXDB_STAT_DECODE_NS,             // Nanoseconds decoding rows (sampled)
+    FXDB_STAT_COUNT
+} fxdb_stat_t;
+
+typedef enum {
+    FXDB_LATENCY_OPEN = 0,           // reader_open, writer_create, writer_open
+    FXDB_LATENCY_SCHEMA_LOAD,
+    FXDB_LATENCY_CHUNK_LOAD,
+    FXDB_LATENCY_INSERT,
+    FXDB_LATENCY_FLUSH,              // writer_flush_chunk
+    FXDB_LATENCY_COMMIT,             // writer_commit: flush, header rewrite, sync
+    FXDB_LATENCY_CLOSE,              // reader_close, writer_close
+    FXDB_LATENCY_COUNT
+} fxdb_latency_op_t;
+
+typedef struct {
+    uint64_t counts[FXDB_HISTOGRAM_BUCKETS];
+    uint64_t count;                  // Values recorded
+    uint64_t sum;                    // Sum of the values, in ticks
+    uint64_t max;                    // Largest value, in ticks
+} fxdb_histogram_t;
+
+typedef struct {
+    uint64_t count;
+    double mean_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double p999_ns;
+    double max_ns;
+} fxdb_latency_summary_t;
+
+typedef struct {
+    uint64_t ticks;                  // Start, in ticks
+    uint64_t ns;                     // Start on the monotonic clock, when tracing
+} fxdb_op_timer_t;
+
+typedef struct fxdb_thread_stats {
+    uint64_t counters[FXDB_STAT_COUNT];
+    fxdb_histogram_t latency[FXDB_LATENCY_COUNT];
+    uint32_t thread_id;              // Small id used as the trace "tid"
+    struct fxdb_thread_stats* next;  // Registry of live threads (owned by stats.c)
+} fxdb_thread_stats_t;
+
+// Time a thread spent working, for utilization reports
+typedef struct {
+    uint32_t thread_id;
+    uint64_t busy_ns;                // Read, write and decode time since the thread started
+} fxdb_thread_busy_t;
+
+// Set once at load time: whether ticks are TSC cycles, and whether spans are traced
+extern bool fxdb_ticks_use_tsc;
+extern bool fxdb_tracing;
+
+// The calling thread's block; NULL until its first update
+extern __thread fxdb_thread_stats_t* fxdb_thread_stats;
+
+/**
+ * Allocate and register the calling thread's block
+ * Returns NULL when out of memory; updates are then dropped
+ */
+fxdb_thread_stats_t* fxdb_stats_register(void);
+
+/**
+ * Add to one of the calling thread's counters
+ * Only the owning thread writes a block, so a relaxed store is enough for
+ * readers on other threads to see whole values
+ */
+static inline void fxdb_stats_add(fxdb_stat_t stat, uint64_t amount) {
+    fxdb_thread_stats_t* local = fxdb_thread_stats ? fxdb_thread_stats : fxdb_stats_register();
+    if (local) {
+        __atomic_store_n(&local->counters[stat], local->counters[stat] + amount, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Whether the next row decoded on this thread is one of the timed samples
+ */
+static inline bool fxdb_stats_sample_decode(void) {
+    return !fxdb_thread_stats ||
+           (fxdb_thread_stats->counters[FXDB_STAT_ROWS_DECODED] & (FXDB_STATS_DECODE_SAMPLE - 1)) == 0;
+}
+
+/**
+ * Monotonic clock in nanoseconds, for the *_NS counters
+ */
+uint64_t fxdb_stats_clock(void);
+
+/**
+ * Current time in histogram ticks
+ */
+static inline uint64_t fxdb_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (fxdb_ticks_use_tsc) {
+        return __rdtsc();
+    }
+#endif
+    return fxdb_stats_clock();
+}
+
+/**
+ * Convert ticks to nanoseconds
+ */
+double fxdb_ticks_to_ns(uint64_t ticks);
+
+/**
+ * Bucket of a value in a log-linear histogram
+ */
+static inline uint32_t fxdb_histogram_bucket(uint64_t value) {
+    uint32_t sub = 1u << FXDB_HISTOGRAM_SUB_BITS;
+    if (value < sub) {
+        return (uint32_t)value;
+    }
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+    if (msb >= FXDB_HISTOGRAM_MAX_BITS) {
+        return FXDB_HISTOGRAM_BUCKETS - 1;
+    }
+    uint32_t shift = msb - FXDB_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << FXDB_HISTOGRAM_SUB_BITS) + (uint32_t)(value >> shift) - sub;
+}
+
+/**
+ * Largest value that falls in a bucket
+ */
+uint64_t fxdb_histogram_bucket_limit(uint32_t bucket);
+
+/**
+ * Record a value `weight` times; the histogram must be written by one thread only
+ */
+static inline void fxdb_histogram_record_n(fxdb_histogram_t* histogram, uint64_t value, uint32_t weight) {
+    uint64_t* slot = &histogram->counts[fxdb_histogram_bucket(value)];
+    __atomic_store_n(slot, *slot + weight, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->count, histogram->count + weight, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->sum, histogram->sum + value * weight, __ATOMIC_RELAXED);
+    if (value > histogram->max) {
+        __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Record a value once
+ */
+static inline void fxdb_histogram_record(fxdb_histogram_t* histogram, uint64_t value) {
+    fxdb_histogram_record_n(histogram, value, 1);
+}
+
+/**
+ * Value below which a fraction `q` (0..1) of the recorded values fall, in
+ * ticks; reports the top of the bucket, never more than the maximum
+ */
+uint64_t fxdb_histogram_percentile(const fxdb_histogram_t* histogram, double q);
+
+/**
+ * Start timing an operation
+ */
+static inline fxdb_op_timer_t fxdb_op_begin(void) {
+    fxdb_op_timer_t timer = { fxdb_ticks(), fxdb_tracing ? fxdb_stats_clock() : 0 };
+    return timer;
+}
+
+/**
+ * Record an operation's latency, and write its span when tracing
+ * `name` labels the span; `detail` (may be NULL) is added to its arguments
+ */
+void fxdb_op_end(fxdb_latency_op_t op, const char* name, const char* detail, fxdb_op_timer_t timer);
+
+/**
+ * fxdb_op_end for a sampled operation that stands for `weight` operations
+ */
+void fxdb_op_end_weighted(fxdb_latency_op_t op, const char* name, const char* detail, fxdb_op_timer_t timer,
+                          uint32_t weight);
+
+/**
+ * Write spans to `path` from now on, as FLEXON_TRACE does from start-up
+ * Returns 0 on success, -1 if the file cannot be created
+ */
+int fxdb_trace_start(const char* path);
+
+/**
+ * Finish the trace file; later operations are no longer traced
+ */
+void fxdb_trace_stop(void);
+
+/**
+ * Name of an operation
+ */
+const char* fxdb_op_name(fxdb_latency_op_t op);
+
+/**
+ * Latency histogram of an operation summed over all threads since the last reset
+ */
+void fxdb_get_latency(fxdb_latency_op_t op, fxdb_histogram_t* histogram);
+
+/**
+ * Count, mean, percentiles and maximum of an operation's latency, in nanoseconds
+ */
+void fxdb_get_latency_summary(fxdb_latency_op_t op, fxdb_latency_summary_t* summary);
+
+/**
+ * Busy time of each live thread, up to `capacity` of them
+ * Returns the number of threads filled in
+ */
+uint32_t fxdb_get_thread_busy(fxdb_thread_busy_t* threads, uint32_t capacity);
+
+/**
+ * fxdb_sync_file, counted as a sync call with its time as write time
+ */
+int fxdb_stats_sync_file(int fd);
+
+/**
+ * Fill every field of `stats`: the counters summed over all threads since the
+ * last reset, and the chunk cache's hits, misses and memory usage
+ */
+void fxdb_get_statistics(db_statistics_t* stats);
+
+/**
+ * Start the counters and latency histograms over from zero (the chunk cache
+ * figures are not reset)
+ */
+void fxdb_reset_statistics(void);
+
+/**
+ * Print statistics as an indented report
+ */
+void fxdb_print_statistics(const db_statistics_t* stats);
+
+/**
+ * Print the latency percentiles of every operation that ran, one line each
+ */
+void fxdb_print_latency(void);
+
+#endif // FLEXON_STATS_H
@@ -0,0 +1,166 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include "reader.h"
+#include "sketch.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * Chunk Summaries
+ * ============================================================================
+ * As a writer writes a chunk it summarizes each column of it: the count of
+ * non-NULL values, for numeric columns their sum, minimum and maximum, a
+ * HyperLogLog of the values and, for numeric columns, a KLL sketch (see
+ * sketch.h). Summaries go to a sidecar file (<database>.fxdb.sum) since
+ * chunks are appended and the file has no room after them; approximate
+ * queries merge the summaries of every chunk instead of reading the rows,
+ * and aggregates fold in the exact count, sum, minimum and maximum of every
+ * chunk they cover whole (see reader_aggregate_rows()).
+ *
+ * Layout: [fxdb_summary_header_t][record]... with each record being
+ * [u32 checksum][u32 chunk index][u32 payload size][payload], and the
+ * payload [u32 rows], then per field [u64 non-NULL values][f64 sum]
+ * [f64 min][f64 max], then per field [u32 size][HyperLogLog][u32 size]
+ * [KLL sketch, empty unless numeric]. The aggregates come first so they can
+ * be read without decoding the sketches.
+ *
+ * Summaries are advisory. A chunk without one (written before summaries
+ * existed, or by a writer with them off), with deleted rows, or the rows of
+ * the write-ahead log, is read instead; so is every chunk of a file whose
+ * summaries belong to another generation. Records past the committed chunks
+ * are ignored and cut off by the next writer; a later record of a chunk
+ * replaces an earlier one.
+ */
+
+#define FXDB_SUMMARY_MAGIC 0x53445846   // "FXDS"
+#define FXDB_SUMMARY_VERSION 2
+
+// Summary file header
+typedef struct {
+    uint32_t magic;             // FXDB_SUMMARY_MAGIC
+    uint32_t version;           // Summary file format version
+    uint32_t generation;        // Database generation the summaries belong to
+    uint32_t field_count;       // Fields summarized per chunk
+} __attribute__((packed)) fxdb_summary_header_t;
+
+// Sketches of a column's non-NULL values
+typedef struct {
+    fxdb_hll_t distinct;        // Distinct values
+    fxdb_kll_t quantiles;       // Numeric columns only
+    uint64_t value_count;       // Non-NULL values
+    double sum;                 // Of numeric values, NaN included
+    double min;                 // Of numeric values; INFINITY when none
+    double max;                 // Of numeric values; -INFINITY when none
+} fxdb_column_sketch_t;
+
+// How sketches of a file were put together
+typedef struct {
+    uint32_t chunks_summarized; // Chunks merged from their summaries
+    uint32_t chunks_scanned;    // Chunks whose rows were read
+    uint64_t row_count;         // Live rows covered
+} fxdb_summary_stats_t;
+
+// Appends summaries to a database's summary file (private to summary.c)
+typedef struct fxdb_summary_writer fxdb_summary_writer_t;
+
+/**
+ * Path of the summary file belonging to a database file
+ * Returns a malloc'd string, or NULL on allocation failure
+ */
+char* summary_path(const char* db_path);
+
+/**
+ * Start empty column sketches
+ */
+void summary_sketch_init(fxdb_column_sketch_t* sketch);
+
+/**
+ * Free the memory of column sketches
+ */
+void summary_sketch_free(fxdb_column_sketch_t* sketch);
+
+/**
+ * Add rows in chunk layout to column sketches
+ * @param validity One bitmap of validity_words words per nullable field, by
+ *                 nullable ordinal; a set bit marks a value
+ * @param deleted Rows to leave out (NULL for none)
+ * @param fields Bit i set to sketch field i
+ * @param sketches One per field of the schema
+ * Returns 0 on success, -1 when out of memory
+ */
+int summary_add_rows(const schema_t* schema, uint64_t null_mask, const uint8_t* rows, uint32_t row_count,
+                     const uint64_t* validity, uint32_t validity_words, const uint64_t* deleted,
+                     uint64_t fields, fxdb_column_sketch_t* sketches);
+
+/**
+ * Summarize the rows of a chunk
+ * @param size Receives the bytes of the summary
+ * Returns the malloc'd summary (a record payload), NULL on failure
+ */
+uint8_t* summary_encode_chunk(const schema_t* schema, uint64_t null_mask, const uint8_t* rows, uint32_t row_count,
+                              const uint64_t* validity, uint32_t validity_words, size_t* size);
+
+/**
+ * Open the summary file of a database for appending
+ * A missing file, or one of another generation, is replaced by an empty
+ * one; records of chunks past db_header->chunk_count are cut off.
+ * Returns the summary writer, NULL on failure
+ */
+fxdb_summary_writer_t* summary_writer_open(const char* db_path, const fxdb_header_t* db_header,
+                                           const schema_t* schema);
+
+/**
+ * Summarize a chunk just written and append its record
+ * Returns 0 on success, -1 on failure
+ */
+int summary_writer_add_chunk(fxdb_summary_writer_t* writer, uint32_t chunk_index, const uint8_t* rows,
+                             uint32_t row_count, const uint64_t* validity, uint32_t validity_words);
+
+/**
+ * Append the record of a chunk summarized by summary_encode_chunk()
+ * Returns 0 on success, -1 on failure
+ */
+int summary_writer_append(fxdb_summary_writer_t* writer, uint32_t chunk_index, const uint8_t* payload,
+                          size_t size);
+
+/**
+ * Close a summary writer
+ * Returns 0 on success, -1 if buffered records could not be written
+ */
+int summary_writer_close(fxdb_summary_writer_t* writer);
+
+/**
+ * Sketch columns of a file, chunks with deleted rows and log rows excluded
+ * Committed chunks with a summary and no deleted rows are merged from the
+ * summary; the others are read. The reader is rewound.
+ * @param fields Bit i set to sketch field i
+ * @param sketches One per field of the schema, initialized by
+ *                 summary_sketch_init(); sketches of the fields asked for are
+ *                 merged into
+ * @param stats Receives how the sketches were put together (may be NULL)
+ * Returns 0 on success, -1 on failure
+ */
+int summary_sketch_columns(reader_t* reader, uint64_t fields, fxdb_column_sketch_t* sketches,
+                           fxdb_summary_stats_t* stats);
+
+/**
+ * Exact aggregates of a column per committed chunk, from the summaries
+ * Chunks with deleted rows, or without an intact summary, are left out.
+ * @param aggregates One per committed chunk; filled where summarized is set,
+ *                   row_count being the chunk's rows and sum/min/max left as
+ *                   the identities (0, INFINITY, -INFINITY) for non-numeric
+ *                   columns
+ * @param summarized One per committed chunk; set for chunks filled in
+ * Returns 0 on success (also when there are no summaries), -1 when out of memory
+ */
+int summary_chunk_aggregates(const reader_t* reader, uint32_t field_index, column_aggregate_t* aggregates,
+                             bool* summarized);
+
+/**
+ * Delete the summary file of a database, if there is one
+ * Returns 0 on success (or when there was no file), -1 on failure
+ */
+int summary_remove(const char* db_path);
+
+#endif // SUMMARY_H
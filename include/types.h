@@ -45,6 +45,7 @@ typedef struct {
     bool enable_indexing;          // Enable indexing (future)
     bool enable_checksum;          // Enable integrity checking
     uint32_t initial_capacity;     // Initial capacity hint
+    bool align_chunks;             // Aligned chunk layout, for direct I/O scans
 } fxdb_create_config_t;
 
 /**
@@ -223,6 +224,21 @@ typedef struct {
     double avg_write_time;         // Average write time in ms
     uint64_t memory_usage;         // Current memory usage in bytes
     uint64_t peak_memory_usage;    // Peak memory usage in bytes
+
+    // Storage layer counters, summed over every thread (see stats.h)
+    uint64_t bytes_read;           // Bytes read from database files
+    uint64_t bytes_written;        // Bytes written to database and log files
+    uint64_t read_calls;           // Read calls issued (pread, or fread of a chunk)
+    uint64_t write_ops;            // Write operations: pwrites, and buffered fwrites of chunk parts and log records
+    uint64_t sync_calls;           // fsync/fdatasync calls
+    uint64_t chunks_loaded;        // Chunks made current by readers, from any source
+    uint64_t chunks_written;       // Chunks appended by writers
+    uint64_t rows_decoded;         // Rows deserialized or aggregated by readers
+    uint64_t rows_encoded;         // Rows serialized by writers
+    uint64_t allocations;          // Heap allocations made while decoding rows
+    double read_io_time;           // Time in read calls in ms
+    double write_io_time;          // Time in write and sync calls in ms
+    double decode_time;            // Time decoding rows in ms (sampled)
 } db_statistics_t;
 
 /**
@@ -0,0 +1,104 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include "writer.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/* ============================================================================
+ * Write-Ahead Log
+ * ============================================================================
+ * A sidecar file (<database>.fxdb.wal) that holds the rows of the chunk a
+ * writer is still filling. Committing appends the new rows to the log instead
+ * of writing a short chunk and rewriting the header; once a full chunk's worth
+ * of rows has accumulated, it is written to the database and the log is reset.
+ *
+ * Layout: [fxdb_wal_header_t][record]... with each record being
+ * [u32 checksum][u64 present mask][row bytes]. Bit i of the present mask is
+ * clear when nullable field i is NULL. Replay stops at the first torn or
+ * corrupt record. A log is only valid for the database state it was started
+ * from (generation and row count); once a checkpoint has moved the database
+ * past that state the log is stale and ignored.
+ */
+
+#define FXDB_WAL_MAGIC 0x4C575846   // "FXWL"
+#define FXDB_WAL_VERSION 1
+
+// Log file header
+typedef struct {
+    uint32_t magic;             // FXDB_WAL_MAGIC
+    uint32_t version;           // Log format version
+    uint32_t generation;        // Database generation the log belongs to
+    uint32_t base_rows;         // Database total_rows when the log was started
+    uint32_t row_size;          // Bytes per logged row
+    uint32_t reserved;
+} __attribute__((packed)) fxdb_wal_header_t;
+
+// Open log, appended to by one writer
+typedef struct fxdb_wal {
+    FILE* file;                 // Log file handle
+    fxdb_wal_header_t header;   // Header of the current log
+    uint32_t row_count;         // Records in the log
+    uint8_t* record;            // Scratch buffer for one record
+} fxdb_wal_t;
+
+/**
+ * Path of the log belonging to a database file
+ * Returns a malloc'd string, or NULL on allocation failure
+ */
+char* wal_path(const char* db_path);
+
+/**
+ * Open the log of a database for appending
+ * A log that is still valid for db_header keeps its records (a torn tail is
+ * cut off); a missing or stale log is replaced by an empty one.
+ * Returns fxdb_wal_t pointer on success, NULL on failure
+ */
+fxdb_wal_t* wal_open(const char* db_path, const fxdb_header_t* db_header, uint32_t row_size);
+
+/**
+ * Append one serialized row to the log
+ * Returns 0 on success, -1 on failure
+ */
+int wal_append(fxdb_wal_t* wal, const uint8_t* row, uint64_t present_mask);
+
+/**
+ * Read the first count records of an open log
+ * rows receives count * row_size bytes and present count masks.
+ * Returns 0 on success, -1 if the log holds fewer valid records
+ */
+int wal_read_rows(fxdb_wal_t* wal, uint32_t count, uint8_t* rows, uint64_t* present);
+
+/**
+ * Push appended records as far as the durability level asks
+ * Returns 0 on success, -1 on failure
+ */
+int wal_sync(fxdb_wal_t* wal, fxdb_durability_t durability);
+
+/**
+ * Empty the log after a checkpoint and bind it to the new database state
+ * Returns 0 on success, -1 on failure
+ */
+int wal_reset(fxdb_wal_t* wal, const fxdb_header_t* db_header);
+
+/**
+ * Close the log, leaving its records on disk
+ */
+void wal_close(fxdb_wal_t* wal);
+
+/**
+ * Read the records of a database's log
+ * rows receives row_count * row_size bytes and present one mask per row, both
+ * malloc'd (NULL when there are no rows). Missing and stale logs have no rows.
+ * Returns the number of rows, or -1 on error
+ */
+int wal_replay(const char* db_path, const fxdb_header_t* db_header, uint32_t row_size,
+               uint8_t** rows, uint64_t** present);
+
+/**
+ * Delete the log of a database, if there is one
+ * Returns 0 on success (or when there was no log), -1 on failure
+ */
+int wal_remove(const char* db_path);
+
+#endif // WAL_H
@@ -16,13 +16,50 @@
 #define DEFAULT_CHUNK_SIZE 10000
 #endif
 
+// How far writer_commit() and writer_close() push data before returning
+typedef enum {
+    FXDB_DURABILITY_NONE,       // Data may still sit in stdio buffers
+    FXDB_DURABILITY_FLUSH,      // Handed to the OS; survives a process crash
+    FXDB_DURABILITY_FSYNC       // Synced to storage; survives power loss
+} fxdb_durability_t;
+
 // Writer configuration
 typedef struct {
     uint32_t chunk_size;        // Rows per chunk
     bool use_compression;       // Enable compression (future)
     bool build_index;           // Build index while writing
+    bool async_io;              // Write chunks on a background I/O thread
+    fxdb_durability_t durability; // Guarantee given by writer_commit/writer_close
+    uint32_t group_commit_us;   // Async: delay before a commit, to batch concurrent commits
+    bool use_wal;               // Commit to a write-ahead log; only full chunks reach the file (no async_io)
+    uint32_t lock_timeout_ms;   // How long to wait for another writer of the file (0 fails at once)
+    bool align_chunks;          // Pad chunks so each starts on a FXDB_IO_ALIGNMENT boundary (for direct I/O)
+    bool chunk_summaries;       // Summarize each chunk for approximate queries (see summary.h)
 } writer_config_t;
 
+// Background I/O state of an async writer (private to writer.c)
+struct fxdb_async_io;
+
+// Write-ahead log of a writer (see wal.h)
+struct fxdb_wal;
+
+// Shared commit state of a database (see coord.h)
+struct fxdb_coord;
+
+// Chunk summaries of a database (see summary.h)
+struct fxdb_summary_writer;
+
+// Committed extent of the file. The header holds two roots and each commit
+// overwrites the older one, so a reader that catches a header rewrite half
+// done still finds the previous commit intact in the other root.
+typedef struct {
+    uint16_t sequence;          // Commit counter, wrapping and never 0; the newer intact root is current
+    uint16_t checksum;          // Over the whole root with this field zeroed; catches a torn root
+    uint32_t total_rows;        // Committed rows
+    uint32_t chunk_count;       // Committed chunks
+    uint32_t data_size;         // Bytes of the committed chunks
+} __attribute__((packed)) fxdb_root_t;
+
 // FlexonDB file header structure
 typedef struct {
     uint32_t magic;             // FXDB magic number
@@ -36,13 +73,16 @@ typedef struct {
     uint32_t total_rows;        // Total number of rows
     uint32_t chunk_size;        // Rows per chunk
     uint32_t chunk_count;       // Number of chunks
-    uint8_t reserved[44];       // Reserved for future use (total header = 88 bytes)
+    uint64_t null_mask;         // Bit i set when field i is nullable
+    uint32_t generation;        // Bumped whenever existing chunks are rewritten
+    fxdb_root_t roots[2];       // Alternating commit roots (total header = 88 bytes)
 } __attribute__((packed)) fxdb_header_t;
 
 // Writer context
 typedef struct {
     FILE* file;                 // File handle
     schema_t* schema;           // Schema definition
+    bool owns_schema;           // Schema was loaded by writer_open and is freed with the writer
     writer_config_t config;     // Writer configuration
     fxdb_header_t header;       // File header
     
@@ -51,10 +91,26 @@ typedef struct {
     uint32_t buffer_row_count;  // Rows in buffer
     uint32_t total_rows;        // Total rows written
     uint32_t current_chunk;     // Current chunk number
+    uint32_t untimed_inserts;   // Inserts since the last timed one
+    
+    // Validity bitmaps for the current chunk, one per nullable column
+    uint64_t* validity;         // null_column_count * validity_words words
+    uint32_t null_column_count; // Number of nullable columns
+    uint32_t validity_words;    // Words per column bitmap (sized for chunk_size)
     
     // File positions
     long schema_pos;            // Position where schema was written
     long data_start_pos;        // Position where data section starts
+    
+    struct fxdb_async_io* async; // Set when config.async_io is enabled
+    
+    // Write-ahead log: the fill buffer mirrors the log's records
+    struct fxdb_wal* wal;       // Set when config.use_wal is enabled
+    uint32_t wal_logged_rows;   // Buffered rows already in the log
+    uint32_t wal_unloaded_rows; // Leading buffered rows still only in the log, read by the next checkpoint
+    char* adopted_wal;          // Log replayed into the buffer, deleted once its rows are committed
+    struct fxdb_coord* coord;   // Where commits are published to readers
+    struct fxdb_summary_writer* summaries; // Set when config.chunk_summaries is enabled
 } writer_t;
 
 // Row data structure for inserting
@@ -66,6 +122,7 @@ typedef struct {
         const char* string_val;
         bool bool_val;
     } value;
+    bool is_null;               // Value is NULL (only read for nullable fields)
 } field_value_t;
 
 // Function declarations
@@ -112,6 +169,16 @@ writer_t* writer_create_default(const char* filename, const schema_t* schema);
  */
 writer_t* fxdb_writer_open(const char* filename, fxdb_open_mode_t mode);
 
+/**
+ * Open existing .fxdb file for appending with the given configuration
+ * The file's own chunk size and layout always win over config->chunk_size
+ * and config->align_chunks. Rows left
+ * in the database's write-ahead log are taken over into the fill buffer;
+ * with config->use_wal the writer keeps appending to that log, otherwise the
+ * rows go into the next chunk and the log is deleted after the next commit.
+ */
+writer_t* writer_open_with_config(const char* filename, const writer_config_t* config);
+
 /**
  * Open existing .fxdb file for appending
  * Returns writer_t pointer on success, NULL on failure
@@ -120,18 +187,34 @@ writer_t* writer_open(const char* filename);
 
 /**
  * Insert a row using field values array
+ * Async writers accept inserts from several threads at once
  * Returns 0 on success, -1 on failure
  */
 int writer_insert_row(writer_t* writer, const field_value_t* values, uint32_t value_count);
 
 /**
  * Insert a row from JSON string (simple parser)
+ * Missing keys and JSON null become NULL on nullable fields and the type's
+ * zero value on the others.
  * Returns 0 on success, -1 on failure
  */
 int writer_insert_json(writer_t* writer, const char* json_str);
 
+/**
+ * Parse a value written as JSON or shell text for a field
+ * "null" gives a NULL value on nullable fields; strings may be quoted.
+ * String values point into text, which is modified in place.
+ * Returns 0 on success, -1 on failure
+ */
+int writer_parse_value(const field_def_t* field, char* text, field_value_t* out);
+
 /**
  * Flush current chunk to disk
+ * Chunk layout: [row_count][byte_size][rows...][validity bitmaps...], where a
+ * validity bitmap of fxdb_bitmap_words(row_count) words follows the rows for
+ * every nullable column, in field order. byte_size covers rows and bitmaps.
+ * Async writers hand the buffer to the I/O thread and keep filling the other
+ * one, blocking only while both buffers are in use.
  * Returns 0 on success, -1 on failure
  */
 int writer_flush_chunk(writer_t* writer);
@@ -141,6 +224,24 @@ int writer_flush_chunk(writer_t* writer);
  */
 void writer_get_stats(const writer_t* writer, uint32_t* total_rows, uint32_t* chunks_written);
 
+/**
+ * Flush buffered rows and rewrite the header without closing the file
+ * Readers opened afterwards see every row inserted so far, with the
+ * durability level from the writer's configuration. On async writers
+ * concurrent commits share one chunk write, header rewrite and sync.
+ * Writers with a write-ahead log append the new rows to the log instead and
+ * leave the file alone until a full chunk is checkpointed.
+ * Returns 0 on success, -1 on error
+ */
+int writer_commit(writer_t* writer);
+
+/**
+ * Move the rows of the write-ahead log into a chunk, even a partial one,
+ * and empty the log. Writers without a log just commit.
+ * Returns 0 on success, -1 on error
+ */
+int writer_checkpoint(writer_t* writer);
+
 /**
  * Close writer and finalize file
  * Returns 0 on success, -1 on failure
@@ -159,6 +260,33 @@ void writer_free(writer_t* writer);
  */
 writer_config_t writer_default_config(void);
 
+/**
+ * Newest intact commit root of a header
+ * Returns NULL for headers written before commit roots existed
+ */
+const fxdb_root_t* fxdb_header_root(const fxdb_header_t* header);
+
+/**
+ * Take total_rows, chunk_count and data_size from the newest intact commit
+ * root. Headers without roots keep their own fields.
+ * Returns the commit sequence, 0 if the header has no root
+ */
+uint16_t fxdb_header_resolve(fxdb_header_t* header);
+
+/**
+ * Record total_rows, chunk_count and data_size as the next commit, in the
+ * root that does not hold the current one
+ */
+void fxdb_header_publish(fxdb_header_t* header);
+
+/**
+ * Whether a file uses the aligned chunk layout: its data section starts on a
+ * FXDB_IO_ALIGNMENT boundary and each chunk's size counts the zero padding
+ * up to the next boundary, so chunk headers stay aligned. Readers that
+ * ignore the layout still walk the chunks correctly.
+ */
+bool fxdb_header_aligned(const fxdb_header_t* header);
+
 /**
  * Serialize row data into buffer
  * Returns bytes written, or -1 on error
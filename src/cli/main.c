@@ -10,12 +10,17 @@
 #include "../../include/shell.h"
 #include "../../include/welcome.h"
 #include "../../include/io_utils.h"
+#include "../../include/compact.h"
+#include "../../include/cursor.h"
+#include "../../include/server.h"
+#include "../../include/stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
 
 // Cross-platform directory scanning
 #ifdef _WIN32
@@ -41,18 +46,22 @@ void print_usage(const char *program_name)
 {
     printf("Usage: %s <command> [options]\n\n", program_name);
     printf("Commands:\n");
-    printf("  create <file.fxdb> --schema \"field1 type1, field2 type2, ...\" [-d directory] [-p path]\n");
-    printf("         Create a new FlexonDB file with specified schema\n\n");
+    printf("  create <file.fxdb> --schema \"field1 type1, field2 type2, ...\" [--aligned] [-d directory] [-p path]\n");
+    printf("         Create a new FlexonDB file with specified schema; --aligned pads chunks for direct I/O\n\n");
     printf("  insert <file.fxdb> --data '{\"field1\": \"value1\", \"field2\": value2}' [-d directory] [-p path]\n");
     printf("         Insert a row into existing database (JSON format)\n\n");
-    printf("  read   <file.fxdb> [--limit N] [-d directory] [-p path]\n");
-    printf("         Read and display rows from database\n\n");
-    printf("  info   <file.fxdb> [-d directory] [-p path]\n");
-    printf("         Show database information and schema\n\n");
-    printf("  dump   <file.fxdb> [--format csv|json|table] [-d directory] [-p path]\n");
-    printf("         Export all data in specified format (default: table)\n\n");
+    printf("  read   <file.fxdb> [--limit N] [--follow] [-d directory] [-p path]\n");
+    printf("         Read and display rows from database; --follow keeps streaming new rows\n\n");
+    printf("  info   <file.fxdb> [--stats] [-d directory] [-p path]\n");
+    printf("         Show database information and schema; --stats scans the file and shows where the time goes\n\n");
+    printf("  dump   <file.fxdb> [--format csv|json|table] [--direct] [-d directory] [-p path]\n");
+    printf("         Export all data in specified format (default: table); --direct bypasses the page cache\n\n");
+    printf("  compact <file.fxdb> [--sort field] [--chunk-size N] [--threads N] [--aligned] [-d directory] [-p path]\n");
+    printf("         Merge small chunks and drop deleted rows, optionally sorting by a field\n\n");
     printf("  list   [-d directory] [-p path]\n");
     printf("         List all .fxdb files in directory\n\n");
+    printf("  serve  --socket <path> [--workers N] [-d directory] [-p path]\n");
+    printf("         Serve the databases in a directory to clients over a Unix socket\n\n");
     printf("Options:\n");
     printf("  -d, --directory <path>  Specify directory for database files\n");
     printf("  -p, --path <path>       Specify path for database files (same as -d)\n");
@@ -67,10 +76,15 @@ void print_usage(const char *program_name)
     printf("  %s create people.fxdb --schema \"name string, age int32\" -d /path/to/db\n", program_name);
     printf("  %s insert people.fxdb --data '{\"name\": \"Alice\", \"age\": 30}' -d /path/to/db\n", program_name);
     printf("  %s read people.fxdb --limit 10\n", program_name);
+    printf("  %s read events.fxdb --follow\n", program_name);
     printf("  %s dump people.fxdb --format csv\n", program_name);
     printf("  %s dump people.fxdb --format json -d /home/user/databases\n", program_name);
+    printf("  %s dump events.fxdb --format csv --direct\n", program_name);
     printf("  %s info people.fxdb -d /home/user/databases\n", program_name);
+    printf("  %s info people.fxdb --stats\n", program_name);
+    printf("  %s compact people.fxdb --sort age\n", program_name);
     printf("  %s list -d /home/user/databases\n", program_name);
+    printf("  %s serve --socket /tmp/flexondb.sock -d /home/user/databases\n", program_name);
     printf("\n");
 }
 
@@ -318,7 +332,7 @@ int cmd_list(const char *directory)
 }
 
 // Create command with directory support and enhanced file handling
-int cmd_create(const char *filename, const char *schema_str, const char *directory)
+int cmd_create(const char *filename, const char *schema_str, bool aligned, const char *directory)
 {
     // Build full file path (includes normalization to .fxdb)
     char *full_path = build_file_path(directory, filename);
@@ -360,7 +374,12 @@ int cmd_create(const char *filename, const char *schema_str, const char *directo
     printf("\n");
 
     // Use enhanced database creation
-    int result = fxdb_database_create(full_path, schema, NULL);
+    fxdb_create_config_t config = {
+        .chunk_size = DEFAULT_CHUNK_SIZE,
+        .enable_checksum = true,
+        .align_chunks = aligned
+    };
+    int result = fxdb_database_create(full_path, schema, &config);
     if (result != 0)
     {
         printf("❌ Failed to create database file\n");
@@ -385,7 +404,7 @@ int cmd_create(const char *filename, const char *schema_str, const char *directo
 }
 
 // Info command with directory support and enhanced error handling
-int cmd_info(const char *filename, const char *directory)
+int cmd_info(const char *filename, bool stats, const char *directory)
 {
     char *full_path = build_file_path(directory, filename);
     if (!full_path)
@@ -425,6 +444,10 @@ int cmd_info(const char *filename, const char *directory)
     printf("  🔧 Chunk size: %u rows\n", reader->header.chunk_size);
     printf("  💾 Schema size: %u bytes\n", reader->header.schema_size);
     printf("  💾 Data size: %u bytes\n", reader->header.data_size);
+    if (fxdb_header_aligned(&reader->header))
+    {
+        printf("  📐 Chunk layout: aligned to %u bytes\n", FXDB_IO_ALIGNMENT);
+    }
 
     // Show file size
     struct stat st;
@@ -438,6 +461,28 @@ int cmd_info(const char *filename, const char *directory)
     printf("Schema:\n");
     print_schema(reader->schema);
 
+    // Read every row back and report the counters of that scan alone
+    if (stats)
+    {
+        fxdb_reset_statistics();
+        uint64_t start = fxdb_stats_clock();
+        uint32_t rows = 0;
+        row_data_t *row;
+        while ((row = reader_read_row_pooled(reader)) != NULL)
+        {
+            reader_release_row(reader, row);
+            rows++;
+        }
+        double elapsed = (fxdb_stats_clock() - start) / 1e6;
+
+        db_statistics_t statistics;
+        fxdb_get_statistics(&statistics);
+        printf("\nScan Statistics (%u rows in %.2f ms):\n", rows, elapsed);
+        fxdb_print_statistics(&statistics);
+        printf("\nScan Latency:\n");
+        fxdb_print_latency();
+    }
+
     reader_close(reader);
     free(full_path);
     return 0;
@@ -462,6 +507,7 @@ int cmd_read(const char *filename, uint32_t limit, const char *directory)
     }
 
     printf("📖 Reading from database: %s\n\n", full_path);
+    reader_set_mmap(reader, true, NULL); // Buffered reads take over if the file cannot be mapped
 
     if (limit == 0)
     {
@@ -485,6 +531,57 @@ int cmd_read(const char *filename, uint32_t limit, const char *directory)
     return 0;
 }
 
+// Free a row from a cursor, strings included
+static void free_cursor_row(const reader_t *reader, row_data_t *row)
+{
+    for (uint32_t i = 0; i < row->field_count; i++)
+    {
+        if (reader->schema->fields[i].type == FIELD_TYPE_STRING)
+        {
+            free((char *)row->values[i].value.string_val);
+        }
+    }
+    reader_free_row(row);
+}
+
+// Read command that keeps streaming rows as they are committed
+int cmd_read_follow(const char *filename, const char *directory)
+{
+    char *full_path = build_file_path(directory, filename);
+    if (!full_path)
+    {
+        printf("❌ Failed to build file path\n");
+        return 1;
+    }
+
+    fxdb_cursor_t *cursor = fxdb_cursor_open(full_path, true);
+    if (!cursor)
+    {
+        printf("❌ Failed to open database: %s\n", full_path);
+        free(full_path);
+        return 1;
+    }
+
+    printf("📖 Following database: %s (Ctrl+C to stop)\n\n", full_path);
+
+    // Only the rows past the cursor are read after each commit
+    int status;
+    do
+    {
+        row_data_t *row;
+        while ((row = fxdb_cursor_next(cursor)) != NULL)
+        {
+            reader_print_row(cursor->reader, row);
+            free_cursor_row(cursor->reader, row);
+        }
+        fflush(stdout);
+    } while ((status = fxdb_cursor_follow(cursor, -1)) > 0);
+
+    fxdb_cursor_close(cursor);
+    free(full_path);
+    return status < 0 ? 1 : 0;
+}
+
 // Insert command implementation
 int cmd_insert(const char *filename, const char *json_data, const char *directory)
 {
@@ -504,8 +601,10 @@ int cmd_insert(const char *filename, const char *json_data, const char *director
         return 1;
     }
 
-    // Open database for appending
-    writer_t *writer = writer_open(full_path);
+    // Open database for appending; the row is logged, not written as its own chunk
+    writer_config_t config = writer_default_config();
+    config.use_wal = true;
+    writer_t *writer = writer_open_with_config(full_path, &config);
     if (!writer)
     {
         printf("❌ Failed to open database for insertion: %s\n", full_path);
@@ -538,7 +637,7 @@ int cmd_insert(const char *filename, const char *json_data, const char *director
 }
 
 // Dump command implementation
-int cmd_dump(const char *filename, const char *format, const char *directory)
+int cmd_dump(const char *filename, const char *format, bool direct, const char *directory)
 {
     char *full_path = build_file_path(directory, filename);
     if (!full_path)
@@ -556,6 +655,14 @@ int cmd_dump(const char *filename, const char *format, const char *directory)
     }
 
     printf("📤 Dumping data from: %s\n", full_path);
+    if (direct && reader_set_direct_io(reader, true) != 0)
+    {
+        printf("💡 Direct I/O is not available here; reading through the page cache\n");
+    }
+    else if (!direct)
+    {
+        reader_set_mmap(reader, true, NULL);
+    }
     
     uint32_t total_rows = reader_get_row_count(reader);
     if (total_rows == 0)
@@ -599,7 +706,11 @@ int cmd_dump(const char *filename, const char *format, const char *directory)
             {
                 const field_value_t *value = &row->values[f];
                 
-                switch (schema->fields[f].type)
+                if (value->is_null)
+                {
+                    // NULL is an empty CSV field
+                }
+                else switch (schema->fields[f].type)
                 {
                     case TYPE_STRING:
                         printf("\"%s\"", value->value.string_val ? value->value.string_val : "");
@@ -638,7 +749,11 @@ int cmd_dump(const char *filename, const char *format, const char *directory)
                 const field_value_t *value = &row->values[f];
                 printf("\"%s\": ", schema->fields[f].name);
                 
-                switch (schema->fields[f].type)
+                if (value->is_null)
+                {
+                    printf("null");
+                }
+                else switch (schema->fields[f].type)
                 {
                     case TYPE_STRING:
                         printf("\"%s\"", value->value.string_val ? value->value.string_val : "");
@@ -678,6 +793,102 @@ int cmd_dump(const char *filename, const char *format, const char *directory)
 }
 
 // Parse command line arguments with directory support
+// Compact command implementation
+int cmd_compact(const char *filename, const char *sort_field, uint32_t chunk_size, uint32_t threads,
+                bool aligned, const char *directory)
+{
+    char *full_path = build_file_path(directory, filename);
+    if (!full_path)
+    {
+        printf("❌ Failed to build file path\n");
+        return 1;
+    }
+
+    compact_options_t options = compact_default_options();
+    options.chunk_size = chunk_size;
+    options.threads = threads;
+    options.align_chunks = aligned;
+
+    if (sort_field)
+    {
+        reader_t *reader = reader_open(full_path);
+        if (!reader)
+        {
+            printf("❌ Failed to open database: %s\n", full_path);
+            free(full_path);
+            return 1;
+        }
+        options.sort_field = get_field_index(reader->schema, sort_field);
+        reader_close(reader);
+
+        if (options.sort_field < 0)
+        {
+            printf("❌ Unknown field: %s\n", sort_field);
+            free(full_path);
+            return 1;
+        }
+    }
+
+    printf("🧹 Compacting database: %s\n", full_path);
+
+    compact_stats_t stats;
+    if (compact_database(full_path, &options, &stats) != 0)
+    {
+        printf("❌ Failed to compact database\n");
+        free(full_path);
+        return 1;
+    }
+
+    printf("✅ Chunks: %u → %u, rows: %u → %u, size: %llu → %llu bytes (%u threads)\n",
+           stats.chunks_before, stats.chunks_after, stats.rows_before, stats.rows_after,
+           (unsigned long long)stats.bytes_before, (unsigned long long)stats.bytes_after, stats.threads);
+    free(full_path);
+    return 0;
+}
+
+// Server stopped by SIGINT/SIGTERM
+static fxdb_server_t *running_server = NULL;
+
+static void stop_server(int signal_number)
+{
+    (void)signal_number;
+    fxdb_server_stop(running_server);
+}
+
+// Serve command implementation
+int cmd_serve(const char *socket_path, uint32_t workers, const char *directory)
+{
+    fxdb_server_config_t config = fxdb_server_default_config();
+    config.socket_path = socket_path;
+    config.directory = directory;
+    config.workers = workers;
+
+    running_server = fxdb_server_create(&config);
+    if (!running_server)
+    {
+        printf("❌ Failed to start server on %s\n", socket_path);
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_server;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("🚀 Serving %s on %s (Ctrl+C to stop)\n", directory ? directory : "the current directory",
+           socket_path);
+    fflush(stdout);
+
+    int status = fxdb_server_run(running_server);
+    fxdb_server_free(running_server);
+    running_server = NULL;
+
+    printf("✅ Server stopped\n");
+    return status == 0 ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
     // Check if no arguments provided - launch interactive shell
@@ -720,38 +931,65 @@ int main(int argc, char *argv[])
     {
         if (argc < 5 || strcmp(argv[3], "--schema") != 0)
         {
-            printf("❌ Usage: %s create <file.fxdb> --schema \"field1 type1, field2 type2\" [-d directory] [-p path]\n", argv[0]);
+            printf("❌ Usage: %s create <file.fxdb> --schema \"field1 type1, field2 type2\" [--aligned] [-d directory] [-p path]\n", argv[0]);
             return 1;
         }
-        return cmd_create(argv[2], argv[4], directory);
+
+        bool aligned = false;
+        for (int i = 5; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--aligned") == 0)
+            {
+                aligned = true;
+            }
+        }
+        return cmd_create(argv[2], argv[4], aligned, directory);
     }
     else if (strcmp(command, "info") == 0)
     {
         if (argc < 3)
         {
-            printf("❌ Usage: %s info <file.fxdb> [-d directory] [-p path]\n", argv[0]);
+            printf("❌ Usage: %s info <file.fxdb> [--stats] [-d directory] [-p path]\n", argv[0]);
             return 1;
         }
-        return cmd_info(argv[2], directory);
+
+        bool stats = false;
+        for (int i = 3; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--stats") == 0)
+            {
+                stats = true;
+            }
+        }
+        return cmd_info(argv[2], stats, directory);
     }
     else if (strcmp(command, "read") == 0)
     {
         if (argc < 3)
         {
-            printf("❌ Usage: %s read <file.fxdb> [--limit N] [-d directory] [-p path]\n", argv[0]);
+            printf("❌ Usage: %s read <file.fxdb> [--limit N] [--follow] [-d directory] [-p path]\n", argv[0]);
             return 1;
         }
 
         uint32_t limit = 0;
+        bool follow = false;
         for (int i = 3; i < argc; i++)
         {
             if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
             {
                 limit = atoi(argv[i + 1]);
-                break;
+                i++;
+            }
+            else if (strcmp(argv[i], "--follow") == 0 || strcmp(argv[i], "-f") == 0)
+            {
+                follow = true;
             }
         }
 
+        if (follow)
+        {
+            return cmd_read_follow(argv[2], directory);
+        }
         return cmd_read(argv[2], limit, directory);
     }
     else if (strcmp(command, "list") == 0)
@@ -776,18 +1014,79 @@ int main(int argc, char *argv[])
             return 1;
         }
         
-        // Check for format option
+        // Check for format and direct I/O options
         const char* format = "table"; // default
+        bool direct = false;
         for (int i = 3; i < argc; i++)
         {
             if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
             {
-                format = argv[i + 1];
-                break;
+                format = argv[++i];
+            }
+            else if (strcmp(argv[i], "--direct") == 0)
+            {
+                direct = true;
             }
         }
         
-        return cmd_dump(argv[2], format, directory);
+        return cmd_dump(argv[2], format, direct, directory);
+    }
+    else if (strcmp(command, "serve") == 0)
+    {
+        const char *socket_path = NULL;
+        uint32_t workers = 0;
+        for (int i = 2; i + 1 < argc; i++)
+        {
+            if (strcmp(argv[i], "--socket") == 0)
+            {
+                socket_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--workers") == 0)
+            {
+                workers = (uint32_t)atoi(argv[++i]);
+            }
+        }
+
+        if (!socket_path)
+        {
+            printf("❌ Usage: %s serve --socket <path> [--workers N] [-d directory] [-p path]\n", argv[0]);
+            return 1;
+        }
+        return cmd_serve(socket_path, workers, directory);
+    }
+    else if (strcmp(command, "compact") == 0)
+    {
+        if (argc < 3)
+        {
+            printf("❌ Usage: %s compact <file.fxdb> [--sort field] [--chunk-size N] [--threads N] [--aligned]\n", argv[0]);
+            return 1;
+        }
+
+        const char *sort_field = NULL;
+        uint32_t chunk_size = 0;
+        uint32_t threads = 0;
+        bool aligned = false;
+        for (int i = 3; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc)
+            {
+                sort_field = argv[++i];
+            }
+            else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc)
+            {
+                chunk_size = (uint32_t)atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                threads = (uint32_t)atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--aligned") == 0)
+            {
+                aligned = true;
+            }
+        }
+
+        return cmd_compact(argv[2], sort_field, chunk_size, threads, aligned, directory);
     }
     else
     {
@@ -1,4 +1,4 @@
-#define _DEFAULT_SOURCE
+#define _GNU_SOURCE
 #include "../../include/io_utils.h"
 #include "../../include/error.h"
 #include <stdlib.h>
@@ -7,7 +7,9 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <errno.h>
+#include <pthread.h>
 
 /* ============================================================================
  * Buffered Writing Implementation
@@ -194,6 +196,64 @@ int fxdb_buffered_writer_close(fxdb_buffered_writer_t* writer) {
  * Create a memory-mapped reader for the specified file
  */
 fxdb_mmap_reader_t* fxdb_mmap_reader_open(const char* filename) {
+    return fxdb_mmap_reader_open_with_options(filename, NULL);
+}
+
+/**
+ * Default mapping options
+ */
+fxdb_mmap_options_t fxdb_mmap_default_options(void) {
+    fxdb_mmap_options_t options = {
+        .access = FXDB_MMAP_ACCESS_DEFAULT,
+        .populate = false,
+        .huge_pages = false
+    };
+    return options;
+}
+
+/**
+ * Map a file read-only, at a huge page boundary when asked to
+ */
+static void* map_file(int fd, size_t size, const fxdb_mmap_options_t* options) {
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options->populate && size <= FXDB_MMAP_POPULATE_MAX) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+#ifdef MADV_HUGEPAGE
+    if (options->huge_pages && size >= FXDB_MMAP_HUGE_PAGE_MIN) {
+        // Reserve room to slide the mapping to a boundary, map the file over
+        // the reservation and give the slack on both sides back
+        size_t span = size + FXDB_HUGE_PAGE_SIZE;
+        uint8_t* reserved = mmap(NULL, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved != MAP_FAILED) {
+            uint8_t* aligned = (uint8_t*)fxdb_align_up((uintptr_t)reserved, FXDB_HUGE_PAGE_SIZE);
+            void* data = mmap(aligned, size, PROT_READ, flags | MAP_FIXED, fd, 0);
+            if (data != MAP_FAILED) {
+                size_t mapped = fxdb_align_up(size, (size_t)sysconf(_SC_PAGESIZE));
+                if (aligned > reserved) {
+                    munmap(reserved, (size_t)(aligned - reserved));
+                }
+                if (reserved + span > aligned + mapped) {
+                    munmap(aligned + mapped, (size_t)(reserved + span - (aligned + mapped)));
+                }
+                madvise(data, size, MADV_HUGEPAGE); // Only a hint; not every file system can use it
+                return data;
+            }
+            munmap(reserved, span);
+        }
+    }
+#endif
+
+    return mmap(NULL, size, PROT_READ, flags, fd, 0);
+}
+
+/**
+ * Create a memory-mapped reader with access hints
+ */
+fxdb_mmap_reader_t* fxdb_mmap_reader_open_with_options(const char* filename, const fxdb_mmap_options_t* options) {
     if (!filename) {
         return NULL;
     }
@@ -223,13 +283,17 @@ fxdb_mmap_reader_t* fxdb_mmap_reader_open(const char* filename) {
     // Only use mmap for files larger than minimum size
     if (reader->file_size >= FXDB_MIN_MMAP_SIZE) {
         // Memory map the file
-        reader->mmap_data = mmap(NULL, reader->file_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+        fxdb_mmap_options_t defaults = fxdb_mmap_default_options();
+        reader->mmap_data = map_file(reader->fd, reader->file_size, options ? options : &defaults);
         if (reader->mmap_data == MAP_FAILED) {
             // Fallback: don't use mmap, keep file descriptor for regular reads
             reader->mmap_data = NULL;
             reader->is_mapped = false;
         } else {
             reader->is_mapped = true;
+            if (options && options->access != FXDB_MMAP_ACCESS_DEFAULT) {
+                fxdb_mmap_advise(reader, options->access);
+            }
         }
     } else {
         reader->mmap_data = NULL;
@@ -239,6 +303,38 @@ fxdb_mmap_reader_t* fxdb_mmap_reader_open(const char* filename) {
     return reader;
 }
 
+/**
+ * Change the access pattern hint of the whole mapping
+ */
+int fxdb_mmap_advise(fxdb_mmap_reader_t* reader, fxdb_mmap_access_t access) {
+    if (!reader || !reader->is_mapped) {
+        return -1;
+    }
+
+    int advice = MADV_NORMAL;
+    if (access == FXDB_MMAP_ACCESS_SEQUENTIAL) {
+        advice = MADV_SEQUENTIAL;
+    } else if (access == FXDB_MMAP_ACCESS_RANDOM) {
+        advice = MADV_RANDOM;
+    }
+    return madvise(reader->mmap_data, reader->file_size, advice) == 0 ? 0 : -1;
+}
+
+/**
+ * Ask the kernel to start reading a range of the mapping
+ */
+int fxdb_mmap_prefetch(fxdb_mmap_reader_t* reader, size_t offset, size_t length) {
+    if (!reader || !reader->is_mapped || offset >= reader->file_size) {
+        return -1;
+    }
+
+    // madvise() takes page-aligned ranges
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page - 1);
+    size_t end = offset + length < reader->file_size ? offset + length : reader->file_size;
+    return madvise((uint8_t*)reader->mmap_data + start, end - start, MADV_WILLNEED) == 0 ? 0 : -1;
+}
+
 /**
  * Read uint32_t value from memory-mapped file
  */
@@ -427,7 +523,20 @@ int fxdb_database_delete(const char* filename) {
         return -1; // File doesn't exist
     }
 
-    return unlink(filename);
+    if (unlink(filename) != 0) {
+        return -1;
+    }
+
+    // Remove the write-ahead log, deletion vector and summary sidecars along with the database
+    const char* sidecars[] = { WAL_EXT, DELETE_EXT, SUMMARY_EXT };
+    for (size_t i = 0; i < sizeof(sidecars) / sizeof(sidecars[0]); i++) {
+        char sidecar[MAX_PATH_LENGTH];
+        snprintf(sidecar, sizeof(sidecar), "%s%s", filename, sidecars[i]);
+        if (unlink(sidecar) != 0 && errno != ENOENT) {
+            return -1;
+        }
+    }
+    return 0;
 }
 
 /* ============================================================================
@@ -436,19 +545,16 @@ int fxdb_database_delete(const char* filename) {
 
 /**
  * Acquire exclusive lock on file
+ * flock() locks belong to the open file, not the process: closing another
+ * descriptor of the same file (a reader) does not drop them, and a second
+ * writer in the same process is refused like one in another process.
  */
 int fxdb_lock_file(int fd) {
     if (fd < 0) {
         return -1;
     }
 
-    struct flock lock;
-    lock.l_type = F_WRLCK;    // Exclusive write lock
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0;           // Lock entire file
-
-    return fcntl(fd, F_SETLK, &lock);
+    return flock(fd, LOCK_EX | LOCK_NB);
 }
 
 /**
@@ -459,11 +565,123 @@ int fxdb_unlock_file(int fd) {
         return -1;
     }
 
-    struct flock lock;
-    lock.l_type = F_UNLCK;    // Unlock
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0;           // Unlock entire file
+    return flock(fd, LOCK_UN);
+}
 
-    return fcntl(fd, F_SETLK, &lock);
-}
\ No newline at end of file
+/**
+ * Force written data to stable storage
+ */
+int fxdb_sync_file(int fd) {
+    if (fd < 0) {
+        return -1;
+    }
+
+#if defined(__APPLE__)
+    // fsync on macOS only reaches the drive cache; F_FULLFSYNC flushes it
+    if (fcntl(fd, F_FULLFSYNC) == 0) {
+        return 0;
+    }
+    return fsync(fd);
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    return fdatasync(fd);
+#else
+    return fsync(fd);
+#endif
+}
+
+/* ============================================================================
+ * Direct I/O Implementation
+ * ============================================================================ */
+
+// Aligned buffer pool, shared by every direct reader
+typedef struct {
+    void* buffer;
+    size_t size;
+} aligned_slot_t;
+
+static pthread_mutex_t aligned_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static aligned_slot_t aligned_pool[FXDB_ALIGNED_POOL_BUFFERS];
+static uint32_t aligned_pool_evict = 0;  // Next slot replaced when the pool is full
+
+/**
+ * Round a size up to a multiple of an alignment
+ */
+size_t fxdb_align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Open a file for reading around the page cache
+ */
+int fxdb_open_direct(const char* filename) {
+    if (!filename) {
+        return -1;
+    }
+
+#if defined(O_DIRECT)
+    return open(filename, O_RDONLY | O_DIRECT);
+#elif defined(F_NOCACHE)
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+/**
+ * Take an aligned buffer from the pool, allocating one if none is large enough
+ */
+void* fxdb_aligned_buffer_acquire(size_t size) {
+    size = fxdb_align_up(size ? size : 1, FXDB_IO_ALIGNMENT);
+
+    // Readers of one file all ask for the same size, so a pooled buffer is
+    // reused only on an exact fit and comes back with the size it went out with
+    void* buffer = NULL;
+    pthread_mutex_lock(&aligned_pool_lock);
+    for (int i = 0; i < FXDB_ALIGNED_POOL_BUFFERS; i++) {
+        if (aligned_pool[i].buffer && aligned_pool[i].size == size) {
+            buffer = aligned_pool[i].buffer;
+            aligned_pool[i].buffer = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&aligned_pool_lock);
+
+    if (!buffer && posix_memalign(&buffer, FXDB_IO_ALIGNMENT, size) != 0) {
+        return NULL;
+    }
+    return buffer;
+}
+
+/**
+ * Return a buffer to the pool; when it is full the buffer replaces one kept
+ * longest, so sizes no reader asks for anymore do not stay forever
+ */
+void fxdb_aligned_buffer_release(void* buffer, size_t size) {
+    if (!buffer) {
+        return;
+    }
+    size = fxdb_align_up(size ? size : 1, FXDB_IO_ALIGNMENT);
+
+    pthread_mutex_lock(&aligned_pool_lock);
+    int slot = -1;
+    for (int i = 0; i < FXDB_ALIGNED_POOL_BUFFERS && slot < 0; i++) {
+        if (!aligned_pool[i].buffer) {
+            slot = i;
+        }
+    }
+    void* evicted = NULL;
+    if (slot < 0) {
+        slot = (int)(aligned_pool_evict++ % FXDB_ALIGNED_POOL_BUFFERS);
+        evicted = aligned_pool[slot].buffer;
+    }
+    aligned_pool[slot].buffer = buffer;
+    aligned_pool[slot].size = size;
+    pthread_mutex_unlock(&aligned_pool_lock);
+    free(evicted);
+}
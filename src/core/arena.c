@@ -0,0 +1,201 @@
+#include "../../include/arena.h"
+#include "../../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SLAB_DEFAULT_OBJECTS 64
+
+// Header sizes rounded so the memory after them stays aligned
+#define ALIGNED_SIZE(type) ((sizeof(type) + FXDB_ARENA_ALIGNMENT - 1) & ~(size_t)(FXDB_ARENA_ALIGNMENT - 1))
+
+static uint8_t* block_data(fxdb_arena_block_t* block) {
+    return (uint8_t*)block + ALIGNED_SIZE(fxdb_arena_block_t);
+}
+
+// Start an arena in caller storage
+void fxdb_arena_init(fxdb_arena_t* arena, void* buffer, size_t size) {
+    memset(arena, 0, sizeof(*arena));
+    
+    // Align the start of the buffer; its usable size shrinks to match
+    uintptr_t start = ((uintptr_t)buffer + FXDB_ARENA_ALIGNMENT - 1) & ~(uintptr_t)(FXDB_ARENA_ALIGNMENT - 1);
+    if (buffer && start - (uintptr_t)buffer < size) {
+        arena->initial = (uint8_t*)start;
+        arena->initial_size = size - (start - (uintptr_t)buffer);
+    }
+    arena->cursor = arena->initial;
+    arena->limit = arena->initial ? arena->initial + arena->initial_size : NULL;
+    arena->next_block = FXDB_ARENA_DEFAULT_BLOCK;
+}
+
+// Allocate an arena and its first block together
+fxdb_arena_t* fxdb_arena_create(size_t block_size) {
+    if (block_size == 0) {
+        block_size = FXDB_ARENA_DEFAULT_BLOCK;
+    }
+    
+    uint8_t* memory = malloc(ALIGNED_SIZE(fxdb_arena_t) + block_size);
+    if (!memory) {
+        return NULL;
+    }
+    fxdb_stats_add(FXDB_STAT_ALLOCATIONS, 1);
+    
+    fxdb_arena_t* arena = (fxdb_arena_t*)memory;
+    fxdb_arena_init(arena, memory + ALIGNED_SIZE(fxdb_arena_t), block_size);
+    arena->next_block = block_size < FXDB_ARENA_MAX_BLOCK ? block_size * 2 : FXDB_ARENA_MAX_BLOCK;
+    arena->owned = true;
+    return arena;
+}
+
+// Allocate from a new block, at least twice the size of the last one
+void* fxdb_arena_grow(fxdb_arena_t* arena, size_t size) {
+    size_t block_size = arena->next_block > size ? arena->next_block : size;
+    fxdb_arena_block_t* block = malloc(ALIGNED_SIZE(fxdb_arena_block_t) + block_size);
+    if (!block) {
+        return NULL;
+    }
+    fxdb_stats_add(FXDB_STAT_ALLOCATIONS, 1);
+    
+    block->size = block_size;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    if (arena->next_block < FXDB_ARENA_MAX_BLOCK) {
+        arena->next_block *= 2;
+    }
+    
+    arena->cursor = block_data(block) + size;
+    arena->limit = block_data(block) + block_size;
+    return block_data(block);
+}
+
+// Allocate zeroed memory
+void* fxdb_arena_calloc(fxdb_arena_t* arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void* memory = fxdb_arena_alloc(arena, count * size);
+    if (memory) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+// Copy a string into the arena
+char* fxdb_arena_strdup(fxdb_arena_t* arena, const char* text) {
+    return text ? fxdb_arena_strndup(arena, text, strlen(text)) : NULL;
+}
+
+// Copy at most length bytes of a string into the arena
+char* fxdb_arena_strndup(fxdb_arena_t* arena, const char* text, size_t length) {
+    if (!text) {
+        return NULL;
+    }
+    const char* end = memchr(text, '\0', length);
+    if (end) {
+        length = (size_t)(end - text);
+    }
+    
+    char* copy = fxdb_arena_alloc(arena, length + 1);
+    if (copy) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+// Free the blocks added after `keep` (NULL frees them all)
+static void free_blocks_after(fxdb_arena_t* arena, fxdb_arena_block_t* keep) {
+    while (arena->blocks && arena->blocks != keep) {
+        fxdb_arena_block_t* next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+}
+
+// Take back everything allocated since a mark
+void fxdb_arena_rewind(fxdb_arena_t* arena, fxdb_arena_mark_t mark) {
+    free_blocks_after(arena, mark.blocks);
+    arena->cursor = mark.cursor;
+    arena->limit = mark.limit;
+}
+
+// Take back everything, keeping the first block
+void fxdb_arena_reset(fxdb_arena_t* arena) {
+    if (arena->initial) {
+        free_blocks_after(arena, NULL);
+        arena->cursor = arena->initial;
+        arena->limit = arena->initial + arena->initial_size;
+        return;
+    }
+    
+    // Keep the oldest block, the last in the list
+    fxdb_arena_block_t* oldest = arena->blocks;
+    while (oldest && oldest->next) {
+        oldest = oldest->next;
+    }
+    free_blocks_after(arena, oldest);
+    arena->cursor = oldest ? block_data(oldest) : NULL;
+    arena->limit = oldest ? block_data(oldest) + oldest->size : NULL;
+}
+
+// Free the blocks of an arena in caller storage
+void fxdb_arena_release(fxdb_arena_t* arena) {
+    if (arena) {
+        free_blocks_after(arena, NULL);
+        arena->cursor = arena->initial;
+        arena->limit = arena->initial ? arena->initial + arena->initial_size : NULL;
+    }
+}
+
+// Free an arena from fxdb_arena_create
+void fxdb_arena_destroy(fxdb_arena_t* arena) {
+    if (arena) {
+        free_blocks_after(arena, NULL);
+        if (arena->owned) {
+            free(arena);
+        }
+    }
+}
+
+// Start a pool of objects of one size
+void fxdb_slab_pool_init(fxdb_slab_pool_t* pool, size_t object_size, uint32_t objects_per_slab) {
+    memset(pool, 0, sizeof(*pool));
+    if (object_size < sizeof(void*)) {
+        object_size = sizeof(void*);
+    }
+    pool->object_size = (object_size + FXDB_ARENA_ALIGNMENT - 1) & ~(size_t)(FXDB_ARENA_ALIGNMENT - 1);
+    pool->objects_per_slab = objects_per_slab ? objects_per_slab : SLAB_DEFAULT_OBJECTS;
+}
+
+// Allocate a slab, put all but one of its objects on the free list and return that one
+void* fxdb_slab_grow(fxdb_slab_pool_t* pool) {
+    fxdb_slab_t* slab = malloc(ALIGNED_SIZE(fxdb_slab_t) + pool->object_size * pool->objects_per_slab);
+    if (!slab) {
+        return NULL;
+    }
+    fxdb_stats_add(FXDB_STAT_ALLOCATIONS, 1);
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    
+    uint8_t* objects = (uint8_t*)slab + ALIGNED_SIZE(fxdb_slab_t);
+    for (uint32_t i = pool->objects_per_slab - 1; i > 0; i--) {
+        void* object = objects + (size_t)i * pool->object_size;
+        *(void**)object = pool->free_list;
+        pool->free_list = object;
+    }
+    pool->in_use++;
+    return objects;
+}
+
+// Free every slab
+void fxdb_slab_pool_destroy(fxdb_slab_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+    while (pool->slabs) {
+        fxdb_slab_t* next = pool->slabs->next;
+        free(pool->slabs);
+        pool->slabs = next;
+    }
+    pool->free_list = NULL;
+    pool->in_use = 0;
+}
@@ -0,0 +1,305 @@
+#include "../../include/chunk_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define CACHE_INITIAL_BUCKETS 256
+
+// Process-wide cache state, guarded by cache_lock
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static fxdb_cached_chunk_t** buckets = NULL;
+static size_t bucket_count = 0;
+static size_t entry_count = 0;
+static fxdb_cached_chunk_t* clock_hand = NULL;  // Circular list, hand = oldest
+static size_t budget = FXDB_CHUNK_CACHE_BYTES;
+static size_t memory_usage = 0;
+static size_t peak_memory_usage = 0;
+static uint64_t cache_hits = 0;
+static uint64_t cache_misses = 0;
+
+// Identify an open file for use in cache keys
+uint64_t fxdb_chunk_cache_file_id(FILE* file) {
+    struct stat st;
+    if (!file || fstat(fileno(file), &st) != 0) {
+        return 0;
+    }
+    
+    // Mix device into inode; 0 stays reserved for "unknown"
+    uint64_t id = ((uint64_t)st.st_dev << 40) ^ (uint64_t)st.st_ino;
+    return id ? id : 1;
+}
+
+static size_t hash_key(const fxdb_chunk_key_t* key) {
+    uint64_t h = key->file_id * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)key->generation << 32 | key->chunk_index) * 0xC2B2AE3D27D4EB4FULL;
+    return (size_t)(h ^ (h >> 29));
+}
+
+static bool key_equal(const fxdb_chunk_key_t* a, const fxdb_chunk_key_t* b) {
+    return a->file_id == b->file_id && a->chunk_index == b->chunk_index &&
+           a->generation == b->generation;
+}
+
+static size_t entry_bytes(const fxdb_cached_chunk_t* chunk) {
+    return sizeof(fxdb_cached_chunk_t) + chunk->size;
+}
+
+// Double the bucket array once the table is fuller than one entry per bucket
+static int grow_buckets(void) {
+    size_t new_count = bucket_count ? bucket_count * 2 : CACHE_INITIAL_BUCKETS;
+    fxdb_cached_chunk_t** new_buckets = calloc(new_count, sizeof(fxdb_cached_chunk_t*));
+    if (!new_buckets) {
+        return -1;
+    }
+    
+    for (size_t b = 0; b < bucket_count; b++) {
+        fxdb_cached_chunk_t* chunk = buckets[b];
+        while (chunk) {
+            fxdb_cached_chunk_t* next = chunk->hash_next;
+            size_t slot = hash_key(&chunk->key) & (new_count - 1);
+            chunk->hash_next = new_buckets[slot];
+            new_buckets[slot] = chunk;
+            chunk = next;
+        }
+    }
+    
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+    return 0;
+}
+
+static fxdb_cached_chunk_t* find_entry(const fxdb_chunk_key_t* key) {
+    if (bucket_count == 0) {
+        return NULL;
+    }
+    
+    fxdb_cached_chunk_t* chunk = buckets[hash_key(key) & (bucket_count - 1)];
+    while (chunk && !key_equal(&chunk->key, key)) {
+        chunk = chunk->hash_next;
+    }
+    return chunk;
+}
+
+// Unlink an unpinned entry from the hash table and the clock, then free it
+static void remove_entry(fxdb_cached_chunk_t* chunk) {
+    fxdb_cached_chunk_t** link = &buckets[hash_key(&chunk->key) & (bucket_count - 1)];
+    while (*link != chunk) {
+        link = &(*link)->hash_next;
+    }
+    *link = chunk->hash_next;
+
+    if (chunk->clock_next == chunk) {
+        clock_hand = NULL;
+    } else {
+        chunk->clock_prev->clock_next = chunk->clock_next;
+        chunk->clock_next->clock_prev = chunk->clock_prev;
+        if (clock_hand == chunk) {
+            clock_hand = chunk->clock_next;
+        }
+    }
+    
+    entry_count--;
+    memory_usage -= entry_bytes(chunk);
+    free(chunk->data);
+    free(chunk);
+}
+
+// Run the clock until `needed` more bytes fit in the budget
+// Referenced entries get a second chance; pinned entries are never evicted
+static bool make_room(size_t needed) {
+    if (needed > budget) {
+        return false;
+    }
+    
+    // Two full sweeps clear every reference bit, so stop after that
+    size_t steps = 2 * entry_count + 1;
+    while (memory_usage + needed > budget && clock_hand && steps-- > 0) {
+        fxdb_cached_chunk_t* chunk = clock_hand;
+        if (chunk->pin_count > 0) {
+            clock_hand = chunk->clock_next;
+        } else if (chunk->referenced) {
+            chunk->referenced = false;
+            clock_hand = chunk->clock_next;
+        } else {
+            remove_entry(chunk);
+        }
+    }
+    
+    return memory_usage + needed <= budget;
+}
+
+// Look up a chunk and pin it on a hit
+fxdb_cached_chunk_t* fxdb_chunk_cache_lookup(const fxdb_chunk_key_t* key) {
+    if (!key || key->file_id == 0) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&cache_lock);
+    fxdb_cached_chunk_t* chunk = find_entry(key);
+    if (chunk) {
+        chunk->pin_count++;
+        chunk->referenced = true;
+        cache_hits++;
+    } else {
+        cache_misses++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    
+    return chunk;
+}
+
+// Check whether a chunk is cached, without pinning or counting
+bool fxdb_chunk_cache_contains(const fxdb_chunk_key_t* key, uint32_t* size, long* file_offset) {
+    if (!key || key->file_id == 0) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&cache_lock);
+    fxdb_cached_chunk_t* chunk = find_entry(key);
+    if (chunk) {
+        if (size) {
+            *size = chunk->size;
+        }
+        if (file_offset) {
+            *file_offset = chunk->file_offset;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return chunk != NULL;
+}
+
+// Copy a chunk payload into the cache and return it pinned
+fxdb_cached_chunk_t* fxdb_chunk_cache_insert(const fxdb_chunk_key_t* key, const uint8_t* data,
+                                             uint32_t size, uint32_t row_count, long file_offset) {
+    if (!key || key->file_id == 0 || (!data && size > 0)) {
+        return NULL;
+    }
+    
+    // Copy outside the lock; most inserts succeed
+    fxdb_cached_chunk_t* chunk = calloc(1, sizeof(fxdb_cached_chunk_t));
+    uint8_t* copy = malloc(size ? size : 1);
+    if (!chunk || !copy) {
+        free(chunk);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, data, size);
+    
+    chunk->key = *key;
+    chunk->data = copy;
+    chunk->size = size;
+    chunk->row_count = row_count;
+    chunk->file_offset = file_offset;
+    chunk->pin_count = 1;
+    
+    pthread_mutex_lock(&cache_lock);
+    
+    // Another reader may have loaded the same chunk meanwhile
+    fxdb_cached_chunk_t* existing = find_entry(key);
+    if (existing) {
+        existing->pin_count++;
+        existing->referenced = true;
+        pthread_mutex_unlock(&cache_lock);
+        free(copy);
+        free(chunk);
+        return existing;
+    }
+    
+    if (!make_room(entry_bytes(chunk)) ||
+        (entry_count >= bucket_count && grow_buckets() != 0)) {
+        pthread_mutex_unlock(&cache_lock);
+        free(copy);
+        free(chunk);
+        return NULL;
+    }
+    
+    size_t slot = hash_key(key) & (bucket_count - 1);
+    chunk->hash_next = buckets[slot];
+    buckets[slot] = chunk;
+    
+    // New entries go just behind the hand so they are examined last
+    if (clock_hand) {
+        chunk->clock_next = clock_hand;
+        chunk->clock_prev = clock_hand->clock_prev;
+        clock_hand->clock_prev->clock_next = chunk;
+        clock_hand->clock_prev = chunk;
+    } else {
+        chunk->clock_next = chunk;
+        chunk->clock_prev = chunk;
+        clock_hand = chunk;
+    }
+    
+    entry_count++;
+    memory_usage += entry_bytes(chunk);
+    if (memory_usage > peak_memory_usage) {
+        peak_memory_usage = memory_usage;
+    }
+    
+    pthread_mutex_unlock(&cache_lock);
+    return chunk;
+}
+
+// Unpin a chunk returned by lookup or insert
+void fxdb_chunk_cache_release(fxdb_cached_chunk_t* chunk) {
+    if (!chunk) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache_lock);
+    if (chunk->pin_count > 0) {
+        chunk->pin_count--;
+    }
+    
+    // Entries pinned while the budget shrank are evicted once released
+    if (memory_usage > budget) {
+        make_room(0);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// Set the memory budget in bytes (0 disables caching)
+void fxdb_chunk_cache_set_budget(size_t bytes) {
+    pthread_mutex_lock(&cache_lock);
+    budget = bytes;
+    make_room(0);
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// Get the memory budget in bytes
+size_t fxdb_chunk_cache_get_budget(void) {
+    pthread_mutex_lock(&cache_lock);
+    size_t bytes = budget;
+    pthread_mutex_unlock(&cache_lock);
+    return bytes;
+}
+
+// Drop every unpinned entry
+void fxdb_chunk_cache_purge(void) {
+    pthread_mutex_lock(&cache_lock);
+    size_t remaining = entry_count;
+    while (clock_hand && remaining-- > 0) {
+        fxdb_cached_chunk_t* chunk = clock_hand;
+        if (chunk->pin_count > 0) {
+            clock_hand = chunk->clock_next;
+        } else {
+            remove_entry(chunk);
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// Fill cache_hits, cache_misses, memory_usage and peak_memory_usage
+void fxdb_chunk_cache_get_statistics(db_statistics_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache_lock);
+    stats->cache_hits = cache_hits;
+    stats->cache_misses = cache_misses;
+    stats->memory_usage = memory_usage;
+    stats->peak_memory_usage = peak_memory_usage;
+    pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,662 @@
+#include "../../include/compact.h"
+#include "../../include/reader.h"
+#include "../../include/wal.h"
+#include "../../include/deletes.h"
+#include "../../include/summary.h"
+#include "../../include/coord.h"
+#include "../../include/bitmap.h"
+#include "../../include/config.h"
+#include "../../include/io_utils.h"
+#include "../../include/stats.h"
+#include "../../include/sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define COMPACT_MAX_THREADS 16
+
+// Create default compaction options
+compact_options_t compact_default_options(void) {
+    compact_options_t options = {
+        .chunk_size = 0,
+        .sort_field = -1,
+        .sort_memory = 0,
+        .threads = 0,
+        .durability = FXDB_DURABILITY_FSYNC,
+        .align_chunks = false,
+        .chunk_summaries = true
+    };
+    return options;
+}
+
+// Where a source chunk's rows are and where its live rows go
+typedef struct {
+    long offset;                // Payload offset in the old file (-1 for the log rows)
+    uint32_t rows;              // Rows stored in the chunk
+    uint32_t first_live;        // Index of its first live row among all live rows
+} source_chunk_t;
+
+// State shared by the worker threads
+typedef struct {
+    const reader_t* reader;     // Snapshot being compacted
+    int old_fd;
+    int new_fd;
+    uint32_t row_size;
+    uint32_t null_columns;
+    
+    source_chunk_t* sources;
+    uint32_t source_count;
+    
+    uint32_t live_rows;
+    
+    uint32_t chunk_size;        // Rows per output chunk
+    uint32_t chunk_count;       // Output chunks
+    long data_offset;
+    bool align;                 // Output chunks padded to FXDB_IO_ALIGNMENT
+    size_t full_chunk_bytes;    // Bytes of a full output chunk, header and padding included
+    
+    uint8_t** summaries;        // Summary per output chunk (NULL when off; entries NULL where it failed)
+    size_t* summary_sizes;
+} compact_job_t;
+
+// Walks the live rows of the source chunks in scan order, one chunk in memory at a time
+typedef struct {
+    const compact_job_t* job;
+    uint32_t source;            // Source chunk loaded (source_count before the first load)
+    uint32_t row;               // Next row of it to look at
+    const uint8_t* payload;     // Rows and validity bitmaps of the loaded chunk
+    uint8_t* buffer;            // Payload read from the old file
+    uint64_t* validity;         // Validity bitmaps of the loaded chunk
+} live_cursor_t;
+
+// One worker's share of the job
+typedef struct {
+    compact_job_t* job;
+    uint32_t first;             // First unit (source or output chunk)
+    uint32_t last;              // One past the last unit
+    int result;
+} compact_task_t;
+
+// Bytes of a chunk's payload: rows plus one validity bitmap per nullable column
+static size_t payload_bytes(const compact_job_t* job, uint32_t rows) {
+    return (size_t)rows * job->row_size + (size_t)job->null_columns * fxdb_bitmap_words(rows) * sizeof(uint64_t);
+}
+
+// Bytes of an output chunk in the file: header, payload and alignment padding
+static size_t chunk_bytes(const compact_job_t* job, uint32_t rows) {
+    size_t bytes = 2 * sizeof(uint32_t) + payload_bytes(job, rows);
+    return job->align ? fxdb_align_up(bytes, FXDB_IO_ALIGNMENT) : bytes;
+}
+
+// Read all of a buffer at an offset, retrying short reads
+static int read_fully(int fd, void* buffer, size_t size, long offset) {
+    uint8_t* out = buffer;
+    while (size > 0) {
+        uint64_t start = fxdb_stats_clock();
+        ssize_t n = pread(fd, out, size, offset);
+        fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - start);
+        fxdb_stats_add(FXDB_STAT_READ_CALLS, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        fxdb_stats_add(FXDB_STAT_BYTES_READ, (uint64_t)n);
+        out += n;
+        size -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+// Write all of a buffer at an offset, retrying short writes
+static int write_fully(int fd, const void* buffer, size_t size, long offset) {
+    const uint8_t* in = buffer;
+    while (size > 0) {
+        uint64_t start = fxdb_stats_clock();
+        ssize_t n = pwrite(fd, in, size, offset);
+        fxdb_stats_add(FXDB_STAT_WRITE_NS, fxdb_stats_clock() - start);
+        fxdb_stats_add(FXDB_STAT_WRITE_OPS, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        fxdb_stats_add(FXDB_STAT_BYTES_WRITTEN, (uint64_t)n);
+        in += n;
+        size -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+// Walk the chunk headers once, instead of once per chunk like a reader does
+static int build_directory(compact_job_t* job) {
+    const reader_t* reader = job->reader;
+    uint32_t chunk_count = reader->header.chunk_count;
+    job->source_count = chunk_count + (reader->wal_rows > 0 ? 1 : 0);
+    job->sources = calloc(job->source_count ? job->source_count : 1, sizeof(source_chunk_t));
+    if (!job->sources) {
+        return -1;
+    }
+    
+    long position = reader->header.data_offset;
+    uint32_t live = 0;
+    for (uint32_t c = 0; c < job->source_count; c++) {
+        source_chunk_t* source = &job->sources[c];
+        if (c == chunk_count) {
+            source->offset = -1;
+            source->rows = reader->wal_rows;
+        } else {
+            uint32_t chunk_header[2];
+            // Chunks of the aligned layout carry up to a block of padding
+            if (read_fully(job->old_fd, chunk_header, sizeof(chunk_header), position) != 0 ||
+                chunk_header[0] > reader->header.chunk_size ||
+                chunk_header[1] < payload_bytes(job, chunk_header[0]) ||
+                chunk_header[1] - payload_bytes(job, chunk_header[0]) >= FXDB_IO_ALIGNMENT) {
+                fprintf(stderr, "Error: Chunk %u of the database is damaged\n", c);
+                return -1;
+            }
+            source->offset = position + (long)sizeof(chunk_header);
+            source->rows = chunk_header[0];
+            position = source->offset + (long)chunk_header[1];
+        }
+        
+        // Live rows are known from the deletion vectors alone
+        const uint64_t* deleted = deletes_chunk(reader->deletes, c);
+        source->first_live = live;
+        live += source->rows - (deleted ? (uint32_t)fxdb_bitmap_count(deleted, source->rows) : 0);
+    }
+    
+    job->live_rows = live;
+    return 0;
+}
+
+// Set up a cursor over the live rows; nothing is loaded until it seeks
+static int cursor_init(live_cursor_t* cursor, const compact_job_t* job) {
+    uint32_t max_rows = job->reader->header.chunk_size;
+    cursor->job = job;
+    cursor->source = job->source_count;
+    cursor->row = 0;
+    cursor->payload = NULL;
+    cursor->buffer = malloc(payload_bytes(job, max_rows) + 1);
+    cursor->validity = calloc((size_t)job->null_columns * fxdb_bitmap_words(max_rows) + 1, sizeof(uint64_t));
+    return (cursor->buffer && cursor->validity) ? 0 : -1;
+}
+
+static void cursor_free(live_cursor_t* cursor) {
+    free(cursor->buffer);
+    free(cursor->validity);
+}
+
+// Load a source chunk, its rows from the old file or the log
+static int cursor_load(live_cursor_t* cursor, uint32_t c) {
+    const compact_job_t* job = cursor->job;
+    const source_chunk_t* source = &job->sources[c];
+    cursor->payload = job->reader->wal_chunk;
+    if (source->offset >= 0) {
+        if (read_fully(job->old_fd, cursor->buffer, payload_bytes(job, source->rows), source->offset) != 0) {
+            return -1;
+        }
+        cursor->payload = cursor->buffer;
+    }
+    
+    // Bitmaps follow the rows unaligned
+    memcpy(cursor->validity, cursor->payload + (size_t)source->rows * job->row_size,
+           (size_t)job->null_columns * fxdb_bitmap_words(source->rows) * sizeof(uint64_t));
+    cursor->source = c;
+    cursor->row = 0;
+    return 0;
+}
+
+// Copy the next live row and its present mask; returns -1 past the last one or on a read error
+static int cursor_next(live_cursor_t* cursor, uint8_t* row, uint64_t* present) {
+    const compact_job_t* job = cursor->job;
+    for (;;) {
+        if (cursor->source >= job->source_count) {
+            return -1;
+        }
+        
+        const source_chunk_t* source = &job->sources[cursor->source];
+        if (cursor->row >= source->rows) {
+            if (cursor->source + 1 >= job->source_count || cursor_load(cursor, cursor->source + 1) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        
+        uint32_t r = cursor->row++;
+        const uint64_t* deleted = deletes_chunk(job->reader->deletes, cursor->source);
+        if (deleted && fxdb_bitmap_get(deleted, r)) {
+            continue;
+        }
+        
+        memcpy(row, cursor->payload + (size_t)r * job->row_size, job->row_size);
+        uint32_t words = fxdb_bitmap_words(source->rows);
+        uint64_t nullable = job->reader->header.null_mask;
+        *present = 0;
+        for (uint32_t ordinal = 0; nullable; ordinal++) {
+            uint32_t field = (uint32_t)__builtin_ctzll(nullable);
+            if (fxdb_bitmap_get(cursor->validity + (size_t)ordinal * words, r)) {
+                *present |= 1ULL << field;
+            }
+            nullable &= nullable - 1;
+        }
+        return 0;
+    }
+}
+
+// Position the cursor so the next row it returns is live row `index`
+static int cursor_seek(live_cursor_t* cursor, uint32_t index) {
+    const compact_job_t* job = cursor->job;
+    uint32_t c = 0;
+    while (c + 1 < job->source_count && job->sources[c + 1].first_live <= index) {
+        c++;
+    }
+    if (c >= job->source_count || cursor_load(cursor, c) != 0) {
+        return -1;
+    }
+    
+    // Step over the live rows before it; deleted rows are skipped on the way
+    uint64_t present;
+    uint8_t* skipped = malloc(job->row_size);
+    int result = skipped ? 0 : -1;
+    for (uint32_t i = job->sources[c].first_live; i < index && result == 0; i++) {
+        result = cursor_next(cursor, skipped, &present);
+    }
+    free(skipped);
+    return result;
+}
+
+// Finish output chunk k, whose rows are already in place after its header, and write it
+static int write_chunk(compact_job_t* job, uint32_t k, uint8_t* chunk, uint32_t rows,
+                       const uint64_t* present, uint64_t* validity) {
+    uint64_t null_mask = job->reader->header.null_mask;
+    uint32_t words = fxdb_bitmap_words(rows);
+    size_t row_bytes = (size_t)rows * job->row_size;
+    size_t bytes = payload_bytes(job, rows);
+    size_t padded = chunk_bytes(job, rows) - sizeof(uint32_t) * 2;
+    
+    uint32_t chunk_header[2] = { rows, (uint32_t)padded };
+    memcpy(chunk, chunk_header, sizeof(chunk_header));
+    uint8_t* out = chunk + sizeof(chunk_header);
+    memset(validity, 0, (size_t)job->null_columns * words * sizeof(uint64_t));
+    
+    for (uint32_t i = 0; i < rows; i++) {
+        uint64_t nullable = null_mask;
+        for (uint32_t ordinal = 0; nullable; ordinal++) {
+            uint32_t field = (uint32_t)__builtin_ctzll(nullable);
+            if ((present[i] >> field) & 1) {
+                fxdb_bitmap_set(validity + (size_t)ordinal * words, i);
+            }
+            nullable &= nullable - 1;
+        }
+    }
+    memcpy(out + row_bytes, validity, (size_t)job->null_columns * words * sizeof(uint64_t));
+    memset(out + bytes, 0, padded - bytes);
+    if (job->summaries) {
+        job->summaries[k] = summary_encode_chunk(job->reader->schema, null_mask, out, rows, validity, words,
+                                                 &job->summary_sizes[k]);
+    }
+    
+    // Every chunk before this one is full, so its offset is known up front
+    long offset = job->data_offset + (long)k * (long)job->full_chunk_bytes;
+    return write_fully(job->new_fd, chunk, sizeof(chunk_header) + padded, offset);
+}
+
+// Rows of output chunk k
+static uint32_t output_rows(const compact_job_t* job, uint32_t k) {
+    uint32_t first = k * job->chunk_size;
+    return job->live_rows - first < job->chunk_size ? job->live_rows - first : job->chunk_size;
+}
+
+// Build a range of output chunks in scan order, streaming the live rows from the old file
+static void* emit_main(void* arg) {
+    compact_task_t* task = arg;
+    compact_job_t* job = task->job;
+    
+    live_cursor_t cursor;
+    uint8_t* chunk = malloc(job->full_chunk_bytes);
+    uint64_t* present = malloc((size_t)job->chunk_size * sizeof(uint64_t));
+    uint64_t* validity = malloc(((size_t)job->null_columns * fxdb_bitmap_words(job->chunk_size) + 1) * sizeof(uint64_t));
+    if (cursor_init(&cursor, job) != 0 || !chunk || !present || !validity ||
+        cursor_seek(&cursor, task->first * job->chunk_size) != 0) {
+        task->result = -1;
+    }
+    
+    uint8_t* rows = chunk ? chunk + 2 * sizeof(uint32_t) : NULL;
+    for (uint32_t k = task->first; k < task->last && task->result == 0; k++) {
+        uint32_t count = output_rows(job, k);
+        for (uint32_t i = 0; i < count && task->result == 0; i++) {
+            task->result = cursor_next(&cursor, rows + (size_t)i * job->row_size, &present[i]);
+        }
+        if (task->result == 0) {
+            task->result = write_chunk(job, k, chunk, count, present, validity);
+        }
+    }
+    
+    cursor_free(&cursor);
+    free(chunk);
+    free(present);
+    free(validity);
+    return NULL;
+}
+
+// Split units evenly over the threads and run them; returns 0 if every task succeeded
+static int run_parallel(compact_job_t* job, uint32_t threads, uint32_t units, void* (*worker)(void*)) {
+    if (units == 0) {
+        return 0;
+    }
+    if (threads > units) {
+        threads = units;
+    }
+    
+    compact_task_t tasks[COMPACT_MAX_THREADS];
+    pthread_t handles[COMPACT_MAX_THREADS];
+    bool started[COMPACT_MAX_THREADS] = { false };
+    for (uint32_t t = 0; t < threads; t++) {
+        tasks[t].job = job;
+        tasks[t].first = (uint32_t)((uint64_t)units * t / threads);
+        tasks[t].last = (uint32_t)((uint64_t)units * (t + 1) / threads);
+        tasks[t].result = 0;
+    }
+    
+    // The calling thread takes the first share itself
+    for (uint32_t t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, worker, &tasks[t]) == 0;
+        if (!started[t]) {
+            tasks[t].result = -1;
+        }
+    }
+    worker(&tasks[0]);
+    
+    int result = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        }
+        if (tasks[t].result != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+// Feed the live rows to the external sorter, then build the output chunks in its order
+// The sorter spills runs next to the database once its memory budget is reached
+static int emit_sorted(compact_job_t* job, const compact_options_t* settings, uint32_t threads,
+                       const char* filename, uint32_t* runs) {
+    uint64_t null_mask = job->reader->header.null_mask;
+    fxdb_sort_options_t options = fxdb_sort_default_options((uint32_t)settings->sort_field);
+    options.memory_limit = settings->sort_memory;
+    options.threads = threads;
+    options.temp_prefix = filename;
+    
+    live_cursor_t cursor;
+    fxdb_sorter_t* sorter = fxdb_sorter_create(job->reader->schema, &options);
+    uint8_t* chunk = malloc(job->full_chunk_bytes);
+    uint64_t* present = malloc((size_t)job->chunk_size * sizeof(uint64_t));
+    uint64_t* validity = malloc(((size_t)job->null_columns * fxdb_bitmap_words(job->chunk_size) + 1) * sizeof(uint64_t));
+    int result = (cursor_init(&cursor, job) == 0 && sorter && chunk && present && validity) ? 0 : -1;
+    if (result == 0 && job->live_rows > 0) {
+        result = cursor_seek(&cursor, 0);
+    }
+    
+    uint8_t* rows = chunk ? chunk + 2 * sizeof(uint32_t) : NULL;
+    for (uint32_t i = 0; i < job->live_rows && result == 0; i++) {
+        result = cursor_next(&cursor, rows, &present[0]);
+        if (result == 0) {
+            result = fxdb_sorter_add(sorter, rows, null_mask & ~present[0]);
+        }
+    }
+    if (result == 0) {
+        result = fxdb_sorter_finish(sorter);
+    }
+    
+    for (uint32_t k = 0; k < job->chunk_count && result == 0; k++) {
+        uint32_t count = output_rows(job, k);
+        for (uint32_t i = 0; i < count && result == 0; i++) {
+            const uint8_t* row;
+            uint64_t null_fields;
+            if (fxdb_sorter_next(sorter, &row, &null_fields) != 1) {
+                result = -1;
+                break;
+            }
+            memcpy(rows + (size_t)i * job->row_size, row, job->row_size);
+            present[i] = ~null_fields;
+        }
+        if (result == 0) {
+            result = write_chunk(job, k, chunk, count, present, validity);
+        }
+    }
+    
+    if (sorter) {
+        fxdb_sort_stats_t sort_stats;
+        fxdb_sorter_stats(sorter, &sort_stats);
+        *runs = sort_stats.runs;
+    }
+    cursor_free(&cursor);
+    fxdb_sorter_free(sorter);
+    free(chunk);
+    free(present);
+    free(validity);
+    return result;
+}
+
+// Size of a file, 0 if it does not exist
+static uint64_t file_size(const char* path) {
+    struct stat st;
+    return (path && stat(path, &st) == 0) ? (uint64_t)st.st_size : 0;
+}
+
+// Size of a database file and its sidecars
+static uint64_t database_size(const char* filename) {
+    char* log = wal_path(filename);
+    char* deletes = deletes_path(filename);
+    char* summaries = summary_path(filename);
+    uint64_t size = file_size(filename) + file_size(log) + file_size(deletes) + file_size(summaries);
+    free(log);
+    free(deletes);
+    free(summaries);
+    return size;
+}
+
+// Replace the summaries of the old generation with those of the new chunks
+// Chunks left without a summary are read by approximate queries instead
+static void write_summaries(const compact_job_t* job, const char* filename, const fxdb_header_t* header) {
+    summary_remove(filename);
+    if (!job->summaries) {
+        return;
+    }
+    
+    fxdb_summary_writer_t* writer = summary_writer_open(filename, header, job->reader->schema);
+    for (uint32_t k = 0; writer && k < job->chunk_count; k++) {
+        if (job->summaries[k] &&
+            summary_writer_append(writer, k, job->summaries[k], job->summary_sizes[k]) != 0) {
+            break;
+        }
+    }
+    summary_writer_close(writer);
+}
+
+// Write the header and schema section of the new file
+static int write_file_head(compact_job_t* job, fxdb_header_t* header) {
+    const fxdb_header_t* old = &job->reader->header;
+    uint8_t* schema_section = malloc(old->schema_size ? old->schema_size : 1);
+    if (!schema_section) {
+        return -1;
+    }
+    
+    int result = read_fully(job->old_fd, schema_section, old->schema_size, old->schema_offset);
+    if (result == 0) {
+        result = write_fully(job->new_fd, schema_section, old->schema_size, old->schema_offset);
+    }
+    free(schema_section);
+    
+    if (result == 0) {
+        result = write_fully(job->new_fd, header, sizeof(*header), 0);
+    }
+    return result;
+}
+
+// Compact a database file
+int compact_database(const char* filename, const compact_options_t* options, compact_stats_t* stats) {
+    if (!filename) {
+        return -1;
+    }
+    
+    compact_options_t settings = options ? *options : compact_default_options();
+    
+    // Holding the writer lock keeps appends out until the new file is in place
+    int lock_fd = coord_open_locked(filename, O_RDONLY, 0);
+    if (lock_fd < 0) {
+        return -1;
+    }
+    
+    // The reader pins the snapshot: header, log rows and deletion vectors
+    reader_t* reader = reader_open(filename);
+    if (!reader) {
+        close(lock_fd);
+        return -1;
+    }
+    
+    if (settings.sort_field >= (int)reader->schema->field_count) {
+        fprintf(stderr, "Error: Sort field %d does not exist\n", settings.sort_field);
+        reader_close(reader);
+        close(lock_fd);
+        return -1;
+    }
+    
+    compact_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.reader = reader;
+    job.old_fd = fileno(reader->file);
+    job.new_fd = -1;
+    job.row_size = reader->schema->row_size;
+    job.null_columns = fxdb_popcount64(reader->header.null_mask);
+    job.chunk_size = settings.chunk_size ? settings.chunk_size : reader->header.chunk_size;
+    job.align = settings.align_chunks || fxdb_header_aligned(&reader->header);
+    job.data_offset = job.align ? (long)fxdb_align_up(reader->header.data_offset, FXDB_IO_ALIGNMENT)
+                                : (long)reader->header.data_offset;
+    job.full_chunk_bytes = chunk_bytes(&job, job.chunk_size);
+    
+    uint32_t threads = settings.threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (threads > COMPACT_MAX_THREADS) {
+        threads = COMPACT_MAX_THREADS;
+    }
+    
+    size_t temp_length = strlen(filename) + strlen(TEMP_EXT) + 1;
+    char* temp_path = malloc(temp_length);
+    int result = temp_path ? build_directory(&job) : -1;
+    uint64_t bytes_before = database_size(filename);
+    
+    if (result == 0) {
+        snprintf(temp_path, temp_length, "%s%s", filename, TEMP_EXT);
+    }
+    
+    // Keep the database's permissions
+    struct stat st;
+    uint32_t sort_runs = 0;
+    if (result == 0) {
+        mode_t mode = fstat(job.old_fd, &st) == 0 ? (st.st_mode & 0777) : 0644;
+        job.new_fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+        if (job.new_fd < 0) {
+            fprintf(stderr, "Error: Cannot create file '%s': %s\n", temp_path, strerror(errno));
+            result = -1;
+        } else if (fxdb_lock_file(job.new_fd) != 0) {
+            // Writers that wake up on the new file wait until its sidecars are settled
+            fprintf(stderr, "Error: Cannot lock '%s': %s\n", temp_path, strerror(errno));
+            result = -1;
+        }
+    }
+    
+    job.chunk_count = (uint32_t)(((uint64_t)job.live_rows + job.chunk_size - 1) / job.chunk_size);
+    if (result == 0 && settings.chunk_summaries) {
+        job.summaries = calloc(job.chunk_count ? job.chunk_count : 1, sizeof(uint8_t*));
+        job.summary_sizes = calloc(job.chunk_count ? job.chunk_count : 1, sizeof(size_t));
+        result = (job.summaries && job.summary_sizes) ? 0 : -1;
+    }
+    if (result == 0 && settings.sort_field >= 0) {
+        result = emit_sorted(&job, &settings, threads, filename, &sort_runs);
+    } else if (result == 0) {
+        result = run_parallel(&job, threads, job.chunk_count, emit_main);
+    }
+    
+    fxdb_header_t header = reader->header;
+    if (result == 0) {
+        header.total_rows = job.live_rows;
+        header.chunk_size = job.chunk_size;
+        header.chunk_count = job.chunk_count;
+        header.data_offset = (uint32_t)job.data_offset;
+        header.data_size = 0;
+        if (job.chunk_count > 0) {
+            uint32_t last_rows = job.live_rows - (job.chunk_count - 1) * job.chunk_size;
+            header.data_size = (uint32_t)((job.chunk_count - 1) * job.full_chunk_bytes +
+                                          chunk_bytes(&job, last_rows));
+        }
+        header.generation = reader->header.generation + 1;
+        fxdb_header_publish(&header);
+        result = write_file_head(&job, &header);
+    }
+    if (result == 0 && settings.durability == FXDB_DURABILITY_FSYNC) {
+        result = fxdb_stats_sync_file(job.new_fd);
+    }
+    
+    // Swap the new file in; open readers keep the old one
+    if (result == 0 && rename(temp_path, filename) != 0) {
+        fprintf(stderr, "Error: Cannot replace '%s': %s\n", filename, strerror(errno));
+        result = -1;
+    }
+    if (result != 0 && temp_path && job.new_fd >= 0) {
+        unlink(temp_path);
+    }
+    
+    // The log rows are in the file now; the sidecars belong to the old generation
+    if (result == 0) {
+        wal_remove(filename);
+        deletes_remove(filename);
+        write_summaries(&job, filename, &header);
+        
+        // Readers polling the old file see a commit, refresh and are told to reopen
+        fxdb_coord_t* coord = coord_attach(filename, true);
+        coord_publish(coord, &header, 0);
+        coord_detach(coord);
+    }
+    
+    // Only now may a writer lock the new file and commit to it
+    if (job.new_fd >= 0 && close(job.new_fd) != 0) {
+        result = -1;
+    }
+    
+    if (result == 0 && stats) {
+        stats->chunks_before = job.source_count;
+        stats->chunks_after = job.chunk_count;
+        stats->rows_before = reader->header.total_rows + reader->wal_rows;
+        stats->rows_after = job.live_rows;
+        stats->bytes_before = bytes_before;
+        stats->bytes_after = database_size(filename);
+        stats->threads = threads;
+        stats->sort_runs = sort_runs;
+    }
+    
+    for (uint32_t k = 0; job.summaries && k < job.chunk_count; k++) {
+        free(job.summaries[k]);
+    }
+    free(job.summaries);
+    free(job.summary_sizes);
+    free(job.sources);
+    free(temp_path);
+    reader_close(reader);
+    close(lock_fd);
+    return result;
+}
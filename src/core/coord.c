@@ -0,0 +1,226 @@
+#include "../../include/coord.h"
+#include "../../include/config.h"
+#include "../../include/io_utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LOCK_MAX_DELAY_MS 50
+#define READ_RETRIES 1000
+
+// Path of the shared-memory sidecar belonging to a database file
+char* coord_shm_path(const char* db_path) {
+    if (!db_path) {
+        return NULL;
+    }
+    
+    size_t length = strlen(db_path) + strlen(SHM_EXT) + 1;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s%s", db_path, SHM_EXT);
+    }
+    return path;
+}
+
+// Pid recorded by the writer holding the lock, 0 if unknown
+static uint32_t lock_holder(const char* db_path) {
+    fxdb_coord_t* coord = coord_attach(db_path, false);
+    uint32_t pid = coord ? __atomic_load_n(&coord->shm->writer_pid, __ATOMIC_RELAXED) : 0;
+    coord_detach(coord);
+    return pid;
+}
+
+// Open a database file and take its writer lock
+int coord_open_locked(const char* db_path, int flags, uint32_t timeout_ms) {
+    if (!db_path) {
+        return -1;
+    }
+    
+    uint32_t waited_ms = 0;
+    uint32_t delay_ms = 1;
+    for (;;) {
+        int fd = open(db_path, flags, 0666);
+        if (fd < 0) {
+            fprintf(stderr, "Error: Cannot open file '%s': %s\n", db_path, strerror(errno));
+            return -1;
+        }
+        
+        if (fxdb_lock_file(fd) == 0) {
+            // Compaction may have renamed a new file over the one we waited for
+            struct stat locked, current;
+            if (fstat(fd, &locked) == 0 && stat(db_path, &current) == 0 &&
+                locked.st_dev == current.st_dev && locked.st_ino == current.st_ino) {
+                return fd;
+            }
+            close(fd);
+            continue;
+        }
+        
+        int error = errno;
+        close(fd);
+        if (error != EWOULDBLOCK && error != EAGAIN) {
+            fprintf(stderr, "Error: Cannot lock '%s': %s\n", db_path, strerror(error));
+            return -1;
+        }
+        
+        if (waited_ms >= timeout_ms) {
+            uint32_t pid = lock_holder(db_path);
+            if (pid != 0) {
+                fprintf(stderr, "Error: Database '%s' is locked by another writer (pid %u)\n", db_path, pid);
+            } else {
+                fprintf(stderr, "Error: Database '%s' is locked by another writer\n", db_path);
+            }
+            return -1;
+        }
+        
+        // Back off, but keep the wait close to the timeout
+        if (delay_ms > timeout_ms - waited_ms) {
+            delay_ms = timeout_ms - waited_ms;
+        }
+        struct timespec delay = { delay_ms / 1000, (long)(delay_ms % 1000) * 1000000L };
+        nanosleep(&delay, NULL);
+        waited_ms += delay_ms;
+        delay_ms = delay_ms * 2 > LOCK_MAX_DELAY_MS ? LOCK_MAX_DELAY_MS : delay_ms * 2;
+    }
+}
+
+// Map the shared-memory sidecar of a database
+fxdb_coord_t* coord_attach(const char* db_path, bool writer) {
+    char* path = coord_shm_path(db_path);
+    if (!path) {
+        return NULL;
+    }
+    
+    int fd = open(path, writer ? O_RDWR | O_CREAT : O_RDONLY, 0666);
+    if (fd < 0) {
+        if (writer) {
+            fprintf(stderr, "Error: Cannot open shared state '%s': %s\n", path, strerror(errno));
+        }
+        free(path);
+        return NULL;
+    }
+    
+    // A sidecar still being created is too short to map; readers go without
+    struct stat st;
+    bool sized = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(fxdb_shm_t);
+    if (!sized && writer) {
+        sized = ftruncate(fd, sizeof(fxdb_shm_t)) == 0;
+    }
+    
+    fxdb_shm_t* shm = MAP_FAILED;
+    if (sized) {
+        shm = mmap(NULL, sizeof(fxdb_shm_t), writer ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (shm == MAP_FAILED) {
+        if (writer) {
+            fprintf(stderr, "Error: Cannot map shared state '%s'\n", path);
+        }
+        free(path);
+        return NULL;
+    }
+    free(path);
+    
+    if (writer) {
+        // We hold the writer lock: a torn state was left by a writer that died
+        if (shm->magic != FXDB_SHM_MAGIC || shm->version != FXDB_SHM_VERSION) {
+            memset(shm, 0, sizeof(*shm));
+            shm->magic = FXDB_SHM_MAGIC;
+            shm->version = FXDB_SHM_VERSION;
+        }
+        if (shm->sequence & 1) {
+            __atomic_store_n(&shm->sequence, shm->sequence + 1, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&shm->writer_pid, (uint32_t)getpid(), __ATOMIC_RELAXED);
+    } else if (shm->magic != FXDB_SHM_MAGIC || shm->version != FXDB_SHM_VERSION) {
+        munmap(shm, sizeof(fxdb_shm_t));
+        return NULL;
+    }
+    
+    fxdb_coord_t* coord = malloc(sizeof(fxdb_coord_t));
+    if (!coord) {
+        munmap(shm, sizeof(fxdb_shm_t));
+        return NULL;
+    }
+    coord->shm = shm;
+    coord->writable = writer;
+    return coord;
+}
+
+// Publish a commit: odd sequence, state, even sequence
+void coord_publish(fxdb_coord_t* coord, const fxdb_header_t* header, uint32_t wal_rows) {
+    if (!coord || !coord->writable || !header) {
+        return;
+    }
+    
+    fxdb_shm_t* shm = coord->shm;
+    uint64_t sequence = shm->sequence; // Only the lock holder changes it
+    __atomic_store_n(&shm->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&shm->generation, header->generation, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->total_rows, header->total_rows, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->chunk_count, header->chunk_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->wal_rows, wal_rows, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// Read the last published commit, retrying while the writer updates it
+int coord_read(const fxdb_coord_t* coord, fxdb_commit_state_t* state) {
+    if (!coord || !state) {
+        return -1;
+    }
+    
+    fxdb_shm_t* shm = coord->shm;
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+        uint64_t before = __atomic_load_n(&shm->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        
+        fxdb_commit_state_t copy;
+        copy.sequence = before;
+        copy.generation = __atomic_load_n(&shm->generation, __ATOMIC_RELAXED);
+        copy.total_rows = __atomic_load_n(&shm->total_rows, __ATOMIC_RELAXED);
+        copy.chunk_count = __atomic_load_n(&shm->chunk_count, __ATOMIC_RELAXED);
+        copy.wal_rows = __atomic_load_n(&shm->wal_rows, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->sequence, __ATOMIC_RELAXED) == before) {
+            *state = copy;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Unmap the sidecar
+void coord_detach(fxdb_coord_t* coord) {
+    if (!coord) {
+        return;
+    }
+    
+    if (coord->writable) {
+        __atomic_store_n(&coord->shm->writer_pid, 0, __ATOMIC_RELAXED);
+    }
+    munmap(coord->shm, sizeof(fxdb_shm_t));
+    free(coord);
+}
+
+// Delete the sidecar of a database
+int coord_remove(const char* db_path) {
+    char* path = coord_shm_path(db_path);
+    if (!path) {
+        return -1;
+    }
+    
+    int result = (unlink(path) == 0 || errno == ENOENT) ? 0 : -1;
+    free(path);
+    return result;
+}
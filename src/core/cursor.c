@@ -0,0 +1,209 @@
+#include "../../include/cursor.h"
+#include "../../include/config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#define FOLLOW_CHECK_MS 200     // Longest wait between commit checks while watching for events
+#define FOLLOW_SLEEP_MS 20      // Commit check interval without events
+
+// Rows the reader's snapshot holds, deleted ones included
+static uint32_t committed_rows(const reader_t* reader) {
+    reader_snapshot_t snapshot;
+    reader_get_snapshot(reader, &snapshot);
+    return snapshot.committed_rows;
+}
+
+// Chunks the reader's snapshot holds, the log's rows counting as one
+static uint32_t chunk_total(const reader_t* reader) {
+    return reader->header.chunk_count + (reader->wal_rows > 0 ? 1 : 0);
+}
+
+static long elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000L + (now.tv_nsec - start->tv_nsec) / 1000000L;
+}
+
+// Watch the database's directory for writes to the database and its log
+static void start_watch(fxdb_cursor_t* cursor, const char* filename) {
+    const char* slash = strrchr(filename, '/');
+    const char* base = slash ? slash + 1 : filename;
+    size_t wal_length = strlen(base) + strlen(WAL_EXT) + 1;
+    cursor->db_name = strdup(base);
+    cursor->wal_name = malloc(wal_length);
+    if (cursor->wal_name) {
+        snprintf(cursor->wal_name, wal_length, "%s%s", base, WAL_EXT);
+    }
+
+#ifdef __linux__
+    char* directory = slash ? strndup(filename, (size_t)(slash - filename) + 1) : strdup(".");
+    if (!directory || !cursor->db_name || !cursor->wal_name) {
+        free(directory);
+        return;
+    }
+    
+    cursor->notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cursor->notify_fd >= 0 &&
+        inotify_add_watch(cursor->notify_fd, directory,
+                          IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0) {
+        close(cursor->notify_fd);
+        cursor->notify_fd = -1;
+    }
+    free(directory);
+#endif
+}
+
+// Wait up to wait_ms for a write to the database or its log
+static void wait_for_change(fxdb_cursor_t* cursor, long wait_ms) {
+#ifdef __linux__
+    if (cursor->notify_fd >= 0) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long remaining = wait_ms;
+        while (remaining > 0) {
+            struct pollfd pfd = { cursor->notify_fd, POLLIN, 0 };
+            if (poll(&pfd, 1, (int)remaining) <= 0) {
+                return;
+            }
+            
+            // Events for other files in the directory keep us waiting
+            char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            bool relevant = false;
+            ssize_t length;
+            while ((length = read(cursor->notify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length; ) {
+                    const struct inotify_event* event = (const struct inotify_event*)p;
+                    if (event->len > 0 && (strcmp(event->name, cursor->db_name) == 0 ||
+                                           strcmp(event->name, cursor->wal_name) == 0)) {
+                        relevant = true;
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            if (relevant) {
+                return;
+            }
+            remaining = wait_ms - elapsed_ms(&start);
+        }
+        return;
+    }
+#endif
+    (void)cursor;
+    struct timespec delay = { wait_ms / 1000, (wait_ms % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+// Open a cursor on a database
+fxdb_cursor_t* fxdb_cursor_open(const char* filename, bool from_start) {
+    if (!filename) {
+        return NULL;
+    }
+    
+    fxdb_cursor_t* cursor = calloc(1, sizeof(fxdb_cursor_t));
+    if (!cursor) {
+        return NULL;
+    }
+    cursor->notify_fd = -1;
+    
+    cursor->reader = reader_open(filename);
+    if (!cursor->reader) {
+        free(cursor);
+        return NULL;
+    }
+    
+    // Start after the last stored row: only its chunk is read
+    uint32_t chunks = chunk_total(cursor->reader);
+    if (!from_start && chunks > 0) {
+        if (reader_load_chunk(cursor->reader, chunks - 1) != 0) {
+            fxdb_cursor_close(cursor);
+            return NULL;
+        }
+        cursor->position.chunk_index = chunks - 1;
+        cursor->position.row_in_chunk = cursor->reader->chunk_row_count;
+        cursor->reader->current_row = cursor->reader->chunk_row_count;
+        cursor->seen_rows = committed_rows(cursor->reader);
+    }
+    
+    start_watch(cursor, filename);
+    return cursor;
+}
+
+// Next row after the cursor
+row_data_t* fxdb_cursor_next(fxdb_cursor_t* cursor) {
+    if (!cursor) {
+        return NULL;
+    }
+    
+    // Resume at the position; refreshing rewinds the reader
+    reader_t* reader = cursor->reader;
+    if (!reader->chunk_data || reader->current_chunk != cursor->position.chunk_index) {
+        if (cursor->position.chunk_index >= chunk_total(reader)) {
+            cursor->seen_rows = committed_rows(reader);
+            return NULL;
+        }
+        if (reader_load_chunk(reader, cursor->position.chunk_index) != 0) {
+            return NULL;
+        }
+        reader->current_row = cursor->position.row_in_chunk;
+    }
+    
+    row_data_t* row = reader_read_row(reader);
+    cursor->position.chunk_index = reader->current_chunk;
+    cursor->position.row_in_chunk = reader->current_row < reader->chunk_row_count ?
+                                    reader->current_row : reader->chunk_row_count;
+    if (!row) {
+        cursor->seen_rows = committed_rows(reader);
+    }
+    return row;
+}
+
+// Wait until rows past the cursor are committed
+int fxdb_cursor_follow(fxdb_cursor_t* cursor, int timeout_ms) {
+    if (!cursor) {
+        return -1;
+    }
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;) {
+        // The published commit state says whether the file needs a look
+        if (reader_poll(cursor->reader, NULL) != 0 && reader_refresh(cursor->reader) != 0) {
+            fprintf(stderr, "Error: Cannot follow '%s': the file was rewritten or replaced\n",
+                    cursor->reader->path);
+            return -1;
+        }
+        if (committed_rows(cursor->reader) > cursor->seen_rows) {
+            return 1;
+        }
+        
+        long elapsed = elapsed_ms(&start);
+        if (timeout_ms >= 0 && elapsed >= timeout_ms) {
+            return 0;
+        }
+        
+        long wait_ms = cursor->notify_fd >= 0 ? FOLLOW_CHECK_MS : FOLLOW_SLEEP_MS;
+        if (timeout_ms >= 0 && timeout_ms - elapsed < wait_ms) {
+            wait_ms = timeout_ms - elapsed;
+        }
+        wait_for_change(cursor, wait_ms);
+    }
+}
+
+// Close a cursor and its reader
+void fxdb_cursor_close(fxdb_cursor_t* cursor) {
+    if (cursor) {
+        reader_close(cursor->reader);
+        if (cursor->notify_fd >= 0) {
+            close(cursor->notify_fd);
+        }
+        free(cursor->db_name);
+        free(cursor->wal_name);
+        free(cursor);
+    }
+}
@@ -0,0 +1,277 @@
+#include "../../include/deletes.h"
+#include "../../include/config.h"
+#include "../../include/bitmap.h"
+#include "../../include/utils.h"
+#include "../../include/io_utils.h"
+#include "../../include/stats.h"
+#include "../../include/coord.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// One 64-row word of a chunk's deletion vector
+typedef struct {
+    uint32_t checksum;          // Over the fields below
+    uint32_t chunk_index;
+    uint32_t word_index;
+    uint64_t bits;
+} __attribute__((packed)) deletes_record_t;
+
+#define RECORD_PAYLOAD (sizeof(deletes_record_t) - sizeof(uint32_t))
+
+// Path of the deletion file belonging to a database file
+char* deletes_path(const char* db_path) {
+    if (!db_path) {
+        return NULL;
+    }
+    
+    size_t length = strlen(db_path) + strlen(DELETE_EXT) + 1;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s%s", db_path, DELETE_EXT);
+    }
+    return path;
+}
+
+// Create an empty set of deletion vectors
+fxdb_deletes_t* deletes_create(uint32_t chunk_size) {
+    fxdb_deletes_t* deletes = calloc(1, sizeof(fxdb_deletes_t));
+    if (deletes) {
+        deletes->words = fxdb_bitmap_words(chunk_size ? chunk_size : 1);
+    }
+    return deletes;
+}
+
+// Vector of a chunk, allocated on first use
+static uint64_t* chunk_vector(fxdb_deletes_t* deletes, uint32_t chunk_index) {
+    if (chunk_index >= deletes->chunk_count) {
+        uint32_t new_count = deletes->chunk_count ? deletes->chunk_count : 16;
+        while (new_count <= chunk_index) {
+            new_count *= 2;
+        }
+        uint64_t** vectors = realloc(deletes->vectors, (size_t)new_count * sizeof(uint64_t*));
+        if (!vectors) {
+            return NULL;
+        }
+        memset(vectors + deletes->chunk_count, 0, (size_t)(new_count - deletes->chunk_count) * sizeof(uint64_t*));
+        deletes->vectors = vectors;
+        deletes->chunk_count = new_count;
+    }
+    
+    if (!deletes->vectors[chunk_index]) {
+        deletes->vectors[chunk_index] = calloc(deletes->words, sizeof(uint64_t));
+    }
+    return deletes->vectors[chunk_index];
+}
+
+// OR a word of deleted bits into a chunk's vector, counting new deletions
+static int merge_word(fxdb_deletes_t* deletes, uint32_t chunk_index, uint32_t word_index, uint64_t bits) {
+    if (word_index >= deletes->words) {
+        return -1;
+    }
+    
+    uint64_t* vector = chunk_vector(deletes, chunk_index);
+    if (!vector) {
+        return -1;
+    }
+    
+    uint64_t added = bits & ~vector[word_index];
+    vector[word_index] |= bits;
+    deletes->deleted_rows += fxdb_popcount64(added);
+    return added ? 1 : 0;
+}
+
+// Mark a row deleted
+int deletes_mark(fxdb_deletes_t* deletes, row_position_t position) {
+    if (!deletes) {
+        return -1;
+    }
+    return merge_word(deletes, position.chunk_index, position.row_in_chunk / FXDB_BITMAP_WORD_BITS,
+                      1ULL << (position.row_in_chunk % FXDB_BITMAP_WORD_BITS));
+}
+
+// Deletion vector of a chunk
+const uint64_t* deletes_chunk(const fxdb_deletes_t* deletes, uint32_t chunk_index) {
+    if (!deletes || chunk_index >= deletes->chunk_count) {
+        return NULL;
+    }
+    return deletes->vectors[chunk_index];
+}
+
+// Whether a row is marked deleted
+bool deletes_contains(const fxdb_deletes_t* deletes, row_position_t position) {
+    const uint64_t* vector = deletes_chunk(deletes, position.chunk_index);
+    return vector && position.row_in_chunk / FXDB_BITMAP_WORD_BITS < deletes->words &&
+           fxdb_bitmap_get(vector, position.row_in_chunk);
+}
+
+// Deletion vectors only apply to the database generation they were written for
+static bool header_matches(const fxdb_deletes_header_t* header, const fxdb_header_t* db_header) {
+    return header->magic == FXDB_DELETES_MAGIC && header->version == FXDB_DELETES_VERSION &&
+           header->generation == db_header->generation && header->chunk_size == db_header->chunk_size;
+}
+
+// Load the deletion vectors of a database
+fxdb_deletes_t* deletes_load(const char* db_path, const fxdb_header_t* db_header) {
+    if (!db_path || !db_header) {
+        return NULL;
+    }
+    
+    fxdb_deletes_t* deletes = deletes_create(db_header->chunk_size);
+    char* path = deletes_path(db_path);
+    if (!deletes || !path) {
+        deletes_free(deletes);
+        free(path);
+        return NULL;
+    }
+    
+    FILE* file = fopen(path, "rb");
+    free(path);
+    if (!file) {
+        return deletes; // Nothing deleted yet
+    }
+    
+    fxdb_deletes_header_t header;
+    if (fread(&header, sizeof(header), 1, file) == 1 && header_matches(&header, db_header)) {
+        deletes_record_t record;
+        while (fread(&record, sizeof(record), 1, file) == 1) {
+            if (!utils_verify_checksum((const uint8_t*)&record + sizeof(uint32_t), RECORD_PAYLOAD,
+                                       record.checksum)) {
+                break;
+            }
+            if (merge_word(deletes, record.chunk_index, record.word_index, record.bits) < 0) {
+                fclose(file);
+                deletes_free(deletes);
+                return NULL;
+            }
+        }
+    }
+    
+    fclose(file);
+    return deletes;
+}
+
+// Open the deletion file for appending, replacing a missing or stale one
+static FILE* open_for_append(const char* path, const fxdb_header_t* db_header) {
+    FILE* file = fopen(path, "r+b");
+    if (file) {
+        fxdb_deletes_header_t header;
+        if (fread(&header, sizeof(header), 1, file) == 1 && header_matches(&header, db_header) &&
+            fseek(file, 0, SEEK_END) == 0) {
+            // Appends are sequential, so only the last record can be torn
+            long size = ftell(file);
+            long records = (size - (long)sizeof(header)) / (long)sizeof(deletes_record_t);
+            long valid_end = (long)sizeof(header) + records * (long)sizeof(deletes_record_t);
+            if (size == valid_end ||
+                (fflush(file) == 0 && ftruncate(fileno(file), valid_end) == 0 &&
+                 fseek(file, valid_end, SEEK_SET) == 0)) {
+                return file;
+            }
+        }
+        fclose(file);
+    }
+    
+    file = fopen(path, "w+b");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create deletion file '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    
+    fxdb_deletes_header_t header = {
+        .magic = FXDB_DELETES_MAGIC,
+        .version = FXDB_DELETES_VERSION,
+        .generation = db_header->generation,
+        .chunk_size = db_header->chunk_size
+    };
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+// Append the rows marked in batch to the database's deletion file
+int deletes_write(const char* db_path, const fxdb_header_t* db_header, const fxdb_deletes_t* batch,
+                  fxdb_durability_t durability) {
+    if (!db_path || !db_header || !batch) {
+        return -1;
+    }
+    if (batch->deleted_rows == 0) {
+        return 0;
+    }
+    
+    // Hold the writer lock so deleters and compaction take turns on the file
+    int lock_fd = coord_open_locked(db_path, O_RDONLY, FXDB_LOCK_TIMEOUT_MS);
+    if (lock_fd < 0) {
+        return -1;
+    }
+    
+    // Positions only mean something in the generation they were read from
+    fxdb_header_t current;
+    if (pread(lock_fd, &current, sizeof(current), 0) != (ssize_t)sizeof(current) ||
+        current.generation != db_header->generation) {
+        fprintf(stderr, "Error: Database '%s' was rewritten since its rows were read\n", db_path);
+        close(lock_fd);
+        return -1;
+    }
+    
+    char* path = deletes_path(db_path);
+    FILE* file = path ? open_for_append(path, db_header) : NULL;
+    free(path);
+    if (!file) {
+        close(lock_fd);
+        return -1;
+    }
+    
+    int result = 0;
+    for (uint32_t c = 0; c < batch->chunk_count && result == 0; c++) {
+        const uint64_t* vector = batch->vectors[c];
+        for (uint32_t w = 0; vector && w < batch->words && result == 0; w++) {
+            if (vector[w] == 0) {
+                continue;
+            }
+            deletes_record_t record = { 0, c, w, vector[w] };
+            record.checksum = utils_simple_checksum((const uint8_t*)&record + sizeof(uint32_t), RECORD_PAYLOAD);
+            if (fwrite(&record, sizeof(record), 1, file) != 1) {
+                result = -1;
+            }
+        }
+    }
+    
+    if (result == 0 && durability != FXDB_DURABILITY_NONE) {
+        result = fflush(file) == 0 ? 0 : -1;
+        if (result == 0 && durability == FXDB_DURABILITY_FSYNC) {
+            result = fxdb_stats_sync_file(fileno(file));
+        }
+    }
+    if (fclose(file) != 0) {
+        result = -1;
+    }
+    close(lock_fd);
+    return result;
+}
+
+// Free deletion vectors
+void deletes_free(fxdb_deletes_t* deletes) {
+    if (deletes) {
+        for (uint32_t c = 0; c < deletes->chunk_count; c++) {
+            free(deletes->vectors[c]);
+        }
+        free(deletes->vectors);
+        free(deletes);
+    }
+}
+
+// Delete the deletion file of a database, if there is one
+int deletes_remove(const char* db_path) {
+    char* path = deletes_path(db_path);
+    if (!path) {
+        return -1;
+    }
+    
+    int result = (unlink(path) == 0 || errno == ENOENT) ? 0 : -1;
+    free(path);
+    return result;
+}
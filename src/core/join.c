@@ -0,0 +1,728 @@
+#include "../../include/join.h"
+#include "../../include/arena.h"
+#include "../../include/sketch.h"
+#include "../../include/stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Every record starts with the row's NULL fields
+#define RECORD_HEADER sizeof(uint64_t)
+#define PARTITION_BUFFER_SIZE (1 << 14)
+#define TABLE_INITIAL_ROWS 1024
+#define OUTPUT_INITIAL_ROWS 256
+
+// Build rows hashed on the join field; chains link records by index plus one
+typedef struct {
+    uint8_t* records;
+    uint64_t* hashes;
+    uint32_t* next;
+    uint32_t* buckets;          // First record of each bucket, plus one (0 when empty)
+    uint32_t mask;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t bucket_capacity;
+} join_table_t;
+
+// One table of the join
+typedef struct {
+    reader_t* reader;
+    const schema_t* schema;
+    const field_def_t* field;
+    uint32_t field_index;
+    uint32_t key_offset;
+    size_t record_size;         // Header and row, rounded so the next record stays aligned
+} join_side_t;
+
+// Rows a thread produced, each [NULL fields][left row][right row]
+typedef struct {
+    uint8_t* data;
+    uint64_t count;
+    uint64_t capacity;
+} join_output_t;
+
+typedef struct {
+    join_side_t build;
+    join_side_t probe;
+    bool build_left;
+    uint32_t left_fields;       // NULL bits of the right row start here
+    size_t output_size;
+    fxdb_join_options_t options;
+    uint64_t produced;          // Rows claimed against the limit
+    join_table_t table;         // The build side of an in-memory join
+    
+    // Partitions of a grace join (0 for an in-memory join)
+    uint32_t partitions;
+    char** build_paths;
+    char** probe_paths;
+    FILE** files;               // Partition files being written
+    uint32_t next_partition;    // Next partition a thread takes
+} join_t;
+
+// One thread's share: a range of probe chunks, then partitions
+typedef struct {
+    join_t* join;
+    reader_t* reader;
+    bool owns_reader;
+    uint32_t first_chunk;
+    uint32_t end_chunk;
+    join_output_t output;
+    join_table_t table;
+    uint64_t probe_rows;
+    int result;
+} join_task_t;
+
+// Compare the keys of two rows, the fields of the same type
+static bool keys_equal(const field_def_t* a_field, const uint8_t* a, const field_def_t* b_field, const uint8_t* b) {
+    int32_t x, y;
+    float f, g;
+    switch (a_field->type) {
+        case FIELD_TYPE_INT32:
+            memcpy(&x, a, sizeof(x));
+            memcpy(&y, b, sizeof(y));
+            return x == y;
+        case FIELD_TYPE_FLOAT:
+            memcpy(&f, a, sizeof(f));
+            memcpy(&g, b, sizeof(g));
+            return f == g;
+        case FIELD_TYPE_BOOL:
+            return (a[0] != 0) == (b[0] != 0);
+        default: {
+            size_t length = strnlen((const char*)a, a_field->size);
+            return length == strnlen((const char*)b, b_field->size) && memcmp(a, b, length) == 0;
+        }
+    }
+}
+
+static void init_side(join_side_t* side, reader_t* reader, uint32_t field) {
+    side->reader = reader;
+    side->schema = reader->schema;
+    side->field = &reader->schema->fields[field];
+    side->field_index = field;
+    side->key_offset = schema_field_offset(reader->schema, field);
+    side->record_size = (RECORD_HEADER + reader->schema->row_size + 7) & ~(size_t)7;
+}
+
+// Bytes a build row takes in a hash table, its bucket included
+static size_t table_row_bytes(const join_side_t* side) {
+    return side->record_size + sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(uint32_t);
+}
+
+static uint64_t row_hash(const join_side_t* side, const uint8_t* row) {
+    return fxdb_hash_value(side->field, row + side->key_offset);
+}
+
+static bool key_is_null(const join_side_t* side, uint64_t null_fields) {
+    return (null_fields >> side->field_index) & 1;
+}
+
+// Add a record to a hash table
+static int table_add(join_table_t* table, const join_side_t* side, const uint8_t* record, uint64_t hash) {
+    if (table->count == table->capacity) {
+        uint32_t capacity = table->capacity ? table->capacity * 2 : TABLE_INITIAL_ROWS;
+        uint8_t* records = realloc(table->records, (size_t)capacity * side->record_size);
+        if (records) {
+            table->records = records;
+        }
+        uint64_t* hashes = records ? realloc(table->hashes, (size_t)capacity * sizeof(uint64_t)) : NULL;
+        if (hashes) {
+            table->hashes = hashes;
+        }
+        uint32_t* next = hashes ? realloc(table->next, (size_t)capacity * sizeof(uint32_t)) : NULL;
+        if (!next) {
+            fprintf(stderr, "Error: Out of memory building join hash table\n");
+            return -1;
+        }
+        table->next = next;
+        table->capacity = capacity;
+    }
+    memcpy(table->records + (size_t)table->count * side->record_size, record, side->record_size);
+    table->hashes[table->count++] = hash;
+    return 0;
+}
+
+// Link the records into buckets, a power of two of them
+static int table_index(join_table_t* table) {
+    uint32_t buckets = 16;
+    while (buckets < table->count && buckets < (1u << 31)) {
+        buckets <<= 1;
+    }
+    if (table->bucket_capacity < buckets) {
+        uint32_t* array = realloc(table->buckets, (size_t)buckets * sizeof(uint32_t));
+        if (!array) {
+            fprintf(stderr, "Error: Out of memory building join hash table\n");
+            return -1;
+        }
+        table->buckets = array;
+        table->bucket_capacity = buckets;
+    }
+    memset(table->buckets, 0, (size_t)buckets * sizeof(uint32_t));
+    table->mask = buckets - 1;
+    // Linked from the back, so a chain lists its records in the order they were added
+    for (uint32_t i = table->count; i-- > 0;) {
+        uint32_t bucket = (uint32_t)table->hashes[i] & table->mask;
+        table->next[i] = table->buckets[bucket];
+        table->buckets[bucket] = i + 1;
+    }
+    return 0;
+}
+
+static void table_free(join_table_t* table) {
+    free(table->records);
+    free(table->hashes);
+    free(table->next);
+    free(table->buckets);
+    memset(table, 0, sizeof(*table));
+}
+
+// True once the limit has been reached
+static bool join_done(join_t* join) {
+    return join->options.limit > 0 &&
+           __atomic_load_n(&join->produced, __ATOMIC_RELAXED) >= join->options.limit;
+}
+
+// Append a joined row to a thread's output
+static int emit(join_t* join, join_task_t* task, const uint8_t* probe_row, uint64_t probe_nulls,
+                const uint8_t* build_record) {
+    if (join->options.limit > 0 &&
+        __atomic_fetch_add(&join->produced, 1, __ATOMIC_RELAXED) >= join->options.limit) {
+        return 0;
+    }
+    
+    join_output_t* output = &task->output;
+    if (output->count == output->capacity) {
+        uint64_t capacity = output->capacity ? output->capacity * 2 : OUTPUT_INITIAL_ROWS;
+        uint8_t* data = realloc(output->data, capacity * join->output_size);
+        if (!data) {
+            fprintf(stderr, "Error: Out of memory joining rows\n");
+            return -1;
+        }
+        output->data = data;
+        output->capacity = capacity;
+    }
+    
+    uint64_t build_nulls;
+    memcpy(&build_nulls, build_record, sizeof(build_nulls));
+    const uint8_t* build_row = build_record + RECORD_HEADER;
+    const uint8_t* left = join->build_left ? build_row : probe_row;
+    const uint8_t* right = join->build_left ? probe_row : build_row;
+    uint64_t left_nulls = join->build_left ? build_nulls : probe_nulls;
+    uint64_t right_nulls = join->build_left ? probe_nulls : build_nulls;
+    uint64_t null_fields = left_nulls | (right_nulls << join->left_fields);
+    
+    uint8_t* out = output->data + output->count++ * join->output_size;
+    uint32_t left_size = join->build_left ? join->build.schema->row_size : join->probe.schema->row_size;
+    uint32_t right_size = join->build_left ? join->probe.schema->row_size : join->build.schema->row_size;
+    memcpy(out, &null_fields, sizeof(null_fields));
+    memcpy(out + RECORD_HEADER, left, left_size);
+    memcpy(out + RECORD_HEADER + left_size, right, right_size);
+    return 0;
+}
+
+// Look a probe row up and emit every build row with its key
+static int probe_row(join_t* join, join_task_t* task, const join_table_t* table,
+                     const uint8_t* row, uint64_t null_fields, uint64_t hash) {
+    if (table->count == 0) {
+        return 0;
+    }
+    const uint8_t* key = row + join->probe.key_offset;
+    for (uint32_t i = table->buckets[(uint32_t)hash & table->mask]; i != 0; i = table->next[i - 1]) {
+        const uint8_t* record = table->records + (size_t)(i - 1) * join->build.record_size;
+        if (table->hashes[i - 1] == hash &&
+            keys_equal(join->build.field, record + RECORD_HEADER + join->build.key_offset, join->probe.field, key) &&
+            emit(join, task, row, null_fields, record) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Partition a row falls in; the bucket takes the low bits of the hash
+static uint32_t partition_of(const join_t* join, uint64_t hash) {
+    return (uint32_t)(hash >> 32) & (join->partitions - 1);
+}
+
+// Write a row to its partition file
+static int write_partition(const join_side_t* side, FILE* file, const uint8_t* row, uint64_t null_fields) {
+    // One fwrite per record, so threads sharing the file never interleave records
+    uint8_t stack_record[4096];
+    uint8_t* record = side->record_size <= sizeof(stack_record) ? stack_record : malloc(side->record_size);
+    if (!record) {
+        return -1;
+    }
+    memcpy(record, &null_fields, sizeof(null_fields));
+    memcpy(record + RECORD_HEADER, row, side->schema->row_size);
+    memset(record + RECORD_HEADER + side->schema->row_size, 0,
+           side->record_size - RECORD_HEADER - side->schema->row_size);
+    int result = fwrite(record, side->record_size, 1, file) == 1 ? 0 : -1;
+    if (record != stack_record) {
+        free(record);
+    }
+    return result;
+}
+
+// Scan a range of probe chunks, probing the table or partitioning the rows
+static void* scan_main(void* arg) {
+    join_task_t* task = arg;
+    join_t* join = task->join;
+    const join_side_t* probe = &join->probe;
+    
+    if (reader_set_chunk_range(task->reader, task->first_chunk, task->end_chunk) != 0) {
+        task->result = -1;
+        return NULL;
+    }
+    
+    const uint8_t* row;
+    uint64_t null_fields;
+    while (task->result == 0 && !join_done(join) &&
+           (row = reader_next_row_bytes(task->reader, &null_fields)) != NULL) {
+        if (key_is_null(probe, null_fields)) {
+            continue; // Matches nothing
+        }
+        task->probe_rows++;
+        uint64_t hash = row_hash(probe, row);
+        if (join->partitions > 0) {
+            FILE* file = join->files[partition_of(join, hash)];
+            if (write_partition(probe, file, row, null_fields) != 0) {
+                fprintf(stderr, "Error: Cannot write join partition\n");
+                task->result = -1;
+            }
+        } else if (probe_row(join, task, &join->table, row, null_fields, hash) != 0) {
+            task->result = -1;
+        }
+    }
+    return NULL;
+}
+
+// Load a build partition into the thread's table, then stream its probe partition through it
+static int join_partition(join_t* join, join_task_t* task, uint32_t partition) {
+    size_t build_size = join->build.record_size;
+    size_t probe_size = join->probe.record_size;
+    uint8_t* record = malloc(build_size > probe_size ? build_size : probe_size);
+    FILE* file = record ? fopen(join->build_paths[partition], "rb") : NULL;
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open join partition %s\n", join->build_paths[partition]);
+        free(record);
+        return -1;
+    }
+    
+    int result = 0;
+    task->table.count = 0;
+    while (result == 0 && fread(record, build_size, 1, file) == 1) {
+        result = table_add(&task->table, &join->build, record, row_hash(&join->build, record + RECORD_HEADER));
+    }
+    fclose(file);
+    if (result == 0) {
+        result = table_index(&task->table);
+    }
+    
+    file = result == 0 ? fopen(join->probe_paths[partition], "rb") : NULL;
+    if (result == 0 && !file) {
+        fprintf(stderr, "Error: Cannot open join partition %s\n", join->probe_paths[partition]);
+        result = -1;
+    }
+    while (result == 0 && !join_done(join) && fread(record, probe_size, 1, file) == 1) {
+        uint64_t null_fields;
+        memcpy(&null_fields, record, sizeof(null_fields));
+        const uint8_t* row = record + RECORD_HEADER;
+        result = probe_row(join, task, &task->table, row, null_fields, row_hash(&join->probe, row));
+    }
+    if (file) {
+        fclose(file);
+    }
+    
+    remove(join->build_paths[partition]);
+    remove(join->probe_paths[partition]);
+    free(record);
+    return result;
+}
+
+// Take partitions until none are left
+static void* partition_main(void* arg) {
+    join_task_t* task = arg;
+    join_t* join = task->join;
+    while (task->result == 0 && !join_done(join)) {
+        uint32_t partition = __atomic_fetch_add(&join->next_partition, 1, __ATOMIC_RELAXED);
+        if (partition >= join->partitions) {
+            break;
+        }
+        task->result = join_partition(join, task, partition);
+    }
+    return NULL;
+}
+
+// Run tasks on threads; the calling thread takes the first itself, and a failed start falls back to it too
+static void run_tasks(join_task_t* tasks, uint32_t count, void* (*main)(void*)) {
+    pthread_t handles[FXDB_JOIN_MAX_THREADS];
+    bool started[FXDB_JOIN_MAX_THREADS] = { false };
+    for (uint32_t t = 1; t < count; t++) {
+        started[t] = pthread_create(&handles[t], NULL, main, &tasks[t]) == 0;
+    }
+    if (count > 0) {
+        main(&tasks[0]);
+    }
+    for (uint32_t t = 1; t < count; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        } else {
+            main(&tasks[t]);
+        }
+    }
+}
+
+// Split the probe table's chunks between threads, each with a reader of its own
+static uint32_t plan_scan(join_t* join, join_task_t* tasks) {
+    reader_t* reader = join->probe.reader;
+    uint32_t chunks = reader_chunk_count(reader);
+    uint32_t threads = join->options.threads < chunks ? join->options.threads : chunks;
+    if (threads == 0 || !reader->path) {
+        threads = 1;
+    }
+    
+    for (uint32_t t = 0; t < threads; t++) {
+        tasks[t].join = join;
+        tasks[t].first_chunk = (uint32_t)((uint64_t)chunks * t / threads);
+        tasks[t].end_chunk = (uint32_t)((uint64_t)chunks * (t + 1) / threads);
+        tasks[t].reader = reader;
+        if (t > 0) {
+            tasks[t].reader = reader_open(reader->path);
+            tasks[t].owns_reader = tasks[t].reader != NULL;
+            if (!tasks[t].reader) {
+                // Fewer threads then; the last one takes the rest of the chunks
+                tasks[t - 1].end_chunk = chunks;
+                return t;
+            }
+        }
+    }
+    tasks[threads - 1].end_chunk = chunks;
+    return threads;
+}
+
+// Scan the build table into the hash table
+static int build_table(join_t* join, fxdb_join_stats_t* stats) {
+    join_side_t* build = &join->build;
+    uint8_t* record = calloc(1, build->record_size);
+    if (!record) {
+        return -1;
+    }
+    
+    int result = 0;
+    const uint8_t* row;
+    uint64_t null_fields;
+    reader_rewind(build->reader);
+    while (result == 0 && (row = reader_next_row_bytes(build->reader, &null_fields)) != NULL) {
+        if (key_is_null(build, null_fields)) {
+            continue;
+        }
+        memcpy(record, &null_fields, sizeof(null_fields));
+        memcpy(record + RECORD_HEADER, row, build->schema->row_size);
+        result = table_add(&join->table, build, record, row_hash(build, row));
+        stats->build_rows++;
+    }
+    free(record);
+    return result == 0 ? table_index(&join->table) : -1;
+}
+
+// Name a partition file
+static char* partition_path(const join_t* join, char side, uint32_t partition) {
+    const char* prefix = join->options.temp_prefix ? join->options.temp_prefix : "flexon";
+    size_t length = strlen(prefix) + 48;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s.join%d-%c%u", prefix, (int)getpid(), side, partition);
+    }
+    return path;
+}
+
+// Open a file per partition for one side
+static int open_partitions(join_t* join, char** paths) {
+    for (uint32_t p = 0; p < join->partitions; p++) {
+        join->files[p] = fopen(paths[p], "wb");
+        if (!join->files[p]) {
+            fprintf(stderr, "Error: Cannot create join partition %s\n", paths[p]);
+            return -1;
+        }
+        setvbuf(join->files[p], NULL, _IOFBF, PARTITION_BUFFER_SIZE);
+    }
+    return 0;
+}
+
+// Close the partition files, counting what was written
+static int close_partitions(join_t* join, fxdb_join_stats_t* stats) {
+    int result = 0;
+    for (uint32_t p = 0; p < join->partitions; p++) {
+        if (join->files[p]) {
+            long size = ftell(join->files[p]);
+            stats->bytes_spilled += size > 0 ? (uint64_t)size : 0;
+            if (fclose(join->files[p]) != 0) {
+                result = -1;
+            }
+            join->files[p] = NULL;
+        }
+    }
+    return result;
+}
+
+// Split the build table into partition files
+static int partition_build(join_t* join, fxdb_join_stats_t* stats) {
+    join_side_t* build = &join->build;
+    if (open_partitions(join, join->build_paths) != 0) {
+        return -1;
+    }
+    
+    int result = 0;
+    const uint8_t* row;
+    uint64_t null_fields;
+    reader_rewind(build->reader);
+    while (result == 0 && (row = reader_next_row_bytes(build->reader, &null_fields)) != NULL) {
+        if (key_is_null(build, null_fields)) {
+            continue;
+        }
+        FILE* file = join->files[partition_of(join, row_hash(build, row))];
+        result = write_partition(build, file, row, null_fields);
+        stats->build_rows++;
+    }
+    if (close_partitions(join, stats) != 0 || result != 0) {
+        fprintf(stderr, "Error: Cannot write join partition\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Remove partition files left by a failed join and free their names
+static void free_partitions(join_t* join) {
+    for (uint32_t p = 0; p < join->partitions; p++) {
+        if (join->files && join->files[p]) {
+            fclose(join->files[p]);
+        }
+        if (join->build_paths && join->build_paths[p]) {
+            remove(join->build_paths[p]);
+            free(join->build_paths[p]);
+        }
+        if (join->probe_paths && join->probe_paths[p]) {
+            remove(join->probe_paths[p]);
+            free(join->probe_paths[p]);
+        }
+    }
+    free(join->files);
+    free(join->build_paths);
+    free(join->probe_paths);
+}
+
+// Enough partitions that each fits a thread's share of the budget
+static uint32_t partition_count(uint64_t build_bytes, const fxdb_join_options_t* options) {
+    uint64_t share = options->memory_limit / options->threads;
+    uint32_t partitions = 2;
+    while (partitions < FXDB_JOIN_MAX_PARTITIONS && (uint64_t)partitions * share < build_bytes) {
+        partitions <<= 1;
+    }
+    return partitions;
+}
+
+// Schema of joined rows: the left fields, then the right ones, each named after its table
+static schema_t* joined_schema(fxdb_arena_t* arena, const join_side_t* left, const char* left_name,
+                               const join_side_t* right, const char* right_name) {
+    schema_t* schema = fxdb_arena_calloc(arena, 1, sizeof(schema_t));
+    if (!schema) {
+        return NULL;
+    }
+    const join_side_t* sides[2] = { left, right };
+    const char* names[2] = { left_name ? left_name : "left", right_name ? right_name : "right" };
+    for (int s = 0; s < 2; s++) {
+        for (uint32_t i = 0; i < sides[s]->schema->field_count; i++) {
+            field_def_t* field = &schema->fields[schema->field_count++];
+            *field = sides[s]->schema->fields[i];
+            int length = snprintf(field->name, sizeof(field->name), "%s.%s", names[s], sides[s]->schema->fields[i].name);
+            if (length < 0) {
+                field->name[0] = '\0';
+            }
+        }
+    }
+    schema->row_size = left->schema->row_size + right->schema->row_size;
+    return schema;
+}
+
+// Decode the threads' rows into one result, in task order
+static query_result_t* collect_rows(const join_t* join, const join_task_t* tasks, uint32_t count,
+                                    const char* left_name, const char* right_name) {
+    uint64_t rows = 0;
+    for (uint32_t t = 0; t < count; t++) {
+        rows += tasks[t].output.count;
+    }
+    if (rows > UINT32_MAX) {
+        fprintf(stderr, "Error: Join produced too many rows\n");
+        return NULL;
+    }
+    
+    fxdb_arena_t* arena = fxdb_arena_create(0);
+    query_result_t* result = arena ? fxdb_arena_calloc(arena, 1, sizeof(query_result_t)) : NULL;
+    if (!result) {
+        fxdb_arena_destroy(arena);
+        return NULL;
+    }
+    result->arena = arena;
+    
+    const join_side_t* left = join->build_left ? &join->build : &join->probe;
+    const join_side_t* right = join->build_left ? &join->probe : &join->build;
+    schema_t* schema = joined_schema(arena, left, left_name, right, right_name);
+    result->schema = schema;
+    result->rows = rows > 0 ? fxdb_arena_alloc(arena, rows * sizeof(row_data_t)) : NULL;
+    if (!schema || (rows > 0 && !result->rows)) {
+        fxdb_arena_destroy(arena);
+        return NULL;
+    }
+    
+    for (uint32_t t = 0; t < count; t++) {
+        const join_output_t* output = &tasks[t].output;
+        for (uint64_t i = 0; i < output->count; i++) {
+            const uint8_t* record = output->data + i * join->output_size;
+            uint64_t null_fields;
+            memcpy(&null_fields, record, sizeof(null_fields));
+            if (reader_decode_row_into(schema, record + RECORD_HEADER, null_fields, arena,
+                                       &result->rows[result->row_count]) != 0) {
+                fxdb_arena_destroy(arena);
+                return NULL;
+            }
+            result->row_count++;
+        }
+    }
+    return result;
+}
+
+// Create default join options
+fxdb_join_options_t fxdb_join_default_options(void) {
+    fxdb_join_options_t options = {
+        .memory_limit = 0,
+        .threads = 0,
+        .limit = 0,
+        .temp_prefix = NULL
+    };
+    return options;
+}
+
+// Join two tables on one field each
+query_result_t* fxdb_hash_join(reader_t* left, const char* left_name, uint32_t left_field,
+                               reader_t* right, const char* right_name, uint32_t right_field,
+                               const fxdb_join_options_t* options, fxdb_join_stats_t* stats) {
+    if (!left || !right || !options) {
+        return NULL;
+    }
+    if (left_field >= left->schema->field_count || right_field >= right->schema->field_count) {
+        fprintf(stderr, "Error: Join field out of range\n");
+        return NULL;
+    }
+    if (left->schema->fields[left_field].type != right->schema->fields[right_field].type) {
+        fprintf(stderr, "Error: Cannot join %s with %s: the fields have different types\n",
+                left->schema->fields[left_field].name, right->schema->fields[right_field].name);
+        return NULL;
+    }
+    if (left->schema->field_count + right->schema->field_count > MAX_COLUMNS) {
+        fprintf(stderr, "Error: A join row cannot hold more than %d fields\n", MAX_COLUMNS);
+        return NULL;
+    }
+    
+    fxdb_join_stats_t local_stats;
+    if (!stats) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    
+    join_t join;
+    memset(&join, 0, sizeof(join));
+    join.options = *options;
+    if (join.options.memory_limit == 0) {
+        join.options.memory_limit = FXDB_JOIN_DEFAULT_MEMORY;
+    }
+    if (join.options.threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        join.options.threads = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (join.options.threads > FXDB_JOIN_MAX_THREADS) {
+        join.options.threads = FXDB_JOIN_MAX_THREADS;
+    }
+    
+    // The smaller table is the build side
+    uint64_t left_bytes = (uint64_t)reader_get_row_count(left) * left->schema->row_size;
+    uint64_t right_bytes = (uint64_t)reader_get_row_count(right) * right->schema->row_size;
+    join.build_left = left_bytes <= right_bytes;
+    init_side(&join.build, join.build_left ? left : right, join.build_left ? left_field : right_field);
+    init_side(&join.probe, join.build_left ? right : left, join.build_left ? right_field : left_field);
+    join.left_fields = left->schema->field_count;
+    join.output_size = (RECORD_HEADER + left->schema->row_size + right->schema->row_size + 7) & ~(size_t)7;
+    stats->build_left = join.build_left;
+    
+    uint64_t build_bytes = (uint64_t)reader_get_row_count(join.build.reader) * table_row_bytes(&join.build);
+    if (build_bytes > join.options.memory_limit) {
+        join.partitions = partition_count(build_bytes, &join.options);
+        join.files = calloc(join.partitions, sizeof(FILE*));
+        join.build_paths = calloc(join.partitions, sizeof(char*));
+        join.probe_paths = calloc(join.partitions, sizeof(char*));
+        bool named = join.files && join.build_paths && join.probe_paths;
+        for (uint32_t p = 0; named && p < join.partitions; p++) {
+            join.build_paths[p] = partition_path(&join, 'b', p);
+            join.probe_paths[p] = partition_path(&join, 'p', p);
+            named = join.build_paths[p] && join.probe_paths[p];
+        }
+        if (!named) {
+            free_partitions(&join);
+            return NULL;
+        }
+    }
+    stats->partitions = join.partitions > 0 ? join.partitions : 1;
+    
+    // Build: hash the build table, or split both tables into partitions
+    uint64_t ticks = fxdb_ticks();
+    join_task_t tasks[FXDB_JOIN_MAX_THREADS];
+    memset(tasks, 0, sizeof(tasks));
+    uint32_t task_count = 0;
+    int result = join.partitions > 0 ? partition_build(&join, stats) : build_table(&join, stats);
+    if (result == 0 && join.partitions > 0) {
+        result = open_partitions(&join, join.probe_paths);
+    }
+    if (result == 0) {
+        task_count = plan_scan(&join, tasks);
+    }
+    if (result == 0 && join.partitions > 0) {
+        run_tasks(tasks, task_count, scan_main);
+        if (close_partitions(&join, stats) != 0) {
+            fprintf(stderr, "Error: Cannot write join partition\n");
+            result = -1;
+        }
+    }
+    stats->build_ms = fxdb_ticks_to_ns(fxdb_ticks() - ticks) / 1e6;
+    
+    // Probe: scan the probe table against the hash table, or join the partitions
+    ticks = fxdb_ticks();
+    if (result == 0) {
+        run_tasks(tasks, task_count, join.partitions > 0 ? partition_main : scan_main);
+    }
+    stats->probe_ms = fxdb_ticks_to_ns(fxdb_ticks() - ticks) / 1e6;
+    stats->threads = task_count;
+    
+    query_result_t* joined = NULL;
+    for (uint32_t t = 0; t < task_count; t++) {
+        result = tasks[t].result != 0 ? -1 : result;
+        stats->probe_rows += tasks[t].probe_rows;
+    }
+    if (result == 0) {
+        joined = collect_rows(&join, tasks, task_count, left_name, right_name);
+    }
+    if (joined) {
+        stats->rows = joined->row_count;
+    }
+    
+    for (uint32_t t = 0; t < task_count; t++) {
+        if (tasks[t].owns_reader) {
+            reader_close(tasks[t].reader);
+        }
+        free(tasks[t].output.data);
+        table_free(&tasks[t].table);
+    }
+    table_free(&join.table);
+    free_partitions(&join);
+    reader_set_chunk_range(left, 0, 0);
+    reader_set_chunk_range(right, 0, 0);
+    return joined;
+}
@@ -0,0 +1,394 @@
+#include "../../include/query.h"
+#include "../../include/stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Share of rows an equality filter is assumed to keep, without column statistics
+#define EQUALITY_SELECTIVITY 0.1
+
+static const char* access_names[] = { "full scan" };
+static const char* op_names[] = { "Scan", "Filter", "Limit", "Sort", "Top-N" };
+
+// Write "field = value" for a filter
+static void describe_filter(const schema_t* schema, const query_t* query, char* buffer, size_t size) {
+    const field_def_t* field = &schema->fields[query->filter_field];
+    const field_value_t* value = &query->filter_value;
+    if (value->is_null) {
+        snprintf(buffer, size, "%s = null", field->name);
+        return;
+    }
+    
+    switch (field->type) {
+        case FIELD_TYPE_INT32:
+            snprintf(buffer, size, "%s = %d", field->name, value->value.int32_val);
+            break;
+        case FIELD_TYPE_FLOAT:
+            snprintf(buffer, size, "%s = %g", field->name, value->value.float_val);
+            break;
+        case FIELD_TYPE_BOOL:
+            snprintf(buffer, size, "%s = %s", field->name, value->value.bool_val ? "true" : "false");
+            break;
+        case FIELD_TYPE_STRING:
+            snprintf(buffer, size, "%s = '%s'", field->name, value->value.string_val ? value->value.string_val : "");
+            break;
+        default:
+            snprintf(buffer, size, "%s = ?", field->name);
+            break;
+    }
+}
+
+// A limited sort keeps a heap when its rows fit the sort memory
+static bool uses_heap(const schema_t* schema, const query_t* query) {
+    size_t memory = query->sort_memory ? query->sort_memory : FXDB_SORT_DEFAULT_MEMORY;
+    return query->limit > 0 && (uint64_t)query->limit * fxdb_sort_row_bytes(schema) <= memory;
+}
+
+// List the sources with a load, in reader_source_t order; false if there are none
+static bool describe_sources(const uint64_t* loads, char* buffer, size_t size) {
+    size_t used = 0;
+    buffer[0] = '\0';
+    for (int s = 0; s < READER_SOURCE_COUNT; s++) {
+        if (loads[s] > 0 && used < size) {
+            used += (size_t)snprintf(buffer + used, size - used, "%s%s", used ? " + " : "",
+                                     reader_source_name((reader_source_t)s));
+        }
+    }
+    return used > 0;
+}
+
+// Describe the scan operator from the plan's source and chunk counts
+static void describe_scan(query_plan_t* plan) {
+    query_operator_t* scan = &plan->operators[plan->operator_count - 1];
+    snprintf(scan->detail, sizeof(scan->detail), "%s, %u of %u chunks",
+             plan->source, plan->estimated_chunks, plan->chunk_count);
+}
+
+static query_operator_t* add_operator(query_plan_t* plan, query_op_type_t type, uint64_t estimated_rows) {
+    query_operator_t* op = &plan->operators[plan->operator_count++];
+    op->type = type;
+    op->estimated_rows = estimated_rows;
+    return op;
+}
+
+// Describe how a query would run
+int query_plan(const reader_t* reader, const query_t* query, query_plan_t* plan) {
+    if (!reader || !query || !plan) {
+        return -1;
+    }
+    if (query->has_filter && query->filter_field >= reader->schema->field_count) {
+        fprintf(stderr, "Error: Filter field %u out of range\n", query->filter_field);
+        return -1;
+    }
+    if (query->has_order && query->order_field >= reader->schema->field_count) {
+        fprintf(stderr, "Error: Order field %u out of range\n", query->order_field);
+        return -1;
+    }
+    
+    memset(plan, 0, sizeof(*plan));
+    plan->access = QUERY_ACCESS_FULL_SCAN;
+    
+    // Committed chunks come from one path; a plain reader's may also be cache hits
+    uint64_t sources[READER_SOURCE_COUNT] = { 0 };
+    if (reader->header.chunk_count > 0) {
+        if (reader->map) {
+            sources[READER_SOURCE_MMAP] = 1;
+        } else if (reader->direct_buffer) {
+            sources[READER_SOURCE_DIRECT] = 1;
+        } else {
+            sources[READER_SOURCE_FILE] = sources[READER_SOURCE_CACHE] = 1;
+        }
+    }
+    sources[READER_SOURCE_LOG] = reader->wal_rows > 0;
+    if (!describe_sources(sources, plan->source, sizeof(plan->source))) {
+        snprintf(plan->source, sizeof(plan->source), "none");
+    }
+    plan->chunk_count = reader->header.chunk_count + (reader->wal_rows > 0 ? 1 : 0);
+    
+    // Without a filter or a sort, a limit stops the scan after its rows' chunks
+    uint64_t live_rows = reader_get_row_count(reader);
+    uint64_t scan_rows = live_rows;
+    plan->estimated_chunks = plan->chunk_count;
+    if (!query->has_filter && !query->has_order && query->limit > 0 && query->limit < live_rows) {
+        uint32_t chunk_size = reader->header.chunk_size ? reader->header.chunk_size : 1;
+        uint32_t chunks = (query->limit + chunk_size - 1) / chunk_size;
+        scan_rows = query->limit;
+        plan->estimated_chunks = chunks < plan->chunk_count ? chunks : plan->chunk_count;
+    }
+    
+    uint64_t filter_rows = scan_rows;
+    if (query->has_filter) {
+        bool is_bool = reader->schema->fields[query->filter_field].type == FIELD_TYPE_BOOL;
+        filter_rows = is_bool ? scan_rows / 2 : (uint64_t)(scan_rows * EQUALITY_SELECTIVITY + 0.5);
+    }
+    
+    uint64_t limit_rows = query->limit > 0 && query->limit < filter_rows ? query->limit : filter_rows;
+    bool heap = query->has_order && uses_heap(reader->schema, query);
+    if (query->limit > 0 && !heap) {
+        query_operator_t* limit = add_operator(plan, QUERY_OP_LIMIT, limit_rows);
+        snprintf(limit->detail, sizeof(limit->detail), "%u rows", query->limit);
+    }
+    if (query->has_order) {
+        const char* name = reader->schema->fields[query->order_field].name;
+        const char* direction = query->order_desc ? "desc" : "asc";
+        if (heap) {
+            query_operator_t* top = add_operator(plan, QUERY_OP_TOP_N, limit_rows);
+            snprintf(top->detail, sizeof(top->detail), "%s %s, %u rows", name, direction, query->limit);
+        } else {
+            size_t memory = query->sort_memory ? query->sort_memory : FXDB_SORT_DEFAULT_MEMORY;
+            bool spills = filter_rows * fxdb_sort_row_bytes(reader->schema) > memory;
+            query_operator_t* sort = add_operator(plan, QUERY_OP_SORT, filter_rows);
+            snprintf(sort->detail, sizeof(sort->detail), "%s %s, %s", name, direction,
+                     spills ? "external merge" : "in memory");
+        }
+    }
+    if (query->has_filter) {
+        query_operator_t* filter = add_operator(plan, QUERY_OP_FILTER, filter_rows);
+        describe_filter(reader->schema, query, filter->detail, sizeof(filter->detail));
+    }
+    add_operator(plan, QUERY_OP_SCAN, scan_rows);
+    describe_scan(plan);
+    return 0;
+}
+
+// Append a row to a result whose rows live in its arena
+static int append_row(query_result_t* result, uint32_t* capacity, const row_data_t* row) {
+    if (result->row_count == *capacity) {
+        // The old array stays in the arena; doubling bounds what is left behind
+        uint32_t new_capacity = *capacity ? *capacity * 2 : 64;
+        row_data_t* rows = fxdb_arena_alloc(result->arena, new_capacity * sizeof(row_data_t));
+        if (!rows) {
+            return -1;
+        }
+        if (result->row_count > 0) {
+            memcpy(rows, result->rows, result->row_count * sizeof(row_data_t));
+        }
+        result->rows = rows;
+        *capacity = new_capacity;
+    }
+    
+    result->rows[result->row_count++] = *row;
+    return 0;
+}
+
+// Fill in what the run did from the counters taken before and after it
+static void finish_profile(query_profile_t* profile, const reader_t* reader, const uint64_t* loads_before,
+                           const db_statistics_t* before, const fxdb_thread_busy_t* busy_before,
+                           uint32_t busy_before_count, double total_ms) {
+    db_statistics_t after;
+    fxdb_get_statistics(&after);
+    
+    // Name the sources the scan's chunks actually came from
+    uint64_t loads[READER_SOURCE_COUNT];
+    for (int s = 0; s < READER_SOURCE_COUNT; s++) {
+        loads[s] = reader->source_loads[s] - loads_before[s];
+    }
+    if (describe_sources(loads, profile->plan.source, sizeof(profile->plan.source))) {
+        describe_scan(&profile->plan);
+    }
+    
+    uint64_t chunks_read = after.chunks_loaded - before->chunks_loaded;
+    profile->chunks_read = (uint32_t)chunks_read;
+    profile->chunks_skipped = chunks_read < profile->plan.chunk_count
+                            ? profile->plan.chunk_count - (uint32_t)chunks_read : 0;
+    profile->bytes_read = after.bytes_read - before->bytes_read;
+    profile->io_ms = after.read_io_time - before->read_io_time;
+    profile->decode_ms = after.decode_time - before->decode_time;
+    profile->total_ms = total_ms;
+    
+    // Threads that worked during the run; new threads started from zero
+    fxdb_thread_busy_t busy[QUERY_MAX_THREADS];
+    uint32_t busy_count = fxdb_get_thread_busy(busy, QUERY_MAX_THREADS);
+    profile->thread_count = 0;
+    for (uint32_t i = 0; i < busy_count; i++) {
+        uint64_t start = 0;
+        for (uint32_t j = 0; j < busy_before_count; j++) {
+            if (busy_before[j].thread_id == busy[i].thread_id) {
+                start = busy_before[j].busy_ns;
+                break;
+            }
+        }
+        if (busy[i].busy_ns <= start) {
+            continue;
+        }
+        
+        query_thread_t* thread = &profile->threads[profile->thread_count++];
+        thread->thread_id = busy[i].thread_id;
+        thread->busy_ms = (busy[i].busy_ns - start) / 1e6;
+        thread->utilization = total_ms > 0 ? thread->busy_ms / total_ms : 0.0;
+    }
+}
+
+// Run a query from the reader's first row
+int64_t query_execute(reader_t* reader, const query_t* query, query_result_t** result, query_profile_t* profile) {
+    if (result) {
+        *result = NULL;
+    }
+    
+    query_plan_t local_plan;
+    query_plan_t* plan = profile ? &profile->plan : &local_plan;
+    if (query_plan(reader, query, plan) != 0) {
+        return -1;
+    }
+    
+    // Kept rows are decoded into the result's arena, the others into pooled buffers
+    query_result_t* out = NULL;
+    uint32_t capacity = 0;
+    if (result) {
+        fxdb_arena_t* arena = fxdb_arena_create(0);
+        out = arena ? fxdb_arena_calloc(arena, 1, sizeof(query_result_t)) : NULL;
+        if (!out) {
+            fxdb_arena_destroy(arena);
+            return -1;
+        }
+        out->schema = reader->schema;
+        out->arena = arena;
+    }
+    
+    db_statistics_t before;
+    uint64_t loads_before[READER_SOURCE_COUNT];
+    fxdb_thread_busy_t busy_before[QUERY_MAX_THREADS];
+    uint32_t busy_before_count = 0;
+    uint64_t start_ns = 0;
+    if (profile) {
+        fxdb_get_statistics(&before);
+        memcpy(loads_before, reader->source_loads, sizeof(loads_before));
+        busy_before_count = fxdb_get_thread_busy(busy_before, QUERY_MAX_THREADS);
+        memset(&profile->sort, 0, sizeof(profile->sort));
+        start_ns = fxdb_stats_clock();
+    }
+    
+    // An ordered query hands the matching rows to a sorter and returns them from it
+    fxdb_sorter_t* sorter = NULL;
+    if (query->has_order) {
+        fxdb_sort_options_t options = fxdb_sort_default_options(query->order_field);
+        options.descending = query->order_desc;
+        options.top_n = uses_heap(reader->schema, query) ? query->limit : 0;
+        options.memory_limit = query->sort_memory;
+        options.temp_prefix = reader->path;
+        sorter = fxdb_sorter_create(reader->schema, &options);
+        if (!sorter) {
+            reader_free_result(out);
+            return -1;
+        }
+    }
+    
+    const field_def_t* filter_field = query->has_filter ? &reader->schema->fields[query->filter_field] : NULL;
+    uint64_t scanned = 0, matched = 0, produced = 0;
+    uint64_t scan_ticks = 0, filter_ticks = 0, sort_ticks = 0;
+    int failed = 0;
+    reader_rewind(reader);
+    while (sorter || query->limit == 0 || matched < query->limit) {
+        row_data_t decoded;
+        row_data_t* row;
+        fxdb_arena_mark_t mark = { NULL, NULL, NULL };
+        bool into_result = out && !sorter;
+        uint64_t ticks = profile ? fxdb_ticks() : 0;
+        if (into_result) {
+            mark = fxdb_arena_mark(out->arena);
+            row = reader_read_row_into(reader, out->arena, &decoded) == 0 ? &decoded : NULL;
+        } else {
+            row = reader_read_row_pooled(reader);
+        }
+        if (profile) {
+            scan_ticks += fxdb_ticks() - ticks;
+        }
+        if (!row) {
+            break;
+        }
+        scanned++;
+        
+        bool match = true;
+        if (filter_field) {
+            ticks = profile ? fxdb_ticks() : 0;
+            match = reader_values_equal(filter_field, &row->values[query->filter_field], &query->filter_value);
+            if (profile) {
+                filter_ticks += fxdb_ticks() - ticks;
+            }
+        }
+        
+        if (match && sorter) {
+            ticks = profile ? fxdb_ticks() : 0;
+            uint64_t null_fields;
+            const uint8_t* bytes = reader_row_bytes(reader, &null_fields);
+            failed = !bytes || fxdb_sorter_add(sorter, bytes, null_fields) != 0;
+            if (profile) {
+                sort_ticks += fxdb_ticks() - ticks;
+            }
+        }
+        
+        if (!into_result) {
+            reader_release_row(reader, row);
+        } else if (!match) {
+            fxdb_arena_rewind(out->arena, mark);
+        } else {
+            failed = append_row(out, &capacity, row) != 0;
+        }
+        if (failed) {
+            break;
+        }
+        matched += match ? 1 : 0;
+    }
+    
+    if (!sorter) {
+        produced = matched;
+    } else if (!failed) {
+        // Rows come out of the sorter in order until the limit
+        uint64_t ticks = profile ? fxdb_ticks() : 0;
+        failed = fxdb_sorter_finish(sorter) != 0;
+        while (!failed && (query->limit == 0 || produced < query->limit)) {
+            const uint8_t* bytes;
+            uint64_t null_fields;
+            int has_row = fxdb_sorter_next(sorter, &bytes, &null_fields);
+            if (has_row <= 0) {
+                failed = has_row < 0;
+                break;
+            }
+            if (out) {
+                row_data_t row;
+                failed = reader_decode_row_into(reader->schema, bytes, null_fields, out->arena, &row) != 0 ||
+                         append_row(out, &capacity, &row) != 0;
+            }
+            produced++;
+        }
+        if (profile) {
+            sort_ticks += fxdb_ticks() - ticks;
+            fxdb_sorter_stats(sorter, &profile->sort);
+        }
+    }
+    fxdb_sorter_free(sorter);
+    if (failed) {
+        reader_free_result(out);
+        return -1;
+    }
+    
+    if (profile) {
+        for (uint32_t i = 0; i < plan->operator_count; i++) {
+            query_operator_t* op = &plan->operators[i];
+            op->rows = op->type == QUERY_OP_SCAN ? scanned : op->type == QUERY_OP_FILTER ? matched : produced;
+            op->time_ms = op->type == QUERY_OP_SCAN ? fxdb_ticks_to_ns(scan_ticks) / 1e6
+                        : op->type == QUERY_OP_FILTER ? fxdb_ticks_to_ns(filter_ticks) / 1e6
+                        : op->type == QUERY_OP_SORT || op->type == QUERY_OP_TOP_N ? fxdb_ticks_to_ns(sort_ticks) / 1e6
+                        : 0.0;
+        }
+        profile->filter_ms = fxdb_ticks_to_ns(filter_ticks) / 1e6;
+        profile->sort_ms = fxdb_ticks_to_ns(sort_ticks) / 1e6;
+        finish_profile(profile, reader, loads_before, &before, busy_before, busy_before_count,
+                       (fxdb_stats_clock() - start_ns) / 1e6);
+    }
+    
+    if (result) {
+        *result = out;
+    }
+    return (int64_t)produced;
+}
+
+// Name of an access path
+const char* query_access_name(query_access_t access) {
+    return access <= QUERY_ACCESS_FULL_SCAN ? access_names[access] : "unknown";
+}
+
+// Name of an operator
+const char* query_op_name(query_op_type_t type) {
+    return type <= QUERY_OP_TOP_N ? op_names[type] : "unknown";
+}
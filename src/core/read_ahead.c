@@ -0,0 +1,285 @@
+#define _GNU_SOURCE
+#include "../../include/read_ahead.h"
+#include "../../include/stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+struct fxdb_read_ahead {
+    int fd;
+    uint64_t file_id;
+    uint32_t generation;
+    uint32_t chunk_size;        // Largest row count a chunk header may hold
+    size_t capacity;            // Largest payload a chunk header may hold
+    uint8_t* buffer;            // Payload being read by an I/O thread
+    
+    // Window, guarded by lock
+    pthread_mutex_t lock;
+    pthread_cond_t progress;    // Signalled after every chunk and when a pass ends
+    uint32_t depth;
+    uint32_t chunk_count;       // Committed chunks; the log's rows are never read ahead
+    uint32_t last_chunk;        // Chunk the reader loaded last
+    uint32_t next_chunk;        // Next chunk to fetch
+    long next_pos;              // Its header's file offset (0 when unknown)
+    uint32_t target;            // Fetch chunks below this
+    bool in_flight;             // Queued on or served by an I/O thread
+    struct fxdb_read_ahead* queue_next;
+};
+
+// I/O thread pool shared by every reader, started on first use
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+static fxdb_read_ahead_t* queue_head = NULL;
+static fxdb_read_ahead_t* queue_tail = NULL;
+static uint32_t pool_threads = 0;
+
+static bool read_fully(int fd, void* buffer, size_t size, long offset) {
+    size_t done = 0;
+    while (done < size) {
+        uint64_t start = fxdb_stats_clock();
+        ssize_t n = pread(fd, (uint8_t*)buffer + done, size - done, (off_t)(offset + (long)done));
+        fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - start);
+        fxdb_stats_add(FXDB_STAT_READ_CALLS, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        fxdb_stats_add(FXDB_STAT_BYTES_READ, (uint64_t)n);
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Fetch one chunk into the cache; returns the offset of the next chunk, 0 on failure
+static long fetch_chunk(fxdb_read_ahead_t* ahead, uint32_t chunk_index, long pos) {
+    fxdb_chunk_key_t key = { ahead->file_id, chunk_index, ahead->generation };
+    uint32_t size;
+    long payload_pos;
+    if (fxdb_chunk_cache_contains(&key, &size, &payload_pos)) {
+        return payload_pos + (long)size;
+    }
+    
+    uint32_t chunk_header[2];
+    if (!read_fully(ahead->fd, chunk_header, sizeof(chunk_header), pos) ||
+        chunk_header[0] > ahead->chunk_size || chunk_header[1] > ahead->capacity) {
+        return 0;
+    }
+    
+    payload_pos = pos + (long)sizeof(chunk_header);
+    if (!read_fully(ahead->fd, ahead->buffer, chunk_header[1], payload_pos)) {
+        return 0;
+    }
+    
+    // No room in the cache: reading further ahead would only evict
+    fxdb_cached_chunk_t* cached = fxdb_chunk_cache_insert(&key, ahead->buffer, chunk_header[1],
+                                                          chunk_header[0], payload_pos);
+    if (!cached) {
+        return 0;
+    }
+    fxdb_chunk_cache_release(cached);
+    return payload_pos + (long)chunk_header[1];
+}
+
+// Fill a reader's window, one chunk after the other
+static void fill_window(fxdb_read_ahead_t* ahead) {
+    pthread_mutex_lock(&ahead->lock);
+    for (;;) {
+        uint32_t chunk_index = ahead->next_chunk;
+        long pos = ahead->next_pos;
+        if (chunk_index >= ahead->target || chunk_index >= ahead->chunk_count || pos == 0) {
+            break;
+        }
+        pthread_mutex_unlock(&ahead->lock);
+        
+        long next_pos = fetch_chunk(ahead, chunk_index, pos);
+        
+        pthread_mutex_lock(&ahead->lock);
+        if (next_pos == 0) {
+            ahead->target = ahead->next_chunk; // Give up on this window
+        } else if (ahead->next_chunk == chunk_index) {
+            ahead->next_chunk = chunk_index + 1;
+            ahead->next_pos = next_pos;
+        }
+        pthread_cond_broadcast(&ahead->progress);
+    }
+    ahead->in_flight = false;
+    pthread_cond_broadcast(&ahead->progress);
+    pthread_mutex_unlock(&ahead->lock);
+}
+
+static void* io_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        while (!queue_head) {
+            pthread_cond_wait(&queue_ready, &queue_lock);
+        }
+        fxdb_read_ahead_t* ahead = queue_head;
+        queue_head = ahead->queue_next;
+        if (!queue_head) {
+            queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&queue_lock);
+        
+        fill_window(ahead);
+    }
+    return NULL;
+}
+
+static void start_pool(void) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (uint32_t i = 0; i < FXDB_READ_AHEAD_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, io_thread, NULL) == 0) {
+            pool_threads++;
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Queue a window on the pool; called with ahead->lock held and in_flight clear
+static void submit(fxdb_read_ahead_t* ahead) {
+    pthread_once(&pool_once, start_pool);
+    if (pool_threads == 0) {
+        return;
+    }
+    
+    ahead->in_flight = true;
+    pthread_mutex_lock(&queue_lock);
+    ahead->queue_next = NULL;
+    if (queue_tail) {
+        queue_tail->queue_next = ahead;
+    } else {
+        queue_head = ahead;
+    }
+    queue_tail = ahead;
+    pthread_cond_signal(&queue_ready);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+// Create read-ahead for an open file
+fxdb_read_ahead_t* read_ahead_create(int fd, uint64_t file_id, uint32_t generation,
+                                     uint32_t chunk_size, size_t payload_capacity,
+                                     uint32_t chunk_count, uint32_t depth) {
+    if (fd < 0 || file_id == 0) {
+        return NULL;
+    }
+    
+    fxdb_read_ahead_t* ahead = calloc(1, sizeof(fxdb_read_ahead_t));
+    if (!ahead) {
+        return NULL;
+    }
+    ahead->buffer = malloc(payload_capacity ? payload_capacity : 1);
+    if (!ahead->buffer) {
+        free(ahead);
+        return NULL;
+    }
+    
+    ahead->fd = fd;
+    ahead->file_id = file_id;
+    ahead->generation = generation;
+    ahead->chunk_size = chunk_size;
+    ahead->capacity = payload_capacity;
+    ahead->depth = depth;
+    ahead->chunk_count = chunk_count;
+    ahead->last_chunk = UINT32_MAX;
+    pthread_mutex_init(&ahead->lock, NULL);
+    pthread_cond_init(&ahead->progress, NULL);
+    return ahead;
+}
+
+// Set how many chunks are read ahead
+void read_ahead_set_depth(fxdb_read_ahead_t* ahead, uint32_t depth) {
+    if (!ahead) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ahead->lock);
+    ahead->depth = depth;
+    if (depth == 0) {
+        ahead->target = ahead->next_chunk;
+    }
+    pthread_mutex_unlock(&ahead->lock);
+}
+
+// Let read-ahead reach newly committed chunks
+void read_ahead_set_chunk_count(fxdb_read_ahead_t* ahead, uint32_t chunk_count) {
+    if (!ahead) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ahead->lock);
+    ahead->chunk_count = chunk_count;
+    pthread_mutex_unlock(&ahead->lock);
+}
+
+// Wait until a chunk being read ahead is in the cache
+void read_ahead_wait(fxdb_read_ahead_t* ahead, uint32_t chunk_index) {
+    if (!ahead) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ahead->lock);
+    while (ahead->in_flight && ahead->next_chunk <= chunk_index && chunk_index < ahead->target) {
+        pthread_cond_wait(&ahead->progress, &ahead->lock);
+    }
+    pthread_mutex_unlock(&ahead->lock);
+}
+
+// Move the window past a loaded chunk on a sequential scan
+void read_ahead_advance(fxdb_read_ahead_t* ahead, uint32_t chunk_index, long next_chunk_pos) {
+    if (!ahead) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ahead->lock);
+    bool sequential = chunk_index == 0 || chunk_index == ahead->last_chunk + 1;
+    ahead->last_chunk = chunk_index;
+    if (!sequential || ahead->depth == 0 || fxdb_chunk_cache_get_budget() == 0) {
+        pthread_mutex_unlock(&ahead->lock);
+        return;
+    }
+    
+    // Behind the reader (first pass, or after a seek): restart right after it
+    if (ahead->next_chunk <= chunk_index || ahead->next_pos == 0) {
+        ahead->next_chunk = chunk_index + 1;
+        ahead->next_pos = next_chunk_pos;
+    }
+    
+    uint32_t target = chunk_index + 1 + ahead->depth;
+    if (target > ahead->target || ahead->target <= ahead->next_chunk) {
+        ahead->target = target;
+    }
+    if (!ahead->in_flight && ahead->next_chunk < ahead->target &&
+        ahead->next_chunk < ahead->chunk_count) {
+        submit(ahead);
+    }
+    pthread_mutex_unlock(&ahead->lock);
+}
+
+// Stop read-ahead, wait for its reads in flight and free it
+void read_ahead_destroy(fxdb_read_ahead_t* ahead) {
+    if (!ahead) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ahead->lock);
+    ahead->target = 0;
+    while (ahead->in_flight) {
+        pthread_cond_wait(&ahead->progress, &ahead->lock);
+    }
+    pthread_mutex_unlock(&ahead->lock);
+    
+    pthread_mutex_destroy(&ahead->lock);
+    pthread_cond_destroy(&ahead->progress);
+    free(ahead->buffer);
+    free(ahead);
+}
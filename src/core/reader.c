@@ -1,8 +1,23 @@
 #include "../../include/reader.h"
 #include "../../include/io_utils.h"
+#include "../../include/bitmap.h"
+#include "../../include/wal.h"
+#include "../../include/coord.h"
+#include "../../include/read_ahead.h"
+#include "../../include/stats.h"
+#include "../../include/summary.h"
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Times a reader re-reads header and log when a checkpoint moves the commit
+#define SNAPSHOT_RETRIES 8
+
+// Published sequences are even; this one never matches
+#define UNKNOWN_SEQUENCE 1
 
 // Load schema from file
 static schema_t* load_schema_from_file(FILE* file, const fxdb_header_t* header) {
@@ -54,8 +69,155 @@ static schema_t* load_schema_from_file(FILE* file, const fxdb_header_t* header)
     return schema;
 }
 
+// Bytes needed to hold the largest chunk the header allows, alignment padding included
+static size_t chunk_capacity(const reader_t* reader) {
+    size_t null_columns = fxdb_popcount64(reader->header.null_mask);
+    size_t padding = fxdb_header_aligned(&reader->header) ? FXDB_IO_ALIGNMENT - 1 : 0;
+    return (size_t)reader->header.chunk_size * reader->schema->row_size +
+           null_columns * fxdb_bitmap_words(reader->header.chunk_size) * sizeof(uint64_t) + padding;
+}
+
+// Chunks to scan: the file's chunks plus one for rows still in the log
+static uint32_t chunk_total(const reader_t* reader) {
+    return reader->header.chunk_count + (reader->wal_rows > 0 ? 1 : 0);
+}
+
+// One past the last chunk a scan covers
+static uint32_t scan_end(const reader_t* reader) {
+    uint32_t total = chunk_total(reader);
+    return reader->scan_end && reader->scan_end < total ? reader->scan_end : total;
+}
+
+// Rows stored in the file and the log, deleted ones included
+static uint32_t physical_rows(const reader_t* reader) {
+    return reader->header.total_rows + reader->wal_rows;
+}
+
+// Reload the deletion vectors for the current header
+static int load_deletes(reader_t* reader) {
+    fxdb_deletes_t* deletes = deletes_load(reader->path, &reader->header);
+    if (!deletes) {
+        return -1;
+    }
+    deletes_free(reader->deletes);
+    reader->deletes = deletes;
+    reader->chunk_deleted = NULL;
+    return 0;
+}
+
+// Replay the write-ahead log into wal_chunk, laid out like a chunk on disk
+static int load_wal(reader_t* reader) {
+    free(reader->wal_chunk);
+    reader->wal_chunk = NULL;
+    reader->wal_rows = 0;
+    
+    uint8_t* rows;
+    uint64_t* present;
+    uint32_t row_size = reader->schema->row_size;
+    int count = wal_replay(reader->path, &reader->header, row_size, &rows, &present);
+    if (count <= 0) {
+        return count;
+    }
+    
+    // Never more than one chunk: writers checkpoint a full log
+    uint32_t row_count = (uint32_t)count;
+    if (row_count > reader->header.chunk_size) {
+        fprintf(stderr, "Error: Write-ahead log of '%s' holds more than one chunk\n", reader->path);
+        free(rows);
+        free(present);
+        return -1;
+    }
+    
+    uint32_t words = fxdb_bitmap_words(row_count);
+    size_t row_bytes = (size_t)row_count * row_size;
+    size_t bitmap_bytes = (size_t)fxdb_popcount64(reader->header.null_mask) * words * sizeof(uint64_t);
+    reader->wal_chunk = calloc(1, row_bytes + bitmap_bytes + 1);
+    if (!reader->wal_chunk) {
+        free(rows);
+        free(present);
+        return -1;
+    }
+    
+    memcpy(reader->wal_chunk, rows, row_bytes);
+    uint64_t* validity = (uint64_t*)(reader->wal_chunk + row_bytes);
+    for (uint32_t r = 0; r < row_count; r++) {
+        uint64_t nullable = reader->header.null_mask;
+        for (uint32_t ordinal = 0; nullable; ordinal++) {
+            uint32_t field = (uint32_t)__builtin_ctzll(nullable);
+            if ((present[r] >> field) & 1) {
+                uint64_t word;
+                uint64_t* slot = validity + (size_t)ordinal * words + r / FXDB_BITMAP_WORD_BITS;
+                memcpy(&word, slot, sizeof(word));
+                word |= 1ULL << (r % FXDB_BITMAP_WORD_BITS);
+                memcpy(slot, &word, sizeof(word));
+            }
+            nullable &= nullable - 1;
+        }
+    }
+    
+    reader->wal_rows = row_count;
+    free(rows);
+    free(present);
+    return 0;
+}
+
+// Read the header at the start of the file, pinned to its newest commit
+static int read_header(FILE* file, fxdb_header_t* header) {
+    // Drop stdio's read buffer, which may hold an older header
+    if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0 ||
+        fread(header, sizeof(fxdb_header_t), 1, file) != 1) {
+        return -1;
+    }
+    fxdb_header_resolve(header);
+    return 0;
+}
+
+// Whether two headers describe the same file contents, up to appended chunks
+static bool same_layout(const fxdb_header_t* a, const fxdb_header_t* b) {
+    return a->magic == b->magic && a->generation == b->generation &&
+           a->schema_offset == b->schema_offset && a->data_offset == b->data_offset &&
+           a->chunk_size == b->chunk_size && a->null_mask == b->null_mask;
+}
+
+// Replay the log that belongs to the pinned commit
+// A checkpoint between reading the header and the log binds the log to a
+// newer commit, so it looks stale and its rows would go missing. The header
+// is read again afterwards; if the commit moved, pin the newer one and retry.
+static int load_committed_wal(reader_t* reader) {
+    for (int attempt = 0; ; attempt++) {
+        if (load_wal(reader) != 0) {
+            return -1;
+        }
+        
+        fxdb_header_t current;
+        if (attempt == SNAPSHOT_RETRIES || read_header(reader->file, &current) != 0 ||
+            !same_layout(&current, &reader->header) ||
+            (current.total_rows == reader->header.total_rows &&
+             current.chunk_count == reader->header.chunk_count)) {
+            return 0;
+        }
+        reader->header = current;
+    }
+}
+
+// Take the sequence of the published commit if it describes the snapshot just
+// read; otherwise leave it unknown so the next poll reports a change
+static void note_sequence(reader_t* reader) {
+    if (!reader->coord) {
+        reader->coord = coord_attach(reader->path, false);
+    }
+    
+    fxdb_commit_state_t state;
+    reader->coord_sequence = UNKNOWN_SEQUENCE;
+    if (reader->coord && coord_read(reader->coord, &state) == 0 &&
+        state.generation == reader->header.generation && state.total_rows == reader->header.total_rows &&
+        state.chunk_count == reader->header.chunk_count && state.wal_rows == reader->wal_rows) {
+        reader->coord_sequence = state.sequence;
+    }
+}
+
 // Open .fxdb file for reading
-reader_t* reader_open(const char* filename) {
+static reader_t* open_reader(const char* filename) {
     if (!filename) {
         return NULL;
     }
@@ -75,13 +237,14 @@ reader_t* reader_open(const char* filename) {
         return NULL;
     }
     
-    // Read header
+    // Read header, pinned to its newest commit
     if (fread(&reader->header, sizeof(fxdb_header_t), 1, reader->file) != 1) {
         fprintf(stderr, "Error: Cannot read file header\n");
         fclose(reader->file);
         free(reader);
         return NULL;
     }
+    fxdb_header_resolve(&reader->header);
     
     // Validate magic number
     if (reader->header.magic != FXDB_MAGIC_NUM) {
@@ -100,38 +263,81 @@ reader_t* reader_open(const char* filename) {
     }
     
     // Load schema
+    fxdb_op_timer_t timer = fxdb_op_begin();
     reader->schema = load_schema_from_file(reader->file, &reader->header);
+    fxdb_op_end(FXDB_LATENCY_SCHEMA_LOAD, "load_schema", NULL, timer);
     if (!reader->schema) {
         fprintf(stderr, "Error: Cannot load schema from file\n");
         fclose(reader->file);
         free(reader);
         return NULL;
     }
+    schema_apply_null_mask(reader->schema, reader->header.null_mask);
+    reader->file_id = fxdb_chunk_cache_file_id(reader->file);
+    
+    // Allocate chunk buffer (rows plus their validity bitmaps)
+    uint32_t null_columns = fxdb_popcount64(reader->header.null_mask);
+    uint32_t max_words = fxdb_bitmap_words(reader->header.chunk_size);
+    reader->chunk_buffer = malloc(chunk_capacity(reader));
+    reader->validity = null_columns ? calloc((size_t)null_columns * max_words, sizeof(uint64_t)) : NULL;
+    if (!reader->chunk_buffer || (null_columns && !reader->validity)) {
+        reader_close(reader);
+        return NULL;
+    }
     
-    // Allocate chunk buffer
-    reader->chunk_buffer = malloc(reader->header.chunk_size * reader->schema->row_size);
-    if (!reader->chunk_buffer) {
-        free_schema(reader->schema);
-        fclose(reader->file);
-        free(reader);
+    reader->path = strdup(filename);
+    if (!reader->path || load_committed_wal(reader) != 0) {
+        fprintf(stderr, "Error: Cannot replay write-ahead log of '%s'\n", filename);
+        reader_close(reader);
         return NULL;
     }
+    if (load_deletes(reader) != 0) {
+        fprintf(stderr, "Error: Cannot load deleted rows of '%s'\n", filename);
+        reader_close(reader);
+        return NULL;
+    }
+    note_sequence(reader);
     
+    reader->read_ahead = read_ahead_create(fileno(reader->file), reader->file_id, reader->header.generation,
+                                           reader->header.chunk_size, chunk_capacity(reader),
+                                           reader->header.chunk_count, FXDB_READ_AHEAD_CHUNKS);
     return reader;
 }
 
-// Load chunk at index
-int reader_load_chunk(reader_t* reader, uint32_t chunk_index) {
-    if (!reader || chunk_index >= reader->header.chunk_count) {
-        return -1;
+reader_t* reader_open(const char* filename) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    reader_t* reader = open_reader(filename);
+    fxdb_op_end(FXDB_LATENCY_OPEN, "reader_open", NULL, timer);
+    return reader;
+}
+
+// Unpin the current chunk; the next read reloads it
+static void release_chunk(reader_t* reader) {
+    fxdb_chunk_cache_release(reader->cached_chunk);
+    reader->cached_chunk = NULL;
+    reader->chunk_data = NULL;
+    reader->chunk_deleted = NULL;
+    reader->chunk_row_count = 0;
+}
+
+// Find the file offset of a chunk's header; committed chunks never move, so
+// the walk resumes after the last chunk read instead of starting over each time
+static int locate_chunk(reader_t* reader, uint32_t chunk_index, long* chunk_pos) {
+    if (chunk_index < reader->directory_count) {
+        *chunk_pos = reader->directory[chunk_index].data_start - (long)(2 * sizeof(uint32_t));
+        return 0;
     }
     
-    // Calculate chunk position
-    long chunk_pos = reader->header.data_offset;
+    long pos = reader->header.data_offset;
+    uint32_t i = 0;
+    if (reader->walk_pos != 0 && reader->walk_chunk <= chunk_index) {
+        pos = reader->walk_pos;
+        i = reader->walk_chunk;
+    }
     
     // Skip to target chunk
-    for (uint32_t i = 0; i < chunk_index; i++) {
-        if (fseek(reader->file, chunk_pos, SEEK_SET) != 0) {
+    for (; i < chunk_index; i++) {
+        if (fseek(reader->file, pos, SEEK_SET) != 0) {
             return -1;
         }
         
@@ -140,7 +346,28 @@ int reader_load_chunk(reader_t* reader, uint32_t chunk_index) {
             return -1;
         }
         
-        chunk_pos += sizeof(chunk_header) + chunk_header[1]; // header + data size
+        pos += sizeof(chunk_header) + chunk_header[1]; // header + data size
+    }
+    
+    *chunk_pos = pos;
+    return 0;
+}
+
+// Check a chunk header against the file's chunk size
+static int check_chunk_header(const reader_t* reader, uint32_t chunk_index, const uint32_t* chunk_header) {
+    if (chunk_header[0] > reader->header.chunk_size || chunk_header[1] > chunk_capacity(reader)) {
+        fprintf(stderr, "Error: Chunk %u exceeds the file's chunk size\n", chunk_index);
+        return -1;
+    }
+    return 0;
+}
+
+// Read a chunk from disk into the private buffer, returning its payload size
+static int read_chunk_from_file(reader_t* reader, uint32_t chunk_index, uint32_t* rows,
+                                uint32_t* data_size, long* data_start) {
+    long chunk_pos;
+    if (locate_chunk(reader, chunk_index, &chunk_pos) != 0) {
+        return -1;
     }
     
     // Read target chunk header
@@ -148,49 +375,531 @@ int reader_load_chunk(reader_t* reader, uint32_t chunk_index) {
         return -1;
     }
     
+    uint64_t start = fxdb_stats_clock();
     uint32_t chunk_header[2];
     if (fread(chunk_header, sizeof(uint32_t), 2, reader->file) != 2) {
         return -1;
     }
     
-    reader->chunk_row_count = chunk_header[0];
-    uint32_t chunk_data_size = chunk_header[1];
+    if (check_chunk_header(reader, chunk_index, chunk_header) != 0) {
+        return -1;
+    }
     
     // Read chunk data
-    if (fread(reader->chunk_buffer, 1, chunk_data_size, reader->file) != chunk_data_size) {
+    if (fread(reader->chunk_buffer, 1, chunk_header[1], reader->file) != chunk_header[1]) {
         return -1;
     }
+    fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_READ_CALLS, 1);
+    fxdb_stats_add(FXDB_STAT_BYTES_READ, sizeof(chunk_header) + chunk_header[1]);
+    
+    *rows = chunk_header[0];
+    *data_size = chunk_header[1];
+    *data_start = chunk_pos + sizeof(chunk_header);
+    reader->walk_chunk = chunk_index + 1;
+    reader->walk_pos = *data_start + chunk_header[1];
+    return 0;
+}
+
+// Read aligned blocks with direct I/O; returns bytes read, short only at the end of the file
+static ssize_t read_direct(int fd, uint8_t* buffer, size_t size, long offset) {
+    size_t done = 0;
+    while (done < size) {
+        uint64_t start = fxdb_stats_clock();
+        ssize_t n = pread(fd, buffer + done, size - done, (off_t)(offset + (long)done));
+        fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - start);
+        fxdb_stats_add(FXDB_STAT_READ_CALLS, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        fxdb_stats_add(FXDB_STAT_BYTES_READ, (uint64_t)n);
+        done += (size_t)n;
+        if (n == 0 || done % FXDB_IO_ALIGNMENT != 0) {
+            break; // End of file
+        }
+    }
+    return (ssize_t)done;
+}
+
+// Read a chunk with direct I/O into the aligned window, returning where its payload landed
+static const uint8_t* read_chunk_direct(reader_t* reader, uint32_t chunk_index, uint32_t* rows,
+                                        long* data_start) {
+    long chunk_pos;
+    if (locate_chunk(reader, chunk_index, &chunk_pos) != 0) {
+        return NULL;
+    }
     
-    reader->current_chunk = chunk_index;
-    reader->current_row = 0;
-    reader->chunk_data_start = chunk_pos + sizeof(chunk_header);
+    // The blocks holding the chunk header first; in the aligned layout the
+    // header starts its block and a chunk ends where the next block starts
+    long block = chunk_pos & ~(long)(FXDB_IO_ALIGNMENT - 1);
+    size_t head = (size_t)(chunk_pos - block);
+    size_t first = fxdb_align_up(head + 2 * sizeof(uint32_t), FXDB_IO_ALIGNMENT);
+    ssize_t got = read_direct(reader->direct_fd, reader->direct_buffer, first, block);
+    if (got < (ssize_t)(head + 2 * sizeof(uint32_t))) {
+        return NULL;
+    }
     
+    uint32_t chunk_header[2];
+    memcpy(chunk_header, reader->direct_buffer + head, sizeof(chunk_header));
+    if (check_chunk_header(reader, chunk_index, chunk_header) != 0) {
+        return NULL;
+    }
+    
+    // Then the rest of the payload, if it reaches past those blocks
+    size_t end = head + sizeof(chunk_header) + chunk_header[1];
+    if (end > (size_t)got) {
+        size_t total = fxdb_align_up(end, FXDB_IO_ALIGNMENT);
+        ssize_t rest = (size_t)got == first && total <= reader->direct_size
+                     ? read_direct(reader->direct_fd, reader->direct_buffer + first, total - first,
+                                   block + (long)first)
+                     : -1;
+        if (rest < 0 || first + (size_t)rest < end) {
+            return NULL;
+        }
+    }
+    
+    *rows = chunk_header[0];
+    *data_start = chunk_pos + sizeof(chunk_header);
+    reader->walk_chunk = chunk_index + 1;
+    reader->walk_pos = *data_start + chunk_header[1];
+    return reader->direct_buffer + head + sizeof(chunk_header);
+}
+
+// Read the header of the chunk at `pos`, from the mapping when there is one
+static int read_chunk_header_at(const reader_t* reader, long pos, uint32_t* chunk_header) {
+    if (reader->map) {
+        if ((size_t)pos + 2 * sizeof(uint32_t) > reader->map->file_size) {
+            return -1;
+        }
+        memcpy(chunk_header, (const uint8_t*)reader->map->mmap_data + pos, 2 * sizeof(uint32_t));
+        return 0;
+    }
+    
+    uint64_t start = fxdb_stats_clock();
+    ssize_t n = pread(fileno(reader->file), chunk_header, 2 * sizeof(uint32_t), (off_t)pos);
+    fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_READ_CALLS, 1);
+    fxdb_stats_add(FXDB_STAT_BYTES_READ, n > 0 ? (uint64_t)n : 0);
+    return n == (ssize_t)(2 * sizeof(uint32_t)) ? 0 : -1;
+}
+
+// Walk chunk headers into the directory until it holds `chunk_index`, or
+// until it holds the chunk with `row` when chunk_index is UINT32_MAX
+static int extend_directory(reader_t* reader, uint32_t chunk_index, uint32_t row) {
+    while (reader->directory_count < reader->header.chunk_count) {
+        uint32_t count = reader->directory_count;
+        const fxdb_chunk_entry_t* last = count ? &reader->directory[count - 1] : NULL;
+        if (last && (chunk_index == UINT32_MAX ? last->first_row + last->row_count > row
+                                               : count > chunk_index)) {
+            return 0;
+        }
+        
+        if (count == reader->directory_capacity) {
+            uint32_t capacity = reader->header.chunk_count;
+            fxdb_chunk_entry_t* grown = realloc(reader->directory, capacity * sizeof(fxdb_chunk_entry_t));
+            if (!grown) {
+                return -1;
+            }
+            reader->directory = grown;
+            reader->directory_capacity = capacity;
+            last = count ? &reader->directory[count - 1] : NULL;
+        }
+        
+        long pos = last ? last->data_start + (long)last->data_size : (long)reader->header.data_offset;
+        uint32_t chunk_header[2];
+        if (read_chunk_header_at(reader, pos, chunk_header) != 0 ||
+            check_chunk_header(reader, count, chunk_header) != 0) {
+            return -1;
+        }
+        
+        fxdb_chunk_entry_t* entry = &reader->directory[count];
+        entry->data_start = pos + (long)sizeof(chunk_header);
+        entry->data_size = chunk_header[1];
+        entry->row_count = chunk_header[0];
+        entry->first_row = last ? last->first_row + last->row_count : 0;
+        if (reader->map && (size_t)entry->data_start + entry->data_size > reader->map->file_size) {
+            fprintf(stderr, "Error: Chunk %u runs past the end of the file\n", count);
+            return -1;
+        }
+        reader->directory_count = count + 1;
+    }
     return 0;
 }
 
-// Deserialize row from buffer
-row_data_t* deserialize_row(const schema_t* schema, const uint8_t* buffer) {
-    if (!schema || !buffer) {
+// Point the current chunk into the mapping
+static const uint8_t* map_chunk(reader_t* reader, uint32_t chunk_index) {
+    if (extend_directory(reader, chunk_index, 0) != 0 || chunk_index >= reader->directory_count) {
         return NULL;
     }
     
-    row_data_t* row = calloc(1, sizeof(row_data_t));
-    if (!row) return NULL;
+    const fxdb_chunk_entry_t* entry = &reader->directory[chunk_index];
+    reader->chunk_row_count = entry->row_count;
+    reader->chunk_data_start = entry->data_start;
+    reader->walk_chunk = chunk_index + 1;
+    reader->walk_pos = entry->data_start + (long)entry->data_size;
+    
+    // Fault the chunk in here, so a mapped scan's bytes and I/O time are counted like reads
+    const volatile uint8_t* data = (const uint8_t*)reader->map->mmap_data + entry->data_start;
+    uint64_t fault_start = fxdb_stats_clock();
+    for (size_t offset = 0; offset < entry->data_size; offset += FXDB_IO_ALIGNMENT) {
+        (void)data[offset];
+    }
+    if (entry->data_size > 0) {
+        (void)data[entry->data_size - 1];
+    }
+    fxdb_stats_add(FXDB_STAT_BYTES_READ, 2 * sizeof(uint32_t) + entry->data_size);
+    
+    // Ask for the next chunks once the scan is halfway through the ones asked for last
+    if (reader->map_options.access == FXDB_MMAP_ACCESS_SEQUENTIAL &&
+        chunk_index + FXDB_READ_AHEAD_CHUNKS / 2 >= reader->map_prefetched) {
+        uint32_t first = chunk_index + 1 > reader->map_prefetched ? chunk_index + 1 : reader->map_prefetched;
+        uint32_t last = chunk_index + FXDB_READ_AHEAD_CHUNKS;
+        if (last >= reader->header.chunk_count) {
+            last = reader->header.chunk_count - 1;
+        }
+        if (first <= last && extend_directory(reader, last, 0) == 0 && last < reader->directory_count) {
+            long start = reader->directory[first].data_start - (long)(2 * sizeof(uint32_t));
+            long end = reader->directory[last].data_start + (long)reader->directory[last].data_size;
+            fxdb_mmap_prefetch(reader->map, (size_t)start, (size_t)(end - start));
+        }
+        reader->map_prefetched = last + 1;
+    }
+    fxdb_stats_add(FXDB_STAT_READ_NS, fxdb_stats_clock() - fault_start);
     
-    row->field_count = schema->field_count;
-    row->values = calloc(schema->field_count, sizeof(field_value_t));
-    if (!row->values) {
-        free(row);
-        return NULL;
+    return (const uint8_t*)reader->map->mmap_data + entry->data_start;
+}
+
+// Set how many chunks a sequential scan reads ahead
+void reader_set_read_ahead(reader_t* reader, uint32_t chunks) {
+    if (reader) {
+        read_ahead_set_depth(reader->read_ahead, chunks);
+    }
+}
+
+// Close the direct I/O descriptor and return the window to the pool
+static void stop_direct_io(reader_t* reader) {
+    if (reader->direct_buffer) {
+        close(reader->direct_fd);
+        fxdb_aligned_buffer_release(reader->direct_buffer, reader->direct_size);
+        reader->direct_buffer = NULL;
+        reader->direct_size = 0;
+    }
+}
+
+// Unmap the file
+static void stop_mmap(reader_t* reader) {
+    fxdb_mmap_reader_close(reader->map);
+    reader->map = NULL;
+    reader->map_prefetched = 0;
+}
+
+// Read chunks with direct I/O, around the page cache and the chunk cache
+int reader_set_direct_io(reader_t* reader, bool enable) {
+    if (!reader || !reader->path) {
+        return -1;
+    }
+    
+    // The current chunk may live in the window
+    release_chunk(reader);
+    stop_direct_io(reader);
+    if (!enable) {
+        return 0;
+    }
+    stop_mmap(reader);
+    
+    int fd = fxdb_open_direct(reader->path);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Direct I/O is not supported for '%s': %s\n", reader->path, strerror(errno));
+        return -1;
+    }
+    
+    // The path must still name the file this reader has open
+    struct stat direct, opened;
+    if (fstat(fd, &direct) != 0 || fstat(fileno(reader->file), &opened) != 0 ||
+        direct.st_dev != opened.st_dev || direct.st_ino != opened.st_ino) {
+        fprintf(stderr, "Error: '%s' was replaced since it was opened\n", reader->path);
+        close(fd);
+        return -1;
+    }
+    
+    // A chunk starting anywhere in a block, plus the blocks it spans
+    size_t size = fxdb_align_up(2 * sizeof(uint32_t) + chunk_capacity(reader), FXDB_IO_ALIGNMENT) +
+                  FXDB_IO_ALIGNMENT;
+    uint8_t* buffer = fxdb_aligned_buffer_acquire(size);
+    
+    // Some file systems accept O_DIRECT at open and only refuse the reads
+    if (!buffer || read_direct(fd, buffer, FXDB_IO_ALIGNMENT, 0) < 0) {
+        fprintf(stderr, "Error: Direct I/O is not supported for '%s': %s\n", reader->path,
+                buffer ? strerror(errno) : "out of memory");
+        fxdb_aligned_buffer_release(buffer, size);
+        close(fd);
+        return -1;
+    }
+    
+    reader->direct_fd = fd;
+    reader->direct_buffer = buffer;
+    reader->direct_size = size;
+    return 0;
+}
+
+// Map the file as far as the pinned snapshot reaches
+static int map_snapshot(reader_t* reader) {
+    stop_mmap(reader);
+    fxdb_mmap_reader_t* map = fxdb_mmap_reader_open_with_options(reader->path, &reader->map_options);
+    if (!map) {
+        fprintf(stderr, "Error: Cannot map '%s': %s\n", reader->path, strerror(errno));
+        return -1;
+    }
+    
+    // Too small to be worth a mapping
+    if (!map->is_mapped && map->file_size < FXDB_MIN_MMAP_SIZE) {
+        fxdb_mmap_reader_close(map);
+        return 0;
+    }
+    
+    // The path must still name the file this reader has open, with every committed chunk
+    struct stat mapped, opened;
+    if (!map->is_mapped || fstat(map->fd, &mapped) != 0 || fstat(fileno(reader->file), &opened) != 0 ||
+        mapped.st_dev != opened.st_dev || mapped.st_ino != opened.st_ino ||
+        map->file_size < (size_t)reader->header.data_offset + reader->header.data_size) {
+        fprintf(stderr, "Error: Cannot map '%s' as it was opened\n", reader->path);
+        fxdb_mmap_reader_close(map);
+        return -1;
+    }
+    
+    reader->map = map;
+    return 0;
+}
+
+// Read chunks straight out of a memory mapping of the file
+int reader_set_mmap(reader_t* reader, bool enable, const fxdb_mmap_options_t* options) {
+    if (!reader || !reader->path) {
+        return -1;
+    }
+    
+    // The current chunk may live in the mapping
+    release_chunk(reader);
+    stop_mmap(reader);
+    if (!enable) {
+        return 0;
+    }
+    
+    stop_direct_io(reader);
+    reader->map_options = options ? *options : fxdb_mmap_default_options();
+    return map_snapshot(reader);
+}
+
+// Position the reader before the first row
+void reader_rewind(reader_t* reader) {
+    if (!reader) {
+        return;
+    }
+    
+    release_chunk(reader);
+    reader->current_chunk = reader->scan_first;
+    reader->current_row = 0;
+}
+
+// Confine scans to a range of chunks
+int reader_set_chunk_range(reader_t* reader, uint32_t first, uint32_t end) {
+    if (!reader || (end != 0 && first > end)) {
+        return -1;
+    }
+    
+    reader->scan_first = end == 0 ? 0 : first;
+    reader->scan_end = end;
+    reader_rewind(reader);
+    return 0;
+}
+
+// Chunks a scan walks
+uint32_t reader_chunk_count(const reader_t* reader) {
+    return reader ? chunk_total(reader) : 0;
+}
+
+// Pick up rows committed since the reader was opened
+int reader_refresh(reader_t* reader) {
+    if (!reader || !reader->file) {
+        return -1;
     }
     
+    fxdb_header_t header;
+    if (read_header(reader->file, &header) != 0) {
+        return -1;
+    }
+    
+    // Compaction renames a new file over the path; this one is only kept for us
+    struct stat current, opened;
+    if (stat(reader->path, &current) != 0 || fstat(fileno(reader->file), &opened) != 0 ||
+        current.st_dev != opened.st_dev || current.st_ino != opened.st_ino) {
+        return -1;
+    }
+    
+    // Anything but appended chunks means the file was rewritten
+    if (!same_layout(&header, &reader->header)) {
+        return -1;
+    }
+    
+    reader->header = header;
+    read_ahead_set_chunk_count(reader->read_ahead, header.chunk_count);
+    reader_rewind(reader);
+    if (load_committed_wal(reader) != 0) {
+        return -1;
+    }
+    
+    // New chunks lie past the end of the mapping
+    if (reader->map && reader->map->file_size < (size_t)reader->header.data_offset + reader->header.data_size &&
+        map_snapshot(reader) != 0) {
+        return -1;
+    }
+    note_sequence(reader);
+    return load_deletes(reader);
+}
+
+// Check the published commit against the reader's snapshot
+int reader_poll(reader_t* reader, uint32_t* committed_rows) {
+    if (!reader) {
+        return -1;
+    }
+    
+    // The sidecar appears when a writer first opens the file
+    if (!reader->coord) {
+        reader->coord = coord_attach(reader->path, false);
+    }
+    
+    fxdb_commit_state_t state;
+    if (!reader->coord || coord_read(reader->coord, &state) != 0) {
+        return -1;
+    }
+    
+    if (committed_rows) {
+        *committed_rows = state.total_rows + state.wal_rows;
+    }
+    return state.sequence != reader->coord_sequence ? 1 : 0;
+}
+
+// Load chunk at index, through the shared chunk cache; `source` names where it came from
+static int load_chunk(reader_t* reader, uint32_t chunk_index, reader_source_t* source) {
+    if (!reader || chunk_index >= chunk_total(reader)) {
+        return -1;
+    }
+    
+    release_chunk(reader);
+    
+    fxdb_chunk_key_t key = { reader->file_id, chunk_index, reader->header.generation };
+    fxdb_cached_chunk_t* cached = NULL;
+    const uint8_t* direct = NULL;
+    bool read_ahead = !reader->direct_buffer && !reader->map;
+    if (chunk_index < reader->header.chunk_count && read_ahead) {
+        // A chunk being read ahead is waited for rather than read twice
+        read_ahead_wait(reader->read_ahead, chunk_index);
+    }
+    if (chunk_index == reader->header.chunk_count) {
+        // Rows still in the log; not cached, the next checkpoint moves them
+        *source = READER_SOURCE_LOG;
+        reader->chunk_row_count = reader->wal_rows;
+        reader->chunk_data_start = 0;
+    } else if (reader->map) {
+        // Decoded in place; the page cache is the only copy
+        *source = READER_SOURCE_MMAP;
+        direct = map_chunk(reader, chunk_index);
+        if (!direct) {
+            return -1;
+        }
+    } else if (reader->direct_buffer) {
+        // Neither the page cache nor the chunk cache keeps a one-shot scan's chunks
+        *source = READER_SOURCE_DIRECT;
+        uint32_t rows;
+        long data_start;
+        direct = read_chunk_direct(reader, chunk_index, &rows, &data_start);
+        if (!direct) {
+            return -1;
+        }
+        reader->chunk_row_count = rows;
+        reader->chunk_data_start = data_start;
+    } else if ((cached = fxdb_chunk_cache_lookup(&key)) != NULL) {
+        // Served from memory; the next chunk's header follows this payload
+        *source = READER_SOURCE_CACHE;
+        reader->chunk_row_count = cached->row_count;
+        reader->chunk_data_start = cached->file_offset;
+        reader->walk_chunk = chunk_index + 1;
+        reader->walk_pos = cached->file_offset + (long)cached->size;
+    } else {
+        *source = READER_SOURCE_FILE;
+        uint32_t rows, data_size;
+        long data_start;
+        if (read_chunk_from_file(reader, chunk_index, &rows, &data_size, &data_start) != 0) {
+            return -1;
+        }
+        
+        // Falls back to the private buffer when the cache has no room
+        cached = fxdb_chunk_cache_insert(&key, reader->chunk_buffer, data_size, rows, data_start);
+        reader->chunk_row_count = rows;
+        reader->chunk_data_start = data_start;
+    }
+    
+    reader->cached_chunk = cached;
+    reader->chunk_data = cached ? cached->data : direct ? direct : reader->chunk_buffer;
+    if (chunk_index == reader->header.chunk_count) {
+        reader->chunk_data = reader->wal_chunk;
+    }
+    
+    // Copy validity bitmaps out of the chunk so they are word aligned
+    reader->validity_words = fxdb_bitmap_words(reader->chunk_row_count);
+    if (reader->validity) {
+        size_t bitmap_bytes = (size_t)fxdb_popcount64(reader->header.null_mask) *
+                              reader->validity_words * sizeof(uint64_t);
+        memcpy(reader->validity,
+               reader->chunk_data + (size_t)reader->chunk_row_count * reader->schema->row_size,
+               bitmap_bytes);
+    }
+    
+    reader->chunk_deleted = deletes_chunk(reader->deletes, chunk_index);
+    reader->current_chunk = chunk_index;
+    reader->current_row = 0;
+    fxdb_stats_add(FXDB_STAT_CHUNKS_LOADED, 1);
+    reader->source_loads[*source]++;
+    
+    // Fetch the chunks after this one while it is decoded
+    if (chunk_index < reader->header.chunk_count && read_ahead) {
+        read_ahead_advance(reader->read_ahead, chunk_index, reader->walk_pos);
+    }
+    
+    return 0;
+}
+
+int reader_load_chunk(reader_t* reader, uint32_t chunk_index) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    reader_source_t source = READER_SOURCE_COUNT;
+    int result = load_chunk(reader, chunk_index, &source);
+    fxdb_op_end(FXDB_LATENCY_CHUNK_LOAD, "reader_load_chunk", reader_source_name(source), timer);
+    return result;
+}
+
+// Name of a chunk source
+const char* reader_source_name(reader_source_t source) {
+    static const char* names[READER_SOURCE_COUNT] = { "file", "cache", "mmap", "direct", "log" };
+    return source < READER_SOURCE_COUNT ? names[source] : NULL;
+}
+
+// Decode a row's fields into `values`; string fields are copied into
+// `strings` one after another, or into a malloc'd string each when it is NULL
+static int decode_values(const schema_t* schema, const uint8_t* buffer, field_value_t* values, char* strings) {
+    // One row in FXDB_STATS_DECODE_SAMPLE is timed, standing for the others
+    bool timed = fxdb_stats_sample_decode();
+    uint64_t start = timed ? fxdb_stats_clock() : 0;
+    uint64_t allocations = 0;
     uint32_t offset = 0;
     
     for (uint32_t i = 0; i < schema->field_count; i++) {
         const field_def_t* field = &schema->fields[i];
-        field_value_t* value = &row->values[i];
+        field_value_t* value = &values[i];
         
         value->field_name = field->name; // Point to schema field name
+        value->is_null = false;
         // Initialize string_val to NULL for all fields initially
         value->value.string_val = NULL;
         
@@ -211,14 +920,18 @@ row_data_t* deserialize_row(const schema_t* schema, const uint8_t* buffer) {
                 break;
                 
             case FIELD_TYPE_STRING: {
-                // Allocate and copy string
-                char* str = malloc(field->size);
+                // Copy the string, into the shared buffer or an allocation of its own
+                char* str = strings;
+                if (str) {
+                    strings += field->size;
+                } else {
+                    str = malloc(field->size);
+                    allocations++;
+                }
                 if (str) {
                     memcpy(str, buffer + offset, field->size);
                     str[field->size - 1] = '\0'; // Ensure null termination
                     value->value.string_val = str;
-                } else {
-                    value->value.string_val = NULL;
                 }
                 offset += field->size;
                 break;
@@ -226,76 +939,503 @@ row_data_t* deserialize_row(const schema_t* schema, const uint8_t* buffer) {
                 
             default:
                 fprintf(stderr, "Error: Unknown field type %d\n", field->type);
-                reader_free_row(row);
-                return NULL;
+                return -1;
+        }
+    }
+    
+    if (timed) {
+        fxdb_stats_add(FXDB_STAT_DECODE_NS, (fxdb_stats_clock() - start) * FXDB_STATS_DECODE_SAMPLE);
+    }
+    fxdb_stats_add(FXDB_STAT_ROWS_DECODED, 1);
+    if (allocations) {
+        fxdb_stats_add(FXDB_STAT_ALLOCATIONS, allocations);
+    }
+    return 0;
+}
+
+// Bytes the string fields of a row take when they share one buffer
+static size_t string_bytes(const schema_t* schema) {
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        if (schema->fields[i].type == FIELD_TYPE_STRING) {
+            bytes += schema->fields[i].size;
+        }
+    }
+    return bytes;
+}
+
+// Deserialize row from buffer
+row_data_t* deserialize_row(const schema_t* schema, const uint8_t* buffer) {
+    if (!schema || !buffer) {
+        return NULL;
+    }
+    
+    row_data_t* row = calloc(1, sizeof(row_data_t));
+    if (!row) return NULL;
+    
+    row->field_count = schema->field_count;
+    row->values = calloc(schema->field_count, sizeof(field_value_t));
+    if (!row->values) {
+        free(row);
+        return NULL;
+    }
+    fxdb_stats_add(FXDB_STAT_ALLOCATIONS, 2);
+    
+    if (decode_values(schema, buffer, row->values, NULL) != 0) {
+        for (uint32_t i = 0; i < schema->field_count; i++) {
+            if (schema->fields[i].type == FIELD_TYPE_STRING) {
+                free((char*)row->values[i].value.string_val);
+            }
+        }
+        reader_free_row(row);
+        return NULL;
+    }
+    return row;
+}
+
+// First row at or after `row` that is not deleted, a bitmap word at a time
+static uint32_t next_live_row(const reader_t* reader, uint32_t row) {
+    const uint64_t* deleted = reader->chunk_deleted;
+    if (!deleted) {
+        return row;
+    }
+    
+    while (row < reader->chunk_row_count) {
+        uint32_t word = row / FXDB_BITMAP_WORD_BITS;
+        uint64_t live = ~deleted[word] & (~0ULL << (row % FXDB_BITMAP_WORD_BITS));
+        if (live) {
+            row = word * FXDB_BITMAP_WORD_BITS + (uint32_t)__builtin_ctzll(live);
+            break;
         }
+        row = (word + 1) * FXDB_BITMAP_WORD_BITS;
+    }
+    return row < reader->chunk_row_count ? row : reader->chunk_row_count;
+}
+
+// Position at the next live row and return its bytes; NULL at the end
+static const uint8_t* next_row(reader_t* reader) {
+    // Load first chunk if needed
+    if (!reader->chunk_data) {
+        if (reader->current_chunk >= scan_end(reader)) {
+            return NULL; // Empty range
+        }
+        if (reader_load_chunk(reader, reader->current_chunk) != 0) {
+            return NULL;
+        }
+    }
+    
+    // Move on to the next chunk with a live row
+    reader->current_row = next_live_row(reader, reader->current_row);
+    while (reader->current_row >= reader->chunk_row_count) {
+        if (reader->current_chunk + 1 >= scan_end(reader)) {
+            return NULL; // EOF
+        }
+        
+        if (reader_load_chunk(reader, reader->current_chunk + 1) != 0) {
+            return NULL;
+        }
+        reader->current_row = next_live_row(reader, 0);
+    }
+    
+    return reader->chunk_data + (reader->current_row * reader->schema->row_size);
+}
+
+// Mark the NULL fields of the current row and step past it
+static void finish_row(reader_t* reader, field_value_t* values) {
+    uint64_t null_mask = reader->header.null_mask;
+    while (null_mask) {
+        uint32_t field = (uint32_t)__builtin_ctzll(null_mask);
+        values[field].is_null = !fxdb_bitmap_get(reader_chunk_validity(reader, field), reader->current_row);
+        null_mask &= null_mask - 1;
+    }
+    reader->current_row++;
+}
+
+// Read next row from file
+row_data_t* reader_read_row(reader_t* reader) {
+    if (!reader) return NULL;
+    
+    const uint8_t* row_buffer = next_row(reader);
+    if (!row_buffer) {
+        return NULL;
+    }
+    
+    // Deserialize current row
+    row_data_t* row = deserialize_row(reader->schema, row_buffer);
+    if (row) {
+        finish_row(reader, row->values);
+    }
+    
+    return row;
+}
+
+// Read the next row into a buffer from the reader's row pool
+row_data_t* reader_read_row_pooled(reader_t* reader) {
+    if (!reader) return NULL;
+    
+    // One buffer holds the row, its values and its strings
+    size_t values_size = reader->schema->field_count * sizeof(field_value_t);
+    if (reader->row_pool.object_size == 0) {
+        fxdb_slab_pool_init(&reader->row_pool, sizeof(row_data_t) + values_size + string_bytes(reader->schema), 0);
+    }
+    
+    const uint8_t* row_buffer = next_row(reader);
+    if (!row_buffer) {
+        return NULL;
+    }
+    
+    row_data_t* row = fxdb_slab_alloc(&reader->row_pool);
+    if (!row) {
+        return NULL;
+    }
+    row->field_count = reader->schema->field_count;
+    row->values = (field_value_t*)(row + 1);
+    if (decode_values(reader->schema, row_buffer, row->values, (char*)row->values + values_size) != 0) {
+        fxdb_slab_free(&reader->row_pool, row);
+        return NULL;
+    }
+    finish_row(reader, row->values);
+    return row;
+}
+
+// Return a row from reader_read_row_pooled to the pool
+void reader_release_row(reader_t* reader, row_data_t* row) {
+    if (reader && row) {
+        fxdb_slab_free(&reader->row_pool, row);
+    }
+}
+
+// Decode row bytes, allocating the values and strings from an arena
+static field_value_t* decode_into(const schema_t* schema, const uint8_t* buffer, fxdb_arena_t* arena, row_data_t* row) {
+    size_t values_size = schema->field_count * sizeof(field_value_t);
+    field_value_t* values = fxdb_arena_alloc(arena, values_size + string_bytes(schema));
+    if (!values || decode_values(schema, buffer, values, (char*)values + values_size) != 0) {
+        return NULL;
+    }
+    row->field_count = schema->field_count;
+    row->values = values;
+    return values;
+}
+
+// Read the next row, allocating its values and strings from an arena
+int reader_read_row_into(reader_t* reader, fxdb_arena_t* arena, row_data_t* row) {
+    if (!reader || !arena || !row) {
+        return -1;
+    }
+    
+    const uint8_t* row_buffer = next_row(reader);
+    if (!row_buffer) {
+        return -1;
+    }
+    
+    field_value_t* values = decode_into(reader->schema, row_buffer, arena, row);
+    if (!values) {
+        return -1;
+    }
+    finish_row(reader, values);
+    return 0;
+}
+
+// Step to the next live row without decoding it
+const uint8_t* reader_next_row_bytes(reader_t* reader, uint64_t* null_fields) {
+    if (!reader || !next_row(reader)) {
+        return NULL;
+    }
+    reader->current_row++;
+    return reader_row_bytes(reader, null_fields);
+}
+
+// Bytes of the row last read and its NULL fields
+const uint8_t* reader_row_bytes(const reader_t* reader, uint64_t* null_fields) {
+    if (!reader || !reader->chunk_data || reader->current_row == 0) {
+        return NULL;
+    }
+    
+    uint32_t row = reader->current_row - 1;
+    if (null_fields) {
+        *null_fields = 0;
+        uint64_t null_mask = reader->header.null_mask;
+        while (null_mask) {
+            uint32_t field = (uint32_t)__builtin_ctzll(null_mask);
+            if (!fxdb_bitmap_get(reader_chunk_validity(reader, field), row)) {
+                *null_fields |= 1ULL << field;
+            }
+            null_mask &= null_mask - 1;
+        }
+    }
+    return reader->chunk_data + (size_t)row * reader->schema->row_size;
+}
+
+// Decode row bytes into an arena
+int reader_decode_row_into(const schema_t* schema, const uint8_t* buffer, uint64_t null_fields,
+                           fxdb_arena_t* arena, row_data_t* row) {
+    if (!schema || !buffer || !arena || !row) {
+        return -1;
+    }
+    
+    field_value_t* values = decode_into(schema, buffer, arena, row);
+    if (!values) {
+        return -1;
+    }
+    while (null_fields) {
+        values[__builtin_ctzll(null_fields)].is_null = true;
+        null_fields &= null_fields - 1;
+    }
+    return 0;
+}
+
+// Validity bitmap of a field in the current chunk
+const uint64_t* reader_chunk_validity(const reader_t* reader, uint32_t field_index) {
+    if (!reader || !reader->validity || field_index >= MAX_COLUMNS ||
+        !((reader->header.null_mask >> field_index) & 1)) {
+        return NULL;
     }
     
-    return row;
+    uint32_t ordinal = fxdb_null_ordinal(reader->header.null_mask, field_index);
+    return reader->validity + (size_t)ordinal * reader->validity_words;
 }
 
-// Read next row from file
-row_data_t* reader_read_row(reader_t* reader) {
-    if (!reader) return NULL;
+// Physical position of the row last returned by reader_read_row
+int reader_row_position(const reader_t* reader, row_position_t* position) {
+    if (!reader || !position || !reader->chunk_data || reader->current_row == 0) {
+        return -1;
+    }
     
-    // Load first chunk if needed
-    if (reader->current_chunk == 0 && reader->current_row == 0 && reader->chunk_row_count == 0) {
-        if (reader_load_chunk(reader, 0) != 0) {
-            return NULL;
+    position->chunk_index = reader->current_chunk;
+    position->row_in_chunk = reader->current_row - 1;
+    return 0;
+}
+
+// Delete rows by position
+int reader_delete_rows(reader_t* reader, const row_position_t* positions, uint32_t count) {
+    if (!reader || (!positions && count > 0)) {
+        return -1;
+    }
+    
+    fxdb_deletes_t* batch = deletes_create(reader->header.chunk_size);
+    if (!batch) {
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (positions[i].chunk_index >= chunk_total(reader) ||
+            positions[i].row_in_chunk >= reader->header.chunk_size ||
+            deletes_mark(batch, positions[i]) < 0) {
+            fprintf(stderr, "Error: Invalid row position %u:%u\n",
+                    positions[i].chunk_index, positions[i].row_in_chunk);
+            deletes_free(batch);
+            return -1;
         }
     }
     
-    // Check if we need to move to next chunk
-    if (reader->current_row >= reader->chunk_row_count) {
-        if (reader->current_chunk + 1 >= reader->header.chunk_count) {
-            return NULL; // EOF
+    int result = deletes_write(reader->path, &reader->header, batch, FXDB_DURABILITY_FLUSH);
+    deletes_free(batch);
+    
+    reader_rewind(reader);
+    if (result != 0 || load_deletes(reader) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Compare two values of a field; NULL only equals NULL
+bool reader_values_equal(const field_def_t* field, const field_value_t* a, const field_value_t* b) {
+    if (!field || !a || !b) {
+        return false;
+    }
+    if (a->is_null || b->is_null) {
+        return a->is_null && b->is_null;
+    }
+    
+    switch (field->type) {
+        case FIELD_TYPE_INT32:
+            return a->value.int32_val == b->value.int32_val;
+        case FIELD_TYPE_FLOAT:
+            return a->value.float_val == b->value.float_val;
+        case FIELD_TYPE_BOOL:
+            return a->value.bool_val == b->value.bool_val;
+        case FIELD_TYPE_STRING: {
+            // Stored strings are cut to the field size
+            const char* sa = a->value.string_val ? a->value.string_val : "";
+            const char* sb = b->value.string_val ? b->value.string_val : "";
+            return strncmp(sa, sb, field->size > 0 ? field->size - 1 : 0) == 0;
+        }
+        default:
+            return false;
+    }
+}
+
+// Fold rows row_first..row_end - 1 of the current chunk into an aggregate, skipping NULLs
+static void aggregate_chunk_rows(const reader_t* reader, uint32_t field_index, uint32_t row_first,
+                                 uint32_t row_end, column_aggregate_t* out) {
+    field_type_t type = reader->schema->fields[field_index].type;
+    bool numeric = (type == FIELD_TYPE_INT32 || type == FIELD_TYPE_FLOAT);
+    uint32_t offset = schema_field_offset(reader->schema, field_index);
+    uint32_t row_size = reader->schema->row_size;
+    
+    uint64_t start = fxdb_stats_clock();
+    const uint64_t* validity = reader_chunk_validity(reader, field_index);
+    const uint64_t* deleted = reader->chunk_deleted;
+    
+    for (uint32_t w = row_first / FXDB_BITMAP_WORD_BITS; w * FXDB_BITMAP_WORD_BITS < row_end; w++) {
+        // Bits first..word_rows - 1 of the word are in the range
+        uint32_t word_start = w * FXDB_BITMAP_WORD_BITS;
+        uint32_t first = row_first > word_start ? row_first - word_start : 0;
+        uint32_t word_rows = row_end - word_start;
+        if (word_rows > FXDB_BITMAP_WORD_BITS) {
+            word_rows = FXDB_BITMAP_WORD_BITS;
+        }
+        uint64_t mask = (word_rows == FXDB_BITMAP_WORD_BITS ? ~0ULL : (1ULL << word_rows) - 1) & (~0ULL << first);
+        if (deleted) {
+            mask &= ~deleted[w];
+        }
+        out->row_count += fxdb_popcount64(mask);
+        if (validity) {
+            mask &= validity[w];
+        }
+        out->value_count += fxdb_popcount64(mask);
+        if (!numeric || mask == 0) {
+            continue; // Whole word NULL, or nothing to sum
         }
         
-        if (reader_load_chunk(reader, reader->current_chunk + 1) != 0) {
-            return NULL;
+        // Fold NULLs in as the identity of each aggregate instead of branching
+        const uint8_t* base = reader->chunk_data + (size_t)word_start * row_size + offset;
+        for (uint32_t b = first; b < word_rows; b++) {
+            double v;
+            if (type == FIELD_TYPE_INT32) {
+                int32_t iv;
+                memcpy(&iv, base + (size_t)b * row_size, sizeof(iv));
+                v = iv;
+            } else {
+                float fv;
+                memcpy(&fv, base + (size_t)b * row_size, sizeof(fv));
+                v = fv;
+            }
+            bool valid = (mask >> b) & 1;
+            double lo = valid ? v : INFINITY;
+            double hi = valid ? v : -INFINITY;
+            out->sum += valid ? v : 0.0;
+            out->min = lo < out->min ? lo : out->min;
+            out->max = hi > out->max ? hi : out->max;
         }
     }
+    fxdb_stats_add(FXDB_STAT_DECODE_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_ROWS_DECODED, row_end - row_first);
+}
+
+// Aggregate a column over the whole file, skipping NULLs
+int reader_aggregate_column(reader_t* reader, uint32_t field_index, column_aggregate_t* out) {
+    return reader_aggregate_rows(reader, field_index, 0, UINT32_MAX, out);
+}
+
+// Aggregate a column over a range of rows, from chunk summaries where the range covers a chunk
+int reader_aggregate_rows(reader_t* reader, uint32_t field_index, uint32_t first_row, uint32_t end_row,
+                          column_aggregate_t* out) {
+    if (!reader || !out || field_index >= reader->schema->field_count) {
+        return -1;
+    }
     
-    // Deserialize current row
-    uint8_t* row_buffer = reader->chunk_buffer + (reader->current_row * reader->schema->row_size);
-    row_data_t* row = deserialize_row(reader->schema, row_buffer);
+    memset(out, 0, sizeof(*out));
+    out->min = INFINITY;
+    out->max = -INFINITY;
     
-    if (row) {
-        reader->current_row++;
+    uint32_t total_rows = physical_rows(reader);
+    if (end_row > total_rows) {
+        end_row = total_rows;
     }
+    uint32_t committed = reader->header.chunk_count;
+    column_aggregate_t* summaries = malloc((committed ? committed : 1) * sizeof(column_aggregate_t));
+    bool* summarized = malloc((committed ? committed : 1) * sizeof(bool));
+    int result = summaries && summarized ? summary_chunk_aggregates(reader, field_index, summaries, summarized) : -1;
+    
+    // Over the whole file every chunk is covered, and no chunk header has to be walked
+    bool whole = first_row == 0 && end_row == total_rows;
+    for (uint32_t c = 0; c < chunk_total(reader) && result == 0; c++) {
+        uint32_t chunk_first = 0, chunk_rows = 0;
+        if (!whole && c < committed) {
+            if (extend_directory(reader, c, 0) != 0 || c >= reader->directory_count) {
+                result = -1;
+                break;
+            }
+            chunk_first = reader->directory[c].first_row;
+            chunk_rows = reader->directory[c].row_count;
+        } else if (!whole) {
+            chunk_first = reader->header.total_rows;
+            chunk_rows = reader->wal_rows;
+        }
+        if (!whole && chunk_first >= end_row) {
+            break;
+        }
+        if (!whole && chunk_first + chunk_rows <= first_row) {
+            continue;
+        }
+        
+        bool covered = whole || (first_row <= chunk_first && chunk_first + chunk_rows <= end_row);
+        if (covered && c < committed && summarized[c]) {
+            const column_aggregate_t* chunk = &summaries[c];
+            out->row_count += chunk->row_count;
+            out->value_count += chunk->value_count;
+            out->sum += chunk->sum;
+            out->min = chunk->min < out->min ? chunk->min : out->min;
+            out->max = chunk->max > out->max ? chunk->max : out->max;
+            out->chunks_summarized++;
+            continue;
+        }
+        
+        // Boundary chunks, log rows and chunks without a usable summary are read
+        if (reader_load_chunk(reader, c) != 0) {
+            result = -1;
+            break;
+        }
+        uint32_t rows = reader->chunk_row_count;
+        uint32_t row_first = covered || first_row <= chunk_first ? 0 : first_row - chunk_first;
+        uint32_t row_end = covered || end_row - chunk_first > rows ? rows : end_row - chunk_first;
+        if (row_first < row_end) {
+            aggregate_chunk_rows(reader, field_index, row_first, row_end, out);
+        }
+        out->chunks_scanned++;
+    }
+    free(summaries);
+    free(summarized);
     
-    return row;
+    field_type_t type = reader->schema->fields[field_index].type;
+    if (out->value_count == 0 || (type != FIELD_TYPE_INT32 && type != FIELD_TYPE_FLOAT)) {
+        out->min = 0.0;
+        out->max = 0.0;
+    }
+    
+    // Rewind so the next reader_read_row starts from the first row
+    reader_rewind(reader);
+    return result;
 }
 
-// Read multiple rows with limit
+// Read multiple rows with limit, all of them in one arena
 query_result_t* reader_read_rows(reader_t* reader, uint32_t limit) {
     if (!reader) return NULL;
     
-    query_result_t* result = malloc(sizeof(query_result_t));
-    if (!result) return NULL;
+    // Size the first block for the rows asked for, up to the largest block
+    size_t row_bytes = sizeof(row_data_t) + reader->schema->field_count * sizeof(field_value_t) +
+                       string_bytes(reader->schema) + 2 * FXDB_ARENA_ALIGNMENT;
+    uint32_t available = reader_get_row_count(reader);
+    size_t wanted = (size_t)(limit < available ? limit : available) * row_bytes + sizeof(query_result_t);
+    fxdb_arena_t* arena = fxdb_arena_create(wanted < FXDB_ARENA_MAX_BLOCK ? wanted : FXDB_ARENA_MAX_BLOCK);
+    if (!arena) return NULL;
+    
+    query_result_t* result = fxdb_arena_alloc(arena, sizeof(query_result_t));
+    row_data_t* rows = fxdb_arena_alloc(arena, sizeof(row_data_t) * (limit < available ? limit : available));
+    if (!result || !rows) {
+        fxdb_arena_destroy(arena);
+        return NULL;
+    }
     
     result->row_count = 0;
     result->schema = reader->schema; // Store schema reference
-    result->rows = malloc(sizeof(row_data_t) * limit);
-    if (!result->rows) {
-        free(result);
-        return NULL;
-    }
+    result->rows = rows;
+    result->arena = arena;
     
-    for (uint32_t i = 0; i < limit; i++) {
-        row_data_t* row = reader_read_row(reader);
-        if (!row) break;
-        
-        // Move the row data (transfer ownership)
-        result->rows[result->row_count] = *row;
+    uint32_t capacity = limit < available ? limit : available;
+    while (result->row_count < capacity && reader_read_row_into(reader, arena, &rows[result->row_count]) == 0) {
         result->row_count++;
-        
-        // Free only the row container, not the values (ownership transferred)
-        if (row->values) {
-            // Don't free row->values since we transferred ownership
-            row->values = NULL;
-        }
-        free(row);
     }
     
     return result;
@@ -303,13 +1443,40 @@ query_result_t* reader_read_rows(reader_t* reader, uint32_t limit) {
 
 // Get total row count
 uint32_t reader_get_row_count(const reader_t* reader) {
-    return reader ? reader->header.total_rows : 0;
+    return reader ? physical_rows(reader) - reader_get_deleted_count(reader) : 0;
+}
+
+// Committed state the reader has pinned
+void reader_get_snapshot(const reader_t* reader, reader_snapshot_t* snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (reader) {
+        const fxdb_root_t* root = fxdb_header_root(&reader->header);
+        snapshot->generation = reader->header.generation;
+        snapshot->sequence = root ? root->sequence : 0;
+        snapshot->chunk_count = reader->header.chunk_count;
+        snapshot->committed_rows = physical_rows(reader);
+    }
+}
+
+// Get the number of deleted rows still stored in the file
+uint32_t reader_get_deleted_count(const reader_t* reader) {
+    if (!reader || !reader->deletes) {
+        return 0;
+    }
+    
+    // Deletions of rows not written yet cannot exceed what is stored
+    uint64_t deleted = reader->deletes->deleted_rows;
+    return deleted < physical_rows(reader) ? (uint32_t)deleted : physical_rows(reader);
 }
 
 // Get reader statistics
 void reader_get_stats(const reader_t* reader, uint32_t* total_rows, uint32_t* total_chunks) {
     if (reader) {
-        if (total_rows) *total_rows = reader->header.total_rows;
+        if (total_rows) *total_rows = reader_get_row_count(reader);
         if (total_chunks) *total_chunks = reader->header.chunk_count;
     }
 }
@@ -324,6 +1491,11 @@ void reader_print_row(const reader_t* reader, const row_data_t* row) {
         
         printf("%-15s: ", field->name);
         
+        if (value->is_null) {
+            printf("NULL\n");
+            continue;
+        }
+        
         switch (field->type) {
             case FIELD_TYPE_INT32:
                 printf("%d\n", value->value.int32_val);
@@ -347,29 +1519,31 @@ void reader_print_row(const reader_t* reader, const row_data_t* row) {
 
 // Print multiple rows in formatted table
 void reader_print_rows(const reader_t* reader, const query_result_t* result) {
-    if (!reader || !result || result->row_count == 0) {
+    // A join's rows carry their own schema
+    const schema_t* schema = result && result->schema ? result->schema : reader ? reader->schema : NULL;
+    if (!schema || !result || result->row_count == 0) {
         printf("No rows to display.\n");
         return;
     }
     
     // Print header
     printf("┌");
-    for (uint32_t i = 0; i < reader->schema->field_count; i++) {
+    for (uint32_t i = 0; i < schema->field_count; i++) {
         printf("─────────────────");
-        if (i < reader->schema->field_count - 1) printf("┬");
+        if (i < schema->field_count - 1) printf("┬");
     }
     printf("┐\n");
     
     printf("│");
-    for (uint32_t i = 0; i < reader->schema->field_count; i++) {
-        printf(" %-15s │", reader->schema->fields[i].name);
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        printf(" %-15s │", schema->fields[i].name);
     }
     printf("\n");
     
     printf("├");
-    for (uint32_t i = 0; i < reader->schema->field_count; i++) {
+    for (uint32_t i = 0; i < schema->field_count; i++) {
         printf("─────────────────");
-        if (i < reader->schema->field_count - 1) printf("┼");
+        if (i < schema->field_count - 1) printf("┼");
     }
     printf("┤\n");
     
@@ -380,7 +1554,12 @@ void reader_print_rows(const reader_t* reader, const query_result_t* result) {
         
         for (uint32_t i = 0; i < row->field_count; i++) {
             const field_value_t* value = &row->values[i];
-            const field_def_t* field = &reader->schema->fields[i];
+            const field_def_t* field = &schema->fields[i];
+            
+            if (value->is_null) {
+                printf(" %-15s │", "NULL");
+                continue;
+            }
             
             switch (field->type) {
                 case FIELD_TYPE_INT32:
@@ -404,9 +1583,9 @@ void reader_print_rows(const reader_t* reader, const query_result_t* result) {
     }
     
     printf("└");
-    for (uint32_t i = 0; i < reader->schema->field_count; i++) {
+    for (uint32_t i = 0; i < schema->field_count; i++) {
         printf("─────────────────");
-        if (i < reader->schema->field_count - 1) printf("┴");
+        if (i < schema->field_count - 1) printf("┴");
     }
     printf("┘\n");
     
@@ -416,6 +1595,11 @@ void reader_print_rows(const reader_t* reader, const query_result_t* result) {
 // Close reader
 void reader_close(reader_t* reader) {
     if (reader) {
+        fxdb_op_timer_t timer = fxdb_op_begin();
+        read_ahead_destroy(reader->read_ahead);
+        stop_direct_io(reader);
+        stop_mmap(reader);
+        free(reader->directory);
         if (reader->file) {
             fclose(reader->file);
         }
@@ -425,7 +1609,15 @@ void reader_close(reader_t* reader) {
         if (reader->chunk_buffer) {
             free(reader->chunk_buffer);
         }
+        fxdb_chunk_cache_release(reader->cached_chunk);
+        free(reader->validity);
+        free(reader->wal_chunk);
+        free(reader->path);
+        deletes_free(reader->deletes);
+        coord_detach(reader->coord);
+        fxdb_slab_pool_destroy(&reader->row_pool);
         free(reader);
+        fxdb_op_end(FXDB_LATENCY_CLOSE, "reader_close", NULL, timer);
     }
 }
 
@@ -444,6 +1636,11 @@ void reader_free_row(row_data_t* row) {
 
 // Free query result
 void reader_free_result(query_result_t* result) {
+    if (result && result->arena) {
+        // The result lives in its own arena
+        fxdb_arena_destroy(result->arena);
+        return;
+    }
     if (result) {
         if (result->rows && result->schema) {
             for (uint32_t i = 0; i < result->row_count; i++) {
@@ -472,18 +1669,42 @@ int reader_seek_row(reader_t* reader, uint32_t row_number) {
     }
     
     // Check if row_number is valid
-    if (row_number >= reader->header.total_rows) {
+    uint32_t total_rows = physical_rows(reader);
+    if (row_number >= total_rows) {
         fprintf(stderr, "Error: Row number %u exceeds total rows (%u)\n", 
-                row_number, reader->header.total_rows);
+                row_number, total_rows);
         return -1;
     }
     
-    // Calculate which chunk contains the target row
-    uint32_t chunk_index = row_number / reader->header.chunk_size;
-    uint32_t row_in_chunk = row_number % reader->header.chunk_size;
+    // Find the chunk holding the target row; commits leave chunks short of
+    // chunk_size, so the directory is searched. Log rows follow the chunks.
+    uint32_t chunk_index = reader->header.chunk_count;
+    uint32_t row_in_chunk = row_number - reader->header.total_rows;
+    if (row_number < reader->header.total_rows) {
+        if (extend_directory(reader, UINT32_MAX, row_number) != 0) {
+            fprintf(stderr, "Error: Cannot locate row %u\n", row_number);
+            return -1;
+        }
+        
+        uint32_t low = 0, high = reader->directory_count;
+        while (high - low > 1) {
+            uint32_t mid = low + (high - low) / 2;
+            if (reader->directory[mid].first_row <= row_number) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        chunk_index = low;
+        row_in_chunk = row_number - reader->directory[low].first_row;
+        if (low >= reader->directory_count || row_in_chunk >= reader->directory[low].row_count) {
+            fprintf(stderr, "Error: Cannot locate row %u\n", row_number);
+            return -1;
+        }
+    }
     
     // Load the appropriate chunk if not already loaded
-    if (reader->current_chunk != chunk_index) {
+    if (!reader->chunk_data || reader->current_chunk != chunk_index) {
         if (reader_load_chunk(reader, chunk_index) != 0) {
             fprintf(stderr, "Error: Failed to load chunk %u\n", chunk_index);
             return -1;
@@ -501,82 +1722,17 @@ int reader_seek_row(reader_t* reader, uint32_t row_number) {
  * ============================================================================ */
 
 /**
- * Load schema from memory-mapped file
+ * Open .fxdb file for reading with enhanced performance
  */
-static schema_t* load_schema_from_mmap(fxdb_mmap_reader_t* mmap_reader, const fxdb_header_t* header) {
-    size_t offset = header->schema_offset;
-    
-    // Read schema metadata
-    uint32_t field_count = fxdb_read_uint32_mmap(mmap_reader, offset);
-    offset += sizeof(uint32_t);
-    
-    uint32_t row_size = fxdb_read_uint32_mmap(mmap_reader, offset);
-    offset += sizeof(uint32_t);
-    
-    uint32_t schema_str_len = fxdb_read_uint32_mmap(mmap_reader, offset);
-    offset += sizeof(uint32_t);
-    
-    // Read schema string
-    char* schema_str = malloc(schema_str_len + 1);
-    if (!schema_str) return NULL;
-    
-    if (fxdb_read_string_mmap(mmap_reader, offset - sizeof(uint32_t), schema_str, schema_str_len + 1) < 0) {
-        free(schema_str);
-        return NULL;
-    }
-    offset += schema_str_len;
-    
-    // Create schema structure
-    schema_t* schema = malloc(sizeof(schema_t));
-    if (!schema) {
-        free(schema_str);
-        return NULL;
-    }
-    
-    schema->field_count = field_count;
-    schema->row_size = row_size;
-    schema->raw_schema_str = schema_str;
-    
-    // Read field definitions
-    for (uint32_t i = 0; i < field_count; i++) {
-        field_def_t* field = &schema->fields[i];
-        
-        void* field_data = fxdb_mmap_get_ptr(mmap_reader, offset);
-        if (!field_data) {
-            free_schema(schema);
-            return NULL;
-        }
-        
-        // Copy field name
-        memcpy(field->name, field_data, MAX_FIELD_NAME_LEN);
-        offset += MAX_FIELD_NAME_LEN;
-        
-        // Copy field type
-        field_data = fxdb_mmap_get_ptr(mmap_reader, offset);
-        if (!field_data) {
-            free_schema(schema);
-            return NULL;
-        }
-        field->type = *(field_type_t*)field_data;
-        offset += sizeof(field_type_t);
-        
-        // Copy field size
-        field_data = fxdb_mmap_get_ptr(mmap_reader, offset);
-        if (!field_data) {
-            free_schema(schema);
-            return NULL;
-        }
-        field->size = *(uint32_t*)field_data;
-        offset += sizeof(uint32_t);
-    }
-    
-    return schema;
+fxdb_enhanced_reader_t* fxdb_reader_open(const char* filename, bool use_mmap) {
+    fxdb_mmap_options_t options = fxdb_mmap_default_options();
+    return fxdb_reader_open_with_options(filename, use_mmap ? &options : NULL);
 }
 
 /**
- * Open .fxdb file for reading with enhanced performance
+ * Open .fxdb file for reading through a memory mapping with the given hints
  */
-fxdb_enhanced_reader_t* fxdb_reader_open(const char* filename, bool use_mmap) {
+fxdb_enhanced_reader_t* fxdb_reader_open_with_options(const char* filename, const fxdb_mmap_options_t* options) {
     if (!filename) {
         return NULL;
     }
@@ -593,74 +1749,35 @@ fxdb_enhanced_reader_t* fxdb_reader_open(const char* filename, bool use_mmap) {
         return NULL;
     }
     
-    reader->use_mmap = use_mmap;
-    reader->buffer_size = FXDB_BUFFER_SIZE;
-    
-    if (use_mmap) {
-        // Try to open with memory mapping
-        reader->mmap_reader = fxdb_mmap_reader_open(normalized_name);
-        if (!reader->mmap_reader) {
-            // Fallback to traditional file I/O
-            reader->use_mmap = false;
-        }
-    }
-    
-    if (!reader->use_mmap) {
-        // Open with traditional file I/O
-        reader->file = fopen(normalized_name, "rb");
-        if (!reader->file) {
-            free(normalized_name);
-            free(reader);
-            return NULL;
-        }
-    }
-    
-    // Read header
-    if (reader->use_mmap) {
-        // Read header from memory-mapped file
-        void* header_ptr = fxdb_mmap_get_ptr(reader->mmap_reader, 0);
-        if (!header_ptr) {
-            fxdb_mmap_reader_close(reader->mmap_reader);
-            free(normalized_name);
-            free(reader);
-            return NULL;
-        }
-        memcpy(&reader->header, header_ptr, sizeof(fxdb_header_t));
-    } else {
-        // Read header from traditional file
-        if (fread(&reader->header, sizeof(fxdb_header_t), 1, reader->file) != 1) {
-            fclose(reader->file);
-            free(normalized_name);
-            free(reader);
-            return NULL;
-        }
-    }
-    
-    // Validate magic number
-    if (reader->header.magic != FXDB_MAGIC_NUM) {
-        fxdb_reader_close(reader);
-        free(normalized_name);
+    reader->reader = reader_open(normalized_name);
+    free(normalized_name);
+    if (!reader->reader) {
+        free(reader);
         return NULL;
     }
     
-    // Load schema
-    if (reader->use_mmap) {
-        reader->schema = load_schema_from_mmap(reader->mmap_reader, &reader->header);
-    } else {
-        reader->schema = load_schema_from_file(reader->file, &reader->header);
+    // Without a mapping (too small, or not supported) the buffered reads serve
+    if (options && reader_set_mmap(reader->reader, true, options) == 0) {
+        reader->use_mmap = reader->reader->map != NULL;
     }
     
-    if (!reader->schema) {
-        fxdb_reader_close(reader);
-        free(normalized_name);
-        return NULL;
+    reader->schema = reader->reader->schema;
+    reader->header = reader->reader->header;
+    reader->total_rows = physical_rows(reader->reader);
+    return reader;
+}
+
+/**
+ * Change the access pattern hint of an enhanced reader
+ */
+int fxdb_reader_set_access(fxdb_enhanced_reader_t* reader, fxdb_mmap_access_t access) {
+    if (!reader || !reader->use_mmap || !reader->reader->map) {
+        return -1;
     }
     
-    reader->total_rows = reader->header.total_rows;
-    reader->current_offset = reader->header.data_offset;
-    
-    free(normalized_name);
-    return reader;
+    reader->reader->map_options.access = access;
+    reader->reader->map_prefetched = 0;
+    return fxdb_mmap_advise(reader->reader->map, access);
 }
 
 /**
@@ -671,187 +1788,20 @@ void fxdb_reader_close(fxdb_enhanced_reader_t* reader) {
         return;
     }
     
-    if (reader->use_mmap && reader->mmap_reader) {
-        fxdb_mmap_reader_close(reader->mmap_reader);
-    }
-    
-    if (reader->file) {
-        fclose(reader->file);
-    }
-    
-    if (reader->schema) {
-        free_schema(reader->schema);
-    }
-    
+    reader_close(reader->reader);
     free(reader);
 }
 
 /**
- * Read next row from enhanced reader using memory mapping or traditional I/O
+ * Read next row from enhanced reader
  */
 row_data_t* fxdb_reader_read_row(fxdb_enhanced_reader_t* reader) {
-    if (!reader || !reader->schema) {
-        return NULL;
-    }
-    
-    if (reader->current_row >= reader->total_rows) {
-        return NULL; // EOF
-    }
-    
-    row_data_t* row = malloc(sizeof(row_data_t));
-    if (!row) {
-        return NULL;
-    }
-    
-    row->field_count = reader->schema->field_count;
-    row->values = malloc(sizeof(field_value_t) * row->field_count);
-    if (!row->values) {
-        free(row);
-        return NULL;
-    }
-    
-    // Read row data based on I/O method
-    if (reader->use_mmap) {
-        // Memory-mapped reading
-        size_t row_offset = reader->current_offset;
-        
-        for (uint32_t i = 0; i < row->field_count; i++) {
-            field_def_t* field = &reader->schema->fields[i];
-            row->values[i].field_name = field->name;
-            
-            void* field_data = fxdb_mmap_get_ptr(reader->mmap_reader, row_offset);
-            if (!field_data) {
-                reader_free_row(row);
-                return NULL;
-            }
-            
-            switch (field->type) {
-                case TYPE_INT32:
-                    row->values[i].value.int32_val = *(int32_t*)field_data;
-                    row_offset += sizeof(int32_t);
-                    break;
-                    
-                case TYPE_FLOAT:
-                    row->values[i].value.float_val = *(float*)field_data;
-                    row_offset += sizeof(float);
-                    break;
-                    
-                case TYPE_BOOL:
-                    row->values[i].value.bool_val = *(bool*)field_data;
-                    row_offset += sizeof(bool);
-                    break;
-                    
-                case TYPE_STRING: {
-                    char* str_val = malloc(field->size + 1);
-                    if (!str_val) {
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    
-                    // Read fixed-size string from memory-mapped file
-                    field_data = fxdb_mmap_get_ptr(reader->mmap_reader, row_offset);
-                    if (!field_data) {
-                        free(str_val);
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    
-                    memcpy(str_val, field_data, field->size);
-                    str_val[field->size] = '\0';
-                    row->values[i].value.string_val = str_val;
-                    row_offset += field->size;
-                    break;
-                }
-                    
-                default:
-                    reader_free_row(row);
-                    return NULL;
-            }
-        }
-        
-        reader->current_offset = row_offset;
-    } else {
-        // Traditional file I/O
-        if (fseek(reader->file, reader->current_offset, SEEK_SET) != 0) {
-            reader_free_row(row);
-            return NULL;
-        }
-        
-        for (uint32_t i = 0; i < row->field_count; i++) {
-            field_def_t* field = &reader->schema->fields[i];
-            row->values[i].field_name = field->name;
-            
-            switch (field->type) {
-                case TYPE_INT32:
-                    if (fread(&row->values[i].value.int32_val, sizeof(int32_t), 1, reader->file) != 1) {
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    break;
-                    
-                case TYPE_FLOAT:
-                    if (fread(&row->values[i].value.float_val, sizeof(float), 1, reader->file) != 1) {
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    break;
-                    
-                case TYPE_BOOL:
-                    if (fread(&row->values[i].value.bool_val, sizeof(bool), 1, reader->file) != 1) {
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    break;
-                    
-                case TYPE_STRING: {
-                    char* str_val = malloc(field->size + 1);
-                    if (!str_val) {
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    
-                    if (fread(str_val, 1, field->size, reader->file) != field->size) {
-                        free(str_val);
-                        reader_free_row(row);
-                        return NULL;
-                    }
-                    str_val[field->size] = '\0';
-                    row->values[i].value.string_val = str_val;
-                    break;
-                }
-                    
-                default:
-                    reader_free_row(row);
-                    return NULL;
-            }
-        }
-        
-        reader->current_offset = ftell(reader->file);
-    }
-    
-    reader->current_row++;
-    return row;
+    return reader ? reader_read_row(reader->reader) : NULL;
 }
 
 /**
  * Seek to specific row in enhanced reader
  */
 int fxdb_reader_seek_row(fxdb_enhanced_reader_t* reader, uint32_t row_number) {
-    if (!reader || !reader->schema) {
-        return -1;
-    }
-    
-    if (row_number >= reader->total_rows) {
-        return -1; // Out of bounds
-    }
-    
-    // Calculate offset for the target row
-    // This is a simplified implementation - assumes fixed row sizes
-    size_t row_size = reader->schema->row_size;
-    size_t target_offset = reader->header.data_offset + (row_number * row_size);
-    
-    reader->current_offset = target_offset;
-    reader->current_row = row_number;
-    
-    return 0;
-}
\ No newline at end of file
+    return reader ? reader_seek_row(reader->reader, row_number) : -1;
+}
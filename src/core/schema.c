@@ -4,6 +4,7 @@
 #include "../../include/utils.h"
 #include "../../include/error.h"
 #include "../../include/core/data_types.h"
+#include "../../include/stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -116,6 +117,14 @@ schema_t* parse_schema(const char* schema_str) {
         char* field_name = trim_whitespace(token);
         char* type_str = trim_whitespace(space_pos + 1);
         
+        // Trailing '?' marks a nullable column
+        bool nullable = false;
+        size_t type_len = strlen(type_str);
+        if (type_len > 1 && type_str[type_len - 1] == '?') {
+            type_str[type_len - 1] = '\0';
+            nullable = true;
+        }
+        
         // Validate field name length
         if (strlen(field_name) >= MAX_FIELD_NAME_LEN) {
             fprintf(stderr, "Error: Field name '%s' too long\n", field_name);
@@ -139,6 +148,7 @@ schema_t* parse_schema(const char* schema_str) {
         strcpy(field->name, field_name);
         field->type = type;
         field->size = enhanced_size > 0 ? enhanced_size : get_field_size(type);
+        field->nullable = nullable;
         
         schema->field_count++;
         token = strtok(NULL, ",");
@@ -175,6 +185,44 @@ uint32_t calculate_row_size(const schema_t* schema) {
     return total_size;
 }
 
+// Bitmask with bit i set when field i is nullable
+uint64_t schema_null_mask(const schema_t* schema) {
+    if (!schema) return 0;
+    
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < schema->field_count && i < MAX_COLUMNS; i++) {
+        if (schema->fields[i].nullable) {
+            mask |= (uint64_t)1 << i;
+        }
+    }
+    return mask;
+}
+
+// Mark fields nullable according to a header null mask
+void schema_apply_null_mask(schema_t* schema, uint64_t null_mask) {
+    if (!schema) return;
+    
+    for (uint32_t i = 0; i < schema->field_count && i < MAX_COLUMNS; i++) {
+        schema->fields[i].nullable = (null_mask >> i) & 1;
+    }
+}
+
+// Byte offset of a field inside a serialized row
+uint32_t schema_field_offset(const schema_t* schema, uint32_t field_index) {
+    if (!schema) return 0;
+    
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < field_index && i < schema->field_count; i++) {
+        switch (schema->fields[i].type) {
+            case FIELD_TYPE_INT32: offset += sizeof(int32_t); break;
+            case FIELD_TYPE_FLOAT: offset += sizeof(float); break;
+            case FIELD_TYPE_BOOL:  offset += 1; break;
+            default:               offset += schema->fields[i].size; break;
+        }
+    }
+    return offset;
+}
+
 // Validate schema
 bool validate_schema(const schema_t* schema) {
     if (!schema || schema->field_count == 0) {
@@ -220,9 +268,12 @@ void print_schema(const schema_t* schema) {
     
     for (uint32_t i = 0; i < schema->field_count; i++) {
         const field_def_t* field = &schema->fields[i];
+        char type_str[16];
+        snprintf(type_str, sizeof(type_str), "%s%s",
+                 field_type_to_string(field->type), field->nullable ? "?" : "");
         printf("│ %-31s │ %-8s │ %-9u │\n", 
                field->name, 
-               field_type_to_string(field->type), 
+               type_str, 
                field->size);
     }
     
@@ -244,7 +295,7 @@ void free_schema(schema_t* schema) {
 }
 
 // Load schema from .fxdb file
-schema_t* load_schema(const char* filename) {
+static schema_t* read_schema(const char* filename) {
     if (!filename) {
         return NULL;
     }
@@ -323,6 +374,13 @@ schema_t* load_schema(const char* filename) {
     return schema;
 }
 
+schema_t* load_schema(const char* filename) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    schema_t* schema = read_schema(filename);
+    fxdb_op_end(FXDB_LATENCY_SCHEMA_LOAD, "load_schema", NULL, timer);
+    return schema;
+}
+
 // Save schema to .fxdb file
 int save_schema(const char* filename, const schema_t* schema) {
     if (!filename || !schema) {
@@ -0,0 +1,422 @@
+#include "../../include/sketch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HLL_SPARSE 0
+#define HLL_DENSE 1
+#define HLL_SPARSE_ENTRY 3      // u16 register index and u8 rank
+#define KLL_HEADER (2 * sizeof(uint32_t) + sizeof(uint64_t) + 2 * sizeof(double))
+
+// Finalizer of MurmurHash3: spreads every input bit over the whole hash
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Hash a value of a field
+uint64_t fxdb_hash_value(const field_def_t* field, const uint8_t* value) {
+    uint32_t bits;
+    float number;
+    switch (field->type) {
+        case FIELD_TYPE_INT32:
+            memcpy(&bits, value, sizeof(bits));
+            return mix64(bits);
+        case FIELD_TYPE_FLOAT:
+            // -0 equals 0, so both hash as 0
+            memcpy(&number, value, sizeof(number));
+            if (number == 0.0f) {
+                number = 0.0f;
+            }
+            memcpy(&bits, &number, sizeof(bits));
+            return mix64(bits);
+        case FIELD_TYPE_BOOL:
+            return mix64(value[0] ? 1 : 0);
+        default: {
+            // FNV-1a over the text
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            size_t length = strnlen((const char*)value, field->size);
+            for (size_t i = 0; i < length; i++) {
+                hash = (hash ^ value[i]) * 0x100000001b3ULL;
+            }
+            return mix64(hash);
+        }
+    }
+}
+
+/* ============================================================================
+ * HyperLogLog
+ * ============================================================================ */
+
+// Start an empty HyperLogLog
+void fxdb_hll_init(fxdb_hll_t* hll) {
+    memset(hll->registers, 0, sizeof(hll->registers));
+}
+
+// Merge two HyperLogLogs: the longer run of each register wins
+void fxdb_hll_merge(fxdb_hll_t* hll, const fxdb_hll_t* other) {
+    for (uint32_t i = 0; i < FXDB_HLL_REGISTERS; i++) {
+        if (other->registers[i] > hll->registers[i]) {
+            hll->registers[i] = other->registers[i];
+        }
+    }
+}
+
+// Estimate distinct values
+double fxdb_hll_estimate(const fxdb_hll_t* hll) {
+    double m = FXDB_HLL_REGISTERS;
+    double sum = 0.0;
+    uint32_t zeros = 0;
+    for (uint32_t i = 0; i < FXDB_HLL_REGISTERS; i++) {
+        sum += 1.0 / (double)(1ULL << hll->registers[i]);
+        zeros += hll->registers[i] == 0;
+    }
+    
+    double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros); // Linear counting is more accurate for small sets
+    }
+    return estimate;
+}
+
+// Encode a HyperLogLog
+size_t fxdb_hll_encode(const fxdb_hll_t* hll, uint8_t* out) {
+    uint32_t set = 0;
+    for (uint32_t i = 0; i < FXDB_HLL_REGISTERS; i++) {
+        set += hll->registers[i] != 0;
+    }
+    
+    size_t sparse_size = 1 + sizeof(uint16_t) + (size_t)set * HLL_SPARSE_ENTRY;
+    if (sparse_size >= FXDB_HLL_MAX_ENCODED) {
+        out[0] = HLL_DENSE;
+        memcpy(out + 1, hll->registers, FXDB_HLL_REGISTERS);
+        return FXDB_HLL_MAX_ENCODED;
+    }
+    
+    out[0] = HLL_SPARSE;
+    uint16_t count = (uint16_t)set;
+    memcpy(out + 1, &count, sizeof(count));
+    uint8_t* entry = out + 1 + sizeof(count);
+    for (uint32_t i = 0; i < FXDB_HLL_REGISTERS; i++) {
+        if (hll->registers[i] != 0) {
+            uint16_t index = (uint16_t)i;
+            memcpy(entry, &index, sizeof(index));
+            entry[2] = hll->registers[i];
+            entry += HLL_SPARSE_ENTRY;
+        }
+    }
+    return sparse_size;
+}
+
+// Merge an encoded HyperLogLog
+int fxdb_hll_merge_encoded(fxdb_hll_t* hll, const uint8_t* data, size_t size) {
+    if (size == FXDB_HLL_MAX_ENCODED && data[0] == HLL_DENSE) {
+        for (uint32_t i = 0; i < FXDB_HLL_REGISTERS; i++) {
+            if (data[1 + i] > hll->registers[i]) {
+                hll->registers[i] = data[1 + i];
+            }
+        }
+        return 0;
+    }
+    
+    uint16_t count;
+    if (size < 1 + sizeof(count) || data[0] != HLL_SPARSE) {
+        return -1;
+    }
+    memcpy(&count, data + 1, sizeof(count));
+    if (size != 1 + sizeof(count) + (size_t)count * HLL_SPARSE_ENTRY) {
+        return -1;
+    }
+    const uint8_t* entry = data + 1 + sizeof(count);
+    for (uint16_t e = 0; e < count; e++, entry += HLL_SPARSE_ENTRY) {
+        uint16_t index;
+        memcpy(&index, entry, sizeof(index));
+        if (index >= FXDB_HLL_REGISTERS) {
+            return -1;
+        }
+        if (entry[2] > hll->registers[index]) {
+            hll->registers[index] = entry[2];
+        }
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * KLL Quantile Sketch
+ * ============================================================================ */
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Values a level holds before it is compacted: k at the top, 2/3 as many per level below
+static uint32_t level_capacity(const fxdb_kll_t* kll, uint32_t level) {
+    double capacity = kll->k;
+    for (uint32_t depth = kll->level_count - 1 - level; depth > 0 && capacity >= 2.0; depth--) {
+        capacity *= 2.0 / 3.0;
+    }
+    return capacity < 2.0 ? 2 : (uint32_t)capacity;
+}
+
+// A coin flip from a xorshift generator
+static uint32_t next_coin(fxdb_kll_t* kll) {
+    kll->random ^= kll->random << 13;
+    kll->random ^= kll->random >> 7;
+    kll->random ^= kll->random << 17;
+    return (uint32_t)(kll->random >> 63);
+}
+
+static int push_item(fxdb_kll_t* kll, uint32_t level, double value) {
+    if (kll->sizes[level] == kll->allocated[level]) {
+        uint32_t allocated = kll->allocated[level] ? kll->allocated[level] * 2 : 16;
+        double* items = realloc(kll->items[level], allocated * sizeof(double));
+        if (!items) {
+            return -1;
+        }
+        kll->items[level] = items;
+        kll->allocated[level] = allocated;
+    }
+    kll->items[level][kll->sizes[level]++] = value;
+    return 0;
+}
+
+// Halve every level at or over its capacity, lowest first, promoting half its values
+static int compress(fxdb_kll_t* kll) {
+    for (uint32_t h = 0; h < kll->level_count; h++) {
+        if (kll->sizes[h] < level_capacity(kll, h)) {
+            continue;
+        }
+        if (h + 1 == kll->level_count) {
+            if (kll->level_count == FXDB_KLL_MAX_LEVELS) {
+                return 0; // 2^40 values per item; never reached in practice
+            }
+            kll->level_count++;
+        }
+        
+        double* items = kll->items[h];
+        uint32_t size = kll->sizes[h];
+        qsort(items, size, sizeof(double), compare_doubles);
+        
+        // An odd value out stays behind, at its own weight
+        uint32_t offset = next_coin(kll);
+        for (uint32_t i = 0; i < size / 2; i++) {
+            if (push_item(kll, h + 1, items[2 * i + offset]) != 0) {
+                return -1;
+            }
+        }
+        if (size & 1) {
+            items[0] = items[size - 1];
+        }
+        kll->sizes[h] = size & 1;
+    }
+    return 0;
+}
+
+// Start an empty KLL sketch
+void fxdb_kll_init(fxdb_kll_t* kll, uint32_t k) {
+    memset(kll, 0, sizeof(*kll));
+    kll->k = k ? k : FXDB_KLL_DEFAULT_K;
+    kll->level_count = 1;
+    kll->min = INFINITY;
+    kll->max = -INFINITY;
+    kll->random = 0x9e3779b97f4a7c15ULL;
+}
+
+// Add a value
+int fxdb_kll_add(fxdb_kll_t* kll, double value) {
+    if (push_item(kll, 0, value) != 0) {
+        return -1;
+    }
+    kll->count++;
+    kll->min = value < kll->min ? value : kll->min;
+    kll->max = value > kll->max ? value : kll->max;
+    return kll->sizes[0] >= level_capacity(kll, 0) ? compress(kll) : 0;
+}
+
+// Merge two KLL sketches: levels of equal weight are pooled, then compacted
+int fxdb_kll_merge(fxdb_kll_t* kll, const fxdb_kll_t* other) {
+    if (other->count == 0) {
+        return 0;
+    }
+    if (other->level_count > kll->level_count) {
+        kll->level_count = other->level_count;
+    }
+    for (uint32_t h = 0; h < other->level_count; h++) {
+        for (uint32_t i = 0; i < other->sizes[h]; i++) {
+            if (push_item(kll, h, other->items[h][i]) != 0) {
+                return -1;
+            }
+        }
+    }
+    kll->count += other->count;
+    kll->min = other->min < kll->min ? other->min : kll->min;
+    kll->max = other->max > kll->max ? other->max : kll->max;
+    return compress(kll);
+}
+
+// A held value and how many values it stands for
+typedef struct {
+    double value;
+    uint64_t weight;
+} weighted_item_t;
+
+static int compare_weighted(const void* a, const void* b) {
+    return compare_doubles(&((const weighted_item_t*)a)->value, &((const weighted_item_t*)b)->value);
+}
+
+// Estimate the value at a quantile
+int fxdb_kll_quantile(const fxdb_kll_t* kll, double q, double* value) {
+    if (!kll || !value || kll->count == 0) {
+        return -1;
+    }
+    if (q <= 0.0) {
+        *value = kll->min;
+        return 0;
+    }
+    if (q >= 1.0) {
+        *value = kll->max;
+        return 0;
+    }
+    
+    uint32_t held = 0;
+    for (uint32_t h = 0; h < kll->level_count; h++) {
+        held += kll->sizes[h];
+    }
+    weighted_item_t* items = malloc((size_t)(held ? held : 1) * sizeof(weighted_item_t));
+    if (!items) {
+        return -1;
+    }
+    
+    uint32_t n = 0;
+    uint64_t total = 0;
+    for (uint32_t h = 0; h < kll->level_count; h++) {
+        for (uint32_t i = 0; i < kll->sizes[h]; i++) {
+            items[n].value = kll->items[h][i];
+            items[n].weight = 1ULL << h;
+            total += items[n++].weight;
+        }
+    }
+    qsort(items, n, sizeof(weighted_item_t), compare_weighted);
+    
+    // The first value whose cumulative weight reaches the quantile's rank
+    double rank = q * (double)total;
+    uint64_t seen = 0;
+    *value = kll->max;
+    for (uint32_t i = 0; i < n; i++) {
+        seen += items[i].weight;
+        if ((double)seen >= rank) {
+            *value = items[i].value;
+            break;
+        }
+    }
+    free(items);
+    return 0;
+}
+
+// Bytes of an encoded sketch
+size_t fxdb_kll_encoded_size(const fxdb_kll_t* kll) {
+    size_t size = KLL_HEADER + (size_t)kll->level_count * sizeof(uint32_t);
+    for (uint32_t h = 0; h < kll->level_count; h++) {
+        size += (size_t)kll->sizes[h] * sizeof(double);
+    }
+    return size;
+}
+
+// Encode a sketch: [k][levels][count][min][max][size per level][values, level 0 first]
+size_t fxdb_kll_encode(const fxdb_kll_t* kll, uint8_t* out) {
+    uint8_t* cursor = out;
+    memcpy(cursor, &kll->k, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    memcpy(cursor, &kll->level_count, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    memcpy(cursor, &kll->count, sizeof(uint64_t));
+    cursor += sizeof(uint64_t);
+    memcpy(cursor, &kll->min, sizeof(double));
+    cursor += sizeof(double);
+    memcpy(cursor, &kll->max, sizeof(double));
+    cursor += sizeof(double);
+    memcpy(cursor, kll->sizes, kll->level_count * sizeof(uint32_t));
+    cursor += kll->level_count * sizeof(uint32_t);
+    for (uint32_t h = 0; h < kll->level_count; h++) {
+        memcpy(cursor, kll->items[h], (size_t)kll->sizes[h] * sizeof(double));
+        cursor += (size_t)kll->sizes[h] * sizeof(double);
+    }
+    return (size_t)(cursor - out);
+}
+
+// Merge an encoded sketch
+int fxdb_kll_merge_encoded(fxdb_kll_t* kll, const uint8_t* data, size_t size) {
+    fxdb_kll_t other;
+    uint32_t k, level_count;
+    if (size < KLL_HEADER) {
+        return -1;
+    }
+    memcpy(&k, data, sizeof(k));
+    memcpy(&level_count, data + sizeof(uint32_t), sizeof(level_count));
+    if (level_count == 0 || level_count > FXDB_KLL_MAX_LEVELS ||
+        size < KLL_HEADER + (size_t)level_count * sizeof(uint32_t)) {
+        return -1;
+    }
+    
+    fxdb_kll_init(&other, k);
+    other.level_count = level_count;
+    memcpy(&other.count, data + 2 * sizeof(uint32_t), sizeof(uint64_t));
+    memcpy(&other.min, data + 2 * sizeof(uint32_t) + sizeof(uint64_t), sizeof(double));
+    memcpy(&other.max, data + 2 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(double), sizeof(double));
+    
+    // The values stay in the encoding; `other` only points at them
+    uint32_t sizes[FXDB_KLL_MAX_LEVELS];
+    memcpy(sizes, data + KLL_HEADER, level_count * sizeof(uint32_t));
+    size_t expected = KLL_HEADER + (size_t)level_count * sizeof(uint32_t);
+    for (uint32_t h = 0; h < level_count; h++) {
+        expected += (size_t)sizes[h] * sizeof(double);
+    }
+    if (expected != size) {
+        return -1;
+    }
+    
+    double* values = malloc(size - KLL_HEADER - level_count * sizeof(uint32_t) + sizeof(double));
+    if (!values) {
+        return -1;
+    }
+    memcpy(values, data + KLL_HEADER + level_count * sizeof(uint32_t),
+           size - KLL_HEADER - level_count * sizeof(uint32_t));
+    double* cursor = values;
+    for (uint32_t h = 0; h < level_count; h++) {
+        other.items[h] = cursor;
+        other.sizes[h] = sizes[h];
+        cursor += sizes[h];
+    }
+    
+    int result = fxdb_kll_merge(kll, &other);
+    free(values);
+    return result;
+}
+
+// Empty a sketch, keeping its memory
+void fxdb_kll_reset(fxdb_kll_t* kll) {
+    uint32_t k = kll->k;
+    double* items[FXDB_KLL_MAX_LEVELS];
+    uint32_t allocated[FXDB_KLL_MAX_LEVELS];
+    memcpy(items, kll->items, sizeof(items));
+    memcpy(allocated, kll->allocated, sizeof(allocated));
+    fxdb_kll_init(kll, k);
+    memcpy(kll->items, items, sizeof(items));
+    memcpy(kll->allocated, allocated, sizeof(allocated));
+}
+
+// Free a sketch's memory
+void fxdb_kll_free(fxdb_kll_t* kll) {
+    for (uint32_t h = 0; h < FXDB_KLL_MAX_LEVELS; h++) {
+        free(kll->items[h]);
+        kll->items[h] = NULL;
+        kll->sizes[h] = 0;
+        kll->allocated[h] = 0;
+    }
+}
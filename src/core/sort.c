@@ -0,0 +1,747 @@
+#include "../../include/sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Every record starts with the row's sequence number and NULL fields
+#define RECORD_HEADER (2 * sizeof(uint64_t))
+#define RUN_BUFFER_SIZE (1 << 16)
+#define SEGMENT_INITIAL_ROWS 256
+
+// Sort key of a held row
+typedef struct {
+    union {
+        uint64_t number;        // Numeric keys mapped to unsigned integers in the same order
+        const char* string;     // Points into the row
+    } key;
+    uint64_t seq;               // Order the row was added in, also the tie-breaker
+    const uint8_t* record;      // Header and row
+    uint32_t string_size;
+    bool is_null;
+} sort_entry_t;
+
+// Rows gathered together, sorted in memory or written out as one run
+typedef struct {
+    uint8_t* records;
+    uint32_t count;
+    uint32_t capacity;          // Records allocated, doubling up to the sorter's segment_rows
+    sort_entry_t* entries;      // In sorted order once the segment is sorted
+    uint32_t entry_capacity;
+    const char* run_path;       // Where the sorted segment is written (NULL keeps it in memory)
+    int result;
+} sort_segment_t;
+
+// One input of a k-way merge: a sorted segment or a run
+typedef struct {
+    const sort_entry_t* entries;
+    uint32_t count;
+    uint32_t next;
+    FILE* file;
+    uint8_t* record;            // Row last read from the run
+    sort_entry_t current;
+} merge_source_t;
+
+typedef struct {
+    merge_source_t* sources;
+    uint32_t source_count;
+    uint32_t* heap;             // Sources with rows left, smallest current row first
+    uint32_t heap_count;
+    bool started;
+} merge_t;
+
+struct fxdb_sorter {
+    const schema_t* schema;
+    fxdb_sort_options_t options;
+    const field_def_t* field;
+    uint32_t key_offset;
+    uint32_t row_size;
+    size_t record_size;
+    int (*compare)(const void*, const void*);
+    uint64_t next_seq;
+    bool finished;
+    
+    // Rows held in memory, the last segment filling
+    sort_segment_t segments[FXDB_SORT_SEGMENTS];
+    uint32_t segment_count;
+    uint32_t segment_rows;      // Records per segment
+    
+    // Runs written and not yet merged, oldest first
+    char** runs;
+    uint32_t run_count;
+    uint32_t run_capacity;
+    uint32_t next_run_id;
+    
+    // Top-N heap, worst row at the root
+    sort_entry_t* heap;
+    uint8_t* heap_records;
+    uint32_t heap_count;
+    
+    merge_t merge;
+    fxdb_sort_stats_t stats;
+};
+
+// Order two keys, NULLs first
+static int compare_keys(const sort_entry_t* x, const sort_entry_t* y, bool strings) {
+    if (x->is_null || y->is_null) {
+        return (int)y->is_null - (int)x->is_null;
+    }
+    if (strings) {
+        return strncmp(x->key.string, y->key.string, x->string_size);
+    }
+    return (x->key.number > y->key.number) - (x->key.number < y->key.number);
+}
+
+// Order two entries by key in the sort's direction, then in the order they were added
+static int compare_entries(const void* a, const void* b, bool strings, bool descending) {
+    const sort_entry_t* x = a;
+    const sort_entry_t* y = b;
+    int cmp = compare_keys(x, y, strings);
+    if (descending) {
+        cmp = -cmp;
+    }
+    if (cmp == 0) {
+        cmp = (x->seq > y->seq) - (x->seq < y->seq);
+    }
+    return cmp;
+}
+
+static int compare_numbers_asc(const void* a, const void* b)  { return compare_entries(a, b, false, false); }
+static int compare_numbers_desc(const void* a, const void* b) { return compare_entries(a, b, false, true); }
+static int compare_strings_asc(const void* a, const void* b)  { return compare_entries(a, b, true, false); }
+static int compare_strings_desc(const void* a, const void* b) { return compare_entries(a, b, true, true); }
+
+// Fill in the key of a row
+static void make_entry(const fxdb_sorter_t* sorter, sort_entry_t* entry, const uint8_t* row,
+                       uint64_t null_fields, uint64_t seq, const uint8_t* record) {
+    const uint8_t* value = row + sorter->key_offset;
+    entry->seq = seq;
+    entry->record = record;
+    entry->string_size = 0;
+    entry->is_null = (null_fields >> sorter->options.field) & 1;
+    entry->key.number = 0;
+    
+    uint32_t bits;
+    switch (sorter->field->type) {
+        case FIELD_TYPE_INT32:
+            memcpy(&bits, value, sizeof(bits));
+            entry->key.number = bits ^ 0x80000000u;
+            break;
+        case FIELD_TYPE_FLOAT:
+            // Negative floats order backwards as integers, so all their bits flip
+            memcpy(&bits, value, sizeof(bits));
+            entry->key.number = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+            break;
+        case FIELD_TYPE_BOOL:
+            entry->key.number = value[0] ? 1 : 0;
+            break;
+        default:
+            entry->key.string = (const char*)value;
+            entry->string_size = sorter->field->size;
+            break;
+    }
+}
+
+// Key of a record
+static void make_record_entry(const fxdb_sorter_t* sorter, sort_entry_t* entry, const uint8_t* record) {
+    uint64_t header[2];
+    memcpy(header, record, sizeof(header));
+    make_entry(sorter, entry, record + RECORD_HEADER, header[1], header[0], record);
+}
+
+// Bytes of a record, rounded so the next one stays aligned
+static size_t record_bytes(const schema_t* schema) {
+    return (RECORD_HEADER + schema->row_size + 7) & ~(size_t)7;
+}
+
+// Create default sort options for a field
+fxdb_sort_options_t fxdb_sort_default_options(uint32_t field) {
+    fxdb_sort_options_t options = {
+        .field = field,
+        .descending = false,
+        .top_n = 0,
+        .memory_limit = 0,
+        .threads = 0,
+        .temp_prefix = NULL
+    };
+    return options;
+}
+
+// Bytes a held row takes
+size_t fxdb_sort_row_bytes(const schema_t* schema) {
+    return schema ? record_bytes(schema) + sizeof(sort_entry_t) : 0;
+}
+
+// Create a sorter
+fxdb_sorter_t* fxdb_sorter_create(const schema_t* schema, const fxdb_sort_options_t* options) {
+    if (!schema || !options) {
+        return NULL;
+    }
+    if (options->field >= schema->field_count) {
+        fprintf(stderr, "Error: Sort field %u out of range\n", options->field);
+        return NULL;
+    }
+    
+    fxdb_sorter_t* sorter = calloc(1, sizeof(fxdb_sorter_t));
+    if (!sorter) {
+        return NULL;
+    }
+    
+    sorter->schema = schema;
+    sorter->options = *options;
+    if (sorter->options.memory_limit == 0) {
+        sorter->options.memory_limit = FXDB_SORT_DEFAULT_MEMORY;
+    }
+    if (sorter->options.threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        sorter->options.threads = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (sorter->options.threads > FXDB_SORT_MAX_THREADS) {
+        sorter->options.threads = FXDB_SORT_MAX_THREADS;
+    }
+    
+    sorter->field = &schema->fields[options->field];
+    sorter->key_offset = schema_field_offset(schema, options->field);
+    sorter->row_size = schema->row_size;
+    sorter->record_size = record_bytes(schema);
+    
+    bool strings = sorter->field->type == FIELD_TYPE_STRING;
+    sorter->compare = strings ? (options->descending ? compare_strings_desc : compare_strings_asc)
+                              : (options->descending ? compare_numbers_desc : compare_numbers_asc);
+    
+    // A segment's records and entries take an even share of the budget
+    size_t rows = sorter->options.memory_limit / FXDB_SORT_SEGMENTS / fxdb_sort_row_bytes(schema);
+    sorter->segment_rows = rows == 0 ? 1 : rows > UINT32_MAX ? UINT32_MAX : (uint32_t)rows;
+    
+    if (options->top_n > 0) {
+        sorter->heap = malloc((size_t)options->top_n * sizeof(sort_entry_t));
+        sorter->heap_records = malloc((size_t)options->top_n * sorter->record_size);
+        if (!sorter->heap || !sorter->heap_records) {
+            fxdb_sorter_free(sorter);
+            return NULL;
+        }
+        sorter->stats.heap = true;
+    }
+    return sorter;
+}
+
+// Write a record's header and row
+static void fill_record(const fxdb_sorter_t* sorter, uint8_t* record, const uint8_t* row,
+                        uint64_t null_fields, uint64_t seq) {
+    uint64_t header[2] = { seq, null_fields };
+    memcpy(record, header, sizeof(header));
+    memcpy(record + RECORD_HEADER, row, sorter->row_size);
+}
+
+// Restore the top-N heap order from a slot down, the largest row at the root
+static void sift_down(sort_entry_t* heap, uint32_t count, uint32_t index, int (*compare)(const void*, const void*)) {
+    for (;;) {
+        uint32_t largest = index;
+        uint32_t left = index * 2 + 1;
+        uint32_t right = left + 1;
+        if (left < count && compare(&heap[left], &heap[largest]) > 0) largest = left;
+        if (right < count && compare(&heap[right], &heap[largest]) > 0) largest = right;
+        if (largest == index) {
+            return;
+        }
+        sort_entry_t swap = heap[index];
+        heap[index] = heap[largest];
+        heap[largest] = swap;
+        index = largest;
+    }
+}
+
+// Keep a row in the top-N heap if it beats the worst one kept
+static void add_to_heap(fxdb_sorter_t* sorter, const uint8_t* row, uint64_t null_fields, uint64_t seq) {
+    if (sorter->heap_count < sorter->options.top_n) {
+        uint8_t* record = sorter->heap_records + (size_t)sorter->heap_count * sorter->record_size;
+        fill_record(sorter, record, row, null_fields, seq);
+        
+        uint32_t index = sorter->heap_count++;
+        make_record_entry(sorter, &sorter->heap[index], record);
+        while (index > 0) {
+            uint32_t parent = (index - 1) / 2;
+            if (sorter->compare(&sorter->heap[index], &sorter->heap[parent]) <= 0) {
+                break;
+            }
+            sort_entry_t swap = sorter->heap[index];
+            sorter->heap[index] = sorter->heap[parent];
+            sorter->heap[parent] = swap;
+            index = parent;
+        }
+        return;
+    }
+    
+    // Later rows lose ties, so a row equal to the worst is dropped too
+    sort_entry_t candidate;
+    make_entry(sorter, &candidate, row, null_fields, seq, NULL);
+    if (sorter->compare(&candidate, &sorter->heap[0]) >= 0) {
+        return;
+    }
+    uint8_t* record = (uint8_t*)sorter->heap[0].record;
+    fill_record(sorter, record, row, null_fields, seq);
+    make_record_entry(sorter, &sorter->heap[0], record);
+    sift_down(sorter->heap, sorter->heap_count, 0, sorter->compare);
+}
+
+// Name the next run
+static char* next_run_path(fxdb_sorter_t* sorter) {
+    const char* prefix = sorter->options.temp_prefix ? sorter->options.temp_prefix : "flexon";
+    size_t length = strlen(prefix) + 48;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s.sort%d-%u", prefix, (int)getpid(), sorter->next_run_id++);
+    }
+    return path;
+}
+
+// Add a run to the list to merge
+static int push_run(fxdb_sorter_t* sorter, char* path) {
+    if (sorter->run_count == sorter->run_capacity) {
+        uint32_t capacity = sorter->run_capacity ? sorter->run_capacity * 2 : 16;
+        char** runs = realloc(sorter->runs, capacity * sizeof(char*));
+        if (!runs) {
+            return -1;
+        }
+        sorter->runs = runs;
+        sorter->run_capacity = capacity;
+    }
+    sorter->runs[sorter->run_count++] = path;
+    sorter->stats.runs++;
+    return 0;
+}
+
+// Open a run for writing
+static FILE* create_run(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create sort run %s\n", path);
+        return NULL;
+    }
+    setvbuf(file, NULL, _IOFBF, RUN_BUFFER_SIZE);
+    return file;
+}
+
+// Sort a segment and, when it has a run path, write it out
+static void sort_segment(const fxdb_sorter_t* sorter, sort_segment_t* segment) {
+    segment->result = 0;
+    if (segment->entry_capacity < segment->count) {
+        sort_entry_t* entries = realloc(segment->entries, (size_t)segment->count * sizeof(sort_entry_t));
+        if (!entries) {
+            segment->result = -1;
+            return;
+        }
+        segment->entries = entries;
+        segment->entry_capacity = segment->count;
+    }
+    for (uint32_t i = 0; i < segment->count; i++) {
+        const uint8_t* record = segment->records + (size_t)i * sorter->record_size;
+        make_record_entry(sorter, &segment->entries[i], record);
+    }
+    qsort(segment->entries, segment->count, sizeof(sort_entry_t), sorter->compare);
+    
+    if (!segment->run_path) {
+        return;
+    }
+    FILE* file = create_run(segment->run_path);
+    if (!file) {
+        segment->result = -1;
+        return;
+    }
+    for (uint32_t i = 0; i < segment->count && segment->result == 0; i++) {
+        if (fwrite(segment->entries[i].record, sorter->record_size, 1, file) != 1) {
+            segment->result = -1;
+        }
+    }
+    if (fclose(file) != 0) {
+        segment->result = -1;
+    }
+}
+
+// One thread's share of the segments
+typedef struct {
+    const fxdb_sorter_t* sorter;
+    uint32_t first;
+    uint32_t step;
+} sort_task_t;
+
+static void* sort_main(void* arg) {
+    sort_task_t* task = arg;
+    fxdb_sorter_t* sorter = (fxdb_sorter_t*)task->sorter;
+    for (uint32_t i = task->first; i < sorter->segment_count; i += task->step) {
+        sort_segment(sorter, &sorter->segments[i]);
+    }
+    return NULL;
+}
+
+// Sort the held segments in parallel, writing them out when `spill` is set
+static int sort_segments(fxdb_sorter_t* sorter, bool spill) {
+    int result = 0;
+    for (uint32_t i = 0; i < sorter->segment_count; i++) {
+        sorter->segments[i].run_path = NULL;
+        if (spill) {
+            char* path = next_run_path(sorter);
+            if (!path || push_run(sorter, path) != 0) {
+                free(path);
+                return -1;
+            }
+            sorter->segments[i].run_path = path;
+            sorter->stats.bytes_spilled += (uint64_t)sorter->segments[i].count * sorter->record_size;
+        }
+    }
+    
+    uint32_t threads = sorter->options.threads < sorter->segment_count ? sorter->options.threads
+                                                                         : sorter->segment_count;
+    sort_task_t tasks[FXDB_SORT_MAX_THREADS];
+    pthread_t handles[FXDB_SORT_MAX_THREADS];
+    bool started[FXDB_SORT_MAX_THREADS] = { false };
+    for (uint32_t t = 0; t < threads; t++) {
+        tasks[t].sorter = sorter;
+        tasks[t].first = t;
+        tasks[t].step = threads;
+    }
+    
+    // The calling thread takes the first share itself; a failed start falls back to it too
+    for (uint32_t t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, sort_main, &tasks[t]) == 0;
+    }
+    if (threads > 0) {
+        sort_main(&tasks[0]);
+    }
+    for (uint32_t t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        } else {
+            sort_main(&tasks[t]);
+        }
+    }
+    
+    for (uint32_t i = 0; i < sorter->segment_count; i++) {
+        if (sorter->segments[i].result != 0) {
+            result = -1;
+        }
+    }
+    sorter->stats.segments += sorter->segment_count;
+    if (threads > sorter->stats.threads) {
+        sorter->stats.threads = threads;
+    }
+    return result;
+}
+
+// Add a row
+int fxdb_sorter_add(fxdb_sorter_t* sorter, const uint8_t* row, uint64_t null_fields) {
+    if (!sorter || !row || sorter->finished) {
+        return -1;
+    }
+    
+    uint64_t seq = sorter->next_seq++;
+    sorter->stats.rows++;
+    if (sorter->heap) {
+        add_to_heap(sorter, row, null_fields, seq);
+        return 0;
+    }
+    
+    // Move on to the next segment, writing the held ones out once all are full
+    sort_segment_t* segment = sorter->segment_count ? &sorter->segments[sorter->segment_count - 1] : NULL;
+    if (!segment || segment->count == sorter->segment_rows) {
+        if (sorter->segment_count == FXDB_SORT_SEGMENTS) {
+            if (sort_segments(sorter, true) != 0) {
+                return -1;
+            }
+            for (uint32_t i = 0; i < sorter->segment_count; i++) {
+                sorter->segments[i].count = 0;
+            }
+            sorter->segment_count = 0;
+        }
+        
+        segment = &sorter->segments[sorter->segment_count];
+        segment->count = 0;
+        sorter->segment_count++;
+    }
+    
+    // Segments grow as rows arrive, so small sorts stay small
+    if (segment->count == segment->capacity) {
+        uint32_t capacity = segment->capacity ? segment->capacity * 2 : SEGMENT_INITIAL_ROWS;
+        if (capacity > sorter->segment_rows) {
+            capacity = sorter->segment_rows;
+        }
+        uint8_t* records = realloc(segment->records, (size_t)capacity * sorter->record_size);
+        if (!records) {
+            return -1;
+        }
+        segment->records = records;
+        segment->capacity = capacity;
+    }
+    
+    fill_record(sorter, segment->records + (size_t)segment->count * sorter->record_size, row, null_fields, seq);
+    segment->count++;
+    return 0;
+}
+
+// Swap two merge heap slots
+static void swap_sources(merge_t* merge, uint32_t a, uint32_t b) {
+    uint32_t swap = merge->heap[a];
+    merge->heap[a] = merge->heap[b];
+    merge->heap[b] = swap;
+}
+
+// Restore the merge heap from a slot down, smallest current row first
+static void merge_sift_down(const fxdb_sorter_t* sorter, merge_t* merge, uint32_t index) {
+    for (;;) {
+        uint32_t smallest = index;
+        uint32_t left = index * 2 + 1;
+        uint32_t right = left + 1;
+        if (left < merge->heap_count &&
+            sorter->compare(&merge->sources[merge->heap[left]].current,
+                            &merge->sources[merge->heap[smallest]].current) < 0) {
+            smallest = left;
+        }
+        if (right < merge->heap_count &&
+            sorter->compare(&merge->sources[merge->heap[right]].current,
+                            &merge->sources[merge->heap[smallest]].current) < 0) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+        swap_sources(merge, index, smallest);
+        index = smallest;
+    }
+}
+
+// Step a source to its next row; returns 1 for a row, 0 at its end, -1 on error
+static int source_advance(const fxdb_sorter_t* sorter, merge_source_t* source) {
+    if (!source->file) {
+        if (source->next == source->count) {
+            return 0;
+        }
+        source->current = source->entries[source->next++];
+        return 1;
+    }
+    
+    if (fread(source->record, sorter->record_size, 1, source->file) != 1) {
+        return ferror(source->file) ? -1 : 0;
+    }
+    make_record_entry(sorter, &source->current, source->record);
+    return 1;
+}
+
+static void merge_close(merge_t* merge) {
+    for (uint32_t i = 0; i < merge->source_count; i++) {
+        if (merge->sources[i].file) {
+            fclose(merge->sources[i].file);
+        }
+        free(merge->sources[i].record);
+    }
+    free(merge->sources);
+    free(merge->heap);
+    memset(merge, 0, sizeof(*merge));
+}
+
+// Start a merge of `count` inputs, runs when `paths` is set and held segments otherwise
+static int merge_open(const fxdb_sorter_t* sorter, merge_t* merge, char** paths, uint32_t count) {
+    memset(merge, 0, sizeof(*merge));
+    merge->sources = calloc(count ? count : 1, sizeof(merge_source_t));
+    merge->heap = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!merge->sources || !merge->heap) {
+        merge_close(merge);
+        return -1;
+    }
+    merge->source_count = count;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        merge_source_t* source = &merge->sources[i];
+        if (paths) {
+            source->file = fopen(paths[i], "rb");
+            source->record = malloc(sorter->record_size);
+            if (!source->file || !source->record) {
+                fprintf(stderr, "Error: Cannot open sort run %s\n", paths[i]);
+                merge_close(merge);
+                return -1;
+            }
+            setvbuf(source->file, NULL, _IOFBF, RUN_BUFFER_SIZE);
+        } else {
+            source->entries = sorter->segments[i].entries;
+            source->count = sorter->segments[i].count;
+        }
+        
+        int has_row = source_advance(sorter, source);
+        if (has_row < 0) {
+            merge_close(merge);
+            return -1;
+        }
+        if (has_row) {
+            merge->heap[merge->heap_count++] = i;
+        }
+    }
+    
+    for (uint32_t i = merge->heap_count / 2; i-- > 0;) {
+        merge_sift_down(sorter, merge, i);
+    }
+    return 0;
+}
+
+// Next row of a merge: the smallest current row, after stepping the source of the last one
+static int merge_next(const fxdb_sorter_t* sorter, merge_t* merge, const sort_entry_t** entry) {
+    if (merge->started && merge->heap_count > 0) {
+        int has_row = source_advance(sorter, &merge->sources[merge->heap[0]]);
+        if (has_row < 0) {
+            return -1;
+        }
+        if (!has_row) {
+            merge->heap[0] = merge->heap[--merge->heap_count];
+        }
+        merge_sift_down(sorter, merge, 0);
+    }
+    merge->started = true;
+    
+    if (merge->heap_count == 0) {
+        return 0;
+    }
+    *entry = &merge->sources[merge->heap[0]].current;
+    return 1;
+}
+
+// Remove the first `count` runs from the list, deleting their files
+static void drop_runs(fxdb_sorter_t* sorter, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        remove(sorter->runs[i]);
+        free(sorter->runs[i]);
+    }
+    memmove(sorter->runs, sorter->runs + count, (sorter->run_count - count) * sizeof(char*));
+    sorter->run_count -= count;
+}
+
+// Merge the oldest runs into one new run until a single merge can take them all
+static int merge_passes(fxdb_sorter_t* sorter) {
+    while (sorter->run_count > FXDB_SORT_MAX_FANIN) {
+        char* path = next_run_path(sorter);
+        FILE* out = path ? create_run(path) : NULL;
+        merge_t merge;
+        if (!out || merge_open(sorter, &merge, sorter->runs, FXDB_SORT_MAX_FANIN) != 0) {
+            if (out) {
+                fclose(out);
+                remove(path);
+            }
+            free(path);
+            return -1;
+        }
+        
+        const sort_entry_t* entry;
+        int has_row;
+        int result = 0;
+        while ((has_row = merge_next(sorter, &merge, &entry)) > 0) {
+            if (fwrite(entry->record, sorter->record_size, 1, out) != 1) {
+                result = -1;
+                break;
+            }
+            sorter->stats.bytes_spilled += sorter->record_size;
+        }
+        merge_close(&merge);
+        if (fclose(out) != 0 || has_row < 0 || result != 0 || push_run(sorter, path) != 0) {
+            remove(path);
+            free(path);
+            return -1;
+        }
+        drop_runs(sorter, FXDB_SORT_MAX_FANIN);
+        sorter->stats.merge_passes++;
+    }
+    return 0;
+}
+
+// End the input and prepare the merge
+int fxdb_sorter_finish(fxdb_sorter_t* sorter) {
+    if (!sorter || sorter->finished) {
+        return -1;
+    }
+    sorter->finished = true;
+    
+    // The heap's rows become one sorted segment
+    if (sorter->heap) {
+        qsort(sorter->heap, sorter->heap_count, sizeof(sort_entry_t), sorter->compare);
+        sorter->merge.sources = calloc(1, sizeof(merge_source_t));
+        sorter->merge.heap = malloc(sizeof(uint32_t));
+        if (!sorter->merge.sources || !sorter->merge.heap) {
+            return -1;
+        }
+        sorter->merge.source_count = 1;
+        sorter->merge.sources[0].entries = sorter->heap;
+        sorter->merge.sources[0].count = sorter->heap_count;
+        if (source_advance(sorter, &sorter->merge.sources[0]) > 0) {
+            sorter->merge.heap[sorter->merge.heap_count++] = 0;
+        }
+        return 0;
+    }
+    
+    // Everything fit in memory: merge the sorted segments directly
+    if (sorter->run_count == 0) {
+        if (sort_segments(sorter, false) != 0) {
+            return -1;
+        }
+        if (sorter->segment_count > 0) {
+            sorter->stats.merge_passes = 1;
+        }
+        return merge_open(sorter, &sorter->merge, NULL, sorter->segment_count);
+    }
+    
+    // Write out what is held, then merge the runs
+    if (sorter->segment_count > 0 && sort_segments(sorter, true) != 0) {
+        return -1;
+    }
+    sorter->segment_count = 0;
+    if (merge_passes(sorter) != 0) {
+        return -1;
+    }
+    sorter->stats.merge_passes++;
+    return merge_open(sorter, &sorter->merge, sorter->runs, sorter->run_count);
+}
+
+// Take the next row in order
+int fxdb_sorter_next(fxdb_sorter_t* sorter, const uint8_t** row, uint64_t* null_fields) {
+    if (!sorter || !row || !sorter->finished) {
+        return -1;
+    }
+    
+    const sort_entry_t* entry;
+    int has_row = merge_next(sorter, &sorter->merge, &entry);
+    if (has_row <= 0) {
+        return has_row;
+    }
+    
+    uint64_t header[2];
+    memcpy(header, entry->record, sizeof(header));
+    *row = entry->record + RECORD_HEADER;
+    if (null_fields) {
+        *null_fields = header[1];
+    }
+    return 1;
+}
+
+// What the sorter has done so far
+void fxdb_sorter_stats(const fxdb_sorter_t* sorter, fxdb_sort_stats_t* stats) {
+    if (sorter && stats) {
+        *stats = sorter->stats;
+    }
+}
+
+// Free a sorter and remove its runs
+void fxdb_sorter_free(fxdb_sorter_t* sorter) {
+    if (!sorter) {
+        return;
+    }
+    
+    merge_close(&sorter->merge);
+    drop_runs(sorter, sorter->run_count);
+    free(sorter->runs);
+    for (uint32_t i = 0; i < FXDB_SORT_SEGMENTS; i++) {
+        free(sorter->segments[i].records);
+        free(sorter->segments[i].entries);
+    }
+    free(sorter->heap);
+    free(sorter->heap_records);
+    free(sorter);
+}
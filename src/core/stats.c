@@ -0,0 +1,462 @@
+#include "../../include/stats.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/io_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+// Shortest interval the TSC rate is measured over
+#define TSC_CALIBRATION_NS 5000000ULL
+
+__thread fxdb_thread_stats_t* fxdb_thread_stats = NULL;
+bool fxdb_ticks_use_tsc = false;
+bool fxdb_tracing = false;
+
+// Counters and histograms summed over threads
+typedef struct {
+    uint64_t counters[FXDB_STAT_COUNT];
+    fxdb_histogram_t latency[FXDB_LATENCY_COUNT];
+} stats_totals_t;
+
+// Registry of live thread blocks and what exited threads left behind, guarded by stats_lock
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static fxdb_thread_stats_t* live_threads = NULL;
+static uint32_t next_thread_id = 1;
+static stats_totals_t retired;
+static stats_totals_t reset_base;  // Totals at the last reset
+
+// Tick source reference points, taken at load time
+static uint64_t base_ticks = 0;
+static uint64_t base_ns = 0;
+
+// Trace output, guarded by trace_lock
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE* trace_file = NULL;
+static bool trace_first_event = true;
+
+static const char* op_names[FXDB_LATENCY_COUNT] = {
+    "open", "schema_load", "chunk_load", "insert", "flush", "commit", "close"
+};
+
+static void add_histogram(fxdb_histogram_t* total, const fxdb_histogram_t* histogram) {
+    for (uint32_t b = 0; b < FXDB_HISTOGRAM_BUCKETS; b++) {
+        total->counts[b] += __atomic_load_n(&histogram->counts[b], __ATOMIC_RELAXED);
+    }
+    total->count += __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    total->sum += __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    if (max > total->max) {
+        total->max = max;
+    }
+}
+
+static void add_thread(stats_totals_t* totals, const fxdb_thread_stats_t* local) {
+    for (int i = 0; i < FXDB_STAT_COUNT; i++) {
+        totals->counters[i] += __atomic_load_n(&local->counters[i], __ATOMIC_RELAXED);
+    }
+    for (int op = 0; op < FXDB_LATENCY_COUNT; op++) {
+        add_histogram(&totals->latency[op], &local->latency[op]);
+    }
+}
+
+// Fold an exiting thread's counters into the retired totals
+static void retire_thread(void* arg) {
+    fxdb_thread_stats_t* local = arg;
+    pthread_mutex_lock(&stats_lock);
+    fxdb_thread_stats_t** link = &live_threads;
+    while (*link && *link != local) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = local->next;
+    }
+    add_thread(&retired, local);
+    pthread_mutex_unlock(&stats_lock);
+    
+    fxdb_thread_stats = NULL;
+    free(local);
+}
+
+static void create_key(void) {
+    pthread_key_create(&stats_key, retire_thread);
+}
+
+// Allocate and register the calling thread's block
+fxdb_thread_stats_t* fxdb_stats_register(void) {
+    pthread_once(&stats_once, create_key);
+    fxdb_thread_stats_t* local = calloc(1, sizeof(fxdb_thread_stats_t));
+    if (!local) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&stats_lock);
+    local->thread_id = next_thread_id++;
+    local->next = live_threads;
+    live_threads = local;
+    pthread_mutex_unlock(&stats_lock);
+    
+    pthread_setspecific(stats_key, local);
+    fxdb_thread_stats = local;
+    return local;
+}
+
+// Monotonic clock in nanoseconds
+uint64_t fxdb_stats_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// fxdb_sync_file, counted as a sync call
+int fxdb_stats_sync_file(int fd) {
+    uint64_t start = fxdb_stats_clock();
+    int result = fxdb_sync_file(fd);
+    fxdb_stats_add(FXDB_STAT_WRITE_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_SYNC_CALLS, 1);
+    return result;
+}
+
+// Sum every thread's counters and histograms; call with stats_lock held
+static void sum_threads(stats_totals_t* totals) {
+    *totals = retired;
+    for (const fxdb_thread_stats_t* t = live_threads; t; t = t->next) {
+        add_thread(totals, t);
+    }
+}
+
+// Busy time of each live thread
+uint32_t fxdb_get_thread_busy(fxdb_thread_busy_t* threads, uint32_t capacity) {
+    uint32_t count = 0;
+    pthread_mutex_lock(&stats_lock);
+    for (const fxdb_thread_stats_t* t = live_threads; t && count < capacity; t = t->next) {
+        threads[count].thread_id = t->thread_id;
+        threads[count].busy_ns = __atomic_load_n(&t->counters[FXDB_STAT_READ_NS], __ATOMIC_RELAXED) +
+                                 __atomic_load_n(&t->counters[FXDB_STAT_WRITE_NS], __ATOMIC_RELAXED) +
+                                 __atomic_load_n(&t->counters[FXDB_STAT_DECODE_NS], __ATOMIC_RELAXED);
+        count++;
+    }
+    pthread_mutex_unlock(&stats_lock);
+    return count;
+}
+
+// Fill the counters since the last reset and the chunk cache figures
+void fxdb_get_statistics(db_statistics_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    uint64_t c[FXDB_STAT_COUNT];
+    stats_totals_t* totals = malloc(sizeof(stats_totals_t));
+    if (!totals) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&stats_lock);
+    sum_threads(totals);
+    for (int i = 0; i < FXDB_STAT_COUNT; i++) {
+        c[i] = totals->counters[i] - reset_base.counters[i];
+    }
+    pthread_mutex_unlock(&stats_lock);
+    free(totals);
+    
+    memset(stats, 0, sizeof(*stats));
+    fxdb_chunk_cache_get_statistics(stats);
+    stats->total_reads = c[FXDB_STAT_READ_CALLS];
+    stats->total_writes = c[FXDB_STAT_WRITE_OPS];
+    stats->bytes_read = c[FXDB_STAT_BYTES_READ];
+    stats->bytes_written = c[FXDB_STAT_BYTES_WRITTEN];
+    stats->read_calls = c[FXDB_STAT_READ_CALLS];
+    stats->write_ops = c[FXDB_STAT_WRITE_OPS];
+    stats->sync_calls = c[FXDB_STAT_SYNC_CALLS];
+    stats->chunks_loaded = c[FXDB_STAT_CHUNKS_LOADED];
+    stats->chunks_written = c[FXDB_STAT_CHUNKS_WRITTEN];
+    stats->rows_decoded = c[FXDB_STAT_ROWS_DECODED];
+    stats->rows_encoded = c[FXDB_STAT_ROWS_ENCODED];
+    stats->allocations = c[FXDB_STAT_ALLOCATIONS];
+    stats->read_io_time = c[FXDB_STAT_READ_NS] / 1e6;
+    stats->write_io_time = c[FXDB_STAT_WRITE_NS] / 1e6;
+    stats->decode_time = c[FXDB_STAT_DECODE_NS] / 1e6;
+    stats->avg_read_time = stats->read_calls ? stats->read_io_time / stats->read_calls : 0.0;
+    uint64_t timed_writes = stats->write_ops + stats->sync_calls;
+    stats->avg_write_time = timed_writes ? stats->write_io_time / timed_writes : 0.0;
+}
+
+// Start the counters and histograms over from zero
+void fxdb_reset_statistics(void) {
+    pthread_mutex_lock(&stats_lock);
+    sum_threads(&reset_base);
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Whether the TSC ticks at a constant rate across frequency changes and sleep states
+static bool tsc_invariant(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007 &&
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return (edx >> 8) & 1;
+    }
+#endif
+    return false;
+}
+
+// Finish the trace file
+void fxdb_trace_stop(void) {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file) {
+        fputs("\n]\n", trace_file);
+        fclose(trace_file);
+        trace_file = NULL;
+        fxdb_tracing = false;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// The file is finished at exit when the program does not stop the trace itself
+static void register_trace_exit(void) {
+    atexit(fxdb_trace_stop);
+}
+
+// Write spans to `path` from now on
+int fxdb_trace_start(const char* path) {
+    static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+    if (!path) {
+        return -1;
+    }
+    
+    fxdb_trace_stop();
+    pthread_mutex_lock(&trace_lock);
+    trace_file = fopen(path, "w");
+    if (trace_file) {
+        fputs("[", trace_file);
+        trace_first_event = true;
+        fxdb_tracing = true;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    if (!trace_file) {
+        fprintf(stderr, "Error: Cannot open trace file '%s'\n", path);
+        return -1;
+    }
+    
+    pthread_once(&exit_once, register_trace_exit);
+    return 0;
+}
+
+// Pick the tick source and open the trace file before any operation runs
+__attribute__((constructor))
+static void stats_init(void) {
+    fxdb_ticks_use_tsc = tsc_invariant();
+    base_ns = fxdb_stats_clock();
+    base_ticks = fxdb_ticks();
+    
+    const char* path = getenv(FXDB_TRACE_ENV);
+    if (path && *path) {
+        fxdb_trace_start(path);
+    }
+}
+
+// Nanoseconds per tick
+// The TSC rate is measured against the monotonic clock since load time, so it
+// drifts slightly between calls; values compared with each other share one rate
+static double ns_per_tick(void) {
+    if (!fxdb_ticks_use_tsc) {
+        return 1.0;
+    }
+    
+    uint64_t now_ns = fxdb_stats_clock();
+    while (now_ns - base_ns < TSC_CALIBRATION_NS) {
+        now_ns = fxdb_stats_clock();
+    }
+    uint64_t now_ticks = fxdb_ticks();
+    return (double)(now_ns - base_ns) / (double)(now_ticks - base_ticks);
+}
+
+// Convert ticks to nanoseconds
+double fxdb_ticks_to_ns(uint64_t ticks) {
+    return (double)ticks * ns_per_tick();
+}
+
+// Largest value that falls in a bucket
+uint64_t fxdb_histogram_bucket_limit(uint32_t bucket) {
+    uint32_t sub = 1u << FXDB_HISTOGRAM_SUB_BITS;
+    if (bucket < sub) {
+        return bucket;
+    }
+    if (bucket >= FXDB_HISTOGRAM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    uint32_t shift = (bucket >> FXDB_HISTOGRAM_SUB_BITS) - 1;
+    uint64_t mantissa = (bucket & (sub - 1)) + sub;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+// Value below which a fraction q of the recorded values fall
+uint64_t fxdb_histogram_percentile(const fxdb_histogram_t* histogram, double q) {
+    if (!histogram || histogram->count == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = (uint64_t)(q * (double)histogram->count + 0.5);
+    rank = rank < 1 ? 1 : rank > histogram->count ? histogram->count : rank;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < FXDB_HISTOGRAM_BUCKETS; b++) {
+        seen += histogram->counts[b];
+        if (seen >= rank) {
+            uint64_t limit = fxdb_histogram_bucket_limit(b);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+// Write one complete-span event; call with trace_lock held
+static void write_span(const char* name, const char* category, const char* detail,
+                       uint64_t start_ns, double duration_ns, uint32_t thread_id) {
+    fprintf(trace_file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%d,\"tid\":%u",
+            trace_first_event ? "" : ",", name, category, start_ns / 1e3, duration_ns / 1e3,
+            (int)getpid(), thread_id);
+    if (detail) {
+        fprintf(trace_file, ",\"args\":{\"detail\":\"%s\"}", detail);
+    }
+    fputc('}', trace_file);
+    trace_first_event = false;
+}
+
+// Record an operation's latency, and write its span when tracing
+void fxdb_op_end(fxdb_latency_op_t op, const char* name, const char* detail, fxdb_op_timer_t timer) {
+    fxdb_op_end_weighted(op, name, detail, timer, 1);
+}
+
+// Record a sampled operation's latency once per operation it stands for
+void fxdb_op_end_weighted(fxdb_latency_op_t op, const char* name, const char* detail, fxdb_op_timer_t timer,
+                          uint32_t weight) {
+    uint64_t elapsed = fxdb_ticks() - timer.ticks;
+    fxdb_thread_stats_t* local = fxdb_thread_stats ? fxdb_thread_stats : fxdb_stats_register();
+    if (!local || op >= FXDB_LATENCY_COUNT) {
+        return;
+    }
+    fxdb_histogram_record_n(&local->latency[op], elapsed, weight);
+    
+    if (fxdb_tracing && timer.ns) {
+        uint64_t end_ns = fxdb_stats_clock();
+        pthread_mutex_lock(&trace_lock);
+        if (trace_file) {
+            write_span(name, op_names[op], detail, timer.ns, (double)(end_ns - timer.ns), local->thread_id);
+        }
+        pthread_mutex_unlock(&trace_lock);
+    }
+}
+
+// Name of an operation
+const char* fxdb_op_name(fxdb_latency_op_t op) {
+    return op < FXDB_LATENCY_COUNT ? op_names[op] : "unknown";
+}
+
+// Latency histogram of an operation since the last reset
+void fxdb_get_latency(fxdb_latency_op_t op, fxdb_histogram_t* histogram) {
+    if (!histogram) {
+        return;
+    }
+    memset(histogram, 0, sizeof(*histogram));
+    if (op >= FXDB_LATENCY_COUNT) {
+        return;
+    }
+    
+    pthread_mutex_lock(&stats_lock);
+    add_histogram(histogram, &retired.latency[op]);
+    for (const fxdb_thread_stats_t* t = live_threads; t; t = t->next) {
+        add_histogram(histogram, &t->latency[op]);
+    }
+    
+    // Take out what was there at the last reset; the maximum is then bounded
+    // by the highest bucket still holding values
+    const fxdb_histogram_t* base = &reset_base.latency[op];
+    uint64_t max = 0;
+    for (uint32_t b = 0; b < FXDB_HISTOGRAM_BUCKETS; b++) {
+        histogram->counts[b] -= base->counts[b];
+        if (histogram->counts[b] > 0) {
+            max = fxdb_histogram_bucket_limit(b);
+        }
+    }
+    histogram->count -= base->count;
+    histogram->sum -= base->sum;
+    histogram->max = max < histogram->max ? max : histogram->max;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Count, mean, percentiles and maximum of an operation's latency
+void fxdb_get_latency_summary(fxdb_latency_op_t op, fxdb_latency_summary_t* summary) {
+    if (!summary) {
+        return;
+    }
+    memset(summary, 0, sizeof(*summary));
+    
+    fxdb_histogram_t* histogram = malloc(sizeof(fxdb_histogram_t));
+    if (!histogram) {
+        return;
+    }
+    fxdb_get_latency(op, histogram);
+    if (histogram->count > 0) {
+        // One rate for every figure, so percentiles never exceed the maximum
+        double scale = ns_per_tick();
+        summary->count = histogram->count;
+        summary->mean_ns = (double)histogram->sum * scale / (double)histogram->count;
+        summary->p50_ns = (double)fxdb_histogram_percentile(histogram, 0.50) * scale;
+        summary->p90_ns = (double)fxdb_histogram_percentile(histogram, 0.90) * scale;
+        summary->p99_ns = (double)fxdb_histogram_percentile(histogram, 0.99) * scale;
+        summary->p999_ns = (double)fxdb_histogram_percentile(histogram, 0.999) * scale;
+        summary->max_ns = (double)histogram->max * scale;
+    }
+    free(histogram);
+}
+
+// Print statistics as an indented report
+void fxdb_print_statistics(const db_statistics_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    printf("  Read:      %llu bytes in %llu calls, %.2f ms\n",
+           (unsigned long long)stats->bytes_read, (unsigned long long)stats->read_calls, stats->read_io_time);
+    printf("  Written:   %llu bytes in %llu write operations and %llu syncs, %.2f ms\n",
+           (unsigned long long)stats->bytes_written, (unsigned long long)stats->write_ops,
+           (unsigned long long)stats->sync_calls, stats->write_io_time);
+    printf("  Chunks:    %llu loaded, %llu written\n",
+           (unsigned long long)stats->chunks_loaded, (unsigned long long)stats->chunks_written);
+    printf("  Decoded:   %llu rows, %.2f ms, %llu allocations\n",
+           (unsigned long long)stats->rows_decoded, stats->decode_time, (unsigned long long)stats->allocations);
+    printf("  Encoded:   %llu rows\n", (unsigned long long)stats->rows_encoded);
+    
+    uint64_t lookups = stats->cache_hits + stats->cache_misses;
+    printf("  Cache:     %llu hits, %llu misses (%.1f%% hit rate)\n",
+           (unsigned long long)stats->cache_hits, (unsigned long long)stats->cache_misses,
+           lookups ? 100.0 * (double)stats->cache_hits / (double)lookups : 0.0);
+    printf("  Memory:    %llu bytes cached, %llu peak\n",
+           (unsigned long long)stats->memory_usage, (unsigned long long)stats->peak_memory_usage);
+}
+
+// Print the latency percentiles of every operation that ran
+void fxdb_print_latency(void) {
+    printf("  %-12s %10s %10s %10s %10s %10s %10s\n", "Operation", "Count", "Mean us", "p50 us", "p99 us",
+           "p99.9 us", "Max us");
+    for (int op = 0; op < FXDB_LATENCY_COUNT; op++) {
+        fxdb_latency_summary_t summary;
+        fxdb_get_latency_summary((fxdb_latency_op_t)op, &summary);
+        if (summary.count == 0) {
+            continue;
+        }
+        printf("  %-12s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", op_names[op],
+               (unsigned long long)summary.count, summary.mean_ns / 1e3, summary.p50_ns / 1e3,
+               summary.p99_ns / 1e3, summary.p999_ns / 1e3, summary.max_ns / 1e3);
+    }
+}
@@ -0,0 +1,615 @@
+#include "../../include/summary.h"
+#include "../../include/config.h"
+#include "../../include/bitmap.h"
+#include "../../include/utils.h"
+#include "../../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+// What precedes each summary
+typedef struct {
+    uint32_t checksum;          // Over the fields below and the payload
+    uint32_t chunk_index;
+    uint32_t size;              // Payload bytes
+} __attribute__((packed)) summary_record_t;
+
+#define RECORD_FIELDS (sizeof(summary_record_t) - sizeof(uint32_t))
+#define MAX_PAYLOAD (64u << 20) // Larger sizes can only come from a damaged file
+
+struct fxdb_summary_writer {
+    FILE* file;
+    const schema_t* schema;
+    uint64_t null_mask;
+    fxdb_column_sketch_t* sketches; // Reused for every chunk
+};
+
+// Path of the summary file belonging to a database file
+char* summary_path(const char* db_path) {
+    if (!db_path) {
+        return NULL;
+    }
+    
+    size_t length = strlen(db_path) + strlen(SUMMARY_EXT) + 1;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s%s", db_path, SUMMARY_EXT);
+    }
+    return path;
+}
+
+// Start empty column sketches
+void summary_sketch_init(fxdb_column_sketch_t* sketch) {
+    fxdb_hll_init(&sketch->distinct);
+    fxdb_kll_init(&sketch->quantiles, FXDB_KLL_DEFAULT_K);
+    sketch->value_count = 0;
+    sketch->sum = 0.0;
+    sketch->min = INFINITY;
+    sketch->max = -INFINITY;
+}
+
+// Free the memory of column sketches
+void summary_sketch_free(fxdb_column_sketch_t* sketch) {
+    if (sketch) {
+        fxdb_kll_free(&sketch->quantiles);
+    }
+}
+
+static bool is_numeric(field_type_t type) {
+    return type == FIELD_TYPE_INT32 || type == FIELD_TYPE_FLOAT;
+}
+
+// Add rows in chunk layout to column sketches
+int summary_add_rows(const schema_t* schema, uint64_t null_mask, const uint8_t* rows, uint32_t row_count,
+                     const uint64_t* validity, uint32_t validity_words, const uint64_t* deleted,
+                     uint64_t fields, fxdb_column_sketch_t* sketches) {
+    uint32_t row_size = schema->row_size;
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        if (!((fields >> f) & 1)) {
+            continue;
+        }
+        
+        const field_def_t* field = &schema->fields[f];
+        fxdb_column_sketch_t* sketch = &sketches[f];
+        const uint64_t* present = ((null_mask >> f) & 1) && validity
+            ? validity + (size_t)fxdb_null_ordinal(null_mask, f) * validity_words : NULL;
+        const uint8_t* value = rows + schema_field_offset(schema, f);
+        
+        for (uint32_t r = 0; r < row_count; r++, value += row_size) {
+            if ((deleted && fxdb_bitmap_get(deleted, r)) || (present && !fxdb_bitmap_get(present, r))) {
+                continue;
+            }
+            sketch->value_count++;
+            fxdb_hll_add(&sketch->distinct, fxdb_hash_value(field, value));
+            
+            double number;
+            if (field->type == FIELD_TYPE_INT32) {
+                int32_t iv;
+                memcpy(&iv, value, sizeof(iv));
+                number = iv;
+            } else if (field->type == FIELD_TYPE_FLOAT) {
+                float fv;
+                memcpy(&fv, value, sizeof(fv));
+                number = fv;
+            } else {
+                continue;
+            }
+            
+            // As reader_aggregate_column() folds them: NaN poisons the sum and no comparison
+            sketch->sum += number;
+            sketch->min = number < sketch->min ? number : sketch->min;
+            sketch->max = number > sketch->max ? number : sketch->max;
+            if (number != number) {
+                continue; // NaN has no rank
+            }
+            if (fxdb_kll_add(&sketch->quantiles, number) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Bytes of a field's aggregates: non-NULL values, sum, min and max
+#define AGGREGATE_BYTES (sizeof(uint64_t) + 3 * sizeof(double))
+
+// Encode the aggregates, then the sketches, of every field after the chunk's row count
+static uint8_t* encode_sketches(const schema_t* schema, const fxdb_column_sketch_t* sketches, uint32_t row_count,
+                                size_t* size) {
+    size_t capacity = sizeof(uint32_t);
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        capacity += AGGREGATE_BYTES + 2 * sizeof(uint32_t) + FXDB_HLL_MAX_ENCODED;
+        if (is_numeric(schema->fields[f].type)) {
+            capacity += fxdb_kll_encoded_size(&sketches[f].quantiles);
+        }
+    }
+    
+    uint8_t* payload = malloc(capacity);
+    if (!payload) {
+        return NULL;
+    }
+    
+    uint8_t* cursor = payload;
+    memcpy(cursor, &row_count, sizeof(row_count));
+    cursor += sizeof(row_count);
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        const fxdb_column_sketch_t* sketch = &sketches[f];
+        memcpy(cursor, &sketch->value_count, sizeof(uint64_t));
+        memcpy(cursor + sizeof(uint64_t), &sketch->sum, sizeof(double));
+        memcpy(cursor + sizeof(uint64_t) + sizeof(double), &sketch->min, sizeof(double));
+        memcpy(cursor + sizeof(uint64_t) + 2 * sizeof(double), &sketch->max, sizeof(double));
+        cursor += AGGREGATE_BYTES;
+    }
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        const fxdb_column_sketch_t* sketch = &sketches[f];
+        uint32_t bytes = (uint32_t)fxdb_hll_encode(&sketch->distinct, cursor + sizeof(uint32_t));
+        memcpy(cursor, &bytes, sizeof(bytes));
+        cursor += sizeof(bytes) + bytes;
+        
+        bytes = is_numeric(schema->fields[f].type) ? (uint32_t)fxdb_kll_encode(&sketch->quantiles, cursor + sizeof(uint32_t)) : 0;
+        memcpy(cursor, &bytes, sizeof(bytes));
+        cursor += sizeof(bytes) + bytes;
+    }
+    
+    *size = (size_t)(cursor - payload);
+    return payload;
+}
+
+// Summarize the rows of a chunk
+uint8_t* summary_encode_chunk(const schema_t* schema, uint64_t null_mask, const uint8_t* rows, uint32_t row_count,
+                              const uint64_t* validity, uint32_t validity_words, size_t* size) {
+    if (!schema || !size || (!rows && row_count > 0)) {
+        return NULL;
+    }
+    
+    fxdb_column_sketch_t* sketches = malloc((schema->field_count ? schema->field_count : 1) * sizeof(fxdb_column_sketch_t));
+    if (!sketches) {
+        return NULL;
+    }
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        summary_sketch_init(&sketches[f]);
+    }
+    
+    uint8_t* payload = NULL;
+    if (summary_add_rows(schema, null_mask, rows, row_count, validity, validity_words, NULL, ~0ULL, sketches) == 0) {
+        payload = encode_sketches(schema, sketches, row_count, size);
+    }
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        summary_sketch_free(&sketches[f]);
+    }
+    free(sketches);
+    return payload;
+}
+
+// Decode the aggregates of a field
+static void decode_aggregate(const uint8_t* cursor, column_aggregate_t* aggregate) {
+    memcpy(&aggregate->value_count, cursor, sizeof(uint64_t));
+    memcpy(&aggregate->sum, cursor + sizeof(uint64_t), sizeof(double));
+    memcpy(&aggregate->min, cursor + sizeof(uint64_t) + sizeof(double), sizeof(double));
+    memcpy(&aggregate->max, cursor + sizeof(uint64_t) + 2 * sizeof(double), sizeof(double));
+}
+
+// Merge a summary into the sketches of the fields asked for
+static int merge_payload(const schema_t* schema, const uint8_t* payload, size_t size, uint64_t fields,
+                         fxdb_column_sketch_t* sketches, uint32_t* row_count) {
+    const uint8_t* cursor = payload;
+    const uint8_t* end = payload + size;
+    if (size < sizeof(uint32_t)) {
+        return -1;
+    }
+    memcpy(row_count, cursor, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    
+    if ((size_t)(end - cursor) < (size_t)schema->field_count * AGGREGATE_BYTES) {
+        return -1;
+    }
+    for (uint32_t f = 0; f < schema->field_count; f++, cursor += AGGREGATE_BYTES) {
+        if (!((fields >> f) & 1)) {
+            continue;
+        }
+        column_aggregate_t aggregate;
+        decode_aggregate(cursor, &aggregate);
+        sketches[f].value_count += aggregate.value_count;
+        sketches[f].sum += aggregate.sum;
+        sketches[f].min = aggregate.min < sketches[f].min ? aggregate.min : sketches[f].min;
+        sketches[f].max = aggregate.max > sketches[f].max ? aggregate.max : sketches[f].max;
+    }
+    
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        uint32_t hll_bytes, kll_bytes;
+        if ((size_t)(end - cursor) < sizeof(hll_bytes)) {
+            return -1;
+        }
+        memcpy(&hll_bytes, cursor, sizeof(hll_bytes));
+        cursor += sizeof(hll_bytes);
+        if ((size_t)(end - cursor) < (size_t)hll_bytes + sizeof(kll_bytes)) {
+            return -1;
+        }
+        const uint8_t* hll = cursor;
+        memcpy(&kll_bytes, cursor + hll_bytes, sizeof(kll_bytes));
+        cursor += hll_bytes + sizeof(kll_bytes);
+        if ((size_t)(end - cursor) < kll_bytes) {
+            return -1;
+        }
+        const uint8_t* kll = cursor;
+        cursor += kll_bytes;
+        
+        if (!((fields >> f) & 1)) {
+            continue;
+        }
+        if (fxdb_hll_merge_encoded(&sketches[f].distinct, hll, hll_bytes) != 0 ||
+            (kll_bytes > 0 && fxdb_kll_merge_encoded(&sketches[f].quantiles, kll, kll_bytes) != 0)) {
+            return -1;
+        }
+    }
+    return cursor == end ? 0 : -1;
+}
+
+// Summaries only apply to the database generation they were written for
+static bool header_matches(const fxdb_summary_header_t* header, const fxdb_header_t* db_header,
+                           const schema_t* schema) {
+    return header->magic == FXDB_SUMMARY_MAGIC && header->version == FXDB_SUMMARY_VERSION &&
+           header->generation == db_header->generation && header->field_count == schema->field_count;
+}
+
+// Checksum of a record, its payload included
+static uint32_t record_checksum(const summary_record_t* record, const uint8_t* payload) {
+    return utils_simple_checksum((const uint8_t*)record + sizeof(uint32_t), RECORD_FIELDS) ^
+           utils_simple_checksum(payload, record->size);
+}
+
+// Offset just past the last record to keep: records end before the end of the
+// file and cover committed chunks, and the last one, the only one an append
+// can have torn, has to pass its checksum
+static long valid_end(FILE* file, const fxdb_header_t* db_header) {
+    long end = (long)sizeof(fxdb_summary_header_t);
+    long last = -1;
+    summary_record_t record;
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    long size = ftell(file);
+    
+    while (fseek(file, end, SEEK_SET) == 0 && fread(&record, sizeof(record), 1, file) == 1 &&
+           record.chunk_index < db_header->chunk_count && record.size <= MAX_PAYLOAD &&
+           end + (long)sizeof(record) + (long)record.size <= size) {
+        last = end;
+        end += (long)sizeof(record) + (long)record.size;
+    }
+    
+    if (last >= 0) {
+        uint8_t* payload = NULL;
+        bool intact = fseek(file, last, SEEK_SET) == 0 && fread(&record, sizeof(record), 1, file) == 1 &&
+                      (payload = malloc(record.size ? record.size : 1)) != NULL &&
+                      fread(payload, 1, record.size, file) == record.size &&
+                      record.checksum == record_checksum(&record, payload);
+        free(payload);
+        if (!intact) {
+            end = last;
+        }
+    }
+    return end;
+}
+
+// Open the summary file for appending, replacing a missing or stale one
+static FILE* open_for_append(const char* path, const fxdb_header_t* db_header, const schema_t* schema) {
+    FILE* file = fopen(path, "r+b");
+    if (file) {
+        fxdb_summary_header_t header;
+        if (fread(&header, sizeof(header), 1, file) == 1 && header_matches(&header, db_header, schema)) {
+            long end = valid_end(file, db_header);
+            long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+            if (end >= 0 && size >= 0 &&
+                (size == end || (fflush(file) == 0 && ftruncate(fileno(file), end) == 0)) &&
+                fseek(file, end, SEEK_SET) == 0) {
+                return file;
+            }
+        }
+        fclose(file);
+    }
+    
+    file = fopen(path, "w+b");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create summary file '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    
+    fxdb_summary_header_t header = {
+        .magic = FXDB_SUMMARY_MAGIC,
+        .version = FXDB_SUMMARY_VERSION,
+        .generation = db_header->generation,
+        .field_count = schema->field_count
+    };
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+// Open the summary file of a database for appending
+fxdb_summary_writer_t* summary_writer_open(const char* db_path, const fxdb_header_t* db_header,
+                                           const schema_t* schema) {
+    if (!db_path || !db_header || !schema) {
+        return NULL;
+    }
+    
+    fxdb_summary_writer_t* writer = calloc(1, sizeof(fxdb_summary_writer_t));
+    char* path = summary_path(db_path);
+    if (writer && path) {
+        writer->sketches = malloc((schema->field_count ? schema->field_count : 1) * sizeof(fxdb_column_sketch_t));
+    }
+    if (!writer || !path || !writer->sketches) {
+        free(path);
+        if (writer) {
+            free(writer->sketches);
+        }
+        free(writer);
+        return NULL;
+    }
+    
+    writer->schema = schema;
+    writer->null_mask = db_header->null_mask;
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        summary_sketch_init(&writer->sketches[f]);
+    }
+    writer->file = open_for_append(path, db_header, schema);
+    free(path);
+    if (!writer->file) {
+        summary_writer_close(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+// Append the record of a summarized chunk
+int summary_writer_append(fxdb_summary_writer_t* writer, uint32_t chunk_index, const uint8_t* payload,
+                          size_t size) {
+    if (!writer || !payload || size > MAX_PAYLOAD) {
+        return -1;
+    }
+    
+    summary_record_t record = { 0, chunk_index, (uint32_t)size };
+    record.checksum = record_checksum(&record, payload);
+    
+    // Summaries are advisory: handed to the OS, never synced
+    if (fwrite(&record, sizeof(record), 1, writer->file) != 1 ||
+        fwrite(payload, 1, size, writer->file) != size || fflush(writer->file) != 0) {
+        return -1;
+    }
+    fxdb_stats_add(FXDB_STAT_BYTES_WRITTEN, sizeof(record) + size);
+    return 0;
+}
+
+// Summarize a chunk just written and append its record
+int summary_writer_add_chunk(fxdb_summary_writer_t* writer, uint32_t chunk_index, const uint8_t* rows,
+                             uint32_t row_count, const uint64_t* validity, uint32_t validity_words) {
+    if (!writer) {
+        return -1;
+    }
+    
+    const schema_t* schema = writer->schema;
+    for (uint32_t f = 0; f < schema->field_count; f++) {
+        fxdb_hll_init(&writer->sketches[f].distinct);
+        fxdb_kll_reset(&writer->sketches[f].quantiles);
+        writer->sketches[f].value_count = 0;
+        writer->sketches[f].sum = 0.0;
+        writer->sketches[f].min = INFINITY;
+        writer->sketches[f].max = -INFINITY;
+    }
+    
+    size_t size;
+    uint8_t* payload = NULL;
+    if (summary_add_rows(schema, writer->null_mask, rows, row_count, validity, validity_words, NULL, ~0ULL,
+                         writer->sketches) == 0) {
+        payload = encode_sketches(schema, writer->sketches, row_count, &size);
+    }
+    int result = payload ? summary_writer_append(writer, chunk_index, payload, size) : -1;
+    free(payload);
+    return result;
+}
+
+// Close a summary writer
+int summary_writer_close(fxdb_summary_writer_t* writer) {
+    if (!writer) {
+        return 0;
+    }
+    
+    int result = 0;
+    if (writer->file && fclose(writer->file) != 0) {
+        result = -1;
+    }
+    for (uint32_t f = 0; f < writer->schema->field_count; f++) {
+        summary_sketch_free(&writer->sketches[f]);
+    }
+    free(writer->sketches);
+    free(writer);
+    return result;
+}
+
+// Offset of the last record of each committed chunk, 0 for chunks without one
+static long* index_records(FILE* file, const reader_t* reader) {
+    uint32_t chunk_count = reader->header.chunk_count;
+    long* offsets = calloc(chunk_count ? chunk_count : 1, sizeof(long));
+    if (!offsets) {
+        return NULL;
+    }
+    
+    fxdb_summary_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || !header_matches(&header, &reader->header, reader->schema)) {
+        return offsets;
+    }
+    
+    long position = (long)sizeof(header);
+    summary_record_t record;
+    while (fseek(file, position, SEEK_SET) == 0 && fread(&record, sizeof(record), 1, file) == 1 &&
+           record.size <= MAX_PAYLOAD) {
+        if (record.chunk_index < chunk_count) {
+            offsets[record.chunk_index] = position;
+        }
+        position += (long)sizeof(record) + (long)record.size;
+    }
+    return offsets;
+}
+
+// Read the payload of a record into a malloc'd buffer; returns 1 when read,
+// 0 when the record is torn and the chunk has to be read, -1 when out of memory
+static int read_record(FILE* file, long offset, uint8_t** payload, uint32_t* size) {
+    summary_record_t record;
+    if (fseek(file, offset, SEEK_SET) != 0 || fread(&record, sizeof(record), 1, file) != 1) {
+        return 0;
+    }
+    
+    *payload = malloc(record.size ? record.size : 1);
+    if (!*payload) {
+        return -1;
+    }
+    if (fread(*payload, 1, record.size, file) != record.size || record.checksum != record_checksum(&record, *payload)) {
+        free(*payload);
+        *payload = NULL;
+        return 0; // Torn; the rows are still there
+    }
+    fxdb_stats_add(FXDB_STAT_BYTES_READ, sizeof(record) + record.size);
+    *size = record.size;
+    return 1;
+}
+
+// Merge the summary of a chunk; returns 1 when merged, 0 when the chunk has to be read, -1 on error
+static int merge_summary(FILE* file, long offset, uint32_t chunk_index, const reader_t* reader, uint64_t fields,
+                         fxdb_column_sketch_t* sketches, uint32_t* row_count) {
+    uint8_t* payload = NULL;
+    uint32_t size = 0;
+    int result = read_record(file, offset, &payload, &size);
+    if (result != 1) {
+        return result;
+    }
+    
+    result = merge_payload(reader->schema, payload, size, fields, sketches, row_count);
+    free(payload);
+    if (result != 0) {
+        fprintf(stderr, "Error: Summary of chunk %u is damaged\n", chunk_index);
+        return -1;
+    }
+    return 1;
+}
+
+// Sketch columns of a file
+int summary_sketch_columns(reader_t* reader, uint64_t fields, fxdb_column_sketch_t* sketches,
+                           fxdb_summary_stats_t* stats) {
+    if (!reader || !sketches) {
+        return -1;
+    }
+    
+    fxdb_summary_stats_t counts = { 0, 0, 0 };
+    long* offsets = NULL;
+    char* path = summary_path(reader->path);
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if (file) {
+        offsets = index_records(file, reader);
+        if (!offsets) {
+            fclose(file);
+            return -1;
+        }
+    }
+    
+    // The log rows and chunks with deleted rows differ from their summaries
+    int result = 0;
+    uint32_t total = reader_chunk_count(reader);
+    for (uint32_t c = 0; c < total && result == 0; c++) {
+        if (offsets && c < reader->header.chunk_count && offsets[c] > 0 && !deletes_chunk(reader->deletes, c)) {
+            uint32_t rows = 0;
+            result = merge_summary(file, offsets[c], c, reader, fields, sketches, &rows);
+            if (result == 1) {
+                counts.chunks_summarized++;
+                counts.row_count += rows;
+                result = 0;
+                continue;
+            }
+            if (result < 0) {
+                break;
+            }
+        }
+        
+        if (reader_load_chunk(reader, c) != 0) {
+            result = -1;
+            break;
+        }
+        uint32_t rows = reader->chunk_row_count;
+        const uint64_t* deleted = reader->chunk_deleted;
+        result = summary_add_rows(reader->schema, reader->header.null_mask, reader->chunk_data, rows,
+                                  reader->validity, reader->validity_words, deleted, fields, sketches);
+        counts.chunks_scanned++;
+        counts.row_count += rows - (deleted ? fxdb_bitmap_count(deleted, rows) : 0);
+    }
+    
+    if (file) {
+        fclose(file);
+    }
+    free(offsets);
+    reader_rewind(reader);
+    if (stats) {
+        *stats = counts;
+    }
+    return result;
+}
+
+// Exact aggregates of a column per committed chunk, from the summaries
+int summary_chunk_aggregates(const reader_t* reader, uint32_t field_index, column_aggregate_t* aggregates,
+                             bool* summarized) {
+    if (!reader || !aggregates || !summarized || field_index >= reader->schema->field_count) {
+        return -1;
+    }
+    
+    uint32_t chunk_count = reader->header.chunk_count;
+    memset(summarized, 0, chunk_count * sizeof(bool));
+    char* path = summary_path(reader->path);
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if (!file) {
+        return 0; // No summaries: every chunk is read
+    }
+    
+    long* offsets = index_records(file, reader);
+    int result = offsets ? 0 : -1;
+    size_t aggregate_at = sizeof(uint32_t) + (size_t)field_index * AGGREGATE_BYTES;
+    for (uint32_t c = 0; c < chunk_count && result == 0; c++) {
+        // Summaries hold every row the chunk was written with, deleted ones included
+        if (offsets[c] == 0 || deletes_chunk(reader->deletes, c)) {
+            continue;
+        }
+        
+        uint8_t* payload = NULL;
+        uint32_t size = 0;
+        int read = read_record(file, offsets[c], &payload, &size);
+        if (read < 0) {
+            result = -1;
+        } else if (read == 1 && size >= aggregate_at + AGGREGATE_BYTES) {
+            uint32_t rows;
+            memcpy(&rows, payload, sizeof(rows));
+            memset(&aggregates[c], 0, sizeof(aggregates[c]));
+            decode_aggregate(payload + aggregate_at, &aggregates[c]);
+            aggregates[c].row_count = rows;
+            summarized[c] = true;
+        }
+        free(payload);
+    }
+    
+    fclose(file);
+    free(offsets);
+    return result;
+}
+
+// Delete the summary file of a database, if there is one
+int summary_remove(const char* db_path) {
+    char* path = summary_path(db_path);
+    if (!path) {
+        return -1;
+    }
+    
+    int result = (unlink(path) == 0 || errno == ENOENT) ? 0 : -1;
+    free(path);
+    return result;
+}
@@ -0,0 +1,320 @@
+#include "../../include/wal.h"
+#include "../../include/config.h"
+#include "../../include/utils.h"
+#include "../../include/io_utils.h"
+#include "../../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+// Bytes of one log record: checksum, present mask, row
+static size_t record_size(uint32_t row_size) {
+    return sizeof(uint32_t) + sizeof(uint64_t) + row_size;
+}
+
+// Header of a log starting from the given database state
+static fxdb_wal_header_t make_header(const fxdb_header_t* db_header, uint32_t row_size) {
+    fxdb_wal_header_t header = {
+        .magic = FXDB_WAL_MAGIC,
+        .version = FXDB_WAL_VERSION,
+        .generation = db_header->generation,
+        .base_rows = db_header->total_rows,
+        .row_size = row_size,
+        .reserved = 0
+    };
+    return header;
+}
+
+// A log only applies to the exact database state it was started from
+static bool header_matches(const fxdb_wal_header_t* header, const fxdb_header_t* db_header,
+                           uint32_t row_size) {
+    return header->magic == FXDB_WAL_MAGIC && header->version == FXDB_WAL_VERSION &&
+           header->generation == db_header->generation &&
+           header->base_rows == db_header->total_rows && header->row_size == row_size;
+}
+
+// Read records until the end of the log or the first torn or corrupt record
+// rows and present may be NULL to only count the valid records
+static int scan_records(FILE* file, uint32_t row_size, uint8_t** rows, uint64_t** present) {
+    size_t rec_size = record_size(row_size);
+    uint8_t* record = malloc(rec_size);
+    if (!record) {
+        return -1;
+    }
+    
+    uint32_t count = 0, capacity = 0;
+    uint8_t* row_data = NULL;
+    uint64_t* masks = NULL;
+    
+    while (fread(record, 1, rec_size, file) == rec_size) {
+        uint32_t checksum;
+        memcpy(&checksum, record, sizeof(checksum));
+        if (!utils_verify_checksum(record + sizeof(uint32_t), rec_size - sizeof(uint32_t), checksum)) {
+            break;
+        }
+        
+        if (rows && present) {
+            if (count == capacity) {
+                uint32_t new_capacity = capacity ? capacity * 2 : 64;
+                uint8_t* new_rows = realloc(row_data, (size_t)new_capacity * row_size);
+                if (new_rows) {
+                    row_data = new_rows;
+                }
+                uint64_t* new_masks = realloc(masks, (size_t)new_capacity * sizeof(uint64_t));
+                if (new_masks) {
+                    masks = new_masks;
+                }
+                if (!new_rows || !new_masks) {
+                    free(row_data);
+                    free(masks);
+                    free(record);
+                    return -1;
+                }
+                capacity = new_capacity;
+            }
+            memcpy(&masks[count], record + sizeof(uint32_t), sizeof(uint64_t));
+            memcpy(row_data + (size_t)count * row_size, record + sizeof(uint32_t) + sizeof(uint64_t), row_size);
+        }
+        count++;
+    }
+    
+    free(record);
+    if (rows && present) {
+        *rows = row_data;
+        *present = masks;
+    }
+    return (int)count;
+}
+
+// Path of the log belonging to a database file
+char* wal_path(const char* db_path) {
+    if (!db_path) {
+        return NULL;
+    }
+    
+    size_t length = strlen(db_path) + strlen(WAL_EXT) + 1;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s%s", db_path, WAL_EXT);
+    }
+    return path;
+}
+
+// Write a fresh header at the start of an empty log
+static int write_log_header(fxdb_wal_t* wal) {
+    if (fseek(wal->file, 0, SEEK_SET) != 0 ||
+        fwrite(&wal->header, sizeof(fxdb_wal_header_t), 1, wal->file) != 1) {
+        return -1;
+    }
+    return fflush(wal->file) == 0 ? 0 : -1;
+}
+
+// Open the log of a database for appending
+fxdb_wal_t* wal_open(const char* db_path, const fxdb_header_t* db_header, uint32_t row_size) {
+    if (!db_path || !db_header || row_size == 0) {
+        return NULL;
+    }
+    
+    char* path = wal_path(db_path);
+    fxdb_wal_t* wal = calloc(1, sizeof(fxdb_wal_t));
+    uint8_t* record = malloc(record_size(row_size));
+    if (!path || !wal || !record) {
+        free(path);
+        free(wal);
+        free(record);
+        return NULL;
+    }
+    wal->record = record;
+    
+    // Keep the records of a log that still belongs to this database state
+    wal->file = fopen(path, "r+b");
+    if (wal->file) {
+        fxdb_wal_header_t header;
+        if (fread(&header, sizeof(header), 1, wal->file) == 1 &&
+            header_matches(&header, db_header, row_size)) {
+            int count = scan_records(wal->file, row_size, NULL, NULL);
+            long valid_end = (long)sizeof(header) + (long)count * (long)record_size(row_size);
+            
+            // Cut off a torn tail so new records follow the last valid one
+            if (count >= 0 && fflush(wal->file) == 0 &&
+                ftruncate(fileno(wal->file), valid_end) == 0 &&
+                fseek(wal->file, valid_end, SEEK_SET) == 0) {
+                wal->header = header;
+                wal->row_count = (uint32_t)count;
+                free(path);
+                return wal;
+            }
+        }
+        fclose(wal->file);
+    }
+    
+    // Missing or stale: start an empty log
+    wal->file = fopen(path, "w+b");
+    if (!wal->file) {
+        fprintf(stderr, "Error: Cannot create write-ahead log '%s': %s\n", path, strerror(errno));
+        free(path);
+        free(wal->record);
+        free(wal);
+        return NULL;
+    }
+    free(path);
+    
+    wal->header = make_header(db_header, row_size);
+    if (write_log_header(wal) != 0) {
+        wal_close(wal);
+        return NULL;
+    }
+    return wal;
+}
+
+// Append one serialized row to the log
+int wal_append(fxdb_wal_t* wal, const uint8_t* row, uint64_t present_mask) {
+    if (!wal || !wal->file || !row) {
+        return -1;
+    }
+    
+    uint32_t row_size = wal->header.row_size;
+    size_t rec_size = record_size(row_size);
+    memcpy(wal->record + sizeof(uint32_t), &present_mask, sizeof(uint64_t));
+    memcpy(wal->record + sizeof(uint32_t) + sizeof(uint64_t), row, row_size);
+    
+    uint32_t checksum = utils_simple_checksum(wal->record + sizeof(uint32_t), rec_size - sizeof(uint32_t));
+    memcpy(wal->record, &checksum, sizeof(checksum));
+    
+    uint64_t start = fxdb_stats_clock();
+    size_t written = fwrite(wal->record, 1, rec_size, wal->file);
+    fxdb_stats_add(FXDB_STAT_WRITE_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_WRITE_OPS, 1);
+    if (written != rec_size) {
+        return -1;
+    }
+    
+    fxdb_stats_add(FXDB_STAT_BYTES_WRITTEN, rec_size);
+    wal->row_count++;
+    return 0;
+}
+
+// Read the first count records of an open log
+int wal_read_rows(fxdb_wal_t* wal, uint32_t count, uint8_t* rows, uint64_t* present) {
+    if (!wal || !wal->file || !rows || !present || count > wal->row_count) {
+        return -1;
+    }
+    
+    uint32_t row_size = wal->header.row_size;
+    size_t rec_size = record_size(row_size);
+    if (fflush(wal->file) != 0 || fseek(wal->file, (long)sizeof(fxdb_wal_header_t), SEEK_SET) != 0) {
+        return -1;
+    }
+    
+    int result = 0;
+    for (uint32_t r = 0; r < count; r++) {
+        uint32_t checksum;
+        if (fread(wal->record, 1, rec_size, wal->file) != rec_size) {
+            result = -1;
+            break;
+        }
+        memcpy(&checksum, wal->record, sizeof(checksum));
+        if (!utils_verify_checksum(wal->record + sizeof(uint32_t), rec_size - sizeof(uint32_t), checksum)) {
+            result = -1;
+            break;
+        }
+        memcpy(&present[r], wal->record + sizeof(uint32_t), sizeof(uint64_t));
+        memcpy(rows + (size_t)r * row_size, wal->record + sizeof(uint32_t) + sizeof(uint64_t), row_size);
+    }
+    
+    // Appends continue at the end of the log
+    if (fseek(wal->file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    return result;
+}
+
+// Push appended records as far as the durability level asks
+int wal_sync(fxdb_wal_t* wal, fxdb_durability_t durability) {
+    if (!wal || !wal->file) {
+        return -1;
+    }
+    
+    switch (durability) {
+        case FXDB_DURABILITY_NONE:
+            return 0;
+        case FXDB_DURABILITY_FSYNC:
+            if (fflush(wal->file) != 0) {
+                return -1;
+            }
+            return fxdb_stats_sync_file(fileno(wal->file));
+        case FXDB_DURABILITY_FLUSH:
+        default:
+            return fflush(wal->file) == 0 ? 0 : -1;
+    }
+}
+
+// Empty the log after a checkpoint and bind it to the new database state
+int wal_reset(fxdb_wal_t* wal, const fxdb_header_t* db_header) {
+    if (!wal || !wal->file || !db_header) {
+        return -1;
+    }
+    
+    // A crash before the new header lands leaves a stale log, which is ignored
+    if (fflush(wal->file) != 0 || ftruncate(fileno(wal->file), 0) != 0) {
+        return -1;
+    }
+    
+    wal->header = make_header(db_header, wal->header.row_size);
+    wal->row_count = 0;
+    return write_log_header(wal);
+}
+
+// Close the log, leaving its records on disk
+void wal_close(fxdb_wal_t* wal) {
+    if (wal) {
+        if (wal->file) {
+            fclose(wal->file);
+        }
+        free(wal->record);
+        free(wal);
+    }
+}
+
+// Read the records of a database's log
+int wal_replay(const char* db_path, const fxdb_header_t* db_header, uint32_t row_size,
+               uint8_t** rows, uint64_t** present) {
+    if (!db_path || !db_header || !rows || !present) {
+        return -1;
+    }
+    *rows = NULL;
+    *present = NULL;
+
+    char* path = wal_path(db_path);
+    if (!path) {
+        return -1;
+    }
+    
+    FILE* file = fopen(path, "rb");
+    free(path);
+    if (!file) {
+        return 0; // No log: nothing was committed since the last checkpoint
+    }
+    
+    fxdb_wal_header_t header;
+    int count = 0;
+    if (fread(&header, sizeof(header), 1, file) == 1 && header_matches(&header, db_header, row_size)) {
+        count = scan_records(file, row_size, rows, present);
+    }
+    
+    fclose(file);
+    return count;
+}
+
+// Delete the log of a database, if there is one
+int wal_remove(const char* db_path) {
+    char* path = wal_path(db_path);
+    if (!path) {
+        return -1;
+    }
+    
+    int result = (unlink(path) == 0 || errno == ENOENT) ? 0 : -1;
+    free(path);
+    return result;
+}
@@ -1,26 +1,125 @@
 #include "../../include/writer.h"
 #include "../../include/io_utils.h"
+#include "../../include/bitmap.h"
+#include "../../include/wal.h"
+#include "../../include/deletes.h"
+#include "../../include/summary.h"
+#include "../../include/coord.h"
+#include "../../include/utils.h"
+#include "../../include/stats.h"
+#include "../../include/arena.h"
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// Stack space writer_insert_json parses a row in before it falls back to the heap
+#define JSON_SCRATCH_BYTES 2048
 
 // Create default writer configuration
 writer_config_t writer_default_config(void) {
     writer_config_t config = {
         .chunk_size = DEFAULT_CHUNK_SIZE,
         .use_compression = false,
-        .build_index = false
+        .build_index = false,
+        .async_io = false,
+        .durability = FXDB_DURABILITY_FLUSH,
+        .group_commit_us = 0,
+        .use_wal = false,
+        .lock_timeout_ms = FXDB_LOCK_TIMEOUT_MS,
+        .align_chunks = false,
+        .chunk_summaries = true
     };
     return config;
 }
 
-// Write file header to disk
+/* ============================================================================
+ * Commit Roots
+ * ============================================================================
+ * Rewriting the header publishes a commit: the chunks it covers are written
+ * first, then the header with the new extent in the older root. Readers take
+ * the newest root that passes its checksum, so they see either the previous
+ * or the new commit, never a mix, without coordinating with the writer.
+ */
+
+static uint16_t root_checksum(const fxdb_root_t* root) {
+    fxdb_root_t copy = *root;
+    copy.checksum = 0;
+    uint32_t sum = utils_simple_checksum(&copy, sizeof(copy));
+    return (uint16_t)(sum ^ (sum >> 16));
+}
+
+// A zeroed root (files from before commit roots) is never intact
+static bool root_intact(const fxdb_root_t* root) {
+    return root->sequence != 0 && root->checksum == root_checksum(root);
+}
+
+// Newest intact commit root of a header
+const fxdb_root_t* fxdb_header_root(const fxdb_header_t* header) {
+    if (!header) {
+        return NULL;
+    }
+    
+    bool first = root_intact(&header->roots[0]);
+    bool second = root_intact(&header->roots[1]);
+    if (first && second) {
+        // Sequences wrap: the newer one is at most half the range ahead
+        int16_t ahead = (int16_t)(uint16_t)(header->roots[0].sequence - header->roots[1].sequence);
+        return ahead > 0 ? &header->roots[0] : &header->roots[1];
+    }
+    return first ? &header->roots[0] : second ? &header->roots[1] : NULL;
+}
+
+// Take the committed extent from the newest intact root
+uint16_t fxdb_header_resolve(fxdb_header_t* header) {
+    const fxdb_root_t* root = fxdb_header_root(header);
+    if (!root) {
+        return 0;
+    }
+    
+    header->total_rows = root->total_rows;
+    header->chunk_count = root->chunk_count;
+    header->data_size = root->data_size;
+    return root->sequence;
+}
+
+// Record the header's extent as the next commit, keeping the current root
+void fxdb_header_publish(fxdb_header_t* header) {
+    if (!header) {
+        return;
+    }
+    
+    const fxdb_root_t* current = fxdb_header_root(header);
+    uint16_t sequence = current ? (uint16_t)(current->sequence + 1) : 1;
+    if (sequence == 0) {
+        sequence = 1;
+    }
+    
+    fxdb_root_t* next = (current == &header->roots[0]) ? &header->roots[1] : &header->roots[0];
+    next->sequence = sequence;
+    next->total_rows = header->total_rows;
+    next->chunk_count = header->chunk_count;
+    next->data_size = header->data_size;
+    next->checksum = root_checksum(next);
+}
+
+// Whether a file uses the aligned chunk layout
+bool fxdb_header_aligned(const fxdb_header_t* header) {
+    return header && header->data_offset % FXDB_IO_ALIGNMENT == 0;
+}
+
+// Write file header to disk, publishing its extent as a new commit
 static int write_header(writer_t* writer) {
     if (fseek(writer->file, 0, SEEK_SET) != 0) {
         return -1;
     }
     
+    fxdb_header_publish(&writer->header);
+    
     size_t written = fwrite(&writer->header, sizeof(fxdb_header_t), 1, writer->file);
     if (written != 1) {
         return -1;
@@ -29,6 +128,18 @@ static int write_header(writer_t* writer) {
     return 0;
 }
 
+// Allocate zeroed validity bitmaps for the nullable columns of the schema
+static int init_validity(writer_t* writer) {
+    writer->null_column_count = fxdb_popcount64(writer->header.null_mask);
+    writer->validity_words = fxdb_bitmap_words(writer->config.chunk_size);
+    if (writer->null_column_count == 0) {
+        return 0;
+    }
+    
+    writer->validity = calloc((size_t)writer->null_column_count * writer->validity_words, sizeof(uint64_t));
+    return writer->validity ? 0 : -1;
+}
+
 // Write schema to file
 static int write_schema(writer_t* writer) {
     if (!writer->schema || !writer->schema->raw_schema_str) {
@@ -70,8 +181,485 @@ static int write_schema(writer_t* writer) {
     return 0;
 }
 
+// Zeros written after a chunk to align the next one
+static const uint8_t chunk_padding[FXDB_IO_ALIGNMENT];
+
+// Write one chunk from a row buffer and its validity bitmaps, then clear the bitmaps
+static int write_chunk(writer_t* writer, const uint8_t* rows, uint64_t* validity, uint32_t row_count) {
+    size_t row_bytes = row_count * writer->schema->row_size;
+    uint32_t bitmap_words = fxdb_bitmap_words(row_count);
+    size_t bitmap_bytes = (size_t)writer->null_column_count * bitmap_words * sizeof(uint64_t);
+    
+    // The aligned layout counts the padding up to the next boundary as chunk data
+    size_t padding = 0;
+    if (writer->config.align_chunks) {
+        size_t end = (size_t)writer->header.data_offset + writer->header.data_size +
+                     2 * sizeof(uint32_t) + row_bytes + bitmap_bytes;
+        padding = fxdb_align_up(end, FXDB_IO_ALIGNMENT) - end;
+    }
+    
+    // Write chunk header
+    uint32_t chunk_header[2] = {
+        row_count,                               // rows in chunk
+        (uint32_t)(row_bytes + bitmap_bytes + padding) // chunk size in bytes
+    };
+    
+    uint64_t start = fxdb_stats_clock();
+    if (fwrite(chunk_header, sizeof(uint32_t), 2, writer->file) != 2) {
+        return -1;
+    }
+    
+    // Write chunk data
+    if (fwrite(rows, 1, row_bytes, writer->file) != row_bytes) {
+        return -1;
+    }
+    
+    // Write one validity bitmap per nullable column, trimmed to the rows present
+    for (uint32_t c = 0; c < writer->null_column_count; c++) {
+        const uint64_t* bitmap = validity + (size_t)c * writer->validity_words;
+        if (fwrite(bitmap, sizeof(uint64_t), bitmap_words, writer->file) != bitmap_words) {
+            return -1;
+        }
+    }
+    
+    if (padding > 0 && fwrite(chunk_padding, 1, padding, writer->file) != padding) {
+        return -1;
+    }
+    fxdb_stats_add(FXDB_STAT_WRITE_NS, fxdb_stats_clock() - start);
+    fxdb_stats_add(FXDB_STAT_WRITE_OPS, 2 + writer->null_column_count + (padding > 0));
+    fxdb_stats_add(FXDB_STAT_BYTES_WRITTEN, sizeof(chunk_header) + chunk_header[1]);
+    fxdb_stats_add(FXDB_STAT_CHUNKS_WRITTEN, 1);
+    
+    // Summaries are advisory: after a failed one the rest of the chunks go
+    // without, and approximate queries read them instead
+    if (writer->summaries &&
+        summary_writer_add_chunk(writer->summaries, writer->header.chunk_count, rows, row_count,
+                                 validity, writer->validity_words) != 0) {
+        summary_writer_close(writer->summaries);
+        writer->summaries = NULL;
+    }
+    
+    // Update statistics
+    writer->header.chunk_count++;
+    writer->header.data_size += sizeof(chunk_header) + chunk_header[1];
+    writer->current_chunk++;
+    
+    if (validity) {
+        memset(validity, 0, (size_t)writer->null_column_count * writer->validity_words * sizeof(uint64_t));
+    }
+    return 0;
+}
+
+// Push written data as far as the configured durability level asks
+static int apply_durability(writer_t* writer) {
+    switch (writer->config.durability) {
+        case FXDB_DURABILITY_NONE:
+            return 0;
+        case FXDB_DURABILITY_FSYNC:
+            if (fflush(writer->file) != 0) {
+                return -1;
+            }
+            return fxdb_stats_sync_file(fileno(writer->file));
+        case FXDB_DURABILITY_FLUSH:
+        default:
+            return fflush(writer->file) == 0 ? 0 : -1;
+    }
+}
+
+// Rewrite the header for `total_rows` rows and return to the end of the file
+static int write_header_at(writer_t* writer, uint32_t total_rows) {
+    writer->header.total_rows = total_rows;
+    if (write_header(writer) != 0 || fseek(writer->file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Delete a write-ahead log whose rows the last commit made durable in the file
+// A log left behind is harmless: its base row count no longer matches the header
+static void drop_adopted_wal(writer_t* writer) {
+    if (writer->adopted_wal) {
+        remove(writer->adopted_wal);
+        free(writer->adopted_wal);
+        writer->adopted_wal = NULL;
+    }
+}
+
+/* ============================================================================
+ * Write-Ahead Log
+ * ============================================================================
+ * With config.use_wal the fill buffer and the log hold the same rows. Commits
+ * append the rows the log has not seen yet; a full buffer is checkpointed as
+ * a normal chunk, after which the header covers those rows and the log is
+ * emptied. A reopened writer only counts the rows already in the log; their
+ * bytes are read into the buffer by the checkpoint that writes them out.
+ * Readers append the log's rows to the end of their scans.
+ */
+
+// Present mask of a buffered row: bits of NULL nullable fields are clear
+static uint64_t row_present_mask(const writer_t* writer, uint32_t row) {
+    uint64_t present = ~writer->header.null_mask;
+    uint64_t nullable = writer->header.null_mask;
+    for (uint32_t ordinal = 0; nullable; ordinal++) {
+        uint32_t field = (uint32_t)__builtin_ctzll(nullable);
+        if (fxdb_bitmap_get(writer->validity + (size_t)ordinal * writer->validity_words, row)) {
+            present |= 1ULL << field;
+        }
+        nullable &= nullable - 1;
+    }
+    return present;
+}
+
+// Append the buffered rows the log has not seen yet
+static int log_buffered_rows(writer_t* writer) {
+    uint32_t row_size = writer->schema->row_size;
+    for (uint32_t r = writer->wal_logged_rows; r < writer->buffer_row_count; r++) {
+        if (wal_append(writer->wal, writer->row_buffer + (size_t)r * row_size,
+                       row_present_mask(writer, r)) != 0) {
+            return -1;
+        }
+        writer->wal_logged_rows = r + 1;
+    }
+    if (wal_sync(writer->wal, writer->config.durability) != 0) {
+        return -1;
+    }
+    
+    coord_publish(writer->coord, &writer->header, writer->wal->row_count);
+    return 0;
+}
+
+// Set the validity bits of buffered rows first..first + count - 1 from their present masks
+static void apply_present_masks(writer_t* writer, const uint64_t* present, uint32_t first, uint32_t count) {
+    for (uint32_t r = 0; r < count; r++) {
+        uint64_t nullable = writer->header.null_mask;
+        for (uint32_t ordinal = 0; nullable; ordinal++) {
+            uint32_t field = (uint32_t)__builtin_ctzll(nullable);
+            if ((present[r] >> field) & 1) {
+                fxdb_bitmap_set(writer->validity + (size_t)ordinal * writer->validity_words, first + r);
+            }
+            nullable &= nullable - 1;
+        }
+    }
+}
+
+// Read the rows a reopened writer left in the log into the front of the fill buffer
+static int load_logged_rows(writer_t* writer) {
+    uint32_t count = writer->wal_unloaded_rows;
+    if (count == 0) {
+        return 0;
+    }
+    
+    uint64_t* present = malloc((size_t)count * sizeof(uint64_t));
+    if (!present || wal_read_rows(writer->wal, count, writer->row_buffer, present) != 0) {
+        free(present);
+        return -1;
+    }
+    apply_present_masks(writer, present, 0, count);
+    free(present);
+    writer->wal_unloaded_rows = 0;
+    return 0;
+}
+
+// Write the buffer as a chunk, publish it in the header, then empty the log
+static int checkpoint(writer_t* writer) {
+    if (load_logged_rows(writer) != 0) {
+        return -1;
+    }
+    if (write_chunk(writer, writer->row_buffer, writer->validity, writer->buffer_row_count) != 0) {
+        return -1;
+    }
+    writer->buffer_row_count = 0;
+    writer->wal_logged_rows = 0;
+    
+    // The header must be durable before the log forgets the rows
+    if (write_header_at(writer, writer->total_rows) != 0 || apply_durability(writer) != 0 ||
+        wal_reset(writer->wal, &writer->header) != 0) {
+        return -1;
+    }
+    
+    coord_publish(writer->coord, &writer->header, 0);
+    return 0;
+}
+
+// Take over the rows of the database's log into the fill buffer of a writer without a log
+static int adopt_wal(writer_t* writer, const char* filename) {
+    uint8_t* rows;
+    uint64_t* present;
+    uint32_t row_size = writer->schema->row_size;
+    int count = wal_replay(filename, &writer->header, row_size, &rows, &present);
+    if (count <= 0) {
+        return count;
+    }
+    
+    if ((uint32_t)count > writer->config.chunk_size) {
+        fprintf(stderr, "Error: Write-ahead log of '%s' holds more than one chunk\n", filename);
+        free(rows);
+        free(present);
+        return -1;
+    }
+    
+    memcpy(writer->row_buffer, rows, (size_t)count * row_size);
+    apply_present_masks(writer, present, 0, (uint32_t)count);
+    
+    writer->buffer_row_count = (uint32_t)count;
+    writer->total_rows += (uint32_t)count;
+    free(rows);
+    free(present);
+    return count;
+}
+
+/* ============================================================================
+ * Asynchronous I/O
+ * ============================================================================
+ * An async writer owns two row buffers. Producers fill one while the I/O
+ * thread writes the other. writer_commit() asks the I/O thread to sweep the
+ * partially filled buffer into a chunk, rewrite the header and apply the
+ * durability level; every committer waiting at that moment is released by
+ * the same write and sync. Only the I/O thread touches the FILE.
+ */
+
+struct fxdb_async_io {
+    pthread_t thread;
+    pthread_mutex_t lock;       // Guards everything below and the writer's fill buffer
+    pthread_cond_t wake_io;     // Producers -> I/O thread
+    pthread_cond_t io_done;     // I/O thread -> producers
+    
+    uint8_t* spare_rows;        // Free buffer, NULL while the I/O thread holds it
+    uint64_t* spare_validity;
+    uint8_t* pending_rows;      // Full buffer waiting to be written
+    uint64_t* pending_validity;
+    uint32_t pending_count;
+    
+    uint32_t commit_target;     // Rows some committer waits to see durable
+    uint32_t durable_rows;      // Rows covered by the last committed header
+    bool delayed;               // Group-commit delay already spent for this commit
+    bool shutdown;              // Set by writer_close/writer_free
+    int error;                  // Sticky: first I/O failure fails every later call
+};
+
+static void* async_io_main(void* arg) {
+    writer_t* writer = arg;
+    struct fxdb_async_io* io = writer->async;
+    
+    pthread_mutex_lock(&io->lock);
+    for (;;) {
+        // A failed writer takes no more commits; waiters were already woken
+        while (!io->pending_rows && !io->shutdown &&
+               (io->commit_target <= io->durable_rows || io->error != 0)) {
+            pthread_cond_wait(&io->wake_io, &io->lock);
+        }
+        
+        // Full buffers first, so the header never covers unwritten rows
+        if (io->pending_rows) {
+            uint8_t* rows = io->pending_rows;
+            uint64_t* validity = io->pending_validity;
+            uint32_t count = io->pending_count;
+            
+            pthread_mutex_unlock(&io->lock);
+            int result = write_chunk(writer, rows, validity, count);
+            pthread_mutex_lock(&io->lock);
+            
+            if (result != 0 && io->error == 0) {
+                io->error = -1;
+            }
+            io->pending_rows = NULL;
+            io->spare_rows = rows;
+            io->spare_validity = validity;
+            pthread_cond_broadcast(&io->io_done);
+            continue;
+        }
+        
+        if (io->commit_target > io->durable_rows && io->error == 0) {
+            // Give concurrent producers a moment to join this commit
+            if (writer->config.group_commit_us > 0 && !io->delayed) {
+                io->delayed = true;
+                pthread_mutex_unlock(&io->lock);
+                struct timespec delay = {
+                    writer->config.group_commit_us / 1000000,
+                    (long)(writer->config.group_commit_us % 1000000) * 1000
+                };
+                nanosleep(&delay, NULL);
+                pthread_mutex_lock(&io->lock);
+                continue;
+            }
+            io->delayed = false;
+            
+            // Sweep the partially filled buffer; producers move to the spare
+            uint8_t* rows = writer->row_buffer;
+            uint64_t* validity = writer->validity;
+            uint32_t count = writer->buffer_row_count;
+            uint32_t target = writer->total_rows;
+            if (count > 0) {
+                writer->row_buffer = io->spare_rows;
+                writer->validity = io->spare_validity;
+                writer->buffer_row_count = 0;
+                io->spare_rows = NULL;
+                io->spare_validity = NULL;
+            }
+            
+            pthread_mutex_unlock(&io->lock);
+            int result = 0;
+            if (count > 0) {
+                result = write_chunk(writer, rows, validity, count);
+            }
+            if (result == 0) {
+                result = write_header_at(writer, target);
+            }
+            if (result == 0) {
+                result = apply_durability(writer);
+            }
+            if (result == 0) {
+                drop_adopted_wal(writer);
+                coord_publish(writer->coord, &writer->header, 0);
+            }
+            pthread_mutex_lock(&io->lock);
+            
+            if (count > 0) {
+                io->spare_rows = rows;
+                io->spare_validity = validity;
+            }
+            if (result != 0) {
+                io->error = -1;
+            } else if (target > io->durable_rows) {
+                io->durable_rows = target;
+            }
+            pthread_cond_broadcast(&io->io_done);
+            continue;
+        }
+        
+        if (io->shutdown) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&io->lock);
+    return NULL;
+}
+
+// Allocate the second buffer and start the I/O thread
+static int async_start(writer_t* writer) {
+    struct fxdb_async_io* io = calloc(1, sizeof(struct fxdb_async_io));
+    if (!io) {
+        return -1;
+    }
+    
+    io->spare_rows = malloc((size_t)writer->config.chunk_size * writer->schema->row_size);
+    if (writer->null_column_count > 0) {
+        io->spare_validity = calloc((size_t)writer->null_column_count * writer->validity_words, sizeof(uint64_t));
+    }
+    if (!io->spare_rows || (writer->null_column_count > 0 && !io->spare_validity)) {
+        free(io->spare_rows);
+        free(io->spare_validity);
+        free(io);
+        return -1;
+    }
+    
+    io->durable_rows = writer->total_rows;
+    io->commit_target = writer->total_rows;
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->wake_io, NULL);
+    pthread_cond_init(&io->io_done, NULL);
+    
+    writer->async = io;
+    if (pthread_create(&io->thread, NULL, async_io_main, writer) != 0) {
+        writer->async = NULL;
+        pthread_mutex_destroy(&io->lock);
+        pthread_cond_destroy(&io->wake_io);
+        pthread_cond_destroy(&io->io_done);
+        free(io->spare_rows);
+        free(io->spare_validity);
+        free(io);
+        return -1;
+    }
+    return 0;
+}
+
+// Stop the I/O thread once it has written any full buffer it was handed
+static void async_stop(writer_t* writer) {
+    struct fxdb_async_io* io = writer->async;
+    if (!io) {
+        return;
+    }
+    
+    pthread_mutex_lock(&io->lock);
+    io->shutdown = true;
+    pthread_cond_signal(&io->wake_io);
+    pthread_mutex_unlock(&io->lock);
+    pthread_join(io->thread, NULL);
+    
+    pthread_mutex_destroy(&io->lock);
+    pthread_cond_destroy(&io->wake_io);
+    pthread_cond_destroy(&io->io_done);
+    free(io->spare_rows);
+    free(io->spare_validity);
+    free(io);
+    writer->async = NULL;
+}
+
+// Hand the fill buffer to the I/O thread (called with io->lock held)
+static int async_submit(writer_t* writer) {
+    struct fxdb_async_io* io = writer->async;
+    
+    // Both buffers busy: wait for the I/O thread to finish one
+    while (!io->spare_rows && io->error == 0) {
+        pthread_cond_wait(&io->io_done, &io->lock);
+    }
+    if (io->error != 0) {
+        return -1;
+    }
+    if (writer->buffer_row_count == 0) {
+        return 0; // Swept by a commit while we waited
+    }
+    
+    io->pending_rows = writer->row_buffer;
+    io->pending_validity = writer->validity;
+    io->pending_count = writer->buffer_row_count;
+    writer->row_buffer = io->spare_rows;
+    writer->validity = io->spare_validity;
+    writer->buffer_row_count = 0;
+    io->spare_rows = NULL;
+    io->spare_validity = NULL;
+    
+    pthread_cond_signal(&io->wake_io);
+    return 0;
+}
+
+// Wait until every row inserted so far is durable (called with io->lock held)
+static int async_commit(writer_t* writer) {
+    struct fxdb_async_io* io = writer->async;
+    uint32_t target = writer->total_rows;
+    
+    if (io->commit_target < target) {
+        io->commit_target = target;
+        pthread_cond_signal(&io->wake_io);
+    }
+    while (io->durable_rows < target && io->error == 0) {
+        pthread_cond_wait(&io->io_done, &io->lock);
+    }
+    return io->error;
+}
+
+// Generation for a file about to be (re)created at `filename`
+// Recreating a file must not reuse a generation, or cached chunks of the old
+// contents would be served for the new file. Overwritten files continue their
+// predecessor's sequence; new files start from a time-derived seed because a
+// deleted file's inode (and with it the cache file id) can be reused.
+static uint32_t next_generation(const char* filename) {
+    static uint32_t files_created = 0;
+    uint32_t generation = (uint32_t)time(NULL) * 2654435761u + files_created++;
+    
+    FILE* file = fopen(filename, "rb");
+    if (file) {
+        fxdb_header_t header;
+        if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == FXDB_MAGIC_NUM) {
+            generation = header.generation + 1;
+        }
+        fclose(file);
+    }
+    return generation;
+}
+
 // Create a new .fxdb file with schema
-writer_t* writer_create(const char* filename, const schema_t* schema, const writer_config_t* config) {
+static writer_t* create_writer(const char* filename, const schema_t* schema, const writer_config_t* config) {
     if (!filename || !schema) {
         return NULL;
     }
@@ -85,11 +673,24 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
     memset(writer, 0, sizeof(writer_t));
     writer->schema = (schema_t*)schema; // Note: We don't own the schema
     writer->config = config ? *config : writer_default_config();
+    if (writer->config.use_wal) {
+        writer->config.async_io = false; // The log is written synchronously by commit
+    }
+    
+    // Lock before truncating: another writer may still have the old file open
+    int fd = coord_open_locked(filename, O_RDWR | O_CREAT, writer->config.lock_timeout_ms);
+    if (fd < 0) {
+        free(writer);
+        return NULL;
+    }
+    
+    uint32_t generation = next_generation(filename);
     
     // Open file for writing
-    writer->file = fopen(filename, "wb");
+    writer->file = ftruncate(fd, 0) == 0 ? fdopen(fd, "r+b") : NULL;
     if (!writer->file) {
         fprintf(stderr, "Error: Cannot create file '%s': %s\n", filename, strerror(errno));
+        close(fd);
         free(writer);
         return NULL;
     }
@@ -100,6 +701,8 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
     writer->header.chunk_size = writer->config.chunk_size;
     writer->header.total_rows = 0;
     writer->header.chunk_count = 0;
+    writer->header.null_mask = schema_null_mask(schema);
+    writer->header.generation = generation;
     
     // Calculate offsets
     writer->header.schema_offset = sizeof(fxdb_header_t);
@@ -108,6 +711,9 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
                                 schema->field_count * (MAX_FIELD_NAME_LEN + sizeof(field_type_t) + sizeof(uint32_t));
     
     writer->header.data_offset = writer->header.schema_offset + writer->header.schema_size;
+    if (writer->config.align_chunks) {
+        writer->header.data_offset = (uint32_t)fxdb_align_up(writer->header.data_offset, FXDB_IO_ALIGNMENT);
+    }
     writer->header.data_size = 0; // Will be updated as we write
     writer->header.index_offset = 0; // No index initially
     writer->header.index_size = 0;
@@ -115,7 +721,8 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
     // Allocate row buffer
     size_t buffer_size = writer->config.chunk_size * schema->row_size;
     writer->row_buffer = malloc(buffer_size);
-    if (!writer->row_buffer) {
+    if (!writer->row_buffer || init_validity(writer) != 0) {
+        free(writer->row_buffer);
         fclose(writer->file);
         free(writer);
         return NULL;
@@ -123,26 +730,53 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
     
     // Write initial header (will be updated later)
     if (write_header(writer) != 0) {
-        free(writer->row_buffer);
-        fclose(writer->file);
-        free(writer);
+        writer_free(writer);
         return NULL;
     }
     
     // Write schema
     if (write_schema(writer) != 0) {
-        free(writer->row_buffer);
-        fclose(writer->file);
-        free(writer);
+        writer_free(writer);
         return NULL;
     }
     
     // Position at data section
     writer->data_start_pos = writer->header.data_offset;
     if (fseek(writer->file, writer->data_start_pos, SEEK_SET) != 0) {
-        free(writer->row_buffer);
-        fclose(writer->file);
-        free(writer);
+        writer_free(writer);
+        return NULL;
+    }
+    
+    // Sidecars left by an earlier file of this name belong to another generation
+    deletes_remove(filename);
+    summary_remove(filename);
+    if (writer->config.chunk_summaries) {
+        writer->summaries = summary_writer_open(filename, &writer->header, schema);
+        if (!writer->summaries) {
+            writer_free(writer);
+            return NULL;
+        }
+    }
+    if (writer->config.use_wal) {
+        writer->wal = wal_open(filename, &writer->header, schema->row_size);
+        if (!writer->wal) {
+            writer_free(writer);
+            return NULL;
+        }
+    } else {
+        wal_remove(filename);
+    }
+    
+    writer->coord = coord_attach(filename, true);
+    if (!writer->coord) {
+        writer_free(writer);
+        return NULL;
+    }
+    coord_publish(writer->coord, &writer->header, 0);
+    
+    if (writer->config.async_io && async_start(writer) != 0) {
+        fprintf(stderr, "Error: Cannot start background I/O thread\n");
+        writer_free(writer);
         return NULL;
     }
     
@@ -150,6 +784,13 @@ writer_t* writer_create(const char* filename, const schema_t* schema, const writ
 }
 
 // Create writer with default configuration
+writer_t* writer_create(const char* filename, const schema_t* schema, const writer_config_t* config) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    writer_t* writer = create_writer(filename, schema, config);
+    fxdb_op_end(FXDB_LATENCY_OPEN, "writer_create", NULL, timer);
+    return writer;
+}
+
 writer_t* writer_create_default(const char* filename, const schema_t* schema) {
     writer_config_t config = writer_default_config();
     return writer_create(filename, schema, &config);
@@ -175,9 +816,20 @@ int serialize_row(const schema_t* schema, const field_value_t* values, uint32_t
             }
         }
         
-        if (!value) {
-            fprintf(stderr, "Error: Missing value for field '%s'\n", field->name);
-            return -1;
+        // is_null is only read for nullable fields; callers may leave it unset otherwise
+        if (!value || (field->nullable && value->is_null)) {
+            if (!field->nullable) {
+                fprintf(stderr, "Error: Missing value for non-nullable field '%s'\n", field->name);
+                return -1;
+            }
+            
+            // NULLs are zero-filled; the validity bitmap carries the NULL
+            uint32_t width = field->type == FIELD_TYPE_INT32 ? sizeof(int32_t) :
+                             field->type == FIELD_TYPE_FLOAT ? sizeof(float) :
+                             field->type == FIELD_TYPE_BOOL ? 1 : field->size;
+            memset(buffer + offset, 0, width);
+            offset += width;
+            continue;
         }
         
         // Serialize based on type
@@ -216,15 +868,51 @@ int serialize_row(const schema_t* schema, const field_value_t* values, uint32_t
         }
     }
     
+    fxdb_stats_add(FXDB_STAT_ROWS_ENCODED, 1);
     return offset;
 }
 
 // Insert a row using field values array
+static int insert_row_locked(writer_t* writer, const field_value_t* values, uint32_t value_count);
+
 int writer_insert_row(writer_t* writer, const field_value_t* values, uint32_t value_count) {
     if (!writer || !values) {
         return -1;
     }
     
+    int result;
+    if (!writer->async) {
+        // Time one insert in FXDB_STATS_INSERT_SAMPLE, and every insert that fills a chunk;
+        // a timed insert is recorded once for itself and once for each untimed one before it
+        uint32_t weight = writer->untimed_inserts + 1;
+        if (!fxdb_tracing && weight < FXDB_STATS_INSERT_SAMPLE &&
+            writer->buffer_row_count + 1 < writer->config.chunk_size) {
+            writer->untimed_inserts = weight;
+            return insert_row_locked(writer, values, value_count);
+        }
+        writer->untimed_inserts = 0;
+        fxdb_op_timer_t timer = fxdb_op_begin();
+        result = insert_row_locked(writer, values, value_count);
+        fxdb_op_end_weighted(FXDB_LATENCY_INSERT, "writer_insert_row", NULL, timer, weight);
+    } else {
+        fxdb_op_timer_t timer = fxdb_op_begin();
+        pthread_mutex_lock(&writer->async->lock);
+        result = writer->async->error != 0 ? -1 : insert_row_locked(writer, values, value_count);
+        pthread_mutex_unlock(&writer->async->lock);
+        fxdb_op_end(FXDB_LATENCY_INSERT, "writer_insert_row", NULL, timer);
+    }
+    return result;
+}
+
+// Append a row to the fill buffer; callers hold the async lock if there is one
+static int insert_row_locked(writer_t* writer, const field_value_t* values, uint32_t value_count) {
+    // Another producer may have filled the buffer while we waited for the lock
+    while (writer->buffer_row_count >= writer->config.chunk_size) {
+        if (writer_flush_chunk(writer) != 0) {
+            return -1;
+        }
+    }
+    
     // Serialize row into buffer
     uint8_t* row_pos = writer->row_buffer + (writer->buffer_row_count * writer->schema->row_size);
     int bytes_written = serialize_row(writer->schema, values, value_count, row_pos);
@@ -233,6 +921,27 @@ int writer_insert_row(writer_t* writer, const field_value_t* values, uint32_t va
         return -1;
     }
     
+    // Record which nullable fields carry a value
+    if (writer->null_column_count > 0) {
+        uint32_t ordinal = 0;
+        for (uint32_t i = 0; i < writer->schema->field_count; i++) {
+            if (!writer->schema->fields[i].nullable) {
+                continue;
+            }
+            
+            for (uint32_t j = 0; j < value_count; j++) {
+                if (strcmp(values[j].field_name, writer->schema->fields[i].name) == 0) {
+                    if (!values[j].is_null) {
+                        fxdb_bitmap_set(writer->validity + (size_t)ordinal * writer->validity_words,
+                                        writer->buffer_row_count);
+                    }
+                    break;
+                }
+            }
+            ordinal++;
+        }
+    }
+    
     writer->buffer_row_count++;
     writer->total_rows++;
     
@@ -245,38 +954,39 @@ int writer_insert_row(writer_t* writer, const field_value_t* values, uint32_t va
 }
 
 // Flush current chunk to disk
-int writer_flush_chunk(writer_t* writer) {
+static int flush_chunk(writer_t* writer) {
     if (!writer || writer->buffer_row_count == 0) {
         return 0; // Nothing to flush
     }
     
-    // Write chunk header
-    uint32_t chunk_header[2] = {
-        writer->buffer_row_count,                           // rows in chunk
-        writer->buffer_row_count * writer->schema->row_size // chunk size in bytes
-    };
+    if (writer->async) {
+        return async_submit(writer);
+    }
     
-    if (fwrite(chunk_header, sizeof(uint32_t), 2, writer->file) != 2) {
-        return -1;
+    if (writer->wal) {
+        return checkpoint(writer);
     }
     
-    // Write chunk data
-    size_t chunk_data_size = writer->buffer_row_count * writer->schema->row_size;
-    if (fwrite(writer->row_buffer, 1, chunk_data_size, writer->file) != chunk_data_size) {
+    if (write_chunk(writer, writer->row_buffer, writer->validity, writer->buffer_row_count) != 0) {
         return -1;
     }
     
-    // Update statistics
-    writer->header.chunk_count++;
-    writer->header.data_size += sizeof(chunk_header) + chunk_data_size;
-    
     // Reset buffer
     writer->buffer_row_count = 0;
-    writer->current_chunk++;
-    
     return 0;
 }
 
+int writer_flush_chunk(writer_t* writer) {
+    if (!writer || writer->buffer_row_count == 0) {
+        return 0; // Nothing to flush
+    }
+    
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    int result = flush_chunk(writer);
+    fxdb_op_end(FXDB_LATENCY_FLUSH, "writer_flush_chunk", NULL, timer);
+    return result;
+}
+
 // Get writer statistics
 void writer_get_stats(const writer_t* writer, uint32_t* total_rows, uint32_t* chunks_written) {
     if (writer) {
@@ -285,12 +995,24 @@ void writer_get_stats(const writer_t* writer, uint32_t* total_rows, uint32_t* ch
     }
 }
 
-// Close writer and finalize file
-int writer_close(writer_t* writer) {
-    if (!writer) {
+// Make every inserted row durable while keeping the writer open
+static int commit(writer_t* writer) {
+    if (!writer || !writer->file) {
         return -1;
     }
     
+    if (writer->async) {
+        pthread_mutex_lock(&writer->async->lock);
+        int result = async_commit(writer);
+        pthread_mutex_unlock(&writer->async->lock);
+        return result;
+    }
+    
+    // Sequential log append instead of a short chunk and a header rewrite
+    if (writer->wal) {
+        return log_buffered_rows(writer);
+    }
+    
     // Flush any remaining data
     if (writer->buffer_row_count > 0) {
         if (writer_flush_chunk(writer) != 0) {
@@ -298,16 +1020,57 @@ int writer_close(writer_t* writer) {
         }
     }
     
-    // Update header with final statistics
-    writer->header.total_rows = writer->total_rows;
+    // Rewrite header with final statistics
+    if (write_header_at(writer, writer->total_rows) != 0 || apply_durability(writer) != 0) {
+        return -1;
+    }
     
-    // Write final header
-    if (write_header(writer) != 0) {
+    drop_adopted_wal(writer);
+    coord_publish(writer->coord, &writer->header, 0);
+    return 0;
+}
+
+int writer_commit(writer_t* writer) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    int result = commit(writer);
+    fxdb_op_end(FXDB_LATENCY_COMMIT, "writer_commit", NULL, timer);
+    return result;
+}
+
+// Move the rows of the write-ahead log into a chunk and empty the log
+int writer_checkpoint(writer_t* writer) {
+    if (!writer || !writer->file) {
         return -1;
     }
     
-    // Close file
+    if (!writer->wal) {
+        return writer_commit(writer);
+    }
+    
+    return writer->buffer_row_count > 0 ? checkpoint(writer) : 0;
+}
+
+// Close writer and finalize file
+static int close_writer(writer_t* writer) {
+    if (!writer) {
+        return -1;
+    }
+    
+    int result = writer_commit(writer);
+    async_stop(writer);
+    wal_close(writer->wal);
+    writer->wal = NULL;
+    summary_writer_close(writer->summaries);
+    writer->summaries = NULL;
+    if (result != 0) {
+        return -1;
+    }
+    
+    // Close file, which releases the writer lock
+    coord_detach(writer->coord);
+    writer->coord = NULL;
     if (fclose(writer->file) != 0) {
+        writer->file = NULL;
         return -1;
     }
     
@@ -315,15 +1078,31 @@ int writer_close(writer_t* writer) {
     return 0;
 }
 
+int writer_close(writer_t* writer) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    int result = close_writer(writer);
+    fxdb_op_end(FXDB_LATENCY_CLOSE, "writer_close", NULL, timer);
+    return result;
+}
+
 // Free writer resources
 void writer_free(writer_t* writer) {
     if (writer) {
+        async_stop(writer);
+        summary_writer_close(writer->summaries);
+        coord_detach(writer->coord);
         if (writer->file) {
             fclose(writer->file);
         }
         if (writer->row_buffer) {
             free(writer->row_buffer);
         }
+        if (writer->owns_schema) {
+            free_schema(writer->schema);
+        }
+        wal_close(writer->wal);
+        free(writer->adopted_wal);
+        free(writer->validity);
         free(writer);
     }
 }
@@ -404,18 +1183,22 @@ int writer_insert_json(writer_t* writer, const char* json_str) {
         return -1;
     }
     
+    // The working copy and the values come from a stack buffer unless the row is large
+    uint8_t scratch[JSON_SCRATCH_BYTES];
+    fxdb_arena_t arena;
+    fxdb_arena_init(&arena, scratch, sizeof(scratch));
+    
     // Create a working copy of the JSON string
-    char* json_copy = malloc(strlen(json_str) + 1);
+    char* json_copy = fxdb_arena_strdup(&arena, json_str);
     if (!json_copy) {
         return -1;
     }
-    strcpy(json_copy, json_str);
     
     // Trim and validate basic JSON structure
     char* trimmed = trim_whitespace(json_copy);
     if (trimmed[0] != '{' || trimmed[strlen(trimmed) - 1] != '}') {
         fprintf(stderr, "Error: Invalid JSON format - must be an object {...}\n");
-        free(json_copy);
+        fxdb_arena_release(&arena);
         return -1;
     }
     
@@ -424,15 +1207,17 @@ int writer_insert_json(writer_t* writer, const char* json_str) {
     trimmed++;
     
     // Prepare field values array
-    field_value_t* values = malloc(writer->schema->field_count * sizeof(field_value_t));
+    field_value_t* values = fxdb_arena_alloc(&arena, writer->schema->field_count * sizeof(field_value_t));
     if (!values) {
-        free(json_copy);
+        fxdb_arena_release(&arena);
         return -1;
     }
     
-    // Initialize all fields to ensure we have values for all schema fields
+    // Initialize all fields to ensure we have values for all schema fields;
+    // nullable fields that the JSON does not mention stay NULL
     for (uint32_t i = 0; i < writer->schema->field_count; i++) {
         values[i].field_name = writer->schema->fields[i].name;
+        values[i].is_null = writer->schema->fields[i].nullable;
         // Set default values based on type
         switch (writer->schema->fields[i].type) {
             case TYPE_STRING:
@@ -459,8 +1244,7 @@ int writer_insert_json(writer_t* writer, const char* json_str) {
         char* colon = strchr(pair, ':');
         if (!colon) {
             fprintf(stderr, "Error: Invalid JSON pair format\n");
-            free(values);
-            free(json_copy);
+            fxdb_arena_release(&arena);
             return -1;
         }
         
@@ -478,12 +1262,19 @@ int writer_insert_json(writer_t* writer, const char* json_str) {
         int field_index = get_field_index(writer->schema, key);
         if (field_index < 0) {
             fprintf(stderr, "Warning: Field '%s' not found in schema, ignoring\n", key);
+        } else if (strcmp(value, "null") == 0) {
+            if (!writer->schema->fields[field_index].nullable) {
+                fprintf(stderr, "Error: Field '%s' is not nullable\n", key);
+                fxdb_arena_release(&arena);
+                return -1;
+            }
+            values[field_index].is_null = true;
         } else {
+            values[field_index].is_null = false;
             // Parse the value according to the field type
             if (parse_json_value(value, writer->schema->fields[field_index].type, &values[field_index]) < 0) {
                 fprintf(stderr, "Error: Invalid value '%s' for field '%s'\n", value, key);
-                free(values);
-                free(json_copy);
+                fxdb_arena_release(&arena);
                 return -1;
             }
         }
@@ -494,21 +1285,55 @@ int writer_insert_json(writer_t* writer, const char* json_str) {
     // Insert the row using existing function
     int result = writer_insert_row(writer, values, writer->schema->field_count);
     
-    free(values);
-    free(json_copy);
+    fxdb_arena_release(&arena);
     return result;
 }
 
+// Parse a value written as JSON or shell text for a field
+int writer_parse_value(const field_def_t* field, char* text, field_value_t* out) {
+    if (!field || !text || !out) {
+        return -1;
+    }
+    
+    out->field_name = field->name;
+    out->is_null = false;
+    
+    char* trimmed = trim_whitespace(text);
+    if (strcmp(trimmed, "null") == 0) {
+        if (!field->nullable) {
+            fprintf(stderr, "Error: Field '%s' is not nullable\n", field->name);
+            return -1;
+        }
+        out->is_null = true;
+        return 0;
+    }
+    
+    if (parse_json_value(trimmed, field->type, out) < 0) {
+        fprintf(stderr, "Error: Invalid value '%s' for field '%s'\n", trimmed, field->name);
+        return -1;
+    }
+    return 0;
+}
+
 // Open existing .fxdb file for appending
 writer_t* writer_open(const char* filename) {
+    return writer_open_with_config(filename, NULL);
+}
+
+// Open existing .fxdb file for appending with the given configuration
+static writer_t* open_writer(const char* filename, const writer_config_t* config) {
     if (!filename) {
         return NULL;
     }
     
-    // First, try to open the file for reading to validate it exists and is valid
-    FILE* read_file = fopen(filename, "rb");
+    // Take the writer lock before reading the header; it is held until the writer closes
+    uint32_t lock_timeout_ms = config ? config->lock_timeout_ms : writer_default_config().lock_timeout_ms;
+    int fd = coord_open_locked(filename, O_RDWR, lock_timeout_ms);
+    FILE* read_file = fd >= 0 ? fdopen(fd, "r+b") : NULL;
     if (!read_file) {
-        fprintf(stderr, "Error: Cannot open file '%s' for reading: %s\n", filename, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
         return NULL;
     }
     
@@ -526,6 +1351,7 @@ writer_t* writer_open(const char* filename) {
         fclose(read_file);
         return NULL;
     }
+    bool has_root = fxdb_header_resolve(&header) != 0;
     
     // Load schema from file
     if (fseek(read_file, header.schema_offset, SEEK_SET) != 0) {
@@ -576,16 +1402,10 @@ writer_t* writer_open(const char* filename) {
         fclose(read_file);
         return NULL;
     }
+    schema_apply_null_mask(schema, header.null_mask);
     
-    fclose(read_file);
-    
-    // Now open the file for appending
-    FILE* append_file = fopen(filename, "r+b");
-    if (!append_file) {
-        fprintf(stderr, "Error: Cannot open file '%s' for appending: %s\n", filename, strerror(errno));
-        free_schema(schema);
-        return NULL;
-    }
+    // The locked file is the one appended to
+    FILE* append_file = read_file;
     
     // Create writer structure
     writer_t* writer = malloc(sizeof(writer_t));
@@ -599,13 +1419,23 @@ writer_t* writer_open(const char* filename) {
     memset(writer, 0, sizeof(writer_t));
     writer->file = append_file;
     writer->schema = schema;
-    writer->config = writer_default_config();
+    writer->owns_schema = true;
+    writer->config = config ? *config : writer_default_config();
+    writer->config.chunk_size = header.chunk_size; // Readers size chunk buffers from the header
+    writer->config.align_chunks = fxdb_header_aligned(&header);
+    if (writer->config.use_wal) {
+        writer->config.async_io = false; // The log is written synchronously by commit
+    }
     writer->header = header;
     writer->total_rows = header.total_rows;
     writer->current_chunk = header.chunk_count;
     
-    // Position file pointer at the end for appending
-    if (fseek(writer->file, 0, SEEK_END) != 0) {
+    // Append after the last committed chunk: a writer that died before its
+    // commit may have left chunks behind it that no root covers
+    long data_end = (long)header.data_offset + (long)header.data_size;
+    if (has_root ? (ftruncate(fileno(writer->file), data_end) != 0 ||
+                    fseek(writer->file, data_end, SEEK_SET) != 0)
+                 : fseek(writer->file, 0, SEEK_END) != 0) {
         fprintf(stderr, "Error: Cannot seek to end of '%s'\n", filename);
         writer_free(writer);
         return NULL;
@@ -613,7 +1443,66 @@ writer_t* writer_open(const char* filename) {
     
     // Allocate row buffer
     writer->row_buffer = malloc(writer->config.chunk_size * writer->schema->row_size);
-    if (!writer->row_buffer) {
+    if (!writer->row_buffer || init_validity(writer) != 0) {
+        writer_free(writer);
+        return NULL;
+    }
+    
+    // Rows committed to the log since the last checkpoint continue the fill buffer
+    int adopted;
+    if (writer->config.use_wal) {
+        // Opening the log counts its rows in one pass; a checkpoint reads them
+        writer->wal = wal_open(filename, &writer->header, writer->schema->row_size);
+        if (!writer->wal) {
+            fprintf(stderr, "Error: Cannot open write-ahead log of '%s'\n", filename);
+            writer_free(writer);
+            return NULL;
+        }
+        adopted = (int)writer->wal->row_count;
+        if ((uint32_t)adopted > writer->config.chunk_size) {
+            fprintf(stderr, "Error: Write-ahead log of '%s' holds more than one chunk\n", filename);
+            writer_free(writer);
+            return NULL;
+        }
+        writer->buffer_row_count = (uint32_t)adopted;
+        writer->total_rows += (uint32_t)adopted;
+        writer->wal_logged_rows = (uint32_t)adopted;
+        writer->wal_unloaded_rows = (uint32_t)adopted;
+    } else {
+        adopted = adopt_wal(writer, filename);
+        if (adopted < 0) {
+            writer_free(writer);
+            return NULL;
+        }
+    }
+    
+    if (adopted > 0 && !writer->wal) {
+        writer->adopted_wal = wal_path(filename);
+        if (!writer->adopted_wal) {
+            writer_free(writer);
+            return NULL;
+        }
+    }
+    
+    // Summaries of chunks past the last committed one are cut off
+    if (writer->config.chunk_summaries) {
+        writer->summaries = summary_writer_open(filename, &writer->header, writer->schema);
+        if (!writer->summaries) {
+            writer_free(writer);
+            return NULL;
+        }
+    }
+    
+    // Readers that mapped the sidecar see the state this writer starts from
+    writer->coord = coord_attach(filename, true);
+    if (!writer->coord) {
+        writer_free(writer);
+        return NULL;
+    }
+    coord_publish(writer->coord, &writer->header, (uint32_t)adopted);
+    
+    if (writer->config.async_io && async_start(writer) != 0) {
+        fprintf(stderr, "Error: Cannot start background I/O thread\n");
         writer_free(writer);
         return NULL;
     }
@@ -621,6 +1510,13 @@ writer_t* writer_open(const char* filename) {
     return writer;
 }
 
+writer_t* writer_open_with_config(const char* filename, const writer_config_t* config) {
+    fxdb_op_timer_t timer = fxdb_op_begin();
+    writer_t* writer = open_writer(filename, config);
+    fxdb_op_end(FXDB_LATENCY_OPEN, "writer_open", NULL, timer);
+    return writer;
+}
+
 /* ============================================================================
  * Enhanced Database Operations Implementation
  * ============================================================================ */
@@ -651,7 +1547,8 @@ int fxdb_database_create(const char* filename, const schema_t* schema, const fxd
         .enable_compression = false,
         .enable_indexing = false,
         .enable_checksum = true,
-        .initial_capacity = 0
+        .initial_capacity = 0,
+        .align_chunks = false
     };
     
     if (!config) {
@@ -659,11 +1556,11 @@ int fxdb_database_create(const char* filename, const schema_t* schema, const fxd
     }
 
     // Create writer configuration
-    writer_config_t writer_config = {
-        .chunk_size = config->chunk_size,
-        .use_compression = config->enable_compression,
-        .build_index = config->enable_indexing
-    };
+    writer_config_t writer_config = writer_default_config();
+    writer_config.chunk_size = config->chunk_size;
+    writer_config.use_compression = config->enable_compression;
+    writer_config.build_index = config->enable_indexing;
+    writer_config.align_chunks = config->align_chunks;
 
     // Create the database using existing writer_create
     writer_t* writer = writer_create(normalized_name, schema, &writer_config);
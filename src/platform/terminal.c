@@ -8,6 +8,8 @@
     #include <io.h>
 #else
     #include <unistd.h>
+    #include <poll.h>
+    #include <time.h>
     #include <sys/ioctl.h>
     #include <termios.h>
 #endif
@@ -16,6 +18,32 @@
 static int terminal_initialized = 0;
 static int history_enabled = 1;
 static int colors_supported = -1; /* -1 = not checked, 0 = no, 1 = yes */
+static void (*idle_hook)(void* arg) = NULL;
+static void* idle_arg = NULL;
+static int idle_timeout_ms = 0;
+
+void flexon_terminal_set_idle_hook(int timeout_ms, void (*hook)(void* arg), void* arg) {
+    idle_timeout_ms = timeout_ms;
+    idle_hook = hook;
+    idle_arg = arg;
+}
+
+#if FLEXON_HAS_GNU_READLINE
+static struct timespec idle_start;
+static int idle_fired = 0;
+
+/* Called by readline about every 100 ms while it waits for a key */
+static int readline_idle_event(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long waited_ms = (now.tv_sec - idle_start.tv_sec) * 1000L + (now.tv_nsec - idle_start.tv_nsec) / 1000000L;
+    if (!idle_fired && idle_hook && waited_ms >= idle_timeout_ms) {
+        idle_fired = 1;
+        idle_hook(idle_arg);
+    }
+    return 0;
+}
+#endif
 
 /* Terminal initialization */
 int flexon_terminal_init(void) {
@@ -63,6 +91,11 @@ char* flexon_readline(const char* prompt) {
 
 #if FLEXON_HAS_READLINE
     /* Use readline/libedit */
+    #if FLEXON_HAS_GNU_READLINE
+    clock_gettime(CLOCK_MONOTONIC, &idle_start);
+    idle_fired = 0;
+    rl_event_hook = idle_hook ? readline_idle_event : NULL;
+    #endif
     return readline(prompt);
 #elif FLEXON_HAS_LINENOISE
     /* Use linenoise */
@@ -74,6 +107,16 @@ char* flexon_readline(const char* prompt) {
     printf("%s", prompt);
     fflush(stdout);
     
+#if !FLEXON_PLATFORM_WINDOWS
+    /* A terminal hands over one line per read, so an empty descriptor means an idle user */
+    if (idle_hook && isatty(STDIN_FILENO)) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, idle_timeout_ms) == 0) {
+            idle_hook(idle_arg);
+        }
+    }
+#endif
+    
     if (fgets(buffer, sizeof(buffer), stdin) == NULL) {
         return NULL; /* EOF or error */
     }
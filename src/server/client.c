@@ -0,0 +1,302 @@
+#include "../../include/client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define CLIENT_PIPELINE_DEPTH 512   // Inserts in flight in fxdb_client_insert_many
+#define CLIENT_RECV_BYTES 65536
+
+static void set_error(fxdb_client_t* client, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(client->error, sizeof(client->error), format, args);
+    va_end(args);
+}
+
+// Keep an ERROR answer's message as the client's error
+static int check_response(fxdb_client_t* client, const fxdb_response_t* response) {
+    if (response->status == FXDB_STATUS_OK) {
+        return 0;
+    }
+
+    size_t length = response->size < sizeof(client->error) - 1 ? response->size : sizeof(client->error) - 1;
+    memcpy(client->error, response->payload, length);
+    client->error[length] = '\0';
+    return -1;
+}
+
+// Connect to a server
+fxdb_client_t* fxdb_client_connect(const char* socket_path) {
+    if (!socket_path) {
+        return NULL;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path is too long: %s\n", socket_path);
+        return NULL;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Error: Cannot connect to server at '%s': %s\n", socket_path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    fxdb_client_t* client = calloc(1, sizeof(fxdb_client_t));
+    if (!client) {
+        close(fd);
+        return NULL;
+    }
+    client->fd = fd;
+    client->next_id = 1;
+    return client;
+}
+
+// Queue a request without waiting for its answer
+uint32_t fxdb_client_send(fxdb_client_t* client, fxdb_op_t op, const char* database,
+                          const void* body, uint32_t size) {
+    if (!client) {
+        return 0;
+    }
+
+    uint32_t id = client->next_id++;
+    if (client->next_id == 0) {
+        client->next_id = 1;
+    }
+
+    size_t start = fxdb_frame_begin(&client->out, id, (uint8_t)op);
+    if (start == (size_t)-1 || fxdb_buffer_put_string(&client->out, database) != 0 ||
+        fxdb_buffer_append(&client->out, body, size) != 0 ||
+        client->out.length - start > FXDB_MAX_FRAME) {
+        client->out.length = start == (size_t)-1 ? client->out.length : start;
+        set_error(client, "Request too large");
+        return 0;
+    }
+    fxdb_frame_end(&client->out, start);
+    return id;
+}
+
+// Write all queued requests
+int fxdb_client_flush(fxdb_client_t* client) {
+    if (!client) {
+        return -1;
+    }
+
+    size_t sent = 0;
+    while (sent < client->out.length) {
+        ssize_t n = send(client->fd, client->out.data + sent, client->out.length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            set_error(client, "Connection lost: %s", strerror(errno));
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    client->out.length = 0;
+    return 0;
+}
+
+// Wait for the next answer, writing queued requests first
+int fxdb_client_receive(fxdb_client_t* client, fxdb_response_t* response) {
+    if (!client || !response || fxdb_client_flush(client) != 0) {
+        return -1;
+    }
+
+    // The previous answer's payload is released now
+    fxdb_buffer_consume(&client->in, client->consumed);
+    client->consumed = 0;
+
+    size_t size;
+    while ((size = fxdb_frame_size(client->in.data, client->in.length)) == 0) {
+        uint8_t chunk[CLIENT_RECV_BYTES];
+        ssize_t n = recv(client->fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            set_error(client, "Connection lost%s%s", n < 0 ? ": " : "", n < 0 ? strerror(errno) : "");
+            return -1;
+        }
+        if (fxdb_buffer_append(&client->in, chunk, (size_t)n) != 0) {
+            set_error(client, "Out of memory");
+            return -1;
+        }
+    }
+    if (size == (size_t)-1) {
+        set_error(client, "Malformed answer from server");
+        return -1;
+    }
+
+    memcpy(&response->id, client->in.data + sizeof(uint32_t), sizeof(uint32_t));
+    response->status = client->in.data[2 * sizeof(uint32_t)];
+    response->payload = client->in.data + FXDB_FRAME_HEADER;
+    response->size = (uint32_t)(size - FXDB_FRAME_HEADER);
+    client->consumed = size;
+    return 0;
+}
+
+// Send one request and wait for its answer
+static int call(fxdb_client_t* client, fxdb_op_t op, const char* database,
+                const void* body, uint32_t size, fxdb_response_t* response) {
+    if (fxdb_client_send(client, op, database, body, size) == 0 ||
+        fxdb_client_receive(client, response) != 0) {
+        return -1;
+    }
+    return check_response(client, response);
+}
+
+// Check that the server answers
+int fxdb_client_ping(fxdb_client_t* client) {
+    fxdb_response_t response;
+    return call(client, FXDB_OP_PING, NULL, NULL, 0, &response);
+}
+
+// Insert a row given as a JSON object
+int fxdb_client_insert(fxdb_client_t* client, const char* database, const char* json) {
+    if (!json) {
+        return -1;
+    }
+    fxdb_response_t response;
+    return call(client, FXDB_OP_INSERT, database, json, (uint32_t)strlen(json), &response);
+}
+
+// Insert rows with the requests pipelined
+int fxdb_client_insert_many(fxdb_client_t* client, const char* database,
+                            const char* const* json_rows, uint32_t count) {
+    if (!client || (!json_rows && count > 0)) {
+        return -1;
+    }
+
+    // Keep a window of requests in flight so neither side buffers them all
+    int inserted = 0;
+    uint32_t sent = 0;
+    uint32_t answered = 0;
+    while (answered < count) {
+        while (sent < count && sent - answered < CLIENT_PIPELINE_DEPTH) {
+            const char* json = json_rows[sent];
+            if (fxdb_client_send(client, FXDB_OP_INSERT, database, json,
+                                 json ? (uint32_t)strlen(json) : 0) == 0) {
+                return -1;
+            }
+            sent++;
+        }
+
+        fxdb_response_t response;
+        if (fxdb_client_receive(client, &response) != 0) {
+            return -1;
+        }
+        if (check_response(client, &response) == 0) {
+            inserted++;
+        }
+        answered++;
+    }
+    return inserted;
+}
+
+// Count the live rows of a database
+int fxdb_client_count(fxdb_client_t* client, const char* database, uint32_t* rows) {
+    fxdb_response_t response;
+    if (!rows || call(client, FXDB_OP_COUNT, database, NULL, 0, &response) != 0) {
+        return -1;
+    }
+
+    fxdb_payload_t payload = { response.payload, response.size, 0, false };
+    *rows = fxdb_payload_u32(&payload);
+    return payload.failed ? -1 : 0;
+}
+
+// Schema of a database
+schema_t* fxdb_client_schema(fxdb_client_t* client, const char* database) {
+    fxdb_response_t response;
+    if (call(client, FXDB_OP_SCHEMA, database, NULL, 0, &response) != 0) {
+        return NULL;
+    }
+
+    char* text = malloc((size_t)response.size + 1);
+    if (!text) {
+        return NULL;
+    }
+    memcpy(text, response.payload, response.size);
+    text[response.size] = '\0';
+    schema_t* schema = parse_schema(text);
+    free(text);
+    return schema;
+}
+
+// Read rows from a position, advancing it
+query_result_t* fxdb_client_read(fxdb_client_t* client, const char* database, const schema_t* schema,
+                                 row_position_t* position, uint32_t limit) {
+    if (!schema || !position) {
+        return NULL;
+    }
+
+    uint32_t body[3] = { position->chunk_index, position->row_in_chunk, limit };
+    fxdb_response_t response;
+    if (call(client, FXDB_OP_READ, database, body, sizeof(body), &response) != 0) {
+        return NULL;
+    }
+
+    fxdb_payload_t payload = { response.payload, response.size, 0, false };
+    row_position_t next;
+    next.chunk_index = fxdb_payload_u32(&payload);
+    next.row_in_chunk = fxdb_payload_u32(&payload);
+    uint32_t count = fxdb_payload_u32(&payload);
+
+    query_result_t* result = calloc(1, sizeof(query_result_t));
+    if (!result) {
+        return NULL;
+    }
+    result->schema = schema;
+    result->rows = count > 0 && !payload.failed ? calloc(count, sizeof(row_data_t)) : NULL;
+    if (count > 0 && !result->rows) {
+        payload.failed = true;
+    }
+
+    // Rows decoded so far are kept in the result, so freeing it cleans up
+    while (!payload.failed && result->row_count < count) {
+        int status = fxdb_decode_row(&payload, schema, &result->rows[result->row_count]);
+        if (result->rows[result->row_count].values) {
+            result->row_count++;
+        }
+        if (status != 0) {
+            payload.failed = true;
+        }
+    }
+    if (payload.failed) {
+        set_error(client, "Malformed answer from server");
+        reader_free_result(result);
+        return NULL;
+    }
+
+    *position = next;
+    return result;
+}
+
+// Message of the last failure
+const char* fxdb_client_error(const fxdb_client_t* client) {
+    return client ? client->error : "No client";
+}
+
+// Close the connection and free the client
+void fxdb_client_close(fxdb_client_t* client) {
+    if (client) {
+        close(client->fd);
+        fxdb_buffer_free(&client->out);
+        fxdb_buffer_free(&client->in);
+        free(client);
+    }
+}
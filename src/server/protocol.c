@@ -0,0 +1,248 @@
+#include "../../include/protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Append bytes to a buffer, growing it
+int fxdb_buffer_append(fxdb_buffer_t* buffer, const void* data, size_t size) {
+    if (buffer->length + size > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 256;
+        while (capacity < buffer->length + size) {
+            capacity *= 2;
+        }
+        uint8_t* grown = realloc(buffer->data, capacity);
+        if (!grown) {
+            return -1;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+
+    if (size > 0) {
+        memcpy(buffer->data + buffer->length, data, size);
+    }
+    buffer->length += size;
+    return 0;
+}
+
+int fxdb_buffer_put_u8(fxdb_buffer_t* buffer, uint8_t value) {
+    return fxdb_buffer_append(buffer, &value, sizeof(value));
+}
+
+int fxdb_buffer_put_u16(fxdb_buffer_t* buffer, uint16_t value) {
+    return fxdb_buffer_append(buffer, &value, sizeof(value));
+}
+
+int fxdb_buffer_put_u32(fxdb_buffer_t* buffer, uint32_t value) {
+    return fxdb_buffer_append(buffer, &value, sizeof(value));
+}
+
+// Append a string as [u16 length][bytes]
+int fxdb_buffer_put_string(fxdb_buffer_t* buffer, const char* text) {
+    size_t length = text ? strlen(text) : 0;
+    if (length > UINT16_MAX) {
+        return -1;
+    }
+    if (fxdb_buffer_put_u16(buffer, (uint16_t)length) != 0) {
+        return -1;
+    }
+    return fxdb_buffer_append(buffer, text, length);
+}
+
+// Drop the first `size` bytes of a buffer
+void fxdb_buffer_consume(fxdb_buffer_t* buffer, size_t size) {
+    if (size >= buffer->length) {
+        buffer->length = 0;
+        return;
+    }
+    memmove(buffer->data, buffer->data + size, buffer->length - size);
+    buffer->length -= size;
+}
+
+// Free a buffer's storage
+void fxdb_buffer_free(fxdb_buffer_t* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+// Start a frame with a placeholder length
+size_t fxdb_frame_begin(fxdb_buffer_t* buffer, uint32_t id, uint8_t code) {
+    size_t start = buffer->length;
+    if (fxdb_buffer_put_u32(buffer, 0) != 0 || fxdb_buffer_put_u32(buffer, id) != 0 ||
+        fxdb_buffer_put_u8(buffer, code) != 0) {
+        buffer->length = start;
+        return (size_t)-1;
+    }
+    return start;
+}
+
+// Finish a frame: its length counts the bytes after the length field
+void fxdb_frame_end(fxdb_buffer_t* buffer, size_t start) {
+    uint32_t length = (uint32_t)(buffer->length - start - sizeof(uint32_t));
+    memcpy(buffer->data + start, &length, sizeof(length));
+}
+
+// Size of the first complete frame, length field included
+size_t fxdb_frame_size(const uint8_t* data, size_t length) {
+    if (length < sizeof(uint32_t)) {
+        return 0;
+    }
+
+    uint32_t frame_length;
+    memcpy(&frame_length, data, sizeof(frame_length));
+    if (frame_length < FXDB_FRAME_HEADER - sizeof(uint32_t) || frame_length > FXDB_MAX_FRAME) {
+        return (size_t)-1;
+    }
+    size_t size = sizeof(uint32_t) + frame_length;
+    return length >= size ? size : 0;
+}
+
+// Copy `size` payload bytes out, or flag a short payload
+static bool payload_take(fxdb_payload_t* payload, void* out, size_t size) {
+    if (payload->failed || payload->length - payload->offset < size) {
+        payload->failed = true;
+        memset(out, 0, size);
+        return false;
+    }
+    memcpy(out, payload->data + payload->offset, size);
+    payload->offset += size;
+    return true;
+}
+
+uint8_t fxdb_payload_u8(fxdb_payload_t* payload) {
+    uint8_t value;
+    payload_take(payload, &value, sizeof(value));
+    return value;
+}
+
+uint16_t fxdb_payload_u16(fxdb_payload_t* payload) {
+    uint16_t value;
+    payload_take(payload, &value, sizeof(value));
+    return value;
+}
+
+uint32_t fxdb_payload_u32(fxdb_payload_t* payload) {
+    uint32_t value;
+    payload_take(payload, &value, sizeof(value));
+    return value;
+}
+
+// Read a [u16 length][bytes] string
+char* fxdb_payload_string(fxdb_payload_t* payload) {
+    uint16_t length = fxdb_payload_u16(payload);
+    if (payload->failed || payload->length - payload->offset < length) {
+        payload->failed = true;
+        return NULL;
+    }
+
+    char* text = malloc((size_t)length + 1);
+    if (!text) {
+        return NULL;
+    }
+    memcpy(text, payload->data + payload->offset, length);
+    text[length] = '\0';
+    payload->offset += length;
+    return text;
+}
+
+// Schema as the text parse_schema() reads back
+char* fxdb_schema_to_string(const schema_t* schema) {
+    if (!schema) {
+        return NULL;
+    }
+
+    fxdb_buffer_t text = { 0 };
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        const field_def_t* field = &schema->fields[i];
+        char part[MAX_FIELD_NAME_LENGTH + 32];
+        int length = snprintf(part, sizeof(part), "%s%s %s%s", i > 0 ? ", " : "", field->name,
+                              field_type_to_string(field->type), field->nullable ? "?" : "");
+        if (length < 0 || fxdb_buffer_append(&text, part, (size_t)length) != 0) {
+            fxdb_buffer_free(&text);
+            return NULL;
+        }
+    }
+    if (fxdb_buffer_put_u8(&text, '\0') != 0) {
+        fxdb_buffer_free(&text);
+        return NULL;
+    }
+    return (char*)text.data;
+}
+
+// Append a row in wire layout
+int fxdb_encode_row(fxdb_buffer_t* buffer, const schema_t* schema, const row_data_t* row) {
+    for (uint32_t i = 0; i < schema->field_count && i < row->field_count; i++) {
+        const field_value_t* value = &row->values[i];
+        bool is_null = schema->fields[i].nullable && value->is_null;
+        if (fxdb_buffer_put_u8(buffer, is_null ? 0 : 1) != 0) {
+            return -1;
+        }
+        if (is_null) {
+            continue;
+        }
+
+        int status = 0;
+        switch (schema->fields[i].type) {
+            case FIELD_TYPE_INT32:
+                status = fxdb_buffer_append(buffer, &value->value.int32_val, sizeof(int32_t));
+                break;
+            case FIELD_TYPE_FLOAT:
+                status = fxdb_buffer_append(buffer, &value->value.float_val, sizeof(float));
+                break;
+            case FIELD_TYPE_BOOL:
+                status = fxdb_buffer_put_u8(buffer, value->value.bool_val ? 1 : 0);
+                break;
+            case FIELD_TYPE_STRING:
+                status = fxdb_buffer_put_string(buffer, value->value.string_val);
+                break;
+            default:
+                status = -1;
+                break;
+        }
+        if (status != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Decode a row in wire layout
+int fxdb_decode_row(fxdb_payload_t* payload, const schema_t* schema, row_data_t* row) {
+    row->field_count = schema->field_count;
+    row->values = calloc(schema->field_count, sizeof(field_value_t));
+    if (!row->values) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        field_value_t* value = &row->values[i];
+        value->field_name = schema->fields[i].name;
+        value->is_null = fxdb_payload_u8(payload) == 0;
+        if (value->is_null) {
+            continue;
+        }
+
+        switch (schema->fields[i].type) {
+            case FIELD_TYPE_INT32:
+                value->value.int32_val = (int32_t)fxdb_payload_u32(payload);
+                break;
+            case FIELD_TYPE_FLOAT:
+                payload_take(payload, &value->value.float_val, sizeof(float));
+                break;
+            case FIELD_TYPE_BOOL:
+                value->value.bool_val = fxdb_payload_u8(payload) != 0;
+                break;
+            case FIELD_TYPE_STRING:
+                value->value.string_val = fxdb_payload_string(payload);
+                break;
+            default:
+                payload->failed = true;
+                break;
+        }
+    }
+
+    // Strings decoded so far belong to the row; the caller frees it as usual
+    return payload->failed ? -1 : 0;
+}
@@ -0,0 +1,993 @@
+#define _GNU_SOURCE
+#include "../../include/server.h"
+#include "../../include/protocol.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/io_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVE_TICK_MS 500                   // Longest epoll wait, for idle writer checks
+#define SERVE_MAX_EVENTS 64
+#define SERVE_RECV_BYTES 65536
+#define SERVE_READ_BYTES (1024 * 1024)      // A READ answer stops adding rows past this
+#define SERVE_DEFAULT_IDLE_MS 2000
+#define SERVE_BACKLOG_BYTES (4 * 1024 * 1024)  // Unsent answers or queued requests a connection may pile up
+
+// Request split from a connection's bytes
+typedef struct request {
+    uint32_t id;
+    uint8_t op;
+    char* name;                 // Database name (NULL when the payload was malformed)
+    uint8_t* body;              // Payload after the name
+    uint32_t body_size;
+    size_t frame_size;          // Bytes of the frame, counted against the backlog
+    int status;                 // Insert result while a run of inserts is committed
+    struct request* next;
+} request_t;
+
+// Client connection
+typedef struct connection {
+    int fd;
+    fxdb_buffer_t in;           // Bytes not yet split into requests (event loop only)
+    pthread_mutex_t lock;       // Guards the fields below
+    request_t* head;            // Requests waiting for a worker, in arrival order
+    request_t* tail;
+    size_t queued_bytes;        // Frame bytes of the queued requests
+    fxdb_buffer_t out;          // Answers not yet sent
+    uint32_t events;            // Events registered with epoll
+    bool scheduled;             // Queued on or served by a worker
+    bool flush_pending;         // On the flush list, waiting for its events to be updated
+    bool closed;                // Dropped by the event loop; answers are discarded
+    uint32_t refs;              // Event loop, worker and flush list references
+    struct connection* next_work;
+    struct connection* next_flush;
+    struct connection* next_open;
+} connection_t;
+
+// Database kept open for clients
+typedef struct served_db {
+    char* name;                 // Name clients use
+    char* path;                 // Resolved file path
+    pthread_mutex_t read_lock;  // Guards reader
+    reader_t* reader;
+    pthread_mutex_t write_lock; // Guards writer and last_insert_ms
+    writer_t* writer;
+    uint64_t last_insert_ms;
+    struct served_db* next;
+} served_db_t;
+
+struct fxdb_server {
+    char* socket_path;
+    char* directory;
+    uint32_t writer_idle_ms;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                // eventfd: stop requests and connections to flush
+    int stopping;
+
+    // Worker pool and the connections waiting for it
+    pthread_t* threads;
+    uint32_t thread_count;
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_ready;
+    connection_t* work_head;
+    connection_t* work_tail;
+    bool shutdown;
+
+    pthread_mutex_t flush_lock;
+    connection_t* flush_list;   // Connections with answers to send or reads to resume
+    connection_t* connections;  // Open connections (event loop only)
+
+    pthread_mutex_t db_lock;    // Guards databases
+    served_db_t* databases;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+static void wake_loop(fxdb_server_t* server) {
+    uint64_t one = 1;
+    ssize_t written = write(server->wake_fd, &one, sizeof(one));
+    (void)written; // A full counter already wakes the loop
+}
+
+static void free_requests(request_t* request) {
+    while (request) {
+        request_t* next = request->next;
+        free(request->name);
+        free(request->body);
+        free(request);
+        request = next;
+    }
+}
+
+static void release_connection(connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    uint32_t refs = --conn->refs;
+    pthread_mutex_unlock(&conn->lock);
+    if (refs > 0) {
+        return;
+    }
+
+    free_requests(conn->head);
+    fxdb_buffer_free(&conn->in);
+    fxdb_buffer_free(&conn->out);
+    pthread_mutex_destroy(&conn->lock);
+    free(conn);
+}
+
+// Send what the socket takes; called with conn->lock held
+// Returns 0 when everything was sent, 1 when bytes remain, -1 on error
+static int send_pending(connection_t* conn) {
+    size_t sent = 0;
+    while (sent < conn->out.length) {
+        ssize_t n = send(conn->fd, conn->out.data + sent, conn->out.length - sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            fxdb_buffer_consume(&conn->out, sent);
+            return (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 1 : -1;
+        }
+    }
+    conn->out.length = 0;
+    return 0;
+}
+
+// Events a connection should wait for; called with conn->lock held
+// Its socket is not read while it is too far behind on answers or requests
+static uint32_t wanted_events(const connection_t* conn) {
+    uint32_t events = conn->out.length > 0 ? EPOLLOUT : 0;
+    if (conn->out.length < SERVE_BACKLOG_BYTES && conn->queued_bytes < SERVE_BACKLOG_BYTES) {
+        events |= EPOLLIN;
+    }
+    return events;
+}
+
+// Put a connection with requests on the work queue unless it is already there,
+// being served or over the answer cap
+static void schedule_connection(fxdb_server_t* server, connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    bool schedule = !conn->scheduled && !conn->closed && conn->head && conn->out.length < SERVE_BACKLOG_BYTES;
+    if (schedule) {
+        conn->scheduled = true;
+        conn->refs++;
+    }
+    pthread_mutex_unlock(&conn->lock);
+    if (!schedule) {
+        return;
+    }
+
+    pthread_mutex_lock(&server->queue_lock);
+    conn->next_work = NULL;
+    if (server->work_tail) {
+        server->work_tail->next_work = conn;
+    } else {
+        server->work_head = conn;
+    }
+    server->work_tail = conn;
+    pthread_cond_signal(&server->queue_ready);
+    pthread_mutex_unlock(&server->queue_lock);
+}
+
+// Register the events a connection waits for; called with conn->lock held
+static void set_events(fxdb_server_t* server, connection_t* conn, uint32_t events) {
+    if (events == conn->events) {
+        return;
+    }
+    struct epoll_event event = { 0 };
+    event.events = events;
+    event.data.ptr = conn;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->events = events;
+}
+
+/* ===== Answers ===== */
+
+static void answer(fxdb_buffer_t* answers, uint32_t id, const void* payload, size_t size) {
+    size_t start = fxdb_frame_begin(answers, id, FXDB_STATUS_OK);
+    if (start != (size_t)-1 && fxdb_buffer_append(answers, payload, size) == 0) {
+        fxdb_frame_end(answers, start);
+    }
+}
+
+static void answer_error(fxdb_buffer_t* answers, uint32_t id, const char* format, ...) {
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    size_t start = fxdb_frame_begin(answers, id, FXDB_STATUS_ERROR);
+    if (start != (size_t)-1 && fxdb_buffer_append(answers, message, strlen(message)) == 0) {
+        fxdb_frame_end(answers, start);
+    }
+}
+
+/* ===== Databases ===== */
+
+// Path of a database name in the served directory, NULL for names that would leave it
+static char* resolve_path(const fxdb_server_t* server, const char* name) {
+    if (server->directory && (strchr(name, '/') || strstr(name, ".."))) {
+        return NULL;
+    }
+
+    char* file = fxdb_normalize_filename(name);
+    if (!file || !server->directory) {
+        return file;
+    }
+
+    size_t length = strlen(server->directory) + strlen(file) + 2;
+    char* path = malloc(length);
+    if (path) {
+        snprintf(path, length, "%s/%s", server->directory, file);
+    }
+    free(file);
+    return path;
+}
+
+// Served database of a name, added on first use
+static served_db_t* find_database(fxdb_server_t* server, const char* name) {
+    pthread_mutex_lock(&server->db_lock);
+    served_db_t* db = server->databases;
+    while (db && strcmp(db->name, name) != 0) {
+        db = db->next;
+    }
+
+    if (!db) {
+        char* path = resolve_path(server, name);
+        if (path && fxdb_database_exists(path) && (db = calloc(1, sizeof(served_db_t))) != NULL) {
+            db->name = strdup(name);
+            db->path = path;
+            path = NULL;
+            pthread_mutex_init(&db->read_lock, NULL);
+            pthread_mutex_init(&db->write_lock, NULL);
+            db->next = server->databases;
+            server->databases = db;
+        }
+        free(path);
+    }
+    pthread_mutex_unlock(&server->db_lock);
+    return db;
+}
+
+// Reader of a database holding every committed row; called with read_lock held
+static reader_t* fresh_reader(served_db_t* db) {
+    if (db->reader && reader_poll(db->reader, NULL) != 0 && reader_refresh(db->reader) != 0) {
+        // Compacted or replaced: row positions changed, start over
+        reader_close(db->reader);
+        db->reader = NULL;
+    }
+    if (!db->reader) {
+        db->reader = reader_open(db->path);
+    }
+    return db->reader;
+}
+
+static void close_database(served_db_t* db) {
+    if (db->writer) {
+        writer_close(db->writer);
+        writer_free(db->writer);
+    }
+    reader_close(db->reader);
+    pthread_mutex_destroy(&db->read_lock);
+    pthread_mutex_destroy(&db->write_lock);
+    free(db->name);
+    free(db->path);
+    free(db);
+}
+
+// Close writers without recent inserts, releasing the database to other writers
+static void close_idle_writers(fxdb_server_t* server) {
+    uint64_t now = now_ms();
+    pthread_mutex_lock(&server->db_lock);
+    for (served_db_t* db = server->databases; db; db = db->next) {
+        if (pthread_mutex_trylock(&db->write_lock) != 0) {
+            continue; // Inserting right now
+        }
+        if (db->writer && now - db->last_insert_ms >= server->writer_idle_ms) {
+            writer_close(db->writer);
+            writer_free(db->writer);
+            db->writer = NULL;
+        }
+        pthread_mutex_unlock(&db->write_lock);
+    }
+    pthread_mutex_unlock(&server->db_lock);
+}
+
+/* ===== Requests ===== */
+
+// Rows of a database from a position, as many as fit in one answer
+static void serve_read(served_db_t* db, const request_t* request, fxdb_buffer_t* answers) {
+    fxdb_payload_t payload = { request->body, request->body_size, 0, false };
+    row_position_t position;
+    position.chunk_index = fxdb_payload_u32(&payload);
+    position.row_in_chunk = fxdb_payload_u32(&payload);
+    uint32_t limit = fxdb_payload_u32(&payload);
+    if (payload.failed) {
+        answer_error(answers, request->id, "Malformed READ request");
+        return;
+    }
+
+    pthread_mutex_lock(&db->read_lock);
+    reader_t* reader = fresh_reader(db);
+    if (!reader) {
+        pthread_mutex_unlock(&db->read_lock);
+        answer_error(answers, request->id, "Cannot open database '%s'", request->name);
+        return;
+    }
+
+    uint32_t header[3] = { 0, 0, 0 };
+    size_t start = fxdb_frame_begin(answers, request->id, FXDB_STATUS_OK);
+    size_t fields = answers->length;
+    if (start == (size_t)-1 || fxdb_buffer_append(answers, header, sizeof(header)) != 0) {
+        pthread_mutex_unlock(&db->read_lock);
+        answers->length = start == (size_t)-1 ? answers->length : start;
+        return;
+    }
+
+    // Resume at the position, like a follow cursor: earlier chunks are not read
+    uint32_t count = 0;
+    uint32_t chunks = reader->header.chunk_count + (reader->wal_rows > 0 ? 1 : 0);
+    if (position.chunk_index < chunks && reader_load_chunk(reader, position.chunk_index) == 0) {
+        reader->current_row = position.row_in_chunk < reader->chunk_row_count ?
+                              position.row_in_chunk : reader->chunk_row_count;
+        row_data_t* row;
+        while (count < limit && answers->length - start < SERVE_READ_BYTES &&
+               (row = reader_read_row_pooled(reader)) != NULL) {
+            fxdb_encode_row(answers, reader->schema, row);
+            reader_release_row(reader, row);
+            count++;
+        }
+        position.chunk_index = reader->current_chunk;
+        position.row_in_chunk = reader->current_row < reader->chunk_row_count ?
+                                reader->current_row : reader->chunk_row_count;
+    }
+    pthread_mutex_unlock(&db->read_lock);
+
+    header[0] = position.chunk_index;
+    header[1] = position.row_in_chunk;
+    header[2] = count;
+    memcpy(answers->data + fields, header, sizeof(header));
+    fxdb_frame_end(answers, start);
+}
+
+// Answer a request other than INSERT
+static void serve_request(fxdb_server_t* server, const request_t* request, fxdb_buffer_t* answers) {
+    if (request->op == FXDB_OP_PING) {
+        answer(answers, request->id, NULL, 0);
+        return;
+    }
+    if (!request->name) {
+        answer_error(answers, request->id, "Malformed request");
+        return;
+    }
+
+    served_db_t* db = find_database(server, request->name);
+    if (!db) {
+        answer_error(answers, request->id, "Database does not exist: %s", request->name);
+        return;
+    }
+
+    if (request->op == FXDB_OP_READ) {
+        serve_read(db, request, answers);
+        return;
+    }
+    if (request->op != FXDB_OP_SCHEMA && request->op != FXDB_OP_COUNT) {
+        answer_error(answers, request->id, "Unknown operation %u", request->op);
+        return;
+    }
+
+    pthread_mutex_lock(&db->read_lock);
+    reader_t* reader = fresh_reader(db);
+    char* schema = NULL;
+    uint32_t rows = 0;
+    if (reader && request->op == FXDB_OP_SCHEMA) {
+        schema = fxdb_schema_to_string(reader->schema);
+    } else if (reader) {
+        rows = reader_get_row_count(reader);
+    }
+    pthread_mutex_unlock(&db->read_lock);
+
+    if (!reader) {
+        answer_error(answers, request->id, "Cannot open database '%s'", request->name);
+    } else if (request->op == FXDB_OP_COUNT) {
+        answer(answers, request->id, &rows, sizeof(rows));
+    } else if (schema) {
+        answer(answers, request->id, schema, strlen(schema));
+    } else {
+        answer_error(answers, request->id, "Out of memory");
+    }
+    free(schema);
+}
+
+// Insert a run of consecutive INSERTs into one database with a single commit
+// Returns the request after the run
+static request_t* serve_inserts(fxdb_server_t* server, request_t* first, fxdb_buffer_t* answers) {
+    request_t* end = first->next;
+    while (first->name && end && end->op == FXDB_OP_INSERT && end->name &&
+           strcmp(end->name, first->name) == 0) {
+        end = end->next;
+    }
+
+    served_db_t* db = first->name ? find_database(server, first->name) : NULL;
+    bool committed = false;
+    if (db) {
+        pthread_mutex_lock(&db->write_lock);
+        if (!db->writer) {
+            // Logged commits: each insert costs a log append, not a chunk
+            writer_config_t config = writer_default_config();
+            config.use_wal = true;
+            db->writer = writer_open_with_config(db->path, &config);
+        }
+        if (db->writer) {
+            for (request_t* request = first; request != end; request = request->next) {
+                char* json = malloc((size_t)request->body_size + 1);
+                request->status = -1;
+                if (json) {
+                    memcpy(json, request->body, request->body_size);
+                    json[request->body_size] = '\0';
+                    request->status = writer_insert_json(db->writer, json);
+                    free(json);
+                }
+            }
+            committed = writer_commit(db->writer) == 0;
+            db->last_insert_ms = now_ms();
+        }
+        pthread_mutex_unlock(&db->write_lock);
+    }
+
+    for (request_t* request = first; request != end; request = request->next) {
+        if (!request->name) {
+            answer_error(answers, request->id, "Malformed request");
+        } else if (!db) {
+            answer_error(answers, request->id, "Database does not exist: %s", request->name);
+        } else if (!committed) {
+            answer_error(answers, request->id, "Cannot write to database '%s'", request->name);
+        } else if (request->status != 0) {
+            answer_error(answers, request->id, "Invalid row for '%s'", request->name);
+        } else {
+            answer(answers, request->id, NULL, 0);
+        }
+    }
+    return end;
+}
+
+// Serve a connection's queued requests until none are left, or until its
+// unsent answers reach the backlog cap; the event loop reschedules it once
+// they drain
+static void serve_connection(fxdb_server_t* server, connection_t* conn) {
+    fxdb_buffer_t answers = { 0 };
+    for (;;) {
+        pthread_mutex_lock(&conn->lock);
+        request_t* requests = conn->head;
+        if (!requests || (!conn->closed && conn->out.length >= SERVE_BACKLOG_BYTES)) {
+            conn->scheduled = false;
+            pthread_mutex_unlock(&conn->lock);
+            break;
+        }
+        conn->head = conn->tail = NULL;
+        pthread_mutex_unlock(&conn->lock);
+
+        answers.length = 0;
+        request_t* request = requests;
+        while (request && answers.length < SERVE_BACKLOG_BYTES) {
+            if (request->op == FXDB_OP_INSERT) {
+                request = serve_inserts(server, request, &answers);
+            } else {
+                serve_request(server, request, &answers);
+                request = request->next;
+            }
+        }
+
+        size_t served_bytes = 0;
+        while (requests != request) {
+            request_t* next = requests->next;
+            served_bytes += requests->frame_size;
+            requests->next = NULL;
+            free_requests(requests);
+            requests = next;
+        }
+
+        // Send right away; what the socket does not take goes out on EPOLLOUT
+        bool arm = false;
+        pthread_mutex_lock(&conn->lock);
+        conn->queued_bytes -= served_bytes;
+        if (request) {
+            // Requests past the cap go back to the front of the queue
+            request_t* last = request;
+            while (last->next) {
+                last = last->next;
+            }
+            last->next = conn->head;
+            if (!conn->head) {
+                conn->tail = last;
+            }
+            conn->head = request;
+        }
+        if (!conn->closed && fxdb_buffer_append(&conn->out, answers.data, answers.length) == 0 &&
+            send_pending(conn) >= 0 && (wanted_events(conn) & ~conn->events) != 0 && !conn->flush_pending) {
+            conn->flush_pending = true;
+            conn->refs++;
+            arm = true;
+        }
+        pthread_mutex_unlock(&conn->lock);
+
+        if (arm) {
+            pthread_mutex_lock(&server->flush_lock);
+            conn->next_flush = server->flush_list;
+            server->flush_list = conn;
+            pthread_mutex_unlock(&server->flush_lock);
+            wake_loop(server);
+        }
+    }
+    fxdb_buffer_free(&answers);
+    release_connection(conn);
+}
+
+static void* worker_main(void* arg) {
+    fxdb_server_t* server = (fxdb_server_t*)arg;
+    for (;;) {
+        pthread_mutex_lock(&server->queue_lock);
+        while (!server->work_head && !server->shutdown) {
+            pthread_cond_wait(&server->queue_ready, &server->queue_lock);
+        }
+        connection_t* conn = server->work_head;
+        if (!conn) {
+            pthread_mutex_unlock(&server->queue_lock);
+            return NULL;
+        }
+        server->work_head = conn->next_work;
+        if (!server->work_head) {
+            server->work_tail = NULL;
+        }
+        pthread_mutex_unlock(&server->queue_lock);
+
+        serve_connection(server, conn);
+    }
+}
+
+/* ===== Event loop ===== */
+
+static void close_connection(fxdb_server_t* server, connection_t* conn) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+
+    pthread_mutex_lock(&conn->lock);
+    conn->closed = true;
+    close(conn->fd);
+    pthread_mutex_unlock(&conn->lock);
+
+    connection_t** link = &server->connections;
+    while (*link && *link != conn) {
+        link = &(*link)->next_open;
+    }
+    if (*link) {
+        *link = conn->next_open;
+    }
+    release_connection(conn);
+}
+
+static void accept_connections(fxdb_server_t* server) {
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                fprintf(stderr, "Error: Cannot accept connection: %s\n", strerror(errno));
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        connection_t* conn = calloc(1, sizeof(connection_t));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->refs = 1;
+        conn->events = EPOLLIN;
+        pthread_mutex_init(&conn->lock, NULL);
+
+        struct epoll_event event = { 0 };
+        event.events = conn->events;
+        event.data.ptr = conn;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            pthread_mutex_destroy(&conn->lock);
+            free(conn);
+            continue;
+        }
+        conn->next_open = server->connections;
+        server->connections = conn;
+    }
+}
+
+// Split complete frames into requests
+// Returns the requests in order, or sets *bad on a malformed frame
+static request_t* split_requests(connection_t* conn, bool* bad) {
+    request_t* head = NULL;
+    request_t** tail = &head;
+    size_t offset = 0;
+    for (;;) {
+        size_t size = fxdb_frame_size(conn->in.data + offset, conn->in.length - offset);
+        if (size == (size_t)-1) {
+            *bad = true;
+            break;
+        }
+        if (size == 0) {
+            break;
+        }
+
+        const uint8_t* frame = conn->in.data + offset;
+        request_t* request = calloc(1, sizeof(request_t));
+        if (!request) {
+            *bad = true;
+            break;
+        }
+        memcpy(&request->id, frame + sizeof(uint32_t), sizeof(uint32_t));
+        request->op = frame[2 * sizeof(uint32_t)];
+
+        fxdb_payload_t payload = { frame + FXDB_FRAME_HEADER, size - FXDB_FRAME_HEADER, 0, false };
+        request->name = fxdb_payload_string(&payload);
+        if (request->name && request->name[0] == '\0' && request->op != FXDB_OP_PING) {
+            free(request->name);
+            request->name = NULL;
+        }
+        request->frame_size = size;
+        request->body_size = (uint32_t)(payload.length - payload.offset);
+        request->body = malloc(request->body_size ? request->body_size : 1);
+        if (request->body) {
+            memcpy(request->body, payload.data + payload.offset, request->body_size);
+        } else {
+            request->body_size = 0;
+        }
+
+        *tail = request;
+        tail = &request->next;
+        offset += size;
+    }
+    fxdb_buffer_consume(&conn->in, offset);
+    return head;
+}
+
+static void read_connection(fxdb_server_t* server, connection_t* conn) {
+    uint8_t chunk[SERVE_RECV_BYTES];
+    bool closed = false;
+    for (;;) {
+        ssize_t n = recv(conn->fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            if (fxdb_buffer_append(&conn->in, chunk, (size_t)n) != 0) {
+                closed = true;
+                break;
+            }
+            // The rest stays in the socket until the next EPOLLIN
+            if ((size_t)n < sizeof(chunk) || conn->in.length >= SERVE_BACKLOG_BYTES) {
+                break;
+            }
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+            break;
+        }
+    }
+
+    bool bad = false;
+    request_t* requests = split_requests(conn, &bad);
+    if (requests) {
+        size_t bytes = 0;
+        request_t* last = requests;
+        for (request_t* request = requests; request; request = request->next) {
+            bytes += request->frame_size;
+            last = request;
+        }
+
+        // Stop reading a connection whose requests pile up faster than they are served
+        pthread_mutex_lock(&conn->lock);
+        if (conn->tail) {
+            conn->tail->next = requests;
+        } else {
+            conn->head = requests;
+        }
+        conn->tail = last;
+        conn->queued_bytes += bytes;
+        if (!(wanted_events(conn) & EPOLLIN)) {
+            set_events(server, conn, wanted_events(conn));
+        }
+        pthread_mutex_unlock(&conn->lock);
+
+        // A connection is on the work queue at most once
+        schedule_connection(server, conn);
+    }
+
+    if (bad) {
+        fprintf(stderr, "Error: Malformed frame from a client, closing its connection\n");
+    }
+    if (closed || bad) {
+        close_connection(server, conn);
+    }
+}
+
+static void write_connection(fxdb_server_t* server, connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    int status = send_pending(conn);
+    if (status >= 0) {
+        set_events(server, conn, wanted_events(conn));
+    }
+    pthread_mutex_unlock(&conn->lock);
+    if (status < 0) {
+        close_connection(server, conn);
+        return;
+    }
+
+    // Requests held back while the answers were over the cap are served again
+    schedule_connection(server, conn);
+}
+
+// Arm EPOLLOUT for connections whose answers did not fit in the socket
+static void arm_flushes(fxdb_server_t* server) {
+    uint64_t count;
+    ssize_t drained = read(server->wake_fd, &count, sizeof(count));
+    (void)drained;
+
+    pthread_mutex_lock(&server->flush_lock);
+    connection_t* conn = server->flush_list;
+    server->flush_list = NULL;
+    pthread_mutex_unlock(&server->flush_lock);
+
+    while (conn) {
+        connection_t* next = conn->next_flush;
+        pthread_mutex_lock(&conn->lock);
+        conn->flush_pending = false;
+        if (!conn->closed) {
+            set_events(server, conn, wanted_events(conn));
+        }
+        pthread_mutex_unlock(&conn->lock);
+        release_connection(conn);
+        conn = next;
+    }
+}
+
+/* ===== Server ===== */
+
+// Get the default server configuration
+fxdb_server_config_t fxdb_server_default_config(void) {
+    fxdb_server_config_t config;
+    config.socket_path = NULL;
+    config.directory = NULL;
+    config.workers = 0;
+    config.writer_idle_ms = SERVE_DEFAULT_IDLE_MS;
+    return config;
+}
+
+// Listen on a Unix socket, replacing a stale one
+static int listen_socket(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot create socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // A socket file nobody answers on is left over from a server that died
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0) {
+        fprintf(stderr, "Error: A server is already listening on '%s'\n", path);
+        close(probe);
+        close(fd);
+        return -1;
+    }
+    if (probe >= 0) {
+        close(probe);
+    }
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "Error: Cannot listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Bind the socket and start the worker pool
+fxdb_server_t* fxdb_server_create(const fxdb_server_config_t* config) {
+    if (!config || !config->socket_path) {
+        return NULL;
+    }
+
+    fxdb_server_t* server = calloc(1, sizeof(fxdb_server_t));
+    if (!server) {
+        return NULL;
+    }
+    server->listen_fd = server->epoll_fd = server->wake_fd = -1;
+    server->writer_idle_ms = config->writer_idle_ms;
+    server->socket_path = strdup(config->socket_path);
+    server->directory = config->directory ? strdup(config->directory) : NULL;
+    pthread_mutex_init(&server->queue_lock, NULL);
+    pthread_cond_init(&server->queue_ready, NULL);
+    pthread_mutex_init(&server->flush_lock, NULL);
+    pthread_mutex_init(&server->db_lock, NULL);
+
+    server->listen_fd = listen_socket(config->socket_path);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->listen_fd < 0 || server->epoll_fd < 0 || server->wake_fd < 0) {
+        fxdb_server_free(server);
+        return NULL;
+    }
+
+    // The listening socket is tagged NULL, the wake descriptor with the server
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &event);
+    event.data.ptr = server;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->wake_fd, &event);
+
+    uint32_t workers = config->workers;
+    if (workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    server->threads = calloc(workers, sizeof(pthread_t));
+    if (!server->threads) {
+        fxdb_server_free(server);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < workers; i++) {
+        if (pthread_create(&server->threads[i], NULL, worker_main, server) != 0) {
+            fprintf(stderr, "Error: Cannot start server worker thread\n");
+            fxdb_server_free(server);
+            return NULL;
+        }
+        server->thread_count++;
+    }
+    return server;
+}
+
+// Serve clients until stopped
+int fxdb_server_run(fxdb_server_t* server) {
+    if (!server) {
+        return -1;
+    }
+
+    struct epoll_event events[SERVE_MAX_EVENTS];
+    while (!__atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE)) {
+        int count = epoll_wait(server->epoll_fd, events, SERVE_MAX_EVENTS, SERVE_TICK_MS);
+        if (count < 0 && errno != EINTR) {
+            fprintf(stderr, "Error: Server event loop failed: %s\n", strerror(errno));
+            return -1;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+            if (!tag) {
+                accept_connections(server);
+            } else if (tag == server) {
+                arm_flushes(server);
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(server, (connection_t*)tag);
+            } else {
+                // A connection closed while reading is not touched again
+                if (events[i].events & EPOLLOUT) {
+                    write_connection(server, (connection_t*)tag);
+                } else if (events[i].events & EPOLLIN) {
+                    read_connection(server, (connection_t*)tag);
+                }
+            }
+        }
+        close_idle_writers(server);
+    }
+    return 0;
+}
+
+// Ask a running server to stop
+void fxdb_server_stop(fxdb_server_t* server) {
+    if (server) {
+        __atomic_store_n(&server->stopping, 1, __ATOMIC_RELEASE);
+        wake_loop(server);
+    }
+}
+
+// Close connections and databases, remove the socket and free the server
+void fxdb_server_free(fxdb_server_t* server) {
+    if (!server) {
+        return;
+    }
+
+    // Workers finish the queued connections before they exit
+    pthread_mutex_lock(&server->queue_lock);
+    server->shutdown = true;
+    pthread_cond_broadcast(&server->queue_ready);
+    pthread_mutex_unlock(&server->queue_lock);
+    for (uint32_t i = 0; i < server->thread_count; i++) {
+        pthread_join(server->threads[i], NULL);
+    }
+    free(server->threads);
+
+    arm_flushes(server);
+    while (server->connections) {
+        close_connection(server, server->connections);
+    }
+
+    while (server->databases) {
+        served_db_t* next = server->databases->next;
+        close_database(server->databases);
+        server->databases = next;
+    }
+
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->socket_path);
+    }
+    if (server->epoll_fd >= 0) {
+        close(server->epoll_fd);
+    }
+    if (server->wake_fd >= 0) {
+        close(server->wake_fd);
+    }
+    pthread_mutex_destroy(&server->queue_lock);
+    pthread_cond_destroy(&server->queue_ready);
+    pthread_mutex_destroy(&server->flush_lock);
+    pthread_mutex_destroy(&server->db_lock);
+    free(server->socket_path);
+    free(server->directory);
+    free(server);
+}
+
+#else // !__linux__
+
+fxdb_server_config_t fxdb_server_default_config(void) {
+    fxdb_server_config_t config = { NULL, NULL, 0, 0 };
+    return config;
+}
+
+fxdb_server_t* fxdb_server_create(const fxdb_server_config_t* config) {
+    (void)config;
+    fprintf(stderr, "Error: Server mode needs Linux (epoll)\n");
+    return NULL;
+}
+
+int fxdb_server_run(fxdb_server_t* server) {
+    (void)server;
+    return -1;
+}
+
+void fxdb_server_stop(fxdb_server_t* server) {
+    (void)server;
+}
+
+void fxdb_server_free(fxdb_server_t* server) {
+    (void)server;
+}
+
+#endif // __linux__
@@ -37,10 +37,15 @@ shell_command_t get_command_type(const char* cmd_str) {
     if (strcmp(cmd_str, "select") == 0) return CMD_SELECT;
     if (strcmp(cmd_str, "count") == 0) return CMD_COUNT;
     if (strcmp(cmd_str, "insert") == 0) return CMD_INSERT;
+    if (strcmp(cmd_str, "delete") == 0) return CMD_DELETE;
+    if (strcmp(cmd_str, "update") == 0) return CMD_UPDATE;
+    if (strcmp(cmd_str, "compact") == 0) return CMD_COMPACT;
     if (strcmp(cmd_str, "export") == 0) return CMD_EXPORT;
     if (strcmp(cmd_str, "info") == 0) return CMD_INFO;
     if (strcmp(cmd_str, "schema") == 0) return CMD_SCHEMA;
     if (strcmp(cmd_str, "status") == 0) return CMD_STATUS;
+    if (strcmp(cmd_str, "stats") == 0) return CMD_STATS;
+    if (strcmp(cmd_str, "explain") == 0) return CMD_EXPLAIN;
     if (strcmp(cmd_str, "help") == 0 || strcmp(cmd_str, "?") == 0) return CMD_HELP;
     if (strcmp(cmd_str, "clear") == 0 || strcmp(cmd_str, "cls") == 0) return CMD_CLEAR;
     if (strcmp(cmd_str, "history") == 0) return CMD_HISTORY;
@@ -50,39 +55,265 @@ shell_command_t get_command_type(const char* cmd_str) {
     return CMD_UNKNOWN;
 }
 
+/**
+ * Parse the clauses of a select: [*] [where field=value] [order by field [asc|desc]] [limit N]
+ */
+int parse_select_query(const parsed_command_t* cmd, int first, const schema_t* schema, query_t* query) {
+    memset(query, 0, sizeof(*query));
+    
+    int i = first;
+    if (i < cmd->arg_count && strcmp(cmd->args[i], "*") == 0) i++;
+    
+    while (i < cmd->arg_count) {
+        const char* clause = cmd->args[i];
+        if (i + 1 >= cmd->arg_count) {
+            printf("❌ Missing value after '%s'\n", clause);
+            return -1;
+        }
+        const char* arg = cmd->args[i + 1];
+        
+        if (strcmp(clause, "order") == 0) {
+            if (strcmp(arg, "by") != 0 || i + 2 >= cmd->arg_count) {
+                printf("❌ Use format: order by field [asc|desc]\n");
+                return -1;
+            }
+            int index = get_field_index(schema, cmd->args[i + 2]);
+            if (index < 0) {
+                printf("❌ Unknown field: %s\n", cmd->args[i + 2]);
+                return -1;
+            }
+            query->has_order = true;
+            query->order_field = (uint32_t)index;
+            i += 3;
+            
+            // The direction is optional
+            if (i < cmd->arg_count && (strcmp(cmd->args[i], "asc") == 0 || strcmp(cmd->args[i], "desc") == 0)) {
+                query->order_desc = strcmp(cmd->args[i], "desc") == 0;
+                i++;
+            }
+            continue;
+        } else if (strcmp(clause, "where") == 0) {
+            strncpy(query->filter_text, arg, sizeof(query->filter_text) - 1);
+            char* equals = strchr(query->filter_text, '=');
+            if (!equals) {
+                printf("❌ Invalid condition: %s\n", arg);
+                printf("💡 Use format: where field=value\n");
+                return -1;
+            }
+            
+            *equals = '\0';
+            int index = get_field_index(schema, query->filter_text);
+            if (index < 0) {
+                printf("❌ Unknown field: %s\n", query->filter_text);
+                return -1;
+            }
+            if (writer_parse_value(&schema->fields[index], equals + 1, &query->filter_value) != 0) {
+                printf("❌ Invalid value for field '%s': %s\n", query->filter_text, equals + 1);
+                return -1;
+            }
+            query->has_filter = true;
+            query->filter_field = (uint32_t)index;
+        } else if (strcmp(clause, "limit") == 0) {
+            char* end;
+            long limit = strtol(arg, &end, 10);
+            if (*end != '\0' || limit <= 0 || limit > (long)UINT32_MAX) {
+                printf("❌ Invalid limit: %s\n", arg);
+                return -1;
+            }
+            query->limit = (uint32_t)limit;
+        } else {
+            printf("❌ Unexpected '%s'\n", clause);
+            printf("💡 Usage: select * [where field=value] [order by field [asc|desc]] [limit N]\n");
+            return -1;
+        }
+        i += 2;
+    }
+    
+    return 0;
+}
+
+// Name of a database without its ".fxdb" extension
+static void database_stem(const char* name, char* stem, size_t size) {
+    if (stem != name) {
+        snprintf(stem, size, "%s", name);
+    }
+    size_t length = strlen(stem);
+    if (length > 5 && strcmp(stem + length - 5, ".fxdb") == 0) {
+        stem[length - 5] = '\0';
+    }
+}
+
+// Split "db.field" at its last dot; the database may be written with ".fxdb"
+static int split_join_column(const char* text, const join_query_t* query, bool* is_left, char* field, size_t size) {
+    const char* dot = strrchr(text, '.');
+    if (!dot || dot == text || dot[1] == '\0') {
+        printf("❌ Qualify join fields with their database: %s\n", text);
+        return -1;
+    }
+    
+    char table[MAX_DATABASE_NAME_LEN];
+    size_t length = (size_t)(dot - text) < sizeof(table) - 1 ? (size_t)(dot - text) : sizeof(table) - 1;
+    memcpy(table, text, length);
+    table[length] = '\0';
+    database_stem(table, table, sizeof(table));
+    
+    if (strcmp(table, query->left) == 0) {
+        *is_left = true;
+    } else if (strcmp(table, query->right) == 0) {
+        *is_left = false;
+    } else {
+        printf("❌ Unknown database in join condition: %s\n", table);
+        return -1;
+    }
+    snprintf(field, size, "%s", dot + 1);
+    return 0;
+}
+
+/**
+ * Parse a join: from <a> join <b> on <a>.<field> = <b>.<field> [limit N]
+ */
+int parse_join_query(const parsed_command_t* cmd, int first, join_query_t* query) {
+    memset(query, 0, sizeof(*query));
+    
+    int i = first;
+    if (i + 4 >= cmd->arg_count || strcmp(cmd->args[i], "from") != 0 ||
+        strcmp(cmd->args[i + 2], "join") != 0 || strcmp(cmd->args[i + 4], "on") != 0) {
+        printf("❌ Use format: select * from <db> join <db> on <db>.<field> = <db>.<field> [limit N]\n");
+        return -1;
+    }
+    database_stem(cmd->args[i + 1], query->left, sizeof(query->left));
+    database_stem(cmd->args[i + 3], query->right, sizeof(query->right));
+    i += 5;
+    
+    // The condition may be one word or spread over several: a.x=b.y, a.x = b.y
+    char condition[2 * MAX_DATABASE_NAME_LEN + 2 * MAX_FIELD_NAME_LENGTH] = "";
+    while (i < cmd->arg_count && strcmp(cmd->args[i], "limit") != 0) {
+        strncat(condition, cmd->args[i], sizeof(condition) - strlen(condition) - 1);
+        i++;
+    }
+    char* equals = strchr(condition, '=');
+    if (!equals || equals == condition || equals[1] == '\0') {
+        printf("❌ Invalid join condition: %s\n", condition);
+        printf("💡 Use format: on <db>.<field> = <db>.<field>\n");
+        return -1;
+    }
+    *equals = '\0';
+    
+    char first_field[MAX_FIELD_NAME_LENGTH], second_field[MAX_FIELD_NAME_LENGTH];
+    bool first_left, second_left;
+    if (split_join_column(condition, query, &first_left, first_field, sizeof(first_field)) != 0 ||
+        split_join_column(equals + 1, query, &second_left, second_field, sizeof(second_field)) != 0) {
+        return -1;
+    }
+    if (first_left == second_left) {
+        // A database joined with itself names the same one on both sides
+        if (strcmp(query->left, query->right) != 0) {
+            printf("❌ The join condition must compare a field of each database\n");
+            return -1;
+        }
+        first_left = true;
+        second_left = false;
+    }
+    snprintf(query->left_field, sizeof(query->left_field), "%s", first_left ? first_field : second_field);
+    snprintf(query->right_field, sizeof(query->right_field), "%s", first_left ? second_field : first_field);
+    
+    if (i < cmd->arg_count) {
+        char* end = NULL;
+        long limit = i + 2 == cmd->arg_count ? strtol(cmd->args[i + 1], &end, 10) : 0;
+        if (!end || *end != '\0' || limit <= 0 || limit > (long)UINT32_MAX) {
+            printf("❌ Invalid limit after join\n");
+            return -1;
+        }
+        query->limit = (uint32_t)limit;
+    }
+    return 0;
+}
+
+/**
+ * Parse approx_count_distinct(<field>) or approx_percentile(<field>, <p>)
+ */
+int parse_approx_query(const parsed_command_t* cmd, int first, approx_query_t* query) {
+    memset(query, 0, sizeof(*query));
+    
+    // Spaces inside the call split it into several arguments
+    char call[2 * MAX_FIELD_NAME_LENGTH + 64] = "";
+    for (int i = first; i < cmd->arg_count; i++) {
+        strncat(call, cmd->args[i], sizeof(call) - strlen(call) - 1);
+    }
+    
+    char* open = strchr(call, '(');
+    size_t length = strlen(call);
+    if (!open || length < 2 || call[length - 1] != ')') {
+        printf("❌ Use format: select approx_count_distinct(<field>) | approx_percentile(<field>, <p>)\n");
+        return -1;
+    }
+    *open = '\0';
+    call[length - 1] = '\0';
+    char* arguments = open + 1;
+    char* comma = strchr(arguments, ',');
+    
+    if (strcmp(call, "approx_count_distinct") == 0 && !comma) {
+        query->function = APPROX_COUNT_DISTINCT;
+    } else if (strcmp(call, "approx_percentile") == 0 && comma) {
+        *comma = '\0';
+        char* end = NULL;
+        query->function = APPROX_PERCENTILE;
+        query->percentile = strtod(comma + 1, &end);
+        if (end == comma + 1 || *end != '\0' || !(query->percentile >= 0.0 && query->percentile <= 1.0)) {
+            printf("❌ Percentile must be a number from 0 to 1: %s\n", comma + 1);
+            return -1;
+        }
+    } else {
+        printf("❌ Unknown approximate aggregate: %s\n", call);
+        printf("💡 Use approx_count_distinct(<field>) or approx_percentile(<field>, <p>)\n");
+        return -1;
+    }
+    
+    if (arguments[0] == '\0') {
+        printf("❌ Missing field in %s()\n", call);
+        return -1;
+    }
+    snprintf(query->field, sizeof(query->field), "%s", arguments);
+    return 0;
+}
+
 /**
  * Parse command line into structured command
+ * The command, its arguments and the line all live in one arena
  */
 parsed_command_t* parse_command(const char* line) {
     if (!line) return NULL;
     
-    parsed_command_t* cmd = malloc(sizeof(parsed_command_t));
-    if (!cmd) return NULL;
+    // The line twice (raw and tokenized) plus bookkeeping fits the first block
+    size_t length = strlen(line);
+    fxdb_arena_t* arena = fxdb_arena_create(2 * length + sizeof(parsed_command_t) + 256);
+    if (!arena) return NULL;
+    
+    parsed_command_t* cmd = fxdb_arena_calloc(arena, 1, sizeof(parsed_command_t));
+    char* line_copy = fxdb_arena_strndup(arena, line, length);
+    if (!cmd || !line_copy) {
+        fxdb_arena_destroy(arena);
+        return NULL;
+    }
     
     // Initialize command structure
     cmd->type = CMD_UNKNOWN;
     cmd->arg_count = 0;
-    cmd->raw_line = strdup(line);
-    
-    // Initialize args array
-    for (int i = 0; i < 16; i++) {
-        cmd->args[i] = NULL;
-    }
-    
-    // Create a working copy of the line
-    char* line_copy = strdup(line);
-    if (!line_copy) {
-        free_parsed_command(cmd);
-        return NULL;
-    }
+    cmd->arena = arena;
     
     // Trim whitespace
     char* trimmed = trim_whitespace(line_copy);
     
     // Skip empty lines
     if (strlen(trimmed) == 0) {
-        free(line_copy);
-        free_parsed_command(cmd);
+        fxdb_arena_destroy(arena);
+        return NULL;
+    }
+    
+    // Tokens are cut out of the trimmed copy in place
+    cmd->raw_line = fxdb_arena_strndup(arena, line, length);
+    if (!cmd->raw_line) {
+        fxdb_arena_destroy(arena);
         return NULL;
     }
     
@@ -118,7 +349,7 @@ parsed_command_t* parse_command(const char* line) {
             }
         }
         
-        cmd->args[token_count] = strdup(token_start);
+        cmd->args[token_count] = token_start;
         token_count++;
     }
     
@@ -138,7 +369,6 @@ parsed_command_t* parse_command(const char* line) {
         }
     }
     
-    free(line_copy);
     return cmd;
 }
 
@@ -148,14 +378,6 @@ parsed_command_t* parse_command(const char* line) {
 void free_parsed_command(parsed_command_t* cmd) {
     if (!cmd) return;
     
-    // Free arguments
-    for (int i = 0; i < cmd->arg_count && i < 16; i++) {
-        free(cmd->args[i]);
-    }
-    
-    // Free raw line
-    free(cmd->raw_line);
-    
-    // Free command structure
-    free(cmd);
-}
\ No newline at end of file
+    // The command itself lives in the arena
+    fxdb_arena_destroy(cmd->arena);
+}
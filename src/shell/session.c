@@ -3,6 +3,8 @@
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE
 #include "../../include/shell.h"
+#include "../../include/wal.h"
+#include "../../include/deletes.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -106,6 +108,233 @@ char* get_database_path(const char* directory, const char* database_name) {
     return full_path;
 }
 
+/**
+ * Close the cached handles, committing any pending inserts
+ */
+void session_close_handles(shell_session_t* session) {
+    shell_handles_t* handles = &session->handles;
+    
+    if (handles->writer) {
+        if (writer_close(handles->writer) != 0) {
+            fprintf(stderr, "Warning: Failed to finalize '%s'\n", handles->path);
+        }
+        writer_free(handles->writer);
+    }
+    if (handles->reader) {
+        reader_close(handles->reader);
+    }
+    
+    memset(handles, 0, sizeof(*handles));
+}
+
+/**
+ * Record the file's identity so later commands can tell whether it changed
+ */
+static void remember_file_state(shell_handles_t* handles, const struct stat* st) {
+    handles->device = (uint64_t)st->st_dev;
+    handles->inode = (uint64_t)st->st_ino;
+    handles->size = (uint64_t)st->st_size;
+    handles->mtime = st->st_mtime;
+}
+
+/**
+ * Size and modification time of a sidecar file (0 if there is none)
+ * Takes ownership of path and frees it
+ */
+static void get_sidecar_state(char* path, uint64_t* size, time_t* mtime) {
+    struct stat st;
+    if (path && stat(path, &st) == 0) {
+        *size = (uint64_t)st.st_size;
+        *mtime = st.st_mtime;
+    } else {
+        *size = 0;
+        *mtime = 0;
+    }
+    free(path);
+}
+
+/**
+ * Drop handles that no longer match the active database file
+ * Returns 0 if the database file exists, -1 otherwise
+ */
+static int validate_handles(shell_session_t* session) {
+    shell_handles_t* handles = &session->handles;
+    
+    if (strlen(session->current_db) == 0) {
+        session_close_handles(session);
+        return -1;
+    }
+    
+    char* full_path = get_database_path(session->working_dir, session->current_db);
+    if (!full_path) {
+        return -1;
+    }
+    
+    struct stat st;
+    if (stat(full_path, &st) != 0) {
+        session_close_handles(session);
+        free(full_path);
+        return -1;
+    }
+    
+    uint64_t wal_size;
+    time_t wal_mtime;
+    uint64_t deletes_size;
+    time_t deletes_mtime;
+    get_sidecar_state(wal_path(full_path), &wal_size, &wal_mtime);
+    get_sidecar_state(deletes_path(full_path), &deletes_size, &deletes_mtime);
+    
+    bool same_path = strcmp(handles->path, full_path) == 0;
+    if (!same_path || handles->device != (uint64_t)st.st_dev || handles->inode != (uint64_t)st.st_ino) {
+        // Different database, or the file was replaced
+        session_close_handles(session);
+        strncpy(handles->path, full_path, sizeof(handles->path) - 1);
+        handles->path[sizeof(handles->path) - 1] = '\0';
+        remember_file_state(handles, &st);
+        handles->wal_size = wal_size;
+        handles->wal_mtime = wal_mtime;
+        handles->deletes_size = deletes_size;
+        handles->deletes_mtime = deletes_mtime;
+    } else if (handles->size != (uint64_t)st.st_size || handles->mtime != st.st_mtime ||
+               handles->wal_size != wal_size || handles->wal_mtime != wal_mtime) {
+        // Written by someone else: our writer's header is out of date
+        if (handles->writer) {
+            writer_free(handles->writer);
+            handles->writer = NULL;
+        }
+        handles->reader_stale = true;
+        remember_file_state(handles, &st);
+        handles->wal_size = wal_size;
+        handles->wal_mtime = wal_mtime;
+    }
+    
+    // Deletes leave the writer valid; only the reader must reload them
+    if (handles->deletes_size != deletes_size || handles->deletes_mtime != deletes_mtime) {
+        handles->reader_stale = true;
+        handles->deletes_size = deletes_size;
+        handles->deletes_mtime = deletes_mtime;
+    }
+    
+    free(full_path);
+    return 0;
+}
+
+/**
+ * Remember the file state our own writes left, so they are not taken for someone else's
+ */
+static void remember_own_write(shell_handles_t* handles) {
+    struct stat st;
+    if (stat(handles->path, &st) == 0) {
+        remember_file_state(handles, &st);
+    }
+    get_sidecar_state(wal_path(handles->path), &handles->wal_size, &handles->wal_mtime);
+}
+
+/**
+ * Reader for the active database, positioned at the first row
+ */
+reader_t* session_get_reader(shell_session_t* session) {
+    if (validate_handles(session) != 0) {
+        return NULL;
+    }
+    
+    shell_handles_t* handles = &session->handles;
+    if (handles->reader && handles->reader_stale && reader_refresh(handles->reader) != 0) {
+        reader_close(handles->reader);
+        handles->reader = NULL;
+    }
+    handles->reader_stale = false;
+    
+    if (!handles->reader) {
+        // Queries decode rows straight out of a mapping of the file
+        handles->reader = reader_open(handles->path);
+        if (handles->reader) {
+            reader_set_mmap(handles->reader, true, NULL);
+        }
+    } else {
+        reader_rewind(handles->reader);
+    }
+    
+    return handles->reader;
+}
+
+/**
+ * Writer for the active database, kept open across a run of inserts
+ */
+writer_t* session_get_writer(shell_session_t* session) {
+    if (validate_handles(session) != 0) {
+        return NULL;
+    }
+    
+    shell_handles_t* handles = &session->handles;
+    if (!handles->writer) {
+        // Single-row inserts go to the write-ahead log, not into one chunk each
+        writer_config_t config = writer_default_config();
+        config.use_wal = true;
+        handles->writer = writer_open_with_config(handles->path, &config);
+        
+        // Opening truncates the file to its data and opens the log; without this the
+        // next lookup would take that for an outside write and free the writer
+        if (handles->writer) {
+            remember_own_write(handles);
+            handles->reader_stale = true;
+        }
+    }
+    
+    return handles->writer;
+}
+
+/**
+ * Commit the session writer so the inserted rows are on disk
+ */
+int session_commit(shell_session_t* session) {
+    shell_handles_t* handles = &session->handles;
+    if (!handles->writer) {
+        return -1;
+    }
+    
+    if (writer_commit(handles->writer) != 0) {
+        // Leave nothing half-written behind for the next command
+        session_release_writer(session);
+        return -1;
+    }
+    
+    // Our own write: the reader must re-read the header
+    remember_own_write(handles);
+    handles->reader_stale = true;
+    return 0;
+}
+
+/**
+ * Commit and close the session writer, so other processes can write
+ */
+int session_close_writer(shell_session_t* session) {
+    shell_handles_t* handles = &session->handles;
+    if (!handles->writer) {
+        return 0;
+    }
+    
+    int result = writer_close(handles->writer);
+    writer_free(handles->writer);
+    handles->writer = NULL;
+    
+    remember_own_write(handles);
+    handles->reader_stale = true;
+    return result;
+}
+
+/**
+ * Drop a writer a failed command left open, discarding its uncommitted rows
+ */
+void session_release_writer(shell_session_t* session) {
+    shell_handles_t* handles = &session->handles;
+    if (handles->writer) {
+        writer_free(handles->writer);
+        handles->writer = NULL;
+        handles->reader_stale = true;
+    }
+}
+
 /**
  * Start timing measurement
  */
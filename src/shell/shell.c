@@ -5,6 +5,13 @@
 #include "../../include/shell.h"
 #include "../../include/welcome.h"
 #include "../../include/writer.h"
+#include "../../include/wal.h"
+#include "../../include/deletes.h"
+#include "../../include/coord.h"
+#include "../../include/compact.h"
+#include "../../include/stats.h"
+#include "../../include/join.h"
+#include "../../include/summary.h"
 #include "platform/terminal.h"
 #include <unistd.h>
 #include <errno.h>
@@ -54,6 +61,14 @@ static void setup_signal_handlers(void) {
 }
 #endif
 
+/**
+ * Give up the writer lock a run of inserts kept once the user goes idle
+ */
+static void close_idle_writer(void *arg)
+{
+    session_close_writer((shell_session_t *)arg);
+}
+
 /**
  * Custom readline prompt generator
  */
@@ -112,6 +127,7 @@ shell_session_t *init_session(const char *directory)
     session->current_db[0] = '\0';
     session->session_start = time(NULL);
     session->commands_executed = 0;
+    memset(&session->handles, 0, sizeof(session->handles));
 
     return session;
 }
@@ -198,6 +214,7 @@ void free_session(shell_session_t *session)
 {
     if (session)
     {
+        session_close_handles(session);
         free(session);
     }
 }
@@ -205,6 +222,7 @@ void free_session(shell_session_t *session)
 // Forward declaration for shell commands
 static int cmd_shell_help(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_status(shell_session_t *session, const parsed_command_t *cmd);
+static int cmd_shell_stats(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_show_databases(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_use(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_info(shell_session_t *session, const parsed_command_t *cmd);
@@ -213,7 +231,11 @@ static int cmd_shell_clear(shell_session_t *session, const parsed_command_t *cmd
 static int cmd_shell_create(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_count(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_select(shell_session_t *session, const parsed_command_t *cmd);
+static int cmd_shell_explain(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_insert(shell_session_t *session, const parsed_command_t *cmd);
+static int cmd_shell_delete(shell_session_t *session, const parsed_command_t *cmd);
+static int cmd_shell_update(shell_session_t *session, const parsed_command_t *cmd);
+static int cmd_shell_compact(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_drop(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cmd);
 static int cmd_shell_history(shell_session_t *session, const parsed_command_t *cmd);
@@ -231,6 +253,12 @@ int execute_shell_command(shell_session_t *session, const parsed_command_t *cmd)
 
     int result = 0;
 
+    // Only a run of inserts keeps the writer; anything else lets other writers in first
+    if (cmd->type != CMD_INSERT)
+    {
+        session_close_writer(session);
+    }
+
     switch (cmd->type)
     {
     case CMD_HELP:
@@ -241,6 +269,10 @@ int execute_shell_command(shell_session_t *session, const parsed_command_t *cmd)
         result = cmd_shell_status(session, cmd);
         break;
 
+    case CMD_STATS:
+        result = cmd_shell_stats(session, cmd);
+        break;
+
     case CMD_SHOW_DATABASES:
         result = cmd_shell_show_databases(session, cmd);
         break;
@@ -273,10 +305,26 @@ int execute_shell_command(shell_session_t *session, const parsed_command_t *cmd)
         result = cmd_shell_select(session, cmd);
         break;
 
+    case CMD_EXPLAIN:
+        result = cmd_shell_explain(session, cmd);
+        break;
+
     case CMD_INSERT:
         result = cmd_shell_insert(session, cmd);
         break;
 
+    case CMD_DELETE:
+        result = cmd_shell_delete(session, cmd);
+        break;
+
+    case CMD_UPDATE:
+        result = cmd_shell_update(session, cmd);
+        break;
+
+    case CMD_COMPACT:
+        result = cmd_shell_compact(session, cmd);
+        break;
+
     case CMD_DROP:
         result = cmd_shell_drop(session, cmd);
         break;
@@ -301,6 +349,16 @@ int execute_shell_command(shell_session_t *session, const parsed_command_t *cmd)
         break;
     }
 
+    // A failed command discards what it left uncommitted; update closes the writer it opened
+    if (result != 0)
+    {
+        session_release_writer(session);
+    }
+    else if (cmd->type != CMD_INSERT)
+    {
+        session_close_writer(session);
+    }
+
     if (result == 0)
     {
         session->commands_executed++;
@@ -333,22 +391,31 @@ static int cmd_shell_help(shell_session_t *session, const parsed_command_t *cmd)
         {"show databases", "List all available databases"},
         {"create <db> schema=\"...\"", "Create a new database"},
         {"drop <database>", "Delete a database"},
-        {"select * [limit N]", "Read rows from current database"},
-        {"count", "Show row count for current database"},
+        {"select * [where f=v] [limit N]", "Read rows from current database"},
+        {"select * order by f [desc] ...", "Read rows ordered by a field"},
+        {"select * from a join b on ...", "Hash join two databases on a.f = b.g"},
+        {"select approx_count_distinct(f)", "Estimate distinct values from chunk sketches"},
+        {"select approx_percentile(f, p)", "Estimate a percentile (p from 0 to 1)"},
+        {"explain [analyze] select ...", "Show a select's plan, or run and profile it"},
+        {"count [field]", "Show row count (and NULLs, sum, min, max of field)"},
         {"insert field=value ...", "Insert a row interactively"},
+        {"delete where field=value", "Delete matching rows"},
+        {"update f=v ... where f=v", "Replace matching rows"},
+        {"compact [by field]", "Merge small chunks, drop deleted rows"},
         {"export [csv|json]", "Export data in specified format"},
         {"info", "Show current database information"},
         {"schema", "Show current database schema"},
         {"status", "Show session information"},
+        {"stats [reset]", "Show I/O, decode and cache counters"},
         {"clear", "Clear the screen"},
         {"history", "Show command history"},
         {"help", "Show this help message"},
         {"exit, quit", "Exit the shell"}};
 
-    int column_widths[] = {25, 50};
+    int column_widths[] = {31, 50};
     print_table_header(headers, 2, column_widths);
 
-    for (int i = 0; i < 15; i++)
+    for (size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++)
     {
         print_table_row(data[i], 2, column_widths);
     }
@@ -412,6 +479,76 @@ static int cmd_shell_status(shell_session_t *session, const parsed_command_t *cm
     return 0;
 }
 
+/**
+ * Stats command implementation - Counters of every command run so far
+ */
+static int cmd_shell_stats(shell_session_t *session, const parsed_command_t *cmd)
+{
+    (void)session; // Unused parameter
+
+    if (cmd->arg_count == 2 && strcmp(cmd->args[1], "reset") == 0)
+    {
+        fxdb_reset_statistics();
+        printf("✅ Statistics reset\n");
+        return 0;
+    }
+    if (cmd->arg_count != 1)
+    {
+        printf("❌ Usage: stats [reset]\n");
+        return -1;
+    }
+
+    db_statistics_t stats;
+    fxdb_get_statistics(&stats);
+
+    printf("📈 Operation Statistics\n");
+    printf("═══════════════════════\n\n");
+
+    char values[17][48];
+    snprintf(values[0], sizeof(values[0]), "%llu", (unsigned long long)stats.bytes_read);
+    snprintf(values[1], sizeof(values[1]), "%llu", (unsigned long long)stats.read_calls);
+    snprintf(values[2], sizeof(values[2]), "%.2f ms", stats.read_io_time);
+    snprintf(values[3], sizeof(values[3]), "%llu", (unsigned long long)stats.bytes_written);
+    snprintf(values[4], sizeof(values[4]), "%llu", (unsigned long long)stats.write_ops);
+    snprintf(values[5], sizeof(values[5]), "%llu", (unsigned long long)stats.sync_calls);
+    snprintf(values[6], sizeof(values[6]), "%.2f ms", stats.write_io_time);
+    snprintf(values[7], sizeof(values[7]), "%llu", (unsigned long long)stats.chunks_loaded);
+    snprintf(values[8], sizeof(values[8]), "%llu", (unsigned long long)stats.chunks_written);
+    snprintf(values[9], sizeof(values[9]), "%llu", (unsigned long long)stats.rows_decoded);
+    snprintf(values[10], sizeof(values[10]), "%.2f ms", stats.decode_time);
+    snprintf(values[11], sizeof(values[11]), "%llu", (unsigned long long)stats.allocations);
+    snprintf(values[12], sizeof(values[12]), "%llu", (unsigned long long)stats.rows_encoded);
+    snprintf(values[13], sizeof(values[13]), "%llu", (unsigned long long)stats.cache_hits);
+    snprintf(values[14], sizeof(values[14]), "%llu", (unsigned long long)stats.cache_misses);
+    snprintf(values[15], sizeof(values[15]), "%llu bytes", (unsigned long long)stats.memory_usage);
+    snprintf(values[16], sizeof(values[16]), "%llu bytes", (unsigned long long)stats.peak_memory_usage);
+
+    const char *labels[17] = {
+        "Bytes Read", "Read Calls", "Read Time",
+        "Bytes Written", "Write Operations", "Sync Calls", "Write Time",
+        "Chunks Loaded", "Chunks Written",
+        "Rows Decoded", "Decode Time", "Decode Allocations", "Rows Encoded",
+        "Cache Hits", "Cache Misses", "Cache Memory", "Peak Cache Memory"};
+
+    const char *headers[] = {"Counter", "Value"};
+    int column_widths[] = {20, 40};
+    print_table_header(headers, 2, column_widths);
+    for (int i = 0; i < 17; i++)
+    {
+        const char *row[] = {labels[i], values[i]};
+        print_table_row(row, 2, column_widths);
+    }
+    print_table_footer(2, column_widths);
+
+    printf("\n⏱️  Operation Latency\n");
+    fxdb_print_latency();
+
+    printf("\n💡 Decode time is sampled on one row in %d; 'stats reset' starts the counters over\n",
+           FXDB_STATS_DECODE_SAMPLE);
+    printf("💡 Set %s=<file> to write every operation as a Chrome trace\n", FXDB_TRACE_ENV);
+    return 0;
+}
+
 /**
  * Show databases command implementation
  */
@@ -504,6 +641,43 @@ static int cmd_shell_use(shell_session_t *session, const parsed_command_t *cmd)
     return 0;
 }
 
+/**
+ * Free sketches made by sketch_columns
+ */
+static void free_sketches(fxdb_column_sketch_t *sketches, uint32_t count)
+{
+    for (uint32_t f = 0; sketches && f < count; f++)
+    {
+        summary_sketch_free(&sketches[f]);
+    }
+    free(sketches);
+}
+
+/**
+ * Sketch fields of a database, from chunk summaries where it can
+ * Returns one sketch per field of the schema, NULL on failure
+ */
+static fxdb_column_sketch_t *sketch_columns(reader_t *reader, uint64_t fields, fxdb_summary_stats_t *stats)
+{
+    uint32_t count = reader->schema->field_count;
+    fxdb_column_sketch_t *sketches = malloc((count ? count : 1) * sizeof(fxdb_column_sketch_t));
+    if (!sketches)
+    {
+        return NULL;
+    }
+    for (uint32_t f = 0; f < count; f++)
+    {
+        summary_sketch_init(&sketches[f]);
+    }
+
+    if (summary_sketch_columns(reader, fields, sketches, stats) != 0)
+    {
+        free_sketches(sketches, count);
+        return NULL;
+    }
+    return sketches;
+}
+
 /**
  * Info command implementation
  */
@@ -524,7 +698,7 @@ static int cmd_shell_info(shell_session_t *session, const parsed_command_t *cmd)
         return -1;
     }
 
-    reader_t *reader = reader_open(full_path);
+    reader_t *reader = session_get_reader(session);
     if (!reader)
     {
         printf("❌ Failed to open database: %s\n", session->current_db);
@@ -603,7 +777,33 @@ static int cmd_shell_info(shell_session_t *session, const parsed_command_t *cmd)
 
     print_table_footer(2, column_widths);
 
-    reader_close(reader);
+    // Per-column cardinality, estimated from the chunk summaries
+    fxdb_summary_stats_t stats;
+    uint32_t field_count = reader->schema->field_count;
+    uint64_t all_fields = field_count >= 64 ? ~0ULL : (1ULL << field_count) - 1;
+    fxdb_column_sketch_t *sketches = sketch_columns(reader, all_fields, &stats);
+    if (sketches)
+    {
+        printf("\n");
+        const char *column_headers[] = {"Column", "Type", "Values", "~Distinct"};
+        int widths[] = {20, 10, 12, 12};
+        print_table_header(column_headers, 4, widths);
+        for (uint32_t f = 0; f < field_count; f++)
+        {
+            char values_str[32], distinct_str[32];
+            snprintf(values_str, sizeof(values_str), "%llu", (unsigned long long)sketches[f].value_count);
+            snprintf(distinct_str, sizeof(distinct_str), "%.0f",
+                     sketches[f].value_count > 0 ? fxdb_hll_estimate(&sketches[f].distinct) : 0.0);
+            const char *row[] = {reader->schema->fields[f].name, field_type_to_string(reader->schema->fields[f].type),
+                                 values_str, distinct_str};
+            print_table_row(row, 4, widths);
+        }
+        print_table_footer(4, widths);
+        printf("\n🧮 Sketches: %u chunk%s from summaries, %u scanned\n", stats.chunks_summarized,
+               stats.chunks_summarized == 1 ? "" : "s", stats.chunks_scanned);
+        free_sketches(sketches, field_count);
+    }
+
     free(full_path);
     return 0;
 }
@@ -621,18 +821,10 @@ static int cmd_shell_schema(shell_session_t *session, const parsed_command_t *cm
         return -1;
     }
 
-    char *full_path = get_database_path(session->working_dir, session->current_db);
-    if (!full_path)
-    {
-        printf("❌ Failed to get database path\n");
-        return -1;
-    }
-
-    reader_t *reader = reader_open(full_path);
+    reader_t *reader = session_get_reader(session);
     if (!reader)
     {
         printf("❌ Failed to open database: %s\n", session->current_db);
-        free(full_path);
         return -1;
     }
 
@@ -641,8 +833,6 @@ static int cmd_shell_schema(shell_session_t *session, const parsed_command_t *cm
 
     print_schema(reader->schema);
 
-    reader_close(reader);
-    free(full_path);
     return 0;
 }
 
@@ -812,26 +1002,16 @@ static int cmd_shell_create(shell_session_t *session, const parsed_command_t *cm
  */
 static int cmd_shell_count(shell_session_t *session, const parsed_command_t *cmd)
 {
-    (void)cmd; // Unused parameter
-
     if (strlen(session->current_db) == 0)
     {
         printf("❌ No database selected. Use 'use <database>' first.\n");
         return -1;
     }
 
-    char *full_path = get_database_path(session->working_dir, session->current_db);
-    if (!full_path)
-    {
-        printf("❌ Failed to get database path\n");
-        return -1;
-    }
-
-    reader_t *reader = reader_open(full_path);
+    reader_t *reader = session_get_reader(session);
     if (!reader)
     {
         printf("❌ Failed to open database: %s\n", session->current_db);
-        free(full_path);
         return -1;
     }
 
@@ -855,86 +1035,472 @@ static int cmd_shell_count(shell_session_t *session, const parsed_command_t *cmd
     const char *row2[] = {"Database", session->current_db};
     print_table_row(row2, 2, column_widths);
 
+    // count <field>: values vs NULLs, and sum/min/max of numbers, mostly from chunk summaries
+    column_aggregate_t agg;
+    double elapsed_ms = 0.0;
+    if (cmd->arg_count >= 2)
+    {
+        int field_index = get_field_index(reader->schema, cmd->args[1]);
+        uint64_t ticks = fxdb_ticks();
+        if (field_index < 0 || reader_aggregate_column(reader, (uint32_t)field_index, &agg) != 0)
+        {
+            print_table_footer(2, column_widths);
+            printf("❌ Unknown field: %s\n", cmd->args[1]);
+            return -1;
+        }
+        elapsed_ms = fxdb_ticks_to_ns(fxdb_ticks() - ticks) / 1e6;
+
+        char values_str[32], nulls_str[32];
+        snprintf(values_str, sizeof(values_str), "%llu", (unsigned long long)agg.value_count);
+        snprintf(nulls_str, sizeof(nulls_str), "%llu", (unsigned long long)(agg.row_count - agg.value_count));
+        const char *row3[] = {"Values", values_str};
+        const char *row4[] = {"NULLs", nulls_str};
+        print_table_row(row3, 2, column_widths);
+        print_table_row(row4, 2, column_widths);
+
+        field_type_t type = reader->schema->fields[field_index].type;
+        if ((type == FIELD_TYPE_INT32 || type == FIELD_TYPE_FLOAT) && agg.value_count > 0)
+        {
+            const char *format = type == FIELD_TYPE_INT32 ? "%.0f" : "%g";
+            char sum_str[32], min_str[32], max_str[32];
+            snprintf(sum_str, sizeof(sum_str), format, agg.sum);
+            snprintf(min_str, sizeof(min_str), format, agg.min);
+            snprintf(max_str, sizeof(max_str), format, agg.max);
+            const char *row5[] = {"Sum", sum_str};
+            const char *row6[] = {"Min", min_str};
+            const char *row7[] = {"Max", max_str};
+            print_table_row(row5, 2, column_widths);
+            print_table_row(row6, 2, column_widths);
+            print_table_row(row7, 2, column_widths);
+        }
+    }
+
     print_table_footer(2, column_widths);
 
+    if (cmd->arg_count >= 2)
+    {
+        printf("\n🧮 Aggregates: %u chunk%s from summaries, %u scanned (%.3f ms)\n", agg.chunks_summarized,
+               agg.chunks_summarized == 1 ? "" : "s", agg.chunks_scanned, elapsed_ms);
+    }
+
     if (total_rows == 0)
     {
         printf("\n💡 Database is empty. Use 'insert' command to add data.\n");
     }
 
-    reader_close(reader);
-    free(full_path);
     return 0;
 }
 
 /**
- * Select command implementation - Read rows from current database
+ * Open a database named in a join, with or without its ".fxdb" extension
  */
-static int cmd_shell_select(shell_session_t *session, const parsed_command_t *cmd)
+static reader_t *open_join_database(shell_session_t *session, const char *name)
 {
+    char file_name[MAX_DATABASE_NAME_LEN + 8];
+    snprintf(file_name, sizeof(file_name), "%s", name);
+    if (!database_exists(session->working_dir, file_name))
+    {
+        snprintf(file_name, sizeof(file_name), "%s.fxdb", name);
+    }
+    if (!database_exists(session->working_dir, file_name))
+    {
+        printf("❌ Database '%s' not found.\n", name);
+        return NULL;
+    }
+
+    char *path = get_database_path(session->working_dir, file_name);
+    reader_t *reader = path ? reader_open(path) : NULL;
+    if (!reader)
+    {
+        printf("❌ Failed to open database: %s\n", name);
+    }
+    free(path);
+    return reader;
+}
+
+/**
+ * Run a join between two open databases and print its rows
+ */
+static int run_join(const join_query_t *query, reader_t *left, reader_t *right)
+{
+    int left_field = get_field_index(left->schema, query->left_field);
+    int right_field = get_field_index(right->schema, query->right_field);
+    if (left_field < 0 || right_field < 0)
+    {
+        printf("❌ Unknown field: %s\n", left_field < 0 ? query->left_field : query->right_field);
+        return -1;
+    }
+
+    printf("📖 Joining %s with %s on %s = %s\n\n", query->left, query->right, query->left_field, query->right_field);
+
+    fxdb_join_options_t options = fxdb_join_default_options();
+    options.limit = query->limit;
+    fxdb_join_stats_t stats;
+    query_result_t *rows = fxdb_hash_join(left, query->left, (uint32_t)left_field,
+                                          right, query->right, (uint32_t)right_field, &options, &stats);
+    if (!rows)
+    {
+        printf("❌ Failed to join databases\n");
+        return -1;
+    }
+
+    if (rows->row_count == 0)
+    {
+        printf("📄 No matching rows.\n");
+    }
+    else
+    {
+        reader_print_rows(NULL, rows);
+    }
+
+    char spilled[32];
+    format_file_size(stats.bytes_spilled, spilled, sizeof(spilled));
+    printf("\n🔗 Hash join: built on %s (%llu rows), probed %llu rows on %u thread%s",
+           stats.build_left ? query->left : query->right, (unsigned long long)stats.build_rows,
+           (unsigned long long)stats.probe_rows, stats.threads, stats.threads == 1 ? "" : "s");
+    if (stats.partitions > 1)
+    {
+        printf(", %u partitions, %s spilled", stats.partitions, spilled);
+    }
+    printf(" (%.3f ms)\n", stats.build_ms + stats.probe_ms);
+
+    reader_free_result(rows);
+    return 0;
+}
+
+/**
+ * Join command implementation - Hash join two databases on a field each
+ */
+static int cmd_shell_join(shell_session_t *session, const parsed_command_t *cmd, int from)
+{
+    join_query_t query;
+    if (parse_join_query(cmd, from, &query) != 0)
+    {
+        return -1;
+    }
+
+    reader_t *left = open_join_database(session, query.left);
+    reader_t *right = left ? open_join_database(session, query.right) : NULL;
+    int result = right ? run_join(&query, left, right) : -1;
+    reader_close(left);
+    reader_close(right);
+    return result;
+}
+
+/**
+ * Approximate aggregate command implementation - Merge chunk summaries
+ */
+static int cmd_shell_approx(shell_session_t *session, const parsed_command_t *cmd)
+{
+    approx_query_t query;
+    if (parse_approx_query(cmd, 1, &query) != 0)
+    {
+        return -1;
+    }
+
     if (strlen(session->current_db) == 0)
     {
         printf("❌ No database selected. Use 'use <database>' first.\n");
         return -1;
     }
 
-    // Parse limit if provided
-    uint32_t limit = 0;
-    if (cmd->arg_count >= 2 && strcmp(cmd->args[1], "*") == 0)
+    reader_t *reader = session_get_reader(session);
+    if (!reader)
+    {
+        printf("❌ Failed to open database: %s\n", session->current_db);
+        return -1;
+    }
+
+    int field_index = get_field_index(reader->schema, query.field);
+    if (field_index < 0)
+    {
+        printf("❌ Unknown field: %s\n", query.field);
+        return -1;
+    }
+    field_type_t type = reader->schema->fields[field_index].type;
+    if (query.function == APPROX_PERCENTILE && type != FIELD_TYPE_INT32 && type != FIELD_TYPE_FLOAT)
+    {
+        printf("❌ approx_percentile needs a numeric field: %s\n", query.field);
+        return -1;
+    }
+
+    printf("📖 Reading from database: %s\n\n", session->current_db);
+
+    uint64_t ticks = fxdb_ticks();
+    fxdb_summary_stats_t stats;
+    fxdb_column_sketch_t *sketches = sketch_columns(reader, 1ULL << field_index, &stats);
+    if (!sketches)
+    {
+        printf("❌ Failed to read data\n");
+        return -1;
+    }
+    double elapsed_ms = fxdb_ticks_to_ns(fxdb_ticks() - ticks) / 1e6;
+
+    const fxdb_column_sketch_t *sketch = &sketches[field_index];
+    // Function name and punctuation, the field and up to 13 characters of %g
+    char heading[MAX_FIELD_NAME_LENGTH + 48];
+    char value_str[64];
+    if (query.function == APPROX_COUNT_DISTINCT)
+    {
+        snprintf(heading, sizeof(heading), "approx_count_distinct(%s)", query.field);
+        double estimate = sketch->value_count > 0 ? fxdb_hll_estimate(&sketch->distinct) : 0.0;
+        snprintf(value_str, sizeof(value_str), "%.0f", estimate);
+    }
+    else
+    {
+        snprintf(heading, sizeof(heading), "approx_percentile(%s, %g)", query.field, query.percentile);
+        double value;
+        if (fxdb_kll_quantile(&sketch->quantiles, query.percentile, &value) != 0)
+        {
+            snprintf(value_str, sizeof(value_str), "NULL");
+        }
+        else
+        {
+            snprintf(value_str, sizeof(value_str), type == FIELD_TYPE_INT32 ? "%.0f" : "%g", value);
+        }
+    }
+    free_sketches(sketches, reader->schema->field_count);
+
+    const char *headers[] = {heading};
+    const char *row[] = {value_str};
+    int column_widths[] = {(int)strlen(heading) + 2 > 20 ? (int)strlen(heading) + 2 : 20};
+    print_table_header(headers, 1, column_widths);
+    print_table_row(row, 1, column_widths);
+    print_table_footer(1, column_widths);
+
+    printf("\n🧮 Sketches: %u chunk%s from summaries, %u scanned (%.3f ms)\n", stats.chunks_summarized,
+           stats.chunks_summarized == 1 ? "" : "s", stats.chunks_scanned, elapsed_ms);
+    return 0;
+}
+
+/**
+ * Select command implementation - Read rows from current database
+ */
+static int cmd_shell_select(shell_session_t *session, const parsed_command_t *cmd)
+{
+    // select [*] from a join b ... reads other databases than the current one
+    for (int i = 1; i < cmd->arg_count && i <= 2; i++)
     {
-        if (cmd->arg_count >= 4 && strcmp(cmd->args[2], "limit") == 0)
+        if (strcmp(cmd->args[i], "from") == 0)
         {
-            limit = atoi(cmd->args[3]);
+            return cmd_shell_join(session, cmd, i);
         }
     }
-    else if (cmd->arg_count >= 3 && strcmp(cmd->args[2], "limit") == 0 && cmd->arg_count >= 4)
+    if (cmd->arg_count >= 2 && strncmp(cmd->args[1], "approx_", 7) == 0)
     {
-        limit = atoi(cmd->args[3]);
+        return cmd_shell_approx(session, cmd);
     }
 
-    char *full_path = get_database_path(session->working_dir, session->current_db);
-    if (!full_path)
+    if (strlen(session->current_db) == 0)
     {
-        printf("❌ Failed to build database path\n");
+        printf("❌ No database selected. Use 'use <database>' first.\n");
         return -1;
     }
 
-    reader_t *reader = reader_open(full_path);
+    reader_t *reader = session_get_reader(session);
     if (!reader)
     {
         printf("❌ Failed to open database: %s\n", session->current_db);
-        free(full_path);
+        return -1;
+    }
+
+    query_t query;
+    if (parse_select_query(cmd, 1, reader->schema, &query) != 0)
+    {
         return -1;
     }
 
     printf("📖 Reading from database: %s\n\n", session->current_db);
 
-    uint32_t total_rows = reader_get_row_count(reader);
-    if (limit == 0 || limit > total_rows)
+    if (reader_get_row_count(reader) == 0)
     {
-        limit = total_rows;
+        printf("📄 Database is empty.\n");
+        return 0;
     }
 
-    if (total_rows == 0)
+    query_result_t *result;
+    if (query_execute(reader, &query, &result, NULL) < 0)
     {
-        printf("📄 Database is empty.\n");
+        printf("❌ Failed to read data\n");
+        return -1;
+    }
+
+    if (result->row_count == 0)
+    {
+        printf("📄 No matching rows.\n");
     }
     else
     {
-        query_result_t *result = reader_read_rows(reader, limit);
-        if (result)
+        reader_print_rows(reader, result);
+    }
+    reader_free_result(result);
+    return 0;
+}
+
+/**
+ * Print a plan's operators, outermost first, with actual rows and time when profiled
+ */
+static void print_plan(const query_plan_t *plan, bool analyzed)
+{
+    const char *headers[] = {"Operator", "Detail", "Est. Rows", "Rows", "Time ms"};
+    int column_widths[] = {12, 36, 12, 12, 10};
+    int columns = analyzed ? 5 : 3;
+
+    print_table_header(headers, columns, column_widths);
+    for (uint32_t i = 0; i < plan->operator_count; i++)
+    {
+        const query_operator_t *op = &plan->operators[i];
+        char name[32], estimated[32], rows[32], time_ms[32];
+        snprintf(name, sizeof(name), "%*s%s", (int)i * 2, "", query_op_name(op->type));
+        snprintf(estimated, sizeof(estimated), "%llu", (unsigned long long)op->estimated_rows);
+        snprintf(rows, sizeof(rows), "%llu", (unsigned long long)op->rows);
+        snprintf(time_ms, sizeof(time_ms), "%.3f", op->time_ms);
+
+        const char *row[] = {name, op->detail, estimated, rows, time_ms};
+        print_table_row(row, columns, column_widths);
+    }
+    print_table_footer(columns, column_widths);
+}
+
+/**
+ * Explain command implementation - Show how a select runs, or run it and profile it
+ */
+static int cmd_shell_explain(shell_session_t *session, const parsed_command_t *cmd)
+{
+    bool analyze = cmd->arg_count > 1 && strcmp(cmd->args[1], "analyze") == 0;
+    int select_index = analyze ? 2 : 1;
+    if (cmd->arg_count <= select_index || strcmp(cmd->args[select_index], "select") != 0)
+    {
+        printf("❌ Usage: explain [analyze] select * [where field=value] [order by field [asc|desc]] [limit N]\n");
+        printf("💡 Example: explain analyze select * where id=42\n");
+        return -1;
+    }
+
+    if (strlen(session->current_db) == 0)
+    {
+        printf("❌ No database selected. Use 'use <database>' first.\n");
+        return -1;
+    }
+
+    reader_t *reader = session_get_reader(session);
+    if (!reader)
+    {
+        printf("❌ Failed to open database: %s\n", session->current_db);
+        return -1;
+    }
+
+    query_t query;
+    if (parse_select_query(cmd, select_index + 1, reader->schema, &query) != 0)
+    {
+        return -1;
+    }
+
+    if (!analyze)
+    {
+        query_plan_t plan;
+        if (query_plan(reader, &query, &plan) != 0)
+        {
+            printf("❌ Failed to plan query\n");
+            return -1;
+        }
+
+        printf("🔍 Query Plan: %s\n", session->current_db);
+        printf("═══════════════════════════════\n\n");
+        print_plan(&plan, false);
+        printf("\n📦 Access path: %s via %s, %u of %u chunk%s estimated\n", query_access_name(plan.access),
+               plan.source, plan.estimated_chunks, plan.chunk_count, plan.chunk_count == 1 ? "" : "s");
+        return 0;
+    }
+
+    query_profile_t profile;
+    if (query_execute(reader, &query, NULL, &profile) < 0)
+    {
+        printf("❌ Failed to run query\n");
+        return -1;
+    }
+
+    printf("🔍 Query Profile: %s\n", session->current_db);
+    printf("═══════════════════════════════\n\n");
+    print_plan(&profile.plan, true);
+
+    printf("\n📦 Access path: %s via %s\n", query_access_name(profile.plan.access), profile.plan.source);
+
+    const char *headers[] = {"Measure", "Value"};
+    int column_widths[] = {20, 30};
+    char chunks[48], bytes[32], total[32], io[32], decode[32], filter[32], sort[32], other[32];
+    snprintf(chunks, sizeof(chunks), "%u read, %u skipped", profile.chunks_read, profile.chunks_skipped);
+    format_file_size(profile.bytes_read, bytes, sizeof(bytes));
+    snprintf(total, sizeof(total), "%.3f ms", profile.total_ms);
+    snprintf(io, sizeof(io), "%.3f ms", profile.io_ms);
+    snprintf(decode, sizeof(decode), "%.3f ms", profile.decode_ms);
+    snprintf(filter, sizeof(filter), "%.3f ms", profile.filter_ms);
+    snprintf(sort, sizeof(sort), "%.3f ms", profile.sort_ms);
+
+    // Read-ahead I/O overlaps the scan, so the rest is only what the scan thread did besides
+    double rest = profile.total_ms - profile.io_ms - profile.decode_ms - profile.filter_ms - profile.sort_ms;
+    snprintf(other, sizeof(other), "%.3f ms", rest > 0 ? rest : 0.0);
+
+    const char *rows[][2] = {
+        {"Chunks", chunks},
+        {"Bytes Read", bytes},
+        {"Total Time", total},
+        {"I/O Time", io},
+        {"Decode Time", decode},
+        {"Filter Time", filter},
+        {"Sort Time", sort},
+        {"Other Time", other}};
+
+    printf("\n");
+    print_table_header(headers, 2, column_widths);
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++)
+    {
+        print_table_row(rows[i], 2, column_widths);
+    }
+    print_table_footer(2, column_widths);
+
+    if (query.has_order)
+    {
+        const fxdb_sort_stats_t *stats = &profile.sort;
+        char spilled[32];
+        format_file_size(stats->bytes_spilled, spilled, sizeof(spilled));
+        if (stats->heap)
         {
-            reader_print_rows(reader, result);
-            reader_free_result(result);
+            printf("\n🔢 Sort: top-N heap over %llu rows\n", (unsigned long long)stats->rows);
+        }
+        else if (stats->runs == 0)
+        {
+            printf("\n🔢 Sort: %llu rows in memory, %u segment%s on %u thread%s\n",
+                   (unsigned long long)stats->rows, stats->segments, stats->segments == 1 ? "" : "s",
+                   stats->threads, stats->threads == 1 ? "" : "s");
         }
         else
         {
-            printf("❌ Failed to read data\n");
+            printf("\n🔢 Sort: %llu rows, %u run%s on %u thread%s, %s spilled, %u merge pass%s\n",
+                   (unsigned long long)stats->rows, stats->runs, stats->runs == 1 ? "" : "s",
+                   stats->threads, stats->threads == 1 ? "" : "s", spilled,
+                   stats->merge_passes, stats->merge_passes == 1 ? "" : "es");
         }
     }
 
-    reader_close(reader);
-    free(full_path);
+    if (profile.thread_count > 0)
+    {
+        const char *thread_headers[] = {"Thread", "Busy ms", "Utilization"};
+        int thread_widths[] = {10, 12, 12};
+        printf("\n🧵 Thread Utilization (I/O and decode time over the total)\n");
+        print_table_header(thread_headers, 3, thread_widths);
+        for (uint32_t i = 0; i < profile.thread_count; i++)
+        {
+            char id[16], busy[32], utilization[32];
+            snprintf(id, sizeof(id), "%u", profile.threads[i].thread_id);
+            snprintf(busy, sizeof(busy), "%.3f", profile.threads[i].busy_ms);
+            snprintf(utilization, sizeof(utilization), "%.1f%%", profile.threads[i].utilization * 100.0);
+            const char *row[] = {id, busy, utilization};
+            print_table_row(row, 3, thread_widths);
+        }
+        print_table_footer(3, thread_widths);
+    }
+
+    printf("\n💡 Decode time is sampled on one row in %d and scaled.\n", FXDB_STATS_DECODE_SAMPLE);
     return 0;
 }
 
@@ -956,19 +1522,11 @@ static int cmd_shell_insert(shell_session_t *session, const parsed_command_t *cm
         return -1;
     }
 
-    char *full_path = get_database_path(session->working_dir, session->current_db);
-    if (!full_path)
-    {
-        printf("❌ Failed to build database path\n");
-        return -1;
-    }
-
-    // Open database for appending
-    writer_t *writer = writer_open(full_path);
+    // Session writer holds the writer lock until a command other than insert runs
+    writer_t *writer = session_get_writer(session);
     if (!writer)
     {
         printf("❌ Failed to open database for insertion: %s\n", session->current_db);
-        free(full_path);
         return -1;
     }
 
@@ -985,9 +1543,6 @@ static int cmd_shell_insert(shell_session_t *session, const parsed_command_t *cm
             printf("❌ Invalid field assignment: %s\n", cmd->args[i]);
             printf("💡 Use format: field=value\n");
             free(pair);
-            writer_close(writer);
-            writer_free(writer);
-            free(full_path);
             return -1;
         }
 
@@ -1022,23 +1577,331 @@ static int cmd_shell_insert(shell_session_t *session, const parsed_command_t *cm
 
     printf("🔍 Generated JSON: %s\n", json_str);
 
-    // Insert the data
-    if (writer_insert_json(writer, json_str) == 0)
+    // Insert the data and commit it before reporting success
+    if (writer_insert_json(writer, json_str) != 0 || session_commit(session) != 0)
     {
-        printf("✅ Data inserted successfully\n");
+        printf("❌ Failed to insert data\n");
+        return -1;
     }
-    else
+
+    printf("✅ Data inserted successfully\n");
+    return 0;
+}
+
+/**
+ * Parse a field=value argument against the schema
+ * The text is copied into buffer, which string values point into
+ */
+static int parse_assignment(const schema_t *schema, const char *text, char *buffer, size_t buffer_size,
+                            uint32_t *field_index, field_value_t *value)
+{
+    strncpy(buffer, text, buffer_size - 1);
+    buffer[buffer_size - 1] = '\0';
+
+    char *equals = strchr(buffer, '=');
+    if (!equals)
     {
-        printf("❌ Failed to insert data\n");
-        writer_close(writer);
-        writer_free(writer);
-        free(full_path);
+        printf("❌ Invalid field assignment: %s\n", text);
+        printf("💡 Use format: field=value\n");
         return -1;
     }
 
-    writer_close(writer);
-    writer_free(writer);
+    *equals = '\0';
+    int index = get_field_index(schema, buffer);
+    if (index < 0)
+    {
+        printf("❌ Unknown field: %s\n", buffer);
+        return -1;
+    }
+
+    *field_index = (uint32_t)index;
+    if (writer_parse_value(&schema->fields[index], equals + 1, value) != 0)
+    {
+        printf("❌ Invalid value for field '%s': %s\n", buffer, equals + 1);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Collect the positions (and optionally the rows) where a field equals a value
+ * Rows come from the reader's row pool; hand them back with reader_release_row()
+ * Returns the number of matching rows, or -1 on error
+ */
+static int find_matching_rows(reader_t *reader, uint32_t field_index, const field_value_t *value,
+                              row_position_t **positions, row_data_t ***rows)
+{
+    const field_def_t *field = &reader->schema->fields[field_index];
+    uint32_t count = 0, capacity = 0;
+    *positions = NULL;
+    if (rows)
+    {
+        *rows = NULL;
+    }
+
+    row_data_t *row;
+    while ((row = reader_read_row_pooled(reader)) != NULL)
+    {
+        if (!reader_values_equal(field, &row->values[field_index], value))
+        {
+            reader_release_row(reader, row);
+            continue;
+        }
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            row_position_t *new_positions = realloc(*positions, capacity * sizeof(row_position_t));
+            if (new_positions)
+            {
+                *positions = new_positions;
+            }
+            row_data_t **new_rows = rows ? realloc(*rows, capacity * sizeof(row_data_t *)) : NULL;
+            if (new_rows)
+            {
+                *rows = new_rows;
+            }
+            if (!new_positions || (rows && !new_rows))
+            {
+                reader_release_row(reader, row);
+                for (uint32_t i = 0; rows && i < count; i++)
+                {
+                    reader_release_row(reader, (*rows)[i]);
+                }
+                return -1;
+            }
+        }
+
+        reader_row_position(reader, &(*positions)[count]);
+        if (rows)
+        {
+            (*rows)[count] = row;
+        }
+        else
+        {
+            reader_release_row(reader, row);
+        }
+        count++;
+    }
+
+    return (int)count;
+}
+
+/**
+ * Delete command implementation - Mark matching rows deleted
+ */
+static int cmd_shell_delete(shell_session_t *session, const parsed_command_t *cmd)
+{
+    if (strlen(session->current_db) == 0)
+    {
+        printf("❌ No database selected. Use 'use <database>' first.\n");
+        return -1;
+    }
+
+    if (cmd->arg_count != 3 || strcmp(cmd->args[1], "where") != 0)
+    {
+        printf("❌ Usage: delete where field=value\n");
+        printf("💡 Example: delete where id=42\n");
+        return -1;
+    }
+
+    reader_t *reader = session_get_reader(session);
+    if (!reader)
+    {
+        printf("❌ Failed to open database: %s\n", session->current_db);
+        return -1;
+    }
+
+    char buffer[512];
+    uint32_t field_index;
+    field_value_t value;
+    if (parse_assignment(reader->schema, cmd->args[2], buffer, sizeof(buffer), &field_index, &value) != 0)
+    {
+        return -1;
+    }
+
+    row_position_t *positions;
+    int count = find_matching_rows(reader, field_index, &value, &positions, NULL);
+    if (count < 0 || reader_delete_rows(reader, positions, (uint32_t)count) != 0)
+    {
+        printf("❌ Failed to delete rows\n");
+        free(positions);
+        return -1;
+    }
+
+    free(positions);
+    printf("✅ Deleted %d row%s\n", count, count == 1 ? "" : "s");
+    return 0;
+}
+
+/**
+ * Update command implementation - Append changed copies, then delete the originals
+ */
+static int cmd_shell_update(shell_session_t *session, const parsed_command_t *cmd)
+{
+    if (strlen(session->current_db) == 0)
+    {
+        printf("❌ No database selected. Use 'use <database>' first.\n");
+        return -1;
+    }
+
+    int where = 1;
+    while (where < cmd->arg_count && strcmp(cmd->args[where], "where") != 0)
+    {
+        where++;
+    }
+    if (where < 2 || where + 2 != cmd->arg_count)
+    {
+        printf("❌ Usage: update field=value ... where field=value\n");
+        printf("💡 Example: update price=9.5 where id=42\n");
+        return -1;
+    }
+
+    // Writer first: looking it up must not invalidate the reader we scan with
+    writer_t *writer = session_get_writer(session);
+    reader_t *reader = writer ? session_get_reader(session) : NULL;
+    if (!reader)
+    {
+        printf("❌ Failed to open database: %s\n", session->current_db);
+        return -1;
+    }
+
+    char buffers[16][512];
+    uint32_t set_fields[16];
+    field_value_t set_values[16];
+    uint32_t where_field;
+    field_value_t where_value;
+    for (int i = 1; i < where; i++)
+    {
+        if (parse_assignment(reader->schema, cmd->args[i], buffers[i], sizeof(buffers[i]),
+                             &set_fields[i], &set_values[i]) != 0)
+        {
+            return -1;
+        }
+        for (int j = 1; j < i; j++)
+        {
+            if (set_fields[j] == set_fields[i])
+            {
+                printf("❌ Field assigned twice: %s\n", cmd->args[i]);
+                return -1;
+            }
+        }
+    }
+    if (parse_assignment(reader->schema, cmd->args[where + 1], buffers[0], sizeof(buffers[0]),
+                         &where_field, &where_value) != 0)
+    {
+        return -1;
+    }
+
+    row_position_t *positions;
+    row_data_t **rows;
+    int count = find_matching_rows(reader, where_field, &where_value, &positions, &rows);
+    int result = count < 0 ? -1 : 0;
+
+    for (int r = 0; r < count; r++)
+    {
+        for (int i = 1; i < where; i++)
+        {
+            // Assigned strings point into the argument buffers; the row's own stay in its buffer
+            field_value_t *target = &rows[r]->values[set_fields[i]];
+            target->value = set_values[i].value;
+            target->is_null = set_values[i].is_null;
+        }
+    }
+
+    // Append the new versions before deleting the old ones, so a failure never loses a row
+    for (int r = 0; r < count && result == 0; r++)
+    {
+        result = writer_insert_row(writer, rows[r]->values, rows[r]->field_count);
+    }
+    // Deleting takes the writer lock, so the session's writer lets go of it first
+    if (result == 0)
+    {
+        result = session_close_writer(session);
+    }
+    if (result == 0)
+    {
+        result = reader_delete_rows(reader, positions, (uint32_t)count);
+    }
+
+    for (int r = 0; r < count; r++)
+    {
+        reader_release_row(reader, rows[r]);
+    }
+    free(rows);
+    free(positions);
+
+    if (result != 0)
+    {
+        printf("❌ Failed to update rows\n");
+        return -1;
+    }
+
+    printf("✅ Updated %d row%s\n", count, count == 1 ? "" : "s");
+    return 0;
+}
+
+/**
+ * Compact command implementation - Rewrite the database into full chunks
+ */
+static int cmd_shell_compact(shell_session_t *session, const parsed_command_t *cmd)
+{
+    if (strlen(session->current_db) == 0)
+    {
+        printf("❌ No database selected. Use 'use <database>' first.\n");
+        return -1;
+    }
+
+    if (cmd->arg_count != 1 && (cmd->arg_count != 3 || strcmp(cmd->args[1], "by") != 0))
+    {
+        printf("❌ Usage: compact [by field]\n");
+        printf("💡 Example: compact by id\n");
+        return -1;
+    }
+
+    compact_options_t options = compact_default_options();
+    if (cmd->arg_count == 3)
+    {
+        reader_t *reader = session_get_reader(session);
+        if (!reader)
+        {
+            printf("❌ Failed to open database: %s\n", session->current_db);
+            return -1;
+        }
+
+        options.sort_field = get_field_index(reader->schema, cmd->args[2]);
+        if (options.sort_field < 0)
+        {
+            printf("❌ Unknown field: %s\n", cmd->args[2]);
+            return -1;
+        }
+    }
+
+    // Our writer would keep appending to the replaced file
+    char *full_path = get_database_path(session->working_dir, session->current_db);
+    session_close_handles(session);
+    if (!full_path)
+    {
+        printf("❌ Failed to build database path\n");
+        return -1;
+    }
+
+    compact_stats_t stats;
+    if (compact_database(full_path, &options, &stats) != 0)
+    {
+        printf("❌ Failed to compact database: %s\n", session->current_db);
+        free(full_path);
+        return -1;
+    }
     free(full_path);
+
+    printf("✅ Compacted %s\n", session->current_db);
+    printf("   Chunks: %u → %u\n", stats.chunks_before, stats.chunks_after);
+    uint32_t dropped = stats.rows_before - stats.rows_after;
+    printf("   Rows:   %u → %u (%u deleted row%s dropped)\n",
+           stats.rows_before, stats.rows_after, dropped, dropped == 1 ? "" : "s");
+    printf("   Size:   %llu → %llu bytes (%u threads)\n",
+           (unsigned long long)stats.bytes_before, (unsigned long long)stats.bytes_after, stats.threads);
     return 0;
 }
 
@@ -1078,7 +1941,14 @@ static int cmd_shell_drop(shell_session_t *session, const parsed_command_t *cmd)
     {
         if (confirmation[0] == 'y' || confirmation[0] == 'Y')
         {
-            if (unlink(full_path) == 0)
+            // Release cached handles before the file goes away
+            if (strcmp(session->handles.path, full_path) == 0)
+            {
+                session_close_handles(session);
+            }
+
+            if (unlink(full_path) == 0 && wal_remove(full_path) == 0 && deletes_remove(full_path) == 0 &&
+                summary_remove(full_path) == 0 && coord_remove(full_path) == 0)
             {
                 printf("✅ Database '%s' deleted successfully\n", db_name);
                 
@@ -1133,18 +2003,10 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
         }
     }
 
-    char *full_path = get_database_path(session->working_dir, session->current_db);
-    if (!full_path)
-    {
-        printf("❌ Failed to build database path\n");
-        return -1;
-    }
-
-    reader_t *reader = reader_open(full_path);
+    reader_t *reader = session_get_reader(session);
     if (!reader)
     {
         printf("❌ Failed to open database: %s\n", session->current_db);
-        free(full_path);
         return -1;
     }
 
@@ -1152,8 +2014,6 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
     if (total_rows == 0)
     {
         printf("📄 Database is empty - nothing to export\n");
-        reader_close(reader);
-        free(full_path);
         return 0;
     }
 
@@ -1163,8 +2023,6 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
     if (!result)
     {
         printf("❌ Failed to read data\n");
-        reader_close(reader);
-        free(full_path);
         return -1;
     }
 
@@ -1190,7 +2048,11 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
             {
                 const field_value_t *value = &row->values[f];
                 
-                switch (schema->fields[f].type)
+                if (value->is_null)
+                {
+                    // NULL is an empty CSV field
+                }
+                else switch (schema->fields[f].type)
                 {
                     case TYPE_STRING:
                         printf("\"%s\"", value->value.string_val ? value->value.string_val : "");
@@ -1229,7 +2091,11 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
                 const field_value_t *value = &row->values[f];
                 printf("\"%s\": ", schema->fields[f].name);
                 
-                switch (schema->fields[f].type)
+                if (value->is_null)
+                {
+                    printf("null");
+                }
+                else switch (schema->fields[f].type)
                 {
                     case TYPE_STRING:
                         printf("\"%s\"", value->value.string_val ? value->value.string_val : "");
@@ -1258,8 +2124,6 @@ static int cmd_shell_export(shell_session_t *session, const parsed_command_t *cm
     }
 
     reader_free_result(result);
-    reader_close(reader);
-    free(full_path);
     return 0;
 }
 
@@ -1316,6 +2180,9 @@ int run_interactive_shell(const char *directory)
 
     print_welcome_screen(session);
 
+    // Inserts keep the writer lock only while the user keeps typing
+    flexon_terminal_set_idle_hook(SHELL_WRITER_IDLE_MS, close_idle_writer, session);
+
     char *line;
     while (1)
     {
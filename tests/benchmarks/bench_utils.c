@@ -0,0 +1,388 @@
+#define _GNU_SOURCE
+#include "bench_utils.h"
+#include "../../include/writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#define BENCH_MAX_CASES 64
+
+struct bench_suite {
+    char name[32];
+    bench_options_t options;
+    bench_result_t results[BENCH_MAX_CASES];
+    bool failed[BENCH_MAX_CASES];
+    uint32_t count;
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double* sorted, uint32_t count, double p) {
+    uint32_t rank = (uint32_t)ceil(p / 100.0 * count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static bool parse_count(const char* text, uint32_t* out, uint32_t min) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (*end != '\0' || value < (long)min || value > 100000000L) {
+        return false;
+    }
+    *out = (uint32_t)value;
+    return true;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--rows N] [--width N] [--runs N] [--warmup N] [--json FILE] [--flexon PATH]\n",
+            program);
+}
+
+// Start a suite, parsing the shared options
+bench_suite_t* bench_suite_create(const char* name, uint32_t default_rows, int argc, char* argv[]) {
+    bench_suite_t* suite = calloc(1, sizeof(bench_suite_t));
+    if (!suite) {
+        return NULL;
+    }
+
+    snprintf(suite->name, sizeof(suite->name), "%s", name);
+    suite->options.rows = default_rows;
+    suite->options.width = 4;
+    suite->options.runs = 10;
+    suite->options.warmup = 2;
+
+    // The flexon binary is built into the same directory as the benchmarks
+    char* self = strdup(argc > 0 ? argv[0] : ".");
+    snprintf(suite->options.flexon_path, sizeof(suite->options.flexon_path), "%s/flexon",
+             self ? dirname(self) : ".");
+    free(self);
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+        if (ok && strcmp(argv[i], "--rows") == 0) {
+            ok = parse_count(value, &suite->options.rows, 1);
+        } else if (ok && strcmp(argv[i], "--width") == 0) {
+            ok = parse_count(value, &suite->options.width, 1) && suite->options.width <= MAX_COLUMNS;
+        } else if (ok && strcmp(argv[i], "--runs") == 0) {
+            ok = parse_count(value, &suite->options.runs, 1);
+        } else if (ok && strcmp(argv[i], "--warmup") == 0) {
+            ok = parse_count(value, &suite->options.warmup, 0);
+        } else if (ok && strcmp(argv[i], "--json") == 0) {
+            suite->options.json_path = value;
+        } else if (ok && strcmp(argv[i], "--flexon") == 0) {
+            snprintf(suite->options.flexon_path, sizeof(suite->options.flexon_path), "%s", value);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Error: Bad option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            free(suite);
+            return NULL;
+        }
+        i++;
+    }
+
+    printf("=== FlexonDB %s Benchmark ===\n", name);
+    printf("rows %u, width %u, %u runs after %u warm-up\n\n", suite->options.rows, suite->options.width,
+           suite->options.runs, suite->options.warmup);
+    return suite;
+}
+
+// Options of a suite
+const bench_options_t* bench_suite_options(const bench_suite_t* suite) {
+    return suite ? &suite->options : NULL;
+}
+
+// Time a case
+int bench_run(bench_suite_t* suite, const char* name, bench_setup_fn_t setup, bench_fn_t fn, void* context,
+              uint64_t rows, uint64_t bytes) {
+    if (!suite || !fn || suite->count == BENCH_MAX_CASES) {
+        return -1;
+    }
+
+    uint32_t index = suite->count++;
+    bench_result_t* result = &suite->results[index];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->rows = rows;
+    result->bytes = bytes;
+    result->times_ms = calloc(suite->options.runs, sizeof(double));
+    if (!result->times_ms) {
+        suite->failed[index] = true;
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < suite->options.warmup + suite->options.runs; i++) {
+        if (setup) {
+            setup(context);
+        }
+        double start = now_ms();
+        if (fn(context) != 0) {
+            fprintf(stderr, "Error: Benchmark case '%s' failed\n", name);
+            suite->failed[index] = true;
+            return -1;
+        }
+        double elapsed = now_ms() - start;
+        if (i >= suite->options.warmup) {
+            result->times_ms[result->runs++] = elapsed;
+        }
+    }
+
+    qsort(result->times_ms, result->runs, sizeof(double), compare_doubles);
+    double sum = 0, squares = 0;
+    for (uint32_t i = 0; i < result->runs; i++) {
+        sum += result->times_ms[i];
+    }
+    result->mean_ms = sum / result->runs;
+    for (uint32_t i = 0; i < result->runs; i++) {
+        squares += (result->times_ms[i] - result->mean_ms) * (result->times_ms[i] - result->mean_ms);
+    }
+    result->stddev_ms = result->runs > 1 ? sqrt(squares / (result->runs - 1)) : 0.0;
+    result->min_ms = result->times_ms[0];
+    result->max_ms = result->times_ms[result->runs - 1];
+    result->p50_ms = percentile(result->times_ms, result->runs, 50);
+    result->p90_ms = percentile(result->times_ms, result->runs, 90);
+    result->p99_ms = percentile(result->times_ms, result->runs, 99);
+
+    double seconds = result->p50_ms / 1000.0;
+    result->rows_per_sec = seconds > 0 ? rows / seconds : 0.0;
+    result->mb_per_sec = seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+    printf("  %-28s p50 %9.3f ms  p90 %9.3f ms  %12.0f rows/s", result->name, result->p50_ms, result->p90_ms,
+           result->rows_per_sec);
+    if (bytes > 0) {
+        printf("  %8.1f MB/s", result->mb_per_sec);
+    }
+    printf("\n");
+    return 0;
+}
+
+// Write the results as JSON
+static int write_json(const bench_suite_t* suite) {
+    FILE* file = fopen(suite->options.json_path, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot write '%s'\n", suite->options.json_path);
+        return -1;
+    }
+
+    struct utsname host;
+    if (uname(&host) != 0) {
+        memset(&host, 0, sizeof(host));
+    }
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(file, "{\n  \"suite\": \"%s\",\n  \"generated_at\": \"%s\",\n", suite->name, timestamp);
+    fprintf(file, "  \"machine\": {\"hostname\": \"%s\", \"os\": \"%s\", \"arch\": \"%s\", \"cpus\": %ld},\n",
+            host.nodename, host.sysname, host.machine, sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(file, "  \"parameters\": {\"rows\": %u, \"width\": %u, \"runs\": %u, \"warmup\": %u},\n",
+            suite->options.rows, suite->options.width, suite->options.runs, suite->options.warmup);
+    fprintf(file, "  \"results\": [");
+
+    bool first = true;
+    for (uint32_t i = 0; i < suite->count; i++) {
+        const bench_result_t* r = &suite->results[i];
+        if (suite->failed[i]) {
+            continue;
+        }
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"runs\": %u, \"rows\": %llu, \"bytes\": %llu,\n",
+                first ? "" : ",", r->name, r->runs, (unsigned long long)r->rows, (unsigned long long)r->bytes);
+        fprintf(file, "     \"mean_ms\": %.6f, \"stddev_ms\": %.6f, \"min_ms\": %.6f, \"p50_ms\": %.6f, "
+                      "\"p90_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f,\n",
+                r->mean_ms, r->stddev_ms, r->min_ms, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms);
+        fprintf(file, "     \"rows_per_sec\": %.1f, \"mb_per_sec\": %.3f,\n     \"times_ms\": [",
+                r->rows_per_sec, r->mb_per_sec);
+        for (uint32_t t = 0; t < r->runs; t++) {
+            fprintf(file, "%s%.6f", t ? ", " : "", r->times_ms[t]);
+        }
+        fprintf(file, "]}");
+        first = false;
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// Print the summary, write the JSON file, free the suite
+int bench_suite_finish(bench_suite_t* suite) {
+    if (!suite) {
+        return 1;
+    }
+
+    int status = 0;
+    for (uint32_t i = 0; i < suite->count; i++) {
+        if (suite->failed[i]) {
+            printf("  %-28s FAILED\n", suite->results[i].name);
+            status = 1;
+        }
+    }
+    if (suite->options.json_path) {
+        if (write_json(suite) != 0) {
+            status = 1;
+        } else {
+            printf("\nResults written to %s\n", suite->options.json_path);
+        }
+    }
+
+    for (uint32_t i = 0; i < suite->count; i++) {
+        free(suite->results[i].times_ms);
+    }
+    free(suite);
+    return status;
+}
+
+// Schema of `width` generated columns
+schema_t* bench_schema(uint32_t width) {
+    static const char* types[] = { "string", "float", "bool", "int32" };
+    char text[MAX_COLUMNS * 24];
+    size_t used = (size_t)snprintf(text, sizeof(text), "id int32");
+
+    for (uint32_t c = 1; c < width && c < MAX_COLUMNS; c++) {
+        const char* type = types[(c - 1) % 4];
+        bool nullable = (c - 1) % 4 == 0 && c > 1;
+        used += (size_t)snprintf(text + used, sizeof(text) - used, ", c%u %s%s", c, type, nullable ? "?" : "");
+    }
+    return parse_schema(text);
+}
+
+// Whether column c of row i is NULL
+static bool value_is_null(const field_def_t* field, uint32_t i, uint32_t c) {
+    return field->nullable && (i + c) % 7 == 0;
+}
+
+// Text of column c of row i as it appears in JSON and CSV
+static int format_value(const field_def_t* field, uint32_t i, uint32_t c, char* buffer, size_t size) {
+    if (value_is_null(field, i, c)) {
+        return snprintf(buffer, size, "null");
+    }
+    switch (field->type) {
+        case TYPE_INT32:
+            return snprintf(buffer, size, "%u", c == 0 ? i : i * 31 + c);
+        case TYPE_FLOAT:
+            return snprintf(buffer, size, "%.2f", i * 0.5 + c);
+        case TYPE_BOOL:
+            return snprintf(buffer, size, "%s", (i + c) % 2 ? "true" : "false");
+        case TYPE_STRING:
+            return snprintf(buffer, size, "\"v%u_%u\"", i, c);
+        default:
+            return -1;
+    }
+}
+
+// Row `i` as a JSON object
+int bench_row_json(const schema_t* schema, uint32_t i, char* buffer, size_t size) {
+    size_t used = 0;
+    for (uint32_t c = 0; c < schema->field_count; c++) {
+        char value[BENCH_STRING_SIZE + 2];
+        format_value(&schema->fields[c], i, c, value, sizeof(value));
+        int n = snprintf(buffer + used, size - used, "%s\"%s\": %s", c ? ", " : "{", schema->fields[c].name, value);
+        if (n < 0 || (size_t)n >= size - used) {
+            return -1;
+        }
+        used += (size_t)n;
+    }
+    int n = snprintf(buffer + used, size - used, "}");
+    return n < 0 || (size_t)n >= size - used ? -1 : (int)(used + 1);
+}
+
+// Row `i` as a CSV line
+int bench_row_csv(const schema_t* schema, uint32_t i, char* buffer, size_t size) {
+    size_t used = 0;
+    for (uint32_t c = 0; c < schema->field_count; c++) {
+        char value[BENCH_STRING_SIZE + 2] = "";
+        if (!value_is_null(&schema->fields[c], i, c)) {
+            format_value(&schema->fields[c], i, c, value, sizeof(value));
+        }
+        int n = snprintf(buffer + used, size - used, "%s%s", c ? "," : "", value);
+        if (n < 0 || (size_t)n >= size - used) {
+            return -1;
+        }
+        used += (size_t)n;
+    }
+    return (int)used;
+}
+
+// Row `i` as typed values
+void bench_row_values(const schema_t* schema, uint32_t i, field_value_t* values, char* strings) {
+    for (uint32_t c = 0; c < schema->field_count; c++) {
+        const field_def_t* field = &schema->fields[c];
+        field_value_t* value = &values[c];
+        value->field_name = field->name;
+        value->is_null = value_is_null(field, i, c);
+        switch (field->type) {
+            case TYPE_INT32:
+                value->value.int32_val = (int32_t)(c == 0 ? i : i * 31 + c);
+                break;
+            case TYPE_FLOAT:
+                value->value.float_val = (float)(i * 0.5 + c);
+                break;
+            case TYPE_BOOL:
+                value->value.bool_val = (i + c) % 2 != 0;
+                break;
+            case TYPE_STRING: {
+                char* text = strings + (size_t)c * BENCH_STRING_SIZE;
+                snprintf(text, BENCH_STRING_SIZE, "v%u_%u", i, c);
+                value->value.string_val = text;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// Write a table of generated rows
+int bench_write_table(const char* filename, const schema_t* schema, uint32_t rows) {
+    writer_t* writer = writer_create_default(filename, schema);
+    field_value_t* values = calloc(schema->field_count, sizeof(field_value_t));
+    char* strings = malloc((size_t)schema->field_count * BENCH_STRING_SIZE);
+    int result = writer && values && strings ? 0 : -1;
+
+    for (uint32_t i = 0; i < rows && result == 0; i++) {
+        bench_row_values(schema, i, values, strings);
+        result = writer_insert_row(writer, values, schema->field_count);
+    }
+    if (writer && writer_close(writer) != 0) {
+        result = -1;
+    }
+
+    writer_free(writer);
+    free(values);
+    free(strings);
+    return result;
+}
+
+// Size of a file in bytes
+uint64_t bench_file_size(const char* filename) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+// Drop a file's pages from the page cache
+void bench_evict(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
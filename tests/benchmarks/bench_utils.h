@@ -0,0 +1,125 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include "../../include/schema.h"
+#include "../../include/writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ===== Benchmark Harness ===== */
+
+// Options shared by every benchmark program:
+//   --rows N     rows per generated table (default per program)
+//   --width N    columns per generated row, id included (default 4)
+//   --runs N     timed repetitions per case (default 10)
+//   --warmup N   untimed repetitions before them (default 2)
+//   --json FILE  write the results as JSON for tests/scripts/generate_report.py
+//   --flexon P   flexon binary for end-to-end cases (default: next to the benchmark)
+typedef struct {
+    uint32_t rows;
+    uint32_t width;
+    uint32_t runs;
+    uint32_t warmup;
+    const char* json_path;
+    char flexon_path[1024];
+} bench_options_t;
+
+// Timings of one case
+typedef struct {
+    char name[64];              // "<group>/<variant>", e.g. "insert/json"
+    uint32_t runs;              // Timed repetitions
+    double* times_ms;           // One sample per run, sorted
+    double mean_ms;
+    double stddev_ms;           // Sample standard deviation
+    double min_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+    uint64_t rows;              // Rows handled per run
+    uint64_t bytes;             // Bytes handled per run (0 when meaningless)
+    double rows_per_sec;        // At the median
+    double mb_per_sec;          // At the median
+} bench_result_t;
+
+typedef struct bench_suite bench_suite_t;
+
+// One repetition; returns 0 on success, -1 to abort the case
+typedef int (*bench_fn_t)(void* context);
+
+// Untimed work before each repetition, warm-up included (may be NULL)
+typedef void (*bench_setup_fn_t)(void* context);
+
+/**
+ * Start a suite, parsing the shared options
+ * @param default_rows Rows used when --rows is not given
+ * Returns NULL on bad options (usage is printed)
+ */
+bench_suite_t* bench_suite_create(const char* name, uint32_t default_rows, int argc, char* argv[]);
+
+/**
+ * Options of a suite
+ */
+const bench_options_t* bench_suite_options(const bench_suite_t* suite);
+
+/**
+ * Time a case: warm-up runs, then timed runs, each after `setup`
+ * @param rows Rows handled per run, for rows/s
+ * @param bytes Bytes handled per run, for MB/s (0 to leave it out)
+ * Returns 0 on success, -1 if a run failed (the case is reported as failed)
+ */
+int bench_run(bench_suite_t* suite, const char* name, bench_setup_fn_t setup, bench_fn_t fn, void* context,
+              uint64_t rows, uint64_t bytes);
+
+/**
+ * Print the summary table, write the JSON file if asked to, free the suite
+ * Returns 0 when every case ran, 1 otherwise (the exit status of the program)
+ */
+int bench_suite_finish(bench_suite_t* suite);
+
+/* ===== Data Generators ===== */
+
+#define BENCH_STRING_SIZE 32   // Room for one generated string value
+
+/**
+ * Schema of `width` columns: id int32, then string, float, bool and int32
+ * columns in turn; every string column after the first is nullable
+ */
+schema_t* bench_schema(uint32_t width);
+
+/**
+ * Row `i` of the generated table as a JSON object
+ * Returns the length written, -1 if it did not fit
+ */
+int bench_row_json(const schema_t* schema, uint32_t i, char* buffer, size_t size);
+
+/**
+ * Row `i` as a CSV line in the format of `flexon dump --format csv`
+ * (strings quoted, NULL as an empty field), without the newline
+ */
+int bench_row_csv(const schema_t* schema, uint32_t i, char* buffer, size_t size);
+
+/**
+ * Row `i` as typed values; strings point into `strings`, which needs
+ * schema->field_count * BENCH_STRING_SIZE bytes
+ */
+void bench_row_values(const schema_t* schema, uint32_t i, field_value_t* values, char* strings);
+
+/**
+ * Write a table of `rows` generated rows
+ * Returns 0 on success, -1 on failure
+ */
+int bench_write_table(const char* filename, const schema_t* schema, uint32_t rows);
+
+/**
+ * Size of a file in bytes (0 if missing)
+ */
+uint64_t bench_file_size(const char* filename);
+
+/**
+ * Drop a file's pages from the page cache so the next read starts cold
+ */
+void bench_evict(const char* filename);
+
+#endif // BENCH_UTILS_H
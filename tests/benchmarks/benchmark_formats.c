@@ -1,11 +1,130 @@
+#include "bench_utils.h"
 #include "../test_utils.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
-int main(void) {
-    printf("=== FlexonDB Format Benchmark ===\n\n");
-    
-    printf("Format benchmark placeholder\n");
-    
-    return 0;
-}
\ No newline at end of file
+#define BENCH_FILE "benchmark_formats.fxdb"
+#define BENCH_IMPORT_FILE "benchmark_import.fxdb"
+
+extern char** environ;
+
+typedef struct {
+    const char* flexon;         // Binary run by the dump cases
+    const char* format;         // Dump format
+    const schema_t* schema;
+    uint32_t rows;
+    char** csv;                 // Lines imported by the import case
+} format_context_t;
+
+static void remove_import(void* context) {
+    (void)context;
+    unlink(BENCH_IMPORT_FILE);
+}
+
+// `flexon dump` end to end, output discarded
+static int dump(void* context) {
+    format_context_t* ctx = context;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char* argv[] = { (char*)ctx->flexon, "dump", BENCH_FILE, "--format", (char*)ctx->format, NULL };
+    pid_t pid;
+    int status = -1;
+    if (posix_spawn(&pid, ctx->flexon, &actions, NULL, argv, environ) != 0 ||
+        waitpid(pid, &status, 0) != pid) {
+        status = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return status == 0 ? 0 : -1;
+}
+
+// Import CSV lines in the dump format: split, parse each field, insert typed rows
+static int import_csv(void* context) {
+    format_context_t* ctx = context;
+    writer_t* writer = writer_create_default(BENCH_IMPORT_FILE, ctx->schema);
+    if (!writer) {
+        return -1;
+    }
+
+    field_value_t values[MAX_COLUMNS];
+    char line[8192];
+    int result = 0;
+    for (uint32_t i = 0; i < ctx->rows && result == 0; i++) {
+        snprintf(line, sizeof(line), "%s", ctx->csv[i]);
+        char* field = line;
+        for (uint32_t c = 0; c < ctx->schema->field_count && result == 0; c++) {
+            char* comma = strchr(field, ',');
+            if (comma) {
+                *comma = '\0';
+            }
+            char null_text[] = "null"; // An empty field is NULL
+            result = writer_parse_value(&ctx->schema->fields[c], *field ? field : null_text, &values[c]);
+            field = comma ? comma + 1 : field + strlen(field);
+        }
+        if (result == 0) {
+            result = writer_insert_row(writer, values, ctx->schema->field_count);
+        }
+    }
+
+    if (writer_close(writer) != 0) {
+        result = -1;
+    }
+    writer_free(writer);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    bench_suite_t* suite = bench_suite_create("Format", 100000, argc, argv);
+    if (!suite) {
+        return 1;
+    }
+    const bench_options_t* options = bench_suite_options(suite);
+
+    cleanup_test_files();
+    schema_t* schema = bench_schema(options->width);
+    char** csv = calloc(options->rows, sizeof(char*));
+    if (!schema || !csv || bench_write_table(BENCH_FILE, schema, options->rows) != 0) {
+        printf("Failed to write benchmark file\n");
+        return 1;
+    }
+
+    uint64_t csv_bytes = 0;
+    char line[8192];
+    for (uint32_t i = 0; i < options->rows; i++) {
+        int length = bench_row_csv(schema, i, line, sizeof(line));
+        csv[i] = length >= 0 ? strdup(line) : NULL;
+        if (!csv[i]) {
+            printf("Failed to generate CSV rows\n");
+            return 1;
+        }
+        csv_bytes += (uint64_t)length + 1;
+    }
+
+    // Dumps read the whole table; MB/s is of the table file
+    uint64_t bytes = bench_file_size(BENCH_FILE);
+    format_context_t ctx = { options->flexon_path, "csv", schema, options->rows, csv };
+    if (access(options->flexon_path, X_OK) == 0) {
+        bench_run(suite, "dump/csv", NULL, dump, &ctx, options->rows, bytes);
+        ctx.format = "json";
+        bench_run(suite, "dump/json", NULL, dump, &ctx, options->rows, bytes);
+    } else {
+        printf("  (no flexon binary at %s; dump cases skipped, see --flexon)\n", options->flexon_path);
+    }
+    bench_run(suite, "import/csv", remove_import, import_csv, &ctx, options->rows, csv_bytes);
+
+    for (uint32_t i = 0; i < options->rows; i++) {
+        free(csv[i]);
+    }
+    free(csv);
+    free_schema(schema);
+    cleanup_test_files();
+    return bench_suite_finish(suite);
+}
@@ -1,39 +1,131 @@
+#include "bench_utils.h"
 #include "../test_utils.h"
 #include "../../include/writer.h"
 #include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-int main(void) {
-    printf("=== FlexonDB Insert Benchmark ===\n\n");
-    
+#define BENCH_FILE "benchmark_insert.fxdb"
+#define BENCH_BATCH_ROWS 1000  // Rows per commit in the batch case
+
+typedef struct {
+    const schema_t* schema;
+    uint32_t rows;
+    char** json;               // Pre-generated rows, so generating them is not timed
+    field_value_t* values;     // rows * field_count values
+    char* strings;             // Storage of the string values
+} insert_context_t;
+
+static void remove_file(void* context) {
+    (void)context;
     cleanup_test_files();
-    
-    // Create test schema
-    schema_t* schema = parse_schema("id int32, name string, score float, active bool");
-    if (!schema) {
-        printf("Failed to create test schema\n");
+}
+
+// Finish a timed insert: close the file and check every row arrived
+static int finish(writer_t* writer, int result, uint32_t rows) {
+    uint32_t written = 0;
+    if (writer_close(writer) != 0) {
+        result = -1;
+    }
+    writer_get_stats(writer, &written, NULL);
+    writer_free(writer);
+    return result == 0 && written == rows ? 0 : -1;
+}
+
+static int insert_rows(void* context) {
+    insert_context_t* ctx = context;
+    writer_t* writer = writer_create_default(BENCH_FILE, ctx->schema);
+    if (!writer) {
+        return -1;
+    }
+
+    int result = 0;
+    uint32_t fields = ctx->schema->field_count;
+    for (uint32_t i = 0; i < ctx->rows && result == 0; i++) {
+        result = writer_insert_row(writer, ctx->values + (size_t)i * fields, fields);
+    }
+    return finish(writer, result, ctx->rows);
+}
+
+static int insert_json(void* context) {
+    insert_context_t* ctx = context;
+    writer_t* writer = writer_create_default(BENCH_FILE, ctx->schema);
+    if (!writer) {
+        return -1;
+    }
+
+    int result = 0;
+    for (uint32_t i = 0; i < ctx->rows && result == 0; i++) {
+        result = writer_insert_json(writer, ctx->json[i]);
+    }
+    return finish(writer, result, ctx->rows);
+}
+
+// JSON rows committed BENCH_BATCH_ROWS at a time, as the server's batch inserts are
+static int insert_batches(void* context) {
+    insert_context_t* ctx = context;
+    writer_t* writer = writer_create_default(BENCH_FILE, ctx->schema);
+    if (!writer) {
+        return -1;
+    }
+
+    int result = 0;
+    for (uint32_t i = 0; i < ctx->rows && result == 0; i++) {
+        result = writer_insert_json(writer, ctx->json[i]);
+        if (result == 0 && ((i + 1) % BENCH_BATCH_ROWS == 0 || i + 1 == ctx->rows)) {
+            result = writer_commit(writer);
+        }
+    }
+    return finish(writer, result, ctx->rows);
+}
+
+int main(int argc, char* argv[]) {
+    bench_suite_t* suite = bench_suite_create("Insert", 100000, argc, argv);
+    if (!suite) {
         return 1;
     }
-    
-    // Time multiple insert operations
-    timing_info_t* timing = timing_start();
-    
-    // Simulate multiple inserts
-    for (int i = 0; i < 1000; i++) {
-        // Insert simulation (would use actual writer functions)
-    }
-    
-    timing_end(timing);
-    
-    printf("Insert benchmark completed:\n");
-    printf("  Operations: 1000\n");
-    printf("  Total time: %.2f ms\n", timing_get_ms(timing));
-    printf("  Average per operation: %.4f ms\n", timing_get_ms(timing) / 1000.0);
-    
-    timing_free(timing);
+    const bench_options_t* options = bench_suite_options(suite);
+
+    cleanup_test_files();
+    schema_t* schema = bench_schema(options->width);
+    insert_context_t ctx = { schema, options->rows, NULL, NULL, NULL };
+    if (schema) {
+        ctx.json = calloc(ctx.rows, sizeof(char*));
+        ctx.values = calloc((size_t)ctx.rows * schema->field_count, sizeof(field_value_t));
+        ctx.strings = malloc((size_t)ctx.rows * schema->field_count * BENCH_STRING_SIZE);
+    }
+    if (!schema || !ctx.json || !ctx.values || !ctx.strings) {
+        printf("Failed to generate benchmark rows\n");
+        return 1;
+    }
+
+    uint64_t json_bytes = 0;
+    char line[8192];
+    for (uint32_t i = 0; i < ctx.rows; i++) {
+        int length = bench_row_json(schema, i, line, sizeof(line));
+        ctx.json[i] = length > 0 ? strdup(line) : NULL;
+        if (!ctx.json[i]) {
+            printf("Failed to generate benchmark rows\n");
+            return 1;
+        }
+        json_bytes += (uint64_t)length;
+        bench_row_values(schema, i, ctx.values + (size_t)i * schema->field_count,
+                         ctx.strings + (size_t)i * schema->field_count * BENCH_STRING_SIZE);
+    }
+
+    uint64_t row_bytes = (uint64_t)ctx.rows * schema->row_size;
+    bench_run(suite, "insert/row", remove_file, insert_rows, &ctx, ctx.rows, row_bytes);
+    bench_run(suite, "insert/json", remove_file, insert_json, &ctx, ctx.rows, json_bytes);
+    bench_run(suite, "insert/batch", remove_file, insert_batches, &ctx, ctx.rows, json_bytes);
+
+    for (uint32_t i = 0; i < ctx.rows; i++) {
+        free(ctx.json[i]);
+    }
+    free(ctx.json);
+    free(ctx.values);
+    free(ctx.strings);
     free_schema(schema);
     cleanup_test_files();
-    
-    return 0;
-}
\ No newline at end of file
+    return bench_suite_finish(suite);
+}
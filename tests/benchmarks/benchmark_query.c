@@ -1,11 +1,81 @@
+#include "bench_utils.h"
 #include "../test_utils.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-int main(void) {
-    printf("=== FlexonDB Query Benchmark ===\n\n");
-    
-    printf("Query benchmark placeholder\n");
-    
-    return 0;
-}
\ No newline at end of file
+#define BENCH_FILE "benchmark_query.fxdb"
+
+typedef struct {
+    uint32_t rows;
+    uint32_t field;             // Column aggregated or filtered on
+    field_value_t match;        // Value the filter looks for
+    const schema_t* schema;
+} query_context_t;
+
+// sum/min/max over one column, a bitmap word at a time
+static int aggregate(void* context) {
+    query_context_t* ctx = context;
+    reader_t* reader = reader_open(BENCH_FILE);
+    column_aggregate_t result;
+    int status = reader && reader_set_mmap(reader, true, NULL) == 0 &&
+                 reader_aggregate_column(reader, ctx->field, &result) == 0 && result.row_count == ctx->rows
+                 ? 0 : -1;
+    reader_close(reader);
+    return status;
+}
+
+// Row-at-a-time scan comparing one column, as the shell's `where` clauses do
+static int filter(void* context) {
+    query_context_t* ctx = context;
+    reader_t* reader = reader_open(BENCH_FILE);
+    if (!reader || reader_set_mmap(reader, true, NULL) != 0) {
+        reader_close(reader);
+        return -1;
+    }
+
+    uint32_t matches = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        if (reader_values_equal(&ctx->schema->fields[ctx->field], &row->values[ctx->field], &ctx->match)) {
+            matches++;
+        }
+        reader_free_row(row);
+    }
+    reader_close(reader);
+    return matches == 1 ? 0 : -1;
+}
+
+int main(int argc, char* argv[]) {
+    bench_suite_t* suite = bench_suite_create("Query", 200000, argc, argv);
+    if (!suite) {
+        return 1;
+    }
+    const bench_options_t* options = bench_suite_options(suite);
+
+    cleanup_test_files();
+    schema_t* schema = bench_schema(options->width);
+    if (!schema || bench_write_table(BENCH_FILE, schema, options->rows) != 0) {
+        printf("Failed to write benchmark file\n");
+        return 1;
+    }
+    uint64_t bytes = bench_file_size(BENCH_FILE);
+
+    // The id column holds each row number once
+    query_context_t by_id = { options->rows, 0, { 0 }, schema };
+    by_id.match.value.int32_val = (int32_t)(options->rows / 2);
+    bench_run(suite, "aggregate/int32", NULL, aggregate, &by_id, options->rows, bytes);
+    bench_run(suite, "filter/int32", NULL, filter, &by_id, options->rows, bytes);
+
+    // The first float column, when the schema is wide enough to have one
+    if (schema->field_count > 2) {
+        query_context_t by_float = { options->rows, 2, { 0 }, schema };
+        bench_run(suite, "aggregate/float", NULL, aggregate, &by_float, options->rows, bytes);
+    }
+
+    free_schema(schema);
+    cleanup_test_files();
+    return bench_suite_finish(suite);
+}
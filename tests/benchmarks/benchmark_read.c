@@ -1,16 +1,137 @@
+#include "bench_utils.h"
 #include "../test_utils.h"
 #include "../../include/reader.h"
+#include "../../include/writer.h"
 #include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-int main(void) {
-    printf("=== FlexonDB Read Benchmark ===\n\n");
-    
-    printf("Read benchmark placeholder\n");
-    printf("  Operations: 1000\n");
-    printf("  Total time: 10.00 ms\n");
-    printf("  Average per operation: 0.0100 ms\n");
-    
-    return 0;
-}
\ No newline at end of file
+#define BENCH_FILE "benchmark_read.fxdb"
+#define BENCH_LOOKUPS 10000
+
+typedef struct {
+    uint32_t rows;              // Rows a scan must return
+    uint32_t* lookups;          // Rows to seek to, BENCH_LOOKUPS of them
+    const fxdb_mmap_options_t* options; // Mapping hints (mmap cases)
+} read_context_t;
+
+static void evict(void* context) {
+    (void)context;
+    bench_evict(BENCH_FILE);
+}
+
+// Sequential scan through reader_t and its buffered reads
+static int scan_reader(void* context) {
+    read_context_t* ctx = context;
+    reader_t* reader = reader_open(BENCH_FILE);
+    if (!reader) {
+        return -1;
+    }
+
+    uint32_t count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        reader_free_row(row);
+        count++;
+    }
+    reader_close(reader);
+    return count == ctx->rows ? 0 : -1;
+}
+
+// Sequential scan through the mmap enhanced reader
+static int scan_mmap(void* context) {
+    read_context_t* ctx = context;
+    fxdb_enhanced_reader_t* reader = fxdb_reader_open_with_options(BENCH_FILE, ctx->options);
+    if (!reader || !reader->use_mmap) {
+        fxdb_reader_close(reader);
+        return -1;
+    }
+
+    uint32_t count = 0;
+    row_data_t* row;
+    while ((row = fxdb_reader_read_row(reader)) != NULL) {
+        reader_free_row(row);
+        count++;
+    }
+    fxdb_reader_close(reader);
+    return count == ctx->rows ? 0 : -1;
+}
+
+// Random seeks through reader_seek_row
+static int seek_reader(void* context) {
+    read_context_t* ctx = context;
+    reader_t* reader = reader_open(BENCH_FILE);
+    int result = reader ? 0 : -1;
+
+    for (uint32_t i = 0; i < BENCH_LOOKUPS && result == 0; i++) {
+        row_data_t* row = reader_seek_row(reader, ctx->lookups[i]) == 0 ? reader_read_row(reader) : NULL;
+        result = row && (uint32_t)row->values[0].value.int32_val == ctx->lookups[i] ? 0 : -1;
+        reader_free_row(row);
+    }
+    reader_close(reader);
+    return result;
+}
+
+// Random seeks through the mmap enhanced reader
+static int seek_mmap(void* context) {
+    read_context_t* ctx = context;
+    fxdb_enhanced_reader_t* reader = fxdb_reader_open_with_options(BENCH_FILE, ctx->options);
+    int result = reader && reader->use_mmap ? 0 : -1;
+
+    for (uint32_t i = 0; i < BENCH_LOOKUPS && result == 0; i++) {
+        row_data_t* row = fxdb_reader_seek_row(reader, ctx->lookups[i]) == 0 ? fxdb_reader_read_row(reader) : NULL;
+        result = row && (uint32_t)row->values[0].value.int32_val == ctx->lookups[i] ? 0 : -1;
+        reader_free_row(row);
+    }
+    fxdb_reader_close(reader);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    bench_suite_t* suite = bench_suite_create("Read", 200000, argc, argv);
+    if (!suite) {
+        return 1;
+    }
+    const bench_options_t* options = bench_suite_options(suite);
+
+    cleanup_test_files();
+    schema_t* schema = bench_schema(options->width);
+    uint32_t* lookups = malloc(BENCH_LOOKUPS * sizeof(uint32_t));
+    if (!schema || !lookups || bench_write_table(BENCH_FILE, schema, options->rows) != 0) {
+        printf("Failed to write benchmark file\n");
+        return 1;
+    }
+
+    srand(42);
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        lookups[i] = (uint32_t)rand() % options->rows;
+    }
+
+    fxdb_mmap_options_t defaults = fxdb_mmap_default_options();
+    fxdb_mmap_options_t sequential = defaults;
+    sequential.access = FXDB_MMAP_ACCESS_SEQUENTIAL;
+    fxdb_mmap_options_t random = defaults;
+    random.access = FXDB_MMAP_ACCESS_RANDOM;
+
+    read_context_t ctx = { options->rows, lookups, &defaults };
+    read_context_t hinted = { options->rows, lookups, &sequential };
+    read_context_t point = { options->rows, lookups, &random };
+    uint64_t bytes = bench_file_size(BENCH_FILE);
+
+    // Warm: the file stays in the page cache between runs
+    bench_run(suite, "scan/reader", NULL, scan_reader, &ctx, options->rows, bytes);
+    bench_run(suite, "scan/mmap", NULL, scan_mmap, &ctx, options->rows, bytes);
+    bench_run(suite, "seek/reader", NULL, seek_reader, &ctx, BENCH_LOOKUPS, 0);
+    bench_run(suite, "seek/mmap", NULL, seek_mmap, &ctx, BENCH_LOOKUPS, 0);
+
+    // Cold: each run starts with the file evicted
+    bench_run(suite, "scan-cold/reader", evict, scan_reader, &ctx, options->rows, bytes);
+    bench_run(suite, "scan-cold/mmap", evict, scan_mmap, &ctx, options->rows, bytes);
+    bench_run(suite, "scan-cold/mmap-sequential", evict, scan_mmap, &hinted, options->rows, bytes);
+    bench_run(suite, "seek-cold/mmap-random", evict, seek_mmap, &point, BENCH_LOOKUPS, 0);
+
+    free(lookups);
+    free_schema(schema);
+    cleanup_test_files();
+    return bench_suite_finish(suite);
+}
@@ -1,13 +1,124 @@
+// shell.h and test_utils.h both define timing_info_t
+#define timing_info_t shell_timing_info_t
+#include "../../include/shell.h"
+#undef timing_info_t
 #include "../test_utils.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utime.h>
+
+#define TEST_WORKFLOW_DB "test_workflow.fxdb"
+
+// Run one shell command line against the session
+static int run(shell_session_t* session, const char* line) {
+    parsed_command_t* cmd = parse_command(line);
+    if (!cmd) {
+        return -1;
+    }
+    int result = execute_shell_command(session, cmd);
+    free_parsed_command(cmd);
+    return result;
+}
 
 int main(void) {
     test_init("Full Workflow Tests");
-    
+
+    cleanup_test_files();
+
     // Test 1: End-to-end workflow
     printf("Test 1: Complete database workflow\n");
-    test_assert(true, "Full workflow test placeholder");
-    
+    schema_t* schema = parse_schema("id int32, name string");
+    writer_t* writer = schema ? writer_create_default(TEST_WORKFLOW_DB, schema) : NULL;
+    test_assert_not_null(writer, "Create database");
+    if (writer) {
+        writer_close(writer);
+        writer_free(writer);
+    }
+
+    shell_session_t* session = init_session(".");
+    test_assert_not_null(session, "Shell session");
+    if (!session) {
+        return test_finalize();
+    }
+
+    test_assert_equal_int(0, run(session, "use " TEST_WORKFLOW_DB), "use database");
+
+    // Test 2: A run of inserts keeps one writer; the reader is reused
+    printf("Test 2: Cached handles across commands\n");
+    test_assert_equal_int(0, run(session, "insert id=1 name=first"), "First insert");
+    writer_t* first_writer = session->handles.writer;
+    test_assert_not_null(first_writer, "Writer kept after the insert commits");
+
+    bool inserts_ok = true;
+    char line[64];
+    for (int i = 2; i <= 50; i++) {
+        snprintf(line, sizeof(line), "insert id=%d name=row%d", i, i);
+        inserts_ok = inserts_ok && run(session, line) == 0;
+    }
+    test_assert(inserts_ok, "Repeated inserts");
+    test_assert(session->handles.writer == first_writer, "Inserts reuse the writer");
+
+    reader_t* reader = session_get_reader(session);
+    test_assert(reader && reader_get_row_count(reader) == 50, "Reader sees committed inserts");
+    test_assert(session_get_reader(session) == reader, "Reader reused while file is unchanged");
+
+    // Test 3: Other writers get the lock once a command other than insert runs
+    printf("Test 3: External changes\n");
+    test_assert_equal_int(0, run(session, "count"), "Count rows");
+    test_assert(session->handles.writer == NULL, "Writer closed by a command other than insert");
+    writer_config_t no_wait = writer_default_config();
+    no_wait.lock_timeout_ms = 0;
+    writer_t* external = writer_open_with_config(TEST_WORKFLOW_DB, &no_wait);
+    test_assert_not_null(external, "External writer not locked out by the session");
+    if (external) {
+        writer_insert_json(external, "{\"id\": 51, \"name\": \"outside\"}");
+        writer_close(external);
+        writer_free(external);
+    }
+
+    // Writes from outside the session invalidate the cached reader
+    reader = session_get_reader(session);
+    test_assert(reader && reader_get_row_count(reader) == 51, "Reader refreshed after external append");
+    test_assert_equal_int(0, run(session, "insert id=52 name=after"), "Insert after external append");
+    test_assert_equal_int(-1, run(session, "insert id=oops name=bad"), "Failed insert");
+    test_assert(session->handles.writer == NULL, "Failed command releases the writer");
+
+    // Test 4: An update opens the writer, then scans with the reader
+    printf("Test 4: Update with fresh handles\n");
+    session_close_handles(session);
+    time_t past = time(NULL) - 10;
+    struct utimbuf times = { past, past };
+    test_assert(utime(TEST_WORKFLOW_DB, &times) == 0, "Age the file");
+    test_assert_equal_int(0, run(session, "update name=changed where id=52"), "Update row");
+    reader = session_get_reader(session);
+    bool updated = false;
+    uint32_t rows = 0;
+    row_data_t* row;
+    while (reader && (row = reader_read_row(reader)) != NULL) {
+        updated = updated || (row->values[0].value.int32_val == 52 &&
+                              strcmp(row->values[1].value.string_val, "changed") == 0);
+        rows++;
+        reader_free_row(row);
+    }
+    test_assert(updated && rows == 52, "Row updated in place of the old one");
+
+    free_session(session);
+
+    reader = reader_open(TEST_WORKFLOW_DB);
+    test_assert(reader && reader_get_row_count(reader) == 52, "Every row on disk after session ends");
+    if (reader) {
+        reader_close(reader);
+    }
+
+    if (schema) {
+        free_schema(schema);
+    }
+
+    cleanup_test_files();
     return test_finalize();
-}
\ No newline at end of file
+}
@@ -1,126 +1,164 @@
 #!/bin/bash
 set -e
 
-# FlexonDB Hyperfine Benchmark Script
-# Uses hyperfine for accurate performance measurements with JSON output
+# FlexonDB Benchmark Script
+# Runs the benchmark programs of tests/benchmarks, compares the results with
+# the baseline stored for this machine class and fails on significant
+# slowdowns. Every run is kept, and a trend report follows each case across
+# them.
+#
+# Usage: tests/scripts/benchmark.sh [options]
+#   --threshold PCT      Fail on a case slower than the baseline by more than PCT percent (default 10)
+#   --confidence LEVEL   Confidence level of the comparison (default 0.95)
+#   --runs N             Timed runs per case (default 15)
+#   --rows N             Rows per generated table (default 50000)
+#   --repeat N           Processes per benchmark program, pooled by the gate (default 3)
+#   --update-baseline    Record this run as the baseline of the machine class
+#   --no-gate            Report slowdowns without failing
+#   --hyperfine          Also time the flexon CLI end to end with hyperfine
+#
+# Environment:
+#   FLEXON_BIN_DIR        Built binaries (default dist/linux/bin; configure with -DBUILD_BENCHMARKS=ON)
+#   FLEXON_MACHINE_CLASS  Baseline to compare with (default <os>-<arch>-<cpus>cpu)
+#   BENCHMARK_OUTPUT_DIR  Where runs and reports are kept (default tests/output)
 
-BINARY="../../build/dist/linux/bin/flexon"
-OUTPUT_DIR="../output"
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+REPO_ROOT="$(cd "$SCRIPT_DIR/../.." && pwd)"
+BIN_DIR="${FLEXON_BIN_DIR:-$REPO_ROOT/dist/linux/bin}"
+BINARY="$BIN_DIR/flexon"
+OUTPUT_DIR="${BENCHMARK_OUTPUT_DIR:-$REPO_ROOT/tests/output}"
+MACHINE_CLASS="${FLEXON_MACHINE_CLASS:-$(uname -s | tr '[:upper:]' '[:lower:]')-$(uname -m)-$(getconf _NPROCESSORS_ONLN)cpu}"
+BASELINE="$REPO_ROOT/tests/benchmarks/baselines/$MACHINE_CLASS.json"
 TIMESTAMP=$(date +"%Y%m%d_%H%M%S")
+RUN_DIR="$OUTPUT_DIR/run_$TIMESTAMP"
+SUITES="insert read query formats"
+
+THRESHOLD=10
+CONFIDENCE=0.95
+RUNS=15
+REPEAT=3
+ROWS=50000
+UPDATE_BASELINE=false
+GATE=true
+HYPERFINE=false
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --threshold) THRESHOLD="$2"; shift 2 ;;
+        --confidence) CONFIDENCE="$2"; shift 2 ;;
+        --runs) RUNS="$2"; shift 2 ;;
+        --rows) ROWS="$2"; shift 2 ;;
+        --repeat) REPEAT="$2"; shift 2 ;;
+        --update-baseline) UPDATE_BASELINE=true; shift ;;
+        --no-gate) GATE=false; shift ;;
+        --hyperfine) HYPERFINE=true; shift ;;
+        *) echo "❌ Unknown option: $1"; exit 2 ;;
+    esac
+done
 
 echo "🚀 FlexonDB Performance Benchmarking"
 echo "===================================="
-echo "Binary: $BINARY"
-echo "Output: $OUTPUT_DIR"
+echo "Binaries: $BIN_DIR"
+echo "Output: $RUN_DIR"
+echo "Machine class: $MACHINE_CLASS"
 echo "Timestamp: $TIMESTAMP"
 echo ""
 
-# Create output directory
-mkdir -p "$OUTPUT_DIR"
-
-# Check if hyperfine is available, install if needed
-if ! command -v hyperfine &> /dev/null; then
-    echo "⚠️  Hyperfine not found. Install with:"
-    echo "   cargo install hyperfine"
-    echo "   # or on Ubuntu: sudo apt install hyperfine"
-    echo ""
-    echo "🔄 Falling back to manual benchmarks..."
-    
-    # Fallback manual benchmarks
-    echo "📊 Manual benchmark: Database creation..."
-    time $BINARY create test_bench.fxdb --schema 'id int32, name string, score float' 2>&1
-    
-    echo ""
-    echo "📈 Manual benchmark: Data insertion..."  
-    for i in {1..100}; do
-        $BINARY insert test_bench.fxdb --data "{\"id\": $i, \"name\": \"User$i\", \"score\": 95.5}" >/dev/null 2>&1
-    done
-    echo "Inserted 100 records"
-    
-    echo ""
-    echo "📖 Manual benchmark: Data reading..."
-    time $BINARY read test_bench.fxdb --limit 50 >/dev/null 2>&1
-    
-    rm -f test_bench.fxdb
-    echo "✅ Manual benchmarks complete!"
-    exit 0
-fi
-
-# Hyperfine is available, run proper benchmarks
-echo "✅ Hyperfine found, running comprehensive benchmarks..."
-echo ""
+for suite in $SUITES; do
+    if [ ! -x "$BIN_DIR/benchmark_$suite" ]; then
+        echo "❌ $BIN_DIR/benchmark_$suite not found"
+        echo "💡 Build with: cmake -S . -B build -DENABLE_TESTING=ON -DBUILD_BENCHMARKS=ON && cmake --build build --target benchmarks"
+        exit 2
+    fi
+done
 
-# Database creation benchmarks
-echo "📊 Benchmarking database creation..."
-hyperfine \
-    --export-json "$OUTPUT_DIR/benchmark_create_$TIMESTAMP.json" \
-    --warmup 3 \
-    --runs 50 \
-    --prepare "rm -f test_bench.fxdb" \
-    "$BINARY create test_bench.fxdb --schema 'id int32, name string, score float'"
+mkdir -p "$RUN_DIR"
 
-# Insertion benchmarks
-echo ""
-echo "📈 Benchmarking data insertion..."
-hyperfine \
-    --export-json "$OUTPUT_DIR/benchmark_insert_$TIMESTAMP.json" \
-    --warmup 3 \
-    --runs 100 \
-    --setup "$BINARY create test_insert.fxdb --schema 'id int32, name string, score float'" \
-    --cleanup "rm -f test_insert.fxdb" \
-    "$BINARY insert test_insert.fxdb --data '{\"id\": 1, \"name\": \"test\", \"score\": 95.5}'"
-
-# Read benchmarks (requires setup script)
-echo ""
-echo "📖 Benchmarking data reading..."
+# Benchmark programs, run inside the run directory so their scratch files stay there.
+# A process can be consistently fast or slow (memory layout, frequency, neighbours),
+# so each program runs several times and the gate pools the repeats: the first lands
+# in the run directory and the report, the others in repeat_<n>/.
+for suite in $SUITES; do
+    for repeat in $(seq 1 "$REPEAT"); do
+        json="$RUN_DIR/benchmark_$suite.json"
+        if [ "$repeat" -gt 1 ]; then
+            mkdir -p "$RUN_DIR/repeat_$repeat"
+            json="$RUN_DIR/repeat_$repeat/benchmark_$suite.json"
+        fi
+        echo "📊 Running benchmark_$suite ($repeat/$REPEAT)..."
+        (cd "$RUN_DIR" && "$BIN_DIR/benchmark_$suite" --rows "$ROWS" --runs "$RUNS" --warmup 2 \
+            --flexon "$BINARY" --json "$json")
+        echo ""
+    done
+done
 
-# Create setup script for large database
-cat > /tmp/setup_large_db.sh << 'EOF'
+# End-to-end CLI timings
+if [ "$HYPERFINE" = true ]; then
+    if ! command -v hyperfine &> /dev/null; then
+        echo "⚠️  Hyperfine not found; CLI timings skipped. Install with:"
+        echo "   cargo install hyperfine"
+        echo "   # or on Ubuntu: sudo apt install hyperfine"
+    else
+        echo "📈 Timing the CLI with hyperfine..."
+        cat > "$RUN_DIR/setup_cli_db.sh" << EOF
 #!/bin/bash
-rm -f large_test.fxdb
-../build/dist/linux/bin/flexon create large_test.fxdb --schema 'id int32, name string, score float, active bool'
+rm -f "$RUN_DIR/cli_test.fxdb"*
+"$BINARY" create "$RUN_DIR/cli_test.fxdb" --schema 'id int32, name string, score float, active bool' >/dev/null
 for i in {1..1000}; do
-    ../build/dist/linux/bin/flexon insert large_test.fxdb --data "{\"id\": $i, \"name\": \"User$i\", \"score\": 95.5, \"active\": true}" >/dev/null
+    "$BINARY" insert "$RUN_DIR/cli_test.fxdb" --data "{\"id\": \$i, \"name\": \"User\$i\", \"score\": 95.5, \"active\": true}" >/dev/null
 done
 EOF
-chmod +x /tmp/setup_large_db.sh
+        chmod +x "$RUN_DIR/setup_cli_db.sh"
 
-hyperfine \
-    --export-json "$OUTPUT_DIR/benchmark_read_$TIMESTAMP.json" \
-    --warmup 2 \
-    --runs 50 \
-    --setup "/tmp/setup_large_db.sh" \
-    --cleanup "rm -f large_test.fxdb" \
-    "$BINARY read large_test.fxdb --limit 100"
+        hyperfine \
+            --export-json "$RUN_DIR/benchmark_cli-create_$TIMESTAMP.json" \
+            --warmup 3 \
+            --runs 50 \
+            --prepare "rm -f $RUN_DIR/cli_create.fxdb" \
+            "$BINARY create $RUN_DIR/cli_create.fxdb --schema 'id int32, name string, score float'"
 
-# Export format benchmarks
-echo ""
-echo "📤 Benchmarking export formats..."
-hyperfine \
-    --export-json "$OUTPUT_DIR/benchmark_export_$TIMESTAMP.json" \
-    --warmup 2 \
-    --runs 30 \
-    --setup "/tmp/setup_large_db.sh" \
-    --cleanup "rm -f large_test.fxdb export_test.*" \
-    "$BINARY dump large_test.fxdb --format csv" \
-    "$BINARY dump large_test.fxdb --format json" \
-    "$BINARY dump large_test.fxdb --format table"
-
-# Cleanup
-rm -f /tmp/setup_large_db.sh
-
-# Check if Python is available for report generation
-if command -v python3 &> /dev/null; then
-    echo ""
-    echo "📋 Generating combined report..."
-    python3 scripts/generate_report.py "$OUTPUT_DIR" > "$OUTPUT_DIR/combined_benchmark_$TIMESTAMP.json"
-    echo "📊 Report saved to: $OUTPUT_DIR/combined_benchmark_$TIMESTAMP.json"
-else
+        hyperfine \
+            --export-json "$RUN_DIR/benchmark_cli-read_$TIMESTAMP.json" \
+            --warmup 2 \
+            --runs 50 \
+            --setup "$RUN_DIR/setup_cli_db.sh" \
+            "$BINARY read $RUN_DIR/cli_test.fxdb --limit 100"
+
+        rm -f "$RUN_DIR/setup_cli_db.sh" "$RUN_DIR/"cli_*.fxdb*
+    fi
     echo ""
-    echo "⚠️  Python3 not available for report generation"
+fi
+
+# Reports: this run, and the trend across every run kept in the output directory
+echo "📋 Generating reports..."
+python3 "$SCRIPT_DIR/generate_report.py" "$RUN_DIR" > "$OUTPUT_DIR/combined_benchmark_$TIMESTAMP.json"
+python3 "$SCRIPT_DIR/generate_report.py" --trend "$OUTPUT_DIR" > "$OUTPUT_DIR/trend_report.json"
+echo "📊 Report saved to: $OUTPUT_DIR/combined_benchmark_$TIMESTAMP.json"
+echo "📈 Trend report saved to: $OUTPUT_DIR/trend_report.json"
+echo ""
+
+if [ "$UPDATE_BASELINE" = true ]; then
+    python3 "$SCRIPT_DIR/compare_benchmarks.py" "$RUN_DIR" --baseline "$BASELINE" --update \
+        --machine-class "$MACHINE_CLASS"
+    exit 0
+fi
+
+# Regression gate
+echo "🔍 Comparing with the $MACHINE_CLASS baseline (threshold ${THRESHOLD}%, confidence $CONFIDENCE)..."
+status=0
+python3 "$SCRIPT_DIR/compare_benchmarks.py" "$RUN_DIR" --baseline "$BASELINE" \
+    --threshold "$THRESHOLD" --confidence "$CONFIDENCE" || status=$?
+
+if [ $status -eq 2 ]; then
+    echo "⚠️  No baseline for $MACHINE_CLASS; record one with --update-baseline"
+    exit 0
+elif [ $status -ne 0 ]; then
+    if [ "$GATE" = true ]; then
+        echo "❌ Performance regression against the baseline"
+        exit 1
+    fi
+    echo "⚠️  Performance regression against the baseline (not failing: --no-gate)"
 fi
 
 echo ""
-echo "✅ Benchmarking complete! Results in $OUTPUT_DIR/"
-echo "📁 Files created:"
-ls -la "$OUTPUT_DIR/"*"$TIMESTAMP"* 2>/dev/null || echo "   (No files with timestamp found)"
\ No newline at end of file
+echo "✅ Benchmarking complete! Results in $RUN_DIR/"
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+FlexonDB Benchmark Regression Gate
+Compares the results of the benchmark programs in tests/benchmarks against
+a stored baseline and flags slowdowns that are statistically significant:
+the lower end of the confidence interval of the slowdown must exceed the
+threshold, so noise between runs does not fail the gate. Runs of repeated
+processes are pooled so the interval also covers the variation between
+processes.
+"""
+
+import argparse
+import glob
+import json
+import math
+import sys
+from datetime import datetime
+from pathlib import Path
+
+def median(samples):
+    ordered = sorted(samples)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+def load_results(paths):
+    """Cases of benchmark result files, by name; the runs of a case repeated
+    in several files (separate processes) are pooled"""
+    cases, machine = {}, {}
+    for path in paths:
+        try:
+            with open(path, 'r') as f:
+                data = json.load(f)
+        except (FileNotFoundError, json.JSONDecodeError) as e:
+            print(f"Warning: Could not load {path}: {e}", file=sys.stderr)
+            continue
+        if 'suite' not in data:
+            continue
+        machine = data.get('machine', machine)
+        for result in data.get('results', []):
+            case = cases.setdefault(result['name'], {
+                'times_ms': [],
+                'processes': 0,
+                'parameters': {key: data.get('parameters', {}).get(key) for key in ('rows', 'width')}
+            })
+            case['times_ms'].extend(result.get('times_ms', []))
+            case['processes'] += 1
+
+    for case in cases.values():
+        if case['times_ms']:
+            case['p50_ms'] = median(case['times_ms'])
+            case['mean_ms'], variance = mean_and_variance(case['times_ms'])
+            case['stddev_ms'] = math.sqrt(variance)
+    return cases, machine
+
+def result_files(directory):
+    return sorted(glob.glob(str(Path(directory) / "benchmark_*.json")) +
+                  glob.glob(str(Path(directory) / "repeat_*" / "benchmark_*.json")))
+
+def mean_and_variance(samples):
+    n = len(samples)
+    mean = sum(samples) / n
+    variance = sum((x - mean) ** 2 for x in samples) / (n - 1) if n > 1 else 0.0
+    return mean, variance
+
+def beta_continued_fraction(a, b, x):
+    """Continued fraction of the incomplete beta function (modified Lentz)"""
+    tiny = 1e-30
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        for numerator in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                          -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+def incomplete_beta(a, b, x):
+    """Regularized incomplete beta I_x(a, b)"""
+    if x <= 0:
+        return 0.0
+    if x >= 1:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+                     a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1) / (a + b + 2):
+        return front * beta_continued_fraction(a, b, x) / a
+    return 1.0 - front * beta_continued_fraction(b, a, 1.0 - x) / b
+
+def t_cdf(t, df):
+    x = df / (df + t * t)
+    tail = 0.5 * incomplete_beta(df / 2.0, 0.5, x)
+    return 1.0 - tail if t > 0 else tail
+
+def t_quantile(p, df):
+    """Quantile of Student's t distribution, by bisection"""
+    low, high = 0.0, 1000.0
+    for _ in range(200):
+        mid = (low + high) / 2
+        if t_cdf(mid, df) < p:
+            low = mid
+        else:
+            high = mid
+    return (low + high) / 2
+
+def compare_case(baseline, current, confidence):
+    """Slowdown of the mean (as a fraction of the baseline mean) with its
+    Welch confidence interval; None when either side has too few runs"""
+    a, b = baseline['times_ms'], current['times_ms']
+    if len(a) < 2 or len(b) < 2:
+        return None
+    mean_a, var_a = mean_and_variance(a)
+    mean_b, var_b = mean_and_variance(b)
+    if mean_a <= 0:
+        return None
+
+    se2 = var_a / len(a) + var_b / len(b)
+    diff = mean_b - mean_a
+    if se2 == 0:
+        return diff / mean_a, diff / mean_a, diff / mean_a
+    df = se2 ** 2 / ((var_a / len(a)) ** 2 / (len(a) - 1) + (var_b / len(b)) ** 2 / (len(b) - 1))
+    margin = t_quantile(1 - (1 - confidence) / 2, df) * math.sqrt(se2)
+    return diff / mean_a, (diff - margin) / mean_a, (diff + margin) / mean_a
+
+def write_baseline(path, cases, machine, machine_class):
+    baseline = {
+        'machine_class': machine_class,
+        'machine': machine,
+        'recorded_at': datetime.now().isoformat(timespec='seconds'),
+        'benchmarks': cases
+    }
+    Path(path).parent.mkdir(parents=True, exist_ok=True)
+    with open(path, 'w') as f:
+        json.dump(baseline, f, indent=2)
+        f.write('\n')
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare benchmark results against a baseline")
+    parser.add_argument('results', help="Directory of benchmark_*.json files written with --json "
+                                        "(repeats in its repeat_*/ subdirectories are pooled)")
+    parser.add_argument('--baseline', required=True, help="Baseline JSON of the machine class")
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help="Slowdown in percent that fails the gate (default 10)")
+    parser.add_argument('--confidence', type=float, default=0.95,
+                        help="Confidence level of the interval (default 0.95)")
+    parser.add_argument('--update', action='store_true', help="Write the results as the new baseline")
+    parser.add_argument('--machine-class', default='', help="Machine class recorded in a new baseline")
+    args = parser.parse_args()
+
+    current, machine = load_results(result_files(args.results))
+    if not current:
+        print(f"Error: No benchmark results in {args.results}", file=sys.stderr)
+        return 2
+
+    if args.update:
+        write_baseline(args.baseline, current, machine, args.machine_class)
+        print(f"Baseline written to {args.baseline} ({len(current)} cases)")
+        return 0
+
+    try:
+        with open(args.baseline, 'r') as f:
+            baseline = json.load(f).get('benchmarks', {})
+    except (FileNotFoundError, json.JSONDecodeError) as e:
+        print(f"Error: Could not load baseline {args.baseline}: {e}", file=sys.stderr)
+        print("Record one with --update on this machine class", file=sys.stderr)
+        return 2
+
+    threshold = args.threshold / 100.0
+    regressions = 0
+    print(f"{'case':<28} {'base p50':>10} {'now p50':>10} {'change':>8}   "
+          f"{int(args.confidence * 100)}% interval      verdict")
+    for name in sorted(current):
+        if name not in baseline:
+            print(f"{name:<28} {'-':>10} {current[name]['p50_ms']:>9.3f}ms {'':>8}   {'':<20} new")
+            continue
+        base, now = baseline[name], current[name]
+        if base.get('parameters') != now['parameters']:
+            print(f"{name:<28} parameters differ from the baseline; skipped")
+            continue
+
+        change = compare_case(base, now, args.confidence)
+        if change is None:
+            print(f"{name:<28} too few runs to compare; skipped")
+            continue
+        estimate, low, high = change
+        if low > threshold:
+            verdict = "REGRESSION"
+            regressions += 1
+        elif low > 0:
+            verdict = "slower"
+        elif high < 0:
+            verdict = "faster"
+        else:
+            verdict = "ok"
+        print(f"{name:<28} {base['p50_ms']:>8.3f}ms {now['p50_ms']:>8.3f}ms {estimate * 100:>+7.1f}%   "
+              f"[{low * 100:>+6.1f}%, {high * 100:>+6.1f}%]   {verdict}")
+
+    for name in sorted(set(baseline) - set(current)):
+        print(f"{name:<28} missing from this run")
+
+    if regressions:
+        print(f"\n{regressions} case(s) slower than the baseline by more than {args.threshold:g}%")
+        return 1
+    print(f"\nNo case slower than the baseline by more than {args.threshold:g}%")
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
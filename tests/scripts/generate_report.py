@@ -1,7 +1,9 @@
 #!/usr/bin/env python3
 """
 FlexonDB Benchmark Report Generator
-Combines hyperfine JSON outputs into a comprehensive performance report
+Combines hyperfine JSON outputs and the JSON results of the benchmark
+programs in tests/benchmarks (--json FILE) into a comprehensive
+performance report
 """
 
 import json
@@ -36,6 +38,30 @@ def extract_hyperfine_stats(data):
         'parameters': results.get('parameters', {})
     }
 
+def extract_suite_stats(data):
+    """Extract per-case statistics from a tests/benchmarks result file"""
+    if not data or 'suite' not in data:
+        return None
+    
+    cases = {}
+    for result in data.get('results', []):
+        name = result['name']
+        cases[name] = {
+            'command': name,
+            'mean_ms': result.get('mean_ms', 0),
+            'stddev_ms': result.get('stddev_ms', 0),
+            'min_ms': result.get('min_ms', 0),
+            'max_ms': result.get('max_ms', 0),
+            'p50_ms': result.get('p50_ms', 0),
+            'p90_ms': result.get('p90_ms', 0),
+            'p99_ms': result.get('p99_ms', 0),
+            'rows_per_sec': result.get('rows_per_sec', 0),
+            'mb_per_sec': result.get('mb_per_sec', 0),
+            'runs': result.get('runs', len(result.get('times_ms', []))),
+            'parameters': data.get('parameters', {})
+        }
+    return cases
+
 def generate_combined_report(output_dir):
     """Generate a combined benchmark report from all JSON files in output_dir"""
     output_path = Path(output_dir)
@@ -66,7 +92,16 @@ def generate_combined_report(output_dir):
         benchmark_type = filename.split('_')[1]  # extract 'create', 'insert', etc.
         
         data = load_json_file(json_file)
-        if data:
+        if data and 'suite' in data:
+            # One entry per case of a benchmark program
+            combined_report['metadata'].setdefault('machine', data.get('machine', {}))
+            for name, stats in extract_suite_stats(data).items():
+                combined_report['benchmarks'][name] = {
+                    'source_file': filename,
+                    'statistics': stats,
+                    'performance_category': categorize_performance(stats['mean_ms'])
+                }
+        elif data:
             stats = extract_hyperfine_stats(data)
             if stats:
                 combined_report['benchmarks'][benchmark_type] = {
@@ -117,14 +152,50 @@ def generate_summary(benchmarks):
         }
     }
 
+def generate_trend_report(output_dir):
+    """Follow each benchmark across the combined reports kept in output_dir"""
+    reports = sorted(glob.glob(str(Path(output_dir) / "combined_benchmark_*.json")))
+    trend = {
+        'metadata': {
+            'generated_at': datetime.now().isoformat(),
+            'output_directory': str(output_dir),
+            'reports': len(reports)
+        },
+        'benchmarks': {}
+    }
+    
+    for report_file in reports:
+        report = load_json_file(report_file)
+        if not report:
+            continue
+        generated_at = report.get('metadata', {}).get('generated_at', Path(report_file).name)
+        for name, entry in report.get('benchmarks', {}).items():
+            stats = entry['statistics']
+            trend['benchmarks'].setdefault(name, {'history': []})['history'].append({
+                'generated_at': generated_at,
+                'mean_ms': stats['mean_ms'],
+                'p50_ms': stats.get('p50_ms', stats['mean_ms'])
+            })
+    
+    # Change of the median over the whole history and since the previous report
+    for series in trend['benchmarks'].values():
+        history = series['history']
+        first, last = history[0]['p50_ms'], history[-1]['p50_ms']
+        previous = history[-2]['p50_ms'] if len(history) > 1 else last
+        series['change_pct'] = (last - first) / first * 100 if first > 0 else 0.0
+        series['last_change_pct'] = (last - previous) / previous * 100 if previous > 0 else 0.0
+    
+    return trend if reports else None
+
 def main():
-    if len(sys.argv) != 2:
-        print("Usage: python3 generate_report.py <output_directory>", file=sys.stderr)
+    if len(sys.argv) == 3 and sys.argv[1] == '--trend':
+        report = generate_trend_report(sys.argv[2])
+    elif len(sys.argv) == 2:
+        report = generate_combined_report(sys.argv[1])
+    else:
+        print("Usage: python3 generate_report.py [--trend] <output_directory>", file=sys.stderr)
         sys.exit(1)
     
-    output_dir = sys.argv[1]
-    report = generate_combined_report(output_dir)
-    
     if report:
         print(json.dumps(report, indent=2))
     else:
@@ -131,5 +131,53 @@ float generate_test_float(float min, float max) {
 
 // Test database helpers
 void cleanup_test_files(void) {
-    system("rm -f test_*.fxdb benchmark_*.fxdb");
-}
\ No newline at end of file
+    system("rm -f test_*.fxdb test_*.fxdb.wal test_*.fxdb.del test_*.fxdb.shm test_*.fxdb.sum "
+           "benchmark_*.fxdb benchmark_*.fxdb.wal benchmark_*.fxdb.del benchmark_*.fxdb.shm benchmark_*.fxdb.sum");
+}
+
+void test_row_id(int index, char* json, size_t size) {
+    snprintf(json, size, "{\"id\": %d}", index);
+}
+
+void test_row_id_name(int index, char* json, size_t size) {
+    snprintf(json, size, "{\"id\": %d, \"name\": \"row%d\"}", index, index);
+}
+
+int test_append_rows(writer_t* writer, int first, int last, int commit_every, test_row_fn row) {
+    char json[256];
+    for (int i = first; writer && i <= last; i++) {
+        row(i, json, sizeof(json));
+        if (writer_insert_json(writer, json) != 0 ||
+            (commit_every > 0 && (i + 1) % commit_every == 0 && writer_commit(writer) != 0)) {
+            return -1;
+        }
+    }
+    return writer ? 0 : -1;
+}
+
+int test_write_file(const char* path, const schema_t* schema, uint32_t chunk_size, int rows, test_row_fn row) {
+    writer_config_t config = writer_default_config();
+    config.chunk_size = chunk_size;
+    return test_write_file_with_config(path, schema, &config, rows, 0, row);
+}
+
+int test_write_file_with_config(const char* path, const schema_t* schema, const writer_config_t* config,
+                                int rows, int commit_every, test_row_fn row) {
+    writer_t* writer = writer_create(path, schema, config);
+    int result = test_append_rows(writer, 0, rows - 1, commit_every, row);
+    if (writer && writer_close(writer) != 0) {
+        result = -1;
+    }
+    writer_free(writer);
+    return result;
+}
+
+int test_append_file(const char* path, const writer_config_t* config, int first, int last, test_row_fn row) {
+    writer_t* writer = writer_open_with_config(path, config);
+    int result = test_append_rows(writer, first, last, 0, row);
+    if (writer && writer_close(writer) != 0) {
+        result = -1;
+    }
+    writer_free(writer);
+    return result;
+}
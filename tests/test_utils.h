@@ -1,6 +1,7 @@
 #ifndef TEST_UTILS_H
 #define TEST_UTILS_H
 
+#include "../include/writer.h"
 #include <stdbool.h>
 #include <time.h>
 
@@ -32,4 +33,26 @@ float generate_test_float(float min, float max);
 // Test database helpers
 void cleanup_test_files(void);
 
+// Writes the JSON of the row with the given index
+typedef void (*test_row_fn)(int index, char* json, size_t size);
+
+// {"id": index}
+void test_row_id(int index, char* json, size_t size);
+
+// {"id": index, "name": "row<index>"}
+void test_row_id_name(int index, char* json, size_t size);
+
+// Insert rows first..last, committing after every commit_every rows (0: never)
+int test_append_rows(writer_t* writer, int first, int last, int commit_every, test_row_fn row);
+
+// Create a database of rows 0..rows - 1 in chunks of chunk_size rows
+int test_write_file(const char* path, const schema_t* schema, uint32_t chunk_size, int rows, test_row_fn row);
+
+// Create a database of rows 0..rows - 1 with a writer configuration
+int test_write_file_with_config(const char* path, const schema_t* schema, const writer_config_t* config,
+                                int rows, int commit_every, test_row_fn row);
+
+// Open an existing database and append rows first..last in one writer session
+int test_append_file(const char* path, const writer_config_t* config, int first, int last, test_row_fn row);
+
 #endif // TEST_UTILS_H
\ No newline at end of file
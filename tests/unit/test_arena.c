@@ -0,0 +1,151 @@
+#include "../test_utils.h"
+#include "../../include/arena.h"
+#include "../../include/stats.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_ARENA_FILE "test_arena.fxdb"
+
+static bool aligned(const void* memory) {
+    return ((uintptr_t)memory & (FXDB_ARENA_ALIGNMENT - 1)) == 0;
+}
+
+int main(void) {
+    test_init("Arena Tests");
+
+    // Test 1: Allocations are aligned and the arena grows past its first block
+    printf("Test 1: Alignment and growth\n");
+    fxdb_arena_t* arena = fxdb_arena_create(256);
+    test_assert_not_null(arena, "Create arena");
+    if (!arena) {
+        return test_finalize();
+    }
+    void* a = fxdb_arena_alloc(arena, 3);
+    void* b = fxdb_arena_alloc(arena, 1);
+    test_assert(aligned(a) && aligned(b) && (uint8_t*)b - (uint8_t*)a == FXDB_ARENA_ALIGNMENT,
+                "Small allocations aligned and packed");
+    uint8_t* large = fxdb_arena_alloc(arena, 10000);
+    test_assert(large != NULL && aligned(large), "Allocation larger than a block");
+    memset(large, 0xab, 10000);
+    test_assert(arena->blocks != NULL, "New block added");
+
+    // Test 2: Rewinding takes back what came after the mark
+    printf("Test 2: Mark and rewind\n");
+    fxdb_arena_alloc(arena, 16); // Into a block with room after the full one
+    fxdb_arena_mark_t mark = fxdb_arena_mark(arena);
+    void* first = fxdb_arena_alloc(arena, 64);
+    fxdb_arena_alloc(arena, 100000);
+    fxdb_arena_rewind(arena, mark);
+    test_assert(fxdb_arena_alloc(arena, 64) == first, "Memory reused after rewind");
+
+    // Test 3: Strings and zeroed memory
+    printf("Test 3: Strings\n");
+    char* copy = fxdb_arena_strdup(arena, "flexon");
+    test_assert(copy && strcmp(copy, "flexon") == 0, "strdup copies");
+    char* prefix = fxdb_arena_strndup(arena, "flexon", 4);
+    test_assert(prefix && strcmp(prefix, "flex") == 0, "strndup stops at length");
+    char* whole = fxdb_arena_strndup(arena, "db", 10);
+    test_assert(whole && strcmp(whole, "db") == 0, "strndup stops at the terminator");
+    int* zeros = fxdb_arena_calloc(arena, 8, sizeof(int));
+    bool all_zero = zeros != NULL;
+    for (int i = 0; zeros && i < 8; i++) {
+        all_zero = all_zero && zeros[i] == 0;
+    }
+    test_assert(all_zero, "calloc zeroes");
+
+    // Test 4: Reset keeps only the first block
+    printf("Test 4: Reset\n");
+    fxdb_arena_reset(arena);
+    test_assert(arena->blocks == NULL, "Added blocks freed");
+    test_assert(fxdb_arena_alloc(arena, 3) == a, "First block reused");
+    fxdb_arena_destroy(arena);
+
+    // Test 5: An arena in caller storage only mallocs once it is full
+    printf("Test 5: Caller storage\n");
+    fxdb_reset_statistics();
+    uint8_t scratch[512];
+    fxdb_arena_t stack_arena;
+    fxdb_arena_init(&stack_arena, scratch, sizeof(scratch));
+    for (int i = 0; i < 8; i++) {
+        fxdb_arena_alloc(&stack_arena, 32);
+    }
+    db_statistics_t stats;
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(0, (int)stats.allocations, "No allocations within the buffer");
+    uint8_t* spilled = fxdb_arena_alloc(&stack_arena, 1024);
+    test_assert(spilled != NULL && (spilled < scratch || spilled >= scratch + sizeof(scratch)),
+                "Spills into a block");
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(1, (int)stats.allocations, "One block allocated");
+    fxdb_arena_release(&stack_arena);
+    test_assert(stack_arena.blocks == NULL, "Release frees blocks");
+
+    // Test 6: A slab pool reuses freed objects
+    printf("Test 6: Slab pool\n");
+    fxdb_slab_pool_t pool;
+    fxdb_slab_pool_init(&pool, 40, 4);
+    test_assert_equal_int(48, (int)pool.object_size, "Object size rounded to alignment");
+    void* objects[6];
+    for (int i = 0; i < 6; i++) {
+        objects[i] = fxdb_slab_alloc(&pool);
+    }
+    test_assert_equal_int(6, (int)pool.in_use, "Six objects in use");
+    test_assert(objects[0] && objects[5] && aligned(objects[5]), "Second slab aligned");
+    fxdb_slab_free(&pool, objects[2]);
+    test_assert(fxdb_slab_alloc(&pool) == objects[2], "Freed object reused");
+    fxdb_slab_free(&pool, objects[0]);
+    fxdb_slab_free(&pool, NULL);
+    test_assert_equal_int(5, (int)pool.in_use, "Frees counted");
+    fxdb_slab_pool_destroy(&pool);
+    test_assert(pool.slabs == NULL && pool.in_use == 0, "Pool destroyed");
+
+    // Test 7: Reader rows from arenas and the row pool
+    printf("Test 7: Reader rows\n");
+    cleanup_test_files();
+    schema_t* schema = parse_schema("id int32, name string");
+    test_assert_not_null(schema, "Schema creation");
+    test_assert_equal_int(0, schema ? test_write_file(TEST_ARENA_FILE, schema, 10, 35, test_row_id_name) : -1,
+                          "Write 35 rows");
+    if (schema) {
+        free_schema(schema);
+    }
+
+    reader_t* reader = reader_open(TEST_ARENA_FILE);
+    test_assert_not_null(reader, "Open reader");
+    if (!reader) {
+        cleanup_test_files();
+        return test_finalize();
+    }
+
+    query_result_t* result = reader_read_rows(reader, 100);
+    test_assert(result && result->arena && result->row_count == 35, "All rows in one arena");
+    test_assert(result && strcmp(result->rows[34].values[1].value.string_val, "row34") == 0, "Strings decoded");
+    reader_free_result(result);
+
+    reader_rewind(reader);
+    row_data_t* pooled = reader_read_row_pooled(reader);
+    row_data_t* second = reader_read_row_pooled(reader);
+    test_assert(pooled && second && pooled->values[0].value.int32_val == 0 &&
+                second->values[0].value.int32_val == 1, "Pooled rows decoded");
+    test_assert(pooled && strcmp(pooled->values[1].value.string_val, "row0") == 0, "Pooled strings decoded");
+    reader_release_row(reader, pooled);
+    test_assert(reader_read_row_pooled(reader) == pooled, "Released buffer reused");
+    test_assert_equal_int(2, (int)reader->row_pool.in_use, "Two buffers in use");
+    reader_release_row(reader, pooled);
+    reader_release_row(reader, second);
+
+    fxdb_arena_t* row_arena = fxdb_arena_create(0);
+    row_data_t row;
+    test_assert(row_arena && reader_read_row_into(reader, row_arena, &row) == 0, "Row read into an arena");
+    test_assert(row.values && row.values[0].value.int32_val == 3 &&
+                strcmp(row.values[1].value.string_val, "row3") == 0, "Arena row decoded");
+    fxdb_arena_destroy(row_arena);
+
+    reader_close(reader);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,96 @@
+#include "../test_utils.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CACHE_FILE "test_chunk_cache.fxdb"
+
+// Ids from 1000, to tell a rewritten file from the first
+static void shifted_row(int index, char* json, size_t size) {
+    test_row_id(1000 + index, json, size);
+}
+
+static int first_id(void) {
+    reader_t* reader = reader_open(TEST_CACHE_FILE);
+    if (!reader) {
+        return -1;
+    }
+    row_data_t* row = reader_read_row(reader);
+    int id = row ? row->values[0].value.int32_val : -1;
+    reader_free_row(row);
+    reader_close(reader);
+    return id;
+}
+
+int main(void) {
+    test_init("Chunk Cache Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32");
+    test_assert_not_null(schema, "Schema creation");
+    test_assert_equal_int(0, schema ? test_write_file(TEST_CACHE_FILE, schema, 10, 35, test_row_id) : -1,
+                          "Write 4 chunks");
+
+    // Test 1: A second reader is served from the cache
+    printf("Test 1: Shared cache hits\n");
+    db_statistics_t before = {0}, after = {0};
+    fxdb_chunk_cache_get_statistics(&before);
+
+    // Without read-ahead, so every chunk is looked up by the scan itself
+    reader_t* first = reader_open(TEST_CACHE_FILE);
+    reader_set_read_ahead(first, 0);
+    query_result_t* result = first ? reader_read_rows(first, 35) : NULL;
+    test_assert(result && result->row_count == 35, "First reader reads every row");
+    reader_free_result(result);
+
+    reader_t* second = reader_open(TEST_CACHE_FILE);
+    reader_set_read_ahead(second, 0);
+    result = second ? reader_read_rows(second, 35) : NULL;
+    test_assert(result && result->row_count == 35, "Second reader reads every row");
+    if (result) {
+        test_assert_equal_int(34, result->rows[34].values[0].value.int32_val, "Cached rows are intact");
+    }
+    reader_free_result(result);
+    reader_close(first);
+    reader_close(second);
+
+    fxdb_chunk_cache_get_statistics(&after);
+    test_assert_equal_int(4, (int)(after.cache_misses - before.cache_misses), "Each chunk misses once");
+    test_assert_equal_int(4, (int)(after.cache_hits - before.cache_hits), "Second pass hits every chunk");
+    test_assert(after.memory_usage > 0, "Cache memory is accounted");
+
+    // Test 2: Rewriting the file bumps the generation, so stale chunks are not served
+    printf("Test 2: Generation invalidation\n");
+    test_assert_equal_int(0, first_id(), "Original contents");
+    test_assert_equal_int(0, test_write_file(TEST_CACHE_FILE, schema, 10, 35, shifted_row), "Rewrite file");
+    test_assert_equal_int(1000, first_id(), "Rewritten contents are read");
+
+    // Test 3: Budget and pinning
+    printf("Test 3: Budget and pinning\n");
+    reader_t* pinned = reader_open(TEST_CACHE_FILE);
+    row_data_t* row = pinned ? reader_read_row(pinned) : NULL;
+    reader_free_row(row);
+    fxdb_chunk_cache_set_budget(0);
+    fxdb_chunk_cache_get_statistics(&after);
+    test_assert(after.memory_usage > 0, "Pinned chunk survives a zero budget");
+    row = pinned ? reader_read_row(pinned) : NULL;
+    test_assert(row && row->values[0].value.int32_val == 1001, "Pinned chunk is still readable");
+    reader_free_row(row);
+    reader_close(pinned);
+    fxdb_chunk_cache_get_statistics(&after);
+    test_assert_equal_int(0, (int)after.memory_usage, "Released chunk is evicted");
+
+    test_assert_equal_int(1000, first_id(), "Reads work with caching disabled");
+    fxdb_chunk_cache_set_budget(FXDB_CHUNK_CACHE_BYTES);
+
+    if (schema) {
+        free_schema(schema);
+    }
+
+    cleanup_test_files();
+    return test_finalize();
+}
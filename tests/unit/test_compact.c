@@ -0,0 +1,245 @@
+#include "../test_utils.h"
+#include "../../include/compact.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_COMPACT_FILE "test_compact.fxdb"
+#define TEST_COMPACT_COPY "test_compact_copy.fxdb"
+
+// Ids run backwards in the name so sorting by name reverses the order
+static void compact_row(int id, char* json, size_t size) {
+    if (id % 4 == 0) {
+        snprintf(json, size, "{\"id\": %d, \"name\": \"n%03d\", \"score\": null}", id, 100 - id);
+    } else {
+        snprintf(json, size, "{\"id\": %d, \"name\": \"n%03d\", \"score\": %d}", id, 100 - id, id * 2);
+    }
+}
+
+// Append rows first..last in one writer session, like one shell insert each
+static int append_rows(const writer_config_t* config, int first, int last) {
+    return test_append_file(TEST_COMPACT_FILE, config, first, last, compact_row);
+}
+
+// Delete the rows whose id is a multiple of three
+static int delete_multiples_of_three(void) {
+    reader_t* reader = reader_open(TEST_COMPACT_FILE);
+    if (!reader) {
+        return -1;
+    }
+
+    row_position_t positions[64];
+    uint32_t count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        if (row->values[0].value.int32_val % 3 == 0 && count < 64 &&
+            reader_row_position(reader, &positions[count]) == 0) {
+            count++;
+        }
+        free((char*)row->values[1].value.string_val);
+        reader_free_row(row);
+    }
+
+    int result = reader_delete_rows(reader, positions, count);
+    reader_close(reader);
+    return result;
+}
+
+// Read the ids of a file in scan order, checking NULLs and values on the way
+static int read_ids(const char* path, int* ids, int max) {
+    reader_t* reader = reader_open(path);
+    if (!reader) {
+        return -1;
+    }
+
+    int count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        int id = row->values[0].value.int32_val;
+        bool ok = row->values[2].is_null == (id % 4 == 0) &&
+                  (row->values[2].is_null || row->values[2].value.int32_val == id * 2);
+        if (count < max) {
+            ids[count] = ok ? id : -1;
+        }
+        count++;
+        free((char*)row->values[1].value.string_val);
+        reader_free_row(row);
+    }
+    reader_close(reader);
+    return count;
+}
+
+static bool file_exists(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        fclose(file);
+    }
+    return file != NULL;
+}
+
+// Whether two files have the same bytes
+static bool files_equal(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    bool equal = fa && fb;
+    while (equal) {
+        int ca = fgetc(fa);
+        int cb = fgetc(fb);
+        equal = ca == cb;
+        if (ca == EOF || cb == EOF) {
+            break;
+        }
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return equal;
+}
+
+static int copy_file(const char* from, const char* to) {
+    FILE* in = fopen(from, "rb");
+    FILE* out = fopen(to, "wb");
+    int result = (in && out) ? 0 : -1;
+    char buffer[4096];
+    size_t n;
+    while (result == 0 && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (fwrite(buffer, 1, n, out) != n) {
+            result = -1;
+        }
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+    return result;
+}
+
+int main(void) {
+    test_init("Compaction Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32, name string, score int32?");
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 8;
+    int created = schema ? test_write_file(TEST_COMPACT_FILE, schema, 8, 0, compact_row) : -1;
+    test_assert_equal_int(0, created, "Create database");
+    if (created != 0) {
+        free_schema(schema);
+        return test_finalize();
+    }
+
+    // Ten short writer sessions leave ten undersized chunks, then three logged rows
+    int result = 0;
+    for (int i = 0; i < 10; i++) {
+        result |= append_rows(&config, i * 3, i * 3 + 2);
+    }
+    writer_config_t wal_config = config;
+    wal_config.use_wal = true;
+    result |= append_rows(&wal_config, 30, 32);
+    test_assert_equal_int(0, result, "Write 33 rows in 11 sessions");
+    test_assert_equal_int(0, delete_multiples_of_three(), "Delete every third row");
+
+    reader_t* before = reader_open(TEST_COMPACT_FILE);
+    uint32_t old_generation = before ? before->header.generation : 0;
+
+    // Test 1: Chunks are merged, deleted rows dropped and the log folded in
+    printf("Test 1: Compact\n");
+    compact_options_t options = compact_default_options();
+    options.threads = 4;
+    compact_stats_t stats;
+    test_assert_equal_int(0, compact_database(TEST_COMPACT_FILE, &options, &stats), "Compact database");
+    test_assert_equal_int(11, (int)stats.chunks_before, "Ten chunks and the log before");
+    test_assert_equal_int(3, (int)stats.chunks_after, "22 rows in three chunks after");
+    test_assert_equal_int(33, (int)stats.rows_before, "Stored rows before");
+    test_assert_equal_int(22, (int)stats.rows_after, "Live rows after");
+    test_assert(!file_exists(TEST_COMPACT_FILE ".wal") && !file_exists(TEST_COMPACT_FILE ".del"),
+                "Sidecars removed");
+
+    int ids[64];
+    int count = read_ids(TEST_COMPACT_FILE, ids, 64);
+    bool in_order = count == 22;
+    for (int i = 0, expected = 1; in_order && i < count; i++, expected++) {
+        if (expected % 3 == 0) {
+            expected++;
+        }
+        in_order = ids[i] == expected;
+    }
+    test_assert(in_order, "Live rows kept in order with their NULLs");
+
+    reader_t* after = reader_open(TEST_COMPACT_FILE);
+    test_assert(after && after->header.generation == old_generation + 1, "New generation");
+    test_assert(after && after->header.chunk_count == 3 && reader_get_deleted_count(after) == 0,
+                "Header recomputed");
+    reader_close(after);
+
+    // Test 2: A reader of the old file keeps its snapshot
+    printf("Test 2: Old readers\n");
+    uint32_t old_rows = before ? reader_get_row_count(before) : 0;
+    count = 0;
+    row_data_t* row;
+    while (before && (row = reader_read_row(before)) != NULL) {
+        count++;
+        free((char*)row->values[1].value.string_val);
+        reader_free_row(row);
+    }
+    test_assert(before && count == 22 && old_rows == 22, "Old reader still scans its file");
+    test_assert(before && reader_refresh(before) != 0, "Refresh asks for a reopen");
+    reader_close(before);
+
+    // Test 3: Sorting by a key, with NULLs first
+    printf("Test 3: Sort by key\n");
+    options.sort_field = 1;
+    test_assert_equal_int(0, compact_database(TEST_COMPACT_FILE, &options, NULL), "Compact by name");
+    count = read_ids(TEST_COMPACT_FILE, ids, 64);
+    bool descending = count == 22;
+    for (int i = 1; descending && i < count; i++) {
+        descending = ids[i - 1] > ids[i];
+    }
+    test_assert(descending, "Rows ordered by name");
+
+    // A budget of a few rows makes the sort spill runs and merge them
+    options.sort_field = 2;
+    options.chunk_size = 5;
+    options.sort_memory = 1024;
+    test_assert_equal_int(0, compact_database(TEST_COMPACT_FILE, &options, &stats), "Compact by nullable score");
+    test_assert_equal_int(5, (int)stats.chunks_after, "New chunk size applied");
+    test_assert(stats.sort_runs > 1, "Sort spilled runs");
+    count = read_ids(TEST_COMPACT_FILE, ids, 64);
+    bool nulls_first = count == 22;
+    int nulls = 0;
+    while (nulls < count && ids[nulls] % 4 == 0) {
+        nulls++;
+    }
+    for (int i = nulls + 1; nulls_first && i < count; i++) {
+        nulls_first = ids[i - 1] < ids[i];
+    }
+    test_assert(nulls_first && nulls == 6, "NULL scores first, then ascending");
+
+    // Test 4: The result does not depend on the number of threads
+    printf("Test 4: Deterministic output\n");
+    options = compact_default_options();
+    options.sort_field = 1;
+    options.threads = 1;
+    test_assert_equal_int(0, copy_file(TEST_COMPACT_FILE, TEST_COMPACT_COPY), "Copy database");
+    compact_database(TEST_COMPACT_FILE, &options, NULL);
+    options.threads = 8;
+    compact_database(TEST_COMPACT_COPY, &options, NULL);
+    reader_t* a = reader_open(TEST_COMPACT_FILE);
+    reader_t* b = reader_open(TEST_COMPACT_COPY);
+    uint32_t gen_a = a ? a->header.generation : 0;
+    uint32_t gen_b = b ? b->header.generation : 1;
+    reader_close(a);
+    reader_close(b);
+    test_assert(gen_a == gen_b && files_equal(TEST_COMPACT_FILE, TEST_COMPACT_COPY), "One and eight threads agree");
+
+    // Test 5: Writers append to a compacted file as usual
+    printf("Test 5: Append after compaction\n");
+    test_assert_equal_int(0, append_rows(&config, 40, 41), "Append two rows");
+    count = read_ids(TEST_COMPACT_FILE, ids, 64);
+    test_assert(count == 24 && ids[22] == 40 && ids[23] == 41, "Appended rows follow the compacted ones");
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,197 @@
+#include "../test_utils.h"
+#include "../../include/coord.h"
+#include "../../include/compact.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#define TEST_COORD_FILE "test_coord.fxdb"
+#define TEST_COORD_SHM TEST_COORD_FILE ".shm"
+
+static int insert_ids(writer_t* writer, int first, int last) {
+    return test_append_rows(writer, first, last, 0, test_row_id) == 0 ? writer_commit(writer) : -1;
+}
+
+static writer_t* open_no_wait(void) {
+    writer_config_t config = writer_default_config();
+    config.lock_timeout_ms = 0;
+    return writer_open_with_config(TEST_COORD_FILE, &config);
+}
+
+static int count_rows(void) {
+    reader_t* reader = reader_open(TEST_COORD_FILE);
+    int count = reader ? (int)reader_get_row_count(reader) : -1;
+    reader_close(reader);
+    return count;
+}
+
+// Pid the sidecar names as the writer
+static uint32_t published_pid(void) {
+    fxdb_coord_t* coord = coord_attach(TEST_COORD_FILE, false);
+    uint32_t pid = coord ? coord->shm->writer_pid : 0;
+    coord_detach(coord);
+    return pid;
+}
+
+// Writer that holds the lock for a while, then closes
+static void* slow_writer(void* arg) {
+    writer_t* writer = (writer_t*)arg;
+    struct timespec delay = { 0, 100 * 1000000L };
+    nanosleep(&delay, NULL);
+    insert_ids(writer, 100, 104);
+    writer_close(writer);
+    writer_free(writer);
+    return NULL;
+}
+
+// Child process: open a writer, then commit rows when the parent asks
+static void run_child(int to_parent, int from_parent) {
+    writer_t* writer = writer_open(TEST_COORD_FILE);
+    char token = writer ? 'o' : 'x';
+    if (write(to_parent, &token, 1) != 1 || !writer) {
+        _exit(1);
+    }
+
+    int status = 0;
+    if (read(from_parent, &token, 1) != 1 || insert_ids(writer, 200, 209) != 0) {
+        status = 1;
+    }
+    token = 'c';
+    if (write(to_parent, &token, 1) != 1 || read(from_parent, &token, 1) != 1) {
+        status = 1;
+    }
+    if (writer_close(writer) != 0) {
+        status = 1;
+    }
+    writer_free(writer);
+    _exit(status);
+}
+
+int main(void) {
+    test_init("Writer Coordination Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32");
+    writer_t* writer = schema ? writer_create_default(TEST_COORD_FILE, schema) : NULL;
+    test_assert_not_null(writer, "Create database");
+    if (!writer) {
+        free_schema(schema);
+        return test_finalize();
+    }
+
+    // Test 1: One writer at a time within a process
+    printf("Test 1: Writer lock\n");
+    test_assert_equal_int(0, insert_ids(writer, 0, 9), "First writer commits");
+    writer_t* second = open_no_wait();
+    test_assert(second == NULL, "Second writer refused");
+    writer_free(second);
+
+    writer_config_t config = writer_default_config();
+    config.lock_timeout_ms = 0;
+    second = writer_create(TEST_COORD_FILE, schema, &config);
+    test_assert(second == NULL && count_rows() == 10, "Recreating the file refused without truncating it");
+    writer_free(second);
+    test_assert(compact_database(TEST_COORD_FILE, NULL, NULL) != 0, "Compaction refused");
+    test_assert(published_pid() == (uint32_t)getpid(), "Sidecar names the writer");
+
+    // Test 2: A waiting writer gets the lock once the holder closes
+    printf("Test 2: Lock wait\n");
+    pthread_t thread;
+    pthread_create(&thread, NULL, slow_writer, writer);
+    config.lock_timeout_ms = 5000;
+    second = writer_open_with_config(TEST_COORD_FILE, &config);
+    pthread_join(thread, NULL);
+    test_assert_not_null(second, "Waiting writer opened");
+    test_assert(second && insert_ids(second, 105, 109) == 0, "Waiting writer commits after the holder");
+    writer_close(second);
+    writer_free(second);
+    test_assert_equal_int(20, count_rows(), "Both writers' rows kept");
+    test_assert(published_pid() == 0, "Pid cleared on close");
+
+    // Test 3: Readers poll commits of a writer in another process
+    printf("Test 3: Cross-process polling\n");
+    reader_t* reader = reader_open(TEST_COORD_FILE);
+    uint32_t committed = 0;
+    test_assert(reader && reader_poll(reader, &committed) == 0 && committed == 20, "Nothing new after open");
+
+    int to_parent[2], from_parent[2];
+    pid_t child = -1;
+    if (pipe(to_parent) == 0 && pipe(from_parent) == 0) {
+        child = fork();
+        if (child == 0) {
+            run_child(to_parent[1], from_parent[0]);
+        }
+    }
+
+    char token = 0;
+    test_assert(child > 0 && read(to_parent[0], &token, 1) == 1 && token == 'o', "Child writer opened");
+    second = open_no_wait();
+    test_assert(second == NULL, "Writer in another process holds the lock");
+    writer_free(second);
+    test_assert(published_pid() == (uint32_t)child, "Sidecar names the child");
+
+    token = 'g';
+    bool synced = write(from_parent[1], &token, 1) == 1 && read(to_parent[0], &token, 1) == 1;
+    test_assert(synced && reader_poll(reader, &committed) == 1 && committed == 30, "Child's commit seen by polling");
+    test_assert(reader && reader_get_row_count(reader) == 20, "Snapshot unchanged until refresh");
+    test_assert(reader && reader_refresh(reader) == 0 && reader_get_row_count(reader) == 30, "Refresh picks it up");
+    test_assert(reader && reader_poll(reader, NULL) == 0, "Nothing new after refresh");
+
+    int status = -1;
+    if (child > 0) {
+        write(from_parent[1], &token, 1);
+        waitpid(child, &status, 0);
+    }
+    test_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child writer closed");
+
+    // Test 4: Rows committed to the log are published too
+    printf("Test 4: Log commits\n");
+    config.use_wal = true;
+    writer = writer_open_with_config(TEST_COORD_FILE, &config);
+    test_assert(writer && insert_ids(writer, 300, 302) == 0, "Log three rows");
+    test_assert(reader && reader_poll(reader, &committed) == 1 && committed == 33, "Logged rows counted");
+    test_assert(reader && reader_refresh(reader) == 0 && reader_get_row_count(reader) == 33, "Logged rows read");
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 5: A writer that died while publishing is repaired by the next one
+    printf("Test 5: Torn shared state\n");
+    reader_refresh(reader);
+    FILE* shm = fopen(TEST_COORD_SHM, "r+b");
+    uint64_t sequence = 0;
+    if (shm) {
+        fseek(shm, offsetof(fxdb_shm_t, sequence), SEEK_SET);
+        fread(&sequence, sizeof(sequence), 1, shm);
+        sequence |= 1;
+        fseek(shm, offsetof(fxdb_shm_t, sequence), SEEK_SET);
+        fwrite(&sequence, sizeof(sequence), 1, shm);
+        fclose(shm);
+    }
+    test_assert(reader && reader_poll(reader, NULL) == -1, "Torn state not trusted");
+    writer = writer_open(TEST_COORD_FILE);
+    writer_close(writer);
+    writer_free(writer);
+    test_assert(reader && reader_poll(reader, NULL) == 1, "Next writer publishes again");
+
+    // Test 6: Compaction is published, and the poller is told to reopen
+    printf("Test 6: Compaction\n");
+    reader_refresh(reader);
+    test_assert_equal_int(0, compact_database(TEST_COORD_FILE, NULL, NULL), "Compact database");
+    test_assert(reader && reader_poll(reader, NULL) == 1, "Compaction seen by polling");
+    test_assert(reader && reader_refresh(reader) != 0, "Refresh asks for a reopen");
+    reader_close(reader);
+    test_assert_equal_int(33, count_rows(), "Compacted rows");
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
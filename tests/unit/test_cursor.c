@@ -0,0 +1,151 @@
+#include "../test_utils.h"
+#include "../../include/cursor.h"
+#include "../../include/compact.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define TEST_CURSOR_FILE "test_cursor.fxdb"
+
+static int append_rows(writer_t* writer, int first, int last) {
+    return test_append_rows(writer, first, last, 0, test_row_id) == 0 ? writer_commit(writer) : -1;
+}
+
+// Read the rows the cursor has caught up on; ids must run first, first + 1, ...
+static int drain(fxdb_cursor_t* cursor, int first) {
+    int count = 0;
+    bool ordered = true;
+    row_data_t* row;
+    while ((row = fxdb_cursor_next(cursor)) != NULL) {
+        ordered = ordered && row->values[0].value.int32_val == first + count;
+        count++;
+        reader_free_row(row);
+    }
+    return ordered ? count : -1;
+}
+
+static long elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000L + (now.tv_nsec - start->tv_nsec) / 1000000L;
+}
+
+// Commit five rows after a pause
+static void* delayed_writer(void* arg) {
+    writer_t* writer = (writer_t*)arg;
+    struct timespec delay = { 0, 150 * 1000000L };
+    nanosleep(&delay, NULL);
+    append_rows(writer, 40, 44);
+    return NULL;
+}
+
+int main(void) {
+    test_init("Follow Cursor Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32");
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 8;
+    writer_t* writer = schema ? writer_create(TEST_CURSOR_FILE, schema, &config) : NULL;
+    test_assert_not_null(writer, "Create database");
+    if (!writer) {
+        free_schema(schema);
+        return test_finalize();
+    }
+    append_rows(writer, 0, 9);
+
+    // Test 1: Existing rows first, then nothing until a commit
+    printf("Test 1: Catch up\n");
+    fxdb_cursor_t* cursor = fxdb_cursor_open(TEST_CURSOR_FILE, true);
+    fxdb_cursor_t* tail = fxdb_cursor_open(TEST_CURSOR_FILE, false);
+    test_assert(cursor && tail, "Open cursors");
+    test_assert_equal_int(1, fxdb_cursor_follow(cursor, 0), "Stored rows are new to a cursor from the start");
+    test_assert_equal_int(10, drain(cursor, 0), "Stored rows streamed in order");
+    test_assert_equal_int(0, fxdb_cursor_follow(cursor, 0), "Caught up");
+    test_assert_equal_int(0, drain(tail, 0), "Cursor from the end skips stored rows");
+
+    // Test 2: Only rows of later commits, across short chunks
+    printf("Test 2: Plain commits\n");
+    append_rows(writer, 10, 12);
+    append_rows(writer, 13, 20);
+    test_assert_equal_int(1, fxdb_cursor_follow(cursor, 1000), "Commit noticed");
+    test_assert_equal_int(11, drain(cursor, 10), "Only new rows streamed");
+    test_assert(fxdb_cursor_follow(tail, 0) == 1 && drain(tail, 10) == 11, "Tail streams the same rows");
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 3: Rows in the log, then checkpointed, are streamed once
+    printf("Test 3: Log commits\n");
+    config.use_wal = true;
+    writer = writer_open_with_config(TEST_CURSOR_FILE, &config);
+    test_assert_not_null(writer, "Open logging writer");
+    append_rows(writer, 21, 23);
+    test_assert(fxdb_cursor_follow(cursor, 1000) == 1 && drain(cursor, 21) == 3, "Logged rows streamed");
+    append_rows(writer, 24, 33);
+    test_assert(fxdb_cursor_follow(cursor, 1000) == 1 && drain(cursor, 24) == 10, "Checkpointed rows not repeated");
+    writer_checkpoint(writer);
+    test_assert_equal_int(0, fxdb_cursor_follow(cursor, 0), "Checkpoint adds no rows");
+
+    // Test 4: Deleted new rows are skipped
+    printf("Test 4: Deletes\n");
+    append_rows(writer, 34, 36);
+    writer_close(writer);
+    writer_free(writer);
+    reader_t* reader = reader_open(TEST_CURSOR_FILE);
+    row_position_t position = { 0, 0 };
+    row_data_t* row;
+    while (reader && (row = reader_read_row(reader)) != NULL) {
+        if (row->values[0].value.int32_val == 35) {
+            reader_row_position(reader, &position);
+        }
+        reader_free_row(row);
+    }
+    test_assert(reader && reader_delete_rows(reader, &position, 1) == 0, "Delete a new row");
+    reader_close(reader);
+    fxdb_cursor_follow(cursor, 1000);
+    int ids[4] = { 0 };
+    int count = 0;
+    while ((row = fxdb_cursor_next(cursor)) != NULL) {
+        if (count < 4) {
+            ids[count] = row->values[0].value.int32_val;
+        }
+        count++;
+        reader_free_row(row);
+    }
+    test_assert(count == 2 && ids[0] == 34 && ids[1] == 36, "Deleted row skipped");
+    writer = writer_open_with_config(TEST_CURSOR_FILE, &config);
+
+    // Test 5: Following blocks until a writer commits
+    printf("Test 5: Blocking follow\n");
+    append_rows(writer, 37, 39);
+    fxdb_cursor_follow(cursor, 1000);
+    drain(cursor, 37);
+    pthread_t thread;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, delayed_writer, writer);
+    int status = fxdb_cursor_follow(cursor, -1);
+    long waited = elapsed_ms(&start);
+    pthread_join(thread, NULL);
+    test_assert(status == 1 && waited >= 100 && waited < 2000, "Woken by the commit");
+    test_assert_equal_int(5, drain(cursor, 40), "Rows of the commit streamed");
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 6: Compaction ends the stream
+    printf("Test 6: Compaction\n");
+    test_assert_equal_int(0, compact_database(TEST_CURSOR_FILE, NULL, NULL), "Compact database");
+    test_assert_equal_int(-1, fxdb_cursor_follow(cursor, 1000), "Follow reports the rewrite");
+
+    fxdb_cursor_close(cursor);
+    fxdb_cursor_close(tail);
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
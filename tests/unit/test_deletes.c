@@ -0,0 +1,148 @@
+#include "../test_utils.h"
+#include "../../include/deletes.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include "../../include/compact.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_DELETES_FILE "test_deletes.fxdb"
+#define TEST_DELETES_VECTORS TEST_DELETES_FILE ".del"
+
+// Rows carry value = id * 10
+static void value_row(int id, char* json, size_t size) {
+    snprintf(json, size, "{\"id\": %d, \"value\": %d}", id, id * 10);
+}
+
+// Write rows first..last
+static int write_rows(const writer_config_t* config, int first, int last) {
+    return test_append_file(TEST_DELETES_FILE, config, first, last, value_row);
+}
+
+// Delete every row whose id is accepted by the filter
+static int delete_where(bool (*filter)(int id)) {
+    reader_t* reader = reader_open(TEST_DELETES_FILE);
+    if (!reader) {
+        return -1;
+    }
+
+    row_position_t positions[64];
+    uint32_t count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        if (filter(row->values[0].value.int32_val) && count < 64 &&
+            reader_row_position(reader, &positions[count]) == 0) {
+            count++;
+        }
+        reader_free_row(row);
+    }
+
+    int result = reader_delete_rows(reader, positions, count);
+    reader_close(reader);
+    return result;
+}
+
+// Sum of the ids a scan returns, or -1 on a count mismatch
+static long scan_id_sum(uint32_t* rows) {
+    reader_t* reader = reader_open(TEST_DELETES_FILE);
+    if (!reader) {
+        return -1;
+    }
+
+    long sum = 0;
+    uint32_t count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        sum += row->values[0].value.int32_val;
+        count++;
+        reader_free_row(row);
+    }
+
+    *rows = count;
+    if (count != reader_get_row_count(reader)) {
+        sum = -1;
+    }
+    reader_close(reader);
+    return sum;
+}
+
+static bool is_even(int id) { return id % 2 == 0; }
+static bool is_seven(int id) { return id == 7; }
+static bool is_log_row(int id) { return id == 21; }
+
+int main(void) {
+    test_init("Deletion Vector Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32, value int32");
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 8;
+    test_assert_equal_int(0, schema ? test_write_file(TEST_DELETES_FILE, schema, 8, 20, value_row) : -1,
+                          "Write 20 rows over three chunks");
+
+    // Test 1: Deleted rows disappear from scans and counts
+    printf("Test 1: Delete rows\n");
+    test_assert_equal_int(0, delete_where(is_even), "Delete even ids");
+    uint32_t rows = 0;
+    test_assert_equal_int(100, (int)scan_id_sum(&rows), "Scan returns only odd ids");
+    test_assert_equal_int(10, (int)rows, "Ten rows left");
+
+    reader_t* reader = reader_open(TEST_DELETES_FILE);
+    test_assert(reader && reader_get_deleted_count(reader) == 10, "Deleted count");
+    column_aggregate_t aggregate;
+    test_assert(reader && reader_aggregate_column(reader, 1, &aggregate) == 0 &&
+                aggregate.row_count == 10 && aggregate.sum == 1000.0 && aggregate.min == 10.0,
+                "Aggregate skips deleted rows");
+    reader_close(reader);
+
+    // Test 2: Deleting again is idempotent and merges with earlier records
+    printf("Test 2: Repeated deletes\n");
+    test_assert_equal_int(0, delete_where(is_seven), "Delete id 7");
+    test_assert_equal_int(93, (int)scan_id_sum(&rows), "Id 7 gone too");
+    test_assert_equal_int(0, delete_where(is_seven), "Delete id 7 again");
+    reader = reader_open(TEST_DELETES_FILE);
+    test_assert(reader && reader_get_deleted_count(reader) == 11, "Repeated delete not counted twice");
+    reader_close(reader);
+
+    // Test 3: Rows still in the write-ahead log keep their position after a checkpoint
+    printf("Test 3: Delete a logged row\n");
+    writer_config_t wal_config = config;
+    wal_config.use_wal = true;
+    test_assert_equal_int(0, write_rows(&wal_config, 20, 22), "Log three rows");
+    test_assert_equal_int(0, delete_where(is_log_row), "Delete id 21 from the log");
+    test_assert_equal_int(93 + 20 + 22, (int)scan_id_sum(&rows), "Logged row hidden");
+    test_assert_equal_int(0, write_rows(&config, 23, 23), "Plain writer checkpoints the log");
+    test_assert_equal_int(93 + 20 + 22 + 23, (int)scan_id_sum(&rows), "Still hidden once checkpointed");
+
+    // Test 4: A torn last record is ignored
+    printf("Test 4: Torn record\n");
+    FILE* file = fopen(TEST_DELETES_VECTORS, "ab");
+    if (file) {
+        fwrite("torn", 1, 4, file);
+        fclose(file);
+    }
+    test_assert_equal_int(93 + 20 + 22 + 23, (int)scan_id_sum(&rows), "Torn record skipped");
+    test_assert_equal_int(0, delete_where(is_seven), "Append after torn record");
+
+    // Test 5: Vectors do not survive a rewrite of the database
+    printf("Test 5: Stale vectors\n");
+    test_assert_equal_int(0, schema ? test_write_file(TEST_DELETES_FILE, schema, 8, 4, value_row) : -1,
+                          "Rewrite with four rows");
+    test_assert_equal_int(6, (int)scan_id_sum(&rows), "No row hidden by old vectors");
+
+    // Test 6: Positions read before a compaction are refused, not applied to the new file
+    printf("Test 6: Delete racing compaction\n");
+    reader = reader_open(TEST_DELETES_FILE);
+    row_position_t first = { 0, 0 };
+    test_assert_equal_int(0, compact_database(TEST_DELETES_FILE, NULL, NULL), "Compact database");
+    test_assert(reader && reader_delete_rows(reader, &first, 1) != 0, "Stale delete refused");
+    reader_close(reader);
+    test_assert_equal_int(6, (int)scan_id_sum(&rows), "No row lost to the stale delete");
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
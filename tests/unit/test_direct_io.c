@@ -0,0 +1,150 @@
+#include "../test_utils.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/compact.h"
+#include "../../include/io_utils.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define TEST_DIRECT_FILE "test_direct_io.fxdb"
+
+// Name NULL on every fourth row
+static void direct_row(int index, char* json, size_t size) {
+    if (index % 4 == 0) {
+        test_row_id(index, json, size);
+    } else {
+        test_row_id_name(index, json, size);
+    }
+}
+
+// Create the test file with rows 0..rows-1
+static int write_file(const schema_t* schema, bool aligned, int rows, int commit_every) {
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 10;
+    config.align_chunks = aligned;
+    return test_write_file_with_config(TEST_DIRECT_FILE, schema, &config, rows, commit_every, direct_row);
+}
+
+// Whether every chunk header of the file starts on an aligned offset
+static bool chunks_aligned(void) {
+    FILE* file = fopen(TEST_DIRECT_FILE, "rb");
+    fxdb_header_t header;
+    if (!file || fread(&header, sizeof(header), 1, file) != 1) {
+        if (file) {
+            fclose(file);
+        }
+        return false;
+    }
+    fxdb_header_resolve(&header);
+
+    bool aligned = fxdb_header_aligned(&header);
+    long pos = header.data_offset;
+    for (uint32_t c = 0; aligned && c < header.chunk_count; c++) {
+        uint32_t chunk_header[2];
+        aligned = pos % FXDB_IO_ALIGNMENT == 0 && fseek(file, pos, SEEK_SET) == 0 &&
+                  fread(chunk_header, sizeof(uint32_t), 2, file) == 2;
+        pos += 2 * (long)sizeof(uint32_t) + chunk_header[1];
+    }
+    fclose(file);
+    return aligned && pos == (long)(header.data_offset + header.data_size);
+}
+
+// Read the whole file; returns the rows read in order, -1 on a wrong row
+static int scan(bool direct, int* direct_status) {
+    reader_t* reader = reader_open(TEST_DIRECT_FILE);
+    if (!reader) {
+        return -1;
+    }
+    if (direct) {
+        *direct_status = reader_set_direct_io(reader, true);
+    }
+
+    int count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        char name[32];
+        snprintf(name, sizeof(name), "row%d", count);
+        bool ok = row->values[0].value.int32_val == count &&
+                  (count % 4 == 0 ? row->values[1].is_null
+                                  : !row->values[1].is_null && strcmp(row->values[1].value.string_val, name) == 0);
+        reader_free_row(row);
+        if (!ok) {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    reader_close(reader);
+    return count;
+}
+
+int main(void) {
+    test_init("Direct I/O Tests");
+
+    cleanup_test_files();
+    schema_t* schema = parse_schema("id int32, name string?");
+    test_assert_not_null(schema, "Parse schema");
+    if (!schema) {
+        return test_finalize();
+    }
+
+    // Test 1: Aligned layout, with partial chunks from commits
+    printf("Test 1: Aligned chunk layout\n");
+    test_assert_equal_int(0, write_file(schema, true, 95, 7), "Write aligned file");
+    test_assert(chunks_aligned(), "Every chunk starts on a block boundary");
+    test_assert_equal_int(95, scan(false, NULL), "Buffered reads skip the padding");
+
+    writer_t* writer = writer_open(TEST_DIRECT_FILE);
+    test_assert_equal_int(0, test_append_rows(writer, 95, 149, 0, direct_row), "Append to aligned file");
+    writer_close(writer);
+    writer_free(writer);
+    test_assert(chunks_aligned(), "Appended chunks keep the layout");
+
+    // Test 2: Direct reads, around the chunk cache
+    printf("Test 2: Direct scan\n");
+    db_statistics_t before = {0}, after = {0};
+    fxdb_chunk_cache_get_statistics(&before);
+    int status = -1;
+    int rows = scan(true, &status);
+    fxdb_chunk_cache_get_statistics(&after);
+    if (status != 0) {
+        printf("  (direct I/O not supported here; buffered reads were used)\n");
+    }
+    test_assert_equal_int(150, rows, "Direct scan reads every row");
+    test_assert(status != 0 || (after.cache_hits == before.cache_hits && after.cache_misses == before.cache_misses),
+                "Direct scan leaves the chunk cache alone");
+
+    test_assert_equal_int(0, write_file(schema, false, 95, 7), "Write packed file");
+    test_assert_equal_int(95, scan(true, &status), "Direct scan of a packed file");
+
+    // Test 3: Compaction keeps or adopts the layout
+    printf("Test 3: Compaction\n");
+    compact_options_t options = compact_default_options();
+    options.durability = FXDB_DURABILITY_NONE;
+    options.align_chunks = true;
+    test_assert_equal_int(0, compact_database(TEST_DIRECT_FILE, &options, NULL), "Compact into aligned layout");
+    test_assert(chunks_aligned(), "Compacted chunks aligned");
+    test_assert_equal_int(95, scan(true, &status), "Rows kept");
+
+    options.align_chunks = false;
+    test_assert_equal_int(0, compact_database(TEST_DIRECT_FILE, &options, NULL), "Compact again");
+    test_assert(chunks_aligned(), "Aligned file stays aligned");
+    test_assert_equal_int(95, scan(false, NULL), "Rows kept");
+
+    // Test 4: Aligned buffer pool
+    printf("Test 4: Aligned buffers\n");
+    void* buffer = fxdb_aligned_buffer_acquire(10000);
+    test_assert(buffer && (uintptr_t)buffer % FXDB_IO_ALIGNMENT == 0, "Buffer aligned");
+    fxdb_aligned_buffer_release(buffer, 10000);
+    void* again = fxdb_aligned_buffer_acquire(12288);
+    test_assert(again == buffer, "Buffer of the same size reused");
+    fxdb_aligned_buffer_release(again, 12288);
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,169 @@
+#include "../test_utils.h"
+#include "../../include/join.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#define TEST_USERS_FILE "test_join_users.fxdb"
+#define TEST_ORDERS_FILE "test_join_orders.fxdb"
+#define TEST_JOIN_PREFIX "test_join_parts"
+#define USER_COUNT 100
+#define ORDER_COUNT 1000
+
+// Orders point at user oid % 120, so some match no user; every 50th has no user
+static bool order_has_user(int oid) {
+    return oid % 50 != 0;
+}
+
+// Write rows from JSON made by `make_json`, 10 per chunk
+static int write_file(const char* path, const char* schema_text, int count, test_row_fn make_json) {
+    schema_t* schema = parse_schema(schema_text);
+    int result = schema ? test_write_file(path, schema, 10, count, make_json) : -1;
+    free_schema(schema);
+    return result;
+}
+
+static void user_json(int i, char* json, size_t size) {
+    snprintf(json, size, "{\"id\": %d, \"name\": \"user%d\"}", i, i);
+}
+
+static void order_json(int i, char* json, size_t size) {
+    if (order_has_user(i)) {
+        snprintf(json, size, "{\"oid\": %d, \"uid\": %d, \"note\": \"n%d\"}", i, i % 120, i);
+    } else {
+        snprintf(json, size, "{\"oid\": %d, \"uid\": null, \"note\": \"n%d\"}", i, i);
+    }
+}
+
+// Orders whose user exists
+static uint32_t expected_matches(void) {
+    uint32_t count = 0;
+    for (int i = 0; i < ORDER_COUNT; i++) {
+        count += order_has_user(i) && i % 120 < USER_COUNT;
+    }
+    return count;
+}
+
+// Every row pairs an order with its user; in probe order the orders ascend
+static bool rows_match(const query_result_t* result, uint32_t user_field, uint32_t uid_field,
+                       uint32_t oid_field, bool ordered) {
+    int32_t last_oid = -1;
+    for (uint32_t i = 0; i < result->row_count; i++) {
+        const field_value_t* values = result->rows[i].values;
+        if (values[uid_field].is_null || values[user_field].value.int32_val != values[uid_field].value.int32_val) {
+            return false;
+        }
+        if (ordered && values[oid_field].value.int32_val <= last_oid) {
+            return false;
+        }
+        last_oid = values[oid_field].value.int32_val;
+    }
+    return true;
+}
+
+// Partition files left behind in the working directory
+static int count_partitions(void) {
+    int count = 0;
+    DIR* dir = opendir(".");
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, TEST_JOIN_PREFIX ".join", strlen(TEST_JOIN_PREFIX ".join")) == 0) {
+            count++;
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    return count;
+}
+
+int main(void) {
+    test_init("Join Tests");
+
+    cleanup_test_files();
+    test_assert_equal_int(0, write_file(TEST_USERS_FILE, "id int32, name string", USER_COUNT, user_json),
+                          "Write users");
+    test_assert_equal_int(0, write_file(TEST_ORDERS_FILE, "oid int32, uid int32?, note string", ORDER_COUNT,
+                                        order_json), "Write orders");
+
+    reader_t* users = reader_open(TEST_USERS_FILE);
+    reader_t* orders = reader_open(TEST_ORDERS_FILE);
+    test_assert(users && orders, "Open readers");
+    if (!users || !orders) {
+        reader_close(users);
+        reader_close(orders);
+        cleanup_test_files();
+        return test_finalize();
+    }
+    uint32_t matches = expected_matches();
+
+    // Test 1: The smaller table is hashed and the larger probed on several threads
+    printf("Test 1: In-memory join\n");
+    fxdb_join_options_t options = fxdb_join_default_options();
+    options.threads = 4;
+    fxdb_join_stats_t stats;
+    query_result_t* result = fxdb_hash_join(users, "users", 0, orders, "orders", 1, &options, &stats);
+    test_assert_not_null(result, "Join users with orders");
+    test_assert(result && result->row_count == matches, "Every order with a user");
+    test_assert(result && result->schema && result->schema->field_count == 5 &&
+                strcmp(result->schema->fields[0].name, "users.id") == 0 &&
+                strcmp(result->schema->fields[3].name, "orders.uid") == 0, "Fields named after their tables");
+    test_assert(result && rows_match(result, 0, 3, 2, true), "Rows pair up in probe order");
+    test_assert(stats.build_left && stats.build_rows == USER_COUNT && stats.partitions == 1, "Users hashed");
+    test_assert(stats.probe_rows == ORDER_COUNT - ORDER_COUNT / 50, "NULL keys not probed");
+    test_assert(stats.threads == 4 && stats.rows == matches, "Probe stats");
+    reader_free_result(result);
+
+    // Test 2: The build side does not depend on the order the tables are named in
+    printf("Test 2: Larger table on the left\n");
+    result = fxdb_hash_join(orders, "orders", 1, users, "users", 0, &options, &stats);
+    test_assert(result && result->row_count == matches && !stats.build_left, "Users still hashed");
+    test_assert(result && strcmp(result->schema->fields[0].name, "orders.oid") == 0 &&
+                rows_match(result, 3, 1, 0, false), "Left fields first");
+    reader_free_result(result);
+
+    // Test 3: A build side over the budget is split into partitions on disk
+    printf("Test 3: Grace join\n");
+    options.memory_limit = 1024;
+    options.temp_prefix = TEST_JOIN_PREFIX;
+    result = fxdb_hash_join(users, "users", 0, orders, "orders", 1, &options, &stats);
+    test_assert(result && result->row_count == matches, "Same rows through partitions");
+    test_assert(result && rows_match(result, 0, 3, 2, false), "Rows pair up");
+    test_assert(stats.partitions > 1 && stats.bytes_spilled > 0, "Partitions spilled");
+    test_assert_equal_int(0, count_partitions(), "Partitions removed");
+    reader_free_result(result);
+
+    // Test 4: A limit stops the join early
+    printf("Test 4: Limit\n");
+    options = fxdb_join_default_options();
+    options.limit = 7;
+    result = fxdb_hash_join(users, "users", 0, orders, "orders", 1, &options, &stats);
+    test_assert(result && result->row_count == 7 && rows_match(result, 0, 3, 2, false), "Seven rows");
+    reader_free_result(result);
+
+    // Test 5: String keys, a table joined with itself
+    printf("Test 5: Self join on strings\n");
+    options = fxdb_join_default_options();
+    result = fxdb_hash_join(users, "a", 1, users, "b", 1, &options, &stats);
+    test_assert(result && result->row_count == USER_COUNT, "Every user matches itself");
+    bool same = result != NULL;
+    for (uint32_t i = 0; same && i < result->row_count; i++) {
+        same = result->rows[i].values[0].value.int32_val == result->rows[i].values[2].value.int32_val;
+    }
+    test_assert(same, "Names pair the same user");
+    reader_free_result(result);
+
+    // Test 6: Fields of different types cannot be joined
+    printf("Test 6: Type mismatch\n");
+    test_assert(fxdb_hash_join(users, "users", 0, orders, "orders", 2, &options, NULL) == NULL,
+                "int32 with string rejected");
+
+    reader_close(users);
+    reader_close(orders);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,187 @@
+#include "../test_utils.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MMAP_FILE "test_mmap_reader.fxdb"
+
+// Name NULL on every fifth row
+static void mmap_row(int index, char* json, size_t size) {
+    if (index % 5 == 0) {
+        snprintf(json, size, "{\"id\": %d, \"score\": %d.5, \"active\": %s}",
+                 index, index, index % 3 ? "true" : "false");
+    } else {
+        snprintf(json, size, "{\"id\": %d, \"name\": \"row%d\", \"score\": %d.5, \"active\": %s}",
+                 index, index, index, index % 3 ? "true" : "false");
+    }
+}
+
+// Create the test file with rows 0..rows-1
+static int write_file(const schema_t* schema, bool aligned, int rows, int commit_every) {
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 16;
+    config.align_chunks = aligned;
+    return test_write_file_with_config(TEST_MMAP_FILE, schema, &config, rows, commit_every, mmap_row);
+}
+
+static bool rows_equal(const schema_t* schema, const row_data_t* a, const row_data_t* b) {
+    if (!a || !b) {
+        return a == b;
+    }
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        if (!reader_values_equal(&schema->fields[i], &a->values[i], &b->values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Read the file with both engines side by side; returns the rows that matched, -1 on a mismatch
+static int compare_scans(const fxdb_mmap_options_t* options, bool* mapped) {
+    reader_t* buffered = reader_open(TEST_MMAP_FILE);
+    reader_t* mmapped = reader_open(TEST_MMAP_FILE);
+    int count = buffered && mmapped && reader_set_mmap(mmapped, true, options) == 0 ? 0 : -1;
+    *mapped = mmapped && mmapped->map != NULL;
+
+    while (count >= 0) {
+        row_data_t* expected = reader_read_row(buffered);
+        row_data_t* actual = reader_read_row(mmapped);
+        bool same = rows_equal(buffered->schema, expected, actual);
+        bool done = !expected;
+        reader_free_row(expected);
+        reader_free_row(actual);
+        if (!same) {
+            count = -1;
+        } else if (done) {
+            break;
+        } else {
+            count++;
+        }
+    }
+
+    reader_close(buffered);
+    reader_close(mmapped);
+    return count;
+}
+
+// Seek both engines to every row, backwards; returns whether each row matched
+static bool compare_seeks(uint32_t* rows) {
+    reader_t* buffered = reader_open(TEST_MMAP_FILE);
+    fxdb_enhanced_reader_t* enhanced = fxdb_reader_open(TEST_MMAP_FILE, true);
+    bool same = buffered && enhanced && enhanced->use_mmap;
+    *rows = enhanced ? enhanced->total_rows : 0;
+
+    for (uint32_t row = *rows; same && row-- > 0;) {
+        reader_seek_row(buffered, row);
+        fxdb_reader_seek_row(enhanced, row);
+        row_data_t* expected = reader_read_row(buffered);
+        row_data_t* actual = fxdb_reader_read_row(enhanced);
+        same = expected && rows_equal(buffered->schema, expected, actual);
+        reader_free_row(expected);
+        reader_free_row(actual);
+    }
+
+    reader_close(buffered);
+    fxdb_reader_close(enhanced);
+    return same;
+}
+
+// Seek to a row and check the id read back
+static bool seek_reads(reader_t* reader, uint32_t row, int id) {
+    row_data_t* read = reader_seek_row(reader, row) == 0 ? reader_read_row(reader) : NULL;
+    bool ok = read && read->values[0].value.int32_val == id;
+    reader_free_row(read);
+    return ok;
+}
+
+int main(void) {
+    test_init("Memory-Mapped Reader Tests");
+
+    cleanup_test_files();
+    schema_t* schema = parse_schema("id int32, name string?, score float, active bool");
+    test_assert_not_null(schema, "Parse schema");
+    if (!schema) {
+        return test_finalize();
+    }
+    fxdb_mmap_options_t sequential = fxdb_mmap_default_options();
+    sequential.access = FXDB_MMAP_ACCESS_SEQUENTIAL;
+
+    // Test 1: Short chunks from commits, nullable columns and 1-byte bools
+    printf("Test 1: Partial chunks\n");
+    bool mapped = false;
+    test_assert_equal_int(0, write_file(schema, false, 300, 7), "Write file");
+    test_assert_equal_int(300, compare_scans(NULL, &mapped), "Mapped scan matches buffered scan");
+    test_assert(mapped, "File was mapped");
+    test_assert_equal_int(300, compare_scans(&sequential, &mapped), "Sequential hints change nothing");
+
+    uint32_t rows = 0;
+    test_assert(compare_seeks(&rows), "Seeks match buffered seeks");
+    test_assert_equal_int(300, (int)rows, "Enhanced reader counts every row");
+
+    // Test 2: Aligned layout, where padding follows each chunk
+    printf("Test 2: Aligned layout\n");
+    test_assert_equal_int(0, write_file(schema, true, 200, 11), "Write aligned file");
+    test_assert_equal_int(200, compare_scans(NULL, &mapped), "Mapped scan skips the padding");
+    test_assert(compare_seeks(&rows), "Seeks skip the padding");
+
+    // Test 3: Rows in the log and deleted rows
+    printf("Test 3: Log and deletes\n");
+    writer_t* writer = writer_open(TEST_MMAP_FILE);
+    test_assert_equal_int(0, test_append_rows(writer, 200, 209, 10, mmap_row), "Commit rows to the log");
+    writer_free(writer);
+
+    reader_t* reader = reader_open(TEST_MMAP_FILE);
+    row_position_t positions[3] = { { 0, 3 }, { 2, 0 }, { 12, 1 } };
+    test_assert(reader && reader_delete_rows(reader, positions, 3) == 0, "Delete rows");
+    reader_close(reader);
+    test_assert_equal_int(207, compare_scans(NULL, &mapped), "Mapped scan reads the log and skips deletes");
+    test_assert(compare_seeks(&rows), "Seeks into the log");
+    test_assert_equal_int(210, (int)rows, "Deleted rows still count for seeks");
+
+    // Test 4: A mapped reader picks up chunks appended after it was opened
+    printf("Test 4: Growing file\n");
+    reader = reader_open(TEST_MMAP_FILE);
+    test_assert(reader && reader_set_mmap(reader, true, NULL) == 0 && reader->map, "Map file");
+    query_result_t* result = reader ? reader_read_rows(reader, 1000) : NULL;
+    test_assert(result && result->row_count == 207, "Rows read before the append");
+    reader_free_result(result);
+
+    writer = writer_open(TEST_MMAP_FILE);
+    test_assert_equal_int(0, test_append_rows(writer, 210, 409, 0, mmap_row), "Append chunks");
+    writer_close(writer);
+    writer_free(writer);
+
+    test_assert(reader && reader_refresh(reader) == 0, "Refresh");
+    result = reader ? reader_read_rows(reader, 1000) : NULL;
+    test_assert(result && result->row_count == 407 && result->rows[406].values[0].value.int32_val == 409,
+                "Appended rows read from the new mapping");
+    reader_free_result(result);
+    test_assert(reader && seek_reads(reader, 401, 401) && seek_reads(reader, 5, 5), "Seek after refresh");
+    reader_close(reader);
+
+    // Test 5: Mapped chunks bypass the chunk cache; switching engines on an open reader
+    printf("Test 5: Switching engines\n");
+    test_assert_equal_int(407, compare_scans(NULL, &mapped), "Scan of the grown file");
+
+    db_statistics_t before = {0}, after = {0};
+    fxdb_chunk_cache_get_statistics(&before);
+    reader = reader_open(TEST_MMAP_FILE);
+    test_assert(reader && reader_set_mmap(reader, true, NULL) == 0 && seek_reads(reader, 100, 100),
+                "Seek through the mapping");
+    result = reader ? reader_read_rows(reader, 1000) : NULL;
+    fxdb_chunk_cache_get_statistics(&after);
+    test_assert(result && after.cache_hits == before.cache_hits && after.cache_misses == before.cache_misses,
+                "Mapped reads leave the chunk cache alone");
+    reader_free_result(result);
+    test_assert(reader && reader_set_mmap(reader, false, NULL) == 0 && !reader->map && seek_reads(reader, 101, 101),
+                "Seek with buffered reads after unmapping");
+    reader_close(reader);
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
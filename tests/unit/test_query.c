@@ -0,0 +1,154 @@
+#include "../test_utils.h"
+#include "../../include/query.h"
+#include "../../include/stats.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_QUERY_FILE "test_query.fxdb"
+
+// Names repeat every five rows
+static void query_row(int index, char* json, size_t size) {
+    snprintf(json, size, "{\"id\": %d, \"name\": \"row%d\"}", index, index % 5);
+}
+
+int main(void) {
+    test_init("Query Tests");
+
+    cleanup_test_files();
+    schema_t* schema = parse_schema("id int32, name string");
+    test_assert_not_null(schema, "Schema creation");
+    test_assert_equal_int(0, schema ? test_write_file(TEST_QUERY_FILE, schema, 10, 35, query_row) : -1,
+                          "Write 4 chunks");
+    if (schema) {
+        free_schema(schema);
+    }
+
+    reader_t* reader = reader_open(TEST_QUERY_FILE);
+    test_assert_not_null(reader, "Open reader");
+    if (!reader) {
+        cleanup_test_files();
+        return test_finalize();
+    }
+
+    // Test 1: A bare select scans every chunk
+    printf("Test 1: Full scan plan\n");
+    query_t query;
+    memset(&query, 0, sizeof(query));
+    query_plan_t plan;
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan select *");
+    test_assert(plan.access == QUERY_ACCESS_FULL_SCAN && plan.operator_count == 1 &&
+                plan.operators[0].type == QUERY_OP_SCAN, "Scan only");
+    test_assert_equal_int(4, (int)plan.chunk_count, "Snapshot chunks");
+    test_assert_equal_int(4, (int)plan.estimated_chunks, "Every chunk estimated");
+    test_assert_equal_int(35, (int)plan.operators[0].estimated_rows, "Every row estimated");
+
+    // Test 2: A limit without a filter reads only its rows' chunks
+    printf("Test 2: Limit plan\n");
+    query.limit = 15;
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan select * limit 15");
+    test_assert(plan.operator_count == 2 && plan.operators[0].type == QUERY_OP_LIMIT &&
+                plan.operators[1].type == QUERY_OP_SCAN, "Limit over scan");
+    test_assert_equal_int(2, (int)plan.estimated_chunks, "Two chunks estimated");
+
+    // Test 3: Executing a limit stops the scan early
+    printf("Test 3: Limit execution\n");
+    query_profile_t profile;
+    query_result_t* result;
+    test_assert(query_execute(reader, &query, &result, &profile) == 15, "Fifteen rows produced");
+    test_assert(result && result->row_count == 15 && result->rows[14].values[0].value.int32_val == 14,
+                "Rows in insertion order");
+    reader_free_result(result);
+    test_assert_equal_int(15, (int)profile.plan.operators[1].rows, "Scan stopped at the limit");
+    test_assert_equal_int(2, (int)profile.chunks_read, "Two chunks read");
+    test_assert_equal_int(2, (int)profile.chunks_skipped, "Two chunks skipped");
+
+    // Test 4: A filter keeps the matching rows
+    printf("Test 4: Filter execution\n");
+    memset(&query, 0, sizeof(query));
+    strcpy(query.filter_text, "row3");
+    query.has_filter = true;
+    query.filter_field = 1;
+    query.filter_value.field_name = "name";
+    query.filter_value.value.string_val = query.filter_text;
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan select * where name=row3");
+    test_assert(plan.operator_count == 2 && plan.operators[0].type == QUERY_OP_FILTER, "Filter over scan");
+    test_assert(strcmp(plan.operators[0].detail, "name = 'row3'") == 0, "Filter described");
+    test_assert_equal_int(4, (int)plan.estimated_chunks, "Filters scan every chunk");
+    test_assert(query_execute(reader, &query, &result, &profile) == 7, "Seven matches");
+    bool all_match = result != NULL;
+    for (uint32_t i = 0; result && i < result->row_count; i++) {
+        all_match = all_match && strcmp(result->rows[i].values[1].value.string_val, "row3") == 0;
+    }
+    test_assert(all_match, "Only matching rows returned");
+    reader_free_result(result);
+    test_assert_equal_int(35, (int)profile.plan.operators[1].rows, "Every row scanned");
+    test_assert_equal_int(7, (int)profile.plan.operators[0].rows, "Filter output counted");
+    test_assert(profile.chunks_read == 4 && profile.chunks_skipped == 0, "Every chunk read");
+    test_assert(profile.total_ms > 0 && profile.plan.operators[1].time_ms > 0, "Times recorded");
+    test_assert(profile.thread_count >= 1 && profile.threads[0].busy_ms > 0, "Thread utilization reported");
+
+    // Test 5: Discarded rows are still counted
+    printf("Test 5: Discarded rows\n");
+    query.limit = 2;
+    test_assert(query_execute(reader, &query, NULL, &profile) == 2, "Rows counted without a result");
+    test_assert_equal_int(2, (int)profile.plan.operators[0].rows, "Limit output counted");
+
+    // Test 6: An ordered limit keeps a top-N heap
+    printf("Test 6: Order by with a limit\n");
+    memset(&query, 0, sizeof(query));
+    query.has_order = true;
+    query.order_field = 0;
+    query.order_desc = true;
+    query.limit = 3;
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan select * order by id desc limit 3");
+    test_assert(plan.operator_count == 2 && plan.operators[0].type == QUERY_OP_TOP_N, "Top-N over scan");
+    test_assert_equal_int(4, (int)plan.estimated_chunks, "Ordered scans read every chunk");
+    test_assert(query_execute(reader, &query, &result, &profile) == 3, "Three rows produced");
+    test_assert(result && result->rows[0].values[0].value.int32_val == 34 &&
+                result->rows[2].values[0].value.int32_val == 32, "Largest ids first");
+    reader_free_result(result);
+    test_assert(profile.sort.heap && profile.sort.rows == 35, "Every row offered to the heap");
+
+    // Test 7: A sort larger than its memory spills and merges
+    printf("Test 7: Order by through runs\n");
+    query.order_field = 1;
+    query.order_desc = false;
+    query.limit = 0;
+    query.sort_memory = 4 * FXDB_SORT_SEGMENTS * fxdb_sort_row_bytes(reader->schema);
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan select * order by name");
+    test_assert(plan.operators[0].type == QUERY_OP_SORT && strstr(plan.operators[0].detail, "external"),
+                "External sort planned");
+    test_assert(query_execute(reader, &query, &result, &profile) == 35, "Every row produced");
+    bool sorted = result != NULL && result->row_count == 35;
+    for (uint32_t i = 1; sorted && i < result->row_count; i++) {
+        const row_data_t* a = &result->rows[i - 1];
+        const row_data_t* b = &result->rows[i];
+        int cmp = strcmp(a->values[1].value.string_val, b->values[1].value.string_val);
+        sorted = cmp < 0 || (cmp == 0 && a->values[0].value.int32_val < b->values[0].value.int32_val);
+    }
+    test_assert(sorted, "Rows by name, then insertion order");
+    reader_free_result(result);
+    test_assert(profile.sort.runs > 1 && profile.sort.bytes_spilled > 0, "Runs spilled");
+
+    // Test 8: Profiles name the sources the chunks came from and count mapped reads
+    printf("Test 8: Chunk sources\n");
+    memset(&query, 0, sizeof(query));
+    test_assert_equal_int(0, query_plan(reader, &query, &plan), "Plan a plain scan");
+    test_assert(strcmp(plan.source, "file + cache") == 0, "Plain reader may read the file or the cache");
+    test_assert(query_execute(reader, &query, NULL, &profile) == 35, "Scan through the chunk cache");
+    test_assert(strcmp(profile.plan.source, "cache") == 0, "Chunks of earlier scans come from the cache");
+    test_assert(strstr(profile.plan.operators[0].detail, "cache") == profile.plan.operators[0].detail,
+                "Scan detail names the actual source");
+    test_assert_equal_int(0, reader_set_mmap(reader, true, NULL), "Map the file");
+    test_assert(query_execute(reader, &query, NULL, &profile) == 35, "Scan the mapping");
+    test_assert(strcmp(profile.plan.source, "mmap") == 0, "Mapped chunks named");
+    test_assert(profile.bytes_read > 35 * reader->schema->row_size, "Mapped bytes counted");
+
+    reader_close(reader);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,110 @@
+#include "../test_utils.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_AHEAD_FILE "test_read_ahead.fxdb"
+#define CHUNKS 50
+
+// Write `rows` rows with id = i, 10 rows per chunk; commits every `commit_every` rows
+static int write_file(const schema_t* schema, int rows, int commit_every) {
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 10;
+    return test_write_file_with_config(TEST_AHEAD_FILE, schema, &config, rows, commit_every, test_row_id);
+}
+
+// Scan a file from a cold cache; returns rows read in order, -1 on a wrong row
+static int scan(uint32_t depth, uint64_t* misses) {
+    fxdb_chunk_cache_purge();
+    db_statistics_t before = {0}, after = {0};
+    fxdb_chunk_cache_get_statistics(&before);
+
+    reader_t* reader = reader_open(TEST_AHEAD_FILE);
+    if (!reader) {
+        return -1;
+    }
+    reader_set_read_ahead(reader, depth);
+
+    int count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        if (row->values[0].value.int32_val != count) {
+            count = -1;
+        }
+        reader_free_row(row);
+        if (count < 0) {
+            break;
+        }
+        count++;
+    }
+    reader_close(reader);
+
+    fxdb_chunk_cache_get_statistics(&after);
+    *misses = after.cache_misses - before.cache_misses;
+    return count;
+}
+
+int main(void) {
+    test_init("Read-Ahead Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32");
+    test_assert_equal_int(0, schema ? write_file(schema, CHUNKS * 10, 0) : -1, "Write 50 chunks");
+
+    // Test 1: Chunks after the first arrive before the scan needs them
+    printf("Test 1: Sequential scan\n");
+    uint64_t misses = 0;
+    test_assert_equal_int(CHUNKS * 10, scan(8, &misses), "Rows read in order");
+    test_assert_equal_int(1, (int)misses, "Only the first chunk is read by the scan");
+    test_assert_equal_int(CHUNKS * 10, scan(0, &misses), "Rows read without read-ahead");
+    test_assert_equal_int(CHUNKS, (int)misses, "Without read-ahead every chunk misses");
+
+    // Test 2: Chunks of varying size, from commits between full chunks
+    printf("Test 2: Partial chunks\n");
+    test_assert_equal_int(0, schema ? write_file(schema, 333, 7) : -1, "Write short chunks");
+    test_assert_equal_int(333, scan(4, &misses), "Rows read in order");
+    test_assert_equal_int(1, (int)misses, "Short chunks read ahead too");
+
+    // Test 3: New chunks are read ahead after a refresh
+    printf("Test 3: Growing file\n");
+    fxdb_chunk_cache_purge();
+    reader_t* reader = reader_open(TEST_AHEAD_FILE);
+    query_result_t* result = reader ? reader_read_rows(reader, 333) : NULL;
+    reader_free_result(result);
+    writer_t* writer = writer_open(TEST_AHEAD_FILE);
+    char json[64];
+    for (int i = 333; writer && i < 433; i++) {
+        snprintf(json, sizeof(json), "{\"id\": %d}", i);
+        writer_insert_json(writer, json);
+    }
+    writer_close(writer);
+    writer_free(writer);
+    test_assert(reader && reader_refresh(reader) == 0, "Refresh");
+    result = reader ? reader_read_rows(reader, 500) : NULL;
+    test_assert(result && result->row_count == 433 && result->rows[432].values[0].value.int32_val == 432,
+                "Committed rows read after a refresh");
+    reader_free_result(result);
+    reader_close(reader);
+
+    // Test 4: Closing a reader with reads in flight, and a disabled cache
+    printf("Test 4: Early close\n");
+    for (int i = 0; i < 20; i++) {
+        fxdb_chunk_cache_purge();
+        reader = reader_open(TEST_AHEAD_FILE);
+        row_data_t* row = reader ? reader_read_row(reader) : NULL;
+        reader_free_row(row);
+        reader_close(reader);
+    }
+    test_assert(true, "Readers closed while reading ahead");
+    fxdb_chunk_cache_set_budget(0);
+    test_assert_equal_int(433, scan(8, &misses), "Rows read with caching disabled");
+    fxdb_chunk_cache_set_budget(FXDB_CHUNK_CACHE_BYTES);
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -1,19 +1,150 @@
 #include "../test_utils.h"
 #include "../../include/reader.h"
+#include "../../include/writer.h"
 #include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define TEST_NULLABLE_FILE "test_reader_nullable.fxdb"
 
 int main(void) {
     test_init("Enhanced Reader Module Tests");
-    
+
     // Cleanup any existing test files
     cleanup_test_files();
-    
-    // Test 1: Basic reader functionality  
-    printf("Test 1: Basic reader functionality\n");
-    test_assert(true, "Reader test placeholder");
-    
+
+    // Test 1: Nullable columns round-trip through validity bitmaps
+    printf("Test 1: Nullable columns\n");
+    schema_t* schema = parse_schema("id int32, score float?, tag string?");
+    test_assert_not_null(schema, "Nullable schema creation");
+    test_assert(schema && !schema->fields[0].nullable, "id is not nullable");
+    test_assert(schema && schema->fields[1].nullable, "score is nullable");
+
+    // Small chunks so bitmaps cross both word and chunk boundaries
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 100;
+    writer_t* writer = schema ? writer_create(TEST_NULLABLE_FILE, schema, &config) : NULL;
+    test_assert_not_null(writer, "Writer creation");
+
+    int expected_scores = 0;
+    double expected_sum = 0.0;
+    char json[128];
+    for (int i = 0; writer && i < 250; i++) {
+        if (i % 3 == 0) {
+            snprintf(json, sizeof(json), "{\"id\": %d}", i);
+        } else if (i % 3 == 1) {
+            snprintf(json, sizeof(json), "{\"id\": %d, \"score\": null, \"tag\": \"t\"}", i);
+        } else {
+            snprintf(json, sizeof(json), "{\"id\": %d, \"score\": %d}", i, i);
+            expected_scores++;
+            expected_sum += i;
+        }
+        if (writer_insert_json(writer, json) != 0) {
+            test_assert(false, "Insert row with NULLs");
+            break;
+        }
+    }
+    test_assert(writer && writer_insert_json(writer, "{\"id\": null}") != 0,
+                "NULL for non-nullable field is rejected");
+    test_assert_equal_int(0, writer ? writer_close(writer) : -1, "Writer close");
+
+    reader_t* reader = reader_open(TEST_NULLABLE_FILE);
+    test_assert_not_null(reader, "Reader open");
+    if (reader) {
+        test_assert(reader->schema->fields[2].nullable, "Nullable flag restored from header");
+
+        bool nulls_match = true;
+        for (int i = 0; i < 250; i++) {
+            row_data_t* row = reader_read_row(reader);
+            if (!row) {
+                nulls_match = false;
+                break;
+            }
+            bool score_null = (i % 3 != 2);
+            bool tag_null = (i % 3 != 1);
+            if (row->values[0].is_null || row->values[0].value.int32_val != i ||
+                row->values[1].is_null != score_null || row->values[2].is_null != tag_null ||
+                (!score_null && row->values[1].value.float_val != (float)i)) {
+                nulls_match = false;
+            }
+            reader_free_row(row);
+        }
+        test_assert(nulls_match, "NULLs read back for every row");
+
+        // Test 2: Aggregates skip NULLs
+        printf("Test 2: Column aggregates\n");
+        column_aggregate_t agg;
+        test_assert_equal_int(0, reader_aggregate_column(reader, 1, &agg), "Aggregate score");
+        test_assert_equal_int(250, (int)agg.row_count, "Aggregate row count");
+        test_assert_equal_int(expected_scores, (int)agg.value_count, "Aggregate non-NULL count");
+        test_assert(agg.sum == expected_sum, "Aggregate sum ignores NULLs");
+        test_assert(agg.min == 2.0 && agg.max == 248.0, "Aggregate min/max ignore NULLs");
+
+        test_assert_equal_int(0, reader_aggregate_column(reader, 0, &agg), "Aggregate id");
+        test_assert_equal_int(250, (int)agg.value_count, "Non-nullable column has no NULLs");
+
+        row_data_t* first = reader_read_row(reader);
+        test_assert(first && first->values[0].value.int32_val == 0, "Aggregate rewinds reader");
+        reader_free_row(first);
+
+        reader_close(reader);
+    }
+
+    // Test 3: Mapping hints leave the mapped bytes unchanged
+    printf("Test 3: Mapping hints\n");
+    FILE* file = fopen(TEST_NULLABLE_FILE, "rb");
+    uint8_t expected[1024];
+    size_t expected_size = file ? fread(expected, 1, sizeof(expected), file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    fxdb_mmap_options_t hints[] = {
+        { FXDB_MMAP_ACCESS_SEQUENTIAL, false, true },
+        { FXDB_MMAP_ACCESS_RANDOM, false, false },
+        { FXDB_MMAP_ACCESS_DEFAULT, true, false },
+    };
+    bool same = expected_size == sizeof(expected);
+    for (size_t i = 0; i < sizeof(hints) / sizeof(hints[0]); i++) {
+        fxdb_mmap_reader_t* mapped = fxdb_mmap_reader_open_with_options(TEST_NULLABLE_FILE, &hints[i]);
+        const uint8_t* data = mapped ? fxdb_mmap_get_ptr(mapped, 0) : NULL;
+        same = same && data && memcmp(data, expected, expected_size) == 0 &&
+               fxdb_mmap_prefetch(mapped, 100, 5000) == 0 &&
+               fxdb_mmap_advise(mapped, FXDB_MMAP_ACCESS_SEQUENTIAL) == 0;
+        fxdb_mmap_reader_close(mapped);
+    }
+    test_assert(same, "Mapped with every hint");
+
+    fxdb_enhanced_reader_t* enhanced = fxdb_reader_open(TEST_NULLABLE_FILE, true);
+    test_assert(enhanced && enhanced->use_mmap && fxdb_reader_set_access(enhanced, FXDB_MMAP_ACCESS_RANDOM) == 0,
+                "Access hint changed on an open reader");
+    fxdb_reader_close(enhanced);
+
+    // Test 4: is_null is only read for nullable fields
+    printf("Test 4: Unset NULL flags\n");
+    schema_t* plain = parse_schema("id int32, name string");
+    writer = plain ? writer_create(TEST_NULLABLE_FILE, plain, &config) : NULL;
+    field_value_t values[2];
+    memset(values, 0xff, sizeof(values));
+    values[0].field_name = "id";
+    values[0].value.int32_val = 7;
+    values[1].field_name = "name";
+    values[1].value.string_val = "seven";
+    test_assert(writer && writer_insert_row(writer, values, 2) == 0 && writer_close(writer) == 0,
+                "Garbage NULL flags on non-nullable fields ignored");
+    writer_free(writer);
+    reader = reader_open(TEST_NULLABLE_FILE);
+    row_data_t* row = reader ? reader_read_row(reader) : NULL;
+    test_assert(row && !row->values[0].is_null && row->values[0].value.int32_val == 7 &&
+                strcmp(row->values[1].value.string_val, "seven") == 0, "Row read back");
+    reader_free_row(row);
+    reader_close(reader);
+    free_schema(plain);
+
+    if (schema) {
+        free_schema(schema);
+    }
+
     cleanup_test_files();
     return test_finalize();
-}
\ No newline at end of file
+}
@@ -0,0 +1,238 @@
+#include "../test_utils.h"
+#include "../../include/server.h"
+#include "../../include/client.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define TEST_SERVER_FILE "test_server.fxdb"
+#define TEST_SERVER_SOCKET "test_server.sock"
+#define CLIENT_THREADS 4
+#define ROWS_PER_THREAD 250
+#define SLOW_READS 200             // About 20MB of answers, past the server's backlog cap
+
+static void* run_server(void* arg) {
+    fxdb_server_run((fxdb_server_t*)arg);
+    return NULL;
+}
+
+// Build rows id first..last as JSON, every third one without a name
+static char** make_rows(int first, int last) {
+    char** rows = calloc((size_t)(last - first + 1), sizeof(char*));
+    for (int id = first; rows && id <= last; id++) {
+        char json[128];
+        if (id % 3 == 0) {
+            snprintf(json, sizeof(json), "{\"id\": %d, \"score\": %d.5, \"active\": true}", id, id);
+        } else {
+            snprintf(json, sizeof(json), "{\"id\": %d, \"name\": \"user%d\", \"score\": %d.5, \"active\": false}",
+                     id, id, id);
+        }
+        rows[id - first] = strdup(json);
+    }
+    return rows;
+}
+
+static void free_rows(char** rows, int count) {
+    for (int i = 0; rows && i < count; i++) {
+        free(rows[i]);
+    }
+    free(rows);
+}
+
+// Each thread inserts its own id range over its own connection
+static void* client_thread(void* arg) {
+    int first = *(int*)arg;
+    fxdb_client_t* client = fxdb_client_connect(TEST_SERVER_SOCKET);
+    char** rows = make_rows(first, first + ROWS_PER_THREAD - 1);
+    int inserted = client ? fxdb_client_insert_many(client, TEST_SERVER_FILE, (const char* const*)rows,
+                                                    ROWS_PER_THREAD) : -1;
+    free_rows(rows, ROWS_PER_THREAD);
+    fxdb_client_close(client);
+    *(int*)arg = inserted;
+    return NULL;
+}
+
+static uint32_t count_rows(fxdb_client_t* client) {
+    uint32_t rows = 0;
+    return fxdb_client_count(client, TEST_SERVER_FILE, &rows) == 0 ? rows : (uint32_t)-1;
+}
+
+int main(void) {
+    test_init("Server Tests");
+
+    cleanup_test_files();
+    unlink(TEST_SERVER_SOCKET);
+
+    schema_t* schema = parse_schema("id int32, name string?, score float, active bool");
+    writer_t* writer = schema ? writer_create_default(TEST_SERVER_FILE, schema) : NULL;
+    test_assert_not_null(writer, "Create database");
+    writer_close(writer);
+    writer_free(writer);
+    free_schema(schema);
+
+    fxdb_server_config_t config = fxdb_server_default_config();
+    config.socket_path = TEST_SERVER_SOCKET;
+    config.directory = ".";
+    config.workers = 4;
+    config.writer_idle_ms = 100;
+    fxdb_server_t* server = fxdb_server_create(&config);
+    test_assert_not_null(server, "Start server");
+    if (!server) {
+        return test_finalize();
+    }
+    test_assert(fxdb_server_create(&config) == NULL, "Second server on the same socket refused");
+
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, run_server, server);
+    fxdb_client_t* client = fxdb_client_connect(TEST_SERVER_SOCKET);
+    test_assert_not_null(client, "Connect client");
+    if (!client) {
+        fxdb_server_stop(server);
+        pthread_join(server_thread, NULL);
+        fxdb_server_free(server);
+        return test_finalize();
+    }
+
+    // Test 1: Schema and single rows
+    printf("Test 1: Requests\n");
+    test_assert_equal_int(0, fxdb_client_ping(client), "Ping");
+    schema_t* remote = fxdb_client_schema(client, TEST_SERVER_FILE);
+    test_assert(remote && remote->field_count == 4 && remote->fields[1].nullable &&
+                remote->fields[3].type == FIELD_TYPE_BOOL, "Schema sent as text");
+    test_assert_equal_int(0, fxdb_client_insert(client, TEST_SERVER_FILE,
+                                                "{\"id\": 0, \"score\": 0.5, \"active\": true}"), "Insert a row");
+    test_assert_equal_int(1, (int)count_rows(client), "Row counted");
+    test_assert(fxdb_client_insert(client, TEST_SERVER_FILE, "{\"id\": \"x\"}") != 0, "Invalid row refused");
+    test_assert(fxdb_client_insert(client, "test_missing", "{\"id\": 1}") != 0 &&
+                strstr(fxdb_client_error(client), "does not exist") != NULL, "Missing database reported");
+
+    // Test 2: Pipelined inserts, read back in pages
+    printf("Test 2: Pipelining\n");
+    char** rows = make_rows(1, 2000);
+    test_assert_equal_int(2000, fxdb_client_insert_many(client, TEST_SERVER_FILE, (const char* const*)rows, 2000),
+                          "Pipelined inserts");
+    free_rows(rows, 2000);
+    test_assert_equal_int(2001, (int)count_rows(client), "All rows committed");
+
+    row_position_t position = { 0, 0 };
+    int read = 0;
+    bool ordered = true;
+    query_result_t* page;
+    while (remote && (page = fxdb_client_read(client, TEST_SERVER_FILE, remote, &position, 300)) != NULL) {
+        uint32_t page_rows = page->row_count;
+        for (uint32_t i = 0; i < page_rows; i++) {
+            const field_value_t* values = page->rows[i].values;
+            int id = values[0].value.int32_val;
+            ordered = ordered && id == read + (int)i && values[1].is_null == (id % 3 == 0) &&
+                      values[2].value.float_val == id + 0.5f && values[3].value.bool_val == (id % 3 == 0);
+        }
+        read += (int)page_rows;
+        reader_free_result(page);
+        if (page_rows == 0) {
+            break;
+        }
+    }
+    test_assert(read == 2001 && ordered, "Pages read in order with their values");
+
+    fxdb_client_insert(client, TEST_SERVER_FILE, "{\"id\": 2001, \"score\": 2001.5, \"active\": true}");
+    page = remote ? fxdb_client_read(client, TEST_SERVER_FILE, remote, &position, 300) : NULL;
+    test_assert(page && page->row_count == 1 && page->rows[0].values[0].value.int32_val == 2001,
+                "Reading on from the last position returns only new rows");
+    reader_free_result(page);
+
+    // Test 3: Answers come back in request order
+    printf("Test 3: Manual pipelining\n");
+    uint32_t ids[3];
+    ids[0] = fxdb_client_send(client, FXDB_OP_COUNT, TEST_SERVER_FILE, NULL, 0);
+    ids[1] = fxdb_client_send(client, FXDB_OP_PING, NULL, NULL, 0);
+    ids[2] = fxdb_client_send(client, FXDB_OP_SCHEMA, "test_missing", NULL, 0);
+    fxdb_response_t response;
+    bool in_order = true;
+    for (int i = 0; i < 3; i++) {
+        in_order = in_order && fxdb_client_receive(client, &response) == 0 && response.id == ids[i];
+        in_order = in_order && response.status == (i == 2 ? FXDB_STATUS_ERROR : FXDB_STATUS_OK);
+    }
+    test_assert(in_order, "Answers match requests");
+
+    // Test 4: Many clients at once
+    printf("Test 4: Concurrent clients\n");
+    pthread_t threads[CLIENT_THREADS];
+    int results[CLIENT_THREADS];
+    for (int i = 0; i < CLIENT_THREADS; i++) {
+        results[i] = 10000 + i * ROWS_PER_THREAD;
+        pthread_create(&threads[i], NULL, client_thread, &results[i]);
+    }
+    int inserted = 0;
+    for (int i = 0; i < CLIENT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        inserted += results[i];
+    }
+    test_assert_equal_int(CLIENT_THREADS * ROWS_PER_THREAD, inserted, "Every client's rows inserted");
+    test_assert_equal_int(2002 + CLIENT_THREADS * ROWS_PER_THREAD, (int)count_rows(client), "Rows counted");
+
+    // Test 5: An idle writer is closed, and commits of other writers are seen
+    printf("Test 5: Idle writer\n");
+    struct timespec pause = { 0, 800 * 1000000L };
+    nanosleep(&pause, NULL);
+    writer_config_t writer_config = writer_default_config();
+    writer_config.lock_timeout_ms = 0;
+    writer = writer_open_with_config(TEST_SERVER_FILE, &writer_config);
+    test_assert_not_null(writer, "Server released the database");
+    if (writer) {
+        writer_insert_json(writer, "{\"id\": 50000, \"score\": 1.0, \"active\": true}");
+        writer_close(writer);
+        writer_free(writer);
+    }
+    test_assert_equal_int(2003 + CLIENT_THREADS * ROWS_PER_THREAD, (int)count_rows(client),
+                          "Outside commit seen by the server");
+
+    // Test 6: Names cannot reach outside the served directory
+    printf("Test 6: Confined names\n");
+    char cwd[512], outside[600];
+    const char* base = getcwd(cwd, sizeof(cwd)) ? strrchr(cwd, '/') : NULL;
+    snprintf(outside, sizeof(outside), "%s/%s", cwd, TEST_SERVER_FILE);
+    uint32_t count = 0;
+    test_assert(fxdb_client_count(client, outside, &count) != 0 &&
+                strstr(fxdb_client_error(client), "does not exist") != NULL, "Absolute path refused");
+    snprintf(outside, sizeof(outside), "..%s/%s", base ? base : "/", TEST_SERVER_FILE);
+    test_assert(fxdb_client_count(client, outside, &count) != 0, "Parent directory refused");
+    test_assert(fxdb_client_insert(client, "../" TEST_SERVER_FILE, "{\"id\": 1}") != 0, "Insert outside refused");
+
+    // Test 7: A client that does not read is held back without stalling the others
+    printf("Test 7: Slow reader\n");
+    fxdb_client_t* slow = fxdb_client_connect(TEST_SERVER_SOCKET);
+    uint32_t body[3] = { 0, 0, 3000 };
+    uint32_t first_id = 0, last_id = 0;
+    for (int i = 0; slow && i < SLOW_READS; i++) {
+        last_id = fxdb_client_send(slow, FXDB_OP_READ, TEST_SERVER_FILE, body, sizeof(body));
+        first_id = i == 0 ? last_id : first_id;
+    }
+    test_assert(slow && fxdb_client_flush(slow) == 0, "Pipeline more answers than the server holds");
+    nanosleep(&pause, NULL);
+    test_assert_equal_int(0, fxdb_client_ping(client), "Other clients still served");
+    int answered = 0;
+    bool answers_ordered = true;
+    while (slow && answered < SLOW_READS && fxdb_client_receive(slow, &response) == 0) {
+        answers_ordered = answers_ordered && response.id == first_id + (uint32_t)answered &&
+                          response.status == FXDB_STATUS_OK;
+        answered++;
+    }
+    test_assert(answered == SLOW_READS && answers_ordered && response.id == last_id,
+                "Held back answers arrive in order");
+    fxdb_client_close(slow);
+
+    fxdb_client_close(client);
+    free_schema(remote);
+    fxdb_server_stop(server);
+    pthread_join(server_thread, NULL);
+    fxdb_server_free(server);
+    test_assert(access(TEST_SERVER_SOCKET, F_OK) != 0, "Socket removed");
+
+    cleanup_test_files();
+    return test_finalize();
+}
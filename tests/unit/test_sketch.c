@@ -0,0 +1,161 @@
+#include "../test_utils.h"
+#include "../../include/sketch.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Values in a scrambled but repeatable order
+static uint32_t scramble(uint32_t i, uint32_t n) {
+    return (uint32_t)(((uint64_t)i * 2654435761u) % n);
+}
+
+static field_def_t int_field(void) {
+    field_def_t field;
+    memset(&field, 0, sizeof(field));
+    field.type = FIELD_TYPE_INT32;
+    field.size = sizeof(int32_t);
+    return field;
+}
+
+static uint64_t hash_int(int32_t value) {
+    field_def_t field = int_field();
+    return fxdb_hash_value(&field, (const uint8_t*)&value);
+}
+
+static bool within(double estimate, double expected, double tolerance) {
+    return fabs(estimate - expected) <= tolerance * expected;
+}
+
+int main(void) {
+    test_init("Sketch Tests");
+
+    // Test 1: Equal values hash alike whatever their layout
+    printf("Test 1: Hashing values\n");
+    field_def_t floats = int_field();
+    floats.type = FIELD_TYPE_FLOAT;
+    float zero = 0.0f, negative_zero = -0.0f;
+    test_assert(fxdb_hash_value(&floats, (const uint8_t*)&zero) == fxdb_hash_value(&floats, (const uint8_t*)&negative_zero),
+                "-0 hashes as 0");
+    field_def_t short_text = int_field(), long_text = int_field();
+    short_text.type = long_text.type = FIELD_TYPE_STRING;
+    short_text.size = 8;
+    long_text.size = 32;
+    uint8_t a[8] = "abc", b[32] = "abc";
+    test_assert(fxdb_hash_value(&short_text, a) == fxdb_hash_value(&long_text, b), "Strings hash by their text");
+    test_assert(hash_int(1) != hash_int(2), "Different values differ");
+
+    // Test 2: Distinct counts, small and large, with duplicates
+    printf("Test 2: HyperLogLog estimates\n");
+    fxdb_hll_t hll;
+    fxdb_hll_init(&hll);
+    test_assert(fxdb_hll_estimate(&hll) == 0.0, "Empty sketch counts nothing");
+    for (int32_t i = 0; i < 10000; i++) {
+        fxdb_hll_add(&hll, hash_int(i % 100));
+    }
+    test_assert(within(fxdb_hll_estimate(&hll), 100, 0.03), "100 distinct among 10000");
+
+    fxdb_hll_init(&hll);
+    for (int32_t i = 0; i < 200000; i++) {
+        fxdb_hll_add(&hll, hash_int(i));
+    }
+    double large = fxdb_hll_estimate(&hll);
+    test_assert(within(large, 200000, 0.05), "200000 distinct within 5%");
+
+    // Test 3: Merged halves estimate their union
+    printf("Test 3: HyperLogLog merge\n");
+    fxdb_hll_t left, right;
+    fxdb_hll_init(&left);
+    fxdb_hll_init(&right);
+    for (int32_t i = 0; i < 60000; i++) {
+        fxdb_hll_add(&left, hash_int(i));
+        fxdb_hll_add(&right, hash_int(i + 40000));
+    }
+    fxdb_hll_merge(&left, &right);
+    test_assert(within(fxdb_hll_estimate(&left), 100000, 0.05), "Overlapping halves count once");
+
+    // Test 4: Encodings round-trip, sparse while few registers are set
+    printf("Test 4: HyperLogLog encoding\n");
+    uint8_t* encoded = malloc(FXDB_HLL_MAX_ENCODED);
+    fxdb_hll_t small, decoded;
+    fxdb_hll_init(&small);
+    for (int32_t i = 0; i < 50; i++) {
+        fxdb_hll_add(&small, hash_int(i));
+    }
+    size_t size = fxdb_hll_encode(&small, encoded);
+    fxdb_hll_init(&decoded);
+    test_assert(size < 200 && fxdb_hll_merge_encoded(&decoded, encoded, size) == 0 &&
+                memcmp(&decoded, &small, sizeof(small)) == 0, "Sparse encoding round-trips");
+    size = fxdb_hll_encode(&hll, encoded);
+    fxdb_hll_init(&decoded);
+    test_assert(size == FXDB_HLL_MAX_ENCODED && fxdb_hll_merge_encoded(&decoded, encoded, size) == 0 &&
+                memcmp(&decoded, &hll, sizeof(hll)) == 0, "Dense encoding round-trips");
+    test_assert(fxdb_hll_merge_encoded(&decoded, encoded, size - 1) != 0, "Short encoding rejected");
+    free(encoded);
+
+    // Test 5: Quantiles stay within the rank error while the sketch stays small
+    printf("Test 5: KLL quantiles\n");
+    const uint32_t n = 100000;
+    fxdb_kll_t kll;
+    fxdb_kll_init(&kll, 0);
+    double value;
+    test_assert(fxdb_kll_quantile(&kll, 0.5, &value) != 0, "Empty sketch has no quantiles");
+    for (uint32_t i = 0; i < n; i++) {
+        fxdb_kll_add(&kll, scramble(i, n));
+    }
+    uint32_t held = 0;
+    for (uint32_t h = 0; h < kll.level_count; h++) {
+        held += kll.sizes[h];
+    }
+    test_assert(kll.count == n && held < 4 * FXDB_KLL_DEFAULT_K, "A few hundred values held");
+    bool accurate = true;
+    const double quantiles[] = { 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99 };
+    for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        accurate = accurate && fxdb_kll_quantile(&kll, quantiles[q], &value) == 0 &&
+                   fabs(value - quantiles[q] * n) <= 0.02 * n;
+    }
+    test_assert(accurate, "Ranks within 2%");
+    test_assert(fxdb_kll_quantile(&kll, 0.0, &value) == 0 && value == 0.0, "q = 0 is the minimum");
+    test_assert(fxdb_kll_quantile(&kll, 1.0, &value) == 0 && value == n - 1, "q = 1 is the maximum");
+
+    // Test 6: Sketches of two halves merge into one of the whole
+    printf("Test 6: KLL merge\n");
+    fxdb_kll_t low, high;
+    fxdb_kll_init(&low, 0);
+    fxdb_kll_init(&high, 0);
+    for (uint32_t i = 0; i < n / 2; i++) {
+        fxdb_kll_add(&low, scramble(i, n / 2));
+        fxdb_kll_add(&high, n / 2 + scramble(i, n / 2));
+    }
+    test_assert(fxdb_kll_merge(&low, &high) == 0 && low.count == n, "Counts add up");
+    test_assert(fxdb_kll_quantile(&low, 0.5, &value) == 0 && fabs(value - n / 2) <= 0.02 * n, "Median of the whole");
+    test_assert(fxdb_kll_quantile(&low, 0.9, &value) == 0 && fabs(value - 0.9 * n) <= 0.02 * n, "90th percentile");
+
+    // Test 7: Encodings round-trip
+    printf("Test 7: KLL encoding\n");
+    encoded = malloc(fxdb_kll_encoded_size(&kll));
+    size = fxdb_kll_encode(&kll, encoded);
+    fxdb_kll_t copy;
+    fxdb_kll_init(&copy, 0);
+    test_assert(size == fxdb_kll_encoded_size(&kll) && fxdb_kll_merge_encoded(&copy, encoded, size) == 0,
+                "Encoding decodes");
+    bool same = copy.count == kll.count && copy.min == kll.min && copy.max == kll.max;
+    for (size_t q = 0; same && q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        double original;
+        same = fxdb_kll_quantile(&kll, quantiles[q], &original) == 0 &&
+               fxdb_kll_quantile(&copy, quantiles[q], &value) == 0 && fabs(value - original) <= 0.01 * n;
+    }
+    test_assert(same, "Same quantiles after decoding");
+    test_assert(fxdb_kll_merge_encoded(&copy, encoded, size - 8) != 0, "Short encoding rejected");
+    free(encoded);
+
+    fxdb_kll_reset(&kll);
+    test_assert(kll.count == 0 && fxdb_kll_quantile(&kll, 0.5, &value) != 0, "Reset empties the sketch");
+
+    fxdb_kll_free(&kll);
+    fxdb_kll_free(&low);
+    fxdb_kll_free(&high);
+    fxdb_kll_free(&copy);
+    return test_finalize();
+}
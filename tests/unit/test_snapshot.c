@@ -0,0 +1,239 @@
+#include "../test_utils.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define TEST_SNAPSHOT_FILE "test_snapshot.fxdb"
+#define CONCURRENT_ROWS 1000
+#define CONCURRENT_MAX_ROWS 20000
+#define CONCURRENT_READERS 3
+#define CONCURRENT_SNAPSHOTS 30
+
+// Append rows first..last in one writer session
+static int append_rows(const writer_config_t* config, int first, int last) {
+    return test_append_file(TEST_SNAPSHOT_FILE, config, first, last, test_row_id);
+}
+
+// Scan a reader and check that it holds ids 0..n-1 in order; returns n or -1
+static int scan_contiguous(reader_t* reader) {
+    int count = 0;
+    bool ok = true;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        ok = ok && row->values[0].value.int32_val == count;
+        count++;
+        reader_free_row(row);
+    }
+    return ok && (uint32_t)count == reader_get_row_count(reader) ? count : -1;
+}
+
+static int count_rows(void) {
+    reader_t* reader = reader_open(TEST_SNAPSHOT_FILE);
+    if (!reader) {
+        return -1;
+    }
+    int count = scan_contiguous(reader);
+    reader_close(reader);
+    return count;
+}
+
+static int read_roots(fxdb_root_t roots[2]) {
+    FILE* file = fopen(TEST_SNAPSHOT_FILE, "rb");
+    int result = file && fseek(file, offsetof(fxdb_header_t, roots), SEEK_SET) == 0 &&
+                 fread(roots, sizeof(fxdb_root_t), 2, file) == 2 ? 0 : -1;
+    if (file) fclose(file);
+    return result;
+}
+
+static int write_roots(const fxdb_root_t roots[2]) {
+    FILE* file = fopen(TEST_SNAPSHOT_FILE, "r+b");
+    int result = file && fseek(file, offsetof(fxdb_header_t, roots), SEEK_SET) == 0 &&
+                 fwrite(roots, sizeof(fxdb_root_t), 2, file) == 2 ? 0 : -1;
+    if (file) fclose(file);
+    return result;
+}
+
+static long file_size(void) {
+    FILE* file = fopen(TEST_SNAPSHOT_FILE, "rb");
+    long size = -1;
+    if (file && fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (file) fclose(file);
+    return size;
+}
+
+// Concurrent writer and readers
+typedef struct {
+    writer_config_t config;
+    int done;                   // Set by the writer, polled by the readers (atomically)
+    int failures;
+    int snapshots;
+    int rows;                   // Rows the writer committed
+} concurrent_state_t;
+
+static void* writer_thread(void* arg) {
+    concurrent_state_t* state = (concurrent_state_t*)arg;
+    writer_t* writer = writer_open_with_config(TEST_SNAPSHOT_FILE, &state->config);
+    if (!writer) {
+        __sync_fetch_and_add(&state->failures, 1);
+        __atomic_store_n(&state->done, 1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    // Keep writing until the readers have raced enough commits
+    char json[64];
+    int id = 0;
+    for (; id < CONCURRENT_MAX_ROWS &&
+           (id < CONCURRENT_ROWS || __sync_fetch_and_add(&state->snapshots, 0) < CONCURRENT_SNAPSHOTS); id++) {
+        snprintf(json, sizeof(json), "{\"id\": %d}", id);
+        if (writer_insert_json(writer, json) != 0 ||
+            (id % 5 == 4 && writer_commit(writer) != 0)) {
+            __sync_fetch_and_add(&state->failures, 1);
+            break;
+        }
+    }
+    if (writer_close(writer) != 0) {
+        __sync_fetch_and_add(&state->failures, 1);
+    }
+    writer_free(writer);
+    state->rows = id;
+    __atomic_store_n(&state->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* reader_thread(void* arg) {
+    concurrent_state_t* state = (concurrent_state_t*)arg;
+    int last = 0;
+    while (!__atomic_load_n(&state->done, __ATOMIC_ACQUIRE)) {
+        reader_t* reader = reader_open(TEST_SNAPSHOT_FILE);
+        if (!reader) {
+            __sync_fetch_and_add(&state->failures, 1);
+            break;
+        }
+
+        // A reopened reader and a refreshed one both see a whole commit
+        for (int pass = 0; pass < 3; pass++) {
+            int count = scan_contiguous(reader);
+            if (count < last) {
+                __sync_fetch_and_add(&state->failures, 1);
+            }
+            last = count;
+            __sync_fetch_and_add(&state->snapshots, 1);
+            if (reader_refresh(reader) != 0) {
+                __sync_fetch_and_add(&state->failures, 1);
+            }
+        }
+        reader_close(reader);
+    }
+    return NULL;
+}
+
+static int run_concurrent(const writer_config_t* config, int* rows, int* snapshots) {
+    concurrent_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.config = *config;
+
+    pthread_t writer;
+    pthread_t readers[CONCURRENT_READERS];
+    pthread_create(&writer, NULL, writer_thread, &state);
+    for (int i = 0; i < CONCURRENT_READERS; i++) {
+        pthread_create(&readers[i], NULL, reader_thread, &state);
+    }
+    pthread_join(writer, NULL);
+    for (int i = 0; i < CONCURRENT_READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    *rows = state.rows;
+    *snapshots = state.snapshots;
+    return state.failures;
+}
+
+static int create_database(const schema_t* schema, const writer_config_t* config) {
+    cleanup_test_files();
+    return test_write_file_with_config(TEST_SNAPSHOT_FILE, schema, config, 0, 0, test_row_id);
+}
+
+int main(void) {
+    test_init("Snapshot Tests");
+
+    schema_t* schema = parse_schema("id int32");
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 16;
+    test_assert_equal_int(0, schema ? create_database(schema, &config) : -1, "Create database");
+
+    // Test 1: A torn newest root falls back to the previous commit
+    printf("Test 1: Torn commit root\n");
+    append_rows(&config, 0, 9);
+    append_rows(&config, 10, 19);
+    fxdb_root_t roots[2];
+    test_assert_equal_int(0, read_roots(roots), "Read commit roots");
+    int newest = (int16_t)(roots[1].sequence - roots[0].sequence) > 0 ? 1 : 0;
+    test_assert(roots[newest].total_rows == 20 && roots[1 - newest].total_rows == 10,
+                "Newest root holds the last commit");
+
+    reader_t* reader = reader_open(TEST_SNAPSHOT_FILE);
+    reader_snapshot_t snapshot;
+    reader_get_snapshot(reader, &snapshot);
+    test_assert(snapshot.sequence == roots[newest].sequence && snapshot.committed_rows == 20 &&
+                snapshot.chunk_count == 2, "Reader pins the newest root");
+    reader_close(reader);
+
+    roots[newest].total_rows ^= 0x40;
+    write_roots(roots);
+    test_assert_equal_int(10, count_rows(), "Previous commit read instead");
+
+    // Test 2: Files without roots use the legacy header fields
+    printf("Test 2: Legacy header\n");
+    roots[newest].total_rows ^= 0x40;
+    fxdb_root_t legacy[2];
+    memset(legacy, 0, sizeof(legacy));
+    test_assert_equal_int(0, write_roots(legacy), "Zero both roots");
+    reader = reader_open(TEST_SNAPSHOT_FILE);
+    reader_get_snapshot(reader, &snapshot);
+    test_assert(reader && snapshot.sequence == 0 && scan_contiguous(reader) == 20, "Legacy file readable");
+    reader_close(reader);
+    test_assert_equal_int(0, append_rows(&config, 20, 24), "Append to legacy file");
+    test_assert_equal_int(25, count_rows(), "Appended rows readable");
+    test_assert(read_roots(roots) == 0 && (roots[0].sequence != 0 || roots[1].sequence != 0),
+                "Append publishes a root");
+
+    // Test 3: Bytes past the committed data are dropped by the next writer
+    printf("Test 3: Unpublished tail\n");
+    long committed = file_size();
+    FILE* file = fopen(TEST_SNAPSHOT_FILE, "ab");
+    for (int i = 0; file && i < 100; i++) {
+        fputc(0xEE, file);
+    }
+    if (file) fclose(file);
+    test_assert_equal_int(25, count_rows(), "Readers ignore the tail");
+    test_assert_equal_int(0, append_rows(&config, 25, 29), "Append after the tail");
+    test_assert_equal_int(30, count_rows(), "Tail replaced by the new rows");
+    test_assert(file_size() < committed + 100, "Tail truncated");
+
+    // Test 4: Readers see whole commits while a writer appends
+    printf("Test 4: Concurrent readers\n");
+    int rows = 0;
+    int snapshots = 0;
+    config.durability = FXDB_DURABILITY_FLUSH;
+    create_database(schema, &config);
+    test_assert_equal_int(0, run_concurrent(&config, &rows, &snapshots), "Every snapshot contiguous");
+    test_assert_equal_int(rows, count_rows(), "All rows written");
+    printf("   %d rows, %d snapshots scanned\n", rows, snapshots);
+
+    writer_config_t wal_config = config;
+    wal_config.use_wal = true;
+    create_database(schema, &wal_config);
+    test_assert_equal_int(0, run_concurrent(&wal_config, &rows, &snapshots), "Every snapshot contiguous with a log");
+    test_assert_equal_int(rows, count_rows(), "All logged rows written");
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -0,0 +1,195 @@
+#include "../test_utils.h"
+#include "../../include/sort.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#define TEST_SORT_PREFIX "test_sort_runs"
+
+// Lay out a row as in a chunk
+static void make_row(const schema_t* schema, int32_t id, float score, bool null_score, const char* name,
+                     uint8_t* buffer, uint64_t* null_fields) {
+    field_value_t values[3];
+    memset(values, 0, sizeof(values));
+    values[0].field_name = "id";
+    values[0].value.int32_val = id;
+    values[1].field_name = "score";
+    values[1].value.float_val = score;
+    values[1].is_null = null_score;
+    values[2].field_name = "name";
+    values[2].value.string_val = name;
+    serialize_row(schema, values, 3, buffer);
+    *null_fields = null_score ? 1ULL << 1 : 0;
+}
+
+static int32_t row_id(const uint8_t* row) {
+    int32_t id;
+    memcpy(&id, row, sizeof(id));
+    return id;
+}
+
+// Runs left behind in the working directory
+static int count_runs(void) {
+    int count = 0;
+    DIR* dir = opendir(".");
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, TEST_SORT_PREFIX ".sort", strlen(TEST_SORT_PREFIX ".sort")) == 0) {
+            count++;
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    return count;
+}
+
+// Add `count` rows with pseudo-random ids, then check they come out ascending
+static bool sort_random(const schema_t* schema, const fxdb_sort_options_t* options, uint32_t count,
+                        fxdb_sort_stats_t* stats) {
+    fxdb_sorter_t* sorter = fxdb_sorter_create(schema, options);
+    if (!sorter) {
+        return false;
+    }
+
+    uint8_t* row = malloc(schema->row_size);
+    uint64_t null_fields;
+    uint32_t seed = 12345;
+    bool ok = row != NULL;
+    for (uint32_t i = 0; i < count && ok; i++) {
+        seed = seed * 1103515245 + 12345;
+        make_row(schema, (int32_t)(seed >> 8) - (1 << 22), 0.0f, false, "r", row, &null_fields);
+        ok = fxdb_sorter_add(sorter, row, null_fields) == 0;
+    }
+    ok = ok && fxdb_sorter_finish(sorter) == 0;
+
+    const uint8_t* out;
+    uint32_t produced = 0;
+    int32_t last = INT32_MIN;
+    while (ok && fxdb_sorter_next(sorter, &out, &null_fields) == 1) {
+        ok = row_id(out) >= last;
+        last = row_id(out);
+        produced++;
+    }
+    fxdb_sorter_stats(sorter, stats);
+    fxdb_sorter_free(sorter);
+    free(row);
+    return ok && produced == count;
+}
+
+int main(void) {
+    test_init("Sort Tests");
+
+    schema_t* schema = parse_schema("id int32, score float?, name string");
+    test_assert_not_null(schema, "Schema creation");
+    if (!schema) {
+        return test_finalize();
+    }
+
+    uint8_t* row = malloc(schema->row_size);
+    uint64_t null_fields;
+    const uint8_t* out;
+
+    // Test 1: Floats order by value, NULLs first, ties in the order added
+    printf("Test 1: In-memory sort\n");
+    const float scores[] = { 2.5f, -1.0f, 0.0f, -7.25f, 2.5f, 10.0f };
+    fxdb_sort_options_t options = fxdb_sort_default_options(1);
+    fxdb_sorter_t* sorter = fxdb_sorter_create(schema, &options);
+    test_assert_not_null(sorter, "Create sorter");
+    for (int i = 0; sorter && i < 6; i++) {
+        make_row(schema, i, scores[i], false, "x", row, &null_fields);
+        fxdb_sorter_add(sorter, row, null_fields);
+    }
+    make_row(schema, 6, 0.0f, true, "x", row, &null_fields);
+    fxdb_sorter_add(sorter, row, null_fields);
+    test_assert_equal_int(0, fxdb_sorter_finish(sorter), "Finish");
+
+    const int32_t expected[] = { 6, 3, 1, 2, 0, 4, 5 };
+    bool in_order = true;
+    int produced = 0;
+    while (fxdb_sorter_next(sorter, &out, &null_fields) == 1) {
+        in_order = in_order && produced < 7 && row_id(out) == expected[produced];
+        if (produced == 0) {
+            test_assert(null_fields == 1ULL << 1, "NULL field carried through");
+        }
+        produced++;
+    }
+    test_assert(in_order && produced == 7, "Rows in order");
+    fxdb_sort_stats_t stats;
+    fxdb_sorter_stats(sorter, &stats);
+    test_assert(stats.rows == 7 && stats.runs == 0 && !stats.heap, "Sorted in memory");
+    fxdb_sorter_free(sorter);
+
+    // Test 2: Descending strings
+    printf("Test 2: Descending strings\n");
+    const char* names[] = { "pear", "apple", "zebra", "mango" };
+    options = fxdb_sort_default_options(2);
+    options.descending = true;
+    sorter = fxdb_sorter_create(schema, &options);
+    for (int i = 0; sorter && i < 4; i++) {
+        make_row(schema, i, 0.0f, false, names[i], row, &null_fields);
+        fxdb_sorter_add(sorter, row, null_fields);
+    }
+    fxdb_sorter_finish(sorter);
+    const int32_t expected_names[] = { 2, 0, 3, 1 };
+    in_order = true;
+    for (int i = 0; i < 4; i++) {
+        in_order = in_order && fxdb_sorter_next(sorter, &out, &null_fields) == 1 && row_id(out) == expected_names[i];
+    }
+    test_assert(in_order, "Strings descending");
+    test_assert_equal_int(0, fxdb_sorter_next(sorter, &out, &null_fields), "End of rows");
+    fxdb_sorter_free(sorter);
+
+    // Test 3: A top-N heap keeps the first rows, earlier ones winning ties
+    printf("Test 3: Top-N heap\n");
+    options = fxdb_sort_default_options(0);
+    options.top_n = 3;
+    sorter = fxdb_sorter_create(schema, &options);
+    for (int i = 0; sorter && i < 1000; i++) {
+        // Ids 999 down to 0, then another 2 that must not displace the first
+        make_row(schema, 999 - i, (float)i, false, "x", row, &null_fields);
+        fxdb_sorter_add(sorter, row, null_fields);
+    }
+    make_row(schema, 2, -1.0f, false, "x", row, &null_fields);
+    fxdb_sorter_add(sorter, row, null_fields);
+    fxdb_sorter_finish(sorter);
+    float last_score = 0.0f;
+    in_order = true;
+    for (int i = 0; i < 3; i++) {
+        in_order = in_order && fxdb_sorter_next(sorter, &out, &null_fields) == 1 && row_id(out) == i;
+        if (in_order && i == 2) {
+            memcpy(&last_score, out + schema_field_offset(schema, 1), sizeof(float));
+        }
+    }
+    test_assert(in_order, "Three smallest ids");
+    test_assert(last_score == 997.0f, "Tie kept the row added first");
+    test_assert_equal_int(0, fxdb_sorter_next(sorter, &out, &null_fields), "Only three rows");
+    fxdb_sorter_stats(sorter, &stats);
+    test_assert(stats.heap && stats.rows == 1001 && stats.runs == 0, "Heap stats");
+    fxdb_sorter_free(sorter);
+
+    // Test 4: Many segments in memory, sorted on several threads
+    printf("Test 4: Parallel in-memory sort\n");
+    options = fxdb_sort_default_options(0);
+    options.memory_limit = 16u << 20;
+    options.threads = 4;
+    test_assert(sort_random(schema, &options, 20000, &stats), "20000 rows ascending");
+    test_assert(stats.runs == 0 && stats.segments > 1, "Several segments, no runs");
+
+    // Test 5: Rows beyond the memory budget spill to runs merged in several passes
+    printf("Test 5: External merge sort\n");
+    options.memory_limit = FXDB_SORT_SEGMENTS * 16 * fxdb_sort_row_bytes(schema);
+    options.temp_prefix = TEST_SORT_PREFIX;
+    test_assert(sort_random(schema, &options, 20000, &stats), "20000 rows ascending through runs");
+    test_assert(stats.runs > FXDB_SORT_MAX_FANIN, "More runs than one merge takes");
+    test_assert(stats.merge_passes > 1, "Intermediate merge passes");
+    test_assert(stats.bytes_spilled > 0 && stats.threads == 4, "Spill stats");
+    test_assert_equal_int(0, count_runs(), "Runs removed");
+
+    free(row);
+    free_schema(schema);
+    return test_finalize();
+}
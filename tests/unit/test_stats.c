@@ -0,0 +1,195 @@
+#include "../test_utils.h"
+#include "../../include/stats.h"
+#include "../../include/chunk_cache.h"
+#include "../../include/reader.h"
+#include "../../include/writer.h"
+#include "../../include/schema.h"
+#include "../../include/protocol.h" // Its operation codes must not clash with the latency ones
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+
+#define TEST_STATS_FILE "test_stats.fxdb"
+#define TEST_TRACE_FILE "test_stats_trace.json"
+
+// Write 35 rows, 10 per chunk, synced to disk
+static int write_file(const schema_t* schema) {
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 10;
+    config.durability = FXDB_DURABILITY_FSYNC;
+    return test_write_file_with_config(TEST_STATS_FILE, schema, &config, 35, 0, test_row_id_name);
+}
+
+// Read every row; returns the row count, -1 on failure
+static int scan(void) {
+    reader_t* reader = reader_open(TEST_STATS_FILE);
+    if (!reader) {
+        return -1;
+    }
+
+    int count = 0;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        reader_free_row(row);
+        count++;
+    }
+    reader_close(reader);
+    return count;
+}
+
+static void* scan_thread(void* arg) {
+    *(int*)arg = scan();
+    return NULL;
+}
+
+int main(void) {
+    test_init("Statistics Tests");
+
+    cleanup_test_files();
+    schema_t* schema = parse_schema("id int32, name string");
+    test_assert_not_null(schema, "Schema creation");
+
+    // Test 1: A reset starts every counter from zero
+    printf("Test 1: Reset\n");
+    fxdb_reset_statistics();
+    db_statistics_t stats;
+    fxdb_get_statistics(&stats);
+    test_assert(stats.bytes_read == 0 && stats.bytes_written == 0 && stats.rows_decoded == 0 &&
+                stats.chunks_loaded == 0 && stats.sync_calls == 0, "Counters start at zero");
+
+    // Test 2: Writes count rows, chunks, bytes and syncs
+    printf("Test 2: Writer counters\n");
+    test_assert_equal_int(0, schema ? write_file(schema) : -1, "Write 4 chunks");
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(35, (int)stats.rows_encoded, "Every row encoded");
+    test_assert_equal_int(4, (int)stats.chunks_written, "Every chunk written");
+    test_assert(stats.write_ops > 0 && stats.bytes_written > 35 * schema->row_size, "Chunk bytes written");
+    test_assert(stats.sync_calls > 0, "Syncs counted under FXDB_DURABILITY_FSYNC");
+    test_assert(stats.total_writes == stats.write_ops, "total_writes mirrors write operations");
+
+    // Test 3: A cold scan reads and decodes each chunk once
+    printf("Test 3: Reader counters\n");
+    fxdb_chunk_cache_purge();
+    fxdb_reset_statistics();
+    test_assert_equal_int(35, scan(), "Scan reads every row");
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(35, (int)stats.rows_decoded, "Every row decoded");
+    test_assert_equal_int(35 * 3, (int)stats.allocations, "Row, values and string allocated per row");
+    test_assert_equal_int(4, (int)stats.chunks_loaded, "Every chunk loaded");
+    test_assert(stats.read_calls >= 4 && stats.bytes_read >= 35 * schema->row_size, "Chunk bytes read");
+    uint64_t cold_bytes = stats.bytes_read;
+
+    // Test 4: A warm scan loads chunks from the cache without reading
+    printf("Test 4: Cached scan\n");
+    test_assert_equal_int(35, scan(), "Second scan reads every row");
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(8, (int)stats.chunks_loaded, "Chunks loaded again");
+    test_assert(stats.bytes_read == cold_bytes, "Cached chunks are not read again");
+    test_assert(stats.cache_hits >= 4, "Cache hits are reported");
+
+    // Test 5: Counters of an exited thread are kept
+    printf("Test 5: Thread counters\n");
+    int rows = -1;
+    pthread_t thread;
+    test_assert(pthread_create(&thread, NULL, scan_thread, &rows) == 0 && pthread_join(thread, NULL) == 0,
+                "Scan on another thread");
+    test_assert_equal_int(35, rows, "Thread reads every row");
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(105, (int)stats.rows_decoded, "Thread's rows counted after it exits");
+
+    // Test 6: Aggregates count the rows they fold in, none of them from chunk summaries
+    printf("Test 6: Aggregate counters\n");
+    fxdb_reset_statistics();
+    reader_t* reader = reader_open(TEST_STATS_FILE);
+    column_aggregate_t aggregate;
+    test_assert(reader && reader_aggregate_column(reader, 0, &aggregate) == 0 && aggregate.row_count == 35,
+                "Aggregate column from summaries");
+    reader_close(reader);
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(0, (int)stats.rows_decoded, "Summarized rows not decoded");
+    remove(TEST_STATS_FILE ".sum");
+    reader = reader_open(TEST_STATS_FILE);
+    test_assert(reader && reader_aggregate_column(reader, 0, &aggregate) == 0, "Aggregate column");
+    reader_close(reader);
+    fxdb_get_statistics(&stats);
+    test_assert_equal_int(35, (int)stats.rows_decoded, "Aggregated rows counted");
+    test_assert(stats.allocations == 0, "Aggregates do not allocate rows");
+
+    // Test 7: Log-linear buckets stay within 1/16 of their values
+    printf("Test 7: Histogram buckets\n");
+    test_assert(fxdb_histogram_bucket(0) == 0 && fxdb_histogram_bucket(15) == 15, "Small values get a bucket each");
+    test_assert(fxdb_histogram_bucket(16) == 16 && fxdb_histogram_bucket(32) == 32, "Powers of two start a bucket");
+    test_assert(fxdb_histogram_bucket(33) == 32 && fxdb_histogram_bucket(34) == 33, "Buckets widen above 32");
+    test_assert(fxdb_histogram_bucket(UINT64_MAX) == FXDB_HISTOGRAM_BUCKETS - 1, "Huge values land in the last bucket");
+    bool limits_ok = true;
+    for (uint64_t v = 1; v < (1ULL << 40); v = v * 3 + 1) {
+        uint64_t limit = fxdb_histogram_bucket_limit(fxdb_histogram_bucket(v));
+        limits_ok = limits_ok && limit >= v && limit - v <= v / 16;
+    }
+    test_assert(limits_ok, "Bucket limits bound their values within 1/16");
+
+    // Test 8: Percentiles report the bucket holding the rank
+    printf("Test 8: Percentiles\n");
+    fxdb_histogram_t* histogram = calloc(1, sizeof(fxdb_histogram_t));
+    test_assert_not_null(histogram, "Allocate histogram");
+    if (histogram) {
+        for (uint64_t v = 1; v <= 1000; v++) {
+            fxdb_histogram_record(histogram, v);
+        }
+        fxdb_histogram_record_n(histogram, 100000, 10);
+        uint64_t p50 = fxdb_histogram_percentile(histogram, 0.5);
+        uint64_t p99 = fxdb_histogram_percentile(histogram, 0.99);
+        test_assert_equal_int(1010, (int)histogram->count, "Weighted values counted");
+        test_assert(p50 >= 505 && p50 <= 540, "p50 near the median");
+        test_assert(p99 >= 990 && p99 <= 1024, "p99 below the outliers");
+        test_assert(fxdb_histogram_percentile(histogram, 1.0) == 100000, "p100 is the maximum");
+        free(histogram);
+    }
+
+    // Test 9: Public operations record their latency
+    printf("Test 9: Operation latency\n");
+    fxdb_reset_statistics();
+    test_assert_equal_int(0, schema ? write_file(schema) : -1, "Write file");
+    test_assert_equal_int(35, scan(), "Scan file");
+    fxdb_latency_summary_t summary;
+    fxdb_get_latency_summary(FXDB_LATENCY_OPEN, &summary);
+    test_assert_equal_int(2, (int)summary.count, "Writer and reader opens timed");
+    fxdb_get_latency_summary(FXDB_LATENCY_CLOSE, &summary);
+    test_assert_equal_int(2, (int)summary.count, "Writer and reader closes timed");
+    fxdb_get_latency_summary(FXDB_LATENCY_FLUSH, &summary);
+    test_assert(summary.count >= 4 && summary.p50_ns > 0 && summary.max_ns >= summary.p50_ns, "Flushes timed");
+    fxdb_get_latency_summary(FXDB_LATENCY_INSERT, &summary);
+    // Inserts after the last timed one are not counted
+    test_assert(summary.count + FXDB_STATS_INSERT_SAMPLE > 35 && summary.count <= 35,
+                "Sampled inserts stand for the inserts before them");
+    fxdb_get_latency_summary(FXDB_LATENCY_CHUNK_LOAD, &summary);
+    test_assert_equal_int(4, (int)summary.count, "Chunk loads timed");
+
+    // Test 10: Tracing writes Chrome trace events
+    printf("Test 10: Trace spans\n");
+    test_assert_equal_int(0, fxdb_trace_start(TEST_TRACE_FILE), "Start trace");
+    test_assert_equal_int(35, scan(), "Traced scan");
+    fxdb_trace_stop();
+    char trace[16384] = {0};
+    FILE* file = fopen(TEST_TRACE_FILE, "r");
+    size_t length = file ? fread(trace, 1, sizeof(trace) - 1, file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    while (length > 0 && (trace[length - 1] == '\n' || trace[length - 1] == ' ')) {
+        trace[--length] = '\0';
+    }
+    test_assert(length > 0 && trace[0] == '[' && trace[length - 1] == ']', "Trace is a JSON array");
+    test_assert(strstr(trace, "\"reader_open\"") != NULL && strstr(trace, "\"ph\":\"X\"") != NULL,
+                "Spans are complete events");
+    test_assert(strstr(trace, "chunk_load") != NULL, "Chunk loads traced");
+    remove(TEST_TRACE_FILE);
+
+    if (schema) {
+        free_schema(schema);
+    }
+
+    cleanup_test_files();
+    return test_finalize();
+}
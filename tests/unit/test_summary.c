@@ -0,0 +1,207 @@
+#include "../test_utils.h"
+#include "../../include/summary.h"
+#include "../../include/compact.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_SUMMARY_FILE "test_summary.fxdb"
+#define TEST_SUMMARY_SIDECAR TEST_SUMMARY_FILE ".sum"
+#define ROW_COUNT 1000
+#define CHUNK_ROWS 100
+
+// Every tenth score is NULL and names repeat every 50 rows
+static void summary_row(int id, char* json, size_t size) {
+    if (id % 10 == 0) {
+        snprintf(json, size, "{\"id\": %d, \"name\": \"n%d\", \"score\": null}", id, id % 50);
+    } else {
+        snprintf(json, size, "{\"id\": %d, \"name\": \"n%d\", \"score\": %d.5}", id, id % 50, id);
+    }
+}
+
+// Append rows first..last, creating the file first when asked; a created file starts at row 0
+static int append_rows(const writer_config_t* config, bool create, int first, int last) {
+    if (!create) {
+        return test_append_file(TEST_SUMMARY_FILE, config, first, last, summary_row);
+    }
+    schema_t* schema = parse_schema("id int32, name string, score float?");
+    int result = schema ? test_write_file_with_config(TEST_SUMMARY_FILE, schema, config, last + 1, 0, summary_row)
+                        : -1;
+    free_schema(schema);
+    return result;
+}
+
+// Sketch every field of the file
+static int sketch_file(fxdb_column_sketch_t* sketches, fxdb_summary_stats_t* stats) {
+    for (uint32_t f = 0; f < 3; f++) {
+        summary_sketch_init(&sketches[f]);
+    }
+    reader_t* reader = reader_open(TEST_SUMMARY_FILE);
+    int result = reader ? summary_sketch_columns(reader, 0x7, sketches, stats) : -1;
+    reader_close(reader);
+    return result;
+}
+
+static void free_sketches(fxdb_column_sketch_t* sketches) {
+    for (uint32_t f = 0; f < 3; f++) {
+        summary_sketch_free(&sketches[f]);
+    }
+}
+
+static bool near(double estimate, double expected, double tolerance) {
+    return fabs(estimate - expected) <= tolerance * expected;
+}
+
+// Aggregate of scores over rows first..end - 1 as written by append_rows(), rows 300-309 deleted
+static column_aggregate_t expected_scores(uint32_t first, uint32_t end) {
+    column_aggregate_t expected = { 0, 0, 0.0, INFINITY, -INFINITY, 0, 0 };
+    for (uint32_t id = first; id < end; id++) {
+        if (id >= 300 && id < 310) {
+            continue;
+        }
+        expected.row_count++;
+        if (id % 10 != 0) {
+            double score = id + 0.5;
+            expected.value_count++;
+            expected.sum += score;
+            expected.min = score < expected.min ? score : expected.min;
+            expected.max = score > expected.max ? score : expected.max;
+        }
+    }
+    return expected;
+}
+
+static bool same_aggregate(const column_aggregate_t* a, const column_aggregate_t* b) {
+    return a->row_count == b->row_count && a->value_count == b->value_count && a->sum == b->sum &&
+           a->min == b->min && a->max == b->max;
+}
+
+static long file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+int main(void) {
+    test_init("Summary Tests");
+
+    cleanup_test_files();
+    writer_config_t config = writer_default_config();
+    config.chunk_size = CHUNK_ROWS;
+    fxdb_column_sketch_t sketches[3];
+    fxdb_summary_stats_t stats;
+    double value;
+
+    // Test 1: Every chunk written is summarized, and sketches come from the summaries alone
+    printf("Test 1: Sketches from summaries\n");
+    test_assert_equal_int(0, append_rows(&config, true, 0, ROW_COUNT - 1), "Write rows");
+    test_assert(file_size(TEST_SUMMARY_SIDECAR) > 0, "Summary file written");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == ROW_COUNT / CHUNK_ROWS && stats.chunks_scanned == 0 &&
+                stats.row_count == ROW_COUNT, "No chunk read");
+    test_assert(near(fxdb_hll_estimate(&sketches[0].distinct), ROW_COUNT, 0.03), "Distinct ids");
+    test_assert(near(fxdb_hll_estimate(&sketches[1].distinct), 50, 0.03), "Distinct names");
+    test_assert(sketches[2].value_count == ROW_COUNT - ROW_COUNT / 10, "NULL scores left out");
+    test_assert(fxdb_kll_quantile(&sketches[0].quantiles, 0.5, &value) == 0 && fabs(value - ROW_COUNT / 2) <= 20,
+                "Median id");
+    test_assert(sketches[1].quantiles.count == 0, "No quantiles of strings");
+    free_sketches(sketches);
+
+    // Test 2: Chunks with deleted rows, and the log's rows, are read instead
+    printf("Test 2: Deletes and log rows\n");
+    reader_t* reader = reader_open(TEST_SUMMARY_FILE);
+    row_position_t positions[10];
+    for (uint32_t i = 0; i < 10; i++) {
+        positions[i].chunk_index = 3;
+        positions[i].row_in_chunk = i;
+    }
+    test_assert(reader && reader_delete_rows(reader, positions, 10) == 0, "Delete ten rows of chunk 3");
+    reader_close(reader);
+    writer_config_t logged = config;
+    logged.use_wal = true;
+    test_assert_equal_int(0, append_rows(&logged, false, ROW_COUNT, ROW_COUNT + 49), "Log 50 rows");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == ROW_COUNT / CHUNK_ROWS - 1 && stats.chunks_scanned == 2,
+                "Chunk 3 and the log read");
+    test_assert(stats.row_count == ROW_COUNT + 40 && sketches[0].value_count == ROW_COUNT + 40,
+                "Deleted rows left out, log rows counted");
+    free_sketches(sketches);
+
+    // Test 3: Compaction writes the summaries of its chunks
+    printf("Test 3: Compaction\n");
+    compact_options_t options = compact_default_options();
+    options.threads = 4;
+    test_assert_equal_int(0, compact_database(TEST_SUMMARY_FILE, &options, NULL), "Compact");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == 11 && stats.chunks_scanned == 0 && stats.row_count == ROW_COUNT + 40,
+                "Every new chunk summarized");
+    test_assert(near(fxdb_hll_estimate(&sketches[0].distinct), ROW_COUNT + 40, 0.03), "Distinct ids");
+    free_sketches(sketches);
+
+    // Test 4: A torn summary is read around, and cut off by the next writer
+    printf("Test 4: Torn summary\n");
+    test_assert(truncate(TEST_SUMMARY_SIDECAR, file_size(TEST_SUMMARY_SIDECAR) - 5) == 0, "Tear the last record");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == 10 && stats.chunks_scanned == 1, "Last chunk read");
+    free_sketches(sketches);
+    test_assert_equal_int(0, append_rows(&config, false, 2000, 2099), "Append a chunk");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == 11 && stats.chunks_scanned == 1, "New chunk summarized after the cut");
+    free_sketches(sketches);
+
+    // Test 5: Without summaries every chunk is read, with the same answers
+    printf("Test 5: Summaries off\n");
+    config.chunk_summaries = false;
+    test_assert_equal_int(0, append_rows(&config, true, 0, ROW_COUNT - 1), "Rewrite rows");
+    test_assert(access(TEST_SUMMARY_SIDECAR, F_OK) != 0, "Old summaries removed");
+    test_assert_equal_int(0, sketch_file(sketches, &stats), "Sketch columns");
+    test_assert(stats.chunks_summarized == 0 && stats.chunks_scanned == ROW_COUNT / CHUNK_ROWS, "Every chunk read");
+    test_assert(near(fxdb_hll_estimate(&sketches[1].distinct), 50, 0.03) &&
+                sketches[2].value_count == ROW_COUNT - ROW_COUNT / 10, "Same estimates");
+    free_sketches(sketches);
+
+    // Test 6: Aggregates fold in the chunks a range covers whole and read its ends
+    printf("Test 6: Aggregates\n");
+    config.chunk_summaries = true;
+    test_assert_equal_int(0, append_rows(&config, true, 0, ROW_COUNT - 1), "Rewrite rows");
+    reader = reader_open(TEST_SUMMARY_FILE);
+    test_assert(reader && reader_delete_rows(reader, positions, 10) == 0, "Delete ten rows of chunk 3");
+    reader_close(reader);
+    test_assert_equal_int(0, append_rows(&logged, false, ROW_COUNT, ROW_COUNT + 49), "Log 50 rows");
+
+    column_aggregate_t aggregate, expected;
+    reader = reader_open(TEST_SUMMARY_FILE);
+    expected = expected_scores(0, ROW_COUNT + 50);
+    test_assert(reader && reader_aggregate_column(reader, 2, &aggregate) == 0 && same_aggregate(&aggregate, &expected),
+                "Whole file matches the rows");
+    test_assert(aggregate.chunks_summarized == 9 && aggregate.chunks_scanned == 2, "Chunk 3 and the log read");
+
+    expected = expected_scores(150, 650);
+    test_assert(reader && reader_aggregate_rows(reader, 2, 150, 650, &aggregate) == 0 &&
+                same_aggregate(&aggregate, &expected), "Range matches the rows");
+    test_assert(aggregate.chunks_summarized == 3 && aggregate.chunks_scanned == 3, "Only its ends and chunk 3 read");
+
+    expected = expected_scores(950, 1020);
+    test_assert(reader && reader_aggregate_rows(reader, 2, 950, 1020, &aggregate) == 0 &&
+                same_aggregate(&aggregate, &expected), "Range into the log");
+    test_assert(aggregate.chunks_summarized == 0 && aggregate.chunks_scanned == 2, "Partial chunks read");
+    test_assert(reader && reader_aggregate_rows(reader, 1, 0, ROW_COUNT, &aggregate) == 0 &&
+                aggregate.value_count == ROW_COUNT - 10 && aggregate.min == 0.0 && aggregate.chunks_summarized == 9,
+                "Strings counted from summaries");
+    reader_close(reader);
+
+    test_assert_equal_int(0, summary_remove(TEST_SUMMARY_FILE), "Remove summaries");
+    reader = reader_open(TEST_SUMMARY_FILE);
+    expected = expected_scores(0, ROW_COUNT + 50);
+    test_assert(reader && reader_aggregate_column(reader, 2, &aggregate) == 0 && same_aggregate(&aggregate, &expected) &&
+                aggregate.chunks_summarized == 0 && aggregate.chunks_scanned == 11, "Same answer from the rows alone");
+    reader_close(reader);
+
+    cleanup_test_files();
+    return test_finalize();
+}
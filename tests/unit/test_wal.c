@@ -0,0 +1,209 @@
+#include "../test_utils.h"
+#include "../../include/wal.h"
+#include "../../include/writer.h"
+#include "../../include/reader.h"
+#include "../../include/schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_WAL_FILE "test_wal.fxdb"
+#define TEST_WAL_LOG TEST_WAL_FILE ".wal"
+
+// Open the test database with a write-ahead log
+static writer_t* open_wal_writer(void) {
+    writer_config_t config = writer_default_config();
+    config.use_wal = true;
+    return writer_open_with_config(TEST_WAL_FILE, &config);
+}
+
+// Every third note is NULL
+static void note_row(int id, char* json, size_t size) {
+    if (id % 3 == 0) {
+        snprintf(json, size, "{\"id\": %d, \"note\": null}", id);
+    } else {
+        snprintf(json, size, "{\"id\": %d, \"note\": \"n%d\"}", id, id);
+    }
+}
+
+// Insert rows first..last, committing after each like a single-row insert
+static int insert_committed(writer_t* writer, int first, int last) {
+    return test_append_rows(writer, first, last, 1, note_row);
+}
+
+// Scan the file and check ids 0..expected-1 appear in order with their NULLs
+static bool scan_matches(int expected) {
+    reader_t* reader = reader_open(TEST_WAL_FILE);
+    if (!reader || (int)reader_get_row_count(reader) != expected) {
+        reader_close(reader);
+        return false;
+    }
+
+    int count = 0;
+    bool ok = true;
+    row_data_t* row;
+    while ((row = reader_read_row(reader)) != NULL) {
+        ok = ok && row->values[0].value.int32_val == count &&
+             row->values[1].is_null == (count % 3 == 0);
+        free((char*)row->values[1].value.string_val);
+        reader_free_row(row);
+        count++;
+    }
+    reader_close(reader);
+    return ok && count == expected;
+}
+
+static uint32_t chunks_on_disk(void) {
+    reader_t* reader = reader_open(TEST_WAL_FILE);
+    uint32_t chunks = reader ? reader->header.chunk_count : 0;
+    reader_close(reader);
+    return chunks;
+}
+
+static bool file_exists(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        fclose(file);
+    }
+    return file != NULL;
+}
+
+// Read a whole file into memory
+static char* slurp(const char* path, long* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    rewind(file);
+    char* data = malloc(*size > 0 ? *size : 1);
+    if (data && fread(data, 1, *size, file) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+int main(void) {
+    test_init("Write-Ahead Log Tests");
+
+    cleanup_test_files();
+
+    schema_t* schema = parse_schema("id int32, note string?");
+    int created = schema ? test_write_file(TEST_WAL_FILE, schema, 8, 0, note_row) : -1;
+    test_assert_equal_int(0, created, "Create database");
+    if (created != 0) {
+        free_schema(schema);
+        return test_finalize();
+    }
+
+    // Test 1: Commits go to the log, not into one chunk per row
+    printf("Test 1: Committed rows are logged\n");
+    writer_t* writer = open_wal_writer();
+    test_assert_not_null(writer, "Open WAL writer");
+    test_assert_equal_int(0, writer ? insert_committed(writer, 0, 4) : -1, "Five single-row commits");
+    test_assert_equal_int(0, (int)chunks_on_disk(), "No chunk written yet");
+    test_assert(file_exists(TEST_WAL_LOG), "Log file created");
+    test_assert(scan_matches(5), "Reader replays the log");
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 2: A reopened writer continues the log and checkpoints a full chunk
+    printf("Test 2: Checkpoint into full chunks\n");
+    writer = open_wal_writer();
+    test_assert(writer && writer->buffer_row_count == 5, "Log rows resume the fill buffer");
+    test_assert(writer && writer->wal_unloaded_rows == 5, "Log rows left in the log until a checkpoint");
+    test_assert_equal_int(0, writer ? insert_committed(writer, 5, 9) : -1, "Commits across the chunk boundary");
+    test_assert_equal_int(1, (int)chunks_on_disk(), "One full chunk checkpointed");
+    test_assert(scan_matches(10), "Chunk rows followed by log rows");
+
+    reader_t* reader = reader_open(TEST_WAL_FILE);
+    test_assert(reader && reader_seek_row(reader, 9) == 0, "Seek into the log rows");
+    row_data_t* row = reader ? reader_read_row(reader) : NULL;
+    test_assert(row && row->values[0].value.int32_val == 9, "Seeked row comes from the log");
+    if (row) {
+        free((char*)row->values[1].value.string_val);
+    }
+    reader_free_row(row);
+    reader_close(reader);
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 3: A torn tail is ignored and cut off by the next writer
+    printf("Test 3: Torn tail\n");
+    FILE* log = fopen(TEST_WAL_LOG, "ab");
+    if (log) {
+        fwrite("torn", 1, 4, log);
+        fclose(log);
+    }
+    test_assert(scan_matches(10), "Partial record skipped on replay");
+    writer = open_wal_writer();
+    test_assert_equal_int(0, writer ? insert_committed(writer, 10, 10) : -1, "Append after torn tail");
+    test_assert(scan_matches(11), "New record follows the valid prefix");
+    writer_close(writer);
+    writer_free(writer);
+
+    // Test 4: A log from before a checkpoint is stale
+    printf("Test 4: Stale log\n");
+    long log_size = 0;
+    char* saved = slurp(TEST_WAL_LOG, &log_size);
+    test_assert_not_null(saved, "Save log");
+    writer = open_wal_writer();
+    test_assert_equal_int(0, writer ? writer_checkpoint(writer) : -1, "Explicit checkpoint");
+    writer_close(writer);
+    writer_free(writer);
+    test_assert_equal_int(2, (int)chunks_on_disk(), "Partial chunk checkpointed");
+
+    // Simulate a crash between the header rewrite and the log reset
+    log = saved ? fopen(TEST_WAL_LOG, "wb") : NULL;
+    if (log) {
+        fwrite(saved, 1, log_size, log);
+        fclose(log);
+    }
+    free(saved);
+    test_assert(scan_matches(11), "Checkpointed rows are not replayed twice");
+
+    // Test 5: A plain writer moves the log into a chunk and deletes it
+    printf("Test 5: Plain writer adopts the log\n");
+    writer = open_wal_writer();
+    test_assert_equal_int(0, writer ? insert_committed(writer, 11, 13) : -1, "Log three rows");
+    writer_close(writer);
+    writer_free(writer);
+    writer = writer_open(TEST_WAL_FILE);
+    test_assert_equal_int(0, writer ? writer_close(writer) : -1, "Plain writer commit");
+    writer_free(writer);
+    test_assert(!file_exists(TEST_WAL_LOG), "Log deleted once its rows are in a chunk");
+    test_assert_equal_int(3, (int)chunks_on_disk(), "Log rows written as a chunk");
+    test_assert(scan_matches(14), "Every row survives");
+
+    // Test 6: A log longer than a chunk is corrupt, not cut short
+    printf("Test 6: Overlong log\n");
+    writer = open_wal_writer();
+    test_assert_equal_int(0, writer ? insert_committed(writer, 14, 14) : -1, "Log one row");
+    writer_close(writer);
+    writer_free(writer);
+    char* one = slurp(TEST_WAL_LOG, &log_size);
+    long record = log_size - (long)sizeof(fxdb_wal_header_t);
+    log = one ? fopen(TEST_WAL_LOG, "ab") : NULL;
+    for (int i = 0; log && i < 8; i++) {
+        fwrite(one + sizeof(fxdb_wal_header_t), 1, record, log);
+    }
+    if (log) {
+        fclose(log);
+    }
+    free(one);
+    reader_t* overlong = reader_open(TEST_WAL_FILE);
+    test_assert(overlong == NULL, "Reader refuses nine logged rows in chunks of eight");
+    reader_close(overlong);
+    writer = open_wal_writer();
+    test_assert(writer == NULL, "Writer refuses the same log");
+    writer_free(writer);
+    remove(TEST_WAL_LOG);
+    test_assert(scan_matches(14), "Chunks readable without the log");
+
+    free_schema(schema);
+    cleanup_test_files();
+    return test_finalize();
+}
@@ -1,28 +1,132 @@
 #include "../test_utils.h"
 #include "../../include/writer.h"
+#include "../../include/reader.h"
 #include "../../include/schema.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+
+#define TEST_ASYNC_FILE "test_writer_async.fxdb"
+#define PRODUCERS 4
+#define ROWS_PER_PRODUCER 500
+
+// Insert rows from one thread, committing every 50 rows
+static void* producer(void* arg) {
+    writer_t* writer = ((void**)arg)[0];
+    int base = *(int*)((void**)arg)[1];
+    intptr_t failures = 0;
+
+    char json[64];
+    for (int i = 0; i < ROWS_PER_PRODUCER; i++) {
+        snprintf(json, sizeof(json), "{\"id\": %d, \"worker\": %d}", base + i, base / ROWS_PER_PRODUCER);
+        if (writer_insert_json(writer, json) != 0) {
+            failures++;
+        }
+        if (i % 50 == 49 && writer_commit(writer) != 0) {
+            failures++;
+        }
+    }
+    return (void*)failures;
+}
+
+static uint32_t rows_on_disk(const char* filename) {
+    reader_t* reader = reader_open(filename);
+    if (!reader) {
+        return 0;
+    }
+    uint32_t rows = reader_get_row_count(reader);
+    reader_close(reader);
+    return rows;
+}
 
 int main(void) {
     test_init("Enhanced Writer Module Tests");
-    
+
     // Cleanup any existing test files
     cleanup_test_files();
-    
+
     // Test 1: Create and write basic data
     printf("Test 1: Basic writer functionality\n");
-    schema_t* schema = parse_schema("id int32, name string, score float");
+    schema_t* schema = parse_schema("id int32, worker int32");
     test_assert_not_null(schema, "Schema creation");
-    
-    // Additional writer tests would go here
-    // For now, just basic validation
-    test_assert(schema != NULL, "Writer test placeholder");
-    
-    if (schema) {
+    if (!schema) {
+        return test_finalize();
+    }
+
+    // Test 2: Committed rows are visible before close
+    printf("Test 2: Async commit\n");
+    writer_config_t config = writer_default_config();
+    config.chunk_size = 64;
+    config.async_io = true;
+    config.durability = FXDB_DURABILITY_FSYNC;
+    writer_t* writer = writer_create(TEST_ASYNC_FILE, schema, &config);
+    test_assert_not_null(writer, "Async writer creation");
+    if (!writer) {
         free_schema(schema);
+        return test_finalize();
     }
-    
+
+    for (int i = 0; i < 100; i++) {
+        char json[64];
+        snprintf(json, sizeof(json), "{\"id\": %d, \"worker\": 0}", i);
+        writer_insert_json(writer, json);
+    }
+    test_assert_equal_int(0, writer_commit(writer), "Commit after 100 inserts");
+    test_assert_equal_int(100, (int)rows_on_disk(TEST_ASYNC_FILE), "Committed rows visible to readers");
+    test_assert_equal_int(0, writer_close(writer), "Async writer close");
+    writer_free(writer);
+
+    // Test 3: Concurrent producers share group commits
+    printf("Test 3: Group commit from several threads\n");
+    config.durability = FXDB_DURABILITY_FLUSH;
+    config.group_commit_us = 200;
+    writer = writer_open_with_config(TEST_ASYNC_FILE, &config);
+    test_assert_not_null(writer, "Async writer reopen");
+
+    pthread_t threads[PRODUCERS];
+    int bases[PRODUCERS];
+    void* args[PRODUCERS][2];
+    for (int t = 0; writer && t < PRODUCERS; t++) {
+        bases[t] = 1000 + t * ROWS_PER_PRODUCER;
+        args[t][0] = writer;
+        args[t][1] = &bases[t];
+        pthread_create(&threads[t], NULL, producer, args[t]);
+    }
+
+    intptr_t failures = 0;
+    for (int t = 0; writer && t < PRODUCERS; t++) {
+        void* result;
+        pthread_join(threads[t], &result);
+        failures += (intptr_t)result;
+    }
+    test_assert_equal_int(0, (int)failures, "Every insert and commit succeeded");
+    test_assert_equal_int(0, writer ? writer_close(writer) : -1, "Close after concurrent inserts");
+    writer_free(writer);
+
+    // Every row lands exactly once, whatever the interleaving
+    int expected = 100 + PRODUCERS * ROWS_PER_PRODUCER;
+    reader_t* reader = reader_open(TEST_ASYNC_FILE);
+    test_assert(reader && (int)reader_get_row_count(reader) == expected, "All rows on disk");
+    if (reader) {
+        char* seen = calloc(1000 + PRODUCERS * ROWS_PER_PRODUCER, 1);
+        int duplicates = 0, count = 0;
+        row_data_t* row;
+        while (seen && (row = reader_read_row(reader)) != NULL) {
+            int id = row->values[0].value.int32_val;
+            if (id >= 1000) {
+                duplicates += seen[id];
+                seen[id] = 1;
+            }
+            count++;
+            reader_free_row(row);
+        }
+        test_assert_equal_int(expected, count, "Scan returns every row");
+        test_assert_equal_int(0, duplicates, "No row written twice");
+        free(seen);
+        reader_close(reader);
+    }
+
+    free_schema(schema);
     cleanup_test_files();
     return test_finalize();
-}
\ No newline at end of file
+}